@@ -0,0 +1,110 @@
+/*
+ * bench_adc.c - SPI ADC sampling pipeline at increasing scan rates
+ *
+ * Runs the rpi_adc.h sampler thread at 1 kHz to 100 kHz while the main
+ * thread drains the ring through adc_peek()/adc_release() every
+ * millisecond, as a Python consumer would. Reports the achieved scan rate,
+ * the worst wake-up lateness, ticks missed by the sampler, samples lost to
+ * a full ring, and scan-number gaps seen by the consumer.
+ *
+ * On a Pi this opens SPI0 with an MCP3008 on CE0 (run as root, ideally
+ * with an isolated core given as core). Elsewhere (or with -s) the
+ * converter is simulated on the SPI0 model, so only the pacing is real.
+ *
+ * Usage: ./bench_adc [-s] [ms] [core]
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_SPI_IMPLEMENTATION
+#include "rpi_spi.h"
+
+#define RPI_ADC_IMPLEMENTATION
+#include "rpi_adc.h"
+
+#define BENCH_DEFAULT_MS  500
+#define BENCH_CAPACITY    16384
+#define BENCH_DRAIN_US    1000
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Consumer: drains in place, counts samples and scan-number gaps */
+static void drain(adc_t* adc, uint64_t* samples, uint64_t* gaps, int64_t* last_seq) {
+    const adc_sample_t* p;
+    size_t n;
+    while ((n = adc_peek(adc, &p)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (*last_seq >= 0 && p[i].seq > (uint64_t)*last_seq + 1) (*gaps)++;
+            *last_seq = p[i].seq;
+        }
+        *samples += n;
+        adc_release(adc, n);
+    }
+}
+
+static void run_rate(adc_t* adc, double rate_hz, int ms, int core) {
+    uint64_t samples = 0, gaps = 0;
+    int64_t last_seq = -1;
+
+    if (adc_start(adc, rate_hz, core) != 0) return;
+    uint64_t end = now_ns() + (uint64_t)ms * 1000000ull;
+    while (now_ns() < end) {
+        drain(adc, &samples, &gaps, &last_seq);
+        usleep(BENCH_DRAIN_US);
+    }
+    adc_stop(adc);
+    drain(adc, &samples, &gaps, &last_seq);
+
+    adc_stats_t st;
+    adc_get_stats(adc, &st);
+    printf("%-9.0f %12.0f %10llu %11.1f %8llu %9llu %6llu %4s\n", rate_hz, adc_scan_rate(adc),
+           (unsigned long long)samples, st.max_late_ns / 1e3, (unsigned long long)st.missed,
+           (unsigned long long)st.overruns, (unsigned long long)gaps, adc->realtime ? "yes" : "no");
+}
+
+int main(int argc, char** argv) {
+    static const double rates[] = { 1000, 10000, 20000, 50000, 100000 };
+    int simulate = 0, ms = BENCH_DEFAULT_MS, core = -1, positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) simulate = 1;
+        else if (positional++ == 0) ms = atoi(argv[i]) > 0 ? atoi(argv[i]) : BENCH_DEFAULT_MS;
+        else core = atoi(argv[i]);
+    }
+
+    adc_t adc;
+    int hw = !simulate && adc_open(&adc, NULL, 0, ADC_MCP3008, BENCH_CAPACITY) == 0;
+    if (!hw && adc_open_sim(&adc, ADC_MCP3008, BENCH_CAPACITY, NULL, NULL) != 0) {
+        fprintf(stderr, "Failed to open the ADC\n");
+        return 1;
+    }
+
+    printf("MCP3008 channel 0 on %s SPI0, %d ms per rate, sampler %s\n", hw ? "mmap" : "simulated",
+           ms, core >= 0 ? "pinned and spinning" : "sleeping");
+    printf("%-9s %12s %10s %11s %8s %9s %6s %4s\n", "target", "achieved", "samples",
+           "max late us", "missed", "overruns", "gaps", "rt");
+    printf("-------------------------------------------------------------------------------\n");
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) run_rate(&adc, rates[i], ms, core);
+
+    adc_close(&adc);
+    return 0;
+}
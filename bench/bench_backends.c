@@ -0,0 +1,220 @@
+/*
+ * bench_backends.c - Toggle rate and read latency per GPIO backend
+ *
+ * Runs the same workload through every backend that can be initialized:
+ *   - digital_write() HIGH/LOW toggles on one pin
+ *   - digital_write_fast() toggles (inline path, devirtualized on mmap)
+ *   - gpio_write_mask() updating 8 pins per call
+ *   - digital_read() and gpio_read_all() latency
+ *
+ * A second table runs simulator toggles on 1-4 threads, each with its own
+ * gpio_ctx_t, to show that independent contexts scale without sharing state.
+ *
+ * The gpiochip backend falls back to a fake ioctl layer when no
+ * /dev/gpiochip0 is available, so host numbers show dispatch overhead only.
+ *
+ * Usage: ./bench_backends [iterations]
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <linux/gpio.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_GPIO_EVENT_IMPLEMENTATION
+#include "rpi_gpio_event.h"
+
+#define RPI_GPIOCHIP_IMPLEMENTATION
+#include "rpi_gpiochip.h"
+
+#define BENCH_PIN           21
+#define BENCH_BUS_MASK      0x0000000000FF0000ull  /* Pins 16-23 */
+#define BENCH_DEFAULT_ITERS 1000000
+
+/* ---------------------------------------------------------------------------
+ * Fake ioctl layer for the gpiochip backend
+ * ---------------------------------------------------------------------------*/
+static volatile uint64_t fake_values;
+
+static int fake_open(const char* path, int flags) { (void)path; (void)flags; return 3; }
+static int fake_close(int fd) { (void)fd; return 0; }
+static ssize_t fake_read(int fd, void* buf, size_t count) { (void)fd; (void)buf; (void)count; return 0; }
+static int fake_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
+    (void)fds; (void)nfds; (void)timeout_ms;
+    return 0;
+}
+
+static int fake_ioctl(int fd, unsigned long request, void* arg) {
+    (void)fd;
+    if (request == GPIO_V2_GET_LINE_IOCTL) {
+        ((struct gpio_v2_line_request*)arg)->fd = 4;
+    } else if (request == GPIO_V2_LINE_SET_VALUES_IOCTL) {
+        struct gpio_v2_line_values* v = (struct gpio_v2_line_values*)arg;
+        fake_values = (fake_values & ~v->mask) | (v->bits & v->mask);
+    } else if (request == GPIO_V2_LINE_GET_VALUES_IOCTL) {
+        struct gpio_v2_line_values* v = (struct gpio_v2_line_values*)arg;
+        v->bits = fake_values & v->mask;
+    }
+    return 0;
+}
+
+static const gpiochip_io_t fake_io = { fake_open, fake_close, fake_ioctl, fake_read, fake_poll };
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static double ns_per_op(uint64_t start, long ops) {
+    return (double)(now_ns() - start) / (double)ops;
+}
+
+static void run_backend(gpio_backend_t backend, long iters) {
+    const char* name = gpio_backend_name(backend);
+    const char* note = "";
+
+    if (gpio_init_backend(backend) != 0) {
+        if (backend != GPIO_BACKEND_GPIOCHIP) {
+            printf("%-9s unavailable\n", name);
+            return;
+        }
+        gpiochip_set_io(&fake_io);
+        if (gpio_init_backend(backend) != 0) {
+            printf("%-9s unavailable\n", name);
+            return;
+        }
+        note = " (fake ioctl)";
+    }
+
+    pin_mode(BENCH_PIN, OUTPUT);
+    for (int pin = 16; pin <= 23; pin++) {
+        pin_mode(pin, OUTPUT);
+    }
+
+    uint64_t start = now_ns();
+    for (long i = 0; i < iters; i += 2) {
+        digital_write(BENCH_PIN, HIGH);
+        digital_write(BENCH_PIN, LOW);
+    }
+    double write_ns = ns_per_op(start, iters);
+
+    start = now_ns();
+    for (long i = 0; i < iters; i += 2) {
+        digital_write_fast(BENCH_PIN, HIGH);
+        digital_write_fast(BENCH_PIN, LOW);
+    }
+    double fast_ns = ns_per_op(start, iters);
+
+    start = now_ns();
+    for (long i = 0; i < iters; i += 2) {
+        gpio_write_mask(BENCH_BUS_MASK, 0);
+        gpio_write_mask(0, BENCH_BUS_MASK);
+    }
+    double mask_ns = ns_per_op(start, iters);
+
+    volatile int sink = 0;
+    start = now_ns();
+    for (long i = 0; i < iters; i++) {
+        sink += digital_read(BENCH_PIN);
+    }
+    double read_ns = ns_per_op(start, iters);
+
+    volatile uint64_t sink64 = 0;
+    start = now_ns();
+    for (long i = 0; i < iters; i++) {
+        sink64 += gpio_read_all();
+    }
+    double read_all_ns = ns_per_op(start, iters);
+    (void)sink; (void)sink64;
+
+    for (int pin = 16; pin <= 23; pin++) {
+        pin_mode(pin, INPUT);
+    }
+    gpio_cleanup();
+    gpiochip_set_io(NULL);
+
+    printf("%-9s %9.2f MHz %9.2f MHz %9.1f ns %9.1f ns %9.1f ns%s\n",
+           name, 500.0 / write_ns, 500.0 / fast_ns, mask_ns, read_ns, read_all_ns, note);
+}
+
+/* ---------------------------------------------------------------------------
+ * Parallel simulator contexts
+ * ---------------------------------------------------------------------------*/
+#define BENCH_MAX_THREADS 4
+
+typedef struct {
+    int pin;
+    long iters;
+} ctx_job_t;
+
+static void* ctx_job(void* arg) {
+    ctx_job_t* job = (ctx_job_t*)arg;
+    gpio_ctx_t ctx = {0};
+    gpio_ctx_init(&ctx, GPIO_BACKEND_SIM);
+    gpio_ctx_pin_mode(&ctx, job->pin, OUTPUT);
+    for (long i = 0; i < job->iters; i += 2) {
+        gpio_ctx_write(&ctx, job->pin, HIGH);
+        gpio_ctx_write(&ctx, job->pin, LOW);
+    }
+    gpio_ctx_cleanup(&ctx);
+    return NULL;
+}
+
+static void run_parallel_contexts(long iters) {
+    printf("\nParallel sim contexts (%ld toggles per thread)\n", iters);
+    printf("%-9s %13s\n", "threads", "aggregate");
+    printf("-----------------------\n");
+
+    for (int n = 1; n <= BENCH_MAX_THREADS; n *= 2) {
+        pthread_t threads[BENCH_MAX_THREADS];
+        ctx_job_t jobs[BENCH_MAX_THREADS];
+
+        uint64_t start = now_ns();
+        for (int t = 0; t < n; t++) {
+            jobs[t] = (ctx_job_t){ .pin = 20 + t, .iters = iters };
+            pthread_create(&threads[t], NULL, ctx_job, &jobs[t]);
+        }
+        for (int t = 0; t < n; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        double ns = ns_per_op(start, iters * n);
+        printf("%-9d %9.2f MHz\n", n, 500.0 / ns);
+    }
+}
+
+int main(int argc, char** argv) {
+    long iters = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_ITERS;
+    if (iters <= 0) iters = BENCH_DEFAULT_ITERS;
+    iters &= ~1L;
+
+    /* Backend init banners go to stdout; keep the table readable */
+    printf("GPIO backend benchmark (%ld operations each)\n", iters);
+    printf("%-9s %13s %13s %12s %12s %12s\n",
+           "backend", "toggle", "toggle_fast", "write_mask", "read", "read_all");
+    printf("------------------------------------------------------------------------------\n");
+
+    gpio_backend_t backends[] = {
+        GPIO_BACKEND_MMAP, GPIO_BACKEND_GPIOCHIP, GPIO_BACKEND_SIM, GPIO_BACKEND_NULL
+    };
+    for (int i = 0; i < (int)(sizeof(backends) / sizeof(backends[0])); i++) {
+        fflush(stdout);
+        run_backend(backends[i], iters);
+    }
+
+    run_parallel_contexts(iters);
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * bench_debounce.c - Cost per tick of the vertical-counter debouncer
+ *
+ * Feeds the same noisy 54-pin snapshots to
+ *   - debounce_update() (bit-sliced counters, all pins per operation)
+ *   - a per-pin counter loop (one counter and branch per pin)
+ * at several stable counts and reports ns per tick and whether both agree.
+ *
+ * Usage: ./bench_debounce [ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RPI_DEBOUNCE_IMPLEMENTATION
+#include "rpi_debounce.h"
+
+#define BENCH_PINS          54
+#define BENCH_DEFAULT_TICKS 5000000
+#define BENCH_SAMPLES       4096
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Reference: one counter per pin */
+typedef struct {
+    uint64_t state;
+    uint8_t count[BENCH_PINS];
+    uint8_t stable;
+} per_pin_t;
+
+static uint64_t per_pin_update(per_pin_t* d, uint64_t sample) {
+    uint64_t changed = 0;
+    for (int pin = 0; pin < BENCH_PINS; pin++) {
+        if (((sample ^ d->state) >> pin) & 1) {
+            if (++d->count[pin] >= d->stable) {
+                d->count[pin] = 0;
+                changed |= 1ull << pin;
+            }
+        } else {
+            d->count[pin] = 0;
+        }
+    }
+    d->state ^= changed;
+    return changed;
+}
+
+static void run_count(int stable, const uint64_t* samples, long ticks) {
+    debounce_t db;
+    per_pin_t ref;
+    debounce_init(&db, 0, stable);
+    memset(&ref, 0, sizeof(ref));
+    ref.stable = (uint8_t)stable;
+
+    uint64_t acc = 0;
+    uint64_t t0 = now_ns();
+    for (long i = 0; i < ticks; i++) acc ^= debounce_update(&db, samples[i & (BENCH_SAMPLES - 1)]);
+    double vert_ns = (double)(now_ns() - t0) / ticks;
+
+    uint64_t acc_ref = 0;
+    t0 = now_ns();
+    for (long i = 0; i < ticks; i++) acc_ref ^= per_pin_update(&ref, samples[i & (BENCH_SAMPLES - 1)]);
+    double ref_ns = (double)(now_ns() - t0) / ticks;
+
+    printf("%-8d %6d %10.2f ns %10.2f ns %8.1fx %7s\n", stable, db.bits, vert_ns, ref_ns,
+           ref_ns / vert_ns, (acc == acc_ref && db.state == ref.state) ? "ok" : "MISMATCH");
+}
+
+int main(int argc, char** argv) {
+    long ticks = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_TICKS;
+    if (ticks <= 0) ticks = BENCH_DEFAULT_TICKS;
+
+    /* Slowly changing levels with bursts of bounce */
+    uint64_t* samples = malloc(BENCH_SAMPLES * sizeof(uint64_t));
+    uint64_t level = 0;
+    uint32_t x = 1;
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        x = x * 1103515245u + 12345u;
+        if ((x >> 24) < 16) level ^= 1ull << ((x >> 8) % BENCH_PINS);
+        x = x * 1103515245u + 12345u;
+        uint64_t noise = (i % 8 == 0) ? ((uint64_t)x << 22 ^ x) : 0;
+        samples[i] = (level ^ noise) & ((1ull << BENCH_PINS) - 1);
+    }
+
+    printf("Debounce, %d pins, %ld ticks\n", BENCH_PINS, ticks);
+    printf("%-8s %6s %13s %13s %9s %7s\n", "count", "planes", "vertical", "per-pin", "speedup", "check");
+    printf("-------------------------------------------------------------\n");
+    run_count(4, samples, ticks);
+    run_count(16, samples, ticks);
+    run_count(200, samples, ticks);
+
+    free(samples);
+    return 0;
+}
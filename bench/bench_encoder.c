@@ -0,0 +1,105 @@
+/*
+ * bench_encoder.c - Quadrature decoder throughput
+ *
+ * Feeds precomputed snapshots to encoder_update() with 1, 4 and 16
+ * encoders, every one moving on every sample (worst case), and reports:
+ *   - ns per snapshot and the resulting sample rate
+ *   - the maximum count rate: one count per encoder per sample, so each
+ *     encoder can follow edges up to the sample rate; total counts/s
+ *     is that times the number of encoders
+ *
+ * A second line per backend times encoder_poll() (read + decode), which is
+ * the real limit when the sampler thread runs; on the simulator the read
+ * dominates, on a Pi the mmap backend reads GPLEV directly.
+ *
+ * Usage: ./bench_encoder [samples]
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_ENCODER_IMPLEMENTATION
+#include "rpi_encoder.h"
+
+#define BENCH_DEFAULT_SAMPLES 10000000L
+#define BENCH_POLL_SAMPLES    1000000L
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void run_update(int encoders, long samples) {
+    static const int seq_a[4] = { 0, 0, 1, 1 };
+    static const int seq_b[4] = { 0, 1, 1, 0 };
+    encoder_set_t set;
+    encoder_set_init(&set, NULL, 0);
+    for (int i = 0; i < encoders; i++) encoder_add(&set, 2 * i, 2 * i + 1);
+
+    /* Every encoder steps forward on every snapshot */
+    uint64_t levels[4];
+    for (int phase = 0; phase < 4; phase++) {
+        levels[phase] = 0;
+        for (int i = 0; i < encoders; i++) {
+            levels[phase] |= ((uint64_t)seq_a[phase] << (2 * i)) | ((uint64_t)seq_b[phase] << (2 * i + 1));
+        }
+    }
+
+    uint64_t t0 = now_ns();
+    for (long s = 0; s <= samples; s++) encoder_update(&set, levels[s & 3], t0 + (uint64_t)s);
+    double ns = (double)(now_ns() - t0) / samples;
+
+    int ok = 1;
+    for (int i = 0; i < encoders; i++) ok &= encoder_position(&set, i) == samples;
+    printf("%-8s %4d %10.2f ns %10.2f M/s %12.2f M/s %6s\n", "update", encoders, ns, 1e3 / ns,
+           1e3 / ns * encoders, ok ? "ok" : "WRONG");
+}
+
+static void run_poll(gpio_backend_t backend, int encoders) {
+    gpio_ctx_t ctx;
+    encoder_set_t set;
+    if (gpio_ctx_init(&ctx, backend) != 0) {
+        printf("%-8s unavailable\n", gpio_backend_name(backend));
+        return;
+    }
+    encoder_set_init(&set, &ctx, 0);
+    for (int i = 0; i < encoders; i++) encoder_add(&set, 2 * i, 2 * i + 1);
+
+    uint64_t t0 = now_ns();
+    for (long s = 0; s < BENCH_POLL_SAMPLES; s++) encoder_poll(&set);
+    double ns = (double)(now_ns() - t0) / BENCH_POLL_SAMPLES;
+
+    printf("%-8s %4d %10.2f ns %10.2f M/s %12.2f M/s\n", gpio_backend_name(backend), encoders, ns,
+           1e3 / ns, 1e3 / ns * encoders);
+    gpio_ctx_cleanup(&ctx);
+}
+
+int main(int argc, char** argv) {
+    long samples = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_SAMPLES;
+    if (samples <= 0) samples = BENCH_DEFAULT_SAMPLES;
+
+    printf("Quadrature decode, %ld snapshots, every encoder moving\n", samples);
+    printf("%-8s %4s %13s %14s %16s %6s\n", "path", "enc", "per sample", "samples/s", "max counts/s", "check");
+    printf("---------------------------------------------------------------------\n");
+    run_update(1, samples);
+    run_update(4, samples);
+    run_update(16, samples);
+    run_poll(GPIO_BACKEND_MMAP, 4);
+    run_poll(GPIO_BACKEND_SIM, 4);
+    return 0;
+}
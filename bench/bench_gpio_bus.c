@@ -0,0 +1,264 @@
+/*
+ * bench_gpio_bus.c - Parallel bus frame rate and read throughput
+ *
+ * Pushes full 320x240 RGB565 frames, 8080 mode, at full speed over a
+ * 16-bit bus (one write per pixel) and an 8-bit bus (two per pixel) with
+ *   - gpio_bus_write_buffer() (per-byte set/clear stores, strobe merged
+ *     into the data store)
+ *   - a naive loop (gpio_ctx_write() per data pin, then WR low and high)
+ * on every backend that can be initialized, and reports frames/s, MB/s and
+ * bulk writes per bus word (the table's are not counted on mmap). On a Pi
+ * the mmap rows are the real bus speed; the simulator and null rows show
+ * the software cost per word.
+ *
+ * Reads: first the gather step alone (level snapshot -> word) per gather
+ * mode against a loop testing one bit per data pin, then strobed reads
+ * with gpio_bus_read_buffer() against RD low, one gpio_ctx_read() per pin
+ * and RD high, in words/s.
+ *
+ * Usage: ./bench_gpio_bus [frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_GPIO_BUS_IMPLEMENTATION
+#include "rpi_gpio_bus.h"
+
+#define FRAME_W 320
+#define FRAME_H 240
+#define FRAME_PIXELS (FRAME_W * FRAME_H)
+
+#define BENCH_DEFAULT_FRAMES 5
+#define BENCH_SNAPSHOTS      4096
+#define BENCH_GATHER_PASSES  256
+#define BENCH_READ_WORDS     (1 << 20)
+
+/* D0-D15 on GPIO 4-19, WR 20, RD 21, D/C 22, CS 23 */
+static const gpio_bus_pins_t pins16 = {
+    16, { 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 }, 20, 21, 22, 23
+};
+static const gpio_bus_pins_t pins8 = {
+    8, { 4, 5, 6, 7, 8, 9, 10, 11 }, 20, 21, 22, 23
+};
+/* The same 16 lines in scrambled order, some in bank 1 */
+static const gpio_bus_pins_t pins_scrambled = {
+    16, { 5, 34, 6, 13, 19, 26, 12, 16, 24, 25, 40, 7, 8, 9, 4, 36 }, 20, 21, 22, 23
+};
+/* In order with gaps */
+static const gpio_bus_pins_t pins_ordered = {
+    16, { 2, 3, 5, 6, 8, 9, 12, 13, 16, 17, 19, 24, 25, 26, 27, 40 }, 20, 21, 22, 23
+};
+
+static const char* gather_names[] = { "lut", "shift", "pext" };
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Reference: one pin write per data line, then the WR strobe */
+static void naive_write(gpio_ctx_t* ctx, const gpio_bus_pins_t* p, const void* data, size_t words) {
+    for (size_t n = 0; n < words; n++) {
+        uint16_t w = p->width == 16 ? ((const uint16_t*)data)[n] : ((const uint8_t*)data)[n];
+        for (int i = 0; i < p->width; i++) gpio_ctx_write(ctx, p->data[i], (w >> i) & 1);
+        gpio_ctx_write(ctx, p->wr, LOW);
+        gpio_ctx_write(ctx, p->wr, HIGH);
+    }
+}
+
+static void run_bus(gpio_backend_t backend, const gpio_bus_pins_t* pins, const uint16_t* frame, int frames) {
+    gpio_ctx_t ctx;
+    gpio_bus_t bus;
+    memset(&ctx, 0, sizeof(ctx));
+    if (gpio_ctx_init(&ctx, backend) != 0) {
+        printf("%-6s %5d unavailable\n", gpio_backend_name(backend), pins->width);
+        return;
+    }
+    if (gpio_bus_init(&bus, &ctx, pins, GPIO_BUS_8080) != 0) {
+        gpio_ctx_cleanup(&ctx);
+        return;
+    }
+
+    /* An 8-bit bus sends the same frame as bytes, two writes per pixel */
+    size_t words = pins->width == 16 ? FRAME_PIXELS : 2 * FRAME_PIXELS;
+    double bytes = (double)frames * FRAME_PIXELS * 2;
+
+    gpio_bus_select(&bus, 1);
+    uint64_t writes = ctx.stats.writes;
+    uint64_t t0 = now_ns();
+    for (int f = 0; f < frames; f++) gpio_bus_write_buffer(&bus, frame, words);
+    double table_s = (double)(now_ns() - t0) / 1e9;
+    double table_writes = (double)(ctx.stats.writes - writes) / ((double)frames * words);
+
+    writes = ctx.stats.writes;
+    t0 = now_ns();
+    for (int f = 0; f < frames; f++) naive_write(&ctx, pins, frame, words);
+    double naive_s = (double)(now_ns() - t0) / 1e9;
+    double naive_writes = (double)(ctx.stats.writes - writes) / ((double)frames * words);
+    gpio_bus_select(&bus, 0);
+
+    /* Table stores go through gpio_ctx_write_mask_fast(), uncounted on mmap */
+    char table_wr[16] = "-";
+    if (!ctx.regs) snprintf(table_wr, sizeof(table_wr), "%.1f", table_writes);
+    printf("%-6s %5d %8.1f %9.2f %7s %8.1f %7.1f %8.1fx\n", gpio_backend_name(backend), pins->width,
+           frames / table_s, bytes / table_s / 1e6, table_wr, frames / naive_s, naive_writes,
+           naive_s / table_s);
+
+    gpio_bus_free(&bus);
+    gpio_ctx_cleanup(&ctx);
+}
+
+/* ---------------------------------------------------------------------------
+ * Reads
+ * ---------------------------------------------------------------------------*/
+
+/* Reference: one bit test per data pin */
+static uint16_t naive_gather(const gpio_bus_pins_t* p, uint64_t levels) {
+    uint16_t w = 0;
+    for (int i = 0; i < p->width; i++) w |= (uint16_t)(((levels >> p->data[i]) & 1) << i);
+    return w;
+}
+
+static void run_gather(const char* wiring, const gpio_bus_pins_t* pins) {
+    gpio_ctx_t ctx;
+    gpio_bus_t bus;
+    memset(&ctx, 0, sizeof(ctx));
+    if (gpio_ctx_init(&ctx, GPIO_BACKEND_NULL) != 0) return;
+    if (gpio_bus_init(&bus, &ctx, pins, GPIO_BUS_8080) != 0) {
+        gpio_ctx_cleanup(&ctx);
+        return;
+    }
+
+    static uint64_t snaps[BENCH_SNAPSHOTS];
+    uint64_t x = 88172645463325252ull;
+    for (int i = 0; i < BENCH_SNAPSHOTS; i++) {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        snaps[i] = x & GPIO_ALL_PINS_MASK;
+    }
+    double words = (double)BENCH_SNAPSHOTS * BENCH_GATHER_PASSES;
+
+    volatile uint16_t sink = 0;
+    uint16_t acc = 0;
+    uint64_t t0 = now_ns();
+    for (int r = 0; r < BENCH_GATHER_PASSES; r++) {
+        for (int i = 0; i < BENCH_SNAPSHOTS; i++) acc ^= naive_gather(pins, snaps[i]);
+    }
+    double naive_s = (double)(now_ns() - t0) / 1e9;
+
+    int modes[2] = { GPIO_BUS_GATHER_LUT, bus.gather_best };
+    for (int m = 0; m < (bus.gather_best == GPIO_BUS_GATHER_LUT ? 1 : 2); m++) {
+        gpio_bus_set_gather(&bus, modes[m]);
+        t0 = now_ns();
+        for (int r = 0; r < BENCH_GATHER_PASSES; r++) {
+            for (int i = 0; i < BENCH_SNAPSHOTS; i++) acc ^= gpio_bus_gather(&bus, snaps[i]);
+        }
+        double s = (double)(now_ns() - t0) / 1e9;
+        printf("%-10s %-6s %10.1f %10.1f %8.1fx\n", wiring, gather_names[modes[m]], words / s / 1e6,
+               words / naive_s / 1e6, naive_s / s);
+    }
+    sink = acc;
+    (void)sink;
+
+    gpio_bus_free(&bus);
+    gpio_ctx_cleanup(&ctx);
+}
+
+/* Reference: RD low, one pin read per data line, RD high */
+static void naive_read(gpio_ctx_t* ctx, const gpio_bus_pins_t* p, uint16_t* out, size_t words) {
+    for (size_t n = 0; n < words; n++) {
+        gpio_ctx_write(ctx, p->rd, LOW);
+        uint16_t w = 0;
+        for (int i = 0; i < p->width; i++) w |= (uint16_t)(gpio_ctx_read(ctx, p->data[i]) << i);
+        gpio_ctx_write(ctx, p->rd, HIGH);
+        out[n] = w;
+    }
+}
+
+static void run_read(gpio_backend_t backend, const char* wiring, const gpio_bus_pins_t* pins) {
+    gpio_ctx_t ctx;
+    gpio_bus_t bus;
+    memset(&ctx, 0, sizeof(ctx));
+    if (gpio_ctx_init(&ctx, backend) != 0) {
+        printf("%-6s %-10s unavailable\n", gpio_backend_name(backend), wiring);
+        return;
+    }
+    if (gpio_bus_init(&bus, &ctx, pins, GPIO_BUS_8080) != 0) {
+        gpio_ctx_cleanup(&ctx);
+        return;
+    }
+    gpio_bus_set_input(&bus, 1);
+
+    uint16_t* buf = (uint16_t*)malloc(BENCH_READ_WORDS * sizeof(uint16_t));
+    if (!buf) {
+        gpio_bus_free(&bus);
+        gpio_ctx_cleanup(&ctx);
+        return;
+    }
+    uint64_t reads = ctx.stats.reads;
+    uint64_t t0 = now_ns();
+    gpio_bus_read_buffer(&bus, buf, BENCH_READ_WORDS);
+    double table_s = (double)(now_ns() - t0) / 1e9;
+    double table_reads = (double)(ctx.stats.reads - reads) / BENCH_READ_WORDS;
+
+    reads = ctx.stats.reads;
+    t0 = now_ns();
+    naive_read(&ctx, pins, buf, BENCH_READ_WORDS);
+    double naive_s = (double)(now_ns() - t0) / 1e9;
+    double naive_reads = (double)(ctx.stats.reads - reads) / BENCH_READ_WORDS;
+
+    printf("%-6s %-10s %-6s %10.2f %6.1f %10.2f %6.1f %8.1fx\n", gpio_backend_name(backend), wiring,
+           gather_names[bus.gather_mode], BENCH_READ_WORDS / table_s / 1e6, table_reads,
+           BENCH_READ_WORDS / naive_s / 1e6, naive_reads, naive_s / table_s);
+
+    free(buf);
+    gpio_bus_free(&bus);
+    gpio_ctx_cleanup(&ctx);
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_FRAMES;
+    if (frames <= 0) frames = BENCH_DEFAULT_FRAMES;
+
+    uint16_t* frame = (uint16_t*)malloc(FRAME_PIXELS * sizeof(uint16_t));
+    if (!frame) return 1;
+    for (int i = 0; i < FRAME_PIXELS; i++) frame[i] = (uint16_t)(i * 40503u + 11);
+
+    printf("%dx%d RGB565 frames, 8080 mode, %d frames per run\n", FRAME_W, FRAME_H, frames);
+    printf("%-6s %5s %8s %9s %7s %8s %7s %9s\n", "gpio", "bits", "fps", "MB/s", "wr/w", "naive", "wr/w",
+           "speedup");
+    printf("----------------------------------------------------------------\n");
+    const gpio_backend_t backends[] = { GPIO_BACKEND_MMAP, GPIO_BACKEND_SIM, GPIO_BACKEND_NULL };
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        run_bus(backends[b], &pins16, frame, frames);
+        run_bus(backends[b], &pins8, frame, frames);
+    }
+
+    printf("\nGather only, 16 bits, Mwords/s\n");
+    printf("%-10s %-6s %10s %10s %9s\n", "wiring", "mode", "gather", "naive", "speedup");
+    printf("-----------------------------------------------\n");
+    run_gather("contiguous", &pins16);
+    run_gather("ordered", &pins_ordered);
+    run_gather("scrambled", &pins_scrambled);
+
+    printf("\nStrobed reads, 16 bits, %d words per run, Mwords/s\n", BENCH_READ_WORDS);
+    printf("%-6s %-10s %-6s %10s %6s %10s %6s %9s\n", "gpio", "wiring", "mode", "read", "rd/w", "naive",
+           "rd/w", "speedup");
+    printf("-----------------------------------------------------------------------\n");
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        run_read(backends[b], "contiguous", &pins16);
+        run_read(backends[b], "scrambled", &pins_scrambled);
+    }
+
+    free(frame);
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * bench_gpiochip.c - gpiochip v2 backend vs. /dev/gpiomem mmap
+ *
+ * Measures output toggle rate for:
+ *   - mmap:          digital_write() on the register block (Raspberry Pi only)
+ *   - gpiochip:      GPIO_V2_LINE_SET_VALUES_IOCTL on a single line
+ *   - gpiochip bulk: one SET_VALUES ioctl updating 8 lines at once
+ *
+ * Without a usable /dev/gpiochip0 (or with --fake) the gpiochip numbers come
+ * from a fake ioctl layer and only reflect the userspace overhead.
+ *
+ * Usage: ./bench_gpiochip [--fake] [iterations]
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/gpio.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define SIMPLE_TIMER_IMPLEMENTATION
+#include "simple_timer.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_GPIO_EVENT_IMPLEMENTATION
+#include "rpi_gpio_event.h"
+
+#define RPI_GPIOCHIP_IMPLEMENTATION
+#include "rpi_gpiochip.h"
+
+#define BENCH_PIN           21
+#define BENCH_DEFAULT_ITERS 100000
+
+/* ---------------------------------------------------------------------------
+ * Fake ioctl layer
+ * ---------------------------------------------------------------------------*/
+static volatile uint64_t fake_values;
+
+static int fake_open(const char* path, int flags) { (void)path; (void)flags; return 3; }
+static int fake_close(int fd) { (void)fd; return 0; }
+static ssize_t fake_read(int fd, void* buf, size_t count) { (void)fd; (void)buf; (void)count; return 0; }
+static int fake_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
+    (void)fds; (void)nfds; (void)timeout_ms;
+    return 0;
+}
+
+static int fake_ioctl(int fd, unsigned long request, void* arg) {
+    (void)fd;
+    if (request == GPIO_V2_GET_LINE_IOCTL) {
+        ((struct gpio_v2_line_request*)arg)->fd = 4;
+    } else if (request == GPIO_V2_LINE_SET_VALUES_IOCTL) {
+        struct gpio_v2_line_values* v = (struct gpio_v2_line_values*)arg;
+        fake_values = (fake_values & ~v->mask) | (v->bits & v->mask);
+    }
+    return 0;
+}
+
+static const gpiochip_io_t fake_io = { fake_open, fake_close, fake_ioctl, fake_read, fake_poll };
+
+/* ---------------------------------------------------------------------------
+ * Reporting
+ * ---------------------------------------------------------------------------*/
+static void report(const char* name, long iters, uint64_t elapsed_us) {
+    if (elapsed_us == 0) elapsed_us = 1;
+    double ns_per_op = (double)elapsed_us * 1000.0 / (double)iters;
+    double toggle_hz = (double)iters / 2.0 / ((double)elapsed_us / 1e6);
+    printf("%-22s %10.1f ns/write %12.1f kHz toggle\n", name, ns_per_op, toggle_hz / 1000.0);
+}
+
+int main(int argc, char** argv) {
+    int use_fake = 0;
+    long iters = BENCH_DEFAULT_ITERS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fake") == 0) {
+            use_fake = 1;
+        } else {
+            iters = atol(argv[i]);
+        }
+    }
+    if (iters <= 0) iters = BENCH_DEFAULT_ITERS;
+    iters &= ~1L;
+
+    printf("GPIO write benchmark (%ld writes)\n", iters);
+    printf("----------------------------------------------------------------\n");
+
+#if defined(__aarch64__) || defined(__arm__)
+    if (gpio_init() == 0) {
+        pin_mode(BENCH_PIN, OUTPUT);
+        uint64_t start = micros();
+        for (long i = 0; i < iters; i += 2) {
+            digital_write(BENCH_PIN, HIGH);
+            digital_write(BENCH_PIN, LOW);
+        }
+        report("mmap (/dev/gpiomem)", iters, micros() - start);
+        pin_mode(BENCH_PIN, INPUT);
+        gpio_cleanup();
+    }
+#else
+    printf("%-22s skipped (not running on a Raspberry Pi)\n", "mmap (/dev/gpiomem)");
+#endif
+
+    if (use_fake || gpiochip_init(NULL) != 0) {
+        printf("Using fake ioctl layer for gpiochip\n");
+        gpiochip_set_io(&fake_io);
+        gpiochip_init(NULL);
+    }
+
+    gpiochip_lines_t single;
+    int pin = BENCH_PIN;
+    if (gpiochip_request_lines(&single, &pin, 1, 0x1, GPIO_EDGE_NONE) == 0) {
+        uint64_t start = micros();
+        for (long i = 0; i < iters; i += 2) {
+            gpiochip_set_values(&single, 0x1, 0x1);
+            gpiochip_set_values(&single, 0x1, 0x0);
+        }
+        report("gpiochip (1 line)", iters, micros() - start);
+        gpiochip_release_lines(&single);
+    }
+
+    gpiochip_lines_t bulk;
+    int pins[] = {5, 6, 13, 16, 19, 20, 21, 26};
+    if (gpiochip_request_lines(&bulk, pins, 8, 0xFF, GPIO_EDGE_NONE) == 0) {
+        uint64_t start = micros();
+        for (long i = 0; i < iters; i += 2) {
+            gpiochip_set_values(&bulk, 0xFF, 0xFF);
+            gpiochip_set_values(&bulk, 0xFF, 0x00);
+        }
+        report("gpiochip (8 lines)", iters, micros() - start);
+        gpiochip_release_lines(&bulk);
+    }
+
+    gpiochip_cleanup();
+    gpiochip_set_io(NULL);
+    return 0;
+}
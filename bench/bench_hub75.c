@@ -0,0 +1,150 @@
+/*
+ * bench_hub75.c - HUB75 conversion speed and refresh rate vs colour depth
+ *
+ * First converts a 64x32 RGB888 frame into bitplane mask streams with
+ * hub75_swap() (eight planes per 64-bit word) and with a naive loop (one
+ * bit test per channel, plane and pixel), and reports pixels/s. Then
+ * plays the panel from the refresh thread at every colour depth and
+ * reports the achieved refresh rate, the frame time, bank writes per
+ * frame (not counted on mmap) and the measured share of the frame the
+ * LEDs are lit: more depth means more shifts per row and exponentially
+ * more lit time, so the rate falls with each bit.
+ *
+ * On a Pi (mmap backend) run as root with the panel on the "regular"
+ * adapter pins, ideally with an isolated core given as core. Elsewhere (or
+ * with -s) the simulator shows the software cost.
+ *
+ * Usage: ./bench_hub75 [-s] [ms] [core]
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_HUB75_IMPLEMENTATION
+#include "rpi_hub75.h"
+
+#define BENCH_WIDTH       64
+#define BENCH_HEIGHT      32
+#define BENCH_CONVERTS    200
+#define BENCH_DEFAULT_MS  500
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Reference: one bit test per channel, plane and pixel */
+static void naive_convert(const hub75_t* panel, const uint8_t* pixels, uint32_t* stream) {
+    const hub75_pins_t* p = &panel->pins;
+    const int pins[6] = { p->r1, p->g1, p->b1, p->r2, p->g2, p->b2 };
+    for (int row = 0; row < panel->rows; row++) {
+        for (int k = 0; k < HUB75_PLANES; k++) {
+            for (int x = 0; x < panel->width; x++) {
+                const uint8_t* top = pixels + ((size_t)row * panel->width + x) * 3;
+                const uint8_t* bot = top + (size_t)panel->rows * panel->width * 3;
+                uint32_t mask = 0;
+                for (int c = 0; c < 3; c++) {
+                    if ((top[c] >> k) & 1) mask |= 1u << pins[c];
+                    if ((bot[c] >> k) & 1) mask |= 1u << pins[c + 3];
+                }
+                stream[((size_t)row * HUB75_PLANES + k) * panel->width + x] = mask;
+            }
+        }
+    }
+}
+
+static void run_convert(hub75_t* panel) {
+    uint8_t* px = hub75_pixels(panel);
+    for (int i = 0; i < BENCH_WIDTH * BENCH_HEIGHT * 3; i++) px[i] = (uint8_t)(i * 37 + 11);
+    double pixels = (double)BENCH_CONVERTS * BENCH_WIDTH * BENCH_HEIGHT;
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < BENCH_CONVERTS; i++) hub75_swap(panel);
+    double swar_s = (double)(now_ns() - t0) / 1e9;
+
+    uint32_t* stream = (uint32_t*)malloc(hub75_stream_words(panel) * sizeof(uint32_t));
+    if (!stream) return;
+    t0 = now_ns();
+    for (int i = 0; i < BENCH_CONVERTS; i++) naive_convert(panel, px, stream);
+    double naive_s = (double)(now_ns() - t0) / 1e9;
+    int same = memcmp(stream, panel->stream[panel->front], hub75_stream_words(panel) * sizeof(uint32_t)) == 0;
+    free(stream);
+
+    printf("Conversion, %dx%d RGB888 -> 8 bitplanes\n", BENCH_WIDTH, BENCH_HEIGHT);
+    printf("%-8s %12s %10s\n", "method", "Mpixel/s", "frame us");
+    printf("--------------------------------\n");
+    printf("%-8s %12.2f %10.1f\n", "swar", pixels / swar_s / 1e6, swar_s * 1e6 / BENCH_CONVERTS);
+    printf("%-8s %12.2f %10.1f   %.1fx slower%s\n", "naive", pixels / naive_s / 1e6,
+           naive_s * 1e6 / BENCH_CONVERTS, naive_s / swar_s, same ? "" : ", MISMATCH");
+}
+
+static void run_depth(hub75_t* panel, int depth, int ms, int core) {
+    hub75_set_depth(panel, depth);
+    uint64_t writes = panel->gpio->stats.writes;
+    if (hub75_start(panel, core) != 0) return;
+    usleep((useconds_t)ms * 1000);
+    hub75_stop(panel);
+
+    hub75_stats_t st;
+    hub75_get_stats(panel, &st);
+    if (st.frames == 0) return;
+    double frame_ns = (double)(st.end_ns - st.start_ns) / (double)st.frames;
+    double lit_ns = (double)st.lit_ns / (double)st.frames;  /* Measured OE low time */
+    /* Frame stores go through gpio_ctx_write_mask_fast(), uncounted on mmap */
+    char per_frame[16] = "-";
+    if (!panel->gpio->regs) {
+        snprintf(per_frame, sizeof(per_frame), "%.0f", (double)(panel->gpio->stats.writes - writes) / (double)st.frames);
+    }
+    printf("%5d %10.1f %10.1f %10.1f %12s %7.1f%% %3s\n", depth, hub75_refresh_rate(panel), frame_ns / 1e3,
+           st.max_frame_ns / 1e3, per_frame, 100.0 * lit_ns / frame_ns, panel->realtime ? "yes" : "no");
+}
+
+int main(int argc, char** argv) {
+    int simulate = 0, ms = BENCH_DEFAULT_MS, core = -1, positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) simulate = 1;
+        else if (positional++ == 0) ms = atoi(argv[i]) > 0 ? atoi(argv[i]) : BENCH_DEFAULT_MS;
+        else core = atoi(argv[i]);
+    }
+
+    gpio_ctx_t gpio;
+    memset(&gpio, 0, sizeof(gpio));
+    int hw = !simulate && gpio_ctx_init(&gpio, GPIO_BACKEND_MMAP) == 0;
+    if (!hw && gpio_ctx_init(&gpio, GPIO_BACKEND_SIM) != 0) {
+        fprintf(stderr, "Failed to open the GPIO simulator\n");
+        return 1;
+    }
+
+    hub75_t panel;
+    if (hub75_init(&panel, &gpio, NULL, BENCH_WIDTH, BENCH_HEIGHT) != 0) {
+        gpio_ctx_cleanup(&gpio);
+        return 1;
+    }
+    run_convert(&panel);
+
+    printf("\nRefresh on %s GPIO, %d ms per depth, base %u ns, thread %s\n", hw ? "mmap" : "simulated", ms,
+           panel.base_ns, core >= 0 ? "pinned" : "unpinned");
+    printf("%5s %10s %10s %10s %12s %8s %3s\n", "depth", "Hz", "frame us", "max us", "writes/frm", "lit", "rt");
+    printf("---------------------------------------------------------------\n");
+    for (int depth = 1; depth <= HUB75_PLANES; depth++) run_depth(&panel, depth, ms, core);
+
+    hub75_free(&panel);
+    gpio_ctx_cleanup(&gpio);
+    return 0;
+}
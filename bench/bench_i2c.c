@@ -0,0 +1,123 @@
+/*
+ * bench_i2c.c - Hardware BSC1 register burst reads, polled vs sleeping waits
+ *
+ * Reads the 14-byte accelerometer/temperature/gyro block of an MPU-6050
+ * style IMU (address 0x68, registers from 0x3B) through rpi_i2c.h at
+ * 100 kHz, 400 kHz and 1 MHz, once polling every wait and once sleeping
+ * through the long ones. Reports the time per read, the poll rate it
+ * allows, the CPU time spent per read and its register accesses.
+ *
+ * On a Pi this uses BSC1 (GPIO 2/3) in wall time and measures CPU time
+ * with CLOCK_THREAD_CPUTIME_ID; an IMU must answer at 0x68. Elsewhere (or
+ * with -s) a register-file device answers on the simulated block in
+ * virtual time, where the CPU time is the register accesses at
+ * I2C_SIM_ACCESS_NS each.
+ *
+ * Usage: ./bench_i2c [-s] [reads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_I2C_IMPLEMENTATION
+#include "rpi_i2c.h"
+
+#define BENCH_ADDR           0x68
+#define BENCH_REG            0x3B
+#define BENCH_BURST          14
+#define BENCH_DEFAULT_READS  1000
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t clock_ns(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct {
+    i2c_ctx_t ctx;
+    i2c_sim_t sim;
+    i2c_sim_regfile_t imu;
+    int simulated;
+} bench_t;
+
+/* Virtual time on the simulator, wall time on the Pi */
+static uint64_t bench_ns(const bench_t* b) {
+    return b->simulated ? b->sim.now_ns : clock_ns(CLOCK_MONOTONIC);
+}
+
+static uint64_t bench_cpu_ns(const bench_t* b) {
+    return b->simulated ? b->sim.accesses * I2C_SIM_ACCESS_NS : clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+static int bench_open(bench_t* b, int simulate) {
+    memset(b, 0, sizeof(*b));
+    if (!simulate && i2c_ctx_init(&b->ctx, NULL) == 0) return 0;
+
+    i2c_sim_slave_t slave;
+    b->simulated = 1;
+    i2c_sim_regfile(&b->imu, BENCH_ADDR, &slave);
+    for (int i = 0; i < BENCH_BURST; i++) b->imu.regs[BENCH_REG + i] = (uint8_t)(i * 17);
+    i2c_sim_init(&b->sim, &slave);
+    return i2c_sim_attach(&b->sim, &b->ctx);
+}
+
+static int run(bench_t* b, uint32_t hz, int sleep, int reads) {
+    uint8_t data[BENCH_BURST];
+    i2c_ctx_set_clock(&b->ctx, hz);
+    b->ctx.sleep = sleep;
+    memset(&b->ctx.stats, 0, sizeof(b->ctx.stats));
+
+    uint64_t a0 = b->simulated ? b->sim.accesses : 0;
+    uint64_t c0 = bench_cpu_ns(b);
+    uint64_t t0 = bench_ns(b);
+    for (int i = 0; i < reads; i++) {
+        if (i2c_ctx_read_regs(&b->ctx, BENCH_ADDR, BENCH_REG, data, sizeof(data)) != 0) {
+            fprintf(stderr, "Read failed (error %d), is a device at 0x%02X?\n", b->ctx.error, BENCH_ADDR);
+            return -1;
+        }
+    }
+    double us = (double)(bench_ns(b) - t0) / reads / 1e3;
+    double cpu_us = (double)(bench_cpu_ns(b) - c0) / reads / 1e3;
+
+    printf("%-8u %-6s %10.1f %10.0f %10.2f %6.0f%% ", b->ctx.clock_hz / 1000, sleep ? "sleep" : "poll", us,
+           1e6 / us, cpu_us, 100.0 * cpu_us / us);
+    if (b->simulated) printf("%10.1f", (double)(b->sim.accesses - a0) / reads);
+    else printf("%10s", "-");
+    printf(" %8.1f\n", (double)b->ctx.stats.sleeps / reads);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    static const uint32_t clocks[] = { 100000, 400000, 1000000 };
+    int simulate = 0, reads = BENCH_DEFAULT_READS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) simulate = 1;
+        else if (atoi(argv[i]) > 0) reads = atoi(argv[i]);
+    }
+
+    bench_t b;
+    if (bench_open(&b, simulate) != 0) {
+        fprintf(stderr, "Failed to open BSC1\n");
+        return 1;
+    }
+
+    printf("%d-byte burst from 0x%02X at 0x%02X on %s BSC1, %d reads per row\n", BENCH_BURST, BENCH_REG,
+           BENCH_ADDR, b.simulated ? "simulated" : "mmap", reads);
+    printf("%-8s %-6s %10s %10s %10s %7s %10s %8s\n", "kHz", "wait", "us/read", "max Hz", "cpu us",
+           "cpu", "accesses", "sleeps");
+    printf("----------------------------------------------------------------------------\n");
+    for (size_t i = 0; i < sizeof(clocks) / sizeof(clocks[0]); i++) {
+        if (run(&b, clocks[i], 0, reads) != 0 || run(&b, clocks[i], 1, reads) != 0) break;
+    }
+
+    i2c_ctx_close(&b.ctx);
+    return 0;
+}
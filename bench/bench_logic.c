@@ -0,0 +1,112 @@
+/*
+ * bench_logic.c - Logic analyzer sample rate and drop accounting
+ *
+ * Captures all pins for a fixed time while a second thread toggles one pin
+ * every few microseconds, with the VCD writer streaming to /dev/null:
+ *   - achieved sample rate (two GPLEV loads + timestamp per sample)
+ *   - records stored versus toggles made
+ *   - samples dropped to a full ring, longest gap between samples
+ *
+ * Runs on the mmap backend when it is available and on the simulator
+ * (where every read takes the simulator lock, so rates are far lower).
+ *
+ * Usage: ./bench_logic [duration_ms] [core_id]
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_LOGIC_IMPLEMENTATION
+#include "rpi_logic.h"
+
+#define BENCH_PIN           21
+#define BENCH_DEFAULT_MS    500
+#define BENCH_TOGGLE_US     20
+
+typedef struct {
+    gpio_ctx_t* ctx;
+    volatile int running;
+    uint64_t toggles;
+} toggler_t;
+
+static void* toggler_func(void* arg) {
+    toggler_t* t = (toggler_t*)arg;
+    int level = 0;
+    while (t->running) {
+        level ^= 1;
+        if (t->ctx->backend == GPIO_BACKEND_SIM) {
+            gpio_ctx_sim_set_input(t->ctx, BENCH_PIN, level);
+        } else {
+            gpio_ctx_write(t->ctx, BENCH_PIN, level);
+        }
+        t->toggles++;
+        usleep(BENCH_TOGGLE_US);
+    }
+    return NULL;
+}
+
+static void run_backend(gpio_backend_t backend, int duration_ms, int core_id) {
+    gpio_ctx_t ctx;
+    logic_t la;
+    const char* name = gpio_backend_name(backend);
+
+    if (gpio_ctx_init(&ctx, backend) != 0) {
+        printf("%-10s unavailable\n", name);
+        return;
+    }
+    if (backend != GPIO_BACKEND_SIM) gpio_ctx_pin_mode(&ctx, BENCH_PIN, OUTPUT);
+
+    FILE* out = fopen("/dev/null", "w");
+    logic_init(&la, &ctx, 0, 0);
+
+    toggler_t t = { &ctx, 1, 0 };
+    pthread_t thread;
+    logic_start(&la, core_id, out);
+    pthread_create(&thread, NULL, toggler_func, &t);
+    usleep((useconds_t)duration_ms * 1000);
+    t.running = 0;
+    pthread_join(thread, NULL);
+    usleep(1000);
+    logic_stop(&la);
+
+    printf("%-10s %10.2f %12llu %10llu %10llu %10llu %10.1f\n", name,
+           logic_sample_rate(&la) / 1e6,
+           (unsigned long long)la.stats.samples,
+           (unsigned long long)t.toggles,
+           (unsigned long long)la.stats.records,
+           (unsigned long long)la.stats.dropped,
+           la.stats.max_gap_ns / 1e3);
+
+    logic_free(&la);
+    fclose(out);
+    if (backend != GPIO_BACKEND_SIM) gpio_ctx_write(&ctx, BENCH_PIN, LOW);
+    gpio_ctx_cleanup(&ctx);
+}
+
+int main(int argc, char** argv) {
+    int duration_ms = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_MS;
+    int core_id = argc > 2 ? atoi(argv[2]) : -1;
+    if (duration_ms <= 0) duration_ms = BENCH_DEFAULT_MS;
+
+    printf("Logic analyzer capture, %d ms, toggling GPIO %d every %d us, sampler core %d\n",
+           duration_ms, BENCH_PIN, BENCH_TOGGLE_US, core_id);
+    printf("%-10s %10s %12s %10s %10s %10s %10s\n",
+           "backend", "MS/s", "samples", "toggles", "records", "dropped", "gap_us");
+    printf("------------------------------------------------------------------------------\n");
+
+    run_backend(GPIO_BACKEND_MMAP, duration_ms, core_id);
+    run_backend(GPIO_BACKEND_SIM, duration_ms, core_id);
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * bench_serializer.c - Encode time for PWM serializer (WS2812) frames
+ *
+ * Times hpwm_serial_encode() on a frame of LEDs (3 bytes each) against a
+ * straightforward bit-by-bit encoder producing the same words:
+ *   - 3 slots per bit (WS2812 at 2.4 MHz, 4-byte groups)
+ *   - 4 slots per bit (one table word per byte)
+ *
+ * The serializer is opened on the simulated PWM block, so nothing is sent;
+ * on a Pi the DMA frame buffer still comes from the mailbox (needs root).
+ *
+ * Usage: ./bench_serializer [leds] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_HW_PWM_IMPLEMENTATION
+#include "rpi_hw_pwm.h"
+
+#define BENCH_DEFAULT_LEDS  1000
+#define BENCH_DEFAULT_ITERS 2000
+
+static hpwm_sim_t pwm_sim;
+static dma_sim_t dma_sim;
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Reference: one slot at a time */
+static size_t encode_bitwise(const uint8_t* data, size_t len, int slots,
+                             uint8_t zero, uint8_t one, uint32_t* out) {
+    size_t bit = 0;
+    size_t words = (len * 8 * slots + 31) / 32;
+    memset(out, 0, words * sizeof(uint32_t));
+    for (size_t i = 0; i < len; i++) {
+        for (int b = 7; b >= 0; b--) {
+            uint8_t pattern = (data[i] >> b) & 1 ? one : zero;
+            for (int j = slots - 1; j >= 0; j--, bit++) {
+                if ((pattern >> j) & 1) out[bit / 32] |= 1u << (31 - bit % 32);
+            }
+        }
+    }
+    return words;
+}
+
+static void run_slots(hpwm_ctx_t* ctx, dma_chan_t* dma, int slots, uint8_t zero, uint8_t one,
+                      uint8_t* frame, size_t len, long iters) {
+    hpwm_serial_t ser;
+    hpwm_serial_config_t cfg = { 18, 2400000, slots, zero, one, 0, (int)len };
+    if (hpwm_serial_open(&ser, ctx, dma, &cfg) != 0) {
+        printf("%-6d unavailable\n", slots);
+        return;
+    }
+
+    size_t words = hpwm_serial_words(&ser, len);
+    uint32_t* a = malloc(words * sizeof(uint32_t));
+    uint32_t* b = malloc(words * sizeof(uint32_t));
+    volatile uint32_t sink = 0;
+
+    uint64_t t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        frame[i % len] ^= 1;  /* Keep the encode inside the loop */
+        hpwm_serial_encode(&ser, frame, len, a);
+        sink ^= a[i % words];
+    }
+    double lut_us = (now_ns() - t0) / 1e3 / iters;
+
+    t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        frame[i % len] ^= 1;
+        encode_bitwise(frame, len, slots, zero, one, b);
+        sink ^= b[i % words];
+    }
+    double bit_us = (now_ns() - t0) / 1e3 / iters;
+    (void)sink;
+
+    hpwm_serial_encode(&ser, frame, len, a);
+    encode_bitwise(frame, len, slots, zero, one, b);
+    printf("%-6d %8zu %10.2f us %10.2f us %8.1fx %9s\n", slots, words, lut_us, bit_us,
+           bit_us / lut_us, memcmp(a, b, words * sizeof(uint32_t)) ? "MISMATCH" : "ok");
+
+    free(a);
+    free(b);
+    hpwm_serial_close(&ser);
+}
+
+int main(int argc, char** argv) {
+    long leds = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_LEDS;
+    long iters = argc > 2 ? atol(argv[2]) : BENCH_DEFAULT_ITERS;
+    if (leds <= 0) leds = BENCH_DEFAULT_LEDS;
+    if (iters <= 0) iters = BENCH_DEFAULT_ITERS;
+
+    size_t len = (size_t)leds * 3;
+    uint8_t* frame = malloc(len);
+    for (size_t i = 0; i < len; i++) frame[i] = (uint8_t)(i * 37 + (i >> 3));
+
+    hpwm_ctx_t ctx;
+    dma_chan_t dma;
+    dma_sim_dev_t dev;
+    hpwm_sim_init(&pwm_sim, NULL, 0);
+    dma_sim_init(&dma_sim);
+    hpwm_sim_device(&pwm_sim, &dev);
+    dma_sim_add_device(&dma_sim, &dev);
+    hpwm_ctx_attach(&ctx, pwm_sim.pwm, pwm_sim.clk, NULL);
+    dma_chan_attach(&dma, dma_sim.regs, DMA_CHANNEL_DEFAULT);
+
+    printf("Serializer encode, %ld LEDs (%zu bytes), %ld iterations\n", leds, len, iters);
+    printf("%-6s %8s %13s %13s %9s %9s\n", "slots", "words", "table", "bitwise", "speedup", "check");
+    printf("-------------------------------------------------------------\n");
+    run_slots(&ctx, &dma, 3, 0x4, 0x6, frame, len, iters);
+    run_slots(&ctx, &dma, 4, 0x8, 0xE, frame, len, iters);
+
+    hpwm_ctx_stop(&ctx);
+    free(frame);
+    return 0;
+}
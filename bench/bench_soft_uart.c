@@ -0,0 +1,140 @@
+/*
+ * bench_soft_uart.c - Bit-banged UART ports served by one thread
+ *
+ * Streams bytes through two looped-back rpi_soft_uart.h ports (TX 17 ->
+ * RX 27, TX 22 -> RX 23) at 9600 to 115200 baud, all served by one
+ * thread. Reports per port the bytes that came back intact, framing and
+ * parity errors, the worst bit lateness, and the CPU time spent on that
+ * port's bits as a share of one core; the last column is the whole
+ * thread, which busy-polls for start bits.
+ *
+ * On a Pi (mmap backend) jumper the pin pairs above and run as root,
+ * ideally with an isolated core given as core. Elsewhere (or with -s) the
+ * wires are modelled in the GPIO simulator observer.
+ *
+ * Usage: ./bench_soft_uart [-s] [ms] [core]
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_SOFT_UART_IMPLEMENTATION
+#include "rpi_soft_uart.h"
+
+#define BENCH_PORTS       2
+#define BENCH_DEFAULT_MS  500
+#define BENCH_FEED_US     1000
+
+static const int tx_pins[BENCH_PORTS] = { 17, 22 };
+static const int rx_pins[BENCH_PORTS] = { 27, 23 };
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Simulated jumpers */
+static void wire_observer(void* user, uint64_t prev, uint64_t levels) {
+    gpio_ctx_t* gpio = (gpio_ctx_t*)user;
+    for (int i = 0; i < BENCH_PORTS; i++) {
+        if (((prev ^ levels) >> tx_pins[i]) & 1) {
+            gpio_ctx_sim_set_input(gpio, rx_pins[i], (levels >> tx_pins[i]) & 1);
+        }
+    }
+}
+
+/* Pattern byte n of a port's stream */
+static inline uint8_t pattern(int port, uint64_t n) {
+    return (uint8_t)(n * 7 + (uint64_t)port * 101);
+}
+
+static void run_baud(gpio_ctx_t* gpio, uint32_t baud, int ms, int core) {
+    soft_uart_t uart;
+    uint64_t sent[BENCH_PORTS] = { 0 }, got[BENCH_PORTS] = { 0 }, good[BENCH_PORTS] = { 0 };
+    uint8_t last[BENCH_PORTS] = { 0 };
+
+    soft_uart_init(&uart, gpio);
+    for (int i = 0; i < BENCH_PORTS; i++) soft_uart_add(&uart, tx_pins[i], rx_pins[i], baud);
+    if (soft_uart_start(&uart, core) != 0) return;
+
+    /* Keep both TX rings topped up; a byte is intact when it follows its
+     * predecessor in the pattern, so one lost byte costs one, not the rest */
+    uint8_t buf[256];
+    uint64_t end = now_ns() + (uint64_t)ms * 1000000ull;
+    while (now_ns() < end) {
+        for (int i = 0; i < BENCH_PORTS; i++) {
+            for (size_t k = 0; k < sizeof(buf); k++) buf[k] = pattern(i, sent[i] + k);
+            sent[i] += soft_uart_write(&uart, i, buf, sizeof(buf));
+            size_t n;
+            while ((n = soft_uart_read(&uart, i, buf, sizeof(buf))) > 0) {
+                for (size_t k = 0; k < n; k++) {
+                    good[i] += got[i] + k > 0 && buf[k] == (uint8_t)(last[i] + 7);
+                    last[i] = buf[k];
+                }
+                got[i] += n;
+            }
+        }
+        usleep(BENCH_FEED_US);
+    }
+    soft_uart_stop(&uart);
+
+    double thread_cpu = 100.0 * (double)uart.thread_cpu_ns / (double)uart.thread_ns;
+    for (int i = 0; i < BENCH_PORTS; i++) {
+        soft_uart_stats_t st;
+        soft_uart_get_stats(&uart, i, &st);
+        printf("%-7u %4d %9llu %9llu %7llu %7llu %9.1f %8.2f%% %7.0f%% %3s\n", baud, i,
+               (unsigned long long)st.tx_bytes, (unsigned long long)good[i],
+               (unsigned long long)st.framing_errors, (unsigned long long)st.parity_errors,
+               st.max_late_ns / 1e3, 100.0 * (double)st.busy_ns / (double)uart.thread_ns, thread_cpu,
+               uart.realtime ? "yes" : "no");
+    }
+}
+
+int main(int argc, char** argv) {
+    static const uint32_t rates[] = { 9600, 19200, 38400, 57600, 115200 };
+    int simulate = 0, ms = BENCH_DEFAULT_MS, core = -1, positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) simulate = 1;
+        else if (positional++ == 0) ms = atoi(argv[i]) > 0 ? atoi(argv[i]) : BENCH_DEFAULT_MS;
+        else core = atoi(argv[i]);
+    }
+
+    gpio_ctx_t gpio;
+    memset(&gpio, 0, sizeof(gpio));
+    int hw = !simulate && gpio_ctx_init(&gpio, GPIO_BACKEND_MMAP) == 0;
+    if (!hw) {
+        if (gpio_ctx_init(&gpio, GPIO_BACKEND_SIM) != 0) {
+            fprintf(stderr, "Failed to open the GPIO simulator\n");
+            return 1;
+        }
+        for (int i = 0; i < BENCH_PORTS; i++) gpio_ctx_sim_set_input(&gpio, rx_pins[i], HIGH);
+        gpio_ctx_sim_set_observer(&gpio, wire_observer, &gpio);
+    }
+
+    printf("%d looped-back ports on %s GPIO, %d ms per rate, thread %s\n", BENCH_PORTS, hw ? "mmap" : "simulated",
+           ms, core >= 0 ? "pinned" : "unpinned");
+    printf("%-7s %4s %9s %9s %7s %7s %9s %9s %8s %3s\n", "baud", "port", "sent", "intact", "framing",
+           "parity", "late us", "port cpu", "thread", "rt");
+    printf("-----------------------------------------------------------------------------------------\n");
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) run_baud(&gpio, rates[i], ms, core);
+
+    if (!hw) gpio_ctx_sim_set_observer(&gpio, NULL, NULL);
+    gpio_ctx_cleanup(&gpio);
+    return 0;
+}
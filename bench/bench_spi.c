@@ -0,0 +1,183 @@
+/*
+ * bench_spi.c - Hardware SPI0 latency and throughput, polled vs DMA
+ *
+ * Runs single transfers of 4 B to 32 KiB through rpi_spi.h, once polled
+ * and once through the DMA queue, and reports per-transfer latency,
+ * throughput and CPU register accesses. A second table queues 32 messages
+ * and compares the run with the time the bytes alone need on the wire.
+ *
+ * On a Pi this uses SPI0 and DMA channels 9/10 in wall time; jumper MOSI
+ * (GPIO 10) to MISO (GPIO 9) for the data check, and lower the clock if
+ * it fails. Elsewhere (or with -s) it
+ * runs on the simulated block in virtual time, where a register access
+ * costs SPI_SIM_ACCESS_NS and a DMA word DMA_SIM_WORD_NS.
+ *
+ * Usage: ./bench_spi [-s] [mhz]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_SPI_IMPLEMENTATION
+#include "rpi_spi.h"
+
+#define BENCH_TX_CHANNEL   10
+#define BENCH_RX_CHANNEL   9
+#define BENCH_MAX_LEN      32768
+#define BENCH_QUEUE_LEN    32
+#define BENCH_QUEUE_BYTES  256
+#define BENCH_DEFAULT_MHZ  125
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct {
+    spi_ctx_t ctx;
+    spi_queue_t queue;
+    dma_chan_t tx, rx;
+    spi_sim_t sim;
+    dma_sim_t dma_sim;
+    int simulated;
+} bench_t;
+
+/* Virtual time on the simulator, wall time on the Pi */
+static uint64_t bench_ns(const bench_t* b) {
+    return b->simulated ? b->sim.now_ns : now_ns();
+}
+
+static uint64_t bench_accesses(const bench_t* b) {
+    return b->simulated ? b->sim.accesses : 0;
+}
+
+static int bench_open(bench_t* b, int simulate) {
+    memset(b, 0, sizeof(*b));
+    if (!simulate && spi_ctx_init(&b->ctx, NULL) == 0) {
+        if (dma_chan_open(&b->tx, BENCH_TX_CHANNEL) == 0 && dma_chan_open(&b->rx, BENCH_RX_CHANNEL) == 0 &&
+            spi_queue_open(&b->queue, &b->ctx, &b->tx, &b->rx, BENCH_QUEUE_LEN, BENCH_MAX_LEN) == 0) {
+            return 0;
+        }
+        fprintf(stderr, "DMA unavailable, falling back to the simulator\n");
+        dma_chan_close(&b->tx);
+        dma_chan_close(&b->rx);
+        spi_ctx_close(&b->ctx);
+    }
+
+    b->simulated = 1;
+    spi_sim_init(&b->sim, NULL, NULL, NULL, 0);
+    dma_sim_init(&b->dma_sim);
+    if (spi_sim_attach(&b->sim, &b->ctx, &b->dma_sim) != 0) return -1;
+    if (dma_chan_attach(&b->tx, b->dma_sim.regs, BENCH_TX_CHANNEL) != 0) return -1;
+    if (dma_chan_attach(&b->rx, b->dma_sim.regs, BENCH_RX_CHANNEL) != 0) return -1;
+    return spi_queue_open(&b->queue, &b->ctx, &b->tx, &b->rx, BENCH_QUEUE_LEN, BENCH_MAX_LEN);
+}
+
+static void bench_close(bench_t* b) {
+    spi_queue_close(&b->queue);
+    if (!b->simulated) {
+        dma_chan_close(&b->tx);
+        dma_chan_close(&b->rx);
+    }
+    spi_ctx_close(&b->ctx);
+}
+
+/* One transfer: returns ns, fills accesses and whether the loopback matched */
+static uint64_t run_one(bench_t* b, int dma, const uint8_t* tx, uint8_t* rx, size_t len,
+                        uint64_t* accesses, int* ok) {
+    spi_ctx_set_dma(&b->ctx, dma ? &b->queue : NULL, 1);
+    uint64_t a0 = bench_accesses(b);
+    uint64_t t0 = bench_ns(b);
+    *ok = spi_ctx_transfer(&b->ctx, 0, tx, rx, len) == 0 && memcmp(tx, rx, len) == 0;
+    uint64_t t = bench_ns(b) - t0;
+    *accesses = bench_accesses(b) - a0;
+    return t;
+}
+
+/* Register accesses are only counted on the simulator */
+static const char* fmt_regs(const bench_t* b, uint64_t n, char* buf, size_t size) {
+    if (b->simulated) snprintf(buf, size, "%llu", (unsigned long long)n);
+    else snprintf(buf, size, "-");
+    return buf;
+}
+
+static void run_single(bench_t* b, const uint8_t* tx, uint8_t* rx) {
+    static const size_t lens[] = { 4, 32, 64, 256, 1024, 4096, BENCH_MAX_LEN };
+
+    printf("%-7s %11s %9s %7s %11s %9s %7s %6s\n", "bytes", "polled us", "MB/s", "regs",
+           "dma us", "MB/s", "regs", "check");
+    printf("--------------------------------------------------------------------------\n");
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        size_t len = lens[i];
+        uint64_t pa, da;
+        int pok, dok;
+        char pr[24], dr[24];
+        uint64_t pt = run_one(b, 0, tx, rx, len, &pa, &pok);
+        uint64_t dt = run_one(b, 1, tx, rx, len, &da, &dok);
+        printf("%-7zu %11.2f %9.2f %7s %11.2f %9.2f %7s %6s\n", len,
+               pt / 1e3, len * 1e3 / (double)pt, fmt_regs(b, pa, pr, sizeof(pr)),
+               dt / 1e3, len * 1e3 / (double)dt, fmt_regs(b, da, dr, sizeof(dr)),
+               pok && dok ? "ok" : "FAIL");
+    }
+}
+
+static void run_queue(bench_t* b, const uint8_t* tx) {
+    spi_queue_clear(&b->queue);
+    for (int i = 0; i < BENCH_QUEUE_LEN; i++) {
+        spi_queue_add(&b->queue, 0, tx + i * BENCH_QUEUE_BYTES, BENCH_QUEUE_BYTES);
+    }
+
+    uint64_t t0 = bench_ns(b);
+    spi_queue_start(&b->queue);
+    int rc = spi_queue_wait(&b->queue);
+    uint64_t t = bench_ns(b) - t0;
+
+    int ok = rc == 0;
+    for (int i = 0; i < BENCH_QUEUE_LEN && ok; i++) {
+        const uint8_t* in = spi_queue_rx(&b->queue, i, NULL);
+        ok = in && memcmp(in, tx + i * BENCH_QUEUE_BYTES, BENCH_QUEUE_BYTES) == 0;
+    }
+
+    double wire_ns = BENCH_QUEUE_LEN * BENCH_QUEUE_BYTES * 8e9 / b->ctx.clock_hz;
+    printf("\nQueue of %d x %d bytes, back to back\n", BENCH_QUEUE_LEN, BENCH_QUEUE_BYTES);
+    printf("%-12s %10s %10s %12s %6s\n", "run us", "wire us", "bus use", "gap us/msg", "check");
+    printf("-----------------------------------------------------\n");
+    printf("%-12.2f %10.2f %9.1f%% %12.2f %6s\n", t / 1e3, wire_ns / 1e3, 100.0 * wire_ns / t,
+           (t - wire_ns) / 1e3 / BENCH_QUEUE_LEN, ok ? "ok" : "FAIL");
+    spi_queue_clear(&b->queue);
+}
+
+int main(int argc, char** argv) {
+    int simulate = 0, mhz = BENCH_DEFAULT_MHZ;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) simulate = 1;
+        else if (atoi(argv[i]) > 0) mhz = atoi(argv[i]);
+    }
+
+    bench_t b;
+    if (bench_open(&b, simulate) != 0) {
+        fprintf(stderr, "Failed to set up SPI\n");
+        return 1;
+    }
+    uint32_t hz = spi_ctx_set_clock(&b.ctx, (uint32_t)mhz * 1000000u);
+
+    static uint8_t tx[BENCH_MAX_LEN], rx[BENCH_MAX_LEN];
+    for (int i = 0; i < BENCH_MAX_LEN; i++) tx[i] = (uint8_t)(i * 37 + 11);
+
+    printf("SPI0 %s, SCLK %.2f MHz (wire limit %.2f MB/s), %s time\n",
+           b.simulated ? "simulator" : "mmap", hz / 1e6, hz / 8e6, b.simulated ? "virtual" : "wall");
+    run_single(&b, tx, rx);
+    run_queue(&b, tx);
+
+    bench_close(&b);
+    return 0;
+}
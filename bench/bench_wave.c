@@ -0,0 +1,135 @@
+/*
+ * bench_wave.c - DMA waveform compile rate and simulated edge accuracy
+ *
+ * Builds a pseudo-random waveform (pin toggles with 1-20 tick delays) and
+ *   - times wave_compile() per step
+ *   - plays it on the host simulator (wave_sim_t) with PWM and PCM pacing
+ *     and reports the error of every edge against its ideal tick position
+ *
+ * Edge errors come from the DMA model (block fetch and bus cycles), so they
+ * show the engine's structure, not silicon timing.
+ *
+ * Usage: ./bench_wave [steps] [tick_ns]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_HW_PWM_IMPLEMENTATION
+#include "rpi_hw_pwm.h"
+
+#define RPI_WAVE_IMPLEMENTATION
+#include "rpi_wave.h"
+
+#define BENCH_DEFAULT_STEPS 2000
+#define BENCH_DEFAULT_TICK  250
+#define BENCH_COMPILE_ITERS 50
+
+static wave_sim_t sim;
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void run_pacer(wave_pacer_t pacer, const wave_step_t* steps, int count,
+                      const uint64_t* ideal_ticks, uint32_t tick_ns) {
+    const char* name = pacer == WAVE_PACE_PCM ? "pcm" : "pwm";
+    wave_edge_t* log = malloc((size_t)count * sizeof(wave_edge_t));
+    wave_engine_t eng;
+    dma_chan_t dma;
+    wave_t w;
+
+    wave_sim_init(&sim, log, (size_t)count);
+    if (wave_sim_engine(&sim, &eng, pacer, tick_ns, &dma) != 0) {
+        printf("%-6s unavailable\n", name);
+        free(log);
+        return;
+    }
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < BENCH_COMPILE_ITERS; i++) {
+        wave_compile(&w, &eng, steps, count);
+        if (i + 1 < BENCH_COMPILE_ITERS) wave_free(&w);
+    }
+    double compile_ns = (double)(now_ns() - t0) / BENCH_COMPILE_ITERS / count;
+
+    wave_play(&eng, &w, 0);
+    t0 = now_ns();
+    wave_sim_run(&sim, (uint64_t)(w.duration_ns + 100 * eng.tick_ns));
+    double sim_ms = (now_ns() - t0) / 1e6;
+
+    /* Every step toggles one bank-0 pin, so edge i belongs to step i */
+    double max_err = 0.0, sum_err = 0.0;
+    size_t n = sim.log_len;
+    for (size_t i = 1; i < n; i++) {
+        double ideal = ideal_ticks[i] * eng.tick_ns;
+        double err = (double)(log[i].t_ns - log[0].t_ns) - ideal;
+        if (err < 0) err = -err;
+        if (err > max_err) max_err = err;
+        sum_err += err;
+    }
+
+    printf("%-6s %8.1f ns %7d %9.1f ns %9.1f ns %9.1f ns %9.1f ms %7zu/%d\n", name, eng.tick_ns, w.num_cbs,
+           compile_ns, n > 1 ? sum_err / (n - 1) : 0.0, max_err, sim_ms, n, count);
+
+    wave_free(&w);
+    wave_engine_close(&eng);
+    free(log);
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_STEPS;
+    uint32_t tick_ns = argc > 2 ? (uint32_t)atoi(argv[2]) : BENCH_DEFAULT_TICK;
+    if (count <= 0) count = BENCH_DEFAULT_STEPS;
+    if (tick_ns == 0) tick_ns = BENCH_DEFAULT_TICK;
+
+    /* Delays are whole microseconds, so ticks per step depend on tick_ns */
+    wave_step_t* steps = malloc((size_t)count * sizeof(wave_step_t));
+    uint64_t* ideal = malloc((size_t)count * sizeof(uint64_t));
+    uint32_t x = 1;
+    for (int i = 0; i < count; i++) {
+        x = x * 1103515245u + 12345u;
+        int pin = 4 + (int)((x >> 16) % 20);
+        uint64_t bit = 1ull << pin;
+        steps[i].set_mask = i % 2 ? 0 : bit;
+        steps[i].clr_mask = i % 2 ? (steps[i - 1].set_mask) : 0;
+        steps[i].delay_us = 1 + (x >> 8) % 20;
+    }
+
+    printf("Waveform engine, %d steps, %u ns tick (simulated DMA)\n", count, tick_ns);
+    printf("%-6s %11s %7s %12s %12s %12s %12s %9s\n",
+           "pacer", "tick", "cbs", "compile", "mean_err", "max_err", "sim_time", "edges");
+    printf("--------------------------------------------------------------------------------------\n");
+
+    for (int p = 0; p < 2; p++) {
+        wave_pacer_t pacer = p ? WAVE_PACE_PCM : WAVE_PACE_PWM;
+
+        /* Ideal edge positions in achieved ticks */
+        wave_engine_t eng;
+        dma_chan_t dma;
+        wave_sim_init(&sim, NULL, 0);
+        if (wave_sim_engine(&sim, &eng, pacer, tick_ns, &dma) == 0) {
+            uint64_t t = 0;
+            for (int i = 0; i < count; i++) {
+                ideal[i] = t;
+                t += (uint64_t)(steps[i].delay_us * 1000.0 / eng.tick_ns + 0.5);
+            }
+            wave_engine_close(&eng);
+        }
+        run_pacer(pacer, steps, count, ideal, tick_ns);
+    }
+
+    free(ideal);
+    free(steps);
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * bench_ws2812.c - WS2812 encode speed and per-bit timing error
+ *
+ * First encodes a 144-LED GRB frame into bit durations with the per-byte
+ * table ws2812_show() uses and with a naive loop (one branch per bit), and
+ * reports LEDs/s. Then streams frames from the sending thread for ms
+ * milliseconds while this thread renders and encodes the next one, and
+ * prints the distribution of the high time error of every bit sent, the
+ * lows long enough to latch mid-frame and whether the setup is within the
+ * +-150 ns the LEDs tolerate.
+ *
+ * On a Pi (mmap backend) run as root with the strip on GPIO 18 and an
+ * isolated core (isolcpus=3) given as core. Elsewhere (or with -s) the
+ * simulator shows the software cost; its stores are too slow for spec.
+ *
+ * Usage: ./bench_ws2812 [-s] [ms] [core]
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_WS2812_IMPLEMENTATION
+#include "rpi_ws2812.h"
+
+#define BENCH_PIN         18
+#define BENCH_LEDS        144
+#define BENCH_ENCODES     2000
+#define BENCH_DEFAULT_MS  1000
+
+/* ---------------------------------------------------------------------------
+ * Timing
+ * ---------------------------------------------------------------------------*/
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Reference: one branch per bit, wire order G R B */
+static void naive_encode(const ws2812_t* strip, ws2812_bit_t* out) {
+    const ws2812_bit_t one = strip->table[0xFF * 8], zero = strip->table[0];
+    for (size_t n = 0; n < strip->count; n++) {
+        uint32_t p = strip->pixels[n];
+        uint32_t grb = ((p >> 8) & 0xFF) << 16 | ((p >> 16) & 0xFF) << 8 | (p & 0xFF);
+        for (int i = 23; i >= 0; i--) *out++ = ((grb >> i) & 1) ? one : zero;
+    }
+}
+
+static void rainbow(ws2812_t* strip, unsigned frame) {
+    for (size_t i = 0; i < strip->count; i++) {
+        unsigned h = (unsigned)(i * 256 / strip->count + frame) & 0xFF;
+        unsigned r = h < 85 ? 255 - h * 3 : h < 170 ? 0 : (h - 170) * 3;
+        unsigned g = h < 85 ? h * 3 : h < 170 ? 255 - (h - 85) * 3 : 0;
+        unsigned b = h < 85 ? 0 : h < 170 ? (h - 85) * 3 : 255 - (h - 170) * 3;
+        ws2812_set_pixel(strip, i, WS2812_RGB(r, g, b));
+    }
+}
+
+static void run_encode(ws2812_t* strip) {
+    rainbow(strip, 0);
+    ws2812_bit_t* ref = (ws2812_bit_t*)malloc(strip->nbits * sizeof(ws2812_bit_t));
+    if (!ref) return;
+    double leds = (double)BENCH_ENCODES * BENCH_LEDS;
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < BENCH_ENCODES; i++) ws2812_encode(strip, strip->bits[1]);
+    double table_s = (double)(now_ns() - t0) / 1e9;
+
+    t0 = now_ns();
+    for (int i = 0; i < BENCH_ENCODES; i++) naive_encode(strip, ref);
+    double naive_s = (double)(now_ns() - t0) / 1e9;
+    int same = memcmp(ref, strip->bits[1], strip->nbits * sizeof(ws2812_bit_t)) == 0;
+    free(ref);
+
+    printf("Encoding, %d GRB LEDs -> %zu bit durations\n", BENCH_LEDS, strip->nbits);
+    printf("%-8s %12s %10s\n", "method", "MLED/s", "frame us");
+    printf("--------------------------------\n");
+    printf("%-8s %12.2f %10.2f\n", "table", leds / table_s / 1e6, table_s * 1e6 / BENCH_ENCODES);
+    printf("%-8s %12.2f %10.2f   %.1fx slower%s\n", "naive", leds / naive_s / 1e6,
+           naive_s * 1e6 / BENCH_ENCODES, naive_s / table_s, same ? "" : ", MISMATCH");
+}
+
+static void run_emit(ws2812_t* strip, int ms, int core) {
+    if (ws2812_start(strip, core) != 0) return;
+
+    /* show() blocks only until the thread takes the previous frame */
+    unsigned frame = 0;
+    uint64_t render_ns = 0, t0 = now_ns(), end = t0 + (uint64_t)ms * 1000000u;
+    while (now_ns() < end) {
+        uint64_t r0 = now_ns();
+        rainbow(strip, frame++);
+        render_ns += now_ns() - r0;
+        ws2812_show(strip);
+    }
+    ws2812_stop(strip);
+    double secs = (double)(now_ns() - t0) / 1e9;
+
+    ws2812_stats_t st;
+    ws2812_get_stats(strip, &st);
+    if (st.bits == 0) return;
+
+    printf("\nEmission on %s GPIO for %d ms, thread %s%s\n", strip->gpio->regs ? "mmap" : "simulated", ms,
+           core >= 0 ? "pinned" : "unpinned", strip->realtime ? ", SCHED_FIFO" : "");
+    printf("  %llu frames (%.1f fps), frame %.1f us, render %.1f us/frame (overlaps sending)\n",
+           (unsigned long long)st.frames, (double)st.frames / secs, st.last_frame_ns / 1e3,
+           frame ? (double)render_ns / frame / 1e3 : 0.0);
+
+    printf("\n%-12s %12s %8s %8s\n", "|error| ns", "bits", "%", "cum %");
+    printf("------------------------------------------\n");
+    uint64_t cum = 0;
+    for (int b = 0; b <= WS2812_HIST_BINS; b++) {
+        if (!st.hist[b]) continue;
+        cum += st.hist[b];
+        char range[16];
+        if (b < WS2812_HIST_BINS) snprintf(range, sizeof(range), "%d-%d", b * WS2812_HIST_NS, (b + 1) * WS2812_HIST_NS);
+        else snprintf(range, sizeof(range), ">=%d", b * WS2812_HIST_NS);
+        printf("%-12s %12llu %7.3f%% %7.3f%%\n", range, (unsigned long long)st.hist[b],
+               100.0 * st.hist[b] / st.bits, 100.0 * cum / st.bits);
+    }
+
+    printf("\n  mean %.1f ns, max %llu ns, out of spec %llu (%.4f%%), long lows %llu (max %.2f us)\n",
+           (double)st.total_err_ns / st.bits, (unsigned long long)st.max_err_ns, (unsigned long long)st.out_of_spec,
+           100.0 * st.out_of_spec / st.bits, (unsigned long long)st.long_lows, st.max_low_ns / 1e3);
+    printf("  %s\n", st.out_of_spec == 0 && st.long_lows == 0 ? "RELIABLE: every bit within +-150 ns"
+                                                              : "UNRELIABLE: expect wrong colours or early latches");
+}
+
+int main(int argc, char** argv) {
+    int simulate = 0, ms = BENCH_DEFAULT_MS, core = -1, positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) simulate = 1;
+        else if (positional++ == 0) ms = atoi(argv[i]) > 0 ? atoi(argv[i]) : BENCH_DEFAULT_MS;
+        else core = atoi(argv[i]);
+    }
+
+    gpio_ctx_t gpio;
+    memset(&gpio, 0, sizeof(gpio));
+    int hw = !simulate && gpio_ctx_init(&gpio, GPIO_BACKEND_MMAP) == 0;
+    if (!hw && gpio_ctx_init(&gpio, GPIO_BACKEND_SIM) != 0) {
+        fprintf(stderr, "Failed to open the GPIO simulator\n");
+        return 1;
+    }
+
+    ws2812_t strip;
+    if (ws2812_init(&strip, &gpio, BENCH_PIN, BENCH_LEDS, WS2812_GRB) != 0) {
+        gpio_ctx_cleanup(&gpio);
+        return 1;
+    }
+    printf("Counter: %.3f ticks/ns\n\n", ws2812_ticks_per_ns());
+    run_encode(&strip);
+    run_emit(&strip, ms, core);
+
+    ws2812_free(&strip);
+    gpio_ctx_cleanup(&gpio);
+    return 0;
+}
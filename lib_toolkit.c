@@ -20,6 +20,56 @@
 #define RPI_HW_PWM_IMPLEMENTATION
 #include "rpi_hw_pwm.h"
 
+#define RPI_WAVE_IMPLEMENTATION
+#include "rpi_wave.h"
+
 #define RPI_REALTIME_IMPLEMENTATION
 #include "rpi_realtime.h"
 
+#define RPI_GPIO_EVENT_IMPLEMENTATION
+#include "rpi_gpio_event.h"
+
+#define RPI_BITBANG_IMPLEMENTATION
+#include "rpi_bitbang.h"
+
+#define RPI_LOGIC_IMPLEMENTATION
+#include "rpi_logic.h"
+
+#define RPI_DEBOUNCE_IMPLEMENTATION
+#include "rpi_debounce.h"
+
+#define RPI_ENCODER_IMPLEMENTATION
+#include "rpi_encoder.h"
+
+#define RPI_SOFT_SPI_IMPLEMENTATION
+#include "rpi_soft_spi.h"
+
+#define RPI_SOFT_I2C_IMPLEMENTATION
+#include "rpi_soft_i2c.h"
+
+#define RPI_SOFT_UART_IMPLEMENTATION
+#include "rpi_soft_uart.h"
+
+#define RPI_HC595_IMPLEMENTATION
+#include "rpi_hc595.h"
+
+#define RPI_HUB75_IMPLEMENTATION
+#include "rpi_hub75.h"
+
+#define RPI_GPIO_BUS_IMPLEMENTATION
+#include "rpi_gpio_bus.h"
+
+#define RPI_WS2812_IMPLEMENTATION
+#include "rpi_ws2812.h"
+
+#define RPI_SPI_IMPLEMENTATION
+#include "rpi_spi.h"
+
+#define RPI_ADC_IMPLEMENTATION
+#include "rpi_adc.h"
+
+#define RPI_I2C_IMPLEMENTATION
+#include "rpi_i2c.h"
+
+#define RPI_GPIOCHIP_IMPLEMENTATION
+#include "rpi_gpiochip.h"
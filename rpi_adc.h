@@ -0,0 +1,749 @@
+/**
+ * @file rpi_adc.h
+ * @brief Continuous SPI ADC sampling into a timestamped lock-free ring.
+ *
+ * Single-header library. Define RPI_ADC_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h, rpi_realtime.h, rpi_spi.h and pthread (-pthread
+ * linker flag).
+ *
+ * A sampler thread, pinned to a core and raised to SCHED_FIFO when
+ * permitted (unpinned samplers stay normal), starts a scan at absolute CLOCK_MONOTONIC deadlines: every
+ * period it converts each configured channel with one polled SPI0 frame
+ * (MCP3004/3008, MCP3204/3208 or ADS7886 framing) and stores one
+ * (timestamp, scan, channel, value) record per conversion in a
+ * preallocated single-producer, single-consumer ring. Deadlines are
+ * absolute, so a late wake-up does not shift the following scans.
+ *
+ * The consumer side is zero-copy: adc_peek() returns a pointer to the
+ * oldest contiguous run of samples inside the ring, adc_release() hands
+ * them back. Python wraps the same run as a ctypes array (buffer protocol,
+ * so memoryview() and numpy.frombuffer() work without copying).
+ *
+ * Overruns are reported, not hidden:
+ *   - ring full: the whole scan is skipped (no SPI traffic) and its
+ *     samples are counted in adc_stats_t.overruns;
+ *   - sampler late by a full period or more: the missed ticks are counted
+ *     in adc_stats_t.missed and skipped, never made up in a burst.
+ * Either way the scan number advances, so gaps show in adc_sample_t.seq.
+ *
+ * adc_sim_t models the converters as an rpi_spi.h simulator slave, so the
+ * whole pipeline runs on a host; adc_open_sim() wires one up.
+ *
+ * Functions taking an adc_t* use adc_default when passed NULL.
+ */
+
+#ifndef RPI_ADC_H
+#define RPI_ADC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default ring capacity in samples (rounded up to a power of two). */
+#define ADC_CAPACITY_DEFAULT 65536
+
+/** Channels per scan. */
+#define ADC_MAX_CHANNELS 8
+
+/** Longest SPI frame of a supported converter. */
+#define ADC_FRAME_MAX 3
+
+/**
+ * Without a pinned core the sampler sleeps until this long before each
+ * deadline and spins the rest, absorbing the wake-up latency.
+ */
+#ifndef ADC_SPIN_NS
+#define ADC_SPIN_NS 100000
+#endif
+
+/** Sleep of adc_wait() while the ring is empty. */
+#ifndef ADC_IDLE_US
+#define ADC_IDLE_US 100
+#endif
+
+/**
+ * @brief Supported converters.
+ */
+typedef enum {
+    ADC_MCP3008 = 0,          /**< 10-bit, 8 channels (MCP3004: 0-3). */
+    ADC_MCP3208,              /**< 12-bit, 8 channels (MCP3204: 0-3). */
+    ADC_ADS7886,              /**< 12-bit, 1 channel, no command (ADS7886/ADS7887-class). */
+    ADC_CHIP_COUNT
+} adc_chip_t;
+
+/**
+ * @brief One conversion. 16 bytes, no padding.
+ */
+typedef struct {
+    uint64_t t_ns;            /**< CLOCK_MONOTONIC time the frame started. */
+    uint32_t seq;             /**< Scan number since adc_start() (gaps = overruns or missed ticks). */
+    uint16_t channel;
+    uint16_t value;           /**< Right-aligned code. */
+} adc_sample_t;
+
+/**
+ * @brief Pipeline statistics (written by the sampler).
+ */
+typedef struct {
+    uint64_t scans;           /**< Scans converted. */
+    uint64_t samples;         /**< Samples stored. */
+    uint64_t overruns;        /**< Samples not taken because the ring was full. */
+    uint64_t missed;          /**< Ticks skipped because the sampler woke a period late. */
+    uint64_t errors;          /**< Failed SPI transfers. */
+    uint64_t max_late_ns;     /**< Worst wake-up lateness against the deadline. */
+    uint64_t start_ns;        /**< Time of the first scan. */
+    uint64_t end_ns;          /**< Time of the latest scan. */
+} adc_stats_t;
+
+/**
+ * @brief Sampling pipeline: converter, sample ring and sampler state.
+ */
+typedef struct {
+    uint64_t head __attribute__((aligned(64)));  /**< Written by the sampler. */
+    uint64_t tail __attribute__((aligned(64)));  /**< Written by the consumer. */
+    adc_sample_t* ring __attribute__((aligned(64)));
+    size_t capacity;          /**< Power of two. */
+    spi_ctx_t* spi;
+    int cs;
+    adc_chip_t chip;
+    uint8_t channels[ADC_MAX_CHANNELS];
+    int num_channels;
+    uint8_t frames[ADC_MAX_CHANNELS][ADC_FRAME_MAX];  /**< Prebuilt command frames. */
+    uint64_t period_ns;
+    uint32_t seq;             /**< Next scan number. */
+    adc_stats_t stats;
+    spi_ctx_t own_spi;        /**< Controller opened by adc_open() or adc_open_sim(). */
+    void* own_sim;            /**< Simulated bus of adc_open_sim(). */
+    pthread_t sampler;
+    int running;
+    int realtime;             /**< Sampler got SCHED_FIFO. */
+    int core_id;
+} adc_t;
+
+/** Pipeline used when a function is passed NULL (the Python bindings use it). */
+extern adc_t adc_default;
+
+/** @name Converter Framing */
+/**@{*/
+
+/**
+ * @brief Resolution in bits (0 for an unknown chip).
+ */
+int adc_chip_bits(adc_chip_t chip);
+
+/**
+ * @brief Channels of the converter (0 for an unknown chip).
+ */
+int adc_chip_channels(adc_chip_t chip);
+
+/**
+ * @brief Build the single-ended command frame for a channel.
+ * @param tx Output, ADC_FRAME_MAX bytes.
+ * @return Frame length in bytes, -1 on an invalid chip or channel.
+ */
+int adc_frame(adc_chip_t chip, int channel, uint8_t* tx);
+
+/**
+ * @brief Extract the code from a received frame.
+ */
+uint16_t adc_decode(adc_chip_t chip, const uint8_t* rx);
+/**@}*/
+
+/** @name Pipeline */
+/**@{*/
+
+/**
+ * @brief Allocate the ring and attach a converter. Samples channel 0.
+ *
+ * With spi NULL, SPI0 is opened through spi_ctx_init() in mode 0 at the
+ * chip's top clock and closed again by adc_close(); a caller-supplied
+ * controller keeps its settings.
+ *
+ * @param cs Chip select 0-2.
+ * @param capacity Samples (0 for ADC_CAPACITY_DEFAULT), rounded up to a power of two.
+ * @return 0 on success, -1 on error.
+ */
+int adc_open(adc_t* adc, spi_ctx_t* spi, int cs, adc_chip_t chip, size_t capacity);
+
+/**
+ * @brief adc_open() on a simulated SPI0 with an adc_sim_t answering CS0.
+ * @param signal Simulated input (NULL for adc_sim_ramp()).
+ * @return 0 on success, -1 on error.
+ */
+int adc_open_sim(adc_t* adc, adc_chip_t chip, size_t capacity,
+                 uint16_t (*signal)(void* user, int channel, uint64_t n), void* user);
+
+/**
+ * @brief Stop sampling, free the ring and close what adc_open() opened.
+ */
+void adc_close(adc_t* adc);
+
+/**
+ * @brief Select the channels converted per scan, in order.
+ *
+ * Must not be called while the sampler runs.
+ *
+ * @return 0 on success, -1 on an empty list or invalid channel.
+ */
+int adc_set_channels(adc_t* adc, const int* channels, int count);
+
+/**
+ * @brief Run scans back to back on the calling thread, without pacing.
+ *
+ * Use instead of adc_start() to drive the pipeline from your own loop (or
+ * a test). Must not be called while the sampler thread runs.
+ *
+ * @return Samples stored.
+ */
+size_t adc_poll(adc_t* adc, size_t scans);
+
+/**
+ * @brief Start the sampler thread.
+ *
+ * Resets the statistics and scan numbers; samples still in the ring stay.
+ *
+ * @param rate_hz Scans per second.
+ * @param core_id CPU core for the sampler, which then busy-waits for each
+ *        deadline, or -1 to sleep until ADC_SPIN_NS before it.
+ * @return 0 on success, -1 on error.
+ */
+int adc_start(adc_t* adc, double rate_hz, int core_id);
+
+/**
+ * @brief Stop the sampler thread. Stored samples stay readable.
+ */
+void adc_stop(adc_t* adc);
+/**@}*/
+
+/** @name Consumer */
+/**@{*/
+
+/**
+ * @brief Samples waiting in the ring.
+ */
+size_t adc_available(adc_t* adc);
+
+/**
+ * @brief Oldest contiguous run of samples, in place in the ring.
+ *
+ * The run ends at the ring's wrap point; call again after adc_release()
+ * for the rest. The pointer stays valid until those samples are released.
+ *
+ * @param samples Output: first sample (NULL when none are waiting).
+ * @return Samples in the run.
+ */
+size_t adc_peek(adc_t* adc, const adc_sample_t** samples);
+
+/**
+ * @brief Return the oldest count samples to the sampler.
+ */
+void adc_release(adc_t* adc, size_t count);
+
+/**
+ * @brief Copy and release up to max samples without blocking.
+ * @return Samples copied.
+ */
+size_t adc_read(adc_t* adc, adc_sample_t* samples, size_t max);
+
+/**
+ * @brief Wait up to timeout_us for at least min_count samples.
+ * @return Samples waiting.
+ */
+size_t adc_wait(adc_t* adc, size_t min_count, uint64_t timeout_us);
+
+/**
+ * @brief Snapshot of the statistics.
+ */
+void adc_get_stats(adc_t* adc, adc_stats_t* stats);
+
+/**
+ * @brief Achieved scan rate in scans per second (0 before two scans).
+ */
+double adc_scan_rate(adc_t* adc);
+/**@}*/
+
+/** @name Simulated Converter */
+/**@{*/
+
+/**
+ * @brief Converter answering rpi_spi.h simulator bytes.
+ *
+ * Frames are counted in bytes, so every transfer on its chip select must
+ * be exactly one frame long (the pipeline's are).
+ */
+typedef struct {
+    adc_chip_t chip;
+    uint16_t (*signal)(void* user, int channel, uint64_t n);  /**< Input; n counts conversions per channel. */
+    void* user;
+    int pos;                  /**< Byte within the frame. */
+    int channel;
+    uint16_t value;           /**< Code of the frame in progress. */
+    uint64_t conversions[ADC_MAX_CHANNELS];
+} adc_sim_t;
+
+/**
+ * @brief Reset the model.
+ * @param signal Input (NULL for adc_sim_ramp()).
+ */
+void adc_sim_init(adc_sim_t* sim, adc_chip_t chip,
+                  uint16_t (*signal)(void* user, int channel, uint64_t n), void* user);
+
+/**
+ * @brief Slave callback for spi_sim_init(), with the adc_sim_t as user.
+ */
+uint8_t adc_sim_slave(void* user, int cs, uint8_t mosi);
+
+/**
+ * @brief Default input: a ramp per channel, (n + 64 * channel) masked to the resolution.
+ */
+uint16_t adc_sim_ramp(adc_chip_t chip, int channel, uint64_t n);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_ADC_H */
+
+#ifdef RPI_ADC_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+
+adc_t adc_default;
+
+typedef struct {
+    int bits;
+    int channels;
+    int frame;
+    uint32_t max_hz;          /**< Datasheet SCLK limit at 2.7 V. */
+} adc_chip_info_t;
+
+static const adc_chip_info_t adc_chips[ADC_CHIP_COUNT] = {
+    [ADC_MCP3008] = { 10, 8, 3, 1350000 },
+    [ADC_MCP3208] = { 12, 8, 3, 1000000 },
+    [ADC_ADS7886] = { 12, 1, 2, 20000000 },
+};
+
+/* Simulated bus of adc_open_sim() */
+typedef struct {
+    spi_sim_t spi;
+    adc_sim_t adc;
+} adc_sim_bus_t;
+
+static uint64_t adc_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline adc_t* adc_or_default(adc_t* adc) {
+    return adc ? adc : &adc_default;
+}
+
+static inline int adc_chip_valid(adc_chip_t chip) {
+    return (int)chip >= 0 && chip < ADC_CHIP_COUNT;
+}
+
+int adc_chip_bits(adc_chip_t chip) {
+    return adc_chip_valid(chip) ? adc_chips[chip].bits : 0;
+}
+
+int adc_chip_channels(adc_chip_t chip) {
+    return adc_chip_valid(chip) ? adc_chips[chip].channels : 0;
+}
+
+int adc_frame(adc_chip_t chip, int channel, uint8_t* tx) {
+    if (!tx || !adc_chip_valid(chip) || channel < 0 || channel >= adc_chips[chip].channels) return -1;
+    memset(tx, 0, ADC_FRAME_MAX);
+    switch (chip) {
+    case ADC_MCP3008:
+        /* Start bit, then SGL/D2/D1/D0 in the top nibble; B9-B8 come back in byte 1 */
+        tx[0] = 0x01;
+        tx[1] = (uint8_t)(0x80 | (channel << 4));
+        break;
+    case ADC_MCP3208:
+        /* Start, SGL and D2 end byte 0 so B11-B8 land in the low nibble of byte 1 */
+        tx[0] = (uint8_t)(0x06 | (channel >> 2));
+        tx[1] = (uint8_t)((channel & 3) << 6);
+        break;
+    default:
+        break;
+    }
+    return adc_chips[chip].frame;
+}
+
+uint16_t adc_decode(adc_chip_t chip, const uint8_t* rx) {
+    switch (chip) {
+    case ADC_MCP3008: return (uint16_t)(((rx[1] & 0x03) << 8) | rx[2]);
+    case ADC_MCP3208: return (uint16_t)(((rx[1] & 0x0F) << 8) | rx[2]);
+    case ADC_ADS7886: return (uint16_t)(((rx[0] & 0x0F) << 8) | rx[1]);
+    default: return 0;
+    }
+}
+
+int adc_set_channels(adc_t* adc, const int* channels, int count) {
+    adc = adc_or_default(adc);
+    if (!channels || count <= 0 || count > ADC_MAX_CHANNELS) {
+        fprintf(stderr, "ADC Error: Need 1-%d channels\n", ADC_MAX_CHANNELS);
+        return -1;
+    }
+    if (adc->running) {
+        fprintf(stderr, "ADC Error: Sampler running\n");
+        return -1;
+    }
+    uint8_t frames[ADC_MAX_CHANNELS][ADC_FRAME_MAX];
+    for (int i = 0; i < count; i++) {
+        if (adc_frame(adc->chip, channels[i], frames[i]) < 0) {
+            fprintf(stderr, "ADC Error: Invalid channel %d\n", channels[i]);
+            return -1;
+        }
+    }
+    for (int i = 0; i < count; i++) adc->channels[i] = (uint8_t)channels[i];
+    memcpy(adc->frames, frames, sizeof(frames[0]) * (size_t)count);
+    adc->num_channels = count;
+    return 0;
+}
+
+int adc_open(adc_t* adc, spi_ctx_t* spi, int cs, adc_chip_t chip, size_t capacity) {
+    adc = adc_or_default(adc);
+    if (!adc_chip_valid(chip) || cs < 0 || cs > 2) {
+        fprintf(stderr, "ADC Error: Invalid chip or chip select\n");
+        return -1;
+    }
+    memset(adc, 0, sizeof(*adc));
+
+    if (capacity == 0) capacity = ADC_CAPACITY_DEFAULT;
+    size_t cap = ADC_MAX_CHANNELS;
+    while (cap < capacity) cap <<= 1;
+
+    adc->ring = aligned_alloc(64, cap * sizeof(adc_sample_t));
+    if (!adc->ring) {
+        fprintf(stderr, "ADC Error: Failed to allocate %zu samples\n", cap);
+        return -1;
+    }
+    adc->capacity = cap;
+    adc->cs = cs;
+    adc->chip = chip;
+    adc->core_id = -1;
+
+    if (!spi) {
+        if (spi_ctx_init(&adc->own_spi, NULL) != 0) {
+            adc_close(adc);
+            return -1;
+        }
+        spi = &adc->own_spi;
+        spi_ctx_set_mode(spi, 0);
+        spi_ctx_set_clock(spi, adc_chips[chip].max_hz);
+    }
+    adc->spi = spi;
+
+    int ch0 = 0;
+    return adc_set_channels(adc, &ch0, 1);
+}
+
+int adc_open_sim(adc_t* adc, adc_chip_t chip, size_t capacity,
+                 uint16_t (*signal)(void* user, int channel, uint64_t n), void* user) {
+    adc = adc_or_default(adc);
+    if (!adc_chip_valid(chip)) {
+        fprintf(stderr, "ADC Error: Invalid chip\n");
+        return -1;
+    }
+    adc_sim_bus_t* bus = calloc(1, sizeof(*bus));
+    if (!bus) {
+        fprintf(stderr, "ADC Error: Failed to allocate the simulator\n");
+        return -1;
+    }
+    adc_sim_init(&bus->adc, chip, signal, user);
+    spi_sim_init(&bus->spi, adc_sim_slave, &bus->adc, NULL, 0);
+
+    spi_ctx_t ctx;
+    if (spi_sim_attach(&bus->spi, &ctx, NULL) != 0) {
+        free(bus);
+        return -1;
+    }
+    spi_ctx_set_clock(&ctx, adc_chips[chip].max_hz);
+
+    if (adc_open(adc, &ctx, 0, chip, capacity) != 0) {
+        free(bus);
+        return -1;
+    }
+    adc->own_spi = ctx;
+    adc->spi = &adc->own_spi;
+    adc->own_sim = bus;
+    return 0;
+}
+
+void adc_close(adc_t* adc) {
+    adc = adc_or_default(adc);
+    adc_stop(adc);
+    if (adc->spi == &adc->own_spi) spi_ctx_close(&adc->own_spi);
+    free(adc->own_sim);
+    free(adc->ring);
+    adc->own_sim = NULL;
+    adc->ring = NULL;
+    adc->spi = NULL;
+    adc->capacity = 0;
+}
+
+/**
+ * One scan: room for every channel is checked first, so a scan is stored
+ * whole or skipped whole. Returns samples stored.
+ */
+static size_t adc_scan(adc_t* adc) {
+    adc_stats_t* st = &adc->stats;
+    uint32_t seq = adc->seq++;
+    int n = adc->num_channels;
+
+    uint64_t head = adc->head;
+    uint64_t tail = __atomic_load_n(&adc->tail, __ATOMIC_ACQUIRE);
+    if (head - tail + (uint64_t)n > adc->capacity) {
+        st->overruns += (uint64_t)n;
+        return 0;
+    }
+
+    int len = adc_chips[adc->chip].frame;
+    size_t mask = adc->capacity - 1;
+    size_t stored = 0;
+    for (int i = 0; i < n; i++) {
+        uint8_t rx[ADC_FRAME_MAX];
+        uint64_t t = adc_now_ns();
+        if (spi_ctx_transfer(adc->spi, adc->cs, adc->frames[i], rx, (size_t)len) != 0) {
+            st->errors++;
+            continue;
+        }
+        adc_sample_t* s = &adc->ring[(head + stored) & mask];
+        s->t_ns = t;
+        s->seq = seq;
+        s->channel = adc->channels[i];
+        s->value = adc_decode(adc->chip, rx);
+        stored++;
+    }
+    __atomic_store_n(&adc->head, head + stored, __ATOMIC_RELEASE);
+
+    uint64_t now = adc_now_ns();
+    if (st->scans == 0) st->start_ns = now;
+    st->end_ns = now;
+    st->scans++;
+    st->samples += stored;
+    return stored;
+}
+
+size_t adc_poll(adc_t* adc, size_t scans) {
+    adc = adc_or_default(adc);
+    if (!adc->ring || adc->running) return 0;
+    size_t stored = 0;
+    for (size_t i = 0; i < scans; i++) stored += adc_scan(adc);
+    return stored;
+}
+
+static void adc_wait_until(const adc_t* adc, uint64_t deadline) {
+    if (adc->core_id < 0 && deadline > adc_now_ns() + ADC_SPIN_NS) {
+        uint64_t wake = deadline - ADC_SPIN_NS;
+        struct timespec ts = { (time_t)(wake / 1000000000ull), (long)(wake % 1000000000ull) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+    }
+    while (adc_now_ns() < deadline) {
+    }
+}
+
+static void* adc_sampler_func(void* arg) {
+    adc_t* adc = (adc_t*)arg;
+    /* Only a pinned sampler spins, so only it may starve the core it runs on */
+    if (adc->core_id >= 0) {
+        pin_to_core(adc->core_id);
+        struct sched_param param = { .sched_priority = sched_get_priority_max(SCHED_FIFO) };
+        adc->realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+
+    uint64_t period = adc->period_ns;
+    uint64_t deadline = adc_now_ns() + period;
+    while (__atomic_load_n(&adc->running, __ATOMIC_RELAXED)) {
+        adc_wait_until(adc, deadline);
+
+        uint64_t late = adc_now_ns() - deadline;
+        if (late > adc->stats.max_late_ns) adc->stats.max_late_ns = late;
+        if (late >= period) {
+            uint64_t skip = late / period;
+            adc->stats.missed += skip;
+            adc->seq += (uint32_t)skip;
+            deadline += skip * period;
+        }
+        adc_scan(adc);
+        deadline += period;
+    }
+    return NULL;
+}
+
+int adc_start(adc_t* adc, double rate_hz, int core_id) {
+    adc = adc_or_default(adc);
+    if (!adc->ring) return -1;
+    if (adc->running) {
+        fprintf(stderr, "ADC Error: Sampler already running\n");
+        return -1;
+    }
+    if (!(rate_hz > 0.0) || rate_hz > 1e9) {
+        fprintf(stderr, "ADC Error: Invalid rate %.1f Hz\n", rate_hz);
+        return -1;
+    }
+
+    adc->period_ns = (uint64_t)(1e9 / rate_hz + 0.5);
+    if (adc->period_ns == 0) adc->period_ns = 1;
+    adc->core_id = core_id;
+    adc->realtime = 0;
+    adc->seq = 0;
+    memset(&adc->stats, 0, sizeof(adc->stats));
+    __atomic_store_n(&adc->running, 1, __ATOMIC_RELEASE);
+
+    if (pthread_create(&adc->sampler, NULL, adc_sampler_func, adc) != 0) {
+        perror("ADC Error: Failed to create sampler thread");
+        adc->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void adc_stop(adc_t* adc) {
+    adc = adc_or_default(adc);
+    if (!adc->running) return;
+    __atomic_store_n(&adc->running, 0, __ATOMIC_RELEASE);
+    pthread_join(adc->sampler, NULL);
+}
+
+size_t adc_available(adc_t* adc) {
+    adc = adc_or_default(adc);
+    return (size_t)(__atomic_load_n(&adc->head, __ATOMIC_ACQUIRE) - adc->tail);
+}
+
+size_t adc_peek(adc_t* adc, const adc_sample_t** samples) {
+    adc = adc_or_default(adc);
+    size_t n = adc->ring ? adc_available(adc) : 0;
+    size_t pos = (size_t)(adc->tail & (adc->capacity - 1));
+    if (n > adc->capacity - pos) n = adc->capacity - pos;
+    if (samples) *samples = n ? &adc->ring[pos] : NULL;
+    return n;
+}
+
+void adc_release(adc_t* adc, size_t count) {
+    adc = adc_or_default(adc);
+    size_t n = adc_available(adc);
+    if (count > n) count = n;
+    __atomic_store_n(&adc->tail, adc->tail + count, __ATOMIC_RELEASE);
+}
+
+size_t adc_read(adc_t* adc, adc_sample_t* samples, size_t max) {
+    adc = adc_or_default(adc);
+    if (!adc->ring || !samples) return 0;
+
+    size_t n = adc_available(adc);
+    if (n > max) n = max;
+    for (size_t i = 0; i < n; i++) {
+        samples[i] = adc->ring[(adc->tail + i) & (adc->capacity - 1)];
+    }
+    __atomic_store_n(&adc->tail, adc->tail + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+size_t adc_wait(adc_t* adc, size_t min_count, uint64_t timeout_us) {
+    adc = adc_or_default(adc);
+    uint64_t deadline = adc_now_ns() + timeout_us * 1000ull;
+    for (;;) {
+        size_t n = adc_available(adc);
+        if (n >= min_count || adc_now_ns() >= deadline) return n;
+        usleep(ADC_IDLE_US);
+    }
+}
+
+void adc_get_stats(adc_t* adc, adc_stats_t* stats) {
+    adc = adc_or_default(adc);
+    if (stats) *stats = adc->stats;
+}
+
+double adc_scan_rate(adc_t* adc) {
+    adc = adc_or_default(adc);
+    const adc_stats_t* st = &adc->stats;
+    if (st->scans < 2 || st->end_ns <= st->start_ns) return 0.0;
+    return (double)(st->scans - 1) * 1e9 / (double)(st->end_ns - st->start_ns);
+}
+
+uint16_t adc_sim_ramp(adc_chip_t chip, int channel, uint64_t n) {
+    uint32_t max = (1u << adc_chip_bits(chip)) - 1;
+    return (uint16_t)((n + 64u * (uint64_t)channel) & max);
+}
+
+void adc_sim_init(adc_sim_t* sim, adc_chip_t chip,
+                  uint16_t (*signal)(void* user, int channel, uint64_t n), void* user) {
+    memset(sim, 0, sizeof(*sim));
+    sim->chip = chip;
+    sim->signal = signal;
+    sim->user = user;
+}
+
+static uint16_t adc_sim_convert(adc_sim_t* sim, int channel) {
+    uint64_t n = sim->conversions[channel]++;
+    uint32_t max = (1u << adc_chip_bits(sim->chip)) - 1;
+    uint16_t v = sim->signal ? sim->signal(sim->user, channel, n) : adc_sim_ramp(sim->chip, channel, n);
+    return (uint16_t)(v & max);
+}
+
+/*
+ * The channel bits arrive in the byte whose reply carries the top of the
+ * code; the model decodes them from that byte's MOSI, as the chip does
+ * from the bits clocked in before it starts driving DOUT.
+ */
+uint8_t adc_sim_slave(void* user, int cs, uint8_t mosi) {
+    adc_sim_t* sim = (adc_sim_t*)user;
+    (void)cs;
+    if (!adc_chip_valid(sim->chip)) return 0;
+
+    int pos = sim->pos;
+    sim->pos = (pos + 1) % adc_chips[sim->chip].frame;
+
+    uint8_t miso = 0;
+    switch (sim->chip) {
+    case ADC_MCP3008:
+        if (pos == 1) {
+            sim->channel = (mosi >> 4) & 7;
+            sim->value = adc_sim_convert(sim, sim->channel);
+            miso = (uint8_t)((sim->value >> 8) & 0x03);
+        } else if (pos == 2) {
+            miso = (uint8_t)sim->value;
+        }
+        break;
+    case ADC_MCP3208:
+        if (pos == 0) {
+            sim->channel = (mosi & 1) << 2;
+        } else if (pos == 1) {
+            sim->channel |= mosi >> 6;
+            sim->value = adc_sim_convert(sim, sim->channel);
+            miso = (uint8_t)((sim->value >> 8) & 0x0F);
+        } else {
+            miso = (uint8_t)sim->value;
+        }
+        break;
+    default:
+        if (pos == 0) {
+            sim->channel = 0;
+            sim->value = adc_sim_convert(sim, 0);
+            miso = (uint8_t)((sim->value >> 8) & 0x0F);
+        } else {
+            miso = (uint8_t)sim->value;
+        }
+        break;
+    }
+    return miso;
+}
+
+#endif /* RPI_ADC_IMPLEMENTATION */
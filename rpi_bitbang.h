@@ -0,0 +1,391 @@
+/**
+ * @file rpi_bitbang.h
+ * @brief CPU playback of precomputed GPIO mask schedules.
+ *
+ * Single-header library. Define RPI_BITBANG_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h, rpi_realtime.h and pthread (-pthread linker flag).
+ *
+ * A schedule is a stream of (set_mask, clr_mask, t_ns) entries, t_ns being
+ * relative to the start of playback. Entries sit in a single-producer,
+ * single-consumer ring stored as separate arrays (struct of arrays), so the
+ * player walks three dense streams and the producer can keep appending from
+ * another thread while playback runs. The player sleeps until shortly before
+ * each deadline, spins on CLOCK_MONOTONIC for the rest, then applies the
+ * entry with one gpio_ctx_write_mask() (one GPSET/GPCLR store per bank that
+ * changes).
+ *
+ * For protocols that rpi_pwm.h cannot express: anything where several pins
+ * move together at arbitrary, precomputed times. Timing is only as good as
+ * the core it runs on; pin the player to an isolated core with SCHED_FIFO
+ * (see rpi_realtime.h) and watch bitbang_stats_t for late entries.
+ */
+
+#ifndef RPI_BITBANG_H
+#define RPI_BITBANG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default ring capacity in entries (rounded up to a power of two). */
+#define BITBANG_CAPACITY_DEFAULT 4096
+
+/** Final part of each wait that is spun instead of slept. */
+#ifndef BITBANG_SPIN_NS
+#define BITBANG_SPIN_NS 50000
+#endif
+
+/** Entries applied later than this past their deadline count as late. */
+#ifndef BITBANG_LATE_NS
+#define BITBANG_LATE_NS 1000
+#endif
+
+/** Sleep between polls of an empty ring when the player is not pinned. */
+#ifndef BITBANG_IDLE_US
+#define BITBANG_IDLE_US 50
+#endif
+
+/**
+ * @brief One schedule entry (append format).
+ */
+typedef struct {
+    uint64_t set_mask;        /**< Pins driven high (bit n = GPIO n). */
+    uint64_t clr_mask;        /**< Pins driven low. */
+    uint64_t t_ns;            /**< Deadline relative to the playback epoch. */
+} bitbang_entry_t;
+
+/**
+ * @brief Playback statistics (written by the player).
+ */
+typedef struct {
+    uint64_t played;          /**< Entries applied. */
+    uint64_t late;            /**< Entries applied more than BITBANG_LATE_NS late. */
+    uint64_t max_late_ns;     /**< Worst lateness seen. */
+    uint64_t total_late_ns;   /**< Sum of lateness (mean = total / played). */
+} bitbang_stats_t;
+
+/**
+ * @brief Playback engine: SoA ring, epoch and player thread.
+ *
+ * head is written only by the producer and tail only by the player; they
+ * sit on separate cache lines.
+ */
+typedef struct {
+    uint64_t head __attribute__((aligned(64)));  /**< Next slot to fill. */
+    uint64_t tail __attribute__((aligned(64)));  /**< Next slot to play. */
+    uint64_t* set_mask __attribute__((aligned(64)));
+    uint64_t* clr_mask;
+    uint64_t* t_ns;
+    size_t capacity;          /**< Power of two. */
+    gpio_ctx_t* gpio;         /**< Context the masks are written to. */
+    uint64_t epoch_ns;        /**< CLOCK_MONOTONIC time of t_ns = 0 (0 = not started). */
+    bitbang_stats_t stats;
+    pthread_t thread;
+    int running;              /**< Player thread active. */
+    int core_id;
+    int realtime;
+} bitbang_t;
+
+/**
+ * @brief Allocate the ring.
+ * @param gpio GPIO context to drive (NULL for gpio_ctx_default). Pins must
+ *             already be outputs.
+ * @param capacity Entries (0 for BITBANG_CAPACITY_DEFAULT), rounded up to a power of two.
+ * @return 0 on success, -1 on error.
+ */
+int bitbang_init(bitbang_t* bb, gpio_ctx_t* gpio, size_t capacity);
+
+/**
+ * @brief Stop the player and free the ring.
+ */
+void bitbang_free(bitbang_t* bb);
+
+/**
+ * @brief Queue entries. Lock-free; call from one producer thread only.
+ *
+ * Deadlines must not decrease. Never blocks: returns how many entries fit.
+ *
+ * @return Entries accepted.
+ */
+size_t bitbang_append(bitbang_t* bb, const bitbang_entry_t* entries, size_t count);
+
+/**
+ * @brief Free slots in the ring (producer side).
+ */
+size_t bitbang_space(const bitbang_t* bb);
+
+/**
+ * @brief Entries queued but not yet played.
+ */
+size_t bitbang_pending(const bitbang_t* bb);
+
+/**
+ * @brief Play queued entries on the calling thread until the ring is empty.
+ *
+ * Sets the epoch to now if playback has not started. Must not be called
+ * while the player thread runs.
+ *
+ * @return Entries played.
+ */
+size_t bitbang_run(bitbang_t* bb);
+
+/**
+ * @brief Start the player thread; the epoch becomes now.
+ *
+ * The thread plays entries as they arrive and idles while the ring is
+ * empty (busy-polls when pinned, sleeps BITBANG_IDLE_US otherwise).
+ *
+ * @param core_id CPU core for the player, or -1 to leave it unpinned.
+ * @param realtime Nonzero to switch the player to SCHED_FIFO (needs root).
+ * @return 0 on success, -1 on error.
+ */
+int bitbang_start(bitbang_t* bb, int core_id, int realtime);
+
+/**
+ * @brief Stop the player thread. Entries not yet played stay queued.
+ */
+void bitbang_stop(bitbang_t* bb);
+
+/**
+ * @brief Wait until every queued entry has been played.
+ * @param timeout_us Maximum wait in microseconds.
+ * @return 0 when drained, -1 on timeout.
+ */
+int bitbang_wait(bitbang_t* bb, uint64_t timeout_us);
+
+/**
+ * @brief Time since the epoch (0 before playback starts).
+ *
+ * Producers of long streams use it to stay ahead of the player.
+ */
+uint64_t bitbang_elapsed_ns(const bitbang_t* bb);
+
+/** @name Timing Helpers */
+/**@{*/
+
+/**
+ * @brief CLOCK_MONOTONIC in nanoseconds.
+ */
+static inline uint64_t bitbang_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Spin until an absolute CLOCK_MONOTONIC deadline.
+ * @return Time at which the spin ended (>= deadline_ns).
+ */
+static inline uint64_t bitbang_spin_until(uint64_t deadline_ns) {
+    uint64_t now = bitbang_now_ns();
+    while (now < deadline_ns) now = bitbang_now_ns();
+    return now;
+}
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_BITBANG_H */
+
+#ifdef RPI_BITBANG_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** Entries played between tail publications. */
+#define BITBANG_PUBLISH_EVERY 32
+
+/** Longest single sleep, so bitbang_stop() is noticed during long gaps. */
+#define BITBANG_SLEEP_MAX_NS 10000000ull
+
+int bitbang_init(bitbang_t* bb, gpio_ctx_t* gpio, size_t capacity) {
+    if (!bb) return -1;
+    memset(bb, 0, sizeof(*bb));
+
+    if (capacity == 0) capacity = BITBANG_CAPACITY_DEFAULT;
+    size_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+    if (cap < 8) cap = 8;  /* One 64-byte line per array */
+
+    bb->set_mask = aligned_alloc(64, cap * sizeof(uint64_t));
+    bb->clr_mask = aligned_alloc(64, cap * sizeof(uint64_t));
+    bb->t_ns = aligned_alloc(64, cap * sizeof(uint64_t));
+    if (!bb->set_mask || !bb->clr_mask || !bb->t_ns) {
+        fprintf(stderr, "Bitbang Error: Failed to allocate %zu entries\n", cap);
+        bitbang_free(bb);
+        return -1;
+    }
+
+    bb->capacity = cap;
+    bb->gpio = gpio ? gpio : &gpio_ctx_default;
+    bb->core_id = -1;
+    return 0;
+}
+
+void bitbang_free(bitbang_t* bb) {
+    if (!bb) return;
+    bitbang_stop(bb);
+    free(bb->set_mask);
+    free(bb->clr_mask);
+    free(bb->t_ns);
+    bb->set_mask = bb->clr_mask = bb->t_ns = NULL;
+    bb->capacity = 0;
+}
+
+size_t bitbang_space(const bitbang_t* bb) {
+    uint64_t head = __atomic_load_n(&bb->head, __ATOMIC_RELAXED);
+    uint64_t tail = __atomic_load_n(&bb->tail, __ATOMIC_ACQUIRE);
+    return bb->capacity - (size_t)(head - tail);
+}
+
+size_t bitbang_pending(const bitbang_t* bb) {
+    uint64_t tail = __atomic_load_n(&bb->tail, __ATOMIC_ACQUIRE);
+    uint64_t head = __atomic_load_n(&bb->head, __ATOMIC_ACQUIRE);
+    return (size_t)(head - tail);
+}
+
+size_t bitbang_append(bitbang_t* bb, const bitbang_entry_t* entries, size_t count) {
+    if (!bb || !entries || !bb->capacity) return 0;
+
+    uint64_t head = __atomic_load_n(&bb->head, __ATOMIC_RELAXED);
+    size_t space = bitbang_space(bb);
+    size_t n = count < space ? count : space;
+    size_t mask = bb->capacity - 1;
+
+    for (size_t i = 0; i < n; i++) {
+        size_t slot = (size_t)(head + i) & mask;
+        bb->set_mask[slot] = entries[i].set_mask;
+        bb->clr_mask[slot] = entries[i].clr_mask;
+        bb->t_ns[slot] = entries[i].t_ns;
+    }
+    __atomic_store_n(&bb->head, head + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+uint64_t bitbang_elapsed_ns(const bitbang_t* bb) {
+    uint64_t epoch = __atomic_load_n(&bb->epoch_ns, __ATOMIC_ACQUIRE);
+    if (!epoch) return 0;
+    uint64_t now = bitbang_now_ns();
+    return now > epoch ? now - epoch : 0;
+}
+
+/**
+ * Sleep until BITBANG_SPIN_NS before the deadline, then spin. Sleeps are
+ * capped so a stop request ends the wait within BITBANG_SLEEP_MAX_NS.
+ * Returns the time the wait ended, or 0 if playback was stopped.
+ */
+static uint64_t bitbang_wait_until(bitbang_t* bb, uint64_t deadline, int threaded) {
+    uint64_t now = bitbang_now_ns();
+    while (now + BITBANG_SPIN_NS < deadline) {
+        if (threaded && !__atomic_load_n(&bb->running, __ATOMIC_RELAXED)) return 0;
+
+        uint64_t wake = deadline - BITBANG_SPIN_NS;
+        if (wake - now > BITBANG_SLEEP_MAX_NS) wake = now + BITBANG_SLEEP_MAX_NS;
+        struct timespec ts = { (time_t)(wake / 1000000000ull), (long)(wake % 1000000000ull) };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        now = bitbang_now_ns();
+    }
+    while (now < deadline) now = bitbang_now_ns();
+    return now;
+}
+
+/**
+ * Play everything queued at the time of the call. The tail is published
+ * every BITBANG_PUBLISH_EVERY entries rather than per entry, so the
+ * producer's cache line is not pulled over on every edge.
+ */
+static size_t bitbang_play(bitbang_t* bb, int threaded) {
+    uint64_t tail = __atomic_load_n(&bb->tail, __ATOMIC_RELAXED);
+    uint64_t head = __atomic_load_n(&bb->head, __ATOMIC_ACQUIRE);
+    size_t mask = bb->capacity - 1;
+    size_t played = 0;
+
+    while (tail != head) {
+        size_t slot = (size_t)tail & mask;
+        uint64_t deadline = bb->epoch_ns + bb->t_ns[slot];
+        uint64_t now = bitbang_wait_until(bb, deadline, threaded);
+        if (!now) break;
+
+        gpio_ctx_write_mask(bb->gpio, bb->set_mask[slot], bb->clr_mask[slot]);
+
+        uint64_t late = now - deadline;
+        bb->stats.played++;
+        bb->stats.total_late_ns += late;
+        if (late > bb->stats.max_late_ns) bb->stats.max_late_ns = late;
+        if (late > BITBANG_LATE_NS) bb->stats.late++;
+
+        tail++;
+        if (++played % BITBANG_PUBLISH_EVERY == 0) {
+            __atomic_store_n(&bb->tail, tail, __ATOMIC_RELEASE);
+        }
+    }
+    __atomic_store_n(&bb->tail, tail, __ATOMIC_RELEASE);
+    return played;
+}
+
+size_t bitbang_run(bitbang_t* bb) {
+    if (!bb || !bb->capacity || bb->running) return 0;
+    if (!bb->epoch_ns) bb->epoch_ns = bitbang_now_ns();
+    return bitbang_play(bb, 0);
+}
+
+static void* bitbang_thread_func(void* arg) {
+    bitbang_t* bb = (bitbang_t*)arg;
+    if (bb->core_id >= 0) pin_to_core(bb->core_id);
+    if (bb->realtime) set_realtime_priority();
+
+    while (__atomic_load_n(&bb->running, __ATOMIC_RELAXED)) {
+        if (bitbang_play(bb, 1) == 0 && bb->core_id < 0) {
+            usleep(BITBANG_IDLE_US);
+        }
+    }
+    return NULL;
+}
+
+int bitbang_start(bitbang_t* bb, int core_id, int realtime) {
+    if (!bb || !bb->capacity) return -1;
+    if (bb->running) {
+        fprintf(stderr, "Bitbang Error: Player already running\n");
+        return -1;
+    }
+
+    bb->core_id = core_id;
+    bb->realtime = realtime;
+    __atomic_store_n(&bb->epoch_ns, bitbang_now_ns(), __ATOMIC_RELEASE);
+    __atomic_store_n(&bb->running, 1, __ATOMIC_RELEASE);
+
+    if (pthread_create(&bb->thread, NULL, bitbang_thread_func, bb) != 0) {
+        perror("Bitbang Error: Failed to create thread");
+        bb->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void bitbang_stop(bitbang_t* bb) {
+    if (!bb || !bb->running) return;
+    __atomic_store_n(&bb->running, 0, __ATOMIC_RELEASE);
+    pthread_join(bb->thread, NULL);
+}
+
+int bitbang_wait(bitbang_t* bb, uint64_t timeout_us) {
+    uint64_t deadline = bitbang_now_ns() + timeout_us * 1000ull;
+    for (;;) {
+        if (bitbang_pending(bb) == 0) return 0;
+        if (bitbang_now_ns() >= deadline) return -1;
+        usleep(BITBANG_IDLE_US);
+    }
+}
+
+#endif /* RPI_BITBANG_IMPLEMENTATION */
@@ -0,0 +1,191 @@
+/**
+ * @file rpi_debounce.h
+ * @brief Bit-parallel debouncing of all GPIO inputs with vertical counters.
+ *
+ * Single-header library. Define RPI_DEBOUNCE_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * No dependencies: feed it one gpio_read_all() snapshot per tick.
+ *
+ * Every pin has a small counter of consecutive samples that disagree with
+ * its debounced level. The counters are stored bit-sliced ("vertical"):
+ * plane p holds bit p of all 64 counters, so one tick increments, resets
+ * and compares every counter with a handful of 64-bit ALU operations,
+ * whatever the number of inputs. A pin flips once its counter reaches the
+ * stable count of its group; any sample that agrees with the debounced
+ * level resets it.
+ *
+ * Usage:
+ *   debounce_t db;
+ *   debounce_init(&db, gpio_read_all(), 5);        // 5 ticks for every pin
+ *   debounce_set_group(&db, (1ull << 20), 20);     // slower for a reed switch
+ *   for (;;) {                                     // e.g. every 1 ms
+ *       uint64_t changed = debounce_update(&db, gpio_read_all());
+ *       uint64_t pressed = debounce_falling(&db, changed);
+ *   }
+ */
+
+#ifndef RPI_DEBOUNCE_H
+#define RPI_DEBOUNCE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Counter planes: stable counts up to 2^DEBOUNCE_MAX_BITS - 1 ticks. */
+#define DEBOUNCE_MAX_BITS 8
+#define DEBOUNCE_MAX_COUNT ((1 << DEBOUNCE_MAX_BITS) - 1)
+
+/** Pin groups with their own stable count (group 0 holds every other pin). */
+#define DEBOUNCE_MAX_GROUPS 8
+
+/**
+ * @brief Debouncer state for up to 64 inputs.
+ */
+typedef struct {
+    uint64_t state;                          /**< Debounced levels. */
+    uint64_t planes[DEBOUNCE_MAX_BITS];      /**< Bit p of every pin's counter. */
+    uint64_t target[DEBOUNCE_MAX_BITS];      /**< Bit p of every pin's stable count. */
+    int bits;                                /**< Planes in use. */
+    uint64_t group_mask[DEBOUNCE_MAX_GROUPS];
+    int group_count[DEBOUNCE_MAX_GROUPS];
+    int groups;
+} debounce_t;
+
+/**
+ * @brief Reset with every pin in group 0.
+ * @param levels Initial debounced levels (usually the current gpio_read_all()).
+ * @param stable_count Consecutive ticks a new level must hold (1-DEBOUNCE_MAX_COUNT).
+ * @return 0 on success, -1 on an invalid count.
+ */
+int debounce_init(debounce_t* db, uint64_t levels, int stable_count);
+
+/**
+ * @brief Give pins their own stable count.
+ *
+ * Pins leave whatever group they were in; pins already in a group with the
+ * same count join it. Counters restart.
+ *
+ * @return Group index, or -1 on an invalid count or too many groups.
+ */
+int debounce_set_group(debounce_t* db, uint64_t pins, int stable_count);
+
+/**
+ * @brief Stable count of a pin.
+ */
+int debounce_pin_count(const debounce_t* db, int pin);
+
+/**
+ * @brief Feed one snapshot.
+ * @param sample Raw levels (bit n = GPIO n).
+ * @return Pins whose debounced level changed on this tick.
+ */
+static inline uint64_t debounce_update(debounce_t* db, uint64_t sample) {
+    uint64_t delta = sample ^ db->state;
+    uint64_t carry = delta;
+    uint64_t equal = ~0ull;
+
+    /* Count up where the sample disagrees, reset where it agrees */
+    for (int p = 0; p < db->bits; p++) {
+        uint64_t plane = db->planes[p];
+        plane = (plane ^ carry) & delta;
+        carry &= db->planes[p];
+        db->planes[p] = plane;
+        equal &= ~(plane ^ db->target[p]);
+    }
+
+    uint64_t changed = equal & delta;
+    db->state ^= changed;
+    for (int p = 0; p < db->bits; p++) db->planes[p] &= ~changed;
+    return changed;
+}
+
+/**
+ * @brief Pins in @p changed that went high.
+ */
+static inline uint64_t debounce_rising(const debounce_t* db, uint64_t changed) {
+    return changed & db->state;
+}
+
+/**
+ * @brief Pins in @p changed that went low (pressed, for pull-up buttons).
+ */
+static inline uint64_t debounce_falling(const debounce_t* db, uint64_t changed) {
+    return changed & ~db->state;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_DEBOUNCE_H */
+
+#ifdef RPI_DEBOUNCE_IMPLEMENTATION
+
+#include <string.h>
+
+/* Rebuild the bit-sliced target counts and plane count from the groups */
+static void debounce_rebuild(debounce_t* db) {
+    int max_count = 1;
+    memset(db->target, 0, sizeof(db->target));
+    memset(db->planes, 0, sizeof(db->planes));
+
+    for (int g = 0; g < db->groups; g++) {
+        if (!db->group_mask[g]) continue;
+        if (db->group_count[g] > max_count) max_count = db->group_count[g];
+        for (int p = 0; p < DEBOUNCE_MAX_BITS; p++) {
+            if (db->group_count[g] & (1 << p)) db->target[p] |= db->group_mask[g];
+        }
+    }
+
+    db->bits = 0;
+    while ((1 << db->bits) <= max_count) db->bits++;
+}
+
+int debounce_init(debounce_t* db, uint64_t levels, int stable_count) {
+    if (!db || stable_count < 1 || stable_count > DEBOUNCE_MAX_COUNT) return -1;
+    memset(db, 0, sizeof(*db));
+    db->state = levels;
+    db->group_mask[0] = ~0ull;
+    db->group_count[0] = stable_count;
+    db->groups = 1;
+    debounce_rebuild(db);
+    return 0;
+}
+
+int debounce_set_group(debounce_t* db, uint64_t pins, int stable_count) {
+    if (!db || stable_count < 1 || stable_count > DEBOUNCE_MAX_COUNT) return -1;
+
+    int slot = -1;
+    for (int g = 0; g < db->groups; g++) {
+        if (db->group_count[g] == stable_count) slot = g;
+    }
+    if (slot < 0) {
+        /* Reuse a group that has lost all its pins */
+        for (int g = 1; g < db->groups; g++) {
+            if (!(db->group_mask[g] & ~pins)) { slot = g; break; }
+        }
+    }
+    if (slot < 0) {
+        if (db->groups == DEBOUNCE_MAX_GROUPS) return -1;
+        slot = db->groups++;
+    }
+
+    for (int g = 0; g < db->groups; g++) db->group_mask[g] &= ~pins;
+    db->group_mask[slot] |= pins;
+    db->group_count[slot] = stable_count;
+    debounce_rebuild(db);
+    return slot;
+}
+
+int debounce_pin_count(const debounce_t* db, int pin) {
+    if (!db || pin < 0 || pin > 63) return 0;
+    for (int g = 0; g < db->groups; g++) {
+        if (db->group_mask[g] & (1ull << pin)) return db->group_count[g];
+    }
+    return 0;
+}
+
+#endif /* RPI_DEBOUNCE_IMPLEMENTATION */
@@ -0,0 +1,705 @@
+/**
+ * @file rpi_dma.h
+ * @brief DMA control blocks, DMA-visible memory and a host DMA simulator.
+ *
+ * Included by rpi_gpio.h; the implementation is compiled together with
+ * RPI_GPIO_IMPLEMENTATION, so no extra define is needed.
+ *
+ * DMA engines see bus addresses, not CPU addresses. dma_mem_alloc() returns
+ * memory with both: on Raspberry Pi it is allocated through the VideoCore
+ * mailbox (/dev/vcio) and mapped through rpi_periph.h; on other hosts it is
+ * plain RAM with a made-up bus address.
+ *
+ * dma_sim_t models the DMA block in virtual time: it executes control-block
+ * chains from simulated channel registers against dma_mem_alloc() memory and
+ * simulated peripherals (dma_sim_dev_t), including DREQ pacing. Drivers use
+ * the same dma_chan_t calls on hardware and in the simulator, so buffer
+ * management can be tested on the host.
+ */
+
+#ifndef RPI_DMA_H
+#define RPI_DMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @name Channels */
+/**@{*/
+#define DMA_CHANNEL_COUNT   15     /**< Channels 0-14 share the PERIPH_DMA block. */
+#define DMA_CHANNEL_DEFAULT 10     /**< Not used by the stock kernel. */
+#define DMA_CHAN_WORDS      64     /**< Register stride between channels (0x100 bytes). */
+#define DMA_ENABLE          1020   /**< Global enable register (0xFF0). */
+/**@}*/
+
+/** @name Channel Register Offsets */
+/**@{*/
+#define DMA_CS        0
+#define DMA_CONBLK_AD 1
+#define DMA_TI        2
+#define DMA_SOURCE_AD 3
+#define DMA_DEST_AD   4
+#define DMA_TXFR_LEN  5
+#define DMA_STRIDE    6
+#define DMA_NEXTCONBK 7
+#define DMA_DEBUG     8
+/**@}*/
+
+/** @name CS Register Bits */
+/**@{*/
+#define DMA_CS_ACTIVE        (1u << 0)
+#define DMA_CS_END           (1u << 1)
+#define DMA_CS_INT           (1u << 2)
+#define DMA_CS_ERROR         (1u << 8)
+#define DMA_CS_PRIORITY(x)   ((uint32_t)(x) << 16)
+#define DMA_CS_PANIC(x)      ((uint32_t)(x) << 20)
+#define DMA_CS_WAIT_WRITES   (1u << 28)
+#define DMA_CS_ABORT         (1u << 30)
+#define DMA_CS_RESET         (1u << 31)
+/**@}*/
+
+/** @name Transfer Information Bits */
+/**@{*/
+#define DMA_TI_INTEN          (1u << 0)
+#define DMA_TI_WAIT_RESP      (1u << 3)
+#define DMA_TI_DEST_INC       (1u << 4)
+#define DMA_TI_DEST_DREQ      (1u << 6)
+#define DMA_TI_DEST_IGNORE    (1u << 7)
+#define DMA_TI_SRC_INC        (1u << 8)
+#define DMA_TI_SRC_DREQ       (1u << 10)
+#define DMA_TI_SRC_IGNORE     (1u << 11)
+#define DMA_TI_PERMAP(x)      ((uint32_t)(x) << 16)
+#define DMA_TI_NO_WIDE_BURSTS (1u << 26)
+/**@}*/
+
+/** @name DREQ Peripheral Numbers */
+/**@{*/
+#define DMA_DREQ_NONE   0
+#define DMA_DREQ_PCM_TX 2
+#define DMA_DREQ_PWM    5
+#define DMA_DREQ_SPI_TX 6
+#define DMA_DREQ_SPI_RX 7
+/**@}*/
+
+/**
+ * @brief DMA control block (must be 32-byte aligned in DMA memory).
+ */
+typedef struct {
+    _Alignas(32) uint32_t ti; /**< Transfer information (DMA_TI_*). */
+    uint32_t source_ad;       /**< Source bus address. */
+    uint32_t dest_ad;         /**< Destination bus address. */
+    uint32_t txfr_len;        /**< Bytes to transfer. */
+    uint32_t stride;          /**< 2D stride (unused by this toolkit). */
+    uint32_t nextconbk;       /**< Bus address of the next block, 0 to stop. */
+    uint32_t reserved[2];
+} dma_cb_t;
+
+/**
+ * @brief Memory visible to both the CPU and the DMA engine.
+ */
+typedef struct {
+    void* virt;               /**< CPU address. */
+    uint32_t bus;             /**< Bus address for control blocks. */
+    size_t size;              /**< Size in bytes (page multiple). */
+    uint32_t handle;          /**< Mailbox handle (0 on host). */
+} dma_mem_t;
+
+/**
+ * @brief One DMA channel.
+ */
+typedef struct {
+    volatile uint32_t* block; /**< PERIPH_DMA register block. */
+    volatile uint32_t* regs;  /**< This channel's registers. */
+    int channel;              /**< Channel number (0-14). */
+    int mapped;               /**< 1 if the block comes from the rpi_periph.h registry. */
+} dma_chan_t;
+
+/** @name Memory */
+/**@{*/
+
+/**
+ * @brief Allocate zeroed DMA memory.
+ * @param mem Output descriptor.
+ * @param size Bytes (rounded up to whole pages).
+ * @return 0 on success, -1 on error.
+ */
+int dma_mem_alloc(dma_mem_t* mem, size_t size);
+
+/**
+ * @brief Free memory from dma_mem_alloc().
+ */
+void dma_mem_free(dma_mem_t* mem);
+
+/**
+ * @brief Bus address of a CPU pointer inside mem.
+ */
+uint32_t dma_mem_bus(const dma_mem_t* mem, const void* ptr);
+
+/**
+ * @brief CPU address of a bus address from any live dma_mem_alloc() block.
+ * @return Pointer, NULL if the address is not DMA memory.
+ */
+void* dma_mem_virt(uint32_t bus);
+
+/**
+ * @brief Bus address of a peripheral register (word index reg in block).
+ */
+uint32_t dma_periph_bus(periph_block_t block, uint32_t reg);
+/**@}*/
+
+/** @name Channels */
+/**@{*/
+
+/**
+ * @brief Map the DMA block (rpi_periph.h) and enable a channel.
+ * @return 0 on success, -1 on error.
+ */
+int dma_chan_open(dma_chan_t* ch, int channel);
+
+/**
+ * @brief Use an existing DMA register block (e.g. dma_sim_t.regs).
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int dma_chan_attach(dma_chan_t* ch, volatile uint32_t* block, int channel);
+
+/**
+ * @brief Reset the channel and start the chain at cb_bus.
+ */
+void dma_chan_start(dma_chan_t* ch, uint32_t cb_bus);
+
+/**
+ * @brief Abort any transfer and reset the channel.
+ */
+void dma_chan_stop(dma_chan_t* ch);
+
+/**
+ * @brief 1 while the channel is running a chain.
+ */
+int dma_chan_active(const dma_chan_t* ch);
+
+/**
+ * @brief Bus address of the control block being executed (0 when idle).
+ */
+uint32_t dma_chan_cb(const dma_chan_t* ch);
+
+/**
+ * @brief Stop the channel and release the block taken by dma_chan_open().
+ */
+void dma_chan_close(dma_chan_t* ch);
+/**@}*/
+
+/** @name Simulator */
+/**@{*/
+
+/** Maximum peripherals attached to one simulator. */
+#define DMA_SIM_MAX_DEVS 4
+
+/** Virtual bus time per 32-bit transfer. */
+#define DMA_SIM_WORD_NS 40
+
+/**
+ * @brief Simulated peripheral reachable by control blocks.
+ *
+ * Register accesses at dma_periph_bus(block, reg) go to the hooks, or to
+ * regs when a hook is NULL.
+ */
+typedef struct {
+    periph_block_t block;       /**< Bus window the device answers. */
+    volatile uint32_t* regs;    /**< Register file (PERIPH_BLOCK_SIZE bytes). */
+    uint32_t dreqs;             /**< Bit n set if the device drives DREQ n. */
+    int (*dreq)(void* user, int dreq);                           /**< 1 while requesting. */
+    void (*write)(void* user, uint32_t reg, uint32_t value);     /**< DMA register write. */
+    uint32_t (*read)(void* user, uint32_t reg);                  /**< DMA register read. */
+    uint64_t (*advance)(void* user, uint64_t now_ns);            /**< Run to now, return next event. */
+    void* user;
+} dma_sim_dev_t;
+
+/**
+ * @brief Simulated DMA block and virtual clock.
+ */
+typedef struct {
+    uint32_t regs[PERIPH_BLOCK_SIZE / 4];       /**< DMA registers; attach channels here. */
+    dma_sim_dev_t devs[DMA_SIM_MAX_DEVS];
+    int num_devs;
+    uint32_t cb_seen[DMA_CHANNEL_COUNT];        /**< CONBLK_AD as last loaded by the simulator. */
+    uint64_t now_ns;                            /**< Virtual time. */
+    uint32_t word_ns;                           /**< Bus time per word (DMA_SIM_WORD_NS). */
+    uint64_t words;                             /**< Words transferred. */
+    uint64_t cbs;                               /**< Control blocks completed. */
+    uint64_t errors;                            /**< Transfers to unmapped addresses. */
+} dma_sim_t;
+
+/**
+ * @brief Reset a simulator (no devices, time 0).
+ */
+void dma_sim_init(dma_sim_t* sim);
+
+/**
+ * @brief Attach a simulated peripheral.
+ * @return 0 on success, -1 if full.
+ */
+int dma_sim_add_device(dma_sim_t* sim, const dma_sim_dev_t* dev);
+
+/**
+ * @brief Run all active channels and devices for duration_ns of virtual time.
+ * @return Words transferred.
+ */
+uint64_t dma_sim_run(dma_sim_t* sim, uint64_t duration_ns);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_DMA_H */
+
+#if defined(RPI_DMA_IMPLEMENTATION) && !defined(RPI_DMA_IMPLEMENTED)
+#define RPI_DMA_IMPLEMENTED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#ifdef RPI_GPIO_PLATFORM_RPI
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#endif
+
+/*
+ * Registry of live allocations, so the simulator (and dma_mem_virt()) can
+ * turn bus addresses back into CPU pointers.
+ */
+#define DMA_MEM_MAX 32
+#define DMA_PAGE_SIZE 4096
+
+static dma_mem_t dma_mems[DMA_MEM_MAX];
+static atomic_flag dma_mem_lock = ATOMIC_FLAG_INIT;
+
+static void dma_mem_acquire(void) {
+    while (atomic_flag_test_and_set_explicit(&dma_mem_lock, memory_order_acquire)) {}
+}
+
+static void dma_mem_release(void) {
+    atomic_flag_clear_explicit(&dma_mem_lock, memory_order_release);
+}
+
+static int dma_mem_register(const dma_mem_t* mem) {
+    dma_mem_acquire();
+    for (int i = 0; i < DMA_MEM_MAX; i++) {
+        if (!dma_mems[i].virt) {
+            dma_mems[i] = *mem;
+            dma_mem_release();
+            return 0;
+        }
+    }
+    dma_mem_release();
+    fprintf(stderr, "DMA Error: more than %d live allocations\n", DMA_MEM_MAX);
+    return -1;
+}
+
+static void dma_mem_unregister(const dma_mem_t* mem) {
+    dma_mem_acquire();
+    for (int i = 0; i < DMA_MEM_MAX; i++) {
+        if (dma_mems[i].virt == mem->virt) {
+            memset(&dma_mems[i], 0, sizeof(dma_mems[i]));
+            break;
+        }
+    }
+    dma_mem_release();
+}
+
+void* dma_mem_virt(uint32_t bus) {
+    void* ptr = NULL;
+    dma_mem_acquire();
+    for (int i = 0; i < DMA_MEM_MAX; i++) {
+        if (dma_mems[i].virt && bus >= dma_mems[i].bus && bus - dma_mems[i].bus < dma_mems[i].size) {
+            ptr = (uint8_t*)dma_mems[i].virt + (bus - dma_mems[i].bus);
+            break;
+        }
+    }
+    dma_mem_release();
+    return ptr;
+}
+
+uint32_t dma_mem_bus(const dma_mem_t* mem, const void* ptr) {
+    return mem->bus + (uint32_t)((const uint8_t*)ptr - (const uint8_t*)mem->virt);
+}
+
+uint32_t dma_periph_bus(periph_block_t block, uint32_t reg) {
+    return PERIPH_BUS_BASE + periph_offset(block) + reg * 4;
+}
+
+#ifdef RPI_GPIO_PLATFORM_RPI
+
+/*
+ * VideoCore mailbox property interface. Memory is allocated direct and
+ * coherent (uncached 0xC0000000 alias), so CPU writes are visible to DMA
+ * without cache maintenance.
+ */
+#define DMA_MBOX_IOCTL     _IOWR(100, 0, char*)
+#define DMA_MBOX_ALLOC     0x3000c
+#define DMA_MBOX_LOCK      0x3000d
+#define DMA_MBOX_UNLOCK    0x3000e
+#define DMA_MBOX_RELEASE   0x3000f
+#define DMA_MEM_FLAGS      0xC     /* MEM_FLAG_DIRECT | MEM_FLAG_COHERENT */
+#define DMA_BUS_TO_PHYS(x) ((x) & ~0xC0000000u)
+
+static uint32_t dma_mbox_call(uint32_t tag, uint32_t a, uint32_t b, uint32_t c, int nargs) {
+    int fd = open("/dev/vcio", O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        perror("Can't open /dev/vcio");
+        return 0;
+    }
+
+    _Alignas(16) uint32_t msg[9];
+    msg[0] = sizeof(msg);
+    msg[1] = 0;           /* Request */
+    msg[2] = tag;
+    msg[3] = 12;          /* Value buffer size */
+    msg[4] = nargs * 4;   /* Request size */
+    msg[5] = a;
+    msg[6] = b;
+    msg[7] = c;
+    msg[8] = 0;           /* End tag */
+
+    int ret = ioctl(fd, DMA_MBOX_IOCTL, msg);
+    close(fd);
+    if (ret < 0) {
+        perror("Mailbox ioctl failed");
+        return 0;
+    }
+    return msg[5];
+}
+
+int dma_mem_alloc(dma_mem_t* mem, size_t size) {
+    if (!mem || size == 0) return -1;
+    size = (size + DMA_PAGE_SIZE - 1) & ~(size_t)(DMA_PAGE_SIZE - 1);
+    memset(mem, 0, sizeof(*mem));
+
+    uint32_t handle = dma_mbox_call(DMA_MBOX_ALLOC, (uint32_t)size, DMA_PAGE_SIZE, DMA_MEM_FLAGS, 3);
+    if (!handle) return -1;
+
+    uint32_t bus = dma_mbox_call(DMA_MBOX_LOCK, handle, 0, 0, 1);
+    if (!bus) {
+        dma_mbox_call(DMA_MBOX_RELEASE, handle, 0, 0, 1);
+        return -1;
+    }
+
+    void* virt = periph_map_phys(DMA_BUS_TO_PHYS(bus), size);
+    if (!virt) {
+        dma_mbox_call(DMA_MBOX_UNLOCK, handle, 0, 0, 1);
+        dma_mbox_call(DMA_MBOX_RELEASE, handle, 0, 0, 1);
+        return -1;
+    }
+
+    mem->virt = virt;
+    mem->bus = bus;
+    mem->size = size;
+    mem->handle = handle;
+    memset(virt, 0, size);
+    if (dma_mem_register(mem) != 0) {
+        dma_mem_free(mem);
+        return -1;
+    }
+    return 0;
+}
+
+void dma_mem_free(dma_mem_t* mem) {
+    if (!mem || !mem->virt) return;
+    dma_mem_unregister(mem);
+    periph_unmap_phys(mem->virt, mem->size);
+    dma_mbox_call(DMA_MBOX_UNLOCK, mem->handle, 0, 0, 1);
+    dma_mbox_call(DMA_MBOX_RELEASE, mem->handle, 0, 0, 1);
+    memset(mem, 0, sizeof(*mem));
+}
+
+#else
+
+/* Host: RAM with bus addresses handed out from the uncached alias range */
+#define DMA_SIM_BUS_BASE 0xC0000000u
+static uint32_t dma_sim_next_bus = DMA_SIM_BUS_BASE;
+
+int dma_mem_alloc(dma_mem_t* mem, size_t size) {
+    if (!mem || size == 0) return -1;
+    size = (size + DMA_PAGE_SIZE - 1) & ~(size_t)(DMA_PAGE_SIZE - 1);
+    memset(mem, 0, sizeof(*mem));
+
+    void* virt = aligned_alloc(DMA_PAGE_SIZE, size);
+    if (!virt) return -1;
+    memset(virt, 0, size);
+
+    dma_mem_acquire();
+    mem->bus = dma_sim_next_bus;
+    dma_sim_next_bus += (uint32_t)size;
+    dma_mem_release();
+
+    mem->virt = virt;
+    mem->size = size;
+    if (dma_mem_register(mem) != 0) {
+        free(virt);
+        memset(mem, 0, sizeof(*mem));
+        return -1;
+    }
+    return 0;
+}
+
+void dma_mem_free(dma_mem_t* mem) {
+    if (!mem || !mem->virt) return;
+    dma_mem_unregister(mem);
+    free(mem->virt);
+    memset(mem, 0, sizeof(*mem));
+}
+
+#endif /* RPI_GPIO_PLATFORM_RPI */
+
+/* ============================================================================
+ * CHANNELS
+ * ============================================================================ */
+
+int dma_chan_attach(dma_chan_t* ch, volatile uint32_t* block, int channel) {
+    if (!ch || !block || channel < 0 || channel >= DMA_CHANNEL_COUNT) return -1;
+    ch->block = block;
+    ch->regs = block + channel * DMA_CHAN_WORDS;
+    ch->channel = channel;
+    ch->mapped = 0;
+
+    block[DMA_ENABLE] |= 1u << channel;
+    ch->regs[DMA_CS] = DMA_CS_RESET;
+    ch->regs[DMA_CONBLK_AD] = 0;
+    return 0;
+}
+
+int dma_chan_open(dma_chan_t* ch, int channel) {
+    if (!ch || channel < 0 || channel >= DMA_CHANNEL_COUNT) return -1;
+
+    volatile uint32_t* block = periph_map(PERIPH_DMA);
+    if (!block) return -1;
+
+    dma_chan_attach(ch, block, channel);
+    ch->mapped = 1;
+    return 0;
+}
+
+void dma_chan_start(dma_chan_t* ch, uint32_t cb_bus) {
+    if (!ch || !ch->regs) return;
+    volatile uint32_t* r = ch->regs;
+
+    r[DMA_CS] = DMA_CS_RESET;
+    usleep(10);
+    r[DMA_CS] = DMA_CS_INT | DMA_CS_END;   /* Write-1-to-clear */
+    r[DMA_DEBUG] = 7;                      /* Clear error flags */
+    r[DMA_CONBLK_AD] = cb_bus;
+    r[DMA_CS] = DMA_CS_WAIT_WRITES | DMA_CS_PANIC(15) | DMA_CS_PRIORITY(15) | DMA_CS_ACTIVE;
+}
+
+void dma_chan_stop(dma_chan_t* ch) {
+    if (!ch || !ch->regs) return;
+    volatile uint32_t* r = ch->regs;
+
+    r[DMA_CS] = DMA_CS_ABORT;
+    usleep(10);
+    r[DMA_CS] = DMA_CS_RESET;
+    r[DMA_CONBLK_AD] = 0;
+}
+
+int dma_chan_active(const dma_chan_t* ch) {
+    return ch && ch->regs && (ch->regs[DMA_CS] & DMA_CS_ACTIVE);
+}
+
+uint32_t dma_chan_cb(const dma_chan_t* ch) {
+    return (ch && ch->regs) ? ch->regs[DMA_CONBLK_AD] : 0;
+}
+
+void dma_chan_close(dma_chan_t* ch) {
+    if (!ch || !ch->regs) return;
+    dma_chan_stop(ch);
+    if (ch->mapped) {
+        periph_unmap(PERIPH_DMA);
+        ch->mapped = 0;
+    }
+    ch->block = NULL;
+    ch->regs = NULL;
+}
+
+/* ============================================================================
+ * SIMULATOR
+ * ============================================================================ */
+
+void dma_sim_init(dma_sim_t* sim) {
+    memset(sim, 0, sizeof(*sim));
+    sim->word_ns = DMA_SIM_WORD_NS;
+}
+
+int dma_sim_add_device(dma_sim_t* sim, const dma_sim_dev_t* dev) {
+    if (!sim || !dev || sim->num_devs >= DMA_SIM_MAX_DEVS) return -1;
+    sim->devs[sim->num_devs++] = *dev;
+    return 0;
+}
+
+/** Resolve a peripheral bus address to a device and register index. */
+static dma_sim_dev_t* dma_sim_find_dev(dma_sim_t* sim, uint32_t bus, uint32_t* reg) {
+    if (bus < PERIPH_BUS_BASE || bus - PERIPH_BUS_BASE >= 0x01000000u) return NULL;
+    uint32_t off = bus - PERIPH_BUS_BASE;
+    for (int i = 0; i < sim->num_devs; i++) {
+        uint32_t base = periph_offset(sim->devs[i].block);
+        if (off >= base && off - base < PERIPH_BLOCK_SIZE) {
+            *reg = (off - base) / 4;
+            return &sim->devs[i];
+        }
+    }
+    return NULL;
+}
+
+static int dma_sim_load(dma_sim_t* sim, uint32_t bus, uint32_t* value) {
+    uint32_t reg;
+    dma_sim_dev_t* dev = dma_sim_find_dev(sim, bus, &reg);
+    if (dev) {
+        *value = dev->read ? dev->read(dev->user, reg) : dev->regs[reg];
+        return 0;
+    }
+    uint32_t* p = (uint32_t*)dma_mem_virt(bus);
+    if (!p) return -1;
+    *value = *p;
+    return 0;
+}
+
+static int dma_sim_store(dma_sim_t* sim, uint32_t bus, uint32_t value) {
+    uint32_t reg;
+    dma_sim_dev_t* dev = dma_sim_find_dev(sim, bus, &reg);
+    if (dev) {
+        if (dev->write) dev->write(dev->user, reg, value);
+        else dev->regs[reg] = value;
+        return 0;
+    }
+    uint32_t* p = (uint32_t*)dma_mem_virt(bus);
+    if (!p) return -1;
+    *p = value;
+    return 0;
+}
+
+static void dma_sim_fail(dma_sim_t* sim, uint32_t* r) {
+    r[DMA_CS] = (r[DMA_CS] & ~DMA_CS_ACTIVE) | DMA_CS_ERROR;
+    sim->errors++;
+}
+
+/** Copy the control block at CONBLK_AD into the channel registers. */
+static int dma_sim_fetch(dma_sim_t* sim, int c, uint32_t* r) {
+    uint32_t cb_bus = r[DMA_CONBLK_AD];
+    sim->cb_seen[c] = cb_bus;
+    if (cb_bus == 0) {
+        r[DMA_CS] = (r[DMA_CS] & ~DMA_CS_ACTIVE) | DMA_CS_END;
+        r[DMA_TXFR_LEN] = 0;
+        return 0;
+    }
+
+    const dma_cb_t* cb = (const dma_cb_t*)dma_mem_virt(cb_bus);
+    if (!cb) {
+        dma_sim_fail(sim, r);
+        return 0;
+    }
+    r[DMA_TI] = cb->ti;
+    r[DMA_SOURCE_AD] = cb->source_ad;
+    r[DMA_DEST_AD] = cb->dest_ad;
+    r[DMA_TXFR_LEN] = cb->txfr_len;
+    r[DMA_STRIDE] = cb->stride;
+    r[DMA_NEXTCONBK] = cb->nextconbk;
+    return 1;
+}
+
+/** Move one word on channel c; returns 1 if the channel made progress. */
+static int dma_sim_step(dma_sim_t* sim, int c) {
+    uint32_t* r = sim->regs + c * DMA_CHAN_WORDS;
+    if (!(sim->regs[DMA_ENABLE] & (1u << c)) || !(r[DMA_CS] & DMA_CS_ACTIVE)) return 0;
+
+    /*
+     * (Re)start: dma_chan_start() clears the DEBUG error flags, which the
+     * simulator never sets, and CONBLK_AD differs from the last fetch.
+     */
+    if ((r[DMA_DEBUG] & 7) || r[DMA_CONBLK_AD] != sim->cb_seen[c]) {
+        r[DMA_DEBUG] = 0;
+        if (!dma_sim_fetch(sim, c, r)) return 1;
+    }
+
+    /* Zero-length blocks complete immediately */
+    while (r[DMA_TXFR_LEN] == 0) {
+        sim->cbs++;
+        if (r[DMA_TI] & DMA_TI_INTEN) r[DMA_CS] |= DMA_CS_INT;
+        r[DMA_CONBLK_AD] = r[DMA_NEXTCONBK];
+        if (!dma_sim_fetch(sim, c, r)) return 1;
+    }
+
+    uint32_t ti = r[DMA_TI];
+    int permap = (int)((ti >> 16) & 0x1F);
+    if (permap && (ti & (DMA_TI_DEST_DREQ | DMA_TI_SRC_DREQ))) {
+        dma_sim_dev_t* dev = NULL;
+        for (int i = 0; i < sim->num_devs; i++) {
+            if (sim->devs[i].dreqs & (1u << permap)) dev = &sim->devs[i];
+        }
+        if (!dev || !dev->dreq || !dev->dreq(dev->user, permap)) return 0;  /* Paced */
+    }
+
+    uint32_t value = 0;
+    if (!(ti & DMA_TI_SRC_IGNORE) && dma_sim_load(sim, r[DMA_SOURCE_AD], &value) != 0) {
+        dma_sim_fail(sim, r);
+        return 1;
+    }
+    if (!(ti & DMA_TI_DEST_IGNORE) && dma_sim_store(sim, r[DMA_DEST_AD], value) != 0) {
+        dma_sim_fail(sim, r);
+        return 1;
+    }
+    if (ti & DMA_TI_SRC_INC) r[DMA_SOURCE_AD] += 4;
+    if (ti & DMA_TI_DEST_INC) r[DMA_DEST_AD] += 4;
+    r[DMA_TXFR_LEN] = r[DMA_TXFR_LEN] > 4 ? r[DMA_TXFR_LEN] - 4 : 0;
+    sim->words++;
+
+    if (r[DMA_TXFR_LEN] == 0) {
+        sim->cbs++;
+        if (ti & DMA_TI_INTEN) r[DMA_CS] |= DMA_CS_INT;
+        r[DMA_CONBLK_AD] = r[DMA_NEXTCONBK];
+        dma_sim_fetch(sim, c, r);
+    }
+    return 1;
+}
+
+/** Run devices up to now; returns the earliest next device event. */
+static uint64_t dma_sim_advance(dma_sim_t* sim) {
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < sim->num_devs; i++) {
+        if (!sim->devs[i].advance) continue;
+        uint64_t t = sim->devs[i].advance(sim->devs[i].user, sim->now_ns);
+        if (t < next) next = t;
+    }
+    return next;
+}
+
+uint64_t dma_sim_run(dma_sim_t* sim, uint64_t duration_ns) {
+    uint64_t end = sim->now_ns + duration_ns;
+    uint64_t start_words = sim->words;
+
+    while (sim->now_ns < end) {
+        uint64_t next = dma_sim_advance(sim);
+
+        int progressed = 0;
+        for (int c = 0; c < DMA_CHANNEL_COUNT; c++) {
+            progressed |= dma_sim_step(sim, c);
+        }
+
+        if (progressed) {
+            sim->now_ns += sim->word_ns;
+        } else if (next <= sim->now_ns) {
+            sim->now_ns++;
+        } else {
+            sim->now_ns = next < end ? next : end;  /* Idle until a device changes state */
+        }
+    }
+    if (sim->now_ns > end) sim->now_ns = end;
+    dma_sim_advance(sim);
+    return sim->words - start_words;
+}
+
+#endif /* RPI_DMA_IMPLEMENTATION */
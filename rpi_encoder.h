@@ -0,0 +1,297 @@
+/**
+ * @file rpi_encoder.h
+ * @brief Multi-channel quadrature encoder decoding.
+ *
+ * Single-header library. Define RPI_ENCODER_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h, rpi_realtime.h and pthread (-pthread linker flag).
+ *
+ * Encoders are decoded together from one level snapshot: each sample is a
+ * single gpio_read_all() (two GPLEV loads), and every encoder looks up
+ * its (previous AB, current AB) pair in a 16-entry transition table. All
+ * four edges count (x4 decoding). A transition that skips a state (both
+ * lines changed between samples) cannot be decoded and is counted as an
+ * error instead; errors mean the sample rate is too low for the shaft
+ * speed.
+ *
+ * Samples come from encoder_poll()/encoder_update() in your own loop, from
+ * a pinned sampler thread (encoder_start()), or from edge events
+ * (encoder_edge(), e.g. fed from rpi_gpio_event.h). Positions (64-bit),
+ * velocities and error counts are written with atomic stores, so other
+ * threads read them without locks.
+ */
+
+#ifndef RPI_ENCODER_H
+#define RPI_ENCODER_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Encoders per set. */
+#define ENCODER_MAX 16
+
+/** Default velocity window. */
+#define ENCODER_WINDOW_NS_DEFAULT 10000000ull
+
+/**
+ * @brief One encoder.
+ */
+typedef struct {
+    int pin_a;
+    int pin_b;
+    int64_t position;          /**< Counts (x4); read with encoder_position(). */
+    double velocity;           /**< Counts per second over the last window. */
+    uint64_t errors;           /**< Undecodable transitions. */
+    uint8_t state;             /**< Last AB state (A = bit 1). */
+    int64_t window_pos;        /**< Position at the start of the velocity window. */
+} encoder_t;
+
+/**
+ * @brief Encoders decoded from the same GPIO context.
+ */
+typedef struct {
+    encoder_t enc[ENCODER_MAX];
+    int count;
+    uint64_t pin_mask;         /**< A and B pins of every encoder. */
+    uint64_t levels;           /**< Last decoded levels. */
+    int primed;                /**< Set once the first sample has been taken. */
+    uint64_t window_ns;        /**< Velocity window. */
+    uint64_t window_start_ns;  /**< Start of the current window (shared by all encoders). */
+    uint64_t samples;          /**< Snapshots decoded (written by the decoder). */
+    gpio_ctx_t* gpio;
+    pthread_t thread;
+    int running;
+    int core_id;
+} encoder_set_t;
+
+/**
+ * @brief Initialize an empty set.
+ * @param gpio GPIO context to sample (NULL for gpio_ctx_default).
+ * @param window_ns Velocity averaging window (0 for ENCODER_WINDOW_NS_DEFAULT).
+ * @return 0 on success, -1 on error.
+ */
+int encoder_set_init(encoder_set_t* set, gpio_ctx_t* gpio, uint64_t window_ns);
+
+/**
+ * @brief Add an encoder. Pins should be inputs (with pull-ups if open collector).
+ * @return Encoder index, or -1 on invalid pins or a full set.
+ */
+int encoder_add(encoder_set_t* set, int pin_a, int pin_b);
+
+/**
+ * @brief Decode one snapshot.
+ *
+ * The first snapshot only records the starting states. When none of the
+ * encoder pins changed, only the velocity window is checked. Velocities
+ * are updated when a window closes, so with encoder_edge() alone they
+ * hold their last value while the shaft stands still.
+ *
+ * @param levels gpio_read_all()-style levels.
+ * @param t_ns CLOCK_MONOTONIC time of the snapshot (for velocity).
+ */
+void encoder_update(encoder_set_t* set, uint64_t levels, uint64_t t_ns);
+
+/**
+ * @brief Read the context and decode (one encoder_update()).
+ */
+void encoder_poll(encoder_set_t* set);
+
+/**
+ * @brief Apply one edge event (pin level after the edge, event timestamp).
+ *
+ * Call encoder_poll() once before the first event so the starting levels
+ * of both lines are known.
+ */
+void encoder_edge(encoder_set_t* set, int pin, int level, uint64_t t_ns);
+
+/**
+ * @brief Start a sampler thread that polls continuously.
+ * @param core_id CPU core (busy-polls; use an isolated one), or -1.
+ * @return 0 on success, -1 on error.
+ */
+int encoder_start(encoder_set_t* set, int core_id);
+
+/**
+ * @brief Stop the sampler thread.
+ */
+void encoder_stop(encoder_set_t* set);
+
+/** @name Lock-free Readers */
+/**@{*/
+int64_t encoder_position(const encoder_set_t* set, int index);
+double encoder_velocity(const encoder_set_t* set, int index);
+uint64_t encoder_errors(const encoder_set_t* set, int index);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_ENCODER_H */
+
+#ifdef RPI_ENCODER_IMPLEMENTATION
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/** Marks an undecodable transition in encoder_table. */
+#define ENCODER_INVALID 2
+
+/**
+ * Indexed by (previous AB << 2) | current AB. Forward is
+ * 00 -> 01 -> 11 -> 10 -> 00 (B leads A); 0 <-> 3 and 1 <-> 2 skip a state.
+ */
+static const int8_t encoder_table[16] = {
+     0, +1, -1, ENCODER_INVALID,
+    -1,  0, ENCODER_INVALID, +1,
+    +1, ENCODER_INVALID,  0, -1,
+    ENCODER_INVALID, -1, +1,  0,
+};
+
+static uint64_t encoder_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint8_t encoder_ab(const encoder_t* e, uint64_t levels) {
+    return (uint8_t)((((levels >> e->pin_a) & 1) << 1) | ((levels >> e->pin_b) & 1));
+}
+
+int encoder_set_init(encoder_set_t* set, gpio_ctx_t* gpio, uint64_t window_ns) {
+    if (!set) return -1;
+    memset(set, 0, sizeof(*set));
+    set->gpio = gpio ? gpio : &gpio_ctx_default;
+    set->window_ns = window_ns ? window_ns : ENCODER_WINDOW_NS_DEFAULT;
+    set->core_id = -1;
+    return 0;
+}
+
+int encoder_add(encoder_set_t* set, int pin_a, int pin_b) {
+    if (!set || !GPIO_VALID_PIN(pin_a) || !GPIO_VALID_PIN(pin_b) || pin_a == pin_b) return -1;
+    if (set->count == ENCODER_MAX || set->running) return -1;
+
+    encoder_t* e = &set->enc[set->count];
+    memset(e, 0, sizeof(*e));
+    e->pin_a = pin_a;
+    e->pin_b = pin_b;
+    if (set->primed) e->state = encoder_ab(e, set->levels);
+    set->pin_mask |= (1ull << pin_a) | (1ull << pin_b);
+    return set->count++;
+}
+
+/* Velocities over the window that just ended; one division per encoder */
+static void encoder_close_window(encoder_set_t* set, uint64_t t_ns) {
+    double scale = 1e9 / (double)(t_ns - set->window_start_ns);
+    for (int i = 0; i < set->count; i++) {
+        encoder_t* e = &set->enc[i];
+        double v = (double)(e->position - e->window_pos) * scale;
+        __atomic_store(&e->velocity, &v, __ATOMIC_RELAXED);
+        e->window_pos = e->position;
+    }
+    set->window_start_ns = t_ns;
+}
+
+void encoder_update(encoder_set_t* set, uint64_t levels, uint64_t t_ns) {
+    set->samples++;
+    levels &= set->pin_mask;
+
+    if (!set->primed) {
+        for (int i = 0; i < set->count; i++) {
+            set->enc[i].state = encoder_ab(&set->enc[i], levels);
+        }
+        set->levels = levels;
+        set->window_start_ns = t_ns;
+        set->primed = 1;
+        return;
+    }
+
+    if (levels != set->levels) {
+        set->levels = levels;
+        for (int i = 0; i < set->count; i++) {
+            encoder_t* e = &set->enc[i];
+            uint8_t ab = encoder_ab(e, levels);
+            int8_t step = encoder_table[(e->state << 2) | ab];
+            e->state = ab;
+
+            if (step == ENCODER_INVALID) {
+                __atomic_store_n(&e->errors, e->errors + 1, __ATOMIC_RELAXED);
+            } else if (step) {
+                __atomic_store_n(&e->position, e->position + step, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    if (t_ns - set->window_start_ns >= set->window_ns) encoder_close_window(set, t_ns);
+}
+
+void encoder_poll(encoder_set_t* set) {
+    uint64_t levels = gpio_ctx_read_all(set->gpio);
+    encoder_update(set, levels, encoder_now_ns());
+}
+
+void encoder_edge(encoder_set_t* set, int pin, int level, uint64_t t_ns) {
+    if (!GPIO_VALID_PIN(pin)) return;
+    uint64_t levels = set->levels;
+    if (level) levels |= 1ull << pin;
+    else levels &= ~(1ull << pin);
+    encoder_update(set, levels, t_ns);
+}
+
+static void* encoder_thread_func(void* arg) {
+    encoder_set_t* set = (encoder_set_t*)arg;
+    if (set->core_id >= 0) pin_to_core(set->core_id);
+
+    while (__atomic_load_n(&set->running, __ATOMIC_RELAXED)) {
+        encoder_poll(set);
+    }
+    return NULL;
+}
+
+int encoder_start(encoder_set_t* set, int core_id) {
+    if (!set) return -1;
+    if (set->running) {
+        fprintf(stderr, "Encoder Error: Sampler already running\n");
+        return -1;
+    }
+
+    set->core_id = core_id;
+    __atomic_store_n(&set->running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&set->thread, NULL, encoder_thread_func, set) != 0) {
+        perror("Encoder Error: Failed to create thread");
+        set->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void encoder_stop(encoder_set_t* set) {
+    if (!set || !set->running) return;
+    __atomic_store_n(&set->running, 0, __ATOMIC_RELEASE);
+    pthread_join(set->thread, NULL);
+}
+
+int64_t encoder_position(const encoder_set_t* set, int index) {
+    if (!set || index < 0 || index >= set->count || index >= ENCODER_MAX) return 0;
+    return __atomic_load_n(&set->enc[index].position, __ATOMIC_RELAXED);
+}
+
+double encoder_velocity(const encoder_set_t* set, int index) {
+    double v = 0.0;
+    if (!set || index < 0 || index >= set->count || index >= ENCODER_MAX) return v;
+    __atomic_load(&set->enc[index].velocity, &v, __ATOMIC_RELAXED);
+    return v;
+}
+
+uint64_t encoder_errors(const encoder_set_t* set, int index) {
+    if (!set || index < 0 || index >= set->count || index >= ENCODER_MAX) return 0;
+    return __atomic_load_n(&set->enc[index].errors, __ATOMIC_RELAXED);
+}
+
+#endif /* RPI_ENCODER_IMPLEMENTATION */
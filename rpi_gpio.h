@@ -5,13 +5,35 @@
  * Single-header library. Define RPI_GPIO_IMPLEMENTATION in exactly one
  * translation unit before including this file.
  *
- * Uses /dev/gpiomem (no root required). On x86/x64, provides mock
- * implementations for development.
+ * Registers are mapped through rpi_periph.h (/dev/mem, or /dev/gpiomem
+ * without root); rpi_dma.h provides DMA memory and channels to the other
+ * modules. The backend is chosen at init time:
+ * mmap (default on Raspberry Pi), gpiochip (see rpi_gpiochip.h), a register
+ * simulator (default on x86/x64) or a null backend. Set RPI_GPIO_BACKEND to
+ * "mmap", "gpiochip", "sim" or "null" to override the default without
+ * rebuilding.
+ *
+ * All state lives in a gpio_ctx_t. The plain functions (gpio_init(),
+ * digital_write(), ...) operate on gpio_ctx_default; the gpio_ctx_*()
+ * variants take an explicit context, e.g. one simulator per thread.
  */
 
 #ifndef RPI_GPIO_H
 #define RPI_GPIO_H
 
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define RPI_GPIO_PLATFORM_HOST
+#elif defined(__aarch64__) || defined(__arm__)
+    #define RPI_GPIO_PLATFORM_RPI
+#else
+    #define RPI_GPIO_PLATFORM_HOST
+#endif
+
+#include "rpi_periph.h"
+#include "rpi_dma.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -37,6 +59,18 @@ extern "C" {
 #define GPIO_PIN_MIN 0
 #define GPIO_PIN_MAX 53
 
+/** @name Edge Detect Flags */
+/**@{*/
+#define GPIO_EDGE_NONE          0
+#define GPIO_EDGE_RISING        (1 << 0)  /**< Synchronous rising edge (GPREN) */
+#define GPIO_EDGE_FALLING       (1 << 1)  /**< Synchronous falling edge (GPFEN) */
+#define GPIO_EDGE_HIGH          (1 << 2)  /**< High level (GPHEN) */
+#define GPIO_EDGE_LOW           (1 << 3)  /**< Low level (GPLEN) */
+#define GPIO_EDGE_ASYNC_RISING  (1 << 4)  /**< Asynchronous rising edge (GPAREN) */
+#define GPIO_EDGE_ASYNC_FALLING (1 << 5)  /**< Asynchronous falling edge (GPAFEN) */
+#define GPIO_EDGE_BOTH          (GPIO_EDGE_RISING | GPIO_EDGE_FALLING)
+/**@}*/
+
 /** @name Register Calculation Constants */
 /**@{*/
 #define GPIO_PINS_PER_FSEL_REG 10
@@ -45,6 +79,23 @@ extern "C" {
 #define FSEL_MASK              0b111
 /**@}*/
 
+/** @name Register Offsets (32-bit words) */
+/**@{*/
+#define GPSET0  7
+#define GPSET1  8
+#define GPCLR0  10
+#define GPCLR1  11
+#define GPLEV0  13
+#define GPLEV1  14
+#define GPEDS0  16
+#define GPREN0  19
+#define GPFEN0  22
+#define GPHEN0  25
+#define GPLEN0  28
+#define GPAREN0 31
+#define GPAFEN0 34
+/**@}*/
+
 /** @name Helper Macros */
 /**@{*/
 /** Function select register index for a pin. */
@@ -57,14 +108,110 @@ extern "C" {
 #define GPIO_BIT(pin)         ((pin) < GPIO_PINS_PER_BANK ? (pin) : ((pin) - GPIO_PINS_PER_BANK))
 /** Validate pin is in valid range. */
 #define GPIO_VALID_PIN(pin)   ((pin) >= GPIO_PIN_MIN && (pin) <= GPIO_PIN_MAX)
+/** Mask covering all valid pins in a 64-bit level word. */
+#define GPIO_ALL_PINS_MASK    ((1ull << (GPIO_PIN_MAX + 1)) - 1)
 /**@}*/
 
 /**
- * @brief Initialize GPIO subsystem.
+ * @brief GPIO backend selection.
+ */
+typedef enum {
+    GPIO_BACKEND_AUTO = 0,  /**< RPI_GPIO_BACKEND, else mmap on Pi and sim on host */
+    GPIO_BACKEND_MMAP,      /**< /dev/gpiomem register block */
+    GPIO_BACKEND_GPIOCHIP,  /**< Linux character device (rpi_gpiochip.h) */
+    GPIO_BACKEND_SIM,       /**< In-memory register simulator */
+    GPIO_BACKEND_NULL,      /**< No-op: writes are dropped, reads return LOW */
+    GPIO_BACKEND_COUNT
+} gpio_backend_t;
+
+typedef struct gpio_ctx gpio_ctx_t;
+
+/**
+ * @brief Backend operations.
+ *
+ * Bank-level operations take pins 0-31 (bank 0) or 32-53 (bank 1). Backend
+ * state lives in the context (regs, state), never in file statics.
+ */
+typedef struct {
+    const char* name;
+    int      (*init)(gpio_ctx_t* ctx);
+    void     (*cleanup)(gpio_ctx_t* ctx);
+    void     (*set_function)(gpio_ctx_t* ctx, int pin, int function);
+    void     (*write_bank)(gpio_ctx_t* ctx, int bank, uint32_t set_mask, uint32_t clr_mask);
+    uint32_t (*read_bank)(gpio_ctx_t* ctx, int bank);
+    void     (*set_edge_detect)(gpio_ctx_t* ctx, int pin, int edges);
+    uint64_t (*edge_status)(gpio_ctx_t* ctx, uint64_t mask);  /**< Read and clear only @p mask. */
+} gpio_backend_ops_t;
+
+/**
+ * @brief Per-context operation counters.
+ *
+ * Plain counters: read them from the thread that owns the context.
+ * The inline *_fast() helpers are not counted.
+ */
+typedef struct {
+    uint64_t writes;    /**< Output updates (digital_write, gpio_write_mask). */
+    uint64_t reads;     /**< Level reads (digital_read, gpio_read_all). */
+    uint64_t config;    /**< Function and edge detect changes. */
+} gpio_stats_t;
+
+/**
+ * @brief GPIO instance: register pointers, backend and statistics.
+ *
+ * Each context owns its backend state, so several simulated instances can
+ * run side by side (one per thread or test). Initialize with gpio_ctx_init().
+ */
+struct gpio_ctx {
+    volatile uint32_t* regs;         /**< mmap register block, NULL for other backends. */
+    const gpio_backend_ops_t* ops;   /**< Active backend operations. */
+    void* state;                     /**< Backend-private state. */
+    gpio_backend_t backend;          /**< Active backend. */
+    gpio_stats_t stats;              /**< Operation counters. */
+};
+
+/**
+ * @brief Context behind gpio_init(), digital_write() and the rest of the
+ * context-free API.
+ */
+extern gpio_ctx_t gpio_ctx_default;
+
+/**
+ * @brief Initialize GPIO subsystem with the default backend.
  * @return 0 on success, -1 on error.
  */
 int gpio_init(void);
 
+/**
+ * @brief Initialize GPIO subsystem with a specific backend.
+ *
+ * Releases the previously active backend first.
+ *
+ * @param backend Backend to use (GPIO_BACKEND_AUTO for the default).
+ * @return 0 on success, -1 on error.
+ */
+int gpio_init_backend(gpio_backend_t backend);
+
+/**
+ * @brief Active backend (GPIO_BACKEND_NULL before gpio_init()).
+ */
+gpio_backend_t gpio_get_backend(void);
+
+/**
+ * @brief Human-readable name of a backend.
+ */
+const char* gpio_backend_name(gpio_backend_t backend);
+
+/**
+ * @brief Install the operations for a backend slot.
+ *
+ * rpi_gpiochip.h registers GPIO_BACKEND_GPIOCHIP automatically.
+ *
+ * @param backend Backend slot.
+ * @param ops Operations table; must stay valid while registered.
+ * @return 0 on success, -1 on invalid slot.
+ */
+int gpio_register_backend(gpio_backend_t backend, const gpio_backend_ops_t* ops);
+
 /**
  * @brief Release GPIO resources.
  */
@@ -98,6 +245,188 @@ void digital_write(int pin, int value);
  */
 int digital_read(int pin);
 
+/**
+ * @brief Drive several outputs at once.
+ *
+ * Pins in @p set_mask go HIGH, pins in @p clr_mask go LOW. Each bank is
+ * updated with one GPSET and one GPCLR store.
+ *
+ * @param set_mask Bit n sets BCM pin n.
+ * @param clr_mask Bit n clears BCM pin n.
+ */
+void gpio_write_mask(uint64_t set_mask, uint64_t clr_mask);
+
+/**
+ * @brief Read the levels of all pins at once.
+ * @return Bit n holds the level of BCM pin n (pins 0-53).
+ */
+uint64_t gpio_read_all(void);
+
+/**
+ * @brief Configure edge/level detection for a pin.
+ *
+ * Detected events latch in the GPEDS registers until cleared with
+ * gpio_edge_status().
+ *
+ * @param pin BCM pin number (0-53).
+ * @param edges Bitwise OR of GPIO_EDGE_* flags, or GPIO_EDGE_NONE to disable.
+ */
+void gpio_set_edge_detect(int pin, int edges);
+
+/**
+ * @brief Read and clear latched edge/level events.
+ * @return Bit n is set if an event was detected on BCM pin n.
+ */
+uint64_t gpio_edge_status(void);
+
+/**
+ * @brief Read and clear latched events of the pins in @p mask only.
+ *
+ * Events on other pins stay latched for their own consumer.
+ * @return Bit n is set if an event was detected on BCM pin n (within @p mask).
+ */
+uint64_t gpio_edge_status_mask(uint64_t mask);
+
+/** @name Context API
+ * Same operations as above on an explicit context.
+ */
+/**@{*/
+
+/**
+ * @brief Initialize a context with a backend.
+ *
+ * The context must be zeroed or previously cleaned up.
+ *
+ * @param ctx Context to initialize.
+ * @param backend Backend to use (GPIO_BACKEND_AUTO for the default).
+ * @return 0 on success, -1 on error (the context is left on the null backend).
+ */
+int gpio_ctx_init(gpio_ctx_t* ctx, gpio_backend_t backend);
+
+/**
+ * @brief Release the backend of a context; it falls back to the null backend.
+ */
+void gpio_ctx_cleanup(gpio_ctx_t* ctx);
+
+void gpio_ctx_pin_mode(gpio_ctx_t* ctx, int pin, int mode);
+void gpio_ctx_set_function(gpio_ctx_t* ctx, int pin, int function);
+void gpio_ctx_write(gpio_ctx_t* ctx, int pin, int value);
+int gpio_ctx_read(gpio_ctx_t* ctx, int pin);
+void gpio_ctx_write_mask(gpio_ctx_t* ctx, uint64_t set_mask, uint64_t clr_mask);
+uint64_t gpio_ctx_read_all(gpio_ctx_t* ctx);
+void gpio_ctx_set_edge_detect(gpio_ctx_t* ctx, int pin, int edges);
+uint64_t gpio_ctx_edge_status(gpio_ctx_t* ctx);
+uint64_t gpio_ctx_edge_status_mask(gpio_ctx_t* ctx, uint64_t mask);
+/**@}*/
+
+/**
+ * @brief Simulator callback invoked after pin levels change.
+ * @param user Opaque pointer passed to gpio_sim_set_observer().
+ * @param prev_levels Levels before the change.
+ * @param levels Levels after the change.
+ */
+typedef void (*gpio_sim_observer_fn)(void* user, uint64_t prev_levels, uint64_t levels);
+
+/**
+ * @brief Drive an input pin of the simulator from outside (test stimulus).
+ *
+ * Ignored unless the context runs the sim backend.
+ *
+ * @param pin BCM pin number.
+ * @param value LOW or HIGH.
+ */
+void gpio_sim_set_input(int pin, int value);
+
+/**
+ * @brief Current function select value of a simulated pin.
+ * @return INPUT, OUTPUT or ALTn, -1 for invalid pins or non-sim backends.
+ */
+int gpio_sim_get_function(int pin);
+
+/**
+ * @brief Observe level changes in the simulator (device models, tracing).
+ *
+ * The observer may call gpio_sim_set_input(); nested changes are applied
+ * but do not re-invoke the observer. The observer is dropped on cleanup.
+ *
+ * @param fn Callback, or NULL to remove.
+ * @param user Opaque pointer passed to @p fn.
+ */
+void gpio_sim_set_observer(gpio_sim_observer_fn fn, void* user);
+
+/** @name Simulator Context API */
+/**@{*/
+void gpio_ctx_sim_set_input(gpio_ctx_t* ctx, int pin, int value);
+int gpio_ctx_sim_get_function(gpio_ctx_t* ctx, int pin);
+void gpio_ctx_sim_set_observer(gpio_ctx_t* ctx, gpio_sim_observer_fn fn, void* user);
+/**@}*/
+
+/**
+ * @brief Inline write for hot loops: direct store on the mmap backend.
+ */
+static inline void gpio_ctx_write_fast(gpio_ctx_t* ctx, int pin, int value) {
+    volatile uint32_t* regs = ctx->regs;
+    if (regs && GPIO_VALID_PIN(pin)) {
+        regs[(value == HIGH ? GPSET0 : GPCLR0) + GPIO_BANK(pin)] = 1u << GPIO_BIT(pin);
+    } else {
+        gpio_ctx_write(ctx, pin, value);
+    }
+}
+
+/**
+ * @brief One masked write, for drivers that precompute tables of them.
+ */
+typedef struct {
+    uint64_t set_mask;
+    uint64_t clr_mask;
+} gpio_store_t;
+
+/**
+ * @brief Inline masked write for hot loops: direct GPSET/GPCLR stores on the
+ * mmap backend.
+ *
+ * Masks as gpio_ctx_write_mask() does, so a pin in both masks is set and
+ * bits above GPIO_PIN_MAX are dropped; with constant masks this folds away.
+ * Only registers with bits in their half of a mask are stored to, so a
+ * bank 0 update is one or two stores, GPSET before GPCLR. Not counted in
+ * ctx->stats on mmap; other backends fall back to gpio_ctx_write_mask(),
+ * which is.
+ */
+static inline void gpio_ctx_write_mask_fast(gpio_ctx_t* ctx, uint64_t set_mask, uint64_t clr_mask) {
+    volatile uint32_t* regs = ctx->regs;
+    if (!regs) {
+        gpio_ctx_write_mask(ctx, set_mask, clr_mask);
+        return;
+    }
+    set_mask &= GPIO_ALL_PINS_MASK;
+    clr_mask &= GPIO_ALL_PINS_MASK & ~set_mask;
+    if ((uint32_t)set_mask) regs[GPSET0] = (uint32_t)set_mask;
+    if ((uint32_t)clr_mask) regs[GPCLR0] = (uint32_t)clr_mask;
+    if (set_mask >> GPIO_PINS_PER_BANK) regs[GPSET1] = (uint32_t)(set_mask >> GPIO_PINS_PER_BANK);
+    if (clr_mask >> GPIO_PINS_PER_BANK) regs[GPCLR1] = (uint32_t)(clr_mask >> GPIO_PINS_PER_BANK);
+}
+
+/**
+ * @brief Inline read for hot loops: direct load on the mmap backend.
+ */
+static inline int gpio_ctx_read_fast(gpio_ctx_t* ctx, int pin) {
+    volatile uint32_t* regs = ctx->regs;
+    if (regs && GPIO_VALID_PIN(pin)) {
+        return (regs[GPLEV0 + GPIO_BANK(pin)] >> GPIO_BIT(pin)) & 1;
+    }
+    return gpio_ctx_read(ctx, pin);
+}
+
+/** gpio_ctx_write_fast() on the default context. */
+static inline void digital_write_fast(int pin, int value) {
+    gpio_ctx_write_fast(&gpio_ctx_default, pin, value);
+}
+
+/** gpio_ctx_read_fast() on the default context. */
+static inline int digital_read_fast(int pin) {
+    return gpio_ctx_read_fast(&gpio_ctx_default, pin);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -108,148 +437,560 @@ int digital_read(int pin);
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
+#include <stdatomic.h>
 
-#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
-    #define RPI_GPIO_PLATFORM_HOST
-#elif defined(__aarch64__) || defined(__arm__)
-    #define RPI_GPIO_PLATFORM_RPI
-#else
-    #define RPI_GPIO_PLATFORM_HOST
-#endif
+#define RPI_PERIPH_IMPLEMENTATION
+#include "rpi_periph.h"
 
-#ifdef RPI_GPIO_PLATFORM_RPI
-    #include <fcntl.h>
-    #include <sys/mman.h>
-    #include <unistd.h>
+#define RPI_DMA_IMPLEMENTATION
+#include "rpi_dma.h"
 
-    #define BLOCK_SIZE (4*1024)
+/** Edge detect enable registers, indexed by GPIO_EDGE_* bit position. */
+static const int gpio_detect_regs[] = { GPREN0, GPFEN0, GPHEN0, GPLEN0, GPAREN0, GPAFEN0 };
+#define GPIO_DETECT_REG_COUNT ((int)(sizeof(gpio_detect_regs) / sizeof(gpio_detect_regs[0])))
 
-    #define GPSET0  7
-    #define GPSET1  8
-    #define GPCLR0  10
-    #define GPCLR1  11
-    #define GPLEV0  13
-    #define GPLEV1  14
+/* ---------------------------------------------------------------------------
+ * mmap backend
+ * ---------------------------------------------------------------------------*/
+static int gpio_mmap_init(gpio_ctx_t* ctx) {
+    ctx->regs = periph_map(PERIPH_GPIO);
+    return ctx->regs ? 0 : -1;
+}
 
-    static volatile uint32_t *gpio_map = NULL;
-    static int mem_fd = -1;
+static void gpio_mmap_cleanup(gpio_ctx_t* ctx) {
+    if (ctx->regs) {
+        periph_unmap(PERIPH_GPIO);
+        ctx->regs = NULL;
+    }
+}
 
-#endif
+static void gpio_mmap_set_function(gpio_ctx_t* ctx, int pin, int function) {
+    volatile uint32_t* fsel_reg = ctx->regs + GPIO_FSEL_REG(pin);
+    int shift = GPIO_FSEL_SHIFT(pin);
 
-int gpio_init(void) {
-#ifdef RPI_GPIO_PLATFORM_HOST
-    printf("MOCK: gpio_init() called. Simulation mode active.\n");
-    return 0;
-#else
-    if ((mem_fd = open("/dev/gpiomem", O_RDWR|O_SYNC) ) < 0) {
-        perror("Can't open /dev/gpiomem");
-        return -1;
+    uint32_t val = *fsel_reg;
+    val &= ~(FSEL_MASK << shift);
+    val |= (function << shift);
+    *fsel_reg = val;
+}
+
+static void gpio_mmap_write_bank(gpio_ctx_t* ctx, int bank, uint32_t set_mask, uint32_t clr_mask) {
+    if (set_mask) ctx->regs[GPSET0 + bank] = set_mask;
+    if (clr_mask) ctx->regs[GPCLR0 + bank] = clr_mask;
+}
+
+static uint32_t gpio_mmap_read_bank(gpio_ctx_t* ctx, int bank) {
+    return ctx->regs[GPLEV0 + bank];
+}
+
+static void gpio_mmap_set_edge_detect(gpio_ctx_t* ctx, int pin, int edges) {
+    volatile uint32_t* regs = ctx->regs;
+    int bank = GPIO_BANK(pin);
+    uint32_t mask = 1u << GPIO_BIT(pin);
+
+    for (int i = 0; i < GPIO_DETECT_REG_COUNT; i++) {
+        volatile uint32_t* reg = regs + gpio_detect_regs[i] + bank;
+        if (edges & (1 << i)) {
+            *reg |= mask;
+        } else {
+            *reg &= ~mask;
+        }
+    }
+    regs[GPEDS0 + bank] = mask;  /* Drop events latched under the old config */
+}
+
+static uint64_t gpio_mmap_edge_status(gpio_ctx_t* ctx, uint64_t mask) {
+    volatile uint32_t* regs = ctx->regs;
+
+    /* GPEDS is write-1-to-clear: acknowledge exactly what was observed */
+    uint32_t lo = regs[GPEDS0] & (uint32_t)mask;
+    uint32_t hi = regs[GPEDS0 + 1] & (uint32_t)(mask >> GPIO_PINS_PER_BANK);
+    if (lo) regs[GPEDS0] = lo;
+    if (hi) regs[GPEDS0 + 1] = hi;
+    return ((uint64_t)hi << GPIO_PINS_PER_BANK) | lo;
+}
+
+static const gpio_backend_ops_t gpio_mmap_backend = {
+    "mmap",
+    gpio_mmap_init,
+    gpio_mmap_cleanup,
+    gpio_mmap_set_function,
+    gpio_mmap_write_bank,
+    gpio_mmap_read_bank,
+    gpio_mmap_set_edge_detect,
+    gpio_mmap_edge_status
+};
+
+/* ---------------------------------------------------------------------------
+ * Simulator backend
+ *
+ * Models FSEL, the output latch, externally driven input levels and the
+ * edge/level detect logic. A pin reads its output latch when configured as
+ * OUTPUT and its external level otherwise. Each context gets its own state.
+ * ---------------------------------------------------------------------------*/
+typedef struct {
+    uint32_t fsel[6];
+    uint32_t out[2];
+    uint32_t in[2];
+    uint32_t level[2];
+    uint32_t detect[GPIO_DETECT_REG_COUNT][2];
+    uint32_t eds[2];
+    atomic_flag lock;
+    gpio_sim_observer_fn observer;
+    void* observer_user;
+} gpio_sim_state_t;
+
+static _Thread_local int gpio_sim_in_observer = 0;
+
+static void gpio_sim_acquire(gpio_sim_state_t* s) {
+    while (atomic_flag_test_and_set_explicit(&s->lock, memory_order_acquire)) {}
+}
+
+static void gpio_sim_release(gpio_sim_state_t* s) {
+    atomic_flag_clear_explicit(&s->lock, memory_order_release);
+}
+
+static uint64_t gpio_sim_levels_locked(const gpio_sim_state_t* s) {
+    return ((uint64_t)s->level[1] << GPIO_PINS_PER_BANK) | s->level[0];
+}
+
+static uint32_t gpio_sim_output_mask(const gpio_sim_state_t* s, int bank) {
+    uint32_t mask = 0;
+    int first = bank * GPIO_PINS_PER_BANK;
+    int last = bank == 0 ? GPIO_PINS_PER_BANK - 1 : GPIO_PIN_MAX;
+
+    for (int pin = first; pin <= last; pin++) {
+        uint32_t f = (s->fsel[GPIO_FSEL_REG(pin)] >> GPIO_FSEL_SHIFT(pin)) & FSEL_MASK;
+        if (f == OUTPUT) mask |= 1u << GPIO_BIT(pin);
     }
+    return mask;
+}
 
-    gpio_map = (volatile uint32_t *)mmap(
-        NULL,
-        BLOCK_SIZE,
-        PROT_READ|PROT_WRITE,
-        MAP_SHARED,
-        mem_fd,
-        0
-    );
+/** Recompute levels and latch edges; caller holds the lock. */
+static void gpio_sim_update_locked(gpio_sim_state_t* s) {
+    for (int bank = 0; bank < 2; bank++) {
+        uint32_t outputs = gpio_sim_output_mask(s, bank);
+        uint32_t prev = s->level[bank];
+        uint32_t now = (s->out[bank] & outputs) | (s->in[bank] & ~outputs);
+        uint32_t rise = ~prev & now;
+        uint32_t fall = prev & ~now;
+
+        s->eds[bank] |= rise & (s->detect[0][bank] | s->detect[4][bank]);
+        s->eds[bank] |= fall & (s->detect[1][bank] | s->detect[5][bank]);
+        s->level[bank] = now;
+    }
+}
 
-    if (gpio_map == MAP_FAILED) {
-        perror("mmap error");
-        close(mem_fd);
+/** Apply a mutation to state @p s under its lock and notify the observer. */
+#define GPIO_SIM_MUTATE(s, stmt) \
+    do { \
+        gpio_sim_acquire(s); \
+        uint64_t gpio_sim_prev_ = gpio_sim_levels_locked(s); \
+        stmt; \
+        gpio_sim_update_locked(s); \
+        uint64_t gpio_sim_now_ = gpio_sim_levels_locked(s); \
+        gpio_sim_observer_fn gpio_sim_fn_ = (s)->observer; \
+        void* gpio_sim_user_ = (s)->observer_user; \
+        gpio_sim_release(s); \
+        if (gpio_sim_fn_ && gpio_sim_prev_ != gpio_sim_now_ && !gpio_sim_in_observer) { \
+            gpio_sim_in_observer = 1; \
+            gpio_sim_fn_(gpio_sim_user_, gpio_sim_prev_, gpio_sim_now_); \
+            gpio_sim_in_observer = 0; \
+        } \
+    } while (0)
+
+static int gpio_sim_init(gpio_ctx_t* ctx) {
+    /* Own cache lines per context: parallel simulators must not false-share */
+    size_t size = (sizeof(gpio_sim_state_t) + 63) & ~(size_t)63;
+    gpio_sim_state_t* s = (gpio_sim_state_t*)aligned_alloc(64, size);
+    if (!s) {
+        perror("GPIO Error: Failed to allocate simulator");
         return -1;
     }
+    memset(s, 0, size);
+    atomic_flag_clear(&s->lock);
+    ctx->state = s;
+    if (ctx == &gpio_ctx_default) {
+        printf("MOCK: gpio_init() called. Simulation mode active.\n");
+    }
     return 0;
-#endif
 }
 
-void gpio_cleanup(void) {
-#ifdef RPI_GPIO_PLATFORM_HOST
-    printf("MOCK: gpio_cleanup() called.\n");
-#else
-    if (gpio_map) {
-        munmap((void*)gpio_map, BLOCK_SIZE);
-        gpio_map = NULL;
+static void gpio_sim_cleanup(gpio_ctx_t* ctx) {
+    free(ctx->state);
+    ctx->state = NULL;
+    if (ctx == &gpio_ctx_default) {
+        printf("MOCK: gpio_cleanup() called.\n");
     }
-    if (mem_fd >= 0) {
-        close(mem_fd);
-        mem_fd = -1;
+}
+
+static void gpio_sim_set_function(gpio_ctx_t* ctx, int pin, int function) {
+    gpio_sim_state_t* s = (gpio_sim_state_t*)ctx->state;
+    GPIO_SIM_MUTATE(s, {
+        uint32_t* reg = &s->fsel[GPIO_FSEL_REG(pin)];
+        int shift = GPIO_FSEL_SHIFT(pin);
+        *reg = (*reg & ~(FSEL_MASK << shift)) | ((uint32_t)function << shift);
+    });
+}
+
+static void gpio_sim_write_bank(gpio_ctx_t* ctx, int bank, uint32_t set_mask, uint32_t clr_mask) {
+    gpio_sim_state_t* s = (gpio_sim_state_t*)ctx->state;
+    GPIO_SIM_MUTATE(s, {
+        s->out[bank] |= set_mask;
+        s->out[bank] &= ~clr_mask;
+    });
+}
+
+static uint32_t gpio_sim_read_bank(gpio_ctx_t* ctx, int bank) {
+    gpio_sim_state_t* s = (gpio_sim_state_t*)ctx->state;
+    gpio_sim_acquire(s);
+    uint32_t level = s->level[bank];
+    gpio_sim_release(s);
+    return level;
+}
+
+static void gpio_sim_set_edge_detect(gpio_ctx_t* ctx, int pin, int edges) {
+    gpio_sim_state_t* s = (gpio_sim_state_t*)ctx->state;
+    int bank = GPIO_BANK(pin);
+    uint32_t mask = 1u << GPIO_BIT(pin);
+
+    gpio_sim_acquire(s);
+    for (int i = 0; i < GPIO_DETECT_REG_COUNT; i++) {
+        if (edges & (1 << i)) {
+            s->detect[i][bank] |= mask;
+        } else {
+            s->detect[i][bank] &= ~mask;
+        }
     }
-#endif
+    s->eds[bank] &= ~mask;
+    gpio_sim_release(s);
 }
 
-void pin_mode(int pin, int mode) {
-    if (!GPIO_VALID_PIN(pin)) return;
-#ifdef RPI_GPIO_PLATFORM_HOST
-    printf("MOCK: Pin %d set to %s\n", pin, mode == INPUT ? "INPUT" : "OUTPUT");
-#else
-    if (!gpio_map) return;
+static uint64_t gpio_sim_edge_status(gpio_ctx_t* ctx, uint64_t mask) {
+    gpio_sim_state_t* s = (gpio_sim_state_t*)ctx->state;
+    gpio_sim_acquire(s);
+    for (int bank = 0; bank < 2; bank++) {
+        /* Level detect re-latches for as long as the level holds */
+        s->eds[bank] |= s->level[bank] & s->detect[2][bank];
+        s->eds[bank] |= ~s->level[bank] & s->detect[3][bank];
+    }
+    uint64_t status = (((uint64_t)s->eds[1] << GPIO_PINS_PER_BANK) | s->eds[0]) & mask;
+    s->eds[0] &= ~(uint32_t)status;
+    s->eds[1] &= ~(uint32_t)(status >> GPIO_PINS_PER_BANK);
+    gpio_sim_release(s);
+    return status & GPIO_ALL_PINS_MASK;
+}
 
-    volatile uint32_t* fsel_reg = gpio_map + GPIO_FSEL_REG(pin);
-    int shift = GPIO_FSEL_SHIFT(pin);
+static const gpio_backend_ops_t gpio_sim_backend = {
+    "sim",
+    gpio_sim_init,
+    gpio_sim_cleanup,
+    gpio_sim_set_function,
+    gpio_sim_write_bank,
+    gpio_sim_read_bank,
+    gpio_sim_set_edge_detect,
+    gpio_sim_edge_status
+};
+
+/** Simulator state of a context, NULL if it runs another backend. */
+static gpio_sim_state_t* gpio_sim_state(gpio_ctx_t* ctx) {
+    return ctx->ops == &gpio_sim_backend ? (gpio_sim_state_t*)ctx->state : NULL;
+}
 
-    uint32_t val = *fsel_reg;
-    val &= ~(FSEL_MASK << shift);
-    if (mode == OUTPUT) {
-        val |= (1 << shift);  /* OUTPUT = 001 */
+void gpio_ctx_sim_set_input(gpio_ctx_t* ctx, int pin, int value) {
+    gpio_sim_state_t* s = gpio_sim_state(ctx);
+    if (!s || !GPIO_VALID_PIN(pin)) return;
+    int bank = GPIO_BANK(pin);
+    uint32_t mask = 1u << GPIO_BIT(pin);
+
+    GPIO_SIM_MUTATE(s, {
+        if (value == HIGH) {
+            s->in[bank] |= mask;
+        } else {
+            s->in[bank] &= ~mask;
+        }
+    });
+}
+
+int gpio_ctx_sim_get_function(gpio_ctx_t* ctx, int pin) {
+    gpio_sim_state_t* s = gpio_sim_state(ctx);
+    if (!s || !GPIO_VALID_PIN(pin)) return -1;
+    gpio_sim_acquire(s);
+    int f = (int)((s->fsel[GPIO_FSEL_REG(pin)] >> GPIO_FSEL_SHIFT(pin)) & FSEL_MASK);
+    gpio_sim_release(s);
+    return f;
+}
+
+void gpio_ctx_sim_set_observer(gpio_ctx_t* ctx, gpio_sim_observer_fn fn, void* user) {
+    gpio_sim_state_t* s = gpio_sim_state(ctx);
+    if (!s) return;
+    gpio_sim_acquire(s);
+    s->observer = fn;
+    s->observer_user = user;
+    gpio_sim_release(s);
+}
+
+void gpio_sim_set_input(int pin, int value) {
+    gpio_ctx_sim_set_input(&gpio_ctx_default, pin, value);
+}
+
+int gpio_sim_get_function(int pin) {
+    return gpio_ctx_sim_get_function(&gpio_ctx_default, pin);
+}
+
+void gpio_sim_set_observer(gpio_sim_observer_fn fn, void* user) {
+    gpio_ctx_sim_set_observer(&gpio_ctx_default, fn, user);
+}
+
+/* ---------------------------------------------------------------------------
+ * Null backend
+ * ---------------------------------------------------------------------------*/
+static int gpio_null_init(gpio_ctx_t* ctx) { (void)ctx; return 0; }
+static void gpio_null_cleanup(gpio_ctx_t* ctx) { (void)ctx; }
+static void gpio_null_set_function(gpio_ctx_t* ctx, int pin, int function) {
+    (void)ctx; (void)pin; (void)function;
+}
+static void gpio_null_write_bank(gpio_ctx_t* ctx, int bank, uint32_t set_mask, uint32_t clr_mask) {
+    (void)ctx; (void)bank; (void)set_mask; (void)clr_mask;
+}
+static uint32_t gpio_null_read_bank(gpio_ctx_t* ctx, int bank) { (void)ctx; (void)bank; return 0; }
+static void gpio_null_set_edge_detect(gpio_ctx_t* ctx, int pin, int edges) {
+    (void)ctx; (void)pin; (void)edges;
+}
+static uint64_t gpio_null_edge_status(gpio_ctx_t* ctx, uint64_t mask) { (void)ctx; (void)mask; return 0; }
+
+static const gpio_backend_ops_t gpio_null_backend = {
+    "null",
+    gpio_null_init,
+    gpio_null_cleanup,
+    gpio_null_set_function,
+    gpio_null_write_bank,
+    gpio_null_read_bank,
+    gpio_null_set_edge_detect,
+    gpio_null_edge_status
+};
+
+/* ---------------------------------------------------------------------------
+ * Dispatch
+ * ---------------------------------------------------------------------------*/
+static const gpio_backend_ops_t* gpio_backends[GPIO_BACKEND_COUNT] = {
+    [GPIO_BACKEND_MMAP] = &gpio_mmap_backend,
+    [GPIO_BACKEND_SIM]  = &gpio_sim_backend,
+    [GPIO_BACKEND_NULL] = &gpio_null_backend,
+};
+
+gpio_ctx_t gpio_ctx_default = {
+    .regs = NULL,
+    .ops = &gpio_null_backend,
+    .state = NULL,
+    .backend = GPIO_BACKEND_NULL,
+};
+
+static gpio_backend_t gpio_default_backend(void) {
+    const char* env = getenv("RPI_GPIO_BACKEND");
+    if (env) {
+        for (int b = GPIO_BACKEND_MMAP; b < GPIO_BACKEND_COUNT; b++) {
+            if (gpio_backends[b] && strcmp(env, gpio_backends[b]->name) == 0) {
+                return (gpio_backend_t)b;
+            }
+        }
+        fprintf(stderr, "GPIO Warning: Unknown RPI_GPIO_BACKEND '%s', using default\n", env);
     }
-    *fsel_reg = val;
+#ifdef RPI_GPIO_PLATFORM_RPI
+    return GPIO_BACKEND_MMAP;
+#else
+    return GPIO_BACKEND_SIM;
 #endif
 }
 
-void gpio_set_function(int pin, int function) {
-    if (!GPIO_VALID_PIN(pin)) return;
-#ifdef RPI_GPIO_PLATFORM_HOST
-    printf("MOCK: Pin %d set to Function %d\n", pin, function);
-#else
-    if (!gpio_map) return;
+int gpio_register_backend(gpio_backend_t backend, const gpio_backend_ops_t* ops) {
+    if (backend <= GPIO_BACKEND_AUTO || backend >= GPIO_BACKEND_COUNT || !ops) return -1;
+    gpio_backends[backend] = ops;
+    return 0;
+}
 
-    volatile uint32_t* fsel_reg = gpio_map + GPIO_FSEL_REG(pin);
-    int shift = GPIO_FSEL_SHIFT(pin);
+/** Put a context on the null backend without touching its previous state. */
+static void gpio_ctx_reset(gpio_ctx_t* ctx) {
+    ctx->regs = NULL;
+    ctx->ops = &gpio_null_backend;
+    ctx->state = NULL;
+    ctx->backend = GPIO_BACKEND_NULL;
+}
 
-    uint32_t val = *fsel_reg;
-    val &= ~(FSEL_MASK << shift);
-    val |= (function << shift);
-    *fsel_reg = val;
-#endif
+int gpio_ctx_init(gpio_ctx_t* ctx, gpio_backend_t backend) {
+    if (!ctx) return -1;
+    gpio_ctx_reset(ctx);
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+
+    if (backend == GPIO_BACKEND_AUTO) {
+        backend = gpio_default_backend();
+    }
+    if (backend <= GPIO_BACKEND_AUTO || backend >= GPIO_BACKEND_COUNT || !gpio_backends[backend]) {
+        fprintf(stderr, "GPIO Error: Backend %d not available\n", (int)backend);
+        return -1;
+    }
+
+    const gpio_backend_ops_t* ops = gpio_backends[backend];
+    if (ops->init(ctx) != 0) {
+        gpio_ctx_reset(ctx);
+        return -1;
+    }
+    ctx->ops = ops;
+    ctx->backend = backend;
+    return 0;
 }
 
-void digital_write(int pin, int value) {
+void gpio_ctx_cleanup(gpio_ctx_t* ctx) {
+    if (!ctx || !ctx->ops) return;
+    ctx->ops->cleanup(ctx);
+    gpio_ctx_reset(ctx);
+}
+
+int gpio_init_backend(gpio_backend_t backend) {
+    gpio_ctx_cleanup(&gpio_ctx_default);
+    return gpio_ctx_init(&gpio_ctx_default, backend);
+}
+
+int gpio_init(void) {
+    return gpio_init_backend(GPIO_BACKEND_AUTO);
+}
+
+gpio_backend_t gpio_get_backend(void) {
+    return gpio_ctx_default.backend;
+}
+
+const char* gpio_backend_name(gpio_backend_t backend) {
+    if (backend == GPIO_BACKEND_AUTO) return "auto";
+    if (backend < 0 || backend >= GPIO_BACKEND_COUNT || !gpio_backends[backend]) return "unavailable";
+    return gpio_backends[backend]->name;
+}
+
+void gpio_cleanup(void) {
+    gpio_ctx_cleanup(&gpio_ctx_default);
+}
+
+void gpio_ctx_pin_mode(gpio_ctx_t* ctx, int pin, int mode) {
+    if (!GPIO_VALID_PIN(pin)) return;
+    ctx->stats.config++;
+    ctx->ops->set_function(ctx, pin, mode == OUTPUT ? OUTPUT : INPUT);
+}
+
+void gpio_ctx_set_function(gpio_ctx_t* ctx, int pin, int function) {
+    if (!GPIO_VALID_PIN(pin)) return;
+    ctx->stats.config++;
+    ctx->ops->set_function(ctx, pin, function & FSEL_MASK);
+}
+
+void gpio_ctx_write(gpio_ctx_t* ctx, int pin, int value) {
     if (!GPIO_VALID_PIN(pin)) return;
-#ifdef RPI_GPIO_PLATFORM_HOST
-    printf("MOCK: Pin %d set to %s\n", pin, value == HIGH ? "HIGH" : "LOW");
-#else
-    if (!gpio_map) return;
 
     int bank = GPIO_BANK(pin);
-    int bit = GPIO_BIT(pin);
+    uint32_t bit = 1u << GPIO_BIT(pin);
+    ctx->stats.writes++;
 
+    /* mmap fast path: plain store, no indirect call */
+    if (ctx->regs) {
+        ctx->regs[(value == HIGH ? GPSET0 : GPCLR0) + bank] = bit;
+        return;
+    }
     if (value == HIGH) {
-        volatile uint32_t* set_reg = gpio_map + GPSET0 + bank;
-        *set_reg = (1 << bit);
+        ctx->ops->write_bank(ctx, bank, bit, 0);
     } else {
-        volatile uint32_t* clr_reg = gpio_map + GPCLR0 + bank;
-        *clr_reg = (1 << bit);
+        ctx->ops->write_bank(ctx, bank, 0, bit);
     }
-#endif
 }
 
-int digital_read(int pin) {
+int gpio_ctx_read(gpio_ctx_t* ctx, int pin) {
     if (!GPIO_VALID_PIN(pin)) return LOW;
-#ifdef RPI_GPIO_PLATFORM_HOST
-    printf("MOCK: Reading Pin %d (returning LOW)\n", pin);
-    return LOW;
-#else
-    if (!gpio_map) return LOW;
 
     int bank = GPIO_BANK(pin);
-    int bit = GPIO_BIT(pin);
+    ctx->stats.reads++;
+    uint32_t level = ctx->regs ? ctx->regs[GPLEV0 + bank] : ctx->ops->read_bank(ctx, bank);
+    return (level & (1u << GPIO_BIT(pin))) ? HIGH : LOW;
+}
 
-    volatile uint32_t* lev_reg = gpio_map + GPLEV0 + bank;
-    return (*lev_reg & (1 << bit)) ? HIGH : LOW;
-#endif
+void gpio_ctx_write_mask(gpio_ctx_t* ctx, uint64_t set_mask, uint64_t clr_mask) {
+    set_mask &= GPIO_ALL_PINS_MASK;
+    clr_mask &= GPIO_ALL_PINS_MASK & ~set_mask;
+    ctx->stats.writes++;
+
+    for (int bank = 0; bank < 2; bank++) {
+        uint32_t set = (uint32_t)(set_mask >> (bank * GPIO_PINS_PER_BANK));
+        uint32_t clr = (uint32_t)(clr_mask >> (bank * GPIO_PINS_PER_BANK));
+        if (!set && !clr) continue;
+
+        if (ctx->regs) {
+            if (set) ctx->regs[GPSET0 + bank] = set;
+            if (clr) ctx->regs[GPCLR0 + bank] = clr;
+        } else {
+            ctx->ops->write_bank(ctx, bank, set, clr);
+        }
+    }
+}
+
+uint64_t gpio_ctx_read_all(gpio_ctx_t* ctx) {
+    uint32_t lo, hi;
+    ctx->stats.reads++;
+    if (ctx->regs) {
+        lo = ctx->regs[GPLEV0];
+        hi = ctx->regs[GPLEV1];
+    } else {
+        lo = ctx->ops->read_bank(ctx, 0);
+        hi = ctx->ops->read_bank(ctx, 1);
+    }
+    return (((uint64_t)hi << GPIO_PINS_PER_BANK) | lo) & GPIO_ALL_PINS_MASK;
+}
+
+void gpio_ctx_set_edge_detect(gpio_ctx_t* ctx, int pin, int edges) {
+    if (!GPIO_VALID_PIN(pin)) return;
+    ctx->stats.config++;
+    ctx->ops->set_edge_detect(ctx, pin, edges);
+}
+
+uint64_t gpio_ctx_edge_status(gpio_ctx_t* ctx) {
+    return ctx->ops->edge_status(ctx, GPIO_ALL_PINS_MASK);
+}
+
+uint64_t gpio_ctx_edge_status_mask(gpio_ctx_t* ctx, uint64_t mask) {
+    return ctx->ops->edge_status(ctx, mask & GPIO_ALL_PINS_MASK);
+}
+
+void pin_mode(int pin, int mode) {
+    gpio_ctx_pin_mode(&gpio_ctx_default, pin, mode);
+}
+
+void gpio_set_function(int pin, int function) {
+    gpio_ctx_set_function(&gpio_ctx_default, pin, function);
+}
+
+void digital_write(int pin, int value) {
+    gpio_ctx_write(&gpio_ctx_default, pin, value);
+}
+
+int digital_read(int pin) {
+    return gpio_ctx_read(&gpio_ctx_default, pin);
+}
+
+void gpio_write_mask(uint64_t set_mask, uint64_t clr_mask) {
+    gpio_ctx_write_mask(&gpio_ctx_default, set_mask, clr_mask);
+}
+
+uint64_t gpio_read_all(void) {
+    return gpio_ctx_read_all(&gpio_ctx_default);
+}
+
+void gpio_set_edge_detect(int pin, int edges) {
+    gpio_ctx_set_edge_detect(&gpio_ctx_default, pin, edges);
+}
+
+uint64_t gpio_edge_status(void) {
+    return gpio_ctx_edge_status(&gpio_ctx_default);
+}
+
+uint64_t gpio_edge_status_mask(uint64_t mask) {
+    return gpio_ctx_edge_status_mask(&gpio_ctx_default, mask);
 }
 
 #endif /* RPI_GPIO_IMPLEMENTATION */
@@ -0,0 +1,507 @@
+/**
+ * @file rpi_gpio_bus.h
+ * @brief 8080/6800 parallel buses on arbitrary GPIOs (TFT controllers).
+ *
+ * Single-header library. Define RPI_GPIO_BUS_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h.
+ *
+ * Any 8 or 16 GPIOs, in any order and either bank, form the data lines.
+ * Each byte value has a precomputed store: its 1 bits in the set mask, its
+ * 0 bits in the clear mask, with the write strobe asserted in the same
+ * store. A 16-bit word ORs the store of its low byte with the store of its
+ * high byte (a second table). A bus write is therefore one GPSET and one
+ * GPCLR, which put the data on the pins and assert the strobe, then one
+ * store that releases the strobe, where the controller latches the data.
+ *
+ * 8080 mode strobes WR low (data taken on the rising edge) and holds RD
+ * high. 6800 mode raises E (data taken on the falling edge) with the R/W
+ * pin low. D/C and CS are optional and driven by the helpers below.
+ *
+ * Reads take one GPLEV snapshot (GPLEV0 alone when every data pin is in
+ * bank 0) and gather the data bits out of it. Each byte of the 64-bit
+ * level word that holds data pins has a 256-entry table giving its share
+ * of the word, so a 16-bit read is at most a few lookups ORed together.
+ * Pins wired contiguously and in order (D0 lowest) reduce to a shift and a
+ * mask; pins in order but scattered use PEXT when built for x86 with BMI2.
+ */
+
+#ifndef RPI_GPIO_BUS_H
+#define RPI_GPIO_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Data lines. */
+#define GPIO_BUS_MAX_WIDTH 16
+
+/** Marks an unconnected control pin. */
+#define GPIO_BUS_NO_PIN (-1)
+
+/** @name Bus Modes */
+/**@{*/
+#define GPIO_BUS_8080 0   /**< WR and RD strobes, active low. */
+#define GPIO_BUS_6800 1   /**< E strobe, active high, and R/W. */
+/**@}*/
+
+/** @name Gather Modes */
+/**@{*/
+#define GPIO_BUS_GATHER_LUT   0   /**< Per-byte lookup tables, any wiring. */
+#define GPIO_BUS_GATHER_SHIFT 1   /**< Contiguous pins, D0 lowest. */
+#define GPIO_BUS_GATHER_PEXT  2   /**< Pins in order, BMI2 builds only. */
+/**@}*/
+
+/** Bytes of the 64-bit level word that can hold pins. */
+#define GPIO_BUS_LANES 7
+
+/**
+ * @brief Bus wiring (BCM GPIO numbers).
+ */
+typedef struct {
+    int width;                        /**< 8 or 16. */
+    int data[GPIO_BUS_MAX_WIDTH];     /**< D0 first. */
+    int wr;                           /**< 8080 WR, 6800 E. */
+    int rd;                           /**< 8080 RD, 6800 R/W; may be GPIO_BUS_NO_PIN. */
+    int dc;                           /**< D/C (RS), high = data; may be GPIO_BUS_NO_PIN. */
+    int cs;                           /**< Chip select, active low; may be GPIO_BUS_NO_PIN. */
+} gpio_bus_pins_t;
+
+/**
+ * @brief A bus.
+ */
+typedef struct {
+    gpio_ctx_t* gpio;
+    gpio_bus_pins_t pins;
+    int mode;
+    int slowdown;                   /**< Extra repeats of each store. */
+    uint64_t data_mask;
+    gpio_store_t* lo;               /**< [256] D0-D7 values, strobe asserted. */
+    gpio_store_t* hi;               /**< [256] D8-D15 values (16-bit buses). */
+    gpio_store_t release;           /**< Strobe released. */
+    gpio_store_t read_assert;       /**< RD low (8080) or E high (6800). */
+    gpio_store_t read_release;
+    int input;                      /**< Data pins are inputs. */
+    int gather_mode;
+    int gather_best;                /**< Fastest mode this wiring allows. */
+    int shift;                      /**< GPIO_BUS_GATHER_SHIFT: D0 pin. */
+    int lanes;                      /**< Level bytes holding data pins. */
+    uint8_t lane_shift[GPIO_BUS_LANES];
+    uint16_t* gather;               /**< [lanes][256] share of the word. */
+    int bank1;                      /**< Some data pin is in bank 1. */
+    uint64_t words;                 /**< Bus writes so far. */
+    uint64_t reads;                 /**< Bus reads so far. */
+} gpio_bus_t;
+
+/**
+ * @brief Set up a bus. Data pins become outputs, low; controls go idle
+ * (strobe released, RD/R-W for writing, D/C high, CS high).
+ * @param gpio GPIO context (NULL for gpio_ctx_default).
+ * @param mode GPIO_BUS_8080 or GPIO_BUS_6800.
+ * @return 0 on success, -1 on error.
+ */
+int gpio_bus_init(gpio_bus_t* bus, gpio_ctx_t* gpio, const gpio_bus_pins_t* pins, int mode);
+
+/**
+ * @brief Free the tables.
+ */
+void gpio_bus_free(gpio_bus_t* bus);
+
+/**
+ * @brief Repeat every store @p slowdown extra times (0-8), for controllers
+ * that cannot follow the GPIO at full speed.
+ */
+void gpio_bus_set_slowdown(gpio_bus_t* bus, int slowdown);
+
+/** @name Control Lines */
+/**@{*/
+void gpio_bus_select(gpio_bus_t* bus, int selected);   /**< CS low when selected. */
+void gpio_bus_set_dc(gpio_bus_t* bus, int data);       /**< D/C high for data. */
+/**@}*/
+
+/** @name Writes */
+/**@{*/
+
+/**
+ * @brief One bus write at the current D/C and CS.
+ * @param word Only the low byte is used on an 8-bit bus.
+ */
+void gpio_bus_write(gpio_bus_t* bus, uint16_t word);
+
+/**
+ * @brief Bulk write at the current D/C and CS.
+ * @param data Bytes on an 8-bit bus, uint16_t words on a 16-bit bus.
+ * @param words Number of bus writes.
+ */
+void gpio_bus_write_buffer(gpio_bus_t* bus, const void* data, size_t words);
+
+/**
+ * @brief Selected command transaction: CS low, @p cmd with D/C low, then
+ * @p len parameter bytes with D/C high, CS high.
+ */
+void gpio_bus_command(gpio_bus_t* bus, uint8_t cmd, const uint8_t* params, size_t len);
+/**@}*/
+
+/** @name Reads */
+/**@{*/
+
+/**
+ * @brief Turn the data pins around. In 6800 mode R/W follows (high for
+ * input). Writes are ignored while the pins are inputs.
+ */
+void gpio_bus_set_input(gpio_bus_t* bus, int input);
+
+/**
+ * @brief Choose how bits are gathered (the fastest available is the default).
+ * @return 0 on success, -1 if this wiring or build does not allow @p mode.
+ */
+int gpio_bus_set_gather(gpio_bus_t* bus, int mode);
+
+/**
+ * @brief Extract the bus word from a level snapshot (gpio_ctx_read_all()).
+ */
+uint16_t gpio_bus_gather(const gpio_bus_t* bus, uint64_t levels);
+
+/**
+ * @brief Read the data pins as they are, without a strobe.
+ */
+uint16_t gpio_bus_sample(gpio_bus_t* bus);
+
+/**
+ * @brief Strobe-and-read loop: for each word assert RD (8080) or E (6800),
+ * take one snapshot, release, gather. For controllers, parallel ADCs
+ * clocked from the read strobe and camera-style capture.
+ * @param out Bytes on an 8-bit bus, uint16_t words on a 16-bit bus.
+ * @return Words read, 0 if the bus has no read strobe or is not an input.
+ */
+size_t gpio_bus_read_buffer(gpio_bus_t* bus, void* out, size_t words);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_GPIO_BUS_H */
+
+#ifdef RPI_GPIO_BUS_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * gpio_ctx_write_mask_fast(), repeated @p slowdown extra times on mmap to
+ * hold the levels longer (the other backends are slower than any bus).
+ */
+static inline void gpio_bus_apply(gpio_ctx_t* gpio, uint64_t set, uint64_t clr, int slowdown) {
+    gpio_ctx_write_mask_fast(gpio, set, clr);
+    if (!gpio->regs) return;
+    for (int i = 0; i < slowdown; i++) gpio_ctx_write_mask_fast(gpio, set, clr);
+}
+
+static inline uint64_t gpio_bus_bit(int pin) {
+    return pin == GPIO_BUS_NO_PIN ? 0 : 1ull << pin;
+}
+
+static void gpio_bus_build(gpio_bus_t* bus) {
+    const gpio_bus_pins_t* p = &bus->pins;
+    uint64_t strobe = gpio_bus_bit(p->wr);
+    uint64_t assert_set = bus->mode == GPIO_BUS_6800 ? strobe : 0;
+    uint64_t assert_clr = bus->mode == GPIO_BUS_6800 ? 0 : strobe;
+
+    bus->data_mask = 0;
+    for (int i = 0; i < p->width; i++) bus->data_mask |= 1ull << p->data[i];
+
+    for (int v = 0; v < 256; v++) {
+        gpio_store_t lo = { assert_set, assert_clr };
+        gpio_store_t hi = { 0, 0 };
+        for (int i = 0; i < 8; i++) {
+            uint64_t bit = 1ull << p->data[i];
+            if (v & (1 << i)) lo.set_mask |= bit;
+            else lo.clr_mask |= bit;
+            if (p->width == 16) {
+                bit = 1ull << p->data[8 + i];
+                if (v & (1 << i)) hi.set_mask |= bit;
+                else hi.clr_mask |= bit;
+            }
+        }
+        bus->lo[v] = lo;
+        bus->hi[v] = hi;
+    }
+    bus->release.set_mask = assert_clr;
+    bus->release.clr_mask = assert_set;
+
+    /* Reads strobe RD in 8080 mode and E in 6800 mode */
+    if (bus->mode == GPIO_BUS_6800) {
+        bus->read_assert.set_mask = strobe;
+        bus->read_release.clr_mask = strobe;
+    } else {
+        bus->read_assert.clr_mask = gpio_bus_bit(p->rd);
+        bus->read_release.set_mask = gpio_bus_bit(p->rd);
+    }
+}
+
+/** Gather tables and the fastest mode this wiring allows. */
+static int gpio_bus_build_gather(gpio_bus_t* bus) {
+    const gpio_bus_pins_t* p = &bus->pins;
+    uint8_t lane_of[GPIO_BUS_LANES + 1];
+    memset(lane_of, 0xFF, sizeof(lane_of));
+
+    bus->lanes = 0;
+    for (int i = 0; i < p->width; i++) {
+        int byte = p->data[i] / 8;
+        if (lane_of[byte] == 0xFF) {
+            lane_of[byte] = (uint8_t)bus->lanes;
+            bus->lane_shift[bus->lanes++] = (uint8_t)(byte * 8);
+        }
+        if (p->data[i] >= GPIO_PINS_PER_BANK) bus->bank1 = 1;
+    }
+
+    bus->gather = (uint16_t*)aligned_alloc(64, (size_t)bus->lanes * 256 * sizeof(uint16_t));
+    if (!bus->gather) return -1;
+    memset(bus->gather, 0, (size_t)bus->lanes * 256 * sizeof(uint16_t));
+    for (int i = 0; i < p->width; i++) {
+        uint16_t* table = bus->gather + (size_t)lane_of[p->data[i] / 8] * 256;
+        int bit = p->data[i] % 8;
+        for (int v = 0; v < 256; v++) {
+            if (v & (1 << bit)) table[v] |= (uint16_t)(1u << i);
+        }
+    }
+
+    int contiguous = 1, ordered = 1;
+    for (int i = 1; i < p->width; i++) {
+        if (p->data[i] != p->data[0] + i) contiguous = 0;
+        if (p->data[i] <= p->data[i - 1]) ordered = 0;
+    }
+    bus->shift = p->data[0];
+    bus->gather_best = GPIO_BUS_GATHER_LUT;
+    if (contiguous) bus->gather_best = GPIO_BUS_GATHER_SHIFT;
+#if defined(__BMI2__)
+    else if (ordered) bus->gather_best = GPIO_BUS_GATHER_PEXT;
+#else
+    (void)ordered;
+#endif
+    bus->gather_mode = bus->gather_best;
+    return 0;
+}
+
+int gpio_bus_init(gpio_bus_t* bus, gpio_ctx_t* gpio, const gpio_bus_pins_t* pins, int mode) {
+    if (!bus || !pins) return -1;
+    if ((pins->width != 8 && pins->width != 16) || (mode != GPIO_BUS_8080 && mode != GPIO_BUS_6800)) {
+        fprintf(stderr, "GPIO Bus Error: Invalid width %d or mode %d\n", pins->width, mode);
+        return -1;
+    }
+
+    /* Every pin valid and used once; only the strobe is mandatory. CS goes
+     * first so the controller ignores the other pins becoming outputs */
+    int used[GPIO_BUS_MAX_WIDTH + 4];
+    int n = 0;
+    if (pins->cs != GPIO_BUS_NO_PIN) used[n++] = pins->cs;
+    if (pins->dc != GPIO_BUS_NO_PIN) used[n++] = pins->dc;
+    if (pins->rd != GPIO_BUS_NO_PIN) used[n++] = pins->rd;
+    used[n++] = pins->wr;
+    for (int i = 0; i < pins->width; i++) used[n++] = pins->data[i];
+    uint64_t all = 0;
+    for (int i = 0; i < n; i++) {
+        if (!GPIO_VALID_PIN(used[i]) || (all & (1ull << used[i]))) {
+            fprintf(stderr, "GPIO Bus Error: Invalid or repeated pin %d\n", used[i]);
+            return -1;
+        }
+        all |= 1ull << used[i];
+    }
+
+    memset(bus, 0, sizeof(*bus));
+    bus->lo = (gpio_store_t*)aligned_alloc(64, 2 * 256 * sizeof(gpio_store_t));
+    if (!bus->lo) {
+        perror("GPIO Bus Error: Failed to allocate tables");
+        return -1;
+    }
+    bus->hi = bus->lo + 256;
+    bus->gpio = gpio ? gpio : &gpio_ctx_default;
+    bus->pins = *pins;
+    bus->mode = mode;
+    gpio_bus_build(bus);
+    if (gpio_bus_build_gather(bus) != 0) {
+        perror("GPIO Bus Error: Failed to allocate tables");
+        free(bus->lo);
+        bus->lo = bus->hi = NULL;
+        return -1;
+    }
+
+    /* Idle: strobe released, RD high (8080) or R/W low (6800), D/C and CS high */
+    uint64_t high = bus->release.set_mask | gpio_bus_bit(pins->dc) | gpio_bus_bit(pins->cs);
+    if (mode == GPIO_BUS_8080) high |= gpio_bus_bit(pins->rd);
+    gpio_ctx_write_mask(bus->gpio, high, all & ~high);
+    for (int i = 0; i < n; i++) gpio_ctx_pin_mode(bus->gpio, used[i], OUTPUT);
+    return 0;
+}
+
+void gpio_bus_free(gpio_bus_t* bus) {
+    if (!bus) return;
+    free(bus->lo);
+    free(bus->gather);
+    bus->lo = bus->hi = NULL;
+    bus->gather = NULL;
+}
+
+void gpio_bus_set_slowdown(gpio_bus_t* bus, int slowdown) {
+    if (!bus) return;
+    bus->slowdown = slowdown < 0 ? 0 : (slowdown > 8 ? 8 : slowdown);
+}
+
+/* ============================================================================
+ * CONTROL LINES
+ * ============================================================================ */
+
+void gpio_bus_select(gpio_bus_t* bus, int selected) {
+    if (!bus || bus->pins.cs == GPIO_BUS_NO_PIN) return;
+    uint64_t cs = 1ull << bus->pins.cs;
+    gpio_bus_apply(bus->gpio, selected ? 0 : cs, selected ? cs : 0, bus->slowdown);
+}
+
+void gpio_bus_set_dc(gpio_bus_t* bus, int data) {
+    if (!bus || bus->pins.dc == GPIO_BUS_NO_PIN) return;
+    uint64_t dc = 1ull << bus->pins.dc;
+    gpio_bus_apply(bus->gpio, data ? dc : 0, data ? 0 : dc, bus->slowdown);
+}
+
+/* ============================================================================
+ * WRITES
+ * ============================================================================ */
+
+void gpio_bus_write(gpio_bus_t* bus, uint16_t word) {
+    if (!bus || !bus->lo || bus->input) return;
+    /* The high table is all zero on an 8-bit bus */
+    const gpio_store_t* l = &bus->lo[word & 0xFF];
+    const gpio_store_t* h = &bus->hi[word >> 8];
+    gpio_bus_apply(bus->gpio, l->set_mask | h->set_mask, l->clr_mask | h->clr_mask, bus->slowdown);
+    gpio_bus_apply(bus->gpio, bus->release.set_mask, bus->release.clr_mask, bus->slowdown);
+    bus->words++;
+}
+
+void gpio_bus_write_buffer(gpio_bus_t* bus, const void* data, size_t words) {
+    if (!bus || !bus->lo || !data || bus->input) return;
+    gpio_ctx_t* gpio = bus->gpio;
+    const gpio_store_t* lo = bus->lo;
+    const gpio_store_t release = bus->release;
+    const int slow = bus->slowdown;
+
+    if (bus->pins.width == 8) {
+        const uint8_t* b = (const uint8_t*)data;
+        for (size_t n = 0; n < words; n++) {
+            const gpio_store_t* st = &lo[b[n]];
+            gpio_bus_apply(gpio, st->set_mask, st->clr_mask, slow);
+            gpio_bus_apply(gpio, release.set_mask, release.clr_mask, slow);
+        }
+    } else {
+        const gpio_store_t* hi = bus->hi;
+        const uint16_t* w = (const uint16_t*)data;
+        for (size_t n = 0; n < words; n++) {
+            const gpio_store_t* l = &lo[w[n] & 0xFF];
+            const gpio_store_t* h = &hi[w[n] >> 8];
+            gpio_bus_apply(gpio, l->set_mask | h->set_mask, l->clr_mask | h->clr_mask, slow);
+            gpio_bus_apply(gpio, release.set_mask, release.clr_mask, slow);
+        }
+    }
+    bus->words += words;
+}
+
+void gpio_bus_command(gpio_bus_t* bus, uint8_t cmd, const uint8_t* params, size_t len) {
+    if (!bus || !bus->lo) return;
+    gpio_bus_select(bus, 1);
+    gpio_bus_set_dc(bus, 0);
+    gpio_bus_write(bus, cmd);
+    gpio_bus_set_dc(bus, 1);
+    for (size_t i = 0; params && i < len; i++) gpio_bus_write(bus, params[i]);
+    gpio_bus_select(bus, 0);
+}
+
+/* ============================================================================
+ * READS
+ * ============================================================================ */
+
+void gpio_bus_set_input(gpio_bus_t* bus, int input) {
+    if (!bus || !bus->lo) return;
+    input = input ? 1 : 0;
+    if (bus->mode == GPIO_BUS_6800 && bus->pins.rd != GPIO_BUS_NO_PIN) {
+        uint64_t rw = 1ull << bus->pins.rd;
+        gpio_bus_apply(bus->gpio, input ? rw : 0, input ? 0 : rw, bus->slowdown);
+    }
+    for (int i = 0; i < bus->pins.width; i++) gpio_ctx_pin_mode(bus->gpio, bus->pins.data[i], input ? INPUT : OUTPUT);
+    bus->input = input;
+}
+
+int gpio_bus_set_gather(gpio_bus_t* bus, int mode) {
+    if (!bus || !bus->lo) return -1;
+    if (mode != GPIO_BUS_GATHER_LUT && mode != bus->gather_best) {
+        fprintf(stderr, "GPIO Bus Error: Gather mode %d not available for this wiring\n", mode);
+        return -1;
+    }
+    bus->gather_mode = mode;
+    return 0;
+}
+
+uint16_t gpio_bus_gather(const gpio_bus_t* bus, uint64_t levels) {
+    switch (bus->gather_mode) {
+    case GPIO_BUS_GATHER_SHIFT:
+        return (uint16_t)((levels >> bus->shift) & ((1u << bus->pins.width) - 1));
+#if defined(__BMI2__)
+    case GPIO_BUS_GATHER_PEXT:
+        return (uint16_t)_pext_u64(levels, bus->data_mask);
+#endif
+    default: {
+        uint16_t word = 0;
+        const uint16_t* table = bus->gather;
+        for (int i = 0; i < bus->lanes; i++, table += 256) word |= table[(uint8_t)(levels >> bus->lane_shift[i])];
+        return word;
+    }
+    }
+}
+
+/** One snapshot; a single register read when every data pin is in bank 0. */
+static inline uint64_t gpio_bus_levels(gpio_bus_t* bus) {
+    gpio_ctx_t* gpio = bus->gpio;
+    if (gpio->regs && !bus->bank1) {
+        gpio->stats.reads++;
+        return gpio->regs[GPLEV0];
+    }
+    return gpio_ctx_read_all(gpio);
+}
+
+uint16_t gpio_bus_sample(gpio_bus_t* bus) {
+    if (!bus || !bus->lo) return 0;
+    bus->reads++;
+    return gpio_bus_gather(bus, gpio_bus_levels(bus));
+}
+
+size_t gpio_bus_read_buffer(gpio_bus_t* bus, void* out, size_t words) {
+    if (!bus || !bus->lo || !out) return 0;
+    if (!bus->input || !(bus->read_assert.set_mask | bus->read_assert.clr_mask)) {
+        fprintf(stderr, "GPIO Bus Error: Strobed reads need input data pins and a read strobe\n");
+        return 0;
+    }
+    gpio_ctx_t* gpio = bus->gpio;
+    const gpio_store_t on = bus->read_assert;
+    const gpio_store_t off = bus->read_release;
+    const int slow = bus->slowdown;
+
+    for (size_t n = 0; n < words; n++) {
+        gpio_bus_apply(gpio, on.set_mask, on.clr_mask, slow);
+        uint64_t levels = gpio_bus_levels(bus);
+        gpio_bus_apply(gpio, off.set_mask, off.clr_mask, slow);
+        uint16_t word = gpio_bus_gather(bus, levels);
+        if (bus->pins.width == 16) ((uint16_t*)out)[n] = word;
+        else ((uint8_t*)out)[n] = (uint8_t)word;
+    }
+    bus->reads += words;
+    return words;
+}
+
+#endif /* RPI_GPIO_BUS_IMPLEMENTATION */
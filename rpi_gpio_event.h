@@ -0,0 +1,318 @@
+/**
+ * @file rpi_gpio_event.h
+ * @brief Timestamped GPIO edge events via a pinned poller and lock-free ring.
+ *
+ * Single-header library. Define RPI_GPIO_EVENT_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h, rpi_realtime.h and pthread (-pthread linker flag).
+ *
+ * A poller thread reads the latched GPEDS edge status, turns every set bit
+ * into a (timestamp, pin, edge) record and pushes it into a single-producer,
+ * single-consumer ring. Consumers drain the ring in batches with
+ * gpio_event_read(). Because GPEDS latches in hardware, pulses shorter than
+ * one poll iteration are still reported.
+ *
+ * On hosts without GPIO hardware an event source can be injected with
+ * gpio_event_set_source() to feed the ring from tests.
+ */
+
+#ifndef RPI_GPIO_EVENT_H
+#define RPI_GPIO_EVENT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Ring capacity in events (must be a power of two). */
+#ifndef GPIO_EVENT_RING_SIZE
+#define GPIO_EVENT_RING_SIZE 1024
+#endif
+
+/** Sleep between empty polls when the poller is not pinned to a core. */
+#ifndef GPIO_EVENT_IDLE_US
+#define GPIO_EVENT_IDLE_US 50
+#endif
+
+/** Maximum number of events a source may return per poll. */
+#define GPIO_EVENT_BATCH_MAX 64
+
+/**
+ * @brief A single detected edge.
+ */
+typedef struct {
+    uint64_t timestamp_ns;  /**< CLOCK_MONOTONIC time of detection. */
+    uint8_t  pin;           /**< BCM pin number. */
+    uint8_t  edge;          /**< GPIO_EDGE_RISING or GPIO_EDGE_FALLING. */
+} gpio_event_t;
+
+/**
+ * @brief Event source callback.
+ *
+ * Called once per poll iteration from the poller thread.
+ *
+ * @param user Opaque pointer passed to gpio_event_set_source().
+ * @param out Buffer for new events.
+ * @param max Capacity of @p out (GPIO_EVENT_BATCH_MAX).
+ * @return Number of events written to @p out.
+ */
+typedef int (*gpio_event_source_fn)(void* user, gpio_event_t* out, int max);
+
+/**
+ * @brief Enable edge detection and start the poller thread.
+ * @param pin_mask Bit n selects BCM pin n.
+ * @param edges GPIO_EDGE_* flags applied to every selected pin.
+ * @param core_id CPU core for the poller (busy-polls), or -1 to sleep between polls.
+ * @return 0 on success, -1 on error.
+ */
+int gpio_event_start(uint64_t pin_mask, int edges, int core_id);
+
+/**
+ * @brief Stop the poller thread and disable edge detection.
+ */
+void gpio_event_stop(void);
+
+/**
+ * @brief Run a single poll iteration on the calling thread.
+ *
+ * Use instead of gpio_event_start() to drive polling from your own loop.
+ * Must not be called while the poller thread is running.
+ *
+ * @return Number of events pushed into the ring.
+ */
+int gpio_event_poll(void);
+
+/**
+ * @brief Dequeue up to @p max events without blocking.
+ * @param events Output buffer.
+ * @param max Capacity of @p events.
+ * @return Number of events dequeued (0 if the ring is empty).
+ */
+int gpio_event_read(gpio_event_t* events, int max);
+
+/**
+ * @brief Dequeue events, waiting until at least one is available.
+ * @param events Output buffer.
+ * @param max Capacity of @p events.
+ * @param timeout_us Maximum wait in microseconds.
+ * @return Number of events dequeued (0 on timeout).
+ */
+int gpio_event_wait(gpio_event_t* events, int max, uint64_t timeout_us);
+
+/**
+ * @brief Number of events discarded because the ring was full.
+ */
+uint64_t gpio_event_dropped(void);
+
+/**
+ * @brief Replace the event source (NULL restores the GPEDS source).
+ * @param fn Source callback.
+ * @param user Opaque pointer passed to @p fn.
+ */
+void gpio_event_set_source(gpio_event_source_fn fn, void* user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_GPIO_EVENT_H */
+
+#ifdef RPI_GPIO_EVENT_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GPIO_EVENT_RING_MASK (GPIO_EVENT_RING_SIZE - 1)
+
+#if (GPIO_EVENT_RING_SIZE & GPIO_EVENT_RING_MASK) != 0
+    #error "GPIO_EVENT_RING_SIZE must be a power of two"
+#endif
+
+/*
+ * Producer and consumer indices live on separate cache lines so the poller
+ * and the reader do not bounce the same line between cores.
+ */
+static struct {
+    _Alignas(64) atomic_uint_fast32_t head;   /**< Written by producer. */
+    _Alignas(64) atomic_uint_fast32_t tail;   /**< Written by consumer. */
+    _Alignas(64) atomic_uint_fast64_t dropped;
+    gpio_event_t slots[GPIO_EVENT_RING_SIZE];
+} gpio_event_ring;
+
+static gpio_event_source_fn gpio_event_source = NULL;
+static void* gpio_event_source_user = NULL;
+static uint64_t gpio_event_pins = 0;
+static int gpio_event_edges = GPIO_EDGE_NONE;
+static int gpio_event_core = -1;
+static pthread_t gpio_event_thread;
+static atomic_bool gpio_event_running = false;
+
+static uint64_t gpio_event_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Default source: GPEDS tells which pins fired, not in which direction.
+ * If only one edge kind is enabled it is reported as-is; otherwise the
+ * current level decides (a pulse shorter than the poll reads as its
+ * trailing edge).
+ */
+static int gpio_event_gpeds_source(void* user, gpio_event_t* out, int max) {
+    (void)user;
+    uint64_t status = gpio_edge_status_mask(gpio_event_pins);
+    if (!status) return 0;
+
+    uint64_t levels = gpio_read_all();
+    uint64_t ts = gpio_event_now_ns();
+    int rising_only = (gpio_event_edges & (GPIO_EDGE_RISING | GPIO_EDGE_ASYNC_RISING)) &&
+                      !(gpio_event_edges & (GPIO_EDGE_FALLING | GPIO_EDGE_ASYNC_FALLING));
+    int falling_only = (gpio_event_edges & (GPIO_EDGE_FALLING | GPIO_EDGE_ASYNC_FALLING)) &&
+                       !(gpio_event_edges & (GPIO_EDGE_RISING | GPIO_EDGE_ASYNC_RISING));
+
+    int n = 0;
+    while (status && n < max) {
+        int pin = __builtin_ctzll(status);
+        status &= status - 1;
+
+        out[n].timestamp_ns = ts;
+        out[n].pin = (uint8_t)pin;
+        if (rising_only) {
+            out[n].edge = GPIO_EDGE_RISING;
+        } else if (falling_only) {
+            out[n].edge = GPIO_EDGE_FALLING;
+        } else {
+            out[n].edge = ((levels >> pin) & 1) ? GPIO_EDGE_RISING : GPIO_EDGE_FALLING;
+        }
+        n++;
+    }
+    return n;
+}
+
+static void gpio_event_push(const gpio_event_t* events, int n) {
+    uint_fast32_t head = atomic_load_explicit(&gpio_event_ring.head, memory_order_relaxed);
+    uint_fast32_t tail = atomic_load_explicit(&gpio_event_ring.tail, memory_order_acquire);
+    uint_fast32_t space = GPIO_EVENT_RING_SIZE - (uint_fast32_t)(head - tail);
+
+    int accepted = n < (int)space ? n : (int)space;
+    for (int i = 0; i < accepted; i++) {
+        gpio_event_ring.slots[(head + i) & GPIO_EVENT_RING_MASK] = events[i];
+    }
+    atomic_store_explicit(&gpio_event_ring.head, head + accepted, memory_order_release);
+
+    if (accepted < n) {
+        atomic_fetch_add_explicit(&gpio_event_ring.dropped, (uint64_t)(n - accepted),
+                                  memory_order_relaxed);
+    }
+}
+
+int gpio_event_poll(void) {
+    gpio_event_t batch[GPIO_EVENT_BATCH_MAX];
+    gpio_event_source_fn source = gpio_event_source ? gpio_event_source : gpio_event_gpeds_source;
+
+    int n = source(gpio_event_source_user, batch, GPIO_EVENT_BATCH_MAX);
+    if (n <= 0) return 0;
+    if (n > GPIO_EVENT_BATCH_MAX) n = GPIO_EVENT_BATCH_MAX;
+
+    gpio_event_push(batch, n);
+    return n;
+}
+
+static void* gpio_event_thread_func(void* arg) {
+    (void)arg;
+    if (gpio_event_core >= 0) {
+        pin_to_core(gpio_event_core);
+    }
+
+    while (atomic_load_explicit(&gpio_event_running, memory_order_relaxed)) {
+        if (gpio_event_poll() == 0 && gpio_event_core < 0) {
+            usleep(GPIO_EVENT_IDLE_US);
+        }
+    }
+    return NULL;
+}
+
+int gpio_event_start(uint64_t pin_mask, int edges, int core_id) {
+    if (atomic_load(&gpio_event_running)) {
+        fprintf(stderr, "GPIO Event Error: Poller already running\n");
+        return -1;
+    }
+
+    gpio_event_pins = pin_mask;
+    gpio_event_edges = edges;
+    gpio_event_core = core_id;
+
+    atomic_store(&gpio_event_ring.head, 0);
+    atomic_store(&gpio_event_ring.tail, 0);
+    atomic_store(&gpio_event_ring.dropped, 0);
+
+    for (int pin = GPIO_PIN_MIN; pin <= GPIO_PIN_MAX; pin++) {
+        if (pin_mask & (1ull << pin)) {
+            gpio_set_edge_detect(pin, edges);
+        }
+    }
+
+    atomic_store(&gpio_event_running, true);
+    if (pthread_create(&gpio_event_thread, NULL, gpio_event_thread_func, NULL) != 0) {
+        perror("GPIO Event Error: Failed to create thread");
+        atomic_store(&gpio_event_running, false);
+        return -1;
+    }
+    return 0;
+}
+
+void gpio_event_stop(void) {
+    if (!atomic_load(&gpio_event_running)) return;
+
+    atomic_store(&gpio_event_running, false);
+    pthread_join(gpio_event_thread, NULL);
+
+    for (int pin = GPIO_PIN_MIN; pin <= GPIO_PIN_MAX; pin++) {
+        if (gpio_event_pins & (1ull << pin)) {
+            gpio_set_edge_detect(pin, GPIO_EDGE_NONE);
+        }
+    }
+    gpio_event_pins = 0;
+}
+
+int gpio_event_read(gpio_event_t* events, int max) {
+    if (!events || max <= 0) return 0;
+
+    uint_fast32_t tail = atomic_load_explicit(&gpio_event_ring.tail, memory_order_relaxed);
+    uint_fast32_t head = atomic_load_explicit(&gpio_event_ring.head, memory_order_acquire);
+    int available = (int)(head - tail);
+    int n = available < max ? available : max;
+
+    for (int i = 0; i < n; i++) {
+        events[i] = gpio_event_ring.slots[(tail + i) & GPIO_EVENT_RING_MASK];
+    }
+    atomic_store_explicit(&gpio_event_ring.tail, tail + n, memory_order_release);
+    return n;
+}
+
+int gpio_event_wait(gpio_event_t* events, int max, uint64_t timeout_us) {
+    uint64_t deadline = gpio_event_now_ns() + timeout_us * 1000ull;
+    for (;;) {
+        int n = gpio_event_read(events, max);
+        if (n > 0 || gpio_event_now_ns() >= deadline) return n;
+        usleep(GPIO_EVENT_IDLE_US);
+    }
+}
+
+uint64_t gpio_event_dropped(void) {
+    return atomic_load_explicit(&gpio_event_ring.dropped, memory_order_relaxed);
+}
+
+void gpio_event_set_source(gpio_event_source_fn fn, void* user) {
+    gpio_event_source = fn;
+    gpio_event_source_user = user;
+}
+
+#endif /* RPI_GPIO_EVENT_IMPLEMENTATION */
@@ -0,0 +1,533 @@
+/**
+ * @file rpi_gpiochip.h
+ * @brief GPIO access through the Linux character device (gpiochip v2 uAPI).
+ *
+ * Single-header library. Define RPI_GPIOCHIP_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h and rpi_gpio_event.h (for gpio_event_t only).
+ *
+ * Alternative to the /dev/gpiomem mmap path that cooperates with kernel
+ * drivers and delivers kernel-timestamped edge events. Lines are requested
+ * in batches (up to 64 per request); values are written and read for the
+ * whole batch with one ioctl, and events are drained with one read() per
+ * batch.
+ *
+ * All syscalls go through a replaceable I/O table (gpiochip_set_io()) so
+ * host tests and benchmarks can run against a fake chip.
+ *
+ * Including the implementation also registers GPIO_BACKEND_GPIOCHIP, so
+ * gpio_init_backend(GPIO_BACKEND_GPIOCHIP) routes pin_mode(), digital_write()
+ * and friends through the character device.
+ */
+
+#ifndef RPI_GPIOCHIP_H
+#define RPI_GPIOCHIP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <poll.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default character device (BCM2711 GPIO bank, line offset == BCM pin). */
+#define GPIOCHIP_DEFAULT_PATH "/dev/gpiochip0"
+
+/** Maximum lines per request (GPIO_V2_LINES_MAX). */
+#define GPIOCHIP_LINES_MAX 64
+
+/** Consumer label reported to the kernel. */
+#define GPIOCHIP_CONSUMER "rpi-toolkit"
+
+/**
+ * @brief A batch of requested lines sharing one request fd.
+ */
+typedef struct {
+    int fd;                                   /**< Line request fd, -1 if released. */
+    int num_lines;                            /**< Number of valid offsets. */
+    uint64_t output_mask;                     /**< Bit i set if line i is an output. */
+    unsigned int offsets[GPIOCHIP_LINES_MAX]; /**< Chip line offsets (BCM pins). */
+} gpiochip_lines_t;
+
+/**
+ * @brief Syscall table used by the backend.
+ *
+ * Replace with gpiochip_set_io() to run against a fake chip.
+ */
+typedef struct {
+    int     (*open)(const char* path, int flags);
+    int     (*close)(int fd);
+    int     (*ioctl)(int fd, unsigned long request, void* arg);
+    ssize_t (*read)(int fd, void* buf, size_t count);
+    int     (*poll)(struct pollfd* fds, nfds_t nfds, int timeout_ms);
+} gpiochip_io_t;
+
+/**
+ * @brief Open the GPIO character device used by later requests.
+ * @param path Device path, or NULL for GPIOCHIP_DEFAULT_PATH.
+ * @return 0 on success, -1 on error.
+ */
+int gpiochip_init(const char* path);
+
+/**
+ * @brief Close the character device.
+ */
+void gpiochip_cleanup(void);
+
+/**
+ * @brief Request a batch of lines with one GPIO_V2_GET_LINE_IOCTL.
+ * @param lines Output: request handle.
+ * @param pins BCM pin numbers (chip line offsets).
+ * @param num_pins Number of pins (1-64).
+ * @param output_mask Bit i set makes pins[i] an output (driven low initially).
+ * @param edges GPIO_EDGE_RISING / GPIO_EDGE_FALLING for input lines, or GPIO_EDGE_NONE.
+ * @return 0 on success, -1 on error.
+ */
+int gpiochip_request_lines(gpiochip_lines_t* lines, const int* pins, int num_pins,
+                           uint64_t output_mask, int edges);
+
+/**
+ * @brief Release a line request.
+ * @param lines Request handle.
+ */
+void gpiochip_release_lines(gpiochip_lines_t* lines);
+
+/**
+ * @brief Set output values for several lines with one ioctl.
+ * @param lines Request handle.
+ * @param mask Bit i selects line i of the request.
+ * @param bits Bit i is the new value of line i.
+ * @return 0 on success, -1 on error.
+ */
+int gpiochip_set_values(gpiochip_lines_t* lines, uint64_t mask, uint64_t bits);
+
+/**
+ * @brief Read values for several lines with one ioctl.
+ * @param lines Request handle.
+ * @param mask Bit i selects line i of the request.
+ * @param bits Output: bit i is the value of line i.
+ * @return 0 on success, -1 on error.
+ */
+int gpiochip_get_values(gpiochip_lines_t* lines, uint64_t mask, uint64_t* bits);
+
+/**
+ * @brief Drain pending edge events with batched read() calls.
+ * @param lines Request handle (lines requested with edges).
+ * @param events Output buffer.
+ * @param max Capacity of @p events.
+ * @param timeout_ms Time to wait for the first event (0 = do not wait, -1 = forever).
+ * @return Number of events stored, or -1 on error.
+ */
+int gpiochip_read_events(gpiochip_lines_t* lines, gpio_event_t* events, int max, int timeout_ms);
+
+/**
+ * @brief gpio_event_source_fn adapter feeding kernel events into rpi_gpio_event.h.
+ *
+ * Pass with the request handle as @p user:
+ * gpio_event_set_source(gpiochip_event_source, &lines);
+ */
+int gpiochip_event_source(void* user, gpio_event_t* out, int max);
+
+/**
+ * @brief Index of a BCM pin within a request.
+ * @return Line index, or -1 if the pin is not part of the request.
+ */
+int gpiochip_line_index(const gpiochip_lines_t* lines, int pin);
+
+/**
+ * @brief Replace the syscall table (NULL restores the real syscalls).
+ * @param io Table to use; must outlive all gpiochip calls.
+ */
+void gpiochip_set_io(const gpiochip_io_t* io);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_GPIOCHIP_H */
+
+#ifdef RPI_GPIOCHIP_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+/** Events drained per read() call. */
+#define GPIOCHIP_READ_BATCH 16
+
+/** Poll timeout used by gpiochip_event_source() so the poller can stop. */
+#define GPIOCHIP_EVENT_POLL_MS 10
+
+static int gpiochip_sys_open(const char* path, int flags) { return open(path, flags); }
+static int gpiochip_sys_ioctl(int fd, unsigned long request, void* arg) { return ioctl(fd, request, arg); }
+
+static const gpiochip_io_t gpiochip_sys_io = {
+    gpiochip_sys_open, close, gpiochip_sys_ioctl, read, poll
+};
+
+static const gpiochip_io_t* gpiochip_io = &gpiochip_sys_io;
+static int gpiochip_fd = -1;
+
+void gpiochip_set_io(const gpiochip_io_t* io) {
+    gpiochip_io = io ? io : &gpiochip_sys_io;
+}
+
+int gpiochip_init(const char* path) {
+    if (gpiochip_fd >= 0) return 0;
+    if (!path) path = GPIOCHIP_DEFAULT_PATH;
+
+    gpiochip_fd = gpiochip_io->open(path, O_RDWR | O_CLOEXEC);
+    if (gpiochip_fd < 0) {
+        perror("Can't open GPIO character device");
+        return -1;
+    }
+    return 0;
+}
+
+void gpiochip_cleanup(void) {
+    if (gpiochip_fd >= 0) {
+        gpiochip_io->close(gpiochip_fd);
+        gpiochip_fd = -1;
+    }
+}
+
+/**
+ * Issue one GPIO_V2_GET_LINE_IOCTL. Masks are indexed by line position:
+ * outputs start at @p output_values, inputs get edge detection per mask.
+ */
+static int gpiochip_request_masks(gpiochip_lines_t* lines, const int* pins, int num_pins,
+                                  uint64_t output_mask, uint64_t output_values,
+                                  uint64_t rising_mask, uint64_t falling_mask) {
+    if (!lines || !pins) return -1;
+    lines->fd = -1;
+    lines->num_lines = 0;
+
+    if (gpiochip_fd < 0 || num_pins <= 0 || num_pins > GPIOCHIP_LINES_MAX) return -1;
+
+    struct gpio_v2_line_request req;
+    memset(&req, 0, sizeof(req));
+    strncpy(req.consumer, GPIOCHIP_CONSUMER, sizeof(req.consumer) - 1);
+    req.num_lines = (uint32_t)num_pins;
+
+    for (int i = 0; i < num_pins; i++) {
+        if (!GPIO_VALID_PIN(pins[i])) return -1;
+        req.offsets[i] = (uint32_t)pins[i];
+    }
+    if (num_pins < GPIOCHIP_LINES_MAX) {
+        output_mask &= (1ull << num_pins) - 1;
+    }
+    rising_mask &= ~output_mask;
+    falling_mask &= ~output_mask;
+
+    /* Default flags apply to plain inputs; everything else is an attribute */
+    req.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+
+    struct {
+        uint64_t mask;
+        uint64_t flags;
+    } groups[] = {
+        { output_mask, GPIO_V2_LINE_FLAG_OUTPUT },
+        { rising_mask & ~falling_mask, GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING },
+        { falling_mask & ~rising_mask, GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_FALLING },
+        { rising_mask & falling_mask, GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING |
+                                      GPIO_V2_LINE_FLAG_EDGE_FALLING },
+    };
+
+    for (int g = 0; g < (int)(sizeof(groups) / sizeof(groups[0])); g++) {
+        if (!groups[g].mask) continue;
+        struct gpio_v2_line_config_attribute* attr = &req.config.attrs[req.config.num_attrs++];
+        attr->attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+        attr->attr.flags = groups[g].flags;
+        attr->mask = groups[g].mask;
+    }
+
+    if (output_mask) {
+        struct gpio_v2_line_config_attribute* attr = &req.config.attrs[req.config.num_attrs++];
+        attr->attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        attr->attr.values = output_values & output_mask;
+        attr->mask = output_mask;
+    }
+
+    if (gpiochip_io->ioctl(gpiochip_fd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+        perror("GPIO_V2_GET_LINE_IOCTL failed");
+        return -1;
+    }
+
+    lines->fd = req.fd;
+    lines->num_lines = num_pins;
+    lines->output_mask = output_mask;
+    for (int i = 0; i < num_pins; i++) {
+        lines->offsets[i] = (unsigned int)pins[i];
+    }
+    return 0;
+}
+
+int gpiochip_request_lines(gpiochip_lines_t* lines, const int* pins, int num_pins,
+                           uint64_t output_mask, int edges) {
+    uint64_t all = num_pins >= GPIOCHIP_LINES_MAX ? ~0ull : (1ull << (num_pins > 0 ? num_pins : 0)) - 1;
+    uint64_t rising = (edges & (GPIO_EDGE_RISING | GPIO_EDGE_ASYNC_RISING)) ? all : 0;
+    uint64_t falling = (edges & (GPIO_EDGE_FALLING | GPIO_EDGE_ASYNC_FALLING)) ? all : 0;
+    return gpiochip_request_masks(lines, pins, num_pins, output_mask, 0, rising, falling);
+}
+
+void gpiochip_release_lines(gpiochip_lines_t* lines) {
+    if (!lines || lines->fd < 0) return;
+    gpiochip_io->close(lines->fd);
+    lines->fd = -1;
+    lines->num_lines = 0;
+}
+
+int gpiochip_set_values(gpiochip_lines_t* lines, uint64_t mask, uint64_t bits) {
+    if (!lines || lines->fd < 0) return -1;
+
+    struct gpio_v2_line_values vals;
+    vals.mask = mask & lines->output_mask;
+    vals.bits = bits;
+    if (!vals.mask) return 0;
+
+    return gpiochip_io->ioctl(lines->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &vals) < 0 ? -1 : 0;
+}
+
+int gpiochip_get_values(gpiochip_lines_t* lines, uint64_t mask, uint64_t* bits) {
+    if (!lines || lines->fd < 0 || !bits) return -1;
+
+    struct gpio_v2_line_values vals;
+    vals.mask = mask;
+    vals.bits = 0;
+
+    if (gpiochip_io->ioctl(lines->fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &vals) < 0) return -1;
+    *bits = vals.bits & mask;
+    return 0;
+}
+
+int gpiochip_read_events(gpiochip_lines_t* lines, gpio_event_t* events, int max, int timeout_ms) {
+    if (!lines || lines->fd < 0 || !events || max <= 0) return -1;
+
+    struct pollfd pfd = { .fd = lines->fd, .events = POLLIN, .revents = 0 };
+    int ready = gpiochip_io->poll(&pfd, 1, timeout_ms);
+    if (ready < 0) return errno == EINTR ? 0 : -1;
+    if (ready == 0) return 0;
+
+    struct gpio_v2_line_event raw[GPIOCHIP_READ_BATCH];
+    int total = 0;
+
+    while (total < max) {
+        int want = max - total < GPIOCHIP_READ_BATCH ? max - total : GPIOCHIP_READ_BATCH;
+        ssize_t got = gpiochip_io->read(lines->fd, raw, (size_t)want * sizeof(raw[0]));
+        if (got <= 0) break;
+
+        int n = (int)(got / (ssize_t)sizeof(raw[0]));
+        for (int i = 0; i < n; i++) {
+            events[total + i].timestamp_ns = raw[i].timestamp_ns;
+            events[total + i].pin = (uint8_t)raw[i].offset;
+            events[total + i].edge = raw[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE
+                                     ? GPIO_EDGE_RISING : GPIO_EDGE_FALLING;
+        }
+        total += n;
+
+        /* A short read means the kernel FIFO is drained */
+        if (n < want) break;
+        pfd.revents = 0;
+        if (gpiochip_io->poll(&pfd, 1, 0) <= 0) break;
+    }
+    return total;
+}
+
+int gpiochip_event_source(void* user, gpio_event_t* out, int max) {
+    int n = gpiochip_read_events((gpiochip_lines_t*)user, out, max, GPIOCHIP_EVENT_POLL_MS);
+    return n < 0 ? 0 : n;
+}
+
+int gpiochip_line_index(const gpiochip_lines_t* lines, int pin) {
+    if (!lines) return -1;
+    for (int i = 0; i < lines->num_lines; i++) {
+        if ((int)lines->offsets[i] == pin) return i;
+    }
+    return -1;
+}
+
+/* ---------------------------------------------------------------------------
+ * GPIO_BACKEND_GPIOCHIP for rpi_gpio.h
+ *
+ * Keeps one line request per context covering every pin configured through
+ * pin_mode(). Changing a pin's direction re-requests the whole set
+ * (setup-time cost); writes and reads then cost one ioctl per bank access.
+ * Alternate functions and level detection are not available through the
+ * character device. Contexts share the chip fd.
+ * ---------------------------------------------------------------------------*/
+typedef struct {
+    gpiochip_lines_t lines;
+    uint64_t outputs;        /**< Pins configured as outputs. */
+    uint64_t inputs;         /**< Pins configured as inputs. */
+    uint64_t values;         /**< Last written output values by pin. */
+    uint64_t rising;         /**< Pins with rising edge detection. */
+    uint64_t falling;        /**< Pins with falling edge detection. */
+    uint64_t latched;        /**< Drained events not yet read (outside the mask). */
+} gpiochip_backend_t;
+
+static int gpiochip_backend_users = 0;
+
+static int gpiochip_backend_rerequest(gpiochip_backend_t* b) {
+    gpiochip_release_lines(&b->lines);
+
+    uint64_t pins_mask = b->outputs | b->inputs;
+    if (!pins_mask) return 0;
+
+    int pins[GPIOCHIP_LINES_MAX];
+    uint64_t out = 0, vals = 0, rise = 0, fall = 0;
+    int n = 0;
+    for (int pin = GPIO_PIN_MIN; pin <= GPIO_PIN_MAX; pin++) {
+        uint64_t bit = 1ull << pin;
+        if (!(pins_mask & bit)) continue;
+        if (b->outputs & bit) out |= 1ull << n;
+        if (b->values & bit) vals |= 1ull << n;
+        if (b->rising & bit) rise |= 1ull << n;
+        if (b->falling & bit) fall |= 1ull << n;
+        pins[n++] = pin;
+    }
+    return gpiochip_request_masks(&b->lines, pins, n, out, vals, rise, fall);
+}
+
+/** Convert a pin mask of one bank into a line-index mask. */
+static uint64_t gpiochip_backend_pins_to_lines(const gpiochip_backend_t* b, int bank,
+                                               uint32_t pin_mask) {
+    uint64_t lines_mask = 0;
+    const gpiochip_lines_t* l = &b->lines;
+    for (int i = 0; i < l->num_lines && pin_mask; i++) {
+        int pin = (int)l->offsets[i];
+        if (GPIO_BANK(pin) == bank && (pin_mask & (1u << GPIO_BIT(pin)))) {
+            lines_mask |= 1ull << i;
+        }
+    }
+    return lines_mask;
+}
+
+static int gpiochip_backend_init(gpio_ctx_t* ctx) {
+    gpiochip_backend_t* b = (gpiochip_backend_t*)calloc(1, sizeof(gpiochip_backend_t));
+    if (!b) {
+        perror("GPIO Error: Failed to allocate gpiochip state");
+        return -1;
+    }
+    if (gpiochip_init(NULL) != 0) {
+        free(b);
+        return -1;
+    }
+    b->lines.fd = -1;
+    ctx->state = b;
+    gpiochip_backend_users++;
+    return 0;
+}
+
+static void gpiochip_backend_cleanup(gpio_ctx_t* ctx) {
+    gpiochip_backend_t* b = (gpiochip_backend_t*)ctx->state;
+    gpiochip_release_lines(&b->lines);
+    free(b);
+    ctx->state = NULL;
+    if (--gpiochip_backend_users == 0) {
+        gpiochip_cleanup();
+    }
+}
+
+static void gpiochip_backend_set_function(gpio_ctx_t* ctx, int pin, int function) {
+    gpiochip_backend_t* b = (gpiochip_backend_t*)ctx->state;
+    uint64_t bit = 1ull << pin;
+    uint64_t outputs = b->outputs & ~bit;
+    uint64_t inputs = b->inputs & ~bit;
+
+    if (function == OUTPUT) {
+        outputs |= bit;
+    } else if (function == INPUT) {
+        inputs |= bit;
+    } else {
+        fprintf(stderr, "GPIO Warning: gpiochip backend cannot select ALT functions (pin %d)\n", pin);
+    }
+
+    if (outputs == b->outputs && inputs == b->inputs) return;
+    b->outputs = outputs;
+    b->inputs = inputs;
+    gpiochip_backend_rerequest(b);
+}
+
+static void gpiochip_backend_write_bank(gpio_ctx_t* ctx, int bank, uint32_t set_mask,
+                                        uint32_t clr_mask) {
+    gpiochip_backend_t* b = (gpiochip_backend_t*)ctx->state;
+    int shift = bank * GPIO_PINS_PER_BANK;
+    b->values |= (uint64_t)set_mask << shift;
+    b->values &= ~((uint64_t)clr_mask << shift);
+
+    uint64_t mask = gpiochip_backend_pins_to_lines(b, bank, set_mask | clr_mask);
+    uint64_t bits = gpiochip_backend_pins_to_lines(b, bank, set_mask);
+    gpiochip_set_values(&b->lines, mask, bits);
+}
+
+static uint32_t gpiochip_backend_read_bank(gpio_ctx_t* ctx, int bank) {
+    gpiochip_backend_t* b = (gpiochip_backend_t*)ctx->state;
+    const gpiochip_lines_t* l = &b->lines;
+    uint64_t mask = gpiochip_backend_pins_to_lines(b, bank, 0xFFFFFFFFu);
+    uint64_t bits = 0;
+    if (!mask || gpiochip_get_values(&b->lines, mask, &bits) != 0) return 0;
+
+    uint32_t level = 0;
+    for (int i = 0; i < l->num_lines; i++) {
+        if (bits & (1ull << i)) level |= 1u << GPIO_BIT((int)l->offsets[i]);
+    }
+    return level;
+}
+
+static void gpiochip_backend_set_edge_detect(gpio_ctx_t* ctx, int pin, int edges) {
+    gpiochip_backend_t* b = (gpiochip_backend_t*)ctx->state;
+    uint64_t bit = 1ull << pin;
+    uint64_t rising = b->rising & ~bit;
+    uint64_t falling = b->falling & ~bit;
+
+    if (edges & (GPIO_EDGE_RISING | GPIO_EDGE_ASYNC_RISING)) rising |= bit;
+    if (edges & (GPIO_EDGE_FALLING | GPIO_EDGE_ASYNC_FALLING)) falling |= bit;
+
+    if (rising == b->rising && falling == b->falling) return;
+    b->rising = rising;
+    b->falling = falling;
+    if (!(b->outputs & bit)) {
+        b->inputs |= bit;
+    }
+    gpiochip_backend_rerequest(b);
+}
+
+static uint64_t gpiochip_backend_edge_status(gpio_ctx_t* ctx, uint64_t mask) {
+    gpiochip_backend_t* b = (gpiochip_backend_t*)ctx->state;
+    gpio_event_t events[GPIOCHIP_READ_BATCH];
+    uint64_t status = b->latched;
+    int n;
+    while ((n = gpiochip_read_events(&b->lines, events, GPIOCHIP_READ_BATCH, 0)) > 0) {
+        for (int i = 0; i < n; i++) {
+            status |= 1ull << events[i].pin;
+        }
+    }
+    b->latched = status & ~mask;
+    return status & mask;
+}
+
+static const gpio_backend_ops_t gpiochip_backend_ops = {
+    "gpiochip",
+    gpiochip_backend_init,
+    gpiochip_backend_cleanup,
+    gpiochip_backend_set_function,
+    gpiochip_backend_write_bank,
+    gpiochip_backend_read_bank,
+    gpiochip_backend_set_edge_detect,
+    gpiochip_backend_edge_status
+};
+
+__attribute__((constructor))
+static void gpiochip_backend_register(void) {
+    gpio_register_backend(GPIO_BACKEND_GPIOCHIP, &gpiochip_backend_ops);
+}
+
+#endif /* RPI_GPIOCHIP_IMPLEMENTATION */
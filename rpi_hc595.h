@@ -0,0 +1,446 @@
+/**
+ * @file rpi_hc595.h
+ * @brief 74HC595 shift-register chains driven from a byte buffer.
+ *
+ * Single-header library. Define RPI_HC595_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h, rpi_realtime.h and pthread (-pthread linker flag).
+ *
+ * A chain of N registers is one buffer of N bytes, byte 0 being the
+ * register wired to the Pi (shifted out last) and bit 7 of each byte its
+ * QH output. The 595 samples SER on the rising edge of SRCLK, so the store
+ * that drops SRCLK also sets up the next SER level, and the one that
+ * raises it carries nothing else. For every byte value the eight falling
+ * edge stores are built once at init, with SER left out wherever the bit
+ * repeats the one before it. RCLK is pulsed once after the whole chain, so
+ * the outputs change together.
+ *
+ * hc595_start() refreshes the chain from a background thread at a fixed
+ * rate on absolute deadlines (for multiplexed LED matrices, or to restore
+ * outputs after noise on long relay cables). It shifts out the front buffer;
+ * the caller edits the back buffer and publishes it with hc595_swap(),
+ * which the thread picks up at its next refresh, so a frame is never shown
+ * half written.
+ */
+
+#ifndef RPI_HC595_H
+#define RPI_HC595_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Registers per chain. */
+#define HC595_MAX_LENGTH 4096
+
+/** Final part of each refresh wait that is spun instead of slept. */
+#ifndef HC595_SPIN_NS
+#define HC595_SPIN_NS 50000
+#endif
+
+/** Poll interval of hc595_swap() while the thread has not taken a frame. */
+#define HC595_SWAP_POLL_US 20
+
+/**
+ * @brief Refresh counters.
+ */
+typedef struct {
+    uint64_t frames;          /**< Chain shifted and latched. */
+    uint64_t swaps;           /**< Back buffers taken by the thread. */
+    uint64_t missed;          /**< Refresh ticks skipped because the thread was late. */
+    uint64_t max_late_ns;     /**< Worst wake-up lateness. */
+    uint64_t last_frame_ns;   /**< Time of the last shift + latch. */
+    uint64_t start_ns;
+    uint64_t end_ns;
+} hc595_stats_t;
+
+/**
+ * @brief A chain.
+ */
+typedef struct {
+    gpio_ctx_t* gpio;
+    int ser;
+    int srclk;
+    int rclk;
+    size_t length;             /**< Registers (bytes). */
+    uint32_t half_period_ns;   /**< 0 = no delay. */
+    gpio_store_t* table;       /**< [byte * 8 + bit] data stores, MSB first. */
+    gpio_store_t clock;        /**< SRCLK rising edge. */
+    gpio_store_t latch;        /**< RCLK rising edge. */
+    gpio_store_t idle;         /**< RCLK and SRCLK low. */
+    uint8_t* buf[2];
+    int front;                 /**< Buffer shifted by the refresh thread. */
+    int pending;               /**< Back buffer published, not yet taken. */
+    uint64_t bytes;            /**< Bytes shifted out. */
+    hc595_stats_t stats;
+    uint64_t period_ns;
+    pthread_t thread;
+    int running;
+    int realtime;              /**< Refresh thread got SCHED_FIFO. */
+    int core_id;
+} hc595_t;
+
+/**
+ * @brief Set up a chain. Pins become outputs, low; both buffers start
+ * zeroed and the chain is cleared.
+ * @param gpio GPIO context (NULL for gpio_ctx_default).
+ * @param length Registers in the chain (1-HC595_MAX_LENGTH).
+ * @return 0 on success, -1 on error.
+ */
+int hc595_init(hc595_t* chain, gpio_ctx_t* gpio, int ser, int srclk, int rclk, size_t length);
+
+/**
+ * @brief Stop the refresh thread and free the table and buffers.
+ */
+void hc595_free(hc595_t* chain);
+
+/**
+ * @brief Set the SRCLK frequency.
+ * @param hz Clock in Hz, 0 for as fast as the GPIO backend allows.
+ * @return The frequency actually used (rounded to a whole half period in ns).
+ */
+uint32_t hc595_set_clock(hc595_t* chain, uint32_t hz);
+
+/**
+ * @brief Shift a whole chain out and latch it, now, in the calling thread.
+ * Do not use while the refresh thread runs.
+ * @param data chain->length bytes.
+ * @return 0 on success, -1 on error.
+ */
+int hc595_write(hc595_t* chain, const uint8_t* data);
+
+/** @name Double Buffering */
+/**@{*/
+
+/**
+ * @brief Buffer to edit for the next frame (chain->length bytes). After a
+ * swap it holds a copy of the frame just published.
+ */
+uint8_t* hc595_back(hc595_t* chain);
+
+/** Set or clear one output of the back buffer (0 = QA of register 0). */
+void hc595_set_output(hc595_t* chain, size_t index, int value);
+
+/**
+ * @brief Publish the back buffer.
+ *
+ * With the refresh thread running this waits until the thread has taken
+ * it (at most one refresh period); otherwise it is written out at once.
+ * Call it from the thread that starts and stops the refresh.
+ * @return 0 on success, -1 on error.
+ */
+int hc595_swap(hc595_t* chain);
+/**@}*/
+
+/**
+ * @brief Start refreshing the front buffer at a fixed rate.
+ * @param rate_hz Refreshes per second.
+ * @param core_id CPU core to pin to (and run SCHED_FIFO on), or -1.
+ * @return 0 on success, -1 on error.
+ */
+int hc595_start(hc595_t* chain, double rate_hz, int core_id);
+
+/**
+ * @brief Stop the refresh thread.
+ */
+void hc595_stop(hc595_t* chain);
+
+/**
+ * @brief Copy the refresh counters (safe while the thread runs).
+ */
+void hc595_get_stats(hc595_t* chain, hc595_stats_t* stats);
+
+/**
+ * @brief Achieved refresh rate over the current or last run.
+ */
+double hc595_refresh_rate(hc595_t* chain);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_HC595_H */
+
+#ifdef RPI_HC595_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+
+static inline uint64_t hc595_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void hc595_build(hc595_t* chain) {
+    uint64_t ser = 1ull << chain->ser;
+    uint64_t srclk = 1ull << chain->srclk;
+    uint64_t rclk = 1ull << chain->rclk;
+
+    for (int byte = 0; byte < 256; byte++) {
+        int prev = -1;
+        for (int i = 0; i < 8; i++) {
+            int bit = (byte >> (7 - i)) & 1;
+            gpio_store_t* st = &chain->table[byte * 8 + i];
+            st->set_mask = 0;
+            st->clr_mask = srclk;
+            if (bit != prev) {
+                if (bit) st->set_mask |= ser;
+                else st->clr_mask |= ser;
+            }
+            prev = bit;
+        }
+    }
+
+    chain->clock.set_mask = srclk;
+    chain->clock.clr_mask = 0;
+    chain->latch.set_mask = rclk;
+    chain->latch.clr_mask = srclk;
+    chain->idle.set_mask = 0;
+    chain->idle.clr_mask = rclk | srclk;
+}
+
+/** Spin until @p deadline, sleeping first if it is more than HC595_SPIN_NS away. */
+static void hc595_wait_until(uint64_t deadline) {
+    uint64_t now = hc595_now_ns();
+    if (deadline > now + HC595_SPIN_NS) {
+        uint64_t wake = deadline - HC595_SPIN_NS;
+        struct timespec ts = { (time_t)(wake / 1000000000ull), (long)(wake % 1000000000ull) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+    }
+    while (hc595_now_ns() < deadline) {
+    }
+}
+
+/** Shift @p data out, last register first, and latch. */
+static void hc595_shift(hc595_t* chain, const uint8_t* data) {
+    gpio_ctx_t* gpio = chain->gpio;
+    const gpio_store_t clock = chain->clock;
+    const uint64_t half = chain->half_period_ns;
+    uint64_t deadline = half ? hc595_now_ns() : 0;
+
+    for (size_t n = chain->length; n-- > 0;) {
+        const gpio_store_t* st = &chain->table[data[n] * 8];
+        for (int i = 0; i < 8; i++) {
+            gpio_ctx_write_mask_fast(gpio, st[i].set_mask, st[i].clr_mask);
+            if (half) hc595_wait_until(deadline += half);
+            gpio_ctx_write_mask_fast(gpio, clock.set_mask, clock.clr_mask);
+            if (half) hc595_wait_until(deadline += half);
+        }
+    }
+    gpio_ctx_write_mask_fast(gpio, chain->latch.set_mask, chain->latch.clr_mask);
+    if (half) hc595_wait_until(deadline += half);
+    gpio_ctx_write_mask_fast(gpio, chain->idle.set_mask, chain->idle.clr_mask);
+    chain->bytes += chain->length;
+}
+
+int hc595_init(hc595_t* chain, gpio_ctx_t* gpio, int ser, int srclk, int rclk, size_t length) {
+    if (!chain) return -1;
+    if (!GPIO_VALID_PIN(ser) || !GPIO_VALID_PIN(srclk) || !GPIO_VALID_PIN(rclk) || ser == srclk ||
+        ser == rclk || srclk == rclk) {
+        fprintf(stderr, "HC595 Error: Invalid pins (SER %d, SRCLK %d, RCLK %d)\n", ser, srclk, rclk);
+        return -1;
+    }
+    if (length == 0 || length > HC595_MAX_LENGTH) {
+        fprintf(stderr, "HC595 Error: Invalid chain length %zu\n", length);
+        return -1;
+    }
+
+    memset(chain, 0, sizeof(*chain));
+    chain->table = (gpio_store_t*)aligned_alloc(64, 256 * 8 * sizeof(gpio_store_t));
+    chain->buf[0] = (uint8_t*)calloc(2, length);
+    if (!chain->table || !chain->buf[0]) {
+        perror("HC595 Error: Failed to allocate chain");
+        free(chain->table);
+        free(chain->buf[0]);
+        chain->table = NULL;
+        chain->buf[0] = NULL;
+        return -1;
+    }
+    chain->buf[1] = chain->buf[0] + length;
+    chain->gpio = gpio ? gpio : &gpio_ctx_default;
+    chain->ser = ser;
+    chain->srclk = srclk;
+    chain->rclk = rclk;
+    chain->length = length;
+    chain->core_id = -1;
+    hc595_build(chain);
+
+    gpio_ctx_write_mask(chain->gpio, 0, (1ull << ser) | (1ull << srclk) | (1ull << rclk));
+    gpio_ctx_pin_mode(chain->gpio, ser, OUTPUT);
+    gpio_ctx_pin_mode(chain->gpio, srclk, OUTPUT);
+    gpio_ctx_pin_mode(chain->gpio, rclk, OUTPUT);
+    hc595_shift(chain, chain->buf[0]);
+    return 0;
+}
+
+void hc595_free(hc595_t* chain) {
+    if (!chain) return;
+    hc595_stop(chain);
+    free(chain->table);
+    free(chain->buf[0]);
+    chain->table = NULL;
+    chain->buf[0] = chain->buf[1] = NULL;
+}
+
+uint32_t hc595_set_clock(hc595_t* chain, uint32_t hz) {
+    if (!chain) return 0;
+    if (hz == 0) {
+        chain->half_period_ns = 0;
+        return 0;
+    }
+    uint32_t half = 500000000u / hz;
+    chain->half_period_ns = half ? half : 1;
+    return 500000000u / chain->half_period_ns;
+}
+
+int hc595_write(hc595_t* chain, const uint8_t* data) {
+    if (!chain || !chain->table || !data) return -1;
+    if (chain->running) {
+        fprintf(stderr, "HC595 Error: Refresh thread owns the chain, use hc595_swap()\n");
+        return -1;
+    }
+    hc595_shift(chain, data);
+    return 0;
+}
+
+/* ============================================================================
+ * DOUBLE BUFFERING
+ * ============================================================================ */
+
+uint8_t* hc595_back(hc595_t* chain) {
+    if (!chain || !chain->table) return NULL;
+    return chain->buf[chain->front ^ 1];
+}
+
+void hc595_set_output(hc595_t* chain, size_t index, int value) {
+    uint8_t* back = hc595_back(chain);
+    if (!back || index >= chain->length * 8) return;
+    uint8_t bit = (uint8_t)(1u << (index & 7));
+    if (value) back[index >> 3] |= bit;
+    else back[index >> 3] &= (uint8_t)~bit;
+}
+
+int hc595_swap(hc595_t* chain) {
+    if (!chain || !chain->table) return -1;
+
+    if (!__atomic_load_n(&chain->running, __ATOMIC_ACQUIRE)) {
+        chain->front ^= 1;
+        hc595_shift(chain, chain->buf[chain->front]);
+    } else {
+        __atomic_store_n(&chain->pending, 1, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&chain->pending, __ATOMIC_ACQUIRE)) usleep(HC595_SWAP_POLL_US);
+    }
+
+    /* The thread only reads the front buffer; start the next frame from this one */
+    memcpy(chain->buf[chain->front ^ 1], chain->buf[chain->front], chain->length);
+    return 0;
+}
+
+/* ============================================================================
+ * REFRESH THREAD
+ * ============================================================================ */
+
+static void* hc595_refresh_func(void* arg) {
+    hc595_t* chain = (hc595_t*)arg;
+    if (chain->core_id >= 0) {
+        pin_to_core(chain->core_id);
+        struct sched_param param = { .sched_priority = sched_get_priority_max(SCHED_FIFO) };
+        chain->realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+
+    hc595_stats_t* st = &chain->stats;
+    uint64_t period = chain->period_ns;
+    uint64_t deadline = hc595_now_ns();
+    __atomic_store_n(&st->start_ns, deadline, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&chain->running, __ATOMIC_RELAXED)) {
+        hc595_wait_until(deadline);
+
+        uint64_t now = hc595_now_ns();
+        uint64_t late = now - deadline;
+        if (late > st->max_late_ns) __atomic_store_n(&st->max_late_ns, late, __ATOMIC_RELAXED);
+        if (late >= period) {
+            uint64_t skip = late / period;
+            __atomic_store_n(&st->missed, st->missed + skip, __ATOMIC_RELAXED);
+            deadline += skip * period;
+        }
+
+        if (__atomic_load_n(&chain->pending, __ATOMIC_ACQUIRE)) {
+            chain->front ^= 1;
+            __atomic_store_n(&st->swaps, st->swaps + 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&chain->pending, 0, __ATOMIC_RELEASE);
+        }
+        hc595_shift(chain, chain->buf[chain->front]);
+
+        uint64_t done = hc595_now_ns();
+        __atomic_store_n(&st->last_frame_ns, done - now, __ATOMIC_RELAXED);
+        __atomic_store_n(&st->frames, st->frames + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&st->end_ns, done, __ATOMIC_RELAXED);
+        deadline += period;
+    }
+    return NULL;
+}
+
+int hc595_start(hc595_t* chain, double rate_hz, int core_id) {
+    if (!chain || !chain->table) return -1;
+    if (chain->running) {
+        fprintf(stderr, "HC595 Error: Refresh thread already running\n");
+        return -1;
+    }
+    if (!(rate_hz > 0.0) || rate_hz > 1e6) {
+        fprintf(stderr, "HC595 Error: Invalid refresh rate %.1f Hz\n", rate_hz);
+        return -1;
+    }
+
+    chain->period_ns = (uint64_t)(1e9 / rate_hz + 0.5);
+    chain->core_id = core_id;
+    chain->realtime = 0;
+    memset(&chain->stats, 0, sizeof(chain->stats));
+    __atomic_store_n(&chain->running, 1, __ATOMIC_RELEASE);
+
+    if (pthread_create(&chain->thread, NULL, hc595_refresh_func, chain) != 0) {
+        perror("HC595 Error: Failed to create refresh thread");
+        chain->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void hc595_stop(hc595_t* chain) {
+    if (!chain || !chain->running) return;
+    __atomic_store_n(&chain->running, 0, __ATOMIC_RELEASE);
+    pthread_join(chain->thread, NULL);
+}
+
+void hc595_get_stats(hc595_t* chain, hc595_stats_t* stats) {
+    if (!chain || !stats) return;
+    const hc595_stats_t* s = &chain->stats;
+    stats->frames = __atomic_load_n(&s->frames, __ATOMIC_RELAXED);
+    stats->swaps = __atomic_load_n(&s->swaps, __ATOMIC_RELAXED);
+    stats->missed = __atomic_load_n(&s->missed, __ATOMIC_RELAXED);
+    stats->max_late_ns = __atomic_load_n(&s->max_late_ns, __ATOMIC_RELAXED);
+    stats->last_frame_ns = __atomic_load_n(&s->last_frame_ns, __ATOMIC_RELAXED);
+    stats->start_ns = __atomic_load_n(&s->start_ns, __ATOMIC_RELAXED);
+    stats->end_ns = __atomic_load_n(&s->end_ns, __ATOMIC_RELAXED);
+}
+
+double hc595_refresh_rate(hc595_t* chain) {
+    hc595_stats_t st;
+    if (!chain) return 0.0;
+    hc595_get_stats(chain, &st);
+    if (st.frames < 2 || st.end_ns <= st.start_ns) return 0.0;
+    return (double)st.frames * 1e9 / (double)(st.end_ns - st.start_ns);
+}
+
+#endif /* RPI_HC595_IMPLEMENTATION */
@@ -0,0 +1,595 @@
+/**
+ * @file rpi_hub75.h
+ * @brief HUB75 RGB LED matrix panels with binary-coded modulation.
+ *
+ * Single-header library. Define RPI_HUB75_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h, rpi_realtime.h and pthread (-pthread linker flag).
+ *
+ * A panel of W x H pixels is driven as H/2 scan rows: the top and bottom
+ * halves are shifted together on R1 G1 B1 and R2 G2 B2, one column per
+ * CLK, then latched with LAT into the row selected on A-E while OE blanks
+ * the outputs. Colour depth comes from binary-coded modulation: each scan
+ * row is shown once per bitplane, plane k lit for base_ns << k, so a depth
+ * of D bits costs D shifts per row and 2^D - 1 base periods of light. OE
+ * goes high at each plane's own deadline, even in the middle of shifting
+ * the next plane, so short planes keep their weight when the shift takes
+ * longer than they are lit.
+ *
+ * The RGB888 framebuffer is turned into GPIO mask streams up front, one
+ * 32-bit GPSET0 word per column, scan row and bitplane. The conversion
+ * transposes eight bitplanes at once: a 256-entry table spreads a colour
+ * byte into the eight byte lanes of a 64-bit word, six of those ORed give
+ * the R1-B2 code of every plane of a pixel pair, and a 64-entry table maps
+ * each code to its pin mask. Playing a column is then two bank writes with
+ * no branching on the data (data and CLK low, then CLK high), and the next
+ * plane is shifted in while the current one is lit.
+ *
+ * hub75_start() plays the front stream continuously from a background
+ * thread; hub75_swap() converts the framebuffer into the back stream and
+ * hands it over at the next frame boundary. All pins must be in bank 0.
+ */
+
+#ifndef RPI_HUB75_H
+#define RPI_HUB75_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Bitplanes held per stream (RGB888 input). */
+#define HUB75_PLANES 8
+
+/** Address lines A-E. */
+#define HUB75_MAX_ADDR 5
+
+/** Columns per chain of panels. */
+#define HUB75_MAX_WIDTH 1024
+
+/** Lit time of the least significant plane played. */
+#define HUB75_DEFAULT_BASE_NS 200
+
+/** Poll interval of hub75_swap() while the thread has not taken a frame. */
+#define HUB75_SWAP_POLL_US 20
+
+/**
+ * @brief Panel wiring (BCM GPIO numbers, all below 32).
+ */
+typedef struct {
+    int r1, g1, b1;
+    int r2, g2, b2;
+    int addr[HUB75_MAX_ADDR];   /**< A, B, C, D, E; unused lines are ignored. */
+    int clk;
+    int lat;
+    int oe;                     /**< Active low. */
+} hub75_pins_t;
+
+/** Common "regular" adapter wiring. */
+#define HUB75_PINS_REGULAR { 11, 27, 7, 8, 9, 10, { 22, 23, 24, 25, 15 }, 17, 4, 18 }
+
+/**
+ * @brief Refresh counters.
+ */
+typedef struct {
+    uint64_t frames;          /**< Full frames (all rows, all planes) played. */
+    uint64_t swaps;           /**< Back streams taken by the thread. */
+    uint64_t last_frame_ns;
+    uint64_t max_frame_ns;
+    uint64_t lit_ns;          /**< Time OE was low, summed over all frames. */
+    uint64_t start_ns;
+    uint64_t end_ns;
+} hub75_stats_t;
+
+/**
+ * @brief A panel (or a chain of panels, as one wide panel).
+ */
+typedef struct {
+    gpio_ctx_t* gpio;
+    hub75_pins_t pins;
+    int width;
+    int height;
+    int rows;                       /**< Scan rows, height / 2. */
+    int depth;                      /**< Bitplanes played, 1-8 (top bits). */
+    uint32_t base_ns;
+    int slowdown;                   /**< Extra repeats of each bank write. */
+    uint32_t data_mask;             /**< R1-B2. */
+    uint32_t clk_mask;
+    uint32_t lat_mask;
+    uint32_t oe_mask;
+    uint32_t row_set[32];           /**< Address lines per scan row. */
+    uint32_t row_clr[32];
+    uint32_t code_mask[64];         /**< R1-B2 code -> GPSET0 word. */
+    uint64_t spread[256];           /**< Bit k of a byte -> bit 0 of lane k. */
+    uint8_t* pixels;                /**< RGB888, row major. */
+    uint32_t* stream[2];            /**< [row][plane][column] GPSET0 words. */
+    int front;                      /**< Stream played by the refresh thread. */
+    int pending;                    /**< Back stream published, not yet taken. */
+    hub75_stats_t stats;
+    pthread_t thread;
+    int running;
+    int realtime;                   /**< Refresh thread got SCHED_FIFO. */
+    int core_id;
+} hub75_t;
+
+/**
+ * @brief Set up a panel. Pins become outputs with OE high (blank); the
+ * framebuffer and both streams start black.
+ * @param gpio GPIO context (NULL for gpio_ctx_default).
+ * @param pins Wiring, NULL for HUB75_PINS_REGULAR.
+ * @param width Columns (1-HUB75_MAX_WIDTH).
+ * @param height Rows: 16, 32 or 64 (1:8, 1:16 or 1:32 scan).
+ * @return 0 on success, -1 on error.
+ */
+int hub75_init(hub75_t* panel, gpio_ctx_t* gpio, const hub75_pins_t* pins, int width, int height);
+
+/**
+ * @brief Stop the refresh thread, blank the panel and free the buffers.
+ */
+void hub75_free(hub75_t* panel);
+
+/**
+ * @brief Set the colour depth (played planes are the top @p depth bits).
+ * @return 0 on success, -1 on error or while the thread runs.
+ */
+int hub75_set_depth(hub75_t* panel, int depth);
+
+/**
+ * @brief Set the lit time of the lowest plane and the GPIO slowdown.
+ * @param base_ns Lowest plane lit time (> 0).
+ * @param slowdown Extra repeats of each write, for panels that cannot
+ *        follow the GPIO at full speed (0-4).
+ * @return 0 on success, -1 on error or while the thread runs.
+ */
+int hub75_set_timing(hub75_t* panel, uint32_t base_ns, int slowdown);
+
+/** @name Framebuffer */
+/**@{*/
+
+/** RGB888 framebuffer, width * height * 3 bytes, row major. */
+uint8_t* hub75_pixels(hub75_t* panel);
+
+void hub75_set_pixel(hub75_t* panel, int x, int y, uint8_t r, uint8_t g, uint8_t b);
+
+/**
+ * @brief Convert the framebuffer into the back stream and publish it.
+ *
+ * With the refresh thread running this waits until the thread has taken
+ * it (at most one frame); otherwise the next hub75_refresh() plays it.
+ * Call it from the thread that starts and stops the refresh.
+ * @return 0 on success, -1 on error.
+ */
+int hub75_swap(hub75_t* panel);
+/**@}*/
+
+/**
+ * @brief Play the front stream once, in the calling thread, and blank.
+ * Do not use while the refresh thread runs.
+ * @return 0 on success, -1 on error.
+ */
+int hub75_refresh(hub75_t* panel);
+
+/**
+ * @brief Start playing the front stream continuously.
+ *
+ * The thread never sleeps while it runs, so give it an isolated core; it
+ * only asks for SCHED_FIFO when pinned.
+ * @param core_id CPU core to pin to, or -1.
+ * @return 0 on success, -1 on error.
+ */
+int hub75_start(hub75_t* panel, int core_id);
+
+/**
+ * @brief Stop the refresh thread and blank the panel.
+ */
+void hub75_stop(hub75_t* panel);
+
+/**
+ * @brief Copy the refresh counters (safe while the thread runs).
+ */
+void hub75_get_stats(hub75_t* panel, hub75_stats_t* stats);
+
+/**
+ * @brief Achieved refresh rate (full frames per second) over the current or
+ * last run.
+ */
+double hub75_refresh_rate(hub75_t* panel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_HUB75_H */
+
+#ifdef RPI_HUB75_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+
+static inline uint64_t hub75_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * One bank 0 write through gpio_ctx_write_mask_fast(), repeated @p slowdown
+ * extra times on mmap for panels that need longer CLK and LAT pulses.
+ */
+static inline void hub75_apply(gpio_ctx_t* gpio, uint32_t set, uint32_t clr, int slowdown) {
+    gpio_ctx_write_mask_fast(gpio, set, clr);
+    if (!gpio->regs) return;
+    for (int i = 0; i < slowdown; i++) gpio_ctx_write_mask_fast(gpio, set, clr);
+}
+
+static size_t hub75_stream_words(const hub75_t* panel) {
+    return (size_t)panel->rows * HUB75_PLANES * (size_t)panel->width;
+}
+
+static int hub75_addr_lines(int rows) {
+    int lines = 0;
+    while ((1 << lines) < rows) lines++;
+    return lines;
+}
+
+static void hub75_build_tables(hub75_t* panel) {
+    const hub75_pins_t* p = &panel->pins;
+    const int data[6] = { p->r1, p->g1, p->b1, p->r2, p->g2, p->b2 };
+
+    for (int v = 0; v < 256; v++) {
+        uint64_t lanes = 0;
+        for (int k = 0; k < HUB75_PLANES; k++) lanes |= (uint64_t)((v >> k) & 1) << (8 * k);
+        panel->spread[v] = lanes;
+    }
+    panel->data_mask = 0;
+    for (int code = 0; code < 64; code++) {
+        uint32_t mask = 0;
+        for (int c = 0; c < 6; c++) {
+            if (code & (1 << c)) mask |= 1u << data[c];
+        }
+        panel->code_mask[code] = mask;
+    }
+    for (int c = 0; c < 6; c++) panel->data_mask |= 1u << data[c];
+
+    int lines = hub75_addr_lines(panel->rows);
+    for (int row = 0; row < panel->rows; row++) {
+        panel->row_set[row] = panel->row_clr[row] = 0;
+        for (int a = 0; a < lines; a++) {
+            if (row & (1 << a)) panel->row_set[row] |= 1u << p->addr[a];
+            else panel->row_clr[row] |= 1u << p->addr[a];
+        }
+    }
+    panel->clk_mask = 1u << p->clk;
+    panel->lat_mask = 1u << p->lat;
+    panel->oe_mask = 1u << p->oe;
+}
+
+/**
+ * Framebuffer -> stream. One 64-bit word per pixel pair carries the R1-B2
+ * code of all eight planes, a byte lane per plane.
+ */
+static void hub75_convert(const hub75_t* panel, const uint8_t* pixels, uint32_t* stream) {
+    const uint64_t* spread = panel->spread;
+    const uint32_t* code_mask = panel->code_mask;
+    const int width = panel->width;
+    const size_t plane_stride = (size_t)width;
+
+    for (int row = 0; row < panel->rows; row++) {
+        const uint8_t* top = pixels + (size_t)row * width * 3;
+        const uint8_t* bot = pixels + (size_t)(row + panel->rows) * width * 3;
+        uint32_t* out = stream + (size_t)row * HUB75_PLANES * plane_stride;
+        for (int x = 0; x < width; x++, top += 3, bot += 3) {
+            uint64_t lanes = spread[top[0]] | spread[top[1]] << 1 | spread[top[2]] << 2 | spread[bot[0]] << 3 |
+                             spread[bot[1]] << 4 | spread[bot[2]] << 5;
+            for (int k = 0; k < HUB75_PLANES; k++) {
+                out[k * plane_stride + x] = code_mask[(lanes >> (8 * k)) & 0x3f];
+            }
+        }
+    }
+}
+
+static inline void hub75_spin_until(uint64_t deadline) {
+    while (hub75_now_ns() < deadline) {
+    }
+}
+
+/** Frame loop state: the plane on the outputs has been lit since @c shown. */
+typedef struct {
+    uint64_t shown;
+    uint64_t deadline;      /**< End of its lit time. */
+} hub75_clock_t;
+
+/** Blank once the lit plane's deadline has passed. @return Its lit time. */
+static inline uint64_t hub75_blank(hub75_t* panel, const hub75_clock_t* t) {
+    hub75_spin_until(t->deadline);
+    hub75_apply(panel->gpio, panel->oe_mask, 0, panel->slowdown);
+    return hub75_now_ns() - t->shown;
+}
+
+/**
+ * Play every scan row and plane of @p stream once. Each plane is shifted
+ * while the previous one is still lit; the clock is read before every
+ * column until that plane's deadline passes and OE goes high, so a plane
+ * shorter than the shift is not stretched to it. Leaves the last plane
+ * lit. @return Lit time of the planes blanked during this frame.
+ */
+static uint64_t hub75_frame(hub75_t* panel, const uint32_t* stream, hub75_clock_t* t) {
+    gpio_ctx_t* gpio = panel->gpio;
+    const int width = panel->width;
+    const int first = HUB75_PLANES - panel->depth;
+    const int slow = panel->slowdown;
+    const uint32_t data_mask = panel->data_mask;
+    const uint32_t clk = panel->clk_mask;
+    const uint32_t lat = panel->lat_mask;
+    const uint32_t oe = panel->oe_mask;
+    uint64_t lit_ns = 0;
+
+    for (int row = 0; row < panel->rows; row++) {
+        for (int plane = first; plane < HUB75_PLANES; plane++) {
+            const uint32_t* col = stream + ((size_t)row * HUB75_PLANES + (size_t)plane) * (size_t)width;
+            int lit = 1;
+            for (int x = 0; x < width; x++) {
+                if (lit) {
+                    uint64_t now = hub75_now_ns();
+                    if (now >= t->deadline) {
+                        hub75_apply(gpio, oe, 0, slow);
+                        lit_ns += now - t->shown;
+                        lit = 0;
+                    }
+                }
+                hub75_apply(gpio, col[x], (data_mask ^ col[x]) | clk, slow);
+                hub75_apply(gpio, clk, 0, slow);
+            }
+            if (lit) lit_ns += hub75_blank(panel, t);
+
+            hub75_apply(gpio, panel->row_set[row] | lat, panel->row_clr[row], slow);
+            hub75_apply(gpio, 0, lat | oe, slow);
+            t->shown = hub75_now_ns();
+            t->deadline = t->shown + ((uint64_t)panel->base_ns << (plane - first));
+        }
+    }
+    return lit_ns;
+}
+
+static int hub75_pin_ok(int pin) {
+    return GPIO_VALID_PIN(pin) && pin < GPIO_PINS_PER_BANK;
+}
+
+int hub75_init(hub75_t* panel, gpio_ctx_t* gpio, const hub75_pins_t* pins, int width, int height) {
+    static const hub75_pins_t regular = HUB75_PINS_REGULAR;
+    if (!panel) return -1;
+    if (!pins) pins = &regular;
+    if (width < 1 || width > HUB75_MAX_WIDTH || (height != 16 && height != 32 && height != 64)) {
+        fprintf(stderr, "HUB75 Error: Invalid panel size %dx%d\n", width, height);
+        return -1;
+    }
+
+    /* Every used pin in bank 0, no pin twice */
+    int rows = height / 2;
+    int used[6 + HUB75_MAX_ADDR + 3];
+    int n = 0;
+    used[n++] = pins->r1;
+    used[n++] = pins->g1;
+    used[n++] = pins->b1;
+    used[n++] = pins->r2;
+    used[n++] = pins->g2;
+    used[n++] = pins->b2;
+    for (int a = 0; a < hub75_addr_lines(rows); a++) used[n++] = pins->addr[a];
+    used[n++] = pins->clk;
+    used[n++] = pins->lat;
+    used[n++] = pins->oe;
+    uint32_t all = 0;
+    for (int i = 0; i < n; i++) {
+        if (!hub75_pin_ok(used[i]) || (all & (1u << used[i]))) {
+            fprintf(stderr, "HUB75 Error: Invalid or repeated pin %d\n", used[i]);
+            return -1;
+        }
+        all |= 1u << used[i];
+    }
+
+    memset(panel, 0, sizeof(*panel));
+    panel->gpio = gpio ? gpio : &gpio_ctx_default;
+    panel->pins = *pins;
+    panel->width = width;
+    panel->height = height;
+    panel->rows = rows;
+    panel->depth = HUB75_PLANES;
+    panel->base_ns = HUB75_DEFAULT_BASE_NS;
+    panel->core_id = -1;
+
+    size_t words = hub75_stream_words(panel);
+    size_t bytes = (words * sizeof(uint32_t) + 63) & ~(size_t)63;
+    panel->pixels = (uint8_t*)calloc((size_t)width * height, 3);
+    panel->stream[0] = (uint32_t*)aligned_alloc(64, 2 * bytes);
+    if (!panel->pixels || !panel->stream[0]) {
+        perror("HUB75 Error: Failed to allocate panel");
+        free(panel->pixels);
+        free(panel->stream[0]);
+        panel->pixels = NULL;
+        panel->stream[0] = NULL;
+        return -1;
+    }
+    memset(panel->stream[0], 0, 2 * bytes);
+    panel->stream[1] = panel->stream[0] + bytes / sizeof(uint32_t);
+    hub75_build_tables(panel);
+
+    gpio_ctx_write_mask(panel->gpio, panel->oe_mask, all & ~panel->oe_mask);
+    for (int i = 0; i < n; i++) gpio_ctx_pin_mode(panel->gpio, used[i], OUTPUT);
+    return 0;
+}
+
+void hub75_free(hub75_t* panel) {
+    if (!panel || !panel->pixels) return;
+    hub75_stop(panel);
+    gpio_ctx_write_mask(panel->gpio, panel->oe_mask, 0);
+    free(panel->pixels);
+    free(panel->stream[0]);
+    panel->pixels = NULL;
+    panel->stream[0] = panel->stream[1] = NULL;
+}
+
+int hub75_set_depth(hub75_t* panel, int depth) {
+    if (!panel || !panel->pixels) return -1;
+    if (depth < 1 || depth > HUB75_PLANES) {
+        fprintf(stderr, "HUB75 Error: Invalid colour depth %d\n", depth);
+        return -1;
+    }
+    if (panel->running) {
+        fprintf(stderr, "HUB75 Error: Stop the refresh thread before changing the depth\n");
+        return -1;
+    }
+    panel->depth = depth;
+    return 0;
+}
+
+int hub75_set_timing(hub75_t* panel, uint32_t base_ns, int slowdown) {
+    if (!panel || !panel->pixels) return -1;
+    if (base_ns == 0 || slowdown < 0 || slowdown > 4) {
+        fprintf(stderr, "HUB75 Error: Invalid timing (base %u ns, slowdown %d)\n", base_ns, slowdown);
+        return -1;
+    }
+    if (panel->running) {
+        fprintf(stderr, "HUB75 Error: Stop the refresh thread before changing the timing\n");
+        return -1;
+    }
+    panel->base_ns = base_ns;
+    panel->slowdown = slowdown;
+    return 0;
+}
+
+/* ============================================================================
+ * FRAMEBUFFER
+ * ============================================================================ */
+
+uint8_t* hub75_pixels(hub75_t* panel) {
+    return panel ? panel->pixels : NULL;
+}
+
+void hub75_set_pixel(hub75_t* panel, int x, int y, uint8_t r, uint8_t g, uint8_t b) {
+    if (!panel || !panel->pixels || x < 0 || y < 0 || x >= panel->width || y >= panel->height) return;
+    uint8_t* px = panel->pixels + ((size_t)y * panel->width + x) * 3;
+    px[0] = r;
+    px[1] = g;
+    px[2] = b;
+}
+
+int hub75_swap(hub75_t* panel) {
+    if (!panel || !panel->pixels) return -1;
+    hub75_convert(panel, panel->pixels, panel->stream[panel->front ^ 1]);
+
+    if (!__atomic_load_n(&panel->running, __ATOMIC_ACQUIRE)) {
+        panel->front ^= 1;
+    } else {
+        __atomic_store_n(&panel->pending, 1, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&panel->pending, __ATOMIC_ACQUIRE)) usleep(HUB75_SWAP_POLL_US);
+    }
+    return 0;
+}
+
+int hub75_refresh(hub75_t* panel) {
+    if (!panel || !panel->pixels) return -1;
+    if (panel->running) {
+        fprintf(stderr, "HUB75 Error: Refresh thread owns the panel\n");
+        return -1;
+    }
+    hub75_clock_t t;
+    t.shown = t.deadline = hub75_now_ns();
+    hub75_frame(panel, panel->stream[panel->front], &t);
+    hub75_blank(panel, &t);
+    return 0;
+}
+
+/* ============================================================================
+ * REFRESH THREAD
+ * ============================================================================ */
+
+static void* hub75_refresh_func(void* arg) {
+    hub75_t* panel = (hub75_t*)arg;
+    if (panel->core_id >= 0) {
+        pin_to_core(panel->core_id);
+        struct sched_param param = { .sched_priority = sched_get_priority_max(SCHED_FIFO) };
+        panel->realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+
+    hub75_stats_t* st = &panel->stats;
+    hub75_clock_t t;
+    t.shown = t.deadline = hub75_now_ns();
+    __atomic_store_n(&st->start_ns, t.shown, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&panel->running, __ATOMIC_RELAXED)) {
+        if (__atomic_load_n(&panel->pending, __ATOMIC_ACQUIRE)) {
+            panel->front ^= 1;
+            __atomic_store_n(&st->swaps, st->swaps + 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&panel->pending, 0, __ATOMIC_RELEASE);
+        }
+
+        uint64_t t0 = hub75_now_ns();
+        uint64_t lit = hub75_frame(panel, panel->stream[panel->front], &t);
+        uint64_t done = hub75_now_ns();
+
+        uint64_t took = done - t0;
+        __atomic_store_n(&st->last_frame_ns, took, __ATOMIC_RELAXED);
+        if (took > st->max_frame_ns) __atomic_store_n(&st->max_frame_ns, took, __ATOMIC_RELAXED);
+        __atomic_store_n(&st->lit_ns, st->lit_ns + lit, __ATOMIC_RELAXED);
+        __atomic_store_n(&st->frames, st->frames + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&st->end_ns, done, __ATOMIC_RELAXED);
+    }
+
+    hub75_blank(panel, &t);
+    return NULL;
+}
+
+int hub75_start(hub75_t* panel, int core_id) {
+    if (!panel || !panel->pixels) return -1;
+    if (panel->running) {
+        fprintf(stderr, "HUB75 Error: Refresh thread already running\n");
+        return -1;
+    }
+
+    panel->core_id = core_id;
+    panel->realtime = 0;
+    memset(&panel->stats, 0, sizeof(panel->stats));
+    __atomic_store_n(&panel->running, 1, __ATOMIC_RELEASE);
+
+    if (pthread_create(&panel->thread, NULL, hub75_refresh_func, panel) != 0) {
+        perror("HUB75 Error: Failed to create refresh thread");
+        panel->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void hub75_stop(hub75_t* panel) {
+    if (!panel || !panel->running) return;
+    __atomic_store_n(&panel->running, 0, __ATOMIC_RELEASE);
+    pthread_join(panel->thread, NULL);
+}
+
+void hub75_get_stats(hub75_t* panel, hub75_stats_t* stats) {
+    if (!panel || !stats) return;
+    const hub75_stats_t* s = &panel->stats;
+    stats->frames = __atomic_load_n(&s->frames, __ATOMIC_RELAXED);
+    stats->swaps = __atomic_load_n(&s->swaps, __ATOMIC_RELAXED);
+    stats->last_frame_ns = __atomic_load_n(&s->last_frame_ns, __ATOMIC_RELAXED);
+    stats->max_frame_ns = __atomic_load_n(&s->max_frame_ns, __ATOMIC_RELAXED);
+    stats->lit_ns = __atomic_load_n(&s->lit_ns, __ATOMIC_RELAXED);
+    stats->start_ns = __atomic_load_n(&s->start_ns, __ATOMIC_RELAXED);
+    stats->end_ns = __atomic_load_n(&s->end_ns, __ATOMIC_RELAXED);
+}
+
+double hub75_refresh_rate(hub75_t* panel) {
+    hub75_stats_t st;
+    if (!panel) return 0.0;
+    hub75_get_stats(panel, &st);
+    if (st.frames < 2 || st.end_ns <= st.start_ns) return 0.0;
+    return (double)st.frames * 1e9 / (double)(st.end_ns - st.start_ns);
+}
+
+#endif /* RPI_HUB75_IMPLEMENTATION */
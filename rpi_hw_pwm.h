@@ -8,19 +8,105 @@
  * Requires rpi_gpio.h and root privileges (/dev/mem access).
  *
  * Supported pins: 12, 13 (ALT0), 18, 19 (ALT5).
+ *
+ * Register pointers live in an hpwm_ctx_t. hpwm_init() and friends use a
+ * default context (MOCK logging on x86/x64 hosts); hpwm_ctx_attach() binds
+ * a context to caller-provided register blocks, e.g. RAM in host tests.
+ *
+ * Each context caches the range, pin mux and enable state it last wrote per
+ * channel. A duty change at an unchanged frequency only rewrites PWM_DATn
+ * (no disable/usleep/re-enable), and redundant writes are skipped, so
+ * hpwm_set_duty() suits closed-loop control at kHz update rates. The cache
+ * assumes nothing else writes the PWM block while the context is live.
+ *
+ * Both channels share one PWM clock. hpwm_plan() picks the clock source,
+ * integer/fractional divider and ranges that give the most duty steps for
+ * the requested frequencies; hpwm_ctx_set() applies it whenever a channel's
+ * frequency changes, rescaling the other channel if the clock moves.
+ *
+ * Streaming mode (hpwm_stream_*) feeds one channel from the PWM FIFO (USEF)
+ * through a ring of DMA control blocks (rpi_dma.h): each FIFO word is the
+ * duty of one PWM period, so the PWM frequency is the sample rate and no CPU
+ * is spent per sample. hpwm_sim_t models the PWM block and its FIFO for
+ * dma_sim_t, so streams can be tested on the host.
+ *
+ * Serializer mode (hpwm_serial_*) shifts FIFO words out MSB first, one bit
+ * per PWM clock, for self-clocked bitstreams such as WS2812 LEDs. Each data
+ * bit becomes a short slot pattern (e.g. 100/110) via a 256-entry table, so
+ * a frame is encoded a byte per lookup and sent by a single DMA transfer.
  */
 
 #ifndef RPI_HW_PWM_H
 #define RPI_HW_PWM_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief PWM clock and range settings for both channels.
+ *
+ * Filled by hpwm_plan(). Duty resolution on channel n is 1/range[n].
+ */
+typedef struct {
+    int src;                  /**< Clock source (CM_SRC_OSC or CM_SRC_PLLD). */
+    uint32_t divi;            /**< Integer divider (2-4095). */
+    uint32_t divf;            /**< Fractional divider in 1/4096 steps (0 when mash is 0). */
+    int mash;                 /**< 0 = integer division, 1 = 1-stage MASH noise shaping. */
+    double clock_hz;          /**< Resulting PWM clock. */
+    uint32_t range[2];        /**< PWM_RNGn per channel (0 = channel unused). */
+    double freq_hz[2];        /**< Achieved output frequency per channel. */
+} hpwm_plan_t;
+
+/**
+ * @brief Last state written to one PWM channel.
+ */
+typedef struct {
+    int freq_hz;              /**< Requested frequency (0 = not configured). */
+    uint32_t range;           /**< PWM_RNGn. */
+    uint32_t data;            /**< PWM_DATn. */
+    int pin;                  /**< Pin muxed to the channel (-1 = none). */
+    int enabled;              /**< 1 if PWENn is set. */
+} hpwm_channel_t;
+
+/**
+ * @brief Hardware PWM instance.
+ */
+typedef struct {
+    volatile uint32_t* pwm;   /**< PWM register block. */
+    volatile uint32_t* clk;   /**< Clock manager register block. */
+    gpio_ctx_t* gpio;         /**< GPIO context used for pin muxing. */
+    int mapped;               /**< 1 if the blocks come from the rpi_periph.h registry. */
+    uint64_t updates;         /**< Channel updates that wrote registers. */
+    uint64_t reconfigs;       /**< Updates that had to disable and re-enable a channel. */
+    hpwm_channel_t ch[2];     /**< Per-channel register cache. */
+    hpwm_plan_t plan;         /**< Clock settings currently programmed. */
+    int serial;               /**< Channel held by an open serializer (-1 = none). */
+} hpwm_ctx_t;
+
+/**
+ * @brief Plan clock divider and ranges for the two PWM channels.
+ *
+ * Pure function: touches no registers. Tries every integer divider of the
+ * oscillator and PLLD, plus a fractional (MASH) divider that hits each
+ * requested frequency exactly, and keeps the candidate with the largest
+ * minimum range among those within HPWM_PLAN_TOLERANCE_PPM of every target.
+ * Integer division wins ties, since MASH adds period jitter.
+ *
+ * @param freq0_hz Channel 1 frequency (PWM0_0: pins 12, 18), 0 if unused.
+ * @param freq1_hz Channel 2 frequency (PWM0_1: pins 13, 19), 0 if unused.
+ * @param plan Output settings with achieved frequencies and ranges.
+ * @return 0 on success, -1 if no channel is used, a frequency is negative
+ *         or above HPWM_CLOCK_MAX_HZ / 2.
+ */
+int hpwm_plan(int freq0_hz, int freq1_hz, hpwm_plan_t* plan);
+
 /**
  * @brief Initialize hardware PWM controller.
  *
- * Configures PWM clock to 1 MHz base frequency.
+ * Starts the PWM clock at 1 MHz; hpwm_set() replans it (see hpwm_plan()).
  *
  * @return 0 on success, -1 on error.
  */
@@ -34,11 +120,278 @@ int hpwm_init(void);
  */
 void hpwm_set(int pin, int freq_hz, int duty_per_mille);
 
+/**
+ * @brief Change duty cycle only, keeping the frequency set by hpwm_set().
+ *
+ * Writes PWM_DATn alone; the new value takes effect at the next period,
+ * so the output does not glitch.
+ *
+ * @param pin BCM pin number previously configured with hpwm_set().
+ * @param duty_per_mille Duty cycle in per-mille (0-1000).
+ * @return 0 on success, -1 if the pin has no frequency set.
+ */
+int hpwm_set_duty(int pin, int duty_per_mille);
+
 /**
  * @brief Stop hardware PWM and release resources.
  */
 void hpwm_stop(void);
 
+/** @name Context API */
+/**@{*/
+
+/**
+ * @brief Map the PWM and clock blocks (rpi_periph.h) and start the clock.
+ * @param ctx Context to initialize.
+ * @param gpio GPIO context for pin muxing (NULL for gpio_ctx_default).
+ * @return 0 on success, -1 on error (always on non-Pi hosts unless
+ *         periph_set_io() supplies fake blocks).
+ */
+int hpwm_ctx_init(hpwm_ctx_t* ctx, gpio_ctx_t* gpio);
+
+/**
+ * @brief Use existing register blocks and start the clock.
+ * @param ctx Context to initialize.
+ * @param pwm_regs PWM block (at least PWM_DAT2 + 1 words).
+ * @param clk_regs Clock manager block (at least CM_PWMDIV + 1 words).
+ * @param gpio GPIO context for pin muxing (NULL for gpio_ctx_default).
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int hpwm_ctx_attach(hpwm_ctx_t* ctx, volatile uint32_t* pwm_regs,
+                    volatile uint32_t* clk_regs, gpio_ctx_t* gpio);
+
+/**
+ * @brief Set one channel; see hpwm_set().
+ * @return 0 on success, -1 on invalid arguments or while a serializer
+ *         holds the PWM clock.
+ */
+int hpwm_ctx_set(hpwm_ctx_t* ctx, int pin, int freq_hz, int duty_per_mille);
+
+/**
+ * @brief Change duty cycle only; see hpwm_set_duty().
+ * @return 0 on success, -1 if the pin is not running or a serializer holds
+ *         the PWM block.
+ */
+int hpwm_ctx_set_duty(hpwm_ctx_t* ctx, int pin, int duty_per_mille);
+
+/**
+ * @brief Disable both channels and release the blocks taken by hpwm_ctx_init().
+ */
+void hpwm_ctx_stop(hpwm_ctx_t* ctx);
+/**@}*/
+
+/** @name FIFO Streaming */
+/**@{*/
+
+/** Maximum control blocks (segments) in a stream ring. */
+#define HPWM_STREAM_MAX_SEGMENTS 64
+
+/**
+ * @brief Stream parameters.
+ */
+typedef struct {
+    int pin;                  /**< HW PWM pin (12, 13, 18, 19). */
+    int sample_rate;          /**< Samples per second (the PWM frequency). */
+    int segment_samples;      /**< Samples per control block. */
+    int segments;             /**< Ring length, 2 to HPWM_STREAM_MAX_SEGMENTS. */
+} hpwm_stream_config_t;
+
+/**
+ * @brief DMA ring feeding the PWM FIFO.
+ *
+ * Segments are played in order, forever. A segment the producer has not
+ * filled in time plays the idle level (half scale) and counts as an
+ * underrun.
+ */
+typedef struct {
+    hpwm_ctx_t* ctx;
+    dma_chan_t* dma;
+    dma_mem_t mem;            /**< Control blocks followed by sample segments. */
+    dma_cb_t* cbs;
+    uint32_t* samples;
+    int channel;              /**< PWM channel fed from the FIFO. */
+    int segments;
+    int segment_samples;
+    uint32_t range;           /**< Full-scale sample value (PWM range). */
+    uint32_t idle;            /**< Value played on underrun. */
+    uint64_t scale;           /**< 16-bit sample to range, 32.32 fixed point. */
+    int fill;                 /**< Segment the producer is filling. */
+    int fill_pos;             /**< Samples already in that segment. */
+    int done;                 /**< Next segment to reclaim. */
+    int running;
+    uint8_t ready[HPWM_STREAM_MAX_SEGMENTS];
+    uint64_t written;         /**< Samples accepted. */
+    uint64_t played;          /**< Producer samples handed to the FIFO. */
+    uint64_t underruns;       /**< Segments played as idle while running. */
+} hpwm_stream_t;
+
+/**
+ * @brief Set up a stream on an attached context and DMA channel.
+ *
+ * Plans the clock for sample_rate (hpwm_ctx_set()), builds the control
+ * block ring and switches the channel to FIFO mode. Only one stream per
+ * PWM block, since both channels share the FIFO.
+ *
+ * @return 0 on success, -1 on invalid config, busy FIFO or DMA memory error.
+ */
+int hpwm_stream_open(hpwm_stream_t* st, hpwm_ctx_t* ctx, dma_chan_t* dma,
+                     const hpwm_stream_config_t* cfg);
+
+/**
+ * @brief Queue samples (0-65535 full scale). Non-blocking.
+ * @return Samples accepted (less than count when the ring is full).
+ */
+int hpwm_stream_write(hpwm_stream_t* st, const uint16_t* samples, int count);
+
+/**
+ * @brief Start DMA. Write the first segments beforehand to avoid underruns.
+ */
+void hpwm_stream_start(hpwm_stream_t* st);
+
+/**
+ * @brief Reclaim played segments and count underruns.
+ *
+ * Called by hpwm_stream_write(); call at least once per ring period when
+ * not writing, or laps are missed.
+ *
+ * @return Samples that can be written without blocking.
+ */
+int hpwm_stream_poll(hpwm_stream_t* st);
+
+/**
+ * @brief Stop DMA, disable the channel and free the ring.
+ */
+void hpwm_stream_close(hpwm_stream_t* st);
+/**@}*/
+
+/** @name Serializer */
+/**@{*/
+
+/**
+ * @brief Bitstream parameters.
+ *
+ * Each data bit is sent as symbol_slots serializer bits (slots) at
+ * slot_rate, MSB first: zero/one hold the slot patterns for a 0 and a 1.
+ */
+typedef struct {
+    int pin;                  /**< HW PWM pin (12, 13, 18, 19). */
+    int slot_rate;            /**< Serializer bits per second (the PWM clock). */
+    int symbol_slots;         /**< Slots per data bit, 1-4. */
+    uint8_t zero;             /**< Slot pattern for a 0 bit. */
+    uint8_t one;              /**< Slot pattern for a 1 bit. */
+    int reset_us;             /**< Low time appended to every frame. */
+    int max_bytes;            /**< Largest frame hpwm_serial_send() accepts. */
+} hpwm_serial_config_t;
+
+/** WS2812/SK6812: 1.25 us per bit as 3 slots at 2.4 MHz, 300 us latch. */
+#define HPWM_SERIAL_WS2812(pin, max_bytes) { (pin), 2400000, 3, 0x4, 0x6, 300, (max_bytes) }
+
+/**
+ * @brief Serializer on one PWM channel, fed by a single DMA control block.
+ */
+typedef struct {
+    hpwm_ctx_t* ctx;
+    dma_chan_t* dma;
+    dma_mem_t mem;            /**< Control block followed by the frame words. */
+    dma_cb_t* cb;
+    uint32_t* words;
+    int channel;
+    int symbol_slots;
+    int max_bytes;
+    int reset_words;          /**< Zero words sent after each frame. */
+    uint32_t lut[256];        /**< Byte to 8 * symbol_slots slot bits. */
+    uint64_t frames;          /**< Frames started. */
+} hpwm_serial_t;
+
+/**
+ * @brief Switch a channel of an attached context to serializer mode.
+ *
+ * Programs the PWM clock to slot_rate and builds the encoding table. The
+ * serializer owns the PWM block (clock and FIFO) until hpwm_serial_close():
+ * the other channel must be stopped, and hpwm_ctx_set() and
+ * hpwm_ctx_set_duty() return -1 until then.
+ *
+ * @return 0 on success, -1 on invalid config, busy block or DMA memory error.
+ */
+int hpwm_serial_open(hpwm_serial_t* ser, hpwm_ctx_t* ctx, dma_chan_t* dma,
+                     const hpwm_serial_config_t* cfg);
+
+/**
+ * @brief FIFO words needed for len bytes (without the reset gap).
+ */
+size_t hpwm_serial_words(const hpwm_serial_t* ser, size_t len);
+
+/**
+ * @brief Encode bytes into serializer words. Touches no registers.
+ *
+ * The last word is padded with low slots.
+ *
+ * @param out At least hpwm_serial_words(ser, len) words.
+ * @return Words written.
+ */
+size_t hpwm_serial_encode(const hpwm_serial_t* ser, const uint8_t* data, size_t len, uint32_t* out);
+
+/**
+ * @brief Encode a frame into DMA memory and start sending it. Non-blocking.
+ * @return 0 on success, -1 if a frame is still in flight or len > max_bytes.
+ */
+int hpwm_serial_send(hpwm_serial_t* ser, const uint8_t* data, size_t len);
+
+/**
+ * @brief 1 while a frame (including its reset gap) is being transferred.
+ */
+int hpwm_serial_busy(const hpwm_serial_t* ser);
+
+/**
+ * @brief Stop DMA, leave serializer mode and free the frame buffer.
+ */
+void hpwm_serial_close(hpwm_serial_t* ser);
+/**@}*/
+
+/** @name Simulated PWM Block */
+/**@{*/
+
+/** FIFO depth modelled by hpwm_sim_t. */
+#define HPWM_FIFO_DEPTH 16
+
+/**
+ * @brief PWM and clock registers plus FIFO model for dma_sim_t.
+ *
+ * Attach a context with hpwm_ctx_attach(ctx, sim->pwm, sim->clk, gpio) and
+ * register the device with hpwm_sim_device(). In FIFO mode one word is read
+ * per PWM period at the clock programmed in sim->clk, and DREQ is raised
+ * while the FIFO is below the PWM_DMAC threshold. In serializer mode an
+ * empty FIFO outputs the silence bit (SBIT) rather than the last word.
+ */
+typedef struct {
+    uint32_t pwm[PERIPH_BLOCK_SIZE / 4];  /**< PWM registers. */
+    uint32_t clk[PERIPH_BLOCK_SIZE / 4];  /**< Clock manager registers. */
+    uint32_t fifo[HPWM_FIFO_DEPTH];
+    int fifo_head;
+    int fifo_count;
+    double next_ns;                       /**< Next FIFO read, 0 while idle. */
+    uint32_t last;                        /**< Value repeated when the FIFO is empty. */
+    uint32_t* log;                        /**< Values output, one per period. */
+    size_t log_cap;
+    size_t log_len;
+    uint64_t reads;                       /**< Periods played in FIFO mode. */
+    uint64_t empty;                       /**< Periods with an empty FIFO. */
+    uint64_t overflows;                   /**< Writes to a full FIFO. */
+} hpwm_sim_t;
+
+/**
+ * @brief Reset the model.
+ * @param log Buffer for output values (may be NULL).
+ * @param log_cap Entries in log.
+ */
+void hpwm_sim_init(hpwm_sim_t* sim, uint32_t* log, size_t log_cap);
+
+/**
+ * @brief Describe the model as a PERIPH_PWM device for dma_sim_add_device().
+ */
+void hpwm_sim_device(hpwm_sim_t* sim, dma_sim_dev_t* dev);
+/**@}*/
+
 #ifdef __cplusplus
 }
 #endif
@@ -50,8 +403,11 @@ void hpwm_stop(void);
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <unistd.h>
 
-#if defined(__aarch64__) || defined(__arm__)
+/* Platform detection is shared with rpi_gpio.h */
+#ifdef RPI_GPIO_PLATFORM_RPI
     #define RPI_HW_PWM_PLATFORM_RPI
 #else
     #define RPI_HW_PWM_PLATFORM_HOST
@@ -66,181 +422,915 @@ void hpwm_stop(void);
 /** Clamp duty per-mille to valid range [0, 1000]. */
 #define HPWM_CLAMP_DUTY(d) ((d) < HPWM_DUTY_MIN ? HPWM_DUTY_MIN : ((d) > HPWM_DUTY_MAX ? HPWM_DUTY_MAX : (d)))
 
-#ifdef RPI_HW_PWM_PLATFORM_RPI
-    #include <fcntl.h>
-    #include <sys/mman.h>
-    #include <unistd.h>
-
-    /** @name Register Offsets */
-    /**@{*/
-    #define PERIPHERAL_BASE 0xFE000000
-    #define PWM_OFFSET      0x20C000
-    #define CLK_OFFSET      0x101000
-    #define BLOCK_SIZE      (4*1024)
-    /**@}*/
-
-    /** @name Register Offsets */
-    /**@{*/
-    #define PWM_CTL  0
-    #define PWM_STA  1
-    #define PWM_DMAC 2
-    #define PWM_RNG1 4
-    #define PWM_DAT1 5
-    #define PWM_FIF1 6
-    #define PWM_RNG2 8
-    #define PWM_DAT2 9
-    /**@}*/
-
-    /** @name Clock Manager Offsets */
-    /**@{*/
-    #define CM_PWMCTL 40
-    #define CM_PWMDIV 41
-    /**@}*/
-
-    /** @name Clock Manager Password */
-    /**@{*/
-    #define CM_PASSWD (0x5A << 24)
-    /**@}*/
-
-    /** @name PWM Control Register Bits */
-    /**@{*/
-    #define PWM_CTL_PWEN1 (1 << 0)   /**< Channel 1 enable */
-    #define PWM_CTL_MSEN1 (1 << 7)   /**< Channel 1 M/S mode */
-    #define PWM_CTL_PWEN2 (1 << 8)   /**< Channel 2 enable */
-    #define PWM_CTL_MSEN2 (1 << 15)  /**< Channel 2 M/S mode */
-    /**@}*/
-
-    /** @name Clock Configuration */
-    /**@{*/
-    #define CM_SRC_PLLD      6       /**< PLLD clock source (500 MHz on Pi 4) */
-    #define CM_DIV_VALUE     54      /**< Divider for ~1 MHz PWM clock */
-    #define PWM_BASE_FREQ_HZ 1000000 /**< Resulting PWM clock frequency */
-    /**@}*/
-
-    /** @name Global Variables */
-    /**@{*/
-    static volatile uint32_t *pwm_map = NULL;
-    static volatile uint32_t *clk_map = NULL;
-    static int mem_fd_hw = -1;
-    /**@}*/
-
-    /**
-     * @brief Get PWM channel and alt function for a hardware PWM pin.
-     * @param pin BCM pin number.
-     * @param channel Output: 0 or 1 for channel.
-     * @param alt_func Output: ALT0 or ALT5.
-     * @return 1 if valid HW PWM pin, 0 otherwise.
-     */
-    static int hpwm_get_channel(int pin, int* channel, int* alt_func) {
-        switch (pin) {
-            case 12: *channel = 0; *alt_func = ALT0; return 1;
-            case 13: *channel = 1; *alt_func = ALT0; return 1;
-            case 18: *channel = 0; *alt_func = ALT5; return 1;
-            case 19: *channel = 1; *alt_func = ALT5; return 1;
-            default: return 0;
-        }
+/** @name Register Offsets */
+/**@{*/
+#define PWM_CTL  0
+#define PWM_STA  1
+#define PWM_DMAC 2
+#define PWM_RNG1 4
+#define PWM_DAT1 5
+#define PWM_FIF1 6
+#define PWM_RNG2 8
+#define PWM_DAT2 9
+/**@}*/
+
+/** @name Clock Manager Offsets */
+/**@{*/
+#define CM_PWMCTL 40
+#define CM_PWMDIV 41
+/**@}*/
+
+/** @name Clock Manager Password */
+/**@{*/
+#define CM_PASSWD (0x5A << 24)
+/**@}*/
+
+/** @name PWM Control Register Bits */
+/**@{*/
+#define PWM_CTL_PWEN1 (1 << 0)   /**< Channel 1 enable */
+#define PWM_CTL_MODE1 (1 << 1)   /**< Channel 1 serializer mode */
+#define PWM_CTL_RPTL1 (1 << 2)   /**< Channel 1 repeats the last word when the FIFO is empty */
+#define PWM_CTL_SBIT1 (1 << 3)   /**< Channel 1 silence bit */
+#define PWM_CTL_USEF1 (1 << 5)   /**< Channel 1 reads the FIFO */
+#define PWM_CTL_CLRF1 (1 << 6)   /**< Clear FIFO (write only) */
+#define PWM_CTL_MSEN1 (1 << 7)   /**< Channel 1 M/S mode */
+#define PWM_CTL_PWEN2 (1 << 8)   /**< Channel 2 enable */
+#define PWM_CTL_MODE2 (1 << 9)   /**< Channel 2 serializer mode */
+#define PWM_CTL_RPTL2 (1 << 10)  /**< Channel 2 repeats the last word when the FIFO is empty */
+#define PWM_CTL_SBIT2 (1 << 11)  /**< Channel 2 silence bit */
+#define PWM_CTL_USEF2 (1 << 13)  /**< Channel 2 reads the FIFO */
+#define PWM_CTL_MSEN2 (1 << 15)  /**< Channel 2 M/S mode */
+/**@}*/
+
+/** @name PWM Status and DMA Control Bits */
+/**@{*/
+#define PWM_STA_FULL1    (1 << 0)
+#define PWM_STA_EMPT1    (1 << 1)
+#define PWM_STA_WERR1    (1 << 2)
+#define PWM_DMAC_ENAB    (1u << 31)
+#define PWM_DMAC_PANIC(x) ((uint32_t)(x) << 8)
+#define PWM_DMAC_DREQ(x)  ((uint32_t)(x))
+/**@}*/
+
+/** @name Clock Configuration */
+/**@{*/
+#define CM_SRC_OSC       1       /**< Crystal oscillator clock source */
+#define CM_SRC_PLLD      6       /**< PLLD clock source */
+#define CM_ENAB          0x10    /**< CM_PWMCTL enable bit */
+#define CM_BUSY          0x80    /**< CM_PWMCTL busy bit */
+#define CM_MASH_SHIFT    9       /**< CM_PWMCTL MASH field */
+#define CM_DIV_VALUE     54      /**< Oscillator divider for the 1 MHz start-up clock */
+#define PWM_BASE_FREQ_HZ 1000000 /**< Start-up PWM clock, until the first hpwm_set() */
+/**@}*/
+
+/** @name Frequency Planner (BCM2711) */
+/**@{*/
+#define HPWM_OSC_HZ             54000000.0   /**< Oscillator (19.2 MHz on Pi 2/3) */
+#define HPWM_PLLD_HZ            750000000.0  /**< PLLD (500 MHz on Pi 2/3) */
+#define HPWM_CLOCK_MAX_HZ       125000000    /**< Highest PWM clock the planner uses */
+#define HPWM_DIVI_MAX           4095
+#define HPWM_PLAN_TOLERANCE_PPM 1000         /**< Acceptable frequency error */
+#define HPWM_SERIAL_WORD_BITS   32           /**< Serializer bits per FIFO word (PWM_RNGn) */
+/**@}*/
+
+/**
+ * @brief Get PWM channel and alt function for a hardware PWM pin.
+ * @param pin BCM pin number.
+ * @param channel Output: 0 or 1 for channel.
+ * @param alt_func Output: ALT0 or ALT5.
+ * @return 1 if valid HW PWM pin, 0 otherwise.
+ */
+static int hpwm_get_channel(int pin, int* channel, int* alt_func) {
+    switch (pin) {
+        case 12: *channel = 0; *alt_func = ALT0; return 1;
+        case 13: *channel = 1; *alt_func = ALT0; return 1;
+        case 18: *channel = 0; *alt_func = ALT5; return 1;
+        case 19: *channel = 1; *alt_func = ALT5; return 1;
+        default: return 0;
     }
+}
 
-#endif
+/*
+ * Frequency planning. A candidate is a (source, DIVI, DIVF) triple; its
+ * clock is src * 4096 / (DIVI * 4096 + DIVF) and each channel's range is
+ * the clock divided by the target frequency, rounded.
+ */
 
-int hpwm_init(void) {
-#ifdef RPI_HW_PWM_PLATFORM_HOST
-    printf("MOCK: hpwm_init() called.\n");
-    return 0;
-#else
-    if ((mem_fd_hw = open("/dev/mem", O_RDWR|O_SYNC) ) < 0) {
-        perror("Can't open /dev/mem (Need sudo?)");
-        return -1;
+/** Fill plan for one divider; returns 0 if the clock or a range is out of bounds. */
+static int hpwm_plan_eval(int src, uint32_t divi, uint32_t divf, const int freq[2],
+                          hpwm_plan_t* plan, double* err) {
+    double src_hz = (src == CM_SRC_PLLD) ? HPWM_PLLD_HZ : HPWM_OSC_HZ;
+    double clock = src_hz * 4096.0 / (divi * 4096.0 + divf);
+    if (divi < 2 || divi > HPWM_DIVI_MAX || clock > HPWM_CLOCK_MAX_HZ) return 0;
+
+    plan->src = src;
+    plan->divi = divi;
+    plan->divf = divf;
+    plan->mash = divf ? 1 : 0;
+    plan->clock_hz = clock;
+    *err = 0.0;
+    for (int c = 0; c < 2; c++) {
+        plan->range[c] = 0;
+        plan->freq_hz[c] = 0.0;
+        if (freq[c] <= 0) continue;
+
+        double range = clock / freq[c] + 0.5;
+        if (range < 2.0 || range > 4294967295.0) return 0;
+        plan->range[c] = (uint32_t)range;
+        plan->freq_hz[c] = clock / plan->range[c];
+
+        double e = (plan->freq_hz[c] - freq[c]) / freq[c];
+        if (e < 0) e = -e;
+        if (e > *err) *err = e;
     }
+    return 1;
+}
+
+static uint32_t hpwm_plan_min_range(const hpwm_plan_t* plan) {
+    uint32_t r = UINT32_MAX;
+    for (int c = 0; c < 2; c++) {
+        if (plan->range[c] && plan->range[c] < r) r = plan->range[c];
+    }
+    return r;
+}
 
-    pwm_map = (volatile uint32_t *)mmap(
-        NULL,
-        BLOCK_SIZE,
-        PROT_READ|PROT_WRITE,
-        MAP_SHARED,
-        mem_fd_hw,
-        PERIPHERAL_BASE + PWM_OFFSET
-    );
+/** 1 if candidate a beats b. */
+static int hpwm_plan_better(const hpwm_plan_t* a, double err_a, const hpwm_plan_t* b, double err_b) {
+    const double tol = HPWM_PLAN_TOLERANCE_PPM / 1e6;
+    int ok_a = err_a <= tol, ok_b = err_b <= tol;
+    if (ok_a != ok_b) return ok_a;
+    if (!ok_a) return err_a < err_b;
 
-    if (pwm_map == MAP_FAILED) {
-        perror("mmap PWM error");
-        close(mem_fd_hw);
-        return -1;
+    uint32_t ra = hpwm_plan_min_range(a), rb = hpwm_plan_min_range(b);
+    if (ra != rb) return ra > rb;
+    if (a->mash != b->mash) return a->mash < b->mash;
+    return err_a < err_b;
+}
+
+int hpwm_plan(int freq0_hz, int freq1_hz, hpwm_plan_t* plan) {
+    const int freq[2] = { freq0_hz, freq1_hz };
+    if (!plan || freq0_hz < 0 || freq1_hz < 0 || (freq0_hz == 0 && freq1_hz == 0)) return -1;
+    if (freq0_hz > HPWM_CLOCK_MAX_HZ / 2 || freq1_hz > HPWM_CLOCK_MAX_HZ / 2) return -1;
+
+    const int sources[2] = { CM_SRC_OSC, CM_SRC_PLLD };
+    hpwm_plan_t best, cand;
+    double best_err = 0.0, err;
+    int found = 0;
+
+    for (int s = 0; s < 2; s++) {
+        double src_hz = (sources[s] == CM_SRC_PLLD) ? HPWM_PLLD_HZ : HPWM_OSC_HZ;
+
+        /* Integer dividers, fastest clock first */
+        for (uint32_t divi = 2; divi <= HPWM_DIVI_MAX; divi++) {
+            if (!hpwm_plan_eval(sources[s], divi, 0, freq, &cand, &err)) continue;
+            if (!found || hpwm_plan_better(&cand, err, &best, best_err)) {
+                best = cand;
+                best_err = err;
+                found = 1;
+            }
+        }
+
+        /* Fractional divider that makes channel c exact at its largest range */
+        double clock_max = src_hz / 2 < HPWM_CLOCK_MAX_HZ ? src_hz / 2 : HPWM_CLOCK_MAX_HZ;
+        for (int c = 0; c < 2; c++) {
+            if (freq[c] <= 0) continue;
+            double range = (double)(uint64_t)(clock_max / freq[c]);
+            if (range < 2.0) continue;
+
+            double div = src_hz / (freq[c] * range);
+            uint32_t divi = (uint32_t)div;
+            uint32_t divf = (uint32_t)((div - divi) * 4096.0 + 0.5);
+            if (divf == 4096) { divi++; divf = 0; }
+            if (!hpwm_plan_eval(sources[s], divi, divf, freq, &cand, &err)) continue;
+            if (!found || hpwm_plan_better(&cand, err, &best, best_err)) {
+                best = cand;
+                best_err = err;
+                found = 1;
+            }
+        }
     }
 
-    clk_map = (volatile uint32_t *)mmap(
-        NULL,
-        BLOCK_SIZE,
-        PROT_READ|PROT_WRITE,
-        MAP_SHARED,
-        mem_fd_hw,
-        PERIPHERAL_BASE + CLK_OFFSET
-    );
+    if (!found) return -1;
+    *plan = best;
+    return 0;
+}
 
-    if (clk_map == MAP_FAILED) {
-        perror("mmap CLK error");
-        munmap((void*)pwm_map, BLOCK_SIZE);
-        close(mem_fd_hw);
-        return -1;
+/**
+ * Divider for a given PWM clock (serializer slot rate). The closest integer
+ * divider of either source wins if within tolerance, otherwise a MASH
+ * divider of PLLD hits it exactly (jitter of one PLLD cycle).
+ */
+static int hpwm_plan_clock(double clock_hz, hpwm_plan_t* plan) {
+    if (clock_hz <= 0.0 || clock_hz > HPWM_CLOCK_MAX_HZ) return -1;
+
+    const int sources[2] = { CM_SRC_OSC, CM_SRC_PLLD };
+    double best_err = 2.0;
+    memset(plan, 0, sizeof(*plan));
+    for (int s = 0; s < 2; s++) {
+        double src_hz = (sources[s] == CM_SRC_PLLD) ? HPWM_PLLD_HZ : HPWM_OSC_HZ;
+        uint32_t divi = (uint32_t)(src_hz / clock_hz + 0.5);
+        if (divi < 2 || divi > HPWM_DIVI_MAX) continue;
+        double err = (src_hz / divi - clock_hz) / clock_hz;
+        if (err < 0) err = -err;
+        if (err < best_err) {
+            best_err = err;
+            plan->src = sources[s];
+            plan->divi = divi;
+            plan->clock_hz = src_hz / divi;
+        }
     }
 
-    /*
-     * Clock setup for 1 MHz PWM frequency:
-     * - Stop the clock (write PASSWD | KILL bit)
-     * - Wait for clock to become idle (BUSY bit clear)
-     * - Set divider: 500 MHz PLLD / 54 ≈ 9.26 MHz integer, but we use
-     *   this as base for range calculations to achieve desired freq
-     * - Enable clock with PLLD source
-     */
-    clk_map[CM_PWMCTL] = CM_PASSWD | 1;  /* Stop clock */
+    if (best_err > HPWM_PLAN_TOLERANCE_PPM / 1e6) {
+        double div = HPWM_PLLD_HZ / clock_hz;
+        uint32_t divi = (uint32_t)div;
+        uint32_t divf = (uint32_t)((div - divi) * 4096.0 + 0.5);
+        if (divf == 4096) { divi++; divf = 0; }
+        if (divi < 2 || divi > HPWM_DIVI_MAX) return best_err <= 1.0 ? 0 : -1;
+        plan->src = CM_SRC_PLLD;
+        plan->divi = divi;
+        plan->divf = divf;
+        plan->mash = divf ? 1 : 0;
+        plan->clock_hz = HPWM_PLLD_HZ * 4096.0 / (divi * 4096.0 + divf);
+    }
+    return 0;
+}
+
+/** Start-up clock: oscillator / 54 = 1 MHz. */
+static void hpwm_plan_base(hpwm_plan_t* plan) {
+    plan->src = CM_SRC_OSC;
+    plan->divi = CM_DIV_VALUE;
+    plan->divf = 0;
+    plan->mash = 0;
+    plan->clock_hz = PWM_BASE_FREQ_HZ;
+    plan->range[0] = plan->range[1] = 0;
+    plan->freq_hz[0] = plan->freq_hz[1] = 0.0;
+}
+
+static int hpwm_plan_same_clock(const hpwm_plan_t* a, const hpwm_plan_t* b) {
+    return a->src == b->src && a->divi == b->divi && a->divf == b->divf && a->mash == b->mash;
+}
+
+/*
+ * Clock setup:
+ * - Stop the clock (source written without ENAB)
+ * - Wait for clock to become idle (BUSY bit clear)
+ * - Set DIVI/DIVF, then enable with the planned source and MASH stage
+ */
+static void hpwm_cm_setup(volatile uint32_t* clk, int ctl, const hpwm_plan_t* plan) {
+    clk[ctl] = CM_PASSWD | 1;  /* Stop clock */
     usleep(100);
 
-    while (clk_map[CM_PWMCTL] & 0x80) usleep(1);  /* Wait for not BUSY */
+    while (clk[ctl] & CM_BUSY) usleep(1);  /* Wait for not BUSY */
 
-    clk_map[CM_PWMDIV] = CM_PASSWD | (CM_DIV_VALUE << 12) | 0;
-    clk_map[CM_PWMCTL] = CM_PASSWD | CM_SRC_PLLD | 0x10;  /* Enable with PLLD */
+    clk[ctl + 1] = CM_PASSWD | (plan->divi << 12) | plan->divf;  /* CM_xxxDIV follows CM_xxxCTL */
+    clk[ctl] = CM_PASSWD | ((uint32_t)plan->mash << CM_MASH_SHIFT) | plan->src;
+    clk[ctl] = CM_PASSWD | ((uint32_t)plan->mash << CM_MASH_SHIFT) | plan->src | CM_ENAB;
     usleep(100);
+}
+
+static void hpwm_clock_setup(volatile uint32_t* clk, const hpwm_plan_t* plan) {
+    hpwm_cm_setup(clk, CM_PWMCTL, plan);
+}
+
+static void hpwm_cache_reset(hpwm_ctx_t* ctx) {
+    for (int c = 0; c < 2; c++) {
+        ctx->ch[c].freq_hz = 0;
+        ctx->ch[c].range = 0;
+        ctx->ch[c].data = 0;
+        ctx->ch[c].pin = -1;
+        ctx->ch[c].enabled = 0;
+    }
+    ctx->serial = -1;
+}
 
+int hpwm_ctx_attach(hpwm_ctx_t* ctx, volatile uint32_t* pwm_regs,
+                    volatile uint32_t* clk_regs, gpio_ctx_t* gpio) {
+    if (!ctx || !pwm_regs || !clk_regs) return -1;
+    ctx->pwm = pwm_regs;
+    ctx->clk = clk_regs;
+    ctx->gpio = gpio ? gpio : &gpio_ctx_default;
+    ctx->mapped = 0;
+    ctx->updates = 0;
+    ctx->reconfigs = 0;
+    hpwm_cache_reset(ctx);
+    hpwm_plan_base(&ctx->plan);
+    hpwm_clock_setup(ctx->clk, &ctx->plan);
     return 0;
-#endif
 }
 
-void hpwm_set(int pin, int freq_hz, int duty_per_mille) {
-    if (freq_hz <= 0) return;
+int hpwm_ctx_init(hpwm_ctx_t* ctx, gpio_ctx_t* gpio) {
+    if (!ctx) return -1;
+
+    volatile uint32_t* pwm = periph_map(PERIPH_PWM);
+    if (!pwm) return -1;
+
+    volatile uint32_t* clk = periph_map(PERIPH_CLK);
+    if (!clk) {
+        periph_unmap(PERIPH_PWM);
+        return -1;
+    }
+
+    hpwm_ctx_attach(ctx, pwm, clk, gpio);
+    ctx->mapped = 1;
+    return 0;
+}
+
+/** Channel register indices and control bits. */
+static const struct {
+    int rng, dat;
+    uint32_t pwen, msen;
+} hpwm_regs[2] = {
+    { PWM_RNG1, PWM_DAT1, PWM_CTL_PWEN1, PWM_CTL_MSEN1 },
+    { PWM_RNG2, PWM_DAT2, PWM_CTL_PWEN2, PWM_CTL_MSEN2 },
+};
+
+/** Write PWM_DATn if it differs from the cache. */
+static void hpwm_write_data(hpwm_ctx_t* ctx, int channel, uint32_t data) {
+    hpwm_channel_t* ch = &ctx->ch[channel];
+    if (ch->data == data) return;
+    ctx->pwm[hpwm_regs[channel].dat] = data;
+    ch->data = data;
+    ctx->updates++;
+}
+
+int hpwm_ctx_set(hpwm_ctx_t* ctx, int pin, int freq_hz, int duty_per_mille) {
+    if (freq_hz <= 0) return -1;
     duty_per_mille = HPWM_CLAMP_DUTY(duty_per_mille);
 
-#ifdef RPI_HW_PWM_PLATFORM_HOST
-    printf("MOCK: HW PWM set on Pin %d to %d Hz, Duty %d/1000\n", pin, freq_hz, duty_per_mille);
-#else
-    if (!pwm_map || !clk_map) return;
+    volatile uint32_t* pwm = ctx->pwm;
+    if (!pwm || !ctx->clk) return -1;
+    if (ctx->serial >= 0) return -1;  /* A replan would retime the serializer */
 
     int channel, alt_func;
     if (!hpwm_get_channel(pin, &channel, &alt_func)) {
-        return;  /* Invalid HW PWM pin */
+        return -1;  /* Invalid HW PWM pin */
     }
 
-    gpio_set_function(pin, alt_func);
+    hpwm_channel_t* ch = &ctx->ch[channel];
+    if (ch->pin != pin) {
+        gpio_ctx_set_function(ctx->gpio, pin, alt_func);
+        ch->pin = pin;
+    }
+
+    if (ch->enabled && ch->freq_hz == freq_hz) {
+        /* Same period: duty only */
+        hpwm_write_data(ctx, channel, (uint64_t)ch->range * duty_per_mille / HPWM_DUTY_MAX);
+        return 0;
+    }
+
+    int freqs[2] = { ctx->ch[0].enabled ? ctx->ch[0].freq_hz : 0,
+                     ctx->ch[1].enabled ? ctx->ch[1].freq_hz : 0 };
+    freqs[channel] = freq_hz;
+    hpwm_plan_t plan;
+    if (hpwm_plan(freqs[0], freqs[1], &plan) != 0) return -1;
+
+    /* A new clock affects both channels, so both are stopped and rewritten */
+    int clock_changed = !hpwm_plan_same_clock(&plan, &ctx->plan);
+    uint32_t enable = 0;
+    for (int c = 0; c < 2; c++) {
+        if (c == channel || (clock_changed && ctx->ch[c].enabled)) {
+            enable |= hpwm_regs[c].pwen;
+        }
+    }
+
+    pwm[PWM_CTL] &= ~enable;  /* Disable affected channels */
+    usleep(10);
+
+    if (clock_changed) {
+        hpwm_clock_setup(ctx->clk, &plan);
+    }
+
+    for (int c = 0; c < 2; c++) {
+        if (!(enable & hpwm_regs[c].pwen)) continue;
+        hpwm_channel_t* cc = &ctx->ch[c];
+        uint32_t range = plan.range[c];
+        uint32_t data = (c == channel)
+            ? (uint64_t)range * duty_per_mille / HPWM_DUTY_MAX
+            : (uint64_t)range * cc->data / cc->range;  /* Keep the other channel's duty */
+
+        pwm[hpwm_regs[c].rng] = range;
+        pwm[hpwm_regs[c].dat] = data;
+        cc->freq_hz = freqs[c];
+        cc->range = range;
+        cc->data = data;
+        cc->enabled = 1;
+        enable |= hpwm_regs[c].msen;
+    }
+
+    pwm[PWM_CTL] |= enable;  /* M/S mode + enable */
+
+    ctx->plan = plan;
+    ctx->updates++;
+    ctx->reconfigs++;
+    return 0;
+}
 
-    uint32_t range = PWM_BASE_FREQ_HZ / freq_hz;
-    uint32_t data = (uint64_t)range * duty_per_mille / HPWM_DUTY_MAX;
+int hpwm_ctx_set_duty(hpwm_ctx_t* ctx, int pin, int duty_per_mille) {
+    int channel, alt_func;
+    if (!ctx || !ctx->pwm || !hpwm_get_channel(pin, &channel, &alt_func)) return -1;
+    if (ctx->serial >= 0) return -1;
 
-    if (channel == 0) {
-        pwm_map[PWM_CTL] &= ~PWM_CTL_PWEN1;  /* Disable channel 1 */
-        usleep(10);
+    hpwm_channel_t* ch = &ctx->ch[channel];
+    if (!ch->enabled || ch->pin != pin) return -1;
 
-        pwm_map[PWM_RNG1] = range;
-        pwm_map[PWM_DAT1] = data;
+    duty_per_mille = HPWM_CLAMP_DUTY(duty_per_mille);
+    hpwm_write_data(ctx, channel, (uint64_t)ch->range * duty_per_mille / HPWM_DUTY_MAX);
+    return 0;
+}
 
-        pwm_map[PWM_CTL] |= PWM_CTL_MSEN1 | PWM_CTL_PWEN1;  /* M/S mode + enable */
-    } else {
-        pwm_map[PWM_CTL] &= ~PWM_CTL_PWEN2;  /* Disable channel 2 */
-        usleep(10);
+void hpwm_ctx_stop(hpwm_ctx_t* ctx) {
+    if (!ctx) return;
+    if (ctx->pwm) {
+        ctx->pwm[PWM_CTL] = 0;
+    }
+    hpwm_cache_reset(ctx);
+    if (ctx->mapped) {
+        periph_unmap(PERIPH_PWM);
+        periph_unmap(PERIPH_CLK);
+        ctx->mapped = 0;
+    }
+    ctx->pwm = NULL;
+    ctx->clk = NULL;
+}
 
-        pwm_map[PWM_RNG2] = range;
-        pwm_map[PWM_DAT2] = data;
+/* ============================================================================
+ * FIFO STREAMING
+ * ============================================================================ */
 
-        pwm_map[PWM_CTL] |= PWM_CTL_MSEN2 | PWM_CTL_PWEN2;  /* M/S mode + enable */
+static const uint32_t hpwm_usef[2] = { PWM_CTL_USEF1, PWM_CTL_USEF2 };
+
+static uint32_t* hpwm_stream_segment(hpwm_stream_t* st, int seg) {
+    return st->samples + (size_t)seg * st->segment_samples;
+}
+
+/** Stop one channel and forget its setting; the other keeps running. */
+static void hpwm_channel_off(hpwm_ctx_t* ctx, int channel) {
+    ctx->pwm[PWM_CTL] &= ~(hpwm_usef[channel] | hpwm_regs[channel].pwen);
+    ctx->ch[channel].enabled = 0;
+    ctx->ch[channel].freq_hz = 0;
+}
+
+static void hpwm_stream_clear(hpwm_stream_t* st, int seg) {
+    uint32_t* p = hpwm_stream_segment(st, seg);
+    for (int i = 0; i < st->segment_samples; i++) p[i] = st->idle;
+}
+
+int hpwm_stream_open(hpwm_stream_t* st, hpwm_ctx_t* ctx, dma_chan_t* dma,
+                     const hpwm_stream_config_t* cfg) {
+    int channel, alt_func;
+    if (!st || !ctx || !ctx->pwm || !dma || !dma->regs || !cfg) return -1;
+    if (!hpwm_get_channel(cfg->pin, &channel, &alt_func) || cfg->sample_rate <= 0) return -1;
+    if (cfg->segment_samples <= 0 || cfg->segments < 2 || cfg->segments > HPWM_STREAM_MAX_SEGMENTS) return -1;
+    if (ctx->pwm[PWM_CTL] & (PWM_CTL_USEF1 | PWM_CTL_USEF2)) return -1;  /* FIFO in use */
+
+    /* Allocate before the channel starts, so a failure leaves the pin idle */
+    memset(st, 0, sizeof(*st));
+    size_t cb_bytes = (size_t)cfg->segments * sizeof(dma_cb_t);
+    size_t sample_bytes = (size_t)cfg->segments * cfg->segment_samples * sizeof(uint32_t);
+    if (dma_mem_alloc(&st->mem, cb_bytes + sample_bytes) != 0) return -1;
+
+    hpwm_ctx_set(ctx, cfg->pin, cfg->sample_rate, 500);
+    if (!ctx->ch[channel].enabled || ctx->ch[channel].freq_hz != cfg->sample_rate) {
+        hpwm_channel_off(ctx, channel);
+        dma_mem_free(&st->mem);
+        return -1;
+    }
+
+    st->ctx = ctx;
+    st->dma = dma;
+    st->cbs = (dma_cb_t*)st->mem.virt;
+    st->samples = (uint32_t*)((uint8_t*)st->mem.virt + cb_bytes);
+    st->channel = channel;
+    st->segments = cfg->segments;
+    st->segment_samples = cfg->segment_samples;
+    st->range = ctx->ch[channel].range;
+    st->idle = st->range / 2;
+    st->scale = ((uint64_t)st->range << 32) / 65535;
+
+    /* Closed ring: segment i -> PWM FIFO, paced by the PWM DREQ */
+    uint32_t fifo_bus = dma_periph_bus(PERIPH_PWM, PWM_FIF1);
+    for (int i = 0; i < st->segments; i++) {
+        dma_cb_t* cb = &st->cbs[i];
+        cb->ti = DMA_TI_NO_WIDE_BURSTS | DMA_TI_WAIT_RESP | DMA_TI_DEST_DREQ |
+                 DMA_TI_PERMAP(DMA_DREQ_PWM) | DMA_TI_SRC_INC;
+        cb->source_ad = dma_mem_bus(&st->mem, hpwm_stream_segment(st, i));
+        cb->dest_ad = fifo_bus;
+        cb->txfr_len = (uint32_t)st->segment_samples * sizeof(uint32_t);
+        cb->stride = 0;
+        cb->nextconbk = dma_mem_bus(&st->mem, &st->cbs[(i + 1) % st->segments]);
+        hpwm_stream_clear(st, i);
+    }
+
+    volatile uint32_t* pwm = ctx->pwm;
+    pwm[PWM_CTL] |= PWM_CTL_CLRF1;
+    pwm[PWM_DMAC] = PWM_DMAC_ENAB | PWM_DMAC_PANIC(7) | PWM_DMAC_DREQ(3);
+    pwm[PWM_CTL] |= hpwm_usef[channel];
+    return 0;
+}
+
+/** Segment the DMA engine is reading, -1 if not running. */
+static int hpwm_stream_current(const hpwm_stream_t* st) {
+    uint32_t cb = dma_chan_cb(st->dma);
+    uint32_t base = dma_mem_bus(&st->mem, st->cbs);
+    if (!st->running || cb < base) return -1;
+    uint32_t seg = (cb - base) / sizeof(dma_cb_t);
+    return seg < (uint32_t)st->segments ? (int)seg : -1;
+}
+
+int hpwm_stream_poll(hpwm_stream_t* st) {
+    if (!st || !st->samples) return 0;
+
+    int cur = hpwm_stream_current(st);
+    if (cur >= 0) {
+        while (st->done != cur) {
+            int seg = st->done;
+            if (st->ready[seg]) {
+                st->played += st->segment_samples;
+            } else {
+                st->underruns++;
+                if (seg == st->fill) {
+                    st->fill = (seg + 1) % st->segments;  /* Too late for this one */
+                    st->fill_pos = 0;
+                }
+            }
+            hpwm_stream_clear(st, seg);  /* Idle if not refilled before the next lap */
+            st->ready[seg] = 0;
+            st->done = (seg + 1) % st->segments;
+        }
+    }
+
+    int free_segments = 0;
+    for (int i = 0; i < st->segments; i++) {
+        if (!st->ready[i] && i != cur) free_segments++;
+    }
+    int avail = free_segments * st->segment_samples - st->fill_pos;
+    return avail > 0 ? avail : 0;
+}
+
+int hpwm_stream_write(hpwm_stream_t* st, const uint16_t* samples, int count) {
+    if (!st || !st->samples || !samples || count <= 0) return 0;
+
+    hpwm_stream_poll(st);
+    int cur = hpwm_stream_current(st);
+    int accepted = 0;
+
+    while (accepted < count && !st->ready[st->fill]) {
+        if (st->fill == cur) {
+            /* Producer fell behind the DMA engine: skip the segment being played */
+            st->fill = (st->fill + 1) % st->segments;
+            st->fill_pos = 0;
+            continue;
+        }
+
+        uint32_t* dst = hpwm_stream_segment(st, st->fill) + st->fill_pos;
+        int n = st->segment_samples - st->fill_pos;
+        if (n > count - accepted) n = count - accepted;
+        for (int i = 0; i < n; i++) {
+            dst[i] = (uint32_t)(((uint64_t)samples[accepted + i] * st->scale) >> 32);
+        }
+        accepted += n;
+        st->fill_pos += n;
+
+        if (st->fill_pos == st->segment_samples) {
+            st->ready[st->fill] = 1;
+            st->fill = (st->fill + 1) % st->segments;
+            st->fill_pos = 0;
+        }
+    }
+    st->written += accepted;
+    return accepted;
+}
+
+void hpwm_stream_start(hpwm_stream_t* st) {
+    if (!st || !st->samples || st->running) return;
+    st->running = 1;
+    dma_chan_start(st->dma, dma_mem_bus(&st->mem, st->cbs));
+}
+
+void hpwm_stream_close(hpwm_stream_t* st) {
+    if (!st || !st->samples) return;
+    dma_chan_stop(st->dma);
+
+    if (st->ctx->pwm) {
+        volatile uint32_t* pwm = st->ctx->pwm;
+        pwm[PWM_DMAC] = 0;
+        hpwm_channel_off(st->ctx, st->channel);
+        pwm[PWM_CTL] |= PWM_CTL_CLRF1;
+    }
+    dma_mem_free(&st->mem);
+    st->samples = NULL;
+    st->cbs = NULL;
+    st->running = 0;
+}
+
+/* ============================================================================
+ * SERIALIZER
+ * ============================================================================ */
+
+static const uint32_t hpwm_mode[2] = { PWM_CTL_MODE1, PWM_CTL_MODE2 };
+
+/** Expand every byte value into its slot bits, MSB first. */
+static void hpwm_serial_build_lut(hpwm_serial_t* ser, uint8_t zero, uint8_t one) {
+    int k = ser->symbol_slots;
+    for (int b = 0; b < 256; b++) {
+        uint32_t bits = 0;
+        for (int i = 7; i >= 0; i--) {
+            bits = (bits << k) | ((b >> i) & 1 ? one : zero);
+        }
+        ser->lut[b] = bits;
     }
+}
+
+int hpwm_serial_open(hpwm_serial_t* ser, hpwm_ctx_t* ctx, dma_chan_t* dma,
+                     const hpwm_serial_config_t* cfg) {
+    int channel, alt_func;
+    if (!ser || !ctx || !ctx->pwm || !ctx->clk || !dma || !dma->regs || !cfg) return -1;
+    if (!hpwm_get_channel(cfg->pin, &channel, &alt_func)) return -1;
+    if (cfg->symbol_slots < 1 || cfg->symbol_slots > 4 || cfg->max_bytes <= 0 || cfg->reset_us < 0) return -1;
+    if (cfg->zero >> cfg->symbol_slots || cfg->one >> cfg->symbol_slots) return -1;
+
+    hpwm_plan_t plan;
+    if (hpwm_plan_clock(cfg->slot_rate, &plan) != 0) return -1;
+
+    volatile uint32_t* pwm = ctx->pwm;
+    if (pwm[PWM_CTL] & (PWM_CTL_USEF1 | PWM_CTL_USEF2)) return -1;  /* FIFO in use */
+    if (ctx->ch[1 - channel].enabled) return -1;                    /* Clock in use */
+    if (ctx->serial >= 0) return -1;                                /* Already open */
+
+    memset(ser, 0, sizeof(*ser));
+    ser->symbol_slots = cfg->symbol_slots;
+    ser->max_bytes = cfg->max_bytes;
+    ser->reset_words = (int)(((uint64_t)cfg->reset_us * (uint64_t)plan.clock_hz / 1000000 +
+                              HPWM_SERIAL_WORD_BITS - 1) / HPWM_SERIAL_WORD_BITS);
+    hpwm_serial_build_lut(ser, cfg->zero, cfg->one);
+
+    size_t words = hpwm_serial_words(ser, (size_t)cfg->max_bytes) + (size_t)ser->reset_words;
+    if (dma_mem_alloc(&ser->mem, sizeof(dma_cb_t) + words * sizeof(uint32_t)) != 0) return -1;
+
+    ser->ctx = ctx;
+    ser->dma = dma;
+    ser->channel = channel;
+    ser->cb = (dma_cb_t*)ser->mem.virt;
+    ser->words = (uint32_t*)((uint8_t*)ser->mem.virt + sizeof(dma_cb_t));
+    ser->cb->ti = DMA_TI_NO_WIDE_BURSTS | DMA_TI_WAIT_RESP | DMA_TI_DEST_DREQ |
+                  DMA_TI_PERMAP(DMA_DREQ_PWM) | DMA_TI_SRC_INC;
+    ser->cb->source_ad = dma_mem_bus(&ser->mem, ser->words);
+    ser->cb->dest_ad = dma_periph_bus(PERIPH_PWM, PWM_FIF1);
+
+    hpwm_channel_t* ch = &ctx->ch[channel];
+    if (ch->pin != cfg->pin) {
+        gpio_ctx_set_function(ctx->gpio, cfg->pin, alt_func);
+        ch->pin = cfg->pin;
+    }
+
+    pwm[PWM_CTL] &= ~hpwm_regs[channel].pwen;
+    usleep(10);
+    if (!hpwm_plan_same_clock(&plan, &ctx->plan)) {
+        hpwm_clock_setup(ctx->clk, &plan);
+    }
+    plan.range[channel] = HPWM_SERIAL_WORD_BITS;
+    plan.freq_hz[channel] = plan.clock_hz / HPWM_SERIAL_WORD_BITS;
+    ctx->plan = plan;
+
+    /* Idle low between frames: SBIT = 0, no repeat */
+    pwm[hpwm_regs[channel].rng] = HPWM_SERIAL_WORD_BITS;
+    pwm[PWM_CTL] |= PWM_CTL_CLRF1;
+    pwm[PWM_DMAC] = PWM_DMAC_ENAB | PWM_DMAC_PANIC(7) | PWM_DMAC_DREQ(3);
+    pwm[PWM_CTL] |= hpwm_mode[channel] | hpwm_usef[channel] | hpwm_regs[channel].pwen;
+
+    ch->freq_hz = 0;  /* Not a duty-cycle channel: hpwm_ctx_set_duty() refuses it */
+    ch->range = HPWM_SERIAL_WORD_BITS;
+    ch->data = 0;
+    ch->enabled = 0;
+    ctx->serial = channel;
+    ctx->updates++;
+    ctx->reconfigs++;
+    return 0;
+}
+
+size_t hpwm_serial_words(const hpwm_serial_t* ser, size_t len) {
+    return (len * 8 * ser->symbol_slots + HPWM_SERIAL_WORD_BITS - 1) / HPWM_SERIAL_WORD_BITS;
+}
+
+size_t hpwm_serial_encode(const hpwm_serial_t* ser, const uint8_t* data, size_t len, uint32_t* out) {
+    const uint32_t* lut = ser->lut;
+    uint32_t* w = out;
+    size_t i = 0;
+
+    if (ser->symbol_slots == 3) {
+        /* 4 bytes -> 96 slots -> exactly 3 words, no carry between groups */
+        for (; i + 4 <= len; i += 4) {
+            uint32_t a = lut[data[i]], b = lut[data[i + 1]];
+            uint32_t c = lut[data[i + 2]], d = lut[data[i + 3]];
+            w[0] = (a << 8) | (b >> 16);
+            w[1] = (b << 16) | (c >> 8);
+            w[2] = (c << 24) | d;
+            w += 3;
+        }
+    } else if (ser->symbol_slots == 4) {
+        for (; i < len; i++) *w++ = lut[data[i]];
+    }
+
+    /* Generic path and tail: bit accumulator, at most 63 bits live */
+    int k = 8 * ser->symbol_slots;
+    uint64_t acc = 0;
+    int bits = 0;
+    for (; i < len; i++) {
+        acc = (acc << k) | lut[data[i]];
+        bits += k;
+        if (bits >= HPWM_SERIAL_WORD_BITS) {
+            bits -= HPWM_SERIAL_WORD_BITS;
+            *w++ = (uint32_t)(acc >> bits);
+        }
+    }
+    if (bits) *w++ = (uint32_t)(acc << (HPWM_SERIAL_WORD_BITS - bits));
+    return (size_t)(w - out);
+}
+
+int hpwm_serial_busy(const hpwm_serial_t* ser) {
+    return ser && ser->words && dma_chan_active(ser->dma);
+}
+
+int hpwm_serial_send(hpwm_serial_t* ser, const uint8_t* data, size_t len) {
+    if (!ser || !ser->words || (!data && len) || len > (size_t)ser->max_bytes) return -1;
+    if (hpwm_serial_busy(ser)) return -1;
+
+    size_t n = hpwm_serial_encode(ser, data, len, ser->words);
+    memset(ser->words + n, 0, (size_t)ser->reset_words * sizeof(uint32_t));
+    n += (size_t)ser->reset_words;
+    if (n == 0) return 0;
+
+    ser->cb->txfr_len = (uint32_t)(n * sizeof(uint32_t));
+    ser->cb->nextconbk = 0;
+    dma_chan_start(ser->dma, dma_mem_bus(&ser->mem, ser->cb));
+    ser->frames++;
+    return 0;
+}
+
+void hpwm_serial_close(hpwm_serial_t* ser) {
+    if (!ser || !ser->words) return;
+    dma_chan_stop(ser->dma);
+
+    if (ser->ctx->pwm) {
+        volatile uint32_t* pwm = ser->ctx->pwm;
+        int c = ser->channel;
+        pwm[PWM_DMAC] = 0;
+        pwm[PWM_CTL] &= ~(hpwm_mode[c] | hpwm_usef[c] | hpwm_regs[c].pwen);
+        pwm[PWM_CTL] |= PWM_CTL_CLRF1;
+        ser->ctx->ch[c].range = 0;
+        ser->ctx->plan.range[c] = 0;
+        ser->ctx->plan.freq_hz[c] = 0.0;
+    }
+    ser->ctx->serial = -1;
+    dma_mem_free(&ser->mem);
+    ser->words = NULL;
+    ser->cb = NULL;
+}
+
+/* ============================================================================
+ * SIMULATED PWM BLOCK
+ * ============================================================================ */
+
+void hpwm_sim_init(hpwm_sim_t* sim, uint32_t* log, size_t log_cap) {
+    memset(sim, 0, sizeof(*sim));
+    sim->log = log;
+    sim->log_cap = log_cap;
+}
+
+/** Clock programmed at clk[ctl] / clk[ctl + 1] in a simulated clock manager, 0 if stopped. */
+static double hpwm_sim_cm_clock(const uint32_t* clk, int ctl_reg) {
+    uint32_t ctl = clk[ctl_reg], div = clk[ctl_reg + 1];
+    if (!(ctl & CM_ENAB)) return 0.0;
+    double src_hz = ((ctl & 0xF) == CM_SRC_PLLD) ? HPWM_PLLD_HZ : HPWM_OSC_HZ;
+    uint32_t divi = (div >> 12) & 0xFFF, divf = div & 0xFFF;
+    if (divi == 0) return 0.0;
+    return src_hz * 4096.0 / (divi * 4096.0 + divf);
+}
+
+static double hpwm_sim_clock(const hpwm_sim_t* sim) {
+    return hpwm_sim_cm_clock(sim->clk, CM_PWMCTL);
+}
+
+static void hpwm_sim_update_status(hpwm_sim_t* sim) {
+    uint32_t sta = sim->pwm[PWM_STA] & ~(PWM_STA_FULL1 | PWM_STA_EMPT1);
+    if (sim->fifo_count == HPWM_FIFO_DEPTH) sta |= PWM_STA_FULL1;
+    if (sim->fifo_count == 0) sta |= PWM_STA_EMPT1;
+    sim->pwm[PWM_STA] = sta;
+}
+
+static uint64_t hpwm_sim_advance(void* user, uint64_t now_ns) {
+    hpwm_sim_t* sim = (hpwm_sim_t*)user;
+    uint32_t ctl = sim->pwm[PWM_CTL];
+
+    if (ctl & PWM_CTL_CLRF1) {
+        sim->fifo_count = 0;
+        sim->pwm[PWM_CTL] = ctl &= ~PWM_CTL_CLRF1;
+    }
+
+    int channel = -1;
+    for (int c = 0; c < 2; c++) {
+        if ((ctl & hpwm_regs[c].pwen) && (ctl & hpwm_usef[c])) { channel = c; break; }
+    }
+    double clock = hpwm_sim_clock(sim);
+    uint32_t range = channel >= 0 ? sim->pwm[hpwm_regs[channel].rng] : 0;
+    if (channel < 0 || clock <= 0.0 || range == 0) {
+        sim->next_ns = 0.0;
+        hpwm_sim_update_status(sim);
+        return UINT64_MAX;
+    }
+
+    double period_ns = range * 1e9 / clock;
+    if (sim->next_ns == 0.0) sim->next_ns = (double)now_ns + period_ns;
+
+    while (sim->next_ns <= (double)now_ns) {
+        if (sim->fifo_count > 0) {
+            sim->last = sim->fifo[sim->fifo_head];
+            sim->fifo_head = (sim->fifo_head + 1) % HPWM_FIFO_DEPTH;
+            sim->fifo_count--;
+        } else {
+            sim->empty++;
+            if ((ctl & hpwm_mode[channel]) && !(ctl & (PWM_CTL_RPTL1 << (8 * channel)))) {
+                sim->last = (ctl & (PWM_CTL_SBIT1 << (8 * channel))) ? UINT32_MAX : 0;
+            }
+        }
+        if (sim->log && sim->log_len < sim->log_cap) sim->log[sim->log_len++] = sim->last;
+        sim->reads++;
+        sim->next_ns += period_ns;
+    }
+    hpwm_sim_update_status(sim);
+    return (uint64_t)sim->next_ns + 1;
+}
+
+static int hpwm_sim_dreq(void* user, int dreq) {
+    hpwm_sim_t* sim = (hpwm_sim_t*)user;
+    (void)dreq;
+    uint32_t dmac = sim->pwm[PWM_DMAC];
+    int threshold = (int)(dmac & 0xFF);  /* DREQ while the FIFO holds fewer words */
+    if (threshold > HPWM_FIFO_DEPTH) threshold = HPWM_FIFO_DEPTH;
+    return (dmac & PWM_DMAC_ENAB) && sim->fifo_count < threshold;
+}
+
+static void hpwm_sim_write(void* user, uint32_t reg, uint32_t value) {
+    hpwm_sim_t* sim = (hpwm_sim_t*)user;
+    if (reg != PWM_FIF1) {
+        sim->pwm[reg] = value;
+        return;
+    }
+    if (sim->fifo_count == HPWM_FIFO_DEPTH) {
+        sim->overflows++;
+        sim->pwm[PWM_STA] |= PWM_STA_WERR1;
+        return;
+    }
+    sim->fifo[(sim->fifo_head + sim->fifo_count) % HPWM_FIFO_DEPTH] = value;
+    sim->fifo_count++;
+    hpwm_sim_update_status(sim);
+}
+
+void hpwm_sim_device(hpwm_sim_t* sim, dma_sim_dev_t* dev) {
+    memset(dev, 0, sizeof(*dev));
+    dev->block = PERIPH_PWM;
+    dev->regs = sim->pwm;
+    dev->dreqs = 1u << DMA_DREQ_PWM;
+    dev->dreq = hpwm_sim_dreq;
+    dev->write = hpwm_sim_write;
+    dev->advance = hpwm_sim_advance;
+    dev->user = sim;
+}
+
+#ifdef RPI_HW_PWM_PLATFORM_RPI
+static hpwm_ctx_t hpwm_ctx_default = { NULL, NULL, NULL, 0, 0, 0, { { 0, 0, 0, -1, 0 }, { 0, 0, 0, -1, 0 } },
+                                        { 0, 0, 0, 0, 0.0, { 0, 0 }, { 0.0, 0.0 } }, -1 };
+#endif
+
+int hpwm_init(void) {
+#ifdef RPI_HW_PWM_PLATFORM_HOST
+    printf("MOCK: hpwm_init() called.\n");
+    return 0;
+#else
+    hpwm_ctx_stop(&hpwm_ctx_default);
+    return hpwm_ctx_init(&hpwm_ctx_default, &gpio_ctx_default);
+#endif
+}
+
+void hpwm_set(int pin, int freq_hz, int duty_per_mille) {
+#ifdef RPI_HW_PWM_PLATFORM_HOST
+    if (freq_hz <= 0) return;
+    duty_per_mille = HPWM_CLAMP_DUTY(duty_per_mille);
+    printf("MOCK: HW PWM set on Pin %d to %d Hz, Duty %d/1000\n", pin, freq_hz, duty_per_mille);
+#else
+    hpwm_ctx_set(&hpwm_ctx_default, pin, freq_hz, duty_per_mille);
+#endif
+}
+
+int hpwm_set_duty(int pin, int duty_per_mille) {
+#ifdef RPI_HW_PWM_PLATFORM_HOST
+    int channel, alt_func;
+    if (!hpwm_get_channel(pin, &channel, &alt_func)) return -1;
+    duty_per_mille = HPWM_CLAMP_DUTY(duty_per_mille);
+    printf("MOCK: HW PWM duty on Pin %d to %d/1000\n", pin, duty_per_mille);
+    return 0;
+#else
+    return hpwm_ctx_set_duty(&hpwm_ctx_default, pin, duty_per_mille);
 #endif
 }
 
@@ -248,19 +1338,7 @@ void hpwm_stop(void) {
 #ifdef RPI_HW_PWM_PLATFORM_HOST
     printf("MOCK: hpwm_stop() called.\n");
 #else
-    if (pwm_map) {
-        pwm_map[PWM_CTL] = 0;
-        munmap((void*)pwm_map, BLOCK_SIZE);
-        pwm_map = NULL;
-    }
-    if (clk_map) {
-        munmap((void*)clk_map, BLOCK_SIZE);
-        clk_map = NULL;
-    }
-    if (mem_fd_hw >= 0) {
-        close(mem_fd_hw);
-        mem_fd_hw = -1;
-    }
+    hpwm_ctx_stop(&hpwm_ctx_default);
 #endif
 }
 
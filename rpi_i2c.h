@@ -0,0 +1,812 @@
+/**
+ * @file rpi_i2c.h
+ * @brief Hardware BSC1 (I2C1) master via MMIO, with combined write-read.
+ *
+ * Single-header library. Define RPI_I2C_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h and root privileges (/dev/mem).
+ *
+ * i2c_ctx_init() maps the BSC1 block through rpi_periph.h and muxes
+ * GPIO 2/3 to ALT0, bypassing /dev/i2c-* and its syscalls per message:
+ *   - Combined write-read: the write is started, and as soon as the
+ *     controller reports it active the read is queued behind it, so the
+ *     BSC issues a repeated START instead of a STOP (the write part must
+ *     fit the 16-byte FIFO, which register addresses do).
+ *   - FIFO refill and drain: writes keep the FIFO topped up without a
+ *     status read per byte while TXW is set; reads drain it in blind
+ *     bursts while RXR is set. Transfers up to 65535 bytes.
+ *   - Low CPU: waits longer than I2C_SLEEP_MIN_US, sized from the bytes
+ *     still on the wire, are slept instead of polled, so a 400 kHz
+ *     register burst leaves the core mostly idle.
+ * i2c_ctx_read_regs() is the burst read of consecutive registers IMUs and
+ * similar sensors expect (one address write, one repeated START read).
+ *
+ * i2c_sim_t models the BSC registers, FIFO and bus timing in virtual time
+ * for host tests; CPU register accesses go through the model (each one
+ * costs I2C_SIM_ACCESS_NS) and slaves answer through callbacks.
+ */
+
+#ifndef RPI_I2C_H
+#define RPI_I2C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** BSC FIFO depth in bytes (shared by both directions). */
+#define I2C_FIFO_BYTES 16
+
+/** Longest transfer (DLEN is 16 bits). */
+#define I2C_MAX_LEN 65535
+
+/** Core clock feeding the BSC divider. */
+#ifndef I2C_CORE_HZ
+#define I2C_CORE_HZ 500000000u
+#endif
+
+/** Default bus clock. */
+#define I2C_HZ_DEFAULT 100000
+
+/** Software timeout per transaction. */
+#ifndef I2C_TIMEOUT_MS
+#define I2C_TIMEOUT_MS 100
+#endif
+
+/** Shortest expected wait that is slept instead of polled. */
+#ifndef I2C_SLEEP_MIN_US
+#define I2C_SLEEP_MIN_US 100
+#endif
+
+/** @name BSC1 Pins (ALT0) */
+/**@{*/
+#define I2C1_PIN_SDA 2
+#define I2C1_PIN_SCL 3
+/**@}*/
+
+/** @name Error Codes (i2c_ctx_t::error) */
+/**@{*/
+#define I2C_OK       0
+#define I2C_NACK     1   /**< Address or data byte not acknowledged. */
+#define I2C_TIMEOUT  2   /**< Clock stretch timeout (CLKT) or no DONE within I2C_TIMEOUT_MS. */
+#define I2C_INVALID  3   /**< Bad address or length. */
+/**@}*/
+
+typedef struct i2c_sim i2c_sim_t;
+
+/**
+ * @brief Controller counters.
+ */
+typedef struct {
+    uint64_t transactions;
+    uint64_t bytes;           /**< Data bytes (addresses excluded). */
+    uint64_t nacks;
+    uint64_t timeouts;
+    uint64_t sleeps;          /**< Waits slept instead of polled. */
+} i2c_stats_t;
+
+/**
+ * @brief BSC1 controller.
+ */
+typedef struct {
+    volatile uint32_t* regs;  /**< BSC register block. */
+    gpio_ctx_t* gpio;
+    i2c_sim_t* sim;           /**< Register accesses go through this model (i2c_sim_attach()). */
+    int mapped;               /**< 1 if the block comes from the rpi_periph.h registry. */
+    uint32_t clock_hz;        /**< SCL after divider rounding. */
+    uint32_t byte_ns;         /**< Nine SCL periods (byte plus ACK). */
+    int sleep;                /**< Sleep through long waits (default 1). */
+    int error;                /**< I2C_* code of the last call. */
+    i2c_stats_t stats;
+} i2c_ctx_t;
+
+/** @name Context API */
+/**@{*/
+
+/**
+ * @brief Map BSC1 (rpi_periph.h), mux GPIO 2/3 to ALT0 and reset the block.
+ *
+ * The bus starts at I2C_HZ_DEFAULT.
+ *
+ * @param gpio GPIO context for pin muxing (NULL for gpio_ctx_default).
+ * @return 0 on success, -1 on error (always on non-Pi hosts unless
+ *         periph_set_io() supplies fake blocks).
+ */
+int i2c_ctx_init(i2c_ctx_t* ctx, gpio_ctx_t* gpio);
+
+/**
+ * @brief Use an existing register block and reset it. Pins are not touched.
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int i2c_ctx_attach(i2c_ctx_t* ctx, volatile uint32_t* regs, gpio_ctx_t* gpio);
+
+/**
+ * @brief Disable the controller and release the block taken by i2c_ctx_init().
+ */
+void i2c_ctx_close(i2c_ctx_t* ctx);
+
+/**
+ * @brief Set SCL. The divider is even, from 2 to 32768; edge delays and the
+ *        clock stretch timeout (35 ms) follow it.
+ * @return The frequency actually used (at most hz), 0 on error.
+ */
+uint32_t i2c_ctx_set_clock(i2c_ctx_t* ctx, uint32_t hz);
+/**@}*/
+
+/** @name Transfers */
+/**
+ * All return 0 on success and -1 on error, with ctx->error saying why.
+ * Addresses are 7-bit.
+ */
+/**@{*/
+int i2c_ctx_write(i2c_ctx_t* ctx, uint8_t addr, const uint8_t* data, size_t len);
+int i2c_ctx_read(i2c_ctx_t* ctx, uint8_t addr, uint8_t* data, size_t len);
+
+/**
+ * @brief Write then read with a repeated START.
+ * @param wlen 1 to I2C_FIFO_BYTES.
+ */
+int i2c_ctx_write_read(i2c_ctx_t* ctx, uint8_t addr, const uint8_t* wdata, size_t wlen,
+                       uint8_t* rdata, size_t rlen);
+
+/**
+ * @brief Burst read of len registers from reg on (auto-incrementing devices).
+ */
+int i2c_ctx_read_regs(i2c_ctx_t* ctx, uint8_t addr, uint8_t reg, uint8_t* data, size_t len);
+
+/**
+ * @brief Write len registers from reg on, in one transaction.
+ */
+int i2c_ctx_write_regs(i2c_ctx_t* ctx, uint8_t addr, uint8_t reg, const uint8_t* data, size_t len);
+
+/**
+ * @brief One-byte read (the BSC cannot send an address alone).
+ * @return 1 if a device acknowledged, 0 otherwise.
+ */
+int i2c_ctx_probe(i2c_ctx_t* ctx, uint8_t addr);
+/**@}*/
+
+/** @name Simulated BSC Block */
+/**@{*/
+
+/** Virtual time charged per CPU register access. */
+#define I2C_SIM_ACCESS_NS 50
+
+/**
+ * @brief Slave callbacks (one set answers every address).
+ */
+typedef struct {
+    int (*start)(void* user, uint8_t addr, int read);  /**< Return 1 to ACK the address. */
+    int (*write)(void* user, uint8_t byte);            /**< Return 1 to ACK. */
+    uint8_t (*read)(void* user);
+    void (*stop)(void* user);                          /**< May be NULL. */
+    void* user;
+} i2c_sim_slave_t;
+
+/**
+ * @brief Register-file device: the first written byte sets the register
+ *        pointer, which auto-increments on every access.
+ */
+typedef struct {
+    uint8_t addr;
+    uint8_t regs[256];
+    uint8_t ptr;
+    int first;                /**< Next written byte is the pointer. */
+    int selected;
+} i2c_sim_regfile_t;
+
+/**
+ * @brief BSC registers, FIFO and bus in virtual time.
+ *
+ * A transfer takes one SCL period for START, nine for the address, nine
+ * per byte and one for STOP. The controller holds SCL low while a write
+ * finds the FIFO empty or a read finds it full. A START requested while a
+ * transfer is active is latched and issued as a repeated START when it
+ * ends. CLKT is never raised: simulated slaves do not stretch.
+ */
+struct i2c_sim {
+    uint32_t regs[PERIPH_BLOCK_SIZE / 4];  /**< Stored register values (status bits are computed). */
+    uint8_t fifo[I2C_FIFO_BYTES];
+    int fifo_head, fifo_count;
+    int phase;                             /**< Bus phase (I2C_SIM_*). */
+    int reading;                           /**< Direction of the transfer on the bus. */
+    uint8_t addr;
+    uint32_t remaining;                    /**< Bytes left in the transfer. */
+    uint8_t shift;                         /**< Byte on the wire. */
+    int pending;                           /**< START latched during a transfer. */
+    int pending_read;
+    int done, err;                         /**< Latched S.DONE and S.ERR. */
+    double next_ns;                        /**< End of the current phase. */
+    uint64_t now_ns;                       /**< Virtual time. */
+    uint32_t access_ns;                    /**< I2C_SIM_ACCESS_NS. */
+    double core_hz;                        /**< I2C_CORE_HZ. */
+    i2c_sim_slave_t slave;
+    uint64_t bytes;                        /**< Data bytes on the bus. */
+    uint64_t starts;
+    uint64_t repeated_starts;
+    uint64_t stops;
+    uint64_t stalls;                       /**< Bytes delayed by the FIFO. */
+    uint64_t accesses;                     /**< CPU register accesses. */
+};
+
+/**
+ * @brief Reset the model (registers at their reset values).
+ * @param slave Devices on the bus, NULL for none (every address NACKs).
+ */
+void i2c_sim_init(i2c_sim_t* sim, const i2c_sim_slave_t* slave);
+
+/**
+ * @brief Attach a context to the model.
+ * @return 0 on success, -1 on error.
+ */
+int i2c_sim_attach(i2c_sim_t* sim, i2c_ctx_t* ctx);
+
+/**
+ * @brief Reset a register-file device and describe it as slave callbacks.
+ */
+void i2c_sim_regfile(i2c_sim_regfile_t* rf, uint8_t addr, i2c_sim_slave_t* slave);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_I2C_H */
+
+#ifdef RPI_I2C_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** @name Register Offsets */
+/**@{*/
+#define I2C_C    0
+#define I2C_S    1
+#define I2C_DLEN 2
+#define I2C_A    3
+#define I2C_FIFO 4
+#define I2C_DIV  5
+#define I2C_DEL  6
+#define I2C_CLKT 7
+/**@}*/
+
+/** @name C Register Bits */
+/**@{*/
+#define I2C_C_READ   (1u << 0)
+#define I2C_C_CLEAR  (3u << 4)   /**< Write only */
+#define I2C_C_ST     (1u << 7)   /**< Write only */
+#define I2C_C_I2CEN  (1u << 15)
+/**@}*/
+
+/** @name S Register Bits */
+/**@{*/
+#define I2C_S_TA     (1u << 0)
+#define I2C_S_DONE   (1u << 1)   /**< Write 1 to clear */
+#define I2C_S_TXW    (1u << 2)   /**< Write active, FIFO under 1/4 full */
+#define I2C_S_RXR    (1u << 3)   /**< Read active, FIFO at least 3/4 full */
+#define I2C_S_TXD    (1u << 4)   /**< FIFO has room */
+#define I2C_S_RXD    (1u << 5)   /**< FIFO has data */
+#define I2C_S_TXE    (1u << 6)
+#define I2C_S_RXF    (1u << 7)
+#define I2C_S_ERR    (1u << 8)   /**< Write 1 to clear */
+#define I2C_S_CLKT   (1u << 9)   /**< Write 1 to clear */
+#define I2C_S_CLEAR  (I2C_S_DONE | I2C_S_ERR | I2C_S_CLKT)
+/**@}*/
+
+/** Bytes written without status checks while TXW is set (room for at least 13). */
+#define I2C_TXW_BYTES (I2C_FIFO_BYTES * 3 / 4)
+
+/** Bytes read without status checks while RXR is set. */
+#define I2C_RXR_BYTES (I2C_FIFO_BYTES * 3 / 4)
+
+/** Clock stretch timeout programmed into CLKT. */
+#define I2C_CLKT_MS 35
+
+/** @name Simulator Bus Phases */
+/**@{*/
+enum { I2C_SIM_IDLE, I2C_SIM_ADDR, I2C_SIM_DATA, I2C_SIM_STALL, I2C_SIM_STOP };
+/**@}*/
+
+static uint32_t i2c_sim_cpu_read(i2c_sim_t* sim, uint32_t reg);
+static void i2c_sim_cpu_write(i2c_sim_t* sim, uint32_t reg, uint32_t value);
+
+static inline uint32_t i2c_rd(const i2c_ctx_t* ctx, uint32_t reg) {
+    return ctx->sim ? i2c_sim_cpu_read(ctx->sim, reg) : ctx->regs[reg];
+}
+
+static inline void i2c_wr(const i2c_ctx_t* ctx, uint32_t reg, uint32_t value) {
+    if (ctx->sim) i2c_sim_cpu_write(ctx->sim, reg, value);
+    else ctx->regs[reg] = value;
+}
+
+/** Virtual time on the simulator, CLOCK_MONOTONIC otherwise. */
+static uint64_t i2c_now_ns(const i2c_ctx_t* ctx) {
+    if (ctx->sim) return ctx->sim->now_ns;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* ============================================================================
+ * CONTEXT
+ * ============================================================================ */
+
+static void i2c_reset(i2c_ctx_t* ctx) {
+    i2c_wr(ctx, I2C_C, I2C_C_CLEAR);
+    i2c_wr(ctx, I2C_S, I2C_S_CLEAR);
+}
+
+int i2c_ctx_attach(i2c_ctx_t* ctx, volatile uint32_t* regs, gpio_ctx_t* gpio) {
+    if (!ctx || !regs) return -1;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->regs = regs;
+    ctx->gpio = gpio ? gpio : &gpio_ctx_default;
+    ctx->sleep = 1;
+    i2c_reset(ctx);
+    i2c_ctx_set_clock(ctx, I2C_HZ_DEFAULT);
+    return 0;
+}
+
+int i2c_ctx_init(i2c_ctx_t* ctx, gpio_ctx_t* gpio) {
+    if (!ctx) return -1;
+
+    volatile uint32_t* regs = periph_map(PERIPH_BSC1);
+    if (!regs) return -1;
+
+    i2c_ctx_attach(ctx, regs, gpio);
+    ctx->mapped = 1;
+    gpio_ctx_set_function(ctx->gpio, I2C1_PIN_SDA, ALT0);
+    gpio_ctx_set_function(ctx->gpio, I2C1_PIN_SCL, ALT0);
+    return 0;
+}
+
+void i2c_ctx_close(i2c_ctx_t* ctx) {
+    if (!ctx || !ctx->regs) return;
+    i2c_reset(ctx);
+    if (ctx->mapped) {
+        periph_unmap(PERIPH_BSC1);
+        ctx->mapped = 0;
+    }
+    ctx->regs = NULL;
+    ctx->sim = NULL;
+}
+
+uint32_t i2c_ctx_set_clock(i2c_ctx_t* ctx, uint32_t hz) {
+    if (!ctx || !ctx->regs || hz == 0) return 0;
+    uint64_t cdiv = ((uint64_t)I2C_CORE_HZ + hz - 1) / hz;
+    cdiv += cdiv & 1;
+    if (cdiv < 2) cdiv = 2;
+    if (cdiv > 32768) cdiv = 32768;
+
+    /* Same edge delays (FEDL = CDIV/16, REDL = CDIV/4) and stretch timeout as the kernel driver */
+    uint32_t fedl = (uint32_t)(cdiv / 16 ? cdiv / 16 : 1);
+    uint32_t redl = (uint32_t)(cdiv / 4 ? cdiv / 4 : 1);
+    ctx->clock_hz = (uint32_t)(I2C_CORE_HZ / cdiv);
+    uint64_t tout = (uint64_t)ctx->clock_hz * I2C_CLKT_MS / 1000;
+    i2c_wr(ctx, I2C_DIV, (uint32_t)cdiv);
+    i2c_wr(ctx, I2C_DEL, (fedl << 16) | redl);
+    i2c_wr(ctx, I2C_CLKT, tout > 0xFFFF ? 0xFFFF : (uint32_t)tout);
+    ctx->byte_ns = (uint32_t)(9 * cdiv * 1000000000ull / I2C_CORE_HZ);
+    return ctx->clock_hz;
+}
+
+/* ============================================================================
+ * TRANSFERS
+ * ============================================================================ */
+
+/**
+ * Nothing to do until about bytes more have crossed the bus: sleep through
+ * it when that is long enough to be worth a syscall, waking early by half
+ * the threshold. The simulator just moves its clock.
+ */
+static void i2c_pause(i2c_ctx_t* ctx, size_t bytes) {
+    uint64_t ns = (uint64_t)bytes * ctx->byte_ns;
+    if (!ctx->sleep || ns < I2C_SLEEP_MIN_US * 1000ull) return;
+    ns -= I2C_SLEEP_MIN_US * 500ull;
+    ctx->stats.sleeps++;
+    if (ctx->sim) {
+        ctx->sim->now_ns += ns;
+        return;
+    }
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    nanosleep(&ts, NULL);
+}
+
+static int i2c_timed_out(const i2c_ctx_t* ctx, uint64_t start_ns) {
+    return i2c_now_ns(ctx) - start_ns > I2C_TIMEOUT_MS * 1000000ull;
+}
+
+/** Keep the FIFO topped up until every byte of a write is in it. */
+static int i2c_fill(i2c_ctx_t* ctx, const uint8_t* data, size_t len, size_t* t, uint64_t start) {
+    while (*t < len) {
+        uint32_t s = i2c_rd(ctx, I2C_S);
+        if (s & (I2C_S_ERR | I2C_S_CLKT | I2C_S_DONE)) return -1;
+        if (s & I2C_S_TXW) {
+            size_t burst = len - *t < I2C_TXW_BYTES ? len - *t : I2C_TXW_BYTES;
+            for (size_t i = 0; i < burst; i++) i2c_wr(ctx, I2C_FIFO, data[(*t)++]);
+        } else if (s & I2C_S_TXD) {
+            i2c_wr(ctx, I2C_FIFO, data[(*t)++]);
+        } else if (i2c_timed_out(ctx, start)) {
+            return -1;
+        } else {
+            i2c_pause(ctx, I2C_FIFO_BYTES - I2C_FIFO_BYTES / 4 - 1);  /* Full until TXW */
+        }
+    }
+    return 0;
+}
+
+/** Drain a read as it arrives; bytes left after DONE are collected by the caller. */
+static void i2c_drain(i2c_ctx_t* ctx, uint8_t* data, size_t len, size_t* r, uint64_t start) {
+    while (*r < len) {
+        uint32_t s = i2c_rd(ctx, I2C_S);
+        if (s & (I2C_S_ERR | I2C_S_CLKT)) return;  /* FIFO may hold unsent write bytes */
+        if (s & I2C_S_RXR) {
+            size_t burst = len - *r < I2C_RXR_BYTES ? len - *r : I2C_RXR_BYTES;
+            for (size_t i = 0; i < burst; i++) data[(*r)++] = (uint8_t)i2c_rd(ctx, I2C_FIFO);
+        } else if (s & I2C_S_RXD) {
+            data[(*r)++] = (uint8_t)i2c_rd(ctx, I2C_FIFO);
+        } else if ((s & I2C_S_DONE) || i2c_timed_out(ctx, start)) {
+            return;
+        } else {
+            /* The FIFO is empty: RXR bytes can arrive before it needs us */
+            size_t left = len - *r;
+            i2c_pause(ctx, (left < I2C_RXR_BYTES ? left : I2C_RXR_BYTES) - 1);
+        }
+    }
+}
+
+/**
+ * One transaction: a write, a read, or a write followed by a read through
+ * a repeated START.
+ */
+static int i2c_run(i2c_ctx_t* ctx, uint8_t addr, const uint8_t* wdata, size_t wlen,
+                   uint8_t* rdata, size_t rlen) {
+    if (!ctx || !ctx->regs) return -1;
+    if (addr > 0x7F || wlen > I2C_MAX_LEN || rlen > I2C_MAX_LEN || (wlen && !wdata) || (rlen && !rdata) ||
+        (wlen && rlen && wlen > I2C_FIFO_BYTES) || (!wlen && !rlen)) {
+        ctx->error = I2C_INVALID;
+        return -1;
+    }
+
+    uint64_t start = i2c_now_ns(ctx);
+    size_t t = 0, r = 0;
+    i2c_wr(ctx, I2C_C, I2C_C_I2CEN | I2C_C_CLEAR);
+    i2c_wr(ctx, I2C_S, I2C_S_CLEAR);
+    i2c_wr(ctx, I2C_A, addr);
+
+    if (wlen) {
+        i2c_wr(ctx, I2C_DLEN, (uint32_t)wlen);
+        while (t < wlen && t < I2C_FIFO_BYTES) i2c_wr(ctx, I2C_FIFO, wdata[t++]);
+        i2c_wr(ctx, I2C_C, I2C_C_I2CEN | I2C_C_ST);
+    }
+    if (rlen) {
+        if (wlen) {
+            /* Queue the read once the write is on the bus: the BSC then
+             * chains it with a repeated START instead of a STOP */
+            uint32_t s;
+            do {
+                s = i2c_rd(ctx, I2C_S);
+            } while (!(s & (I2C_S_TA | I2C_S_DONE)) && !i2c_timed_out(ctx, start));
+        }
+        i2c_wr(ctx, I2C_DLEN, (uint32_t)rlen);
+        i2c_wr(ctx, I2C_C, I2C_C_I2CEN | I2C_C_ST | I2C_C_READ);
+        if (wlen) {
+            /* Until TXE the FIFO still holds write bytes; RXR and DONE
+             * only come once the read has data, so they are safe too */
+            uint32_t s;
+            if (wlen > 1) i2c_pause(ctx, wlen - 1);
+            do {
+                s = i2c_rd(ctx, I2C_S);
+            } while (!(s & (I2C_S_TXE | I2C_S_RXR | I2C_S_CLEAR)) && !i2c_timed_out(ctx, start));
+        }
+        i2c_drain(ctx, rdata, rlen, &r, start);
+    } else {
+        i2c_fill(ctx, wdata, wlen, &t, start);
+    }
+
+    /* Wait for DONE, sleeping through what DLEN says is left */
+    uint32_t s;
+    while (!((s = i2c_rd(ctx, I2C_S)) & I2C_S_DONE)) {
+        if (i2c_timed_out(ctx, start)) break;
+        if (s & I2C_S_TA) {
+            uint32_t left = i2c_rd(ctx, I2C_DLEN);
+            if (left > 1) i2c_pause(ctx, left - 1);
+        }
+    }
+    while (r < rlen && !(s & I2C_S_ERR) && (i2c_rd(ctx, I2C_S) & I2C_S_RXD)) rdata[r++] = (uint8_t)i2c_rd(ctx, I2C_FIFO);
+
+    ctx->stats.transactions++;
+    if (s & I2C_S_ERR) {
+        ctx->error = I2C_NACK;
+        ctx->stats.nacks++;
+    } else if ((s & I2C_S_CLKT) || !(s & I2C_S_DONE) || r < rlen || t < wlen) {
+        ctx->error = I2C_TIMEOUT;
+        ctx->stats.timeouts++;
+    } else {
+        ctx->error = I2C_OK;
+        ctx->stats.bytes += wlen + rlen;
+    }
+    /* Leave idle: an aborted transfer is dropped with the FIFO */
+    i2c_wr(ctx, I2C_C, ctx->error == I2C_OK ? I2C_C_I2CEN : I2C_C_CLEAR);
+    i2c_wr(ctx, I2C_S, I2C_S_CLEAR);
+    return ctx->error == I2C_OK ? 0 : -1;
+}
+
+int i2c_ctx_write(i2c_ctx_t* ctx, uint8_t addr, const uint8_t* data, size_t len) {
+    return i2c_run(ctx, addr, data, len, NULL, 0);
+}
+
+int i2c_ctx_read(i2c_ctx_t* ctx, uint8_t addr, uint8_t* data, size_t len) {
+    return i2c_run(ctx, addr, NULL, 0, data, len);
+}
+
+int i2c_ctx_write_read(i2c_ctx_t* ctx, uint8_t addr, const uint8_t* wdata, size_t wlen,
+                       uint8_t* rdata, size_t rlen) {
+    if (ctx && (wlen == 0 || rlen == 0)) {
+        ctx->error = I2C_INVALID;
+        return -1;
+    }
+    return i2c_run(ctx, addr, wdata, wlen, rdata, rlen);
+}
+
+int i2c_ctx_read_regs(i2c_ctx_t* ctx, uint8_t addr, uint8_t reg, uint8_t* data, size_t len) {
+    return i2c_ctx_write_read(ctx, addr, &reg, 1, data, len);
+}
+
+int i2c_ctx_write_regs(i2c_ctx_t* ctx, uint8_t addr, uint8_t reg, const uint8_t* data, size_t len) {
+    if (!ctx) return -1;
+    if (len >= I2C_MAX_LEN || (len && !data)) {
+        ctx->error = I2C_INVALID;
+        return -1;
+    }
+    uint8_t stack[I2C_FIFO_BYTES * 4];
+    uint8_t* buf = len + 1 <= sizeof(stack) ? stack : malloc(len + 1);
+    if (!buf) {
+        ctx->error = I2C_INVALID;
+        return -1;
+    }
+    buf[0] = reg;
+    if (len) memcpy(buf + 1, data, len);
+    int rc = i2c_run(ctx, addr, buf, len + 1, NULL, 0);
+    if (buf != stack) free(buf);
+    return rc;
+}
+
+int i2c_ctx_probe(i2c_ctx_t* ctx, uint8_t addr) {
+    uint8_t b;
+    return i2c_run(ctx, addr, NULL, 0, &b, 1) == 0;
+}
+
+/* ============================================================================
+ * SIMULATOR
+ * ============================================================================ */
+
+static double i2c_sim_bit_ns(const i2c_sim_t* sim) {
+    uint32_t cdiv = sim->regs[I2C_DIV] & 0xFFFF;
+    if (cdiv == 0) cdiv = 32768;
+    return cdiv * 1e9 / sim->core_hz;
+}
+
+static void i2c_sim_begin_stop(i2c_sim_t* sim, double t) {
+    sim->phase = I2C_SIM_STOP;
+    sim->pending = 0;
+    sim->next_ns = t + i2c_sim_bit_ns(sim);
+}
+
+/* START (or repeated START) plus address and ACK */
+static void i2c_sim_begin_addr(i2c_sim_t* sim, double t, int read) {
+    sim->addr = (uint8_t)(sim->regs[I2C_A] & 0x7F);
+    sim->remaining = sim->regs[I2C_DLEN] & 0xFFFF;
+    sim->reading = read;
+    sim->phase = I2C_SIM_ADDR;
+    sim->next_ns = t + 10 * i2c_sim_bit_ns(sim);
+}
+
+/* Start the next byte, or hold SCL low until the FIFO allows it */
+static void i2c_sim_begin_byte(i2c_sim_t* sim, double t) {
+    if (sim->reading ? sim->fifo_count == I2C_FIFO_BYTES : sim->fifo_count == 0) {
+        if (sim->phase != I2C_SIM_STALL) sim->stalls++;
+        sim->phase = I2C_SIM_STALL;
+        return;
+    }
+    if (!sim->reading) {
+        sim->shift = sim->fifo[sim->fifo_head];
+        sim->fifo_head = (sim->fifo_head + 1) % I2C_FIFO_BYTES;
+        sim->fifo_count--;
+    }
+    sim->phase = I2C_SIM_DATA;
+    sim->next_ns = t + 9 * i2c_sim_bit_ns(sim);
+}
+
+static void i2c_sim_end_transfer(i2c_sim_t* sim, double t) {
+    if (sim->pending) {
+        sim->pending = 0;
+        sim->repeated_starts++;
+        i2c_sim_begin_addr(sim, t, sim->pending_read);
+    } else {
+        i2c_sim_begin_stop(sim, t);
+    }
+}
+
+/** Run the bus up to now; returns the next event time. */
+static uint64_t i2c_sim_run(i2c_sim_t* sim) {
+    double now = (double)sim->now_ns;
+    const i2c_sim_slave_t* sl = &sim->slave;
+    for (;;) {
+        if (sim->phase == I2C_SIM_IDLE) return UINT64_MAX;
+        if (sim->phase == I2C_SIM_STALL) {
+            i2c_sim_begin_byte(sim, now);
+            if (sim->phase == I2C_SIM_STALL) return UINT64_MAX;
+            continue;
+        }
+        if (sim->next_ns > now) return (uint64_t)sim->next_ns + 1;
+
+        double t = sim->next_ns;
+        int ack = 1;
+        switch (sim->phase) {
+        case I2C_SIM_ADDR:
+            ack = sl->start && sl->start(sl->user, sim->addr, sim->reading);
+            if (!ack) break;
+            if (sim->remaining == 0) i2c_sim_end_transfer(sim, t);
+            else i2c_sim_begin_byte(sim, t);
+            continue;
+        case I2C_SIM_DATA:
+            if (sim->reading) {
+                int tail = (sim->fifo_head + sim->fifo_count) % I2C_FIFO_BYTES;
+                sim->fifo[tail] = sl->read ? sl->read(sl->user) : 0xFF;
+                sim->fifo_count++;
+            } else {
+                ack = sl->write && sl->write(sl->user, sim->shift);
+            }
+            sim->bytes++;
+            sim->remaining--;
+            if (!ack) break;
+            if (sim->remaining == 0) i2c_sim_end_transfer(sim, t);
+            else i2c_sim_begin_byte(sim, t);
+            continue;
+        default:
+            sim->phase = I2C_SIM_IDLE;
+            sim->done = 1;
+            sim->stops++;
+            if (sl->stop) sl->stop(sl->user);
+            continue;
+        }
+
+        /* NACK: ERR, then STOP */
+        sim->err = 1;
+        i2c_sim_begin_stop(sim, t);
+    }
+}
+
+static uint32_t i2c_sim_read(i2c_sim_t* sim, uint32_t reg) {
+    if (reg == I2C_FIFO) {
+        if (sim->fifo_count == 0) return 0;
+        uint8_t b = sim->fifo[sim->fifo_head];
+        sim->fifo_head = (sim->fifo_head + 1) % I2C_FIFO_BYTES;
+        sim->fifo_count--;
+        i2c_sim_run(sim);  /* Room may release a held read */
+        return b;
+    }
+    if (reg == I2C_DLEN) {
+        return sim->phase != I2C_SIM_IDLE ? sim->remaining : sim->regs[I2C_DLEN];
+    }
+    if (reg != I2C_S) return sim->regs[reg];
+
+    int active = sim->phase != I2C_SIM_IDLE;
+    uint32_t s = 0;
+    if (active) s |= I2C_S_TA;
+    if (sim->done) s |= I2C_S_DONE;
+    if (sim->err) s |= I2C_S_ERR;
+    if (active && !sim->reading && sim->fifo_count < I2C_FIFO_BYTES / 4) s |= I2C_S_TXW;
+    if (active && sim->reading && sim->fifo_count >= I2C_RXR_BYTES) s |= I2C_S_RXR;
+    if (sim->fifo_count < I2C_FIFO_BYTES) s |= I2C_S_TXD;
+    if (sim->fifo_count) s |= I2C_S_RXD;
+    if (sim->fifo_count == 0) s |= I2C_S_TXE;
+    if (sim->fifo_count == I2C_FIFO_BYTES) s |= I2C_S_RXF;
+    return s;
+}
+
+static void i2c_sim_write(i2c_sim_t* sim, uint32_t reg, uint32_t value) {
+    if (reg == I2C_C) {
+        if (value & I2C_C_CLEAR) sim->fifo_head = sim->fifo_count = 0;
+        sim->regs[I2C_C] = value & ~(I2C_C_CLEAR | I2C_C_ST);
+        if (!(value & I2C_C_I2CEN)) {
+            sim->phase = I2C_SIM_IDLE;  /* Disabling aborts the transfer */
+            sim->pending = 0;
+        } else if (value & I2C_C_ST) {
+            int read = (value & I2C_C_READ) != 0;
+            if (sim->phase == I2C_SIM_IDLE) {
+                sim->starts++;
+                i2c_sim_begin_addr(sim, (double)sim->now_ns, read);
+            } else {
+                sim->pending = 1;
+                sim->pending_read = read;
+            }
+        }
+    } else if (reg == I2C_S) {
+        if (value & I2C_S_DONE) sim->done = 0;
+        if (value & I2C_S_ERR) sim->err = 0;
+    } else if (reg == I2C_FIFO) {
+        if (sim->fifo_count < I2C_FIFO_BYTES) {
+            int tail = (sim->fifo_head + sim->fifo_count) % I2C_FIFO_BYTES;
+            sim->fifo[tail] = (uint8_t)value;
+            sim->fifo_count++;
+        }
+    } else {
+        sim->regs[reg] = value;
+    }
+    i2c_sim_run(sim);
+}
+
+static uint32_t i2c_sim_cpu_read(i2c_sim_t* sim, uint32_t reg) {
+    sim->now_ns += sim->access_ns;
+    sim->accesses++;
+    i2c_sim_run(sim);
+    return i2c_sim_read(sim, reg);
+}
+
+static void i2c_sim_cpu_write(i2c_sim_t* sim, uint32_t reg, uint32_t value) {
+    sim->now_ns += sim->access_ns;
+    sim->accesses++;
+    i2c_sim_run(sim);
+    i2c_sim_write(sim, reg, value);
+}
+
+void i2c_sim_init(i2c_sim_t* sim, const i2c_sim_slave_t* slave) {
+    memset(sim, 0, sizeof(*sim));
+    sim->regs[I2C_DIV] = 0x5DC;
+    sim->regs[I2C_DEL] = 0x00300030;
+    sim->regs[I2C_CLKT] = 0x40;
+    sim->access_ns = I2C_SIM_ACCESS_NS;
+    sim->core_hz = I2C_CORE_HZ;
+    if (slave) sim->slave = *slave;
+}
+
+int i2c_sim_attach(i2c_sim_t* sim, i2c_ctx_t* ctx) {
+    if (!sim || !ctx) return -1;
+    if (i2c_ctx_attach(ctx, sim->regs, NULL) != 0) return -1;
+
+    /* Redo the reset through the model so the FIFO is cleared too */
+    ctx->sim = sim;
+    i2c_reset(ctx);
+    i2c_ctx_set_clock(ctx, I2C_HZ_DEFAULT);
+    return 0;
+}
+
+static int i2c_regfile_start(void* user, uint8_t addr, int read) {
+    i2c_sim_regfile_t* rf = (i2c_sim_regfile_t*)user;
+    rf->selected = addr == rf->addr;
+    rf->first = !read;
+    return rf->selected;
+}
+
+static int i2c_regfile_write(void* user, uint8_t byte) {
+    i2c_sim_regfile_t* rf = (i2c_sim_regfile_t*)user;
+    if (!rf->selected) return 0;
+    if (rf->first) rf->ptr = byte;
+    else rf->regs[rf->ptr++] = byte;
+    rf->first = 0;
+    return 1;
+}
+
+static uint8_t i2c_regfile_read(void* user) {
+    i2c_sim_regfile_t* rf = (i2c_sim_regfile_t*)user;
+    return rf->selected ? rf->regs[rf->ptr++] : 0xFF;
+}
+
+void i2c_sim_regfile(i2c_sim_regfile_t* rf, uint8_t addr, i2c_sim_slave_t* slave) {
+    memset(rf, 0, sizeof(*rf));
+    rf->addr = addr;
+    slave->start = i2c_regfile_start;
+    slave->write = i2c_regfile_write;
+    slave->read = i2c_regfile_read;
+    slave->stop = NULL;
+    slave->user = rf;
+}
+
+#endif /* RPI_I2C_IMPLEMENTATION */
@@ -0,0 +1,414 @@
+/**
+ * @file rpi_logic.h
+ * @brief GPIO logic analyzer: run-length capture of all pins with VCD export.
+ *
+ * Single-header library. Define RPI_LOGIC_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h, rpi_realtime.h and pthread (-pthread linker flag).
+ *
+ * A sampler reads all 54 levels (GPLEV0 and GPLEV1) as fast as it can,
+ * ideally on an isolated core, and stores only changes: one
+ * (timestamp delta, levels) record per sample that differs from the last
+ * stored one. Records go into a preallocated single-producer,
+ * single-consumer ring. A background writer drains the ring into a VCD
+ * file that GTKWave, PulseView (sigrok) and most waveform viewers open
+ * directly; without a writer, logic_read() hands records to the caller.
+ *
+ * When the ring is full a change cannot be stored; the sample is counted
+ * as dropped and the change is retried on the next sample, so the capture
+ * recovers with the correct levels once the consumer catches up.
+ *
+ * Works with every gpio_ctx_t backend; tests feed it from the simulator.
+ */
+
+#ifndef RPI_LOGIC_H
+#define RPI_LOGIC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default ring capacity in records (rounded up to a power of two). */
+#define LOGIC_CAPACITY_DEFAULT 65536
+
+/** Sleep of the writer thread when the ring is empty. */
+#ifndef LOGIC_WRITER_IDLE_US
+#define LOGIC_WRITER_IDLE_US 1000
+#endif
+
+/**
+ * @brief One run-length record: levels held from this point on.
+ */
+typedef struct {
+    uint64_t delta_ns;        /**< Time since the previous record (since start for the first). */
+    uint64_t levels;          /**< Captured levels (bit n = GPIO n, masked). */
+} logic_record_t;
+
+/**
+ * @brief Capture statistics (written by the sampler).
+ */
+typedef struct {
+    uint64_t samples;         /**< GPLEV snapshots taken. */
+    uint64_t records;         /**< Changes stored. */
+    uint64_t dropped;         /**< Samples whose change did not fit in the ring. */
+    uint64_t max_gap_ns;      /**< Longest time between two samples (preemption shows here). */
+    uint64_t start_ns;        /**< CLOCK_MONOTONIC time of the first sample. */
+    uint64_t end_ns;          /**< Time of the latest sample. */
+} logic_stats_t;
+
+/**
+ * @brief Capture instance: record ring, sampler and writer state.
+ */
+typedef struct {
+    uint64_t head __attribute__((aligned(64)));  /**< Written by the sampler. */
+    uint64_t tail __attribute__((aligned(64)));  /**< Written by the consumer. */
+    logic_record_t* ring __attribute__((aligned(64)));
+    size_t capacity;          /**< Power of two. */
+    gpio_ctx_t* gpio;
+    uint64_t pin_mask;        /**< Pins captured (others read as 0). */
+    uint64_t last_levels;     /**< Last stored levels. */
+    uint64_t last_ns;         /**< Time of the last stored record. */
+    logic_stats_t stats;
+    FILE* vcd;                /**< Writer output, NULL without a writer. */
+    uint64_t vcd_t_ns;        /**< Writer position in capture time. */
+    uint64_t vcd_levels;
+    pthread_t sampler;
+    pthread_t writer;
+    int running;              /**< Sampler active. */
+    int writing;              /**< Writer active (cleared once the sampler has stopped). */
+    int core_id;
+} logic_t;
+
+/**
+ * @brief Allocate the ring.
+ * @param gpio GPIO context to sample (NULL for gpio_ctx_default).
+ * @param pin_mask Pins to capture (0 for all 54).
+ * @param capacity Records (0 for LOGIC_CAPACITY_DEFAULT), rounded up to a power of two.
+ * @return 0 on success, -1 on error.
+ */
+int logic_init(logic_t* la, gpio_ctx_t* gpio, uint64_t pin_mask, size_t capacity);
+
+/**
+ * @brief Stop the capture and free the ring.
+ */
+void logic_free(logic_t* la);
+
+/**
+ * @brief Take samples on the calling thread.
+ *
+ * Use instead of logic_start() to drive sampling from your own loop (or a
+ * test). Must not be called while the sampler thread runs.
+ *
+ * @return Records stored.
+ */
+size_t logic_poll(logic_t* la, size_t samples);
+
+/**
+ * @brief Start the sampler thread and, if @p vcd is given, the writer.
+ *
+ * The sampler busy-polls: pin it to an isolated core.
+ *
+ * @param core_id CPU core for the sampler, or -1 to leave it unpinned.
+ * @param vcd Output stream for the writer thread (NULL to consume with logic_read()).
+ * @return 0 on success, -1 on error.
+ */
+int logic_start(logic_t* la, int core_id, FILE* vcd);
+
+/**
+ * @brief Stop sampling; the writer drains the ring and flushes before returning.
+ */
+void logic_stop(logic_t* la);
+
+/**
+ * @brief Dequeue records without blocking (when no writer runs).
+ * @return Records dequeued.
+ */
+size_t logic_read(logic_t* la, logic_record_t* records, size_t max);
+
+/**
+ * @brief Achieved sample rate in samples per second (0 before two samples).
+ */
+double logic_sample_rate(const logic_t* la);
+
+/** @name VCD Export */
+/**@{*/
+
+/**
+ * @brief Write the VCD header: 1 ns timescale, one wire per pin in @p pin_mask.
+ */
+void logic_vcd_header(FILE* out, uint64_t pin_mask);
+
+/**
+ * @brief Write the pins that differ between @p prev and @p levels at @p t_ns.
+ *
+ * Pass prev = ~levels to dump every pin (initial values).
+ */
+void logic_vcd_change(FILE* out, uint64_t pin_mask, uint64_t t_ns, uint64_t prev, uint64_t levels);
+
+/**
+ * @brief Write records as value changes.
+ * @param t_ns In: time of the previous record; out: time of the last one written.
+ * @param prev In: levels before the first record; out: levels after the last one.
+ */
+void logic_vcd_records(FILE* out, uint64_t pin_mask, const logic_record_t* records, size_t count,
+                       uint64_t* t_ns, uint64_t* prev);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_LOGIC_H */
+
+#ifdef RPI_LOGIC_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/** Records the writer dequeues per batch. */
+#define LOGIC_WRITER_BATCH 256
+
+/** First VCD identifier character; pin n uses LOGIC_VCD_ID0 + n. */
+#define LOGIC_VCD_ID0 '!'
+
+static uint64_t logic_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+int logic_init(logic_t* la, gpio_ctx_t* gpio, uint64_t pin_mask, size_t capacity) {
+    if (!la) return -1;
+    memset(la, 0, sizeof(*la));
+
+    if (capacity == 0) capacity = LOGIC_CAPACITY_DEFAULT;
+    size_t cap = 4;
+    while (cap < capacity) cap <<= 1;
+
+    la->ring = aligned_alloc(64, cap * sizeof(logic_record_t));
+    if (!la->ring) {
+        fprintf(stderr, "Logic Error: Failed to allocate %zu records\n", cap);
+        return -1;
+    }
+    la->capacity = cap;
+    la->gpio = gpio ? gpio : &gpio_ctx_default;
+    la->pin_mask = pin_mask ? (pin_mask & GPIO_ALL_PINS_MASK) : GPIO_ALL_PINS_MASK;
+    la->core_id = -1;
+    return 0;
+}
+
+void logic_free(logic_t* la) {
+    if (!la) return;
+    logic_stop(la);
+    free(la->ring);
+    la->ring = NULL;
+    la->capacity = 0;
+}
+
+/**
+ * Both GPLEV loads straight from the register block on the mmap backend;
+ * other backends go through the context.
+ */
+static inline uint64_t logic_levels(const logic_t* la) {
+    volatile uint32_t* regs = la->gpio->regs;
+    if (regs) {
+        uint32_t lo = regs[GPLEV0];
+        uint32_t hi = regs[GPLEV1];
+        return (((uint64_t)hi << GPIO_PINS_PER_BANK) | lo) & la->pin_mask;
+    }
+    return gpio_ctx_read_all(la->gpio) & la->pin_mask;
+}
+
+/**
+ * One sample. The first one always stores a record, so consumers know the
+ * starting levels. Returns 1 if a record was stored.
+ */
+static inline int logic_sample(logic_t* la) {
+    uint64_t levels = logic_levels(la);
+    uint64_t now = logic_now_ns();
+    logic_stats_t* st = &la->stats;
+
+    if (st->samples == 0) {
+        st->start_ns = now;
+        la->last_ns = now;
+        la->last_levels = ~levels;
+    } else if (now - st->end_ns > st->max_gap_ns) {
+        st->max_gap_ns = now - st->end_ns;
+    }
+    st->samples++;
+    st->end_ns = now;
+
+    if (levels == la->last_levels) return 0;
+
+    uint64_t head = la->head;
+    uint64_t tail = __atomic_load_n(&la->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= la->capacity) {
+        st->dropped++;
+        return 0;
+    }
+
+    logic_record_t* r = &la->ring[head & (la->capacity - 1)];
+    r->delta_ns = now - la->last_ns;
+    r->levels = levels;
+    __atomic_store_n(&la->head, head + 1, __ATOMIC_RELEASE);
+
+    la->last_ns = now;
+    la->last_levels = levels;
+    st->records++;
+    return 1;
+}
+
+size_t logic_poll(logic_t* la, size_t samples) {
+    if (!la || !la->ring || la->running) return 0;
+    size_t stored = 0;
+    for (size_t i = 0; i < samples; i++) stored += (size_t)logic_sample(la);
+    return stored;
+}
+
+size_t logic_read(logic_t* la, logic_record_t* records, size_t max) {
+    if (!la || !la->ring || !records) return 0;
+
+    uint64_t tail = la->tail;
+    uint64_t head = __atomic_load_n(&la->head, __ATOMIC_ACQUIRE);
+    size_t n = (size_t)(head - tail);
+    if (n > max) n = max;
+
+    for (size_t i = 0; i < n; i++) {
+        records[i] = la->ring[(tail + i) & (la->capacity - 1)];
+    }
+    __atomic_store_n(&la->tail, tail + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+double logic_sample_rate(const logic_t* la) {
+    if (!la || la->stats.samples < 2 || la->stats.end_ns <= la->stats.start_ns) return 0.0;
+    return (double)(la->stats.samples - 1) * 1e9 / (double)(la->stats.end_ns - la->stats.start_ns);
+}
+
+void logic_vcd_header(FILE* out, uint64_t pin_mask) {
+    fprintf(out, "$version rpi-toolkit rpi_logic.h $end\n");
+    fprintf(out, "$timescale 1ns $end\n");
+    fprintf(out, "$scope module gpio $end\n");
+    for (int pin = GPIO_PIN_MIN; pin <= GPIO_PIN_MAX; pin++) {
+        if (pin_mask & (1ull << pin)) {
+            fprintf(out, "$var wire 1 %c gpio%d $end\n", LOGIC_VCD_ID0 + pin, pin);
+        }
+    }
+    fprintf(out, "$upscope $end\n");
+    fprintf(out, "$enddefinitions $end\n");
+}
+
+void logic_vcd_change(FILE* out, uint64_t pin_mask, uint64_t t_ns, uint64_t prev, uint64_t levels) {
+    uint64_t changed = (prev ^ levels) & pin_mask;
+    if (!changed) return;
+
+    fprintf(out, "#%llu\n", (unsigned long long)t_ns);
+    while (changed) {
+        int pin = __builtin_ctzll(changed);
+        changed &= changed - 1;
+        fputc((levels >> pin) & 1 ? '1' : '0', out);
+        fputc(LOGIC_VCD_ID0 + pin, out);
+        fputc('\n', out);
+    }
+}
+
+void logic_vcd_records(FILE* out, uint64_t pin_mask, const logic_record_t* records, size_t count,
+                       uint64_t* t_ns, uint64_t* prev) {
+    for (size_t i = 0; i < count; i++) {
+        *t_ns += records[i].delta_ns;
+        logic_vcd_change(out, pin_mask, *t_ns, *prev, records[i].levels);
+        *prev = records[i].levels;
+    }
+}
+
+static void* logic_sampler_func(void* arg) {
+    logic_t* la = (logic_t*)arg;
+    if (la->core_id >= 0) pin_to_core(la->core_id);
+
+    while (__atomic_load_n(&la->running, __ATOMIC_RELAXED)) {
+        logic_sample(la);
+    }
+    return NULL;
+}
+
+/* Drains until logic_stop() has joined the sampler and the ring is empty */
+static void* logic_writer_func(void* arg) {
+    logic_t* la = (logic_t*)arg;
+    logic_record_t batch[LOGIC_WRITER_BATCH];
+    int first = 1;
+
+    for (;;) {
+        int writing = __atomic_load_n(&la->writing, __ATOMIC_ACQUIRE);
+        size_t n = logic_read(la, batch, LOGIC_WRITER_BATCH);
+        if (n) {
+            if (first) la->vcd_levels = ~batch[0].levels;  /* Dump every pin once */
+            first = 0;
+            logic_vcd_records(la->vcd, la->pin_mask, batch, n, &la->vcd_t_ns, &la->vcd_levels);
+        } else if (!writing) {
+            break;
+        } else {
+            usleep(LOGIC_WRITER_IDLE_US);
+        }
+    }
+    fflush(la->vcd);
+    return NULL;
+}
+
+int logic_start(logic_t* la, int core_id, FILE* vcd) {
+    if (!la || !la->ring) return -1;
+    if (la->running) {
+        fprintf(stderr, "Logic Error: Capture already running\n");
+        return -1;
+    }
+
+    /* A new capture: records and counters left from the last one are dropped */
+    la->head = 0;
+    la->tail = 0;
+    la->last_levels = 0;
+    la->last_ns = 0;
+    memset(&la->stats, 0, sizeof(la->stats));
+    la->core_id = core_id;
+    la->vcd = vcd;
+    la->vcd_t_ns = 0;
+    la->vcd_levels = 0;
+    __atomic_store_n(&la->running, 1, __ATOMIC_RELEASE);
+
+    if (pthread_create(&la->sampler, NULL, logic_sampler_func, la) != 0) {
+        perror("Logic Error: Failed to create sampler thread");
+        la->running = 0;
+        return -1;
+    }
+
+    if (vcd) {
+        logic_vcd_header(vcd, la->pin_mask);
+        __atomic_store_n(&la->writing, 1, __ATOMIC_RELEASE);
+        if (pthread_create(&la->writer, NULL, logic_writer_func, la) != 0) {
+            perror("Logic Error: Failed to create writer thread");
+            la->writing = 0;
+            __atomic_store_n(&la->running, 0, __ATOMIC_RELEASE);
+            pthread_join(la->sampler, NULL);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void logic_stop(logic_t* la) {
+    if (!la || !la->running) return;
+    __atomic_store_n(&la->running, 0, __ATOMIC_RELEASE);
+    pthread_join(la->sampler, NULL);
+    if (la->writing) {
+        __atomic_store_n(&la->writing, 0, __ATOMIC_RELEASE);
+        pthread_join(la->writer, NULL);
+    }
+}
+
+#endif /* RPI_LOGIC_IMPLEMENTATION */
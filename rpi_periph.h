@@ -0,0 +1,361 @@
+/**
+ * @file rpi_periph.h
+ * @brief Shared peripheral mapping registry for Raspberry Pi.
+ *
+ * Included by rpi_gpio.h; the implementation is compiled together with
+ * RPI_GPIO_IMPLEMENTATION, so no extra define is needed.
+ *
+ * Peripheral register blocks (GPIO, PWM, CLK, DMA, SPI, BSC) are mapped
+ * lazily on first use and reference-counted, so several modules and contexts
+ * share one mapping per block. All blocks, and physical memory mapped with
+ * periph_map_phys() (DMA buffers), share a single /dev/mem fd; GPIO
+ * falls back to /dev/gpiomem when /dev/mem is not accessible (no root).
+ *
+ * The peripheral base is read from /proc/device-tree/soc/ranges (Pi 4:
+ * 0xFE000000, Pi 2/3: 0x3F000000). Syscalls go through a replaceable table
+ * (periph_set_io()) so host tests can map RAM instead.
+ */
+
+#ifndef RPI_PERIPH_H
+#define RPI_PERIPH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Device tree node holding the SoC address translation. */
+#define PERIPH_RANGES_PATH "/proc/device-tree/soc/ranges"
+
+/** Base used when the device tree cannot be read (BCM2711, Pi 4B). */
+#define PERIPH_DEFAULT_BASE 0xFE000000u
+
+/** Peripheral base as seen by the VideoCore / DMA engines. */
+#define PERIPH_BUS_BASE 0x7E000000u
+
+/** Size of one mapped block. */
+#define PERIPH_BLOCK_SIZE (4*1024)
+
+/**
+ * @brief Peripheral register blocks.
+ */
+typedef enum {
+    PERIPH_GPIO = 0,   /**< GPIO (base + 0x200000) */
+    PERIPH_PWM,        /**< PWM0 (base + 0x20C000) */
+    PERIPH_CLK,        /**< Clock manager (base + 0x101000) */
+    PERIPH_DMA,        /**< DMA channels 0-14 (base + 0x007000) */
+    PERIPH_SPI0,       /**< SPI0 (base + 0x204000) */
+    PERIPH_BSC1,       /**< I2C1 (base + 0x804000) */
+    PERIPH_PCM,        /**< PCM / I2S (base + 0x203000) */
+    PERIPH_COUNT
+} periph_block_t;
+
+/**
+ * @brief Syscall table used by the registry.
+ *
+ * Replace with periph_set_io() to map fake register blocks.
+ */
+typedef struct {
+    int   (*open)(const char* path, int flags);
+    int   (*close)(int fd);
+    void* (*mmap)(void* addr, size_t length, int prot, int flags, int fd, off_t offset);
+    int   (*munmap)(void* addr, size_t length);
+} periph_io_t;
+
+/**
+ * @brief Map a block, or take another reference to an existing mapping.
+ * @param block Peripheral block.
+ * @return Register block, NULL on error.
+ */
+volatile uint32_t* periph_map(periph_block_t block);
+
+/**
+ * @brief Drop a reference; the block is unmapped when the last one goes.
+ *
+ * The /dev/mem fd is closed once no block uses it.
+ */
+void periph_unmap(periph_block_t block);
+
+/**
+ * @brief Map physical memory outside the register blocks (e.g. DMA buffers).
+ *
+ * Uses the same /dev/mem fd as the register blocks.
+ *
+ * @param phys Page-aligned physical address.
+ * @param size Length in bytes.
+ * @return CPU address, NULL on error.
+ */
+void* periph_map_phys(uint32_t phys, size_t size);
+
+/**
+ * @brief Release a periph_map_phys() mapping.
+ */
+void periph_unmap_phys(void* addr, size_t size);
+
+/**
+ * @brief Current number of references to a block (0 if unmapped).
+ */
+int periph_refcount(periph_block_t block);
+
+/**
+ * @brief Offset of a block from the peripheral base.
+ */
+uint32_t periph_offset(periph_block_t block);
+
+/**
+ * @brief Physical peripheral base (detected once, then cached).
+ */
+uint32_t periph_base(void);
+
+/**
+ * @brief Parse a device-tree ranges file.
+ * @param ranges_path File to read (NULL for PERIPH_RANGES_PATH).
+ * @return Physical peripheral base, PERIPH_DEFAULT_BASE if unreadable.
+ */
+uint32_t periph_detect_base(const char* ranges_path);
+
+/**
+ * @brief Replace the syscall table (NULL restores the real syscalls).
+ *
+ * Only call while no block is mapped.
+ */
+void periph_set_io(const periph_io_t* io);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_PERIPH_H */
+
+#if defined(RPI_PERIPH_IMPLEMENTATION) && !defined(RPI_PERIPH_IMPLEMENTED)
+#define RPI_PERIPH_IMPLEMENTED
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const struct {
+    const char* name;
+    uint32_t offset;
+} periph_blocks[PERIPH_COUNT] = {
+    [PERIPH_GPIO] = { "GPIO", 0x200000 },
+    [PERIPH_PWM]  = { "PWM",  0x20C000 },
+    [PERIPH_CLK]  = { "CLK",  0x101000 },
+    [PERIPH_DMA]  = { "DMA",  0x007000 },
+    [PERIPH_SPI0] = { "SPI0", 0x204000 },
+    [PERIPH_BSC1] = { "BSC1", 0x804000 },
+    [PERIPH_PCM]  = { "PCM",  0x203000 },
+};
+
+static int periph_sys_open(const char* path, int flags) { return open(path, flags); }
+
+static void* periph_sys_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
+    return mmap(addr, length, prot, flags, fd, offset);
+}
+
+static const periph_io_t periph_sys_io = { periph_sys_open, close, periph_sys_mmap, munmap };
+static const periph_io_t* periph_io = &periph_sys_io;
+
+static struct {
+    volatile uint32_t* map;
+    int refs;
+    int fd;                     /**< fd the block was mapped from. */
+} periph_maps[PERIPH_COUNT];
+
+static int periph_mem_fd = -1;
+static int periph_phys_maps = 0;
+static int periph_gpiomem_fd = -1;
+static uint32_t periph_base_cached = 0;
+static atomic_flag periph_lock = ATOMIC_FLAG_INIT;
+
+static void periph_acquire(void) {
+    while (atomic_flag_test_and_set_explicit(&periph_lock, memory_order_acquire)) {}
+}
+
+static void periph_release(void) {
+    atomic_flag_clear_explicit(&periph_lock, memory_order_release);
+}
+
+static uint32_t periph_be32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+uint32_t periph_detect_base(const char* ranges_path) {
+    FILE* f = fopen(ranges_path ? ranges_path : PERIPH_RANGES_PATH, "rb");
+    if (!f) return PERIPH_DEFAULT_BASE;
+
+    /* <child 0x7e000000> <parent: 1 cell (Pi 2/3) or 2 cells (Pi 4)> <size> */
+    unsigned char buf[12];
+    size_t n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+
+    uint32_t base = 0;
+    if (n >= 8) base = periph_be32(buf + 4);
+    if (base == 0 && n >= 12) base = periph_be32(buf + 8);
+    return base ? base : PERIPH_DEFAULT_BASE;
+}
+
+uint32_t periph_base(void) {
+    if (!periph_base_cached) {
+        periph_base_cached = periph_detect_base(NULL);
+    }
+    return periph_base_cached;
+}
+
+uint32_t periph_offset(periph_block_t block) {
+    if (block < 0 || block >= PERIPH_COUNT) return 0;
+    return periph_blocks[block].offset;
+}
+
+/** Open /dev/mem once; later calls reuse the fd. Caller holds the lock. */
+static int periph_open_mem(int quiet) {
+    if (periph_mem_fd < 0) {
+        periph_mem_fd = periph_io->open("/dev/mem", O_RDWR | O_SYNC | O_CLOEXEC);
+        if (periph_mem_fd < 0 && !quiet) {
+            perror("Can't open /dev/mem (Need sudo?)");
+        }
+    }
+    return periph_mem_fd;
+}
+
+/** Close an fd once no mapped block uses it. Caller holds the lock. */
+static void periph_close_unused(int* fd) {
+    if (*fd < 0) return;
+    if (*fd == periph_mem_fd && periph_phys_maps > 0) return;
+    for (int b = 0; b < PERIPH_COUNT; b++) {
+        if (periph_maps[b].refs > 0 && periph_maps[b].fd == *fd) return;
+    }
+    periph_io->close(*fd);
+    *fd = -1;
+}
+
+volatile uint32_t* periph_map(periph_block_t block) {
+    if (block < 0 || block >= PERIPH_COUNT) return NULL;
+
+#ifndef RPI_GPIO_PLATFORM_RPI
+    if (periph_io == &periph_sys_io) {
+        fprintf(stderr, "Peripheral Error: %s registers are only available on Raspberry Pi\n",
+                periph_blocks[block].name);
+        return NULL;
+    }
+#endif
+
+    periph_acquire();
+    if (periph_maps[block].refs > 0) {
+        periph_maps[block].refs++;
+        volatile uint32_t* map = periph_maps[block].map;
+        periph_release();
+        return map;
+    }
+
+    int fd;
+    off_t offset;
+    if (block == PERIPH_GPIO && periph_open_mem(1) < 0) {
+        /* Unprivileged: the GPIO block alone is exposed through /dev/gpiomem */
+        if (periph_gpiomem_fd < 0) {
+            periph_gpiomem_fd = periph_io->open("/dev/gpiomem", O_RDWR | O_SYNC | O_CLOEXEC);
+        }
+        if (periph_gpiomem_fd < 0) {
+            perror("Can't open /dev/gpiomem");
+            periph_release();
+            return NULL;
+        }
+        fd = periph_gpiomem_fd;
+        offset = 0;
+    } else {
+        fd = periph_open_mem(0);
+        if (fd < 0) {
+            periph_release();
+            return NULL;
+        }
+        offset = (off_t)(periph_base() + periph_blocks[block].offset);
+    }
+
+    void* map = periph_io->mmap(NULL, PERIPH_BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                fd, offset);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "mmap %s error: ", periph_blocks[block].name);
+        perror(NULL);
+        periph_close_unused(&periph_mem_fd);
+        periph_close_unused(&periph_gpiomem_fd);
+        periph_release();
+        return NULL;
+    }
+
+    periph_maps[block].map = (volatile uint32_t*)map;
+    periph_maps[block].refs = 1;
+    periph_maps[block].fd = fd;
+    periph_release();
+    return (volatile uint32_t*)map;
+}
+
+void periph_unmap(periph_block_t block) {
+    if (block < 0 || block >= PERIPH_COUNT) return;
+
+    periph_acquire();
+    if (periph_maps[block].refs > 0 && --periph_maps[block].refs == 0) {
+        periph_io->munmap((void*)periph_maps[block].map, PERIPH_BLOCK_SIZE);
+        periph_maps[block].map = NULL;
+        periph_close_unused(&periph_mem_fd);
+        periph_close_unused(&periph_gpiomem_fd);
+    }
+    periph_release();
+}
+
+void* periph_map_phys(uint32_t phys, size_t size) {
+    if (size == 0) return NULL;
+
+#ifndef RPI_GPIO_PLATFORM_RPI
+    if (periph_io == &periph_sys_io) {
+        fprintf(stderr, "Peripheral Error: physical memory is only available on Raspberry Pi\n");
+        return NULL;
+    }
+#endif
+
+    periph_acquire();
+    int fd = periph_open_mem(0);
+    if (fd < 0) {
+        periph_release();
+        return NULL;
+    }
+
+    void* map = periph_io->mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)phys);
+    if (map == MAP_FAILED) {
+        perror("mmap physical memory error");
+        periph_close_unused(&periph_mem_fd);
+        periph_release();
+        return NULL;
+    }
+    periph_phys_maps++;
+    periph_release();
+    return map;
+}
+
+void periph_unmap_phys(void* addr, size_t size) {
+    if (!addr) return;
+
+    periph_acquire();
+    periph_io->munmap(addr, size);
+    if (periph_phys_maps > 0) periph_phys_maps--;
+    periph_close_unused(&periph_mem_fd);
+    periph_release();
+}
+
+int periph_refcount(periph_block_t block) {
+    if (block < 0 || block >= PERIPH_COUNT) return 0;
+    periph_acquire();
+    int refs = periph_maps[block].refs;
+    periph_release();
+    return refs;
+}
+
+void periph_set_io(const periph_io_t* io) {
+    periph_io = io ? io : &periph_sys_io;
+}
+
+#endif /* RPI_PERIPH_IMPLEMENTATION */
@@ -6,15 +6,52 @@
  * translation unit before including this file.
  *
  * Requires rpi_gpio.h and pthread (-pthread linker flag).
+ *
+ * Channels belong to a pwm_ctx_t that drives pins through a gpio_ctx_t.
+ * pwm_init() and friends use a default context on gpio_ctx_default; on
+ * x86/x64 hosts they only log (MOCK) while explicit contexts run for real
+ * against any backend, including the simulator.
  */
 
 #ifndef RPI_PWM_H
 #define RPI_PWM_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Maximum PWM channels per context. */
+#define MAX_PWM_PINS 8
+
+typedef struct pwm_ctx pwm_ctx_t;
+
+/**
+ * @brief One software PWM channel.
+ */
+typedef struct {
+    int pin;
+    volatile int duty;
+    volatile int period_us;
+    volatile bool running;
+    volatile uint64_t cycles;   /**< Completed periods (written by the channel thread). */
+    pthread_t thread;
+    bool active;
+    pwm_ctx_t* ctx;             /**< Owning context. */
+} pwm_pin_t;
+
+/**
+ * @brief Software PWM instance: channel slots and the GPIO context they drive.
+ */
+struct pwm_ctx {
+    gpio_ctx_t* gpio;                 /**< GPIO context used for output. */
+    pthread_mutex_t mutex;            /**< Guards slot allocation. */
+    pwm_pin_t pins[MAX_PWM_PINS];
+};
+
 /**
  * @brief Initialize software PWM on a pin at 100 Hz.
  * @param pin BCM pin number.
@@ -43,6 +80,45 @@ void pwm_write(int pin, int duty);
  */
 void pwm_stop(int pin);
 
+/** @name Context API */
+/**@{*/
+
+/**
+ * @brief Initialize a PWM context.
+ * @param ctx Context to initialize.
+ * @param gpio GPIO context to drive (NULL for gpio_ctx_default).
+ * @return 0 on success, -1 on error.
+ */
+int pwm_ctx_init(pwm_ctx_t* ctx, gpio_ctx_t* gpio);
+
+/**
+ * @brief Stop every channel of a context and release it.
+ */
+void pwm_ctx_cleanup(pwm_ctx_t* ctx);
+
+/**
+ * @brief Start a channel (no-op if the pin already runs).
+ * @return 0 on success, -1 if all MAX_PWM_PINS slots are in use.
+ */
+int pwm_ctx_start(pwm_ctx_t* ctx, int pin, int freq_hz);
+
+/**
+ * @brief Set the duty cycle (0-100%) of a running channel.
+ */
+void pwm_ctx_write(pwm_ctx_t* ctx, int pin, int duty);
+
+/**
+ * @brief Stop a channel and drive its pin LOW.
+ */
+void pwm_ctx_stop(pwm_ctx_t* ctx, int pin);
+
+/**
+ * @brief Periods completed by a channel since it was started.
+ * @return Cycle count, 0 if the pin is not running.
+ */
+uint64_t pwm_ctx_cycles(pwm_ctx_t* ctx, int pin);
+/**@}*/
+
 #ifdef __cplusplus
 }
 #endif
@@ -53,8 +129,11 @@ void pwm_stop(int pin);
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
-#if defined(__aarch64__) || defined(__arm__)
+/* Platform detection is shared with rpi_gpio.h */
+#ifdef RPI_GPIO_PLATFORM_RPI
     #define RPI_PWM_PLATFORM_RPI
 #else
     #define RPI_PWM_PLATFORM_HOST
@@ -67,104 +146,166 @@ void pwm_stop(int pin);
 /** Clamp duty cycle to valid range [0, 100]. */
 #define PWM_CLAMP_DUTY(d)   ((d) < PWM_DUTY_MIN ? PWM_DUTY_MIN : ((d) > PWM_DUTY_MAX ? PWM_DUTY_MAX : (d)))
 
-#ifdef RPI_PWM_PLATFORM_RPI
-    #include <pthread.h>
-    #include <unistd.h>
-    #include <stdbool.h>
-
-    #define MAX_PWM_PINS 8
-
-    typedef struct {
-        int pin;
-        volatile int duty;
-        volatile int period_us;
-        volatile bool running;
-        pthread_t thread;
-        bool active;
-    } pwm_pin_t;
-
-    static pwm_pin_t pwm_pins[MAX_PWM_PINS] = {0};
-    static pthread_mutex_t pwm_mutex = PTHREAD_MUTEX_INITIALIZER;
-
-    /**
-     * PWM thread main loop:
-     * - Reads volatile duty cycle and period values
-     * - Generates PWM signal by toggling pin HIGH/LOW
-     * - Handles edge cases: 0% duty (always LOW) and 100% duty (always HIGH)
-     */
-    void* pwm_thread_func(void* arg) {
-        pwm_pin_t* p = (pwm_pin_t*)arg;
-
-        while (p->running) {
-            int d = p->duty;
-            int period = p->period_us;
-
-            if (d <= PWM_DUTY_MIN) {
-                /* 0% duty: keep pin LOW for entire period */
-                digital_write(p->pin, LOW);
-                usleep(period);
-            } else if (d >= PWM_DUTY_MAX) {
-                /* 100% duty: keep pin HIGH for entire period */
-                digital_write(p->pin, HIGH);
-                usleep(period);
-            } else {
-                /* Proportional duty: calculate on/off times */
-                int on_time = (period * d) / PWM_DUTY_MAX;
-                int off_time = period - on_time;
-
-                digital_write(p->pin, HIGH);
-                usleep(on_time);
-                digital_write(p->pin, LOW);
-                usleep(off_time);
-            }
+/**
+ * PWM thread main loop:
+ * - Reads volatile duty cycle and period values
+ * - Generates PWM signal by toggling pin HIGH/LOW
+ * - Handles edge cases: 0% duty (always LOW) and 100% duty (always HIGH)
+ */
+void* pwm_thread_func(void* arg) {
+    pwm_pin_t* p = (pwm_pin_t*)arg;
+    gpio_ctx_t* gpio = p->ctx->gpio;
+
+    while (p->running) {
+        int d = p->duty;
+        int period = p->period_us;
+
+        if (d <= PWM_DUTY_MIN) {
+            /* 0% duty: keep pin LOW for entire period */
+            gpio_ctx_write(gpio, p->pin, LOW);
+            usleep(period);
+        } else if (d >= PWM_DUTY_MAX) {
+            /* 100% duty: keep pin HIGH for entire period */
+            gpio_ctx_write(gpio, p->pin, HIGH);
+            usleep(period);
+        } else {
+            /* Proportional duty: calculate on/off times */
+            int on_time = (period * d) / PWM_DUTY_MAX;
+            int off_time = period - on_time;
+
+            gpio_ctx_write(gpio, p->pin, HIGH);
+            usleep(on_time);
+            gpio_ctx_write(gpio, p->pin, LOW);
+            usleep(off_time);
         }
-        return NULL;
+        p->cycles++;
     }
-#endif
+    return NULL;
+}
 
-int pwm_init_freq(int pin, int freq_hz) {
-#ifdef RPI_PWM_PLATFORM_HOST
-    printf("MOCK: PWM initialized on Pin %d at %d Hz\n", pin, freq_hz);
+int pwm_ctx_init(pwm_ctx_t* ctx, gpio_ctx_t* gpio) {
+    if (!ctx) return -1;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->gpio = gpio ? gpio : &gpio_ctx_default;
+    if (pthread_mutex_init(&ctx->mutex, NULL) != 0) {
+        perror("PWM Error: Failed to create mutex");
+        return -1;
+    }
     return 0;
-#else
+}
+
+void pwm_ctx_cleanup(pwm_ctx_t* ctx) {
+    if (!ctx) return;
+    for (int i = 0; i < MAX_PWM_PINS; i++) {
+        if (ctx->pins[i].active) {
+            pwm_ctx_stop(ctx, ctx->pins[i].pin);
+        }
+    }
+    pthread_mutex_destroy(&ctx->mutex);
+}
+
+int pwm_ctx_start(pwm_ctx_t* ctx, int pin, int freq_hz) {
     if (freq_hz <= 0) freq_hz = PWM_DEFAULT_FREQ_HZ;
-    
-    pthread_mutex_lock(&pwm_mutex);
-    
+
+    pthread_mutex_lock(&ctx->mutex);
+
     int slot = -1;
     for (int i = 0; i < MAX_PWM_PINS; i++) {
-        if (pwm_pins[i].active && pwm_pins[i].pin == pin) {
-            pthread_mutex_unlock(&pwm_mutex);
+        if (ctx->pins[i].active && ctx->pins[i].pin == pin) {
+            pthread_mutex_unlock(&ctx->mutex);
             return 0;
         }
-        if (!pwm_pins[i].active && slot == -1) {
+        if (!ctx->pins[i].active && slot == -1) {
             slot = i;
         }
     }
 
     if (slot == -1) {
-        pthread_mutex_unlock(&pwm_mutex);
+        pthread_mutex_unlock(&ctx->mutex);
         fprintf(stderr, "PWM Error: Max pins reached\n");
         return -1;
     }
 
-    pin_mode(pin, OUTPUT);
-    
-    pwm_pins[slot].pin = pin;
-    pwm_pins[slot].duty = 0;
-    pwm_pins[slot].period_us = 1000000 / freq_hz;
-    pwm_pins[slot].running = true;
-    pwm_pins[slot].active = true;
+    gpio_ctx_pin_mode(ctx->gpio, pin, OUTPUT);
+
+    pwm_pin_t* p = &ctx->pins[slot];
+    p->pin = pin;
+    p->duty = 0;
+    p->period_us = 1000000 / freq_hz;
+    p->cycles = 0;
+    p->running = true;
+    p->active = true;
+    p->ctx = ctx;
 
-    if (pthread_create(&pwm_pins[slot].thread, NULL, pwm_thread_func, &pwm_pins[slot]) != 0) {
+    if (pthread_create(&p->thread, NULL, pwm_thread_func, p) != 0) {
         perror("PWM Error: Failed to create thread");
-        pwm_pins[slot].active = false;
-        pthread_mutex_unlock(&pwm_mutex);
+        p->active = false;
+        pthread_mutex_unlock(&ctx->mutex);
         return -1;
     }
 
-    pthread_mutex_unlock(&pwm_mutex);
+    pthread_mutex_unlock(&ctx->mutex);
     return 0;
+}
+
+void pwm_ctx_write(pwm_ctx_t* ctx, int pin, int duty) {
+    duty = PWM_CLAMP_DUTY(duty);
+
+    pthread_mutex_lock(&ctx->mutex);
+    for (int i = 0; i < MAX_PWM_PINS; i++) {
+        if (ctx->pins[i].active && ctx->pins[i].pin == pin) {
+            ctx->pins[i].duty = duty;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+}
+
+void pwm_ctx_stop(pwm_ctx_t* ctx, int pin) {
+    pthread_mutex_lock(&ctx->mutex);
+    for (int i = 0; i < MAX_PWM_PINS; i++) {
+        if (ctx->pins[i].active && ctx->pins[i].pin == pin) {
+            ctx->pins[i].running = false;
+            pthread_mutex_unlock(&ctx->mutex);
+
+            pthread_join(ctx->pins[i].thread, NULL);
+
+            pthread_mutex_lock(&ctx->mutex);
+            gpio_ctx_write(ctx->gpio, pin, LOW);
+            ctx->pins[i].active = false;
+            pthread_mutex_unlock(&ctx->mutex);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+}
+
+uint64_t pwm_ctx_cycles(pwm_ctx_t* ctx, int pin) {
+    uint64_t cycles = 0;
+    pthread_mutex_lock(&ctx->mutex);
+    for (int i = 0; i < MAX_PWM_PINS; i++) {
+        if (ctx->pins[i].active && ctx->pins[i].pin == pin) {
+            cycles = ctx->pins[i].cycles;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+    return cycles;
+}
+
+#ifdef RPI_PWM_PLATFORM_RPI
+static pwm_ctx_t pwm_ctx_default = {
+    .gpio = &gpio_ctx_default,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+#endif
+
+int pwm_init_freq(int pin, int freq_hz) {
+#ifdef RPI_PWM_PLATFORM_HOST
+    printf("MOCK: PWM initialized on Pin %d at %d Hz\n", pin, freq_hz);
+    return 0;
+#else
+    return pwm_ctx_start(&pwm_ctx_default, pin, freq_hz);
 #endif
 }
 
@@ -173,20 +314,11 @@ int pwm_init(int pin) {
 }
 
 void pwm_write(int pin, int duty) {
-    duty = PWM_CLAMP_DUTY(duty);
-
 #ifdef RPI_PWM_PLATFORM_HOST
+    duty = PWM_CLAMP_DUTY(duty);
     printf("MOCK: PWM on Pin %d updated to %d%%\n", pin, duty);
 #else
-    pthread_mutex_lock(&pwm_mutex);
-    for (int i = 0; i < MAX_PWM_PINS; i++) {
-        if (pwm_pins[i].active && pwm_pins[i].pin == pin) {
-            pwm_pins[i].duty = duty;
-            pthread_mutex_unlock(&pwm_mutex);
-            return;
-        }
-    }
-    pthread_mutex_unlock(&pwm_mutex);
+    pwm_ctx_write(&pwm_ctx_default, pin, duty);
 #endif
 }
 
@@ -194,22 +326,7 @@ void pwm_stop(int pin) {
 #ifdef RPI_PWM_PLATFORM_HOST
     printf("MOCK: PWM stopped on Pin %d\n", pin);
 #else
-    pthread_mutex_lock(&pwm_mutex);
-    for (int i = 0; i < MAX_PWM_PINS; i++) {
-        if (pwm_pins[i].active && pwm_pins[i].pin == pin) {
-            pwm_pins[i].running = false;
-            pthread_mutex_unlock(&pwm_mutex);
-            
-            pthread_join(pwm_pins[i].thread, NULL);
-            
-            pthread_mutex_lock(&pwm_mutex);
-            digital_write(pin, LOW);
-            pwm_pins[i].active = false;
-            pthread_mutex_unlock(&pwm_mutex);
-            return;
-        }
-    }
-    pthread_mutex_unlock(&pwm_mutex);
+    pwm_ctx_stop(&pwm_ctx_default, pin);
 #endif
 }
 
@@ -0,0 +1,362 @@
+/**
+ * @file rpi_soft_i2c.h
+ * @brief Bit-banged I2C master with clock stretching and batched messages.
+ *
+ * Single-header library. Define RPI_SOFT_I2C_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h.
+ *
+ * Lines are driven open drain: the output latch of SDA and SCL is set LOW
+ * once, and a line is pulled low by switching the pin to OUTPUT and
+ * released by switching it back to INPUT, so the external pull-ups (or a
+ * slave holding the line) set the level. SCL is read back after every
+ * release, which is what makes clock stretching work.
+ *
+ * A transaction is an array of messages, like Linux i2c_msg: one START, a
+ * repeated START between messages, one STOP at the end (or on the first
+ * NACK). Half periods are a spin loop calibrated against CLOCK_MONOTONIC
+ * once per process; no sleeping, so run it on a core that is not
+ * preempted if the clock must be steady. The spin is the whole half
+ * period, so the achieved rate is below the nominal one by the cost of the
+ * GPIO calls (see bench/bench_soft_i2c).
+ */
+
+#ifndef RPI_SOFT_I2C_H
+#define RPI_SOFT_I2C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default bus clock. */
+#define SOFT_I2C_HZ_DEFAULT 100000
+
+/** Longest a slave may hold SCL low. */
+#ifndef SOFT_I2C_STRETCH_TIMEOUT_US
+#define SOFT_I2C_STRETCH_TIMEOUT_US 25000
+#endif
+
+/** Message flag: read into buf instead of writing it. */
+#define SOFT_I2C_M_RD 0x0001
+
+/** @name Error Codes (soft_i2c_t::error) */
+/**@{*/
+#define SOFT_I2C_OK       0
+#define SOFT_I2C_NACK     1   /**< Address or data byte not acknowledged. */
+#define SOFT_I2C_TIMEOUT  2   /**< SCL held low past SOFT_I2C_STRETCH_TIMEOUT_US. */
+#define SOFT_I2C_INVALID  3   /**< Bad address, length or flags. */
+/**@}*/
+
+/**
+ * @brief One message of a transaction.
+ */
+typedef struct {
+    uint16_t addr;             /**< 7-bit slave address. */
+    uint16_t flags;            /**< SOFT_I2C_M_RD or 0. */
+    uint16_t len;              /**< Bytes (reads need at least one). */
+    uint8_t* buf;
+} soft_i2c_msg_t;
+
+/**
+ * @brief Bus counters.
+ */
+typedef struct {
+    uint64_t transactions;
+    uint64_t bytes;            /**< Data bytes (addresses excluded). */
+    uint64_t nacks;
+    uint64_t stretches;        /**< Times SCL stayed low after release. */
+    uint64_t timeouts;
+} soft_i2c_stats_t;
+
+/**
+ * @brief Bus state.
+ */
+typedef struct {
+    gpio_ctx_t* gpio;
+    int sda;
+    int scl;
+    uint32_t hz;               /**< Nominal clock. */
+    uint32_t half_loops;       /**< Spin iterations per half period. */
+    int error;                 /**< SOFT_I2C_* code of the last call. */
+    soft_i2c_stats_t stats;
+} soft_i2c_t;
+
+/**
+ * @brief Initialize a bus and release both lines.
+ *
+ * Calibrates the spin delay on first use (a few milliseconds).
+ *
+ * @param gpio GPIO context (NULL for gpio_ctx_default).
+ * @param hz Bus clock (0 for SOFT_I2C_HZ_DEFAULT).
+ * @return 0 on success, -1 on error.
+ */
+int soft_i2c_init(soft_i2c_t* bus, gpio_ctx_t* gpio, int sda, int scl, uint32_t hz);
+
+/**
+ * @brief Change the bus clock.
+ */
+void soft_i2c_set_clock(soft_i2c_t* bus, uint32_t hz);
+
+/**
+ * @brief Run a transaction: START, messages joined by repeated STARTs, STOP.
+ * @return 0 on success, -1 on error (bus->error says why; STOP is still sent).
+ */
+int soft_i2c_transfer(soft_i2c_t* bus, soft_i2c_msg_t* msgs, int count);
+
+/** @name Single-Message Helpers */
+/**@{*/
+int soft_i2c_write(soft_i2c_t* bus, uint8_t addr, const uint8_t* data, uint16_t len);
+int soft_i2c_read(soft_i2c_t* bus, uint8_t addr, uint8_t* data, uint16_t len);
+/**@}*/
+
+/**
+ * @brief Write then read with a repeated START (register reads).
+ */
+int soft_i2c_write_read(soft_i2c_t* bus, uint8_t addr, const uint8_t* wdata, uint16_t wlen,
+                        uint8_t* rdata, uint16_t rlen);
+
+/**
+ * @brief Address-only write.
+ * @return 1 if a device acknowledged, 0 otherwise.
+ */
+int soft_i2c_probe(soft_i2c_t* bus, uint8_t addr);
+
+/**
+ * @brief Spin iterations per microsecond (calibrated on first call).
+ */
+double soft_i2c_loops_per_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_SOFT_I2C_H */
+
+#ifdef RPI_SOFT_I2C_IMPLEMENTATION
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static double soft_i2c_calibration = 0.0;
+
+static uint64_t soft_i2c_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline void soft_i2c_spin(uint32_t loops) {
+    for (uint32_t i = 0; i < loops; i++) __asm__ volatile("" ::: "memory");
+}
+
+double soft_i2c_loops_per_us(void) {
+    if (soft_i2c_calibration > 0.0) return soft_i2c_calibration;
+
+    /* Warm up (clock ramp), then best of several runs: a preempted run only
+     * makes the loop look slower */
+    const uint32_t loops = 1000000;
+    uint64_t best = UINT64_MAX;
+    soft_i2c_spin(4 * loops);
+    for (int run = 0; run < 5; run++) {
+        uint64_t t0 = soft_i2c_now_ns();
+        soft_i2c_spin(loops);
+        uint64_t dt = soft_i2c_now_ns() - t0;
+        if (dt < best) best = dt;
+    }
+    soft_i2c_calibration = (double)loops * 1000.0 / (double)(best ? best : 1);
+    return soft_i2c_calibration;
+}
+
+static inline void soft_i2c_half(const soft_i2c_t* bus) {
+    soft_i2c_spin(bus->half_loops);
+}
+
+/* Open-drain emulation: OUTPUT pulls low (latch is LOW), INPUT releases */
+static inline void soft_i2c_sda(soft_i2c_t* bus, int level) {
+    gpio_ctx_pin_mode(bus->gpio, bus->sda, level ? INPUT : OUTPUT);
+}
+
+static inline void soft_i2c_scl_low(soft_i2c_t* bus) {
+    gpio_ctx_pin_mode(bus->gpio, bus->scl, OUTPUT);
+}
+
+/** Release SCL and wait for it to go high (clock stretching). */
+static int soft_i2c_scl_release(soft_i2c_t* bus) {
+    gpio_ctx_pin_mode(bus->gpio, bus->scl, INPUT);
+    if (gpio_ctx_read_fast(bus->gpio, bus->scl)) return 0;
+
+    bus->stats.stretches++;
+    uint64_t deadline = soft_i2c_now_ns() + SOFT_I2C_STRETCH_TIMEOUT_US * 1000ull;
+    while (!gpio_ctx_read_fast(bus->gpio, bus->scl)) {
+        if (soft_i2c_now_ns() > deadline) {
+            bus->stats.timeouts++;
+            bus->error = SOFT_I2C_TIMEOUT;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void soft_i2c_set_clock(soft_i2c_t* bus, uint32_t hz) {
+    if (!bus) return;
+    bus->hz = hz ? hz : SOFT_I2C_HZ_DEFAULT;
+    double half_us = 500000.0 / (double)bus->hz;
+    bus->half_loops = (uint32_t)(half_us * soft_i2c_loops_per_us() + 0.5);
+}
+
+int soft_i2c_init(soft_i2c_t* bus, gpio_ctx_t* gpio, int sda, int scl, uint32_t hz) {
+    if (!bus) return -1;
+    if (!GPIO_VALID_PIN(sda) || !GPIO_VALID_PIN(scl) || sda == scl) {
+        fprintf(stderr, "Soft I2C Error: Invalid pins (SDA %d, SCL %d)\n", sda, scl);
+        return -1;
+    }
+
+    memset(bus, 0, sizeof(*bus));
+    bus->gpio = gpio ? gpio : &gpio_ctx_default;
+    bus->sda = sda;
+    bus->scl = scl;
+    soft_i2c_set_clock(bus, hz);
+
+    /* Release first, then preset the latches so OUTPUT always means low */
+    gpio_ctx_pin_mode(bus->gpio, sda, INPUT);
+    gpio_ctx_pin_mode(bus->gpio, scl, INPUT);
+    gpio_ctx_write(bus->gpio, sda, LOW);
+    gpio_ctx_write(bus->gpio, scl, LOW);
+    return 0;
+}
+
+/* START from idle or repeated START with SCL low */
+static int soft_i2c_start(soft_i2c_t* bus, int repeated) {
+    if (repeated) {
+        soft_i2c_sda(bus, 1);
+        soft_i2c_half(bus);
+        if (soft_i2c_scl_release(bus) != 0) return -1;
+        soft_i2c_half(bus);
+    }
+    soft_i2c_sda(bus, 0);
+    soft_i2c_half(bus);
+    soft_i2c_scl_low(bus);
+    return 0;
+}
+
+static void soft_i2c_stop(soft_i2c_t* bus) {
+    soft_i2c_sda(bus, 0);
+    soft_i2c_half(bus);
+    soft_i2c_scl_release(bus);
+    soft_i2c_half(bus);
+    soft_i2c_sda(bus, 1);
+    soft_i2c_half(bus);
+}
+
+/** Clock one bit; returns the SDA level sampled at the end of SCL high, or -1. */
+static int soft_i2c_bit(soft_i2c_t* bus, int bit) {
+    soft_i2c_sda(bus, bit);
+    soft_i2c_half(bus);
+    if (soft_i2c_scl_release(bus) != 0) return -1;
+    soft_i2c_half(bus);
+    int level = gpio_ctx_read_fast(bus->gpio, bus->sda);
+    soft_i2c_scl_low(bus);
+    return level;
+}
+
+/** Write a byte; returns 0 on ACK, 1 on NACK, -1 on timeout. */
+static int soft_i2c_write_byte(soft_i2c_t* bus, uint8_t byte) {
+    for (int i = 7; i >= 0; i--) {
+        if (soft_i2c_bit(bus, (byte >> i) & 1) < 0) return -1;
+    }
+    return soft_i2c_bit(bus, 1);
+}
+
+/** Read a byte and answer ACK or NACK; returns the byte or -1 on timeout. */
+static int soft_i2c_read_byte(soft_i2c_t* bus, int ack) {
+    int byte = 0;
+    for (int i = 0; i < 8; i++) {
+        int bit = soft_i2c_bit(bus, 1);
+        if (bit < 0) return -1;
+        byte = (byte << 1) | bit;
+    }
+    if (soft_i2c_bit(bus, !ack) < 0) return -1;
+    return byte;
+}
+
+static int soft_i2c_message(soft_i2c_t* bus, const soft_i2c_msg_t* msg) {
+    int rd = msg->flags & SOFT_I2C_M_RD;
+    int r = soft_i2c_write_byte(bus, (uint8_t)((msg->addr << 1) | (rd ? 1 : 0)));
+    if (r != 0) goto fail;
+
+    for (uint16_t i = 0; i < msg->len; i++) {
+        if (rd) {
+            int byte = soft_i2c_read_byte(bus, i + 1 < msg->len);
+            if (byte < 0) return -1;
+            msg->buf[i] = (uint8_t)byte;
+        } else {
+            r = soft_i2c_write_byte(bus, msg->buf[i]);
+            if (r != 0) goto fail;
+        }
+        bus->stats.bytes++;
+    }
+    return 0;
+
+fail:
+    if (r > 0) {
+        bus->stats.nacks++;
+        bus->error = SOFT_I2C_NACK;
+    }
+    return -1;
+}
+
+int soft_i2c_transfer(soft_i2c_t* bus, soft_i2c_msg_t* msgs, int count) {
+    if (!bus) return -1;
+    bus->error = SOFT_I2C_OK;
+    if (!msgs || count <= 0) {
+        bus->error = SOFT_I2C_INVALID;
+        return -1;
+    }
+    for (int m = 0; m < count; m++) {
+        int rd = msgs[m].flags & SOFT_I2C_M_RD;
+        if (msgs[m].addr > 0x7F || (msgs[m].flags & ~SOFT_I2C_M_RD) || (rd && msgs[m].len == 0) ||
+            (msgs[m].len && !msgs[m].buf)) {
+            bus->error = SOFT_I2C_INVALID;
+            return -1;
+        }
+    }
+
+    int result = 0;
+    for (int m = 0; m < count && result == 0; m++) {
+        if (soft_i2c_start(bus, m > 0) != 0 || soft_i2c_message(bus, &msgs[m]) != 0) result = -1;
+    }
+    soft_i2c_stop(bus);
+    bus->stats.transactions++;
+    return result;
+}
+
+int soft_i2c_write(soft_i2c_t* bus, uint8_t addr, const uint8_t* data, uint16_t len) {
+    soft_i2c_msg_t msg = { addr, 0, len, (uint8_t*)data };
+    return soft_i2c_transfer(bus, &msg, 1);
+}
+
+int soft_i2c_read(soft_i2c_t* bus, uint8_t addr, uint8_t* data, uint16_t len) {
+    soft_i2c_msg_t msg = { addr, SOFT_I2C_M_RD, len, data };
+    return soft_i2c_transfer(bus, &msg, 1);
+}
+
+int soft_i2c_write_read(soft_i2c_t* bus, uint8_t addr, const uint8_t* wdata, uint16_t wlen,
+                        uint8_t* rdata, uint16_t rlen) {
+    soft_i2c_msg_t msgs[2] = {
+        { addr, 0, wlen, (uint8_t*)wdata },
+        { addr, SOFT_I2C_M_RD, rlen, rdata },
+    };
+    return soft_i2c_transfer(bus, msgs, 2);
+}
+
+int soft_i2c_probe(soft_i2c_t* bus, uint8_t addr) {
+    soft_i2c_msg_t msg = { addr, 0, 0, NULL };
+    return soft_i2c_transfer(bus, &msg, 1) == 0;
+}
+
+#endif /* RPI_SOFT_I2C_IMPLEMENTATION */
@@ -0,0 +1,307 @@
+/**
+ * @file rpi_soft_spi.h
+ * @brief Bit-banged SPI master on arbitrary GPIO pins.
+ *
+ * Single-header library. Define RPI_SOFT_SPI_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h.
+ *
+ * Each bit is two bulk writes: a data store that drives MOSI together with
+ * one clock edge, and a clock store that makes the other edge. With CPHA 0
+ * the data store carries the trailing edge of the previous bit, with CPHA 1
+ * the leading edge of the current one; either way the slave never samples
+ * in the store where MOSI moves. The data stores are precomputed per byte
+ * value (256 x 8 set/clear pairs for the active mode and bit order), and
+ * MOSI is only written when it changes within the byte, so a bit costs two
+ * or three GPSET/GPCLR stores and no per-bit branching on the data.
+ *
+ * MISO is sampled once per bit, just before the clock store (after half a
+ * period of settling). Chip selects are active low and toggled around each
+ * transfer, or by hand with soft_spi_select()/soft_spi_deselect() for
+ * multi-part transactions. Clock periods are absolute deadlines spun on
+ * CLOCK_MONOTONIC; a clock of 0 runs as fast as the GPIO backend allows.
+ */
+
+#ifndef RPI_SOFT_SPI_H
+#define RPI_SOFT_SPI_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Chip selects per bus. */
+#define SOFT_SPI_MAX_CS 8
+
+/** Pass as the chip select to leave CS alone. */
+#define SOFT_SPI_NO_CS (-1)
+
+/** @name Bit Order */
+/**@{*/
+#define SOFT_SPI_MSB_FIRST 0
+#define SOFT_SPI_LSB_FIRST 1
+/**@}*/
+
+/** Byte clocked out when a transfer has no TX buffer. */
+#ifndef SOFT_SPI_FILL
+#define SOFT_SPI_FILL 0x00
+#endif
+
+/**
+ * @brief Bus state.
+ */
+typedef struct {
+    gpio_ctx_t* gpio;
+    int sck;
+    int mosi;                      /**< -1 for a receive-only bus. */
+    int miso;                      /**< -1 for a transmit-only bus. */
+    int mode;                      /**< 0-3: CPOL = bit 1, CPHA = bit 0. */
+    int bit_order;
+    uint32_t half_period_ns;       /**< 0 = no delay. */
+    uint64_t cs_mask[SOFT_SPI_MAX_CS];
+    int cs_count;
+    gpio_store_t* table;           /**< [byte * 8 + bit] data stores. */
+    gpio_store_t clock;            /**< Second edge of every bit. */
+    gpio_store_t idle;             /**< SCK back to idle (end of a CPHA 0 transfer). */
+    uint64_t bytes;                /**< Bytes transferred. */
+    uint64_t transfers;            /**< soft_spi_transfer() calls. */
+} soft_spi_t;
+
+/**
+ * @brief Initialize a bus in mode 0, MSB first, at full speed.
+ *
+ * Sets SCK and MOSI as outputs (SCK at its idle level) and MISO as input.
+ *
+ * @param gpio GPIO context (NULL for gpio_ctx_default).
+ * @param mosi MOSI pin, or -1.
+ * @param miso MISO pin, or -1.
+ * @return 0 on success, -1 on error.
+ */
+int soft_spi_init(soft_spi_t* spi, gpio_ctx_t* gpio, int sck, int mosi, int miso);
+
+/**
+ * @brief Free the store table.
+ */
+void soft_spi_free(soft_spi_t* spi);
+
+/**
+ * @brief Select mode and bit order; rebuilds the store table and moves SCK to idle.
+ * @param mode 0-3.
+ * @param bit_order SOFT_SPI_MSB_FIRST or SOFT_SPI_LSB_FIRST.
+ * @return 0 on success, -1 on error.
+ */
+int soft_spi_set_mode(soft_spi_t* spi, int mode, int bit_order);
+
+/**
+ * @brief Set the SCK frequency.
+ * @param hz Clock in Hz, 0 for as fast as possible.
+ * @return The frequency actually used (rounded to a whole half period in ns).
+ */
+uint32_t soft_spi_set_clock(soft_spi_t* spi, uint32_t hz);
+
+/**
+ * @brief Add an active-low chip select; the pin is driven high.
+ * @return Chip select index, or -1 on error.
+ */
+int soft_spi_add_cs(soft_spi_t* spi, int pin);
+
+/** @name Manual Chip Select */
+/**@{*/
+void soft_spi_select(soft_spi_t* spi, int cs);
+void soft_spi_deselect(soft_spi_t* spi, int cs);
+/**@}*/
+
+/**
+ * @brief Full-duplex transfer of a buffer.
+ *
+ * @param cs Chip select index, or SOFT_SPI_NO_CS.
+ * @param tx Bytes to send (NULL sends SOFT_SPI_FILL).
+ * @param rx Received bytes (NULL skips sampling MISO).
+ * @param len Bytes to transfer.
+ * @return 0 on success, -1 on error.
+ */
+int soft_spi_transfer(soft_spi_t* spi, int cs, const uint8_t* tx, uint8_t* rx, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_SOFT_SPI_H */
+
+#ifdef RPI_SOFT_SPI_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static inline uint64_t soft_spi_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/** Advance @p deadline by half a period and spin until it passes. */
+static inline void soft_spi_half(const soft_spi_t* spi, uint64_t* deadline) {
+    if (!spi->half_period_ns) return;
+    *deadline += spi->half_period_ns;
+    while (soft_spi_now_ns() < *deadline) {}
+}
+
+static inline uint64_t soft_spi_pin_bit(int pin) {
+    return pin >= 0 ? 1ull << pin : 0;
+}
+
+static void soft_spi_build(soft_spi_t* spi) {
+    uint64_t sck = 1ull << spi->sck;
+    uint64_t mosi = soft_spi_pin_bit(spi->mosi);
+    int cpol = (spi->mode >> 1) & 1;
+    int cpha = spi->mode & 1;
+
+    /* The data store makes the edge the slave does not sample on */
+    int data_sck = cpha ? !cpol : cpol;
+    uint64_t data_set = data_sck ? sck : 0;
+    uint64_t data_clr = data_sck ? 0 : sck;
+
+    for (int byte = 0; byte < 256; byte++) {
+        int prev = -1;
+        for (int i = 0; i < 8; i++) {
+            int bit = spi->bit_order == SOFT_SPI_LSB_FIRST ? (byte >> i) & 1 : (byte >> (7 - i)) & 1;
+            gpio_store_t* st = &spi->table[byte * 8 + i];
+            st->set_mask = data_set;
+            st->clr_mask = data_clr;
+            if (bit != prev) {
+                if (bit) st->set_mask |= mosi;
+                else st->clr_mask |= mosi;
+            }
+            prev = bit;
+        }
+    }
+
+    spi->clock.set_mask = data_clr;
+    spi->clock.clr_mask = data_set;
+    spi->idle.set_mask = cpol ? sck : 0;
+    spi->idle.clr_mask = cpol ? 0 : sck;
+}
+
+int soft_spi_init(soft_spi_t* spi, gpio_ctx_t* gpio, int sck, int mosi, int miso) {
+    if (!spi) return -1;
+    if (!GPIO_VALID_PIN(sck) || (mosi != -1 && !GPIO_VALID_PIN(mosi)) ||
+        (miso != -1 && !GPIO_VALID_PIN(miso)) || sck == mosi || sck == miso ||
+        (mosi != -1 && mosi == miso)) {
+        fprintf(stderr, "Soft SPI Error: Invalid pins (SCK %d, MOSI %d, MISO %d)\n", sck, mosi, miso);
+        return -1;
+    }
+
+    memset(spi, 0, sizeof(*spi));
+    spi->table = (gpio_store_t*)aligned_alloc(64, 256 * 8 * sizeof(gpio_store_t));
+    if (!spi->table) {
+        perror("Soft SPI Error: Failed to allocate store table");
+        return -1;
+    }
+    spi->gpio = gpio ? gpio : &gpio_ctx_default;
+    spi->sck = sck;
+    spi->mosi = mosi;
+    spi->miso = miso;
+
+    gpio_ctx_pin_mode(spi->gpio, sck, OUTPUT);
+    if (mosi >= 0) gpio_ctx_pin_mode(spi->gpio, mosi, OUTPUT);
+    if (miso >= 0) gpio_ctx_pin_mode(spi->gpio, miso, INPUT);
+    return soft_spi_set_mode(spi, 0, SOFT_SPI_MSB_FIRST);
+}
+
+void soft_spi_free(soft_spi_t* spi) {
+    if (!spi) return;
+    free(spi->table);
+    spi->table = NULL;
+}
+
+int soft_spi_set_mode(soft_spi_t* spi, int mode, int bit_order) {
+    if (!spi || !spi->table || mode < 0 || mode > 3) return -1;
+    if (bit_order != SOFT_SPI_MSB_FIRST && bit_order != SOFT_SPI_LSB_FIRST) return -1;
+
+    spi->mode = mode;
+    spi->bit_order = bit_order;
+    soft_spi_build(spi);
+    gpio_ctx_write_mask(spi->gpio, spi->idle.set_mask, spi->idle.clr_mask);
+    return 0;
+}
+
+uint32_t soft_spi_set_clock(soft_spi_t* spi, uint32_t hz) {
+    if (!spi) return 0;
+    if (hz == 0) {
+        spi->half_period_ns = 0;
+        return 0;
+    }
+    uint32_t half = 500000000u / hz;
+    spi->half_period_ns = half ? half : 1;
+    return 500000000u / spi->half_period_ns;
+}
+
+int soft_spi_add_cs(soft_spi_t* spi, int pin) {
+    if (!spi || !GPIO_VALID_PIN(pin) || spi->cs_count == SOFT_SPI_MAX_CS) return -1;
+    if (pin == spi->sck || pin == spi->mosi || pin == spi->miso) {
+        fprintf(stderr, "Soft SPI Error: CS pin %d is a bus pin\n", pin);
+        return -1;
+    }
+
+    gpio_ctx_write(spi->gpio, pin, HIGH);
+    gpio_ctx_pin_mode(spi->gpio, pin, OUTPUT);
+    spi->cs_mask[spi->cs_count] = 1ull << pin;
+    return spi->cs_count++;
+}
+
+void soft_spi_select(soft_spi_t* spi, int cs) {
+    if (!spi || cs < 0 || cs >= spi->cs_count) return;
+    gpio_ctx_write_mask(spi->gpio, 0, spi->cs_mask[cs]);
+}
+
+void soft_spi_deselect(soft_spi_t* spi, int cs) {
+    if (!spi || cs < 0 || cs >= spi->cs_count) return;
+    gpio_ctx_write_mask(spi->gpio, spi->cs_mask[cs], 0);
+}
+
+int soft_spi_transfer(soft_spi_t* spi, int cs, const uint8_t* tx, uint8_t* rx, size_t len) {
+    if (!spi || !spi->table) return -1;
+    if (cs != SOFT_SPI_NO_CS && (cs < 0 || cs >= spi->cs_count)) return -1;
+
+    gpio_ctx_t* gpio = spi->gpio;
+    int sample = rx && spi->miso >= 0;
+    int lsb = spi->bit_order == SOFT_SPI_LSB_FIRST;
+    const gpio_store_t clock = spi->clock;
+    uint64_t deadline = spi->half_period_ns ? soft_spi_now_ns() : 0;
+
+    soft_spi_select(spi, cs);
+    for (size_t n = 0; n < len; n++) {
+        const gpio_store_t* st = &spi->table[(tx ? tx[n] : SOFT_SPI_FILL) * 8];
+        unsigned in = 0;
+
+        for (int i = 0; i < 8; i++) {
+            gpio_ctx_write_mask_fast(gpio, st[i].set_mask, st[i].clr_mask);
+            soft_spi_half(spi, &deadline);
+            if (sample) {
+                unsigned bit = (unsigned)gpio_ctx_read_fast(gpio, spi->miso);
+                in = lsb ? in | (bit << i) : (in << 1) | bit;
+            }
+            gpio_ctx_write_mask_fast(gpio, clock.set_mask, clock.clr_mask);
+            soft_spi_half(spi, &deadline);
+        }
+        if (rx) rx[n] = sample ? (uint8_t)in : 0;
+    }
+
+    /* CPHA 0 leaves SCK on the leading edge of the last bit */
+    if (!(spi->mode & 1) && len) {
+        gpio_ctx_write_mask_fast(gpio, spi->idle.set_mask, spi->idle.clr_mask);
+        soft_spi_half(spi, &deadline);
+    }
+    soft_spi_deselect(spi, cs);
+
+    spi->bytes += len;
+    spi->transfers++;
+    return 0;
+}
+
+#endif /* RPI_SOFT_SPI_IMPLEMENTATION */
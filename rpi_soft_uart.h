@@ -0,0 +1,687 @@
+/**
+ * @file rpi_soft_uart.h
+ * @brief Bit-banged UART ports on arbitrary GPIO pins, served by one thread.
+ *
+ * Single-header library. Define RPI_SOFT_UART_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h, rpi_realtime.h and pthread (-pthread linker flag).
+ *
+ * Every port of a set is served from the same loop: each pass takes one
+ * level snapshot (gpio_read_all()) and one timestamp, handles every bit
+ * that is due on any port, and applies all TX level changes in a single
+ * GPSET/GPCLR store.
+ *   - TX: each byte becomes a precomputed frame (start bit, data LSB first,
+ *     optional parity, stop bits) from a 256-entry table. Bit k of a frame
+ *     goes out at frame_start + k / baud, an absolute deadline, and frames
+ *     queued back to back start exactly at the end of the previous stop
+ *     bit, so lateness never accumulates.
+ *   - RX: a falling edge on an idle, armed line starts a frame; its time is
+ *     taken as the midpoint between the two snapshots around it, and every
+ *     bit is then sampled once at its centre. Alternatively, a port can be
+ *     fed timestamped edges (soft_uart_edge(), e.g. from rpi_gpio_event.h),
+ *     in which case the start time is exact and each centre takes the level
+ *     held across it.
+ * A start bit that is high again at its centre counts as a false start, a
+ * low stop bit as a framing error (the line must go high before the next
+ * start is accepted, so a break is one error), a parity mismatch as a
+ * parity error. Received bytes go to a per-port single-producer,
+ * single-consumer ring; bytes that find it full are counted as overruns.
+ *
+ * soft_uart_start() runs the loop on a thread that busy-polls (pin it to an
+ * isolated core for 115200 baud). Each port reports the time spent on its
+ * bits (busy_ns) and the worst lateness of a bit against its deadline.
+ */
+
+#ifndef RPI_SOFT_UART_H
+#define RPI_SOFT_UART_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Ports per set. */
+#define SOFT_UART_MAX_PORTS 8
+
+/** Bytes per TX and RX ring (power of two). */
+#ifndef SOFT_UART_BUF
+#define SOFT_UART_BUF 1024
+#endif
+
+/** Supported baud rates. */
+#define SOFT_UART_MIN_BAUD 50
+#define SOFT_UART_MAX_BAUD 250000
+
+/** Pass as the TX or RX pin for a one-way port. */
+#define SOFT_UART_NO_PIN (-1)
+
+/** @name Parity */
+/**@{*/
+#define SOFT_UART_PARITY_NONE 0
+#define SOFT_UART_PARITY_EVEN 1
+#define SOFT_UART_PARITY_ODD  2
+/**@}*/
+
+/** Sleep between passes when no port needs polling. */
+#define SOFT_UART_IDLE_US 200
+
+/** Sleeps end this long before a deadline, which is then spun on. */
+#ifndef SOFT_UART_SPIN_NS
+#define SOFT_UART_SPIN_NS 50000
+#endif
+
+/**
+ * @brief Per-port counters.
+ */
+typedef struct {
+    uint64_t tx_bytes;        /**< Frames completed, including stop bits. */
+    uint64_t rx_bytes;        /**< Bytes stored in the RX ring. */
+    uint64_t framing_errors;  /**< Low stop bit. */
+    uint64_t parity_errors;
+    uint64_t false_starts;    /**< Start bit high again at its centre (noise). */
+    uint64_t overruns;        /**< Received bytes dropped on a full ring. */
+    uint64_t busy_ns;         /**< Time spent on this port's bits (soft_uart_poll() only). */
+    uint64_t max_late_ns;     /**< Worst TX bit or RX sample behind its deadline. */
+} soft_uart_stats_t;
+
+/**
+ * @brief One port. Rings are shared with the caller; everything else
+ * belongs to the thread that services the set.
+ */
+typedef struct {
+    uint64_t tx_head __attribute__((aligned(64)));  /**< Written by soft_uart_write(). */
+    uint64_t tx_tail __attribute__((aligned(64)));  /**< Written by the service loop. */
+    uint64_t rx_head __attribute__((aligned(64)));  /**< Written by the service loop. */
+    uint64_t rx_tail __attribute__((aligned(64)));  /**< Written by soft_uart_read(). */
+    uint8_t tx_buf[SOFT_UART_BUF];
+    uint8_t rx_buf[SOFT_UART_BUF];
+    uint16_t frames[256];      /**< Line level per bit, start bit in bit 0. */
+    int tx_pin;
+    int rx_pin;
+    uint32_t baud;
+    int data_bits;             /**< 5-8. */
+    int parity;
+    int stop_bits;             /**< 1-2. */
+    int frame_bits;            /**< Start + data + parity + stop. */
+    int rx_edges;              /**< RX fed by soft_uart_edge() instead of snapshots. */
+
+    int tx_bit;                /**< Next bit of tx_frame, -1 when idle. */
+    int tx_active;             /**< A frame is on the line (read by soft_uart_tx_idle()). */
+    int tx_level;
+    uint16_t tx_frame;
+    uint64_t tx_start_ns;
+    uint64_t tx_next_ns;
+    uint64_t tx_end_ns;        /**< End of the last stop bit sent. */
+
+    int rx_bit;                /**< Bit sampled next, -1 when idle. */
+    int rx_armed;              /**< Line seen high since the last frame. */
+    int rx_level;              /**< Level after the last edge (edge mode). */
+    uint32_t rx_shift;
+    uint64_t rx_start_ns;
+    uint64_t rx_next_ns;
+
+    soft_uart_stats_t stats;
+} soft_uart_port_t;
+
+/**
+ * @brief Ports served together.
+ */
+typedef struct {
+    soft_uart_port_t port[SOFT_UART_MAX_PORTS];
+    int count;
+    gpio_ctx_t* gpio;
+    int polled_rx;             /**< Ports that need every snapshot for start bits. */
+    int primed;
+    uint64_t last_ns;          /**< Time of the previous pass. */
+    uint64_t passes;           /**< Service passes (written by the service loop). */
+    uint64_t thread_cpu_ns;    /**< CPU time of the service thread, set by soft_uart_stop(). */
+    uint64_t thread_ns;        /**< Wall time of the service thread, set by soft_uart_stop(). */
+    pthread_t thread;
+    int running;
+    int realtime;              /**< Thread got SCHED_FIFO. */
+    int core_id;
+} soft_uart_t;
+
+/**
+ * @brief Initialize an empty set.
+ * @param gpio GPIO context (NULL for gpio_ctx_default).
+ * @return 0 on success, -1 on error.
+ */
+int soft_uart_init(soft_uart_t* uart, gpio_ctx_t* gpio);
+
+/**
+ * @brief Add an 8N1 port. TX is driven high (idle) and made an output; RX
+ * is made an input.
+ * @param tx_pin TX pin, or SOFT_UART_NO_PIN.
+ * @param rx_pin RX pin, or SOFT_UART_NO_PIN.
+ * @return Port index, or -1 on error.
+ */
+int soft_uart_add(soft_uart_t* uart, int tx_pin, int rx_pin, uint32_t baud);
+
+/**
+ * @brief Change the frame format of an idle port.
+ * @param data_bits 5-8.
+ * @param parity SOFT_UART_PARITY_NONE, _EVEN or _ODD.
+ * @param stop_bits 1 or 2 (RX checks the first).
+ * @return 0 on success, -1 on error.
+ */
+int soft_uart_set_format(soft_uart_t* uart, int port, int data_bits, int parity, int stop_bits);
+
+/**
+ * @brief Take RX from soft_uart_edge() instead of level snapshots.
+ *
+ * The line is taken to be idle (high) from here on. Edges must come from
+ * the thread that services the set, so ports in this mode cannot be used
+ * with soft_uart_start().
+ */
+int soft_uart_set_rx_edges(soft_uart_t* uart, int port, int enable);
+
+/** @name Data (any one thread per port and direction) */
+/**@{*/
+/** Queue bytes for TX. @return Bytes queued (fewer when the ring fills). */
+size_t soft_uart_write(soft_uart_t* uart, int port, const uint8_t* data, size_t len);
+/** Take received bytes. @return Bytes copied. */
+size_t soft_uart_read(soft_uart_t* uart, int port, uint8_t* data, size_t max);
+/** Received bytes waiting. */
+size_t soft_uart_available(soft_uart_t* uart, int port);
+/** 1 once every queued byte has left the line (stop bits included). */
+int soft_uart_tx_idle(soft_uart_t* uart, int port);
+/**@}*/
+
+/**
+ * @brief One service pass over a given snapshot (for your own loop or a
+ * simulated clock).
+ * @param levels gpio_read_all()-style levels.
+ * @param t_ns CLOCK_MONOTONIC time of the snapshot.
+ * @return Earliest pending deadline (TX bit or RX sample), UINT64_MAX if none.
+ */
+uint64_t soft_uart_update(soft_uart_t* uart, uint64_t levels, uint64_t t_ns);
+
+/**
+ * @brief Read the context and service it, charging each port its share.
+ * @return As soft_uart_update().
+ */
+uint64_t soft_uart_poll(soft_uart_t* uart);
+
+/**
+ * @brief Apply one edge on a pin to the ports in edge mode that receive on it.
+ * Samples due before t_ns take the level held before the edge.
+ */
+void soft_uart_edge(soft_uart_t* uart, int pin, int level, uint64_t t_ns);
+
+/**
+ * @brief Start the service thread.
+ *
+ * The thread busy-polls while any port receives. With core_id >= 0 it is
+ * pinned and raised to SCHED_FIFO when permitted (on a shared core the
+ * spinning would starve everything else, so unpinned threads stay normal).
+ *
+ * @return 0 on success, -1 on error.
+ */
+int soft_uart_start(soft_uart_t* uart, int core_id);
+
+/**
+ * @brief Stop the service thread and record its CPU and wall time.
+ */
+void soft_uart_stop(soft_uart_t* uart);
+
+/**
+ * @brief Copy a port's counters (safe while the thread runs).
+ */
+void soft_uart_get_stats(soft_uart_t* uart, int port, soft_uart_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_SOFT_UART_H */
+
+#ifdef RPI_SOFT_UART_IMPLEMENTATION
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+
+static inline uint64_t soft_uart_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Counters are read by other threads through soft_uart_get_stats() */
+static inline void soft_uart_count(uint64_t* counter, uint64_t n) {
+    __atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+static inline void soft_uart_late(soft_uart_port_t* p, uint64_t deadline, uint64_t t_ns) {
+    if (t_ns > deadline && t_ns - deadline > p->stats.max_late_ns) {
+        __atomic_store_n(&p->stats.max_late_ns, t_ns - deadline, __ATOMIC_RELAXED);
+    }
+}
+
+/** Start of bit @p bit from the start of its frame (no rounding drift). */
+static inline uint64_t soft_uart_bit_ns(const soft_uart_port_t* p, int bit) {
+    return (uint64_t)bit * 1000000000ull / p->baud;
+}
+
+/** Centre of bit @p bit from the start of its frame. */
+static inline uint64_t soft_uart_mid_ns(const soft_uart_port_t* p, int bit) {
+    return (uint64_t)(2 * bit + 1) * 1000000000ull / (2ull * p->baud);
+}
+
+static inline int soft_uart_valid_port(const soft_uart_t* uart, int port) {
+    return uart && port >= 0 && port < uart->count;
+}
+
+static void soft_uart_build(soft_uart_port_t* p) {
+    int par = p->parity != SOFT_UART_PARITY_NONE;
+    p->frame_bits = 1 + p->data_bits + par + p->stop_bits;
+    for (int byte = 0; byte < 256; byte++) {
+        unsigned data = (unsigned)byte & ((1u << p->data_bits) - 1);
+        uint16_t frame = (uint16_t)(data << 1);  /* Start bit 0 */
+        int bit = 1 + p->data_bits;
+        if (par) {
+            unsigned odd = (unsigned)__builtin_popcount(data) & 1;
+            if (odd ^ (p->parity == SOFT_UART_PARITY_ODD)) frame |= (uint16_t)(1u << bit);
+            bit++;
+        }
+        for (int s = 0; s < p->stop_bits; s++) frame |= (uint16_t)(1u << bit++);
+        p->frames[byte] = frame;
+    }
+}
+
+int soft_uart_init(soft_uart_t* uart, gpio_ctx_t* gpio) {
+    if (!uart) return -1;
+    memset(uart, 0, sizeof(*uart));
+    uart->gpio = gpio ? gpio : &gpio_ctx_default;
+    uart->core_id = -1;
+    return 0;
+}
+
+int soft_uart_add(soft_uart_t* uart, int tx_pin, int rx_pin, uint32_t baud) {
+    if (!uart || uart->running) return -1;
+    if ((tx_pin != SOFT_UART_NO_PIN && !GPIO_VALID_PIN(tx_pin)) ||
+        (rx_pin != SOFT_UART_NO_PIN && !GPIO_VALID_PIN(rx_pin)) || (tx_pin < 0 && rx_pin < 0) ||
+        tx_pin == rx_pin) {
+        fprintf(stderr, "Soft UART Error: Invalid pins (TX %d, RX %d)\n", tx_pin, rx_pin);
+        return -1;
+    }
+    if (baud < SOFT_UART_MIN_BAUD || baud > SOFT_UART_MAX_BAUD) {
+        fprintf(stderr, "Soft UART Error: Baud rate %u out of range\n", baud);
+        return -1;
+    }
+    if (uart->count == SOFT_UART_MAX_PORTS) {
+        fprintf(stderr, "Soft UART Error: Set is full\n");
+        return -1;
+    }
+
+    soft_uart_port_t* p = &uart->port[uart->count];
+    memset(p, 0, sizeof(*p));
+    p->tx_pin = tx_pin;
+    p->rx_pin = rx_pin;
+    p->baud = baud;
+    p->data_bits = 8;
+    p->stop_bits = 1;
+    p->tx_bit = -1;
+    p->tx_level = 1;
+    p->rx_bit = -1;
+    p->rx_level = 1;
+    soft_uart_build(p);
+
+    if (tx_pin >= 0) {
+        gpio_ctx_write(uart->gpio, tx_pin, HIGH);
+        gpio_ctx_pin_mode(uart->gpio, tx_pin, OUTPUT);
+    }
+    if (rx_pin >= 0) {
+        gpio_ctx_pin_mode(uart->gpio, rx_pin, INPUT);
+        uart->polled_rx++;
+    }
+    return uart->count++;
+}
+
+int soft_uart_set_format(soft_uart_t* uart, int port, int data_bits, int parity, int stop_bits) {
+    if (!soft_uart_valid_port(uart, port) || uart->running) return -1;
+    if (data_bits < 5 || data_bits > 8 || parity < SOFT_UART_PARITY_NONE || parity > SOFT_UART_PARITY_ODD ||
+        stop_bits < 1 || stop_bits > 2) {
+        return -1;
+    }
+    soft_uart_port_t* p = &uart->port[port];
+    if (p->tx_bit >= 0 || p->rx_bit >= 0) return -1;
+    p->data_bits = data_bits;
+    p->parity = parity;
+    p->stop_bits = stop_bits;
+    soft_uart_build(p);
+    return 0;
+}
+
+int soft_uart_set_rx_edges(soft_uart_t* uart, int port, int enable) {
+    if (!soft_uart_valid_port(uart, port) || uart->running) return -1;
+    soft_uart_port_t* p = &uart->port[port];
+    if (p->rx_pin < 0 || p->rx_bit >= 0) return -1;
+    enable = enable != 0;
+    if (enable != p->rx_edges) uart->polled_rx += enable ? -1 : 1;
+    p->rx_edges = enable;
+    p->rx_level = 1;
+    p->rx_armed = enable;
+    return 0;
+}
+
+size_t soft_uart_write(soft_uart_t* uart, int port, const uint8_t* data, size_t len) {
+    if (!soft_uart_valid_port(uart, port) || !data) return 0;
+    soft_uart_port_t* p = &uart->port[port];
+    if (p->tx_pin < 0) return 0;
+
+    uint64_t head = p->tx_head;
+    uint64_t tail = __atomic_load_n(&p->tx_tail, __ATOMIC_ACQUIRE);
+    size_t room = SOFT_UART_BUF - (size_t)(head - tail);
+    if (len > room) len = room;
+    for (size_t i = 0; i < len; i++) p->tx_buf[(head + i) & (SOFT_UART_BUF - 1)] = data[i];
+    __atomic_store_n(&p->tx_head, head + len, __ATOMIC_RELEASE);
+    return len;
+}
+
+size_t soft_uart_read(soft_uart_t* uart, int port, uint8_t* data, size_t max) {
+    if (!soft_uart_valid_port(uart, port) || !data) return 0;
+    soft_uart_port_t* p = &uart->port[port];
+
+    uint64_t tail = p->rx_tail;
+    uint64_t head = __atomic_load_n(&p->rx_head, __ATOMIC_ACQUIRE);
+    size_t n = (size_t)(head - tail);
+    if (n > max) n = max;
+    for (size_t i = 0; i < n; i++) data[i] = p->rx_buf[(tail + i) & (SOFT_UART_BUF - 1)];
+    __atomic_store_n(&p->rx_tail, tail + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+size_t soft_uart_available(soft_uart_t* uart, int port) {
+    if (!soft_uart_valid_port(uart, port)) return 0;
+    soft_uart_port_t* p = &uart->port[port];
+    return (size_t)(__atomic_load_n(&p->rx_head, __ATOMIC_ACQUIRE) - p->rx_tail);
+}
+
+int soft_uart_tx_idle(soft_uart_t* uart, int port) {
+    if (!soft_uart_valid_port(uart, port)) return 1;
+    soft_uart_port_t* p = &uart->port[port];
+    return __atomic_load_n(&p->tx_tail, __ATOMIC_ACQUIRE) == p->tx_head &&
+           !__atomic_load_n(&p->tx_active, __ATOMIC_ACQUIRE);
+}
+
+/* ============================================================================
+ * RECEIVE
+ * ============================================================================ */
+
+static void soft_uart_rx_begin(soft_uart_port_t* p, uint64_t start_ns) {
+    p->rx_bit = 0;
+    p->rx_shift = 0;
+    p->rx_start_ns = start_ns;
+    p->rx_next_ns = start_ns + soft_uart_mid_ns(p, 0);
+}
+
+static void soft_uart_rx_store(soft_uart_port_t* p) {
+    unsigned data = p->rx_shift & ((1u << p->data_bits) - 1);
+    if (p->parity != SOFT_UART_PARITY_NONE) {
+        unsigned ones = (unsigned)__builtin_popcount(p->rx_shift & ((2u << p->data_bits) - 1));
+        if ((ones & 1) != (p->parity == SOFT_UART_PARITY_ODD)) {
+            soft_uart_count(&p->stats.parity_errors, 1);
+            return;
+        }
+    }
+
+    uint64_t head = p->rx_head;
+    if (head - __atomic_load_n(&p->rx_tail, __ATOMIC_ACQUIRE) == SOFT_UART_BUF) {
+        soft_uart_count(&p->stats.overruns, 1);
+        return;
+    }
+    p->rx_buf[head & (SOFT_UART_BUF - 1)] = (uint8_t)data;
+    __atomic_store_n(&p->rx_head, head + 1, __ATOMIC_RELEASE);
+    soft_uart_count(&p->stats.rx_bytes, 1);
+}
+
+/** Take every bit centre up to @p t_ns as @p level. */
+static void soft_uart_rx_until(soft_uart_port_t* p, uint64_t t_ns, int level) {
+    int last = p->data_bits + (p->parity != SOFT_UART_PARITY_NONE) + 1;  /* First stop bit */
+    while (p->rx_bit >= 0 && p->rx_next_ns <= t_ns) {
+        int bit = p->rx_bit;
+        if (bit == 0) {
+            if (level) {
+                soft_uart_count(&p->stats.false_starts, 1);
+                p->rx_bit = -1;
+                p->rx_armed = 1;
+                return;
+            }
+        } else if (bit < last) {
+            p->rx_shift |= (uint32_t)level << (bit - 1);
+        } else {
+            p->rx_bit = -1;
+            p->rx_armed = level;
+            if (level) soft_uart_rx_store(p);
+            else soft_uart_count(&p->stats.framing_errors, 1);
+            return;
+        }
+        p->rx_bit = bit + 1;
+        p->rx_next_ns = p->rx_start_ns + soft_uart_mid_ns(p, bit + 1);
+    }
+}
+
+void soft_uart_edge(soft_uart_t* uart, int pin, int level, uint64_t t_ns) {
+    if (!uart || !GPIO_VALID_PIN(pin)) return;
+    for (int i = 0; i < uart->count; i++) {
+        soft_uart_port_t* p = &uart->port[i];
+        if (!p->rx_edges || p->rx_pin != pin) continue;
+
+        if (p->rx_bit >= 0 && t_ns) soft_uart_rx_until(p, t_ns - 1, p->rx_level);
+        p->rx_level = level != 0;
+        if (p->rx_bit < 0) {
+            if (p->rx_level) p->rx_armed = 1;
+            else if (p->rx_armed) soft_uart_rx_begin(p, t_ns);
+        }
+    }
+}
+
+/* ============================================================================
+ * SERVICE LOOP
+ * ============================================================================ */
+
+/**
+ * Everything due on one port at @p t_ns. TX level changes are collected in
+ * the masks for one shared store. @return 1 if any bit was handled.
+ */
+static int soft_uart_service(soft_uart_t* uart, soft_uart_port_t* p, uint64_t levels, uint64_t t_ns,
+                             uint64_t* set_mask, uint64_t* clr_mask, uint64_t* next) {
+    int work = 0;
+
+    if (p->rx_pin >= 0) {
+        int level = p->rx_edges ? p->rx_level : (int)((levels >> p->rx_pin) & 1);
+        if (p->rx_bit < 0 && !p->rx_edges) {
+            if (level) {
+                p->rx_armed = 1;
+            } else if (p->rx_armed) {
+                /* The edge fell somewhere since the previous snapshot */
+                uint64_t prev = uart->primed ? uart->last_ns : t_ns;
+                soft_uart_rx_begin(p, prev + (t_ns - prev) / 2);
+                work = 1;
+            }
+        }
+        if (p->rx_bit >= 0 && p->rx_next_ns <= t_ns) {
+            if (!p->rx_edges) soft_uart_late(p, p->rx_next_ns, t_ns);
+            soft_uart_rx_until(p, t_ns, level);
+            work = 1;
+        }
+        if (p->rx_bit >= 0 && p->rx_next_ns < *next) *next = p->rx_next_ns;
+    }
+
+    if (p->tx_pin >= 0) {
+        int chained = 0;
+        if (p->tx_bit == p->frame_bits && p->tx_next_ns <= t_ns) {
+            /* End of the last stop bit */
+            p->tx_end_ns = p->tx_next_ns;
+            p->tx_bit = -1;
+            soft_uart_count(&p->stats.tx_bytes, 1);
+            chained = 1;
+            work = 1;
+        }
+        if (p->tx_bit < 0) {
+            uint64_t tail = p->tx_tail;
+            if (tail != __atomic_load_n(&p->tx_head, __ATOMIC_ACQUIRE)) {
+                p->tx_frame = p->frames[p->tx_buf[tail & (SOFT_UART_BUF - 1)]];
+                __atomic_store_n(&p->tx_tail, tail + 1, __ATOMIC_RELEASE);
+                p->tx_start_ns = chained ? p->tx_end_ns : t_ns;
+                p->tx_next_ns = p->tx_start_ns;
+                p->tx_bit = 0;
+                __atomic_store_n(&p->tx_active, 1, __ATOMIC_RELEASE);
+            } else if (chained) {
+                __atomic_store_n(&p->tx_active, 0, __ATOMIC_RELEASE);
+            }
+        }
+        if (p->tx_bit >= 0 && p->tx_bit < p->frame_bits && p->tx_next_ns <= t_ns) {
+            int level = (p->tx_frame >> p->tx_bit) & 1;
+            if (level != p->tx_level) {
+                if (level) *set_mask |= 1ull << p->tx_pin;
+                else *clr_mask |= 1ull << p->tx_pin;
+                p->tx_level = level;
+            }
+            soft_uart_late(p, p->tx_next_ns, t_ns);
+            p->tx_bit++;
+            p->tx_next_ns = p->tx_start_ns + soft_uart_bit_ns(p, p->tx_bit);
+            work = 1;
+        }
+        if (p->tx_bit >= 0 && p->tx_next_ns < *next) *next = p->tx_next_ns;
+    }
+    return work;
+}
+
+static uint64_t soft_uart_pass(soft_uart_t* uart, uint64_t levels, uint64_t t_ns, int timed) {
+    uint64_t set_mask = 0, clr_mask = 0, next = UINT64_MAX;
+    uint64_t mark = t_ns;
+    int stores = 0;
+    soft_uart_port_t* owners[SOFT_UART_MAX_PORTS];
+
+    for (int i = 0; i < uart->count; i++) {
+        soft_uart_port_t* p = &uart->port[i];
+        uint64_t drive = set_mask | clr_mask;
+        if (!soft_uart_service(uart, p, levels, t_ns, &set_mask, &clr_mask, &next)) continue;
+        if ((set_mask | clr_mask) != drive) owners[stores++] = p;
+        if (timed) {
+            uint64_t now = soft_uart_now_ns();
+            soft_uart_count(&p->stats.busy_ns, now - mark);
+            mark = now;
+        }
+    }
+
+    if (set_mask | clr_mask) {
+        gpio_ctx_write_mask(uart->gpio, set_mask, clr_mask);
+        if (timed) {
+            /* The shared store is split between the ports that drove it */
+            uint64_t share = (soft_uart_now_ns() - mark) / (uint64_t)stores;
+            for (int i = 0; i < stores; i++) soft_uart_count(&owners[i]->stats.busy_ns, share);
+        }
+    }
+
+    uart->last_ns = t_ns;
+    uart->primed = 1;
+    __atomic_store_n(&uart->passes, uart->passes + 1, __ATOMIC_RELAXED);
+    return next;
+}
+
+uint64_t soft_uart_update(soft_uart_t* uart, uint64_t levels, uint64_t t_ns) {
+    if (!uart) return UINT64_MAX;
+    return soft_uart_pass(uart, levels, t_ns, 0);
+}
+
+uint64_t soft_uart_poll(soft_uart_t* uart) {
+    if (!uart) return UINT64_MAX;
+    uint64_t t_ns = soft_uart_now_ns();
+    uint64_t levels = uart->polled_rx ? gpio_ctx_read_all(uart->gpio) : 0;
+    return soft_uart_pass(uart, levels, t_ns, 1);
+}
+
+/* ============================================================================
+ * SERVICE THREAD
+ * ============================================================================ */
+
+static uint64_t soft_uart_clock_ns(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void* soft_uart_thread_func(void* arg) {
+    soft_uart_t* uart = (soft_uart_t*)arg;
+    if (uart->core_id >= 0) {
+        pin_to_core(uart->core_id);
+        struct sched_param param = { .sched_priority = sched_get_priority_max(SCHED_FIFO) };
+        uart->realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+
+    uint64_t start = soft_uart_now_ns();
+    uint64_t cpu_start = soft_uart_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    while (__atomic_load_n(&uart->running, __ATOMIC_RELAXED)) {
+        uint64_t next = soft_uart_poll(uart);
+        if (uart->polled_rx) continue;
+
+        /* TX only: sleep up to the next bit, or a while when nothing is queued */
+        uint64_t now = soft_uart_now_ns();
+        if (next == UINT64_MAX) {
+            usleep(SOFT_UART_IDLE_US);
+        } else if (next > now + SOFT_UART_SPIN_NS) {
+            uint64_t wake = next - SOFT_UART_SPIN_NS;
+            struct timespec ts = { (time_t)(wake / 1000000000ull), (long)(wake % 1000000000ull) };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        }
+    }
+    uart->thread_cpu_ns = soft_uart_clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+    uart->thread_ns = soft_uart_now_ns() - start;
+    return NULL;
+}
+
+int soft_uart_start(soft_uart_t* uart, int core_id) {
+    if (!uart) return -1;
+    if (uart->running) {
+        fprintf(stderr, "Soft UART Error: Service thread already running\n");
+        return -1;
+    }
+    for (int i = 0; i < uart->count; i++) {
+        if (uart->port[i].rx_edges) {
+            fprintf(stderr, "Soft UART Error: Port %d takes edges, service it from the edge thread\n", i);
+            return -1;
+        }
+    }
+
+    uart->core_id = core_id;
+    uart->realtime = 0;
+    uart->primed = 0;
+    __atomic_store_n(&uart->running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&uart->thread, NULL, soft_uart_thread_func, uart) != 0) {
+        perror("Soft UART Error: Failed to create thread");
+        uart->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void soft_uart_stop(soft_uart_t* uart) {
+    if (!uart || !uart->running) return;
+    __atomic_store_n(&uart->running, 0, __ATOMIC_RELEASE);
+    pthread_join(uart->thread, NULL);
+}
+
+void soft_uart_get_stats(soft_uart_t* uart, int port, soft_uart_stats_t* stats) {
+    if (!soft_uart_valid_port(uart, port) || !stats) return;
+    const soft_uart_stats_t* s = &uart->port[port].stats;
+    stats->tx_bytes = __atomic_load_n(&s->tx_bytes, __ATOMIC_RELAXED);
+    stats->rx_bytes = __atomic_load_n(&s->rx_bytes, __ATOMIC_RELAXED);
+    stats->framing_errors = __atomic_load_n(&s->framing_errors, __ATOMIC_RELAXED);
+    stats->parity_errors = __atomic_load_n(&s->parity_errors, __ATOMIC_RELAXED);
+    stats->false_starts = __atomic_load_n(&s->false_starts, __ATOMIC_RELAXED);
+    stats->overruns = __atomic_load_n(&s->overruns, __ATOMIC_RELAXED);
+    stats->busy_ns = __atomic_load_n(&s->busy_ns, __ATOMIC_RELAXED);
+    stats->max_late_ns = __atomic_load_n(&s->max_late_ns, __ATOMIC_RELAXED);
+}
+
+#endif /* RPI_SOFT_UART_IMPLEMENTATION */
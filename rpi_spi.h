@@ -0,0 +1,930 @@
+/**
+ * @file rpi_spi.h
+ * @brief Hardware SPI0 master via MMIO, with DMA for large transfers.
+ *
+ * Single-header library. Define RPI_SPI_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h and root privileges (/dev/mem, mailbox memory for
+ * DMA).
+ *
+ * spi_ctx_init() maps the SPI0 block through rpi_periph.h, the same way
+ * rpi_hw_pwm.h maps PWM, and muxes GPIO 7-11 to ALT0. Transfers bypass
+ * spidev entirely:
+ *   - Polled: the CPU keeps up to SPI_FIFO_BYTES bytes in flight, refilling
+ *     the TX FIFO without status reads and draining the RX FIFO in blind
+ *     bursts while RXR is set. Best for short messages, where DMA setup
+ *     costs more than the transfer.
+ *   - DMA: a transfer queue (spi_queue_t) holds prebuilt control block
+ *     pairs in DMA memory, one TX channel paced by DREQ 6 and one RX
+ *     channel paced by DREQ 7. Each entry starts with the length word the
+ *     BCM2835 takes through the FIFO in DMA mode, and ends with chip select
+ *     released by the controller (ADCS). spi_queue_poll() starts the next
+ *     entry as soon as the previous one drains, so a queue runs back to back
+ *     with only a FIFO write and two channel starts between messages.
+ *
+ * spi_ctx_set_dma() lets spi_ctx_transfer() pick the path by length.
+ *
+ * spi_sim_t models the SPI0 registers, FIFOs and shifter in virtual time
+ * for host tests: CPU register accesses go through the model (each one
+ * costs SPI_SIM_ACCESS_NS), and spi_sim_device() exposes the FIFO and both
+ * DREQs to the rpi_dma.h simulator. A slave callback (or loopback) answers
+ * every byte.
+ */
+
+#ifndef RPI_SPI_H
+#define RPI_SPI_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** TX and RX FIFO depth in bytes. */
+#define SPI_FIFO_BYTES 64
+
+/** Longest DMA transfer: DLEN is 16 bits and each control block moves whole words. */
+#define SPI_DMA_MAX_LEN 65532
+
+/** Default spi_ctx_transfer() length from which DMA is used. */
+#define SPI_DMA_MIN_DEFAULT 96
+
+/** Core clock that feeds the SPI divider (BCM2711 default; 250 MHz on Pi 3). */
+#ifndef SPI_CORE_HZ
+#define SPI_CORE_HZ 500000000u
+#endif
+
+/** Byte clocked out when a transfer has no TX buffer. */
+#ifndef SPI_FILL
+#define SPI_FILL 0x00
+#endif
+
+/** Give up on a transfer that has not completed after this long. */
+#define SPI_TIMEOUT_MS 1000
+
+/** @name SPI0 Pins (ALT0) */
+/**@{*/
+#define SPI0_PIN_CE1  7
+#define SPI0_PIN_CE0  8
+#define SPI0_PIN_MISO 9
+#define SPI0_PIN_MOSI 10
+#define SPI0_PIN_SCLK 11
+/**@}*/
+
+typedef struct spi_queue spi_queue_t;
+typedef struct spi_sim spi_sim_t;
+
+/**
+ * @brief SPI0 controller.
+ */
+typedef struct {
+    volatile uint32_t* regs;  /**< SPI0 register block. */
+    gpio_ctx_t* gpio;
+    spi_sim_t* sim;           /**< Register accesses go through this model (spi_sim_attach()). */
+    int mapped;               /**< 1 if the block comes from the rpi_periph.h registry. */
+    uint32_t mode_bits;       /**< CPOL/CPHA as written to the CS register. */
+    uint32_t clock_hz;        /**< SCLK after divider rounding. */
+    spi_queue_t* dma;         /**< Queue used for large transfers (NULL = polled only). */
+    size_t dma_min;           /**< Shortest transfer sent through dma. */
+    uint64_t transfers;       /**< Completed transfers, both paths. */
+    uint64_t bytes;
+    uint64_t dma_transfers;   /**< Of which through DMA. */
+    uint64_t timeouts;
+} spi_ctx_t;
+
+/** @name Context API */
+/**@{*/
+
+/**
+ * @brief Map SPI0 (rpi_periph.h), mux GPIO 7-11 to ALT0 and reset the block.
+ *
+ * The bus starts in mode 0 at 1 MHz.
+ *
+ * @param gpio GPIO context for pin muxing (NULL for gpio_ctx_default).
+ * @return 0 on success, -1 on error (always on non-Pi hosts unless
+ *         periph_set_io() supplies fake blocks).
+ */
+int spi_ctx_init(spi_ctx_t* ctx, gpio_ctx_t* gpio);
+
+/**
+ * @brief Use an existing register block and reset it. Pins are not touched.
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int spi_ctx_attach(spi_ctx_t* ctx, volatile uint32_t* regs, gpio_ctx_t* gpio);
+
+/**
+ * @brief Idle the controller and release the block taken by spi_ctx_init().
+ */
+void spi_ctx_close(spi_ctx_t* ctx);
+
+/**
+ * @brief Set SCLK. The divider is even, from 2 to 65536.
+ * @return The frequency actually used (at most hz), 0 on error.
+ */
+uint32_t spi_ctx_set_clock(spi_ctx_t* ctx, uint32_t hz);
+
+/**
+ * @brief Set the SPI mode (0-3: CPOL = bit 1, CPHA = bit 0).
+ * @return 0 on success, -1 on error.
+ */
+int spi_ctx_set_mode(spi_ctx_t* ctx, int mode);
+
+/**
+ * @brief Send transfers of at least min_len bytes through a queue.
+ *
+ * spi_ctx_transfer() clears the queue before each use, so it must not hold
+ * entries of its own. Transfers that do not fit the queue stay polled.
+ *
+ * @param queue Open queue, or NULL to poll everything.
+ * @param min_len 0 for SPI_DMA_MIN_DEFAULT.
+ */
+void spi_ctx_set_dma(spi_ctx_t* ctx, spi_queue_t* queue, size_t min_len);
+
+/**
+ * @brief Full-duplex transfer with CS held active throughout. Blocking.
+ *
+ * @param cs Chip select 0-2 (active low).
+ * @param tx Bytes to send (NULL sends SPI_FILL).
+ * @param rx Received bytes (NULL discards them).
+ * @return 0 on success, -1 on invalid arguments or timeout.
+ */
+int spi_ctx_transfer(spi_ctx_t* ctx, int cs, const uint8_t* tx, uint8_t* rx, size_t len);
+/**@}*/
+
+/** @name DMA Transfer Queue */
+/**@{*/
+
+/**
+ * @brief One queued transfer.
+ */
+typedef struct {
+    int cs;
+    size_t len;
+    dma_cb_t* tx_cb;
+    dma_cb_t* rx_cb;
+    uint8_t* rx;              /**< Received bytes, in DMA memory. */
+} spi_queue_entry_t;
+
+/**
+ * @brief Prebuilt DMA transfers run back to back.
+ */
+struct spi_queue {
+    spi_ctx_t* ctx;
+    dma_chan_t* tx_dma;
+    dma_chan_t* rx_dma;
+    dma_mem_t mem;            /**< Control blocks, then TX words, then RX words. */
+    uint8_t* tx_buf;
+    uint8_t* rx_buf;
+    size_t buf_size;          /**< Bytes in each of tx_buf and rx_buf. */
+    size_t buf_used;
+    spi_queue_entry_t* entries;
+    int max_entries;
+    int count;
+    int current;              /**< Entry on the wire, or count when idle. */
+    int done;                 /**< Entries of this run already complete. */
+    uint64_t completed;       /**< Entries finished since spi_queue_open(). */
+};
+
+/**
+ * @brief Allocate DMA memory and control blocks for a queue.
+ * @param ctx Controller (its block must be SPI0 or a simulated SPI0).
+ * @param tx_dma, rx_dma Two distinct open channels.
+ * @param max_entries Transfers per run.
+ * @param max_bytes Total payload per run.
+ * @return 0 on success, -1 on error.
+ */
+int spi_queue_open(spi_queue_t* q, spi_ctx_t* ctx, dma_chan_t* tx_dma, dma_chan_t* rx_dma,
+                   int max_entries, size_t max_bytes);
+
+/**
+ * @brief Append a transfer; copies tx into DMA memory.
+ * @param tx Bytes to send (NULL sends SPI_FILL).
+ * @return Entry index, or -1 if the queue is running, full, or len is 0 or
+ *         above SPI_DMA_MAX_LEN.
+ */
+int spi_queue_add(spi_queue_t* q, int cs, const uint8_t* tx, size_t len);
+
+/**
+ * @brief Start the queued transfers. Non-blocking.
+ * @return 0 on success, -1 if already running or empty.
+ */
+int spi_queue_start(spi_queue_t* q);
+
+/**
+ * @brief Start the next entry when the current one has drained.
+ * @return Entries not yet complete (0 when the run is over).
+ */
+int spi_queue_poll(spi_queue_t* q);
+
+/**
+ * @brief Poll until the run completes (drives the simulator when attached).
+ * @return 0 on success, -1 on timeout (the run is aborted).
+ */
+int spi_queue_wait(spi_queue_t* q);
+
+/**
+ * @brief Received bytes of a completed entry, in place in DMA memory.
+ * @param len Output: entry length (may be NULL).
+ * @return Pointer valid until spi_queue_clear(), NULL if not complete.
+ */
+const uint8_t* spi_queue_rx(const spi_queue_t* q, int index, size_t* len);
+
+/**
+ * @brief Drop all entries (aborting a running queue).
+ */
+void spi_queue_clear(spi_queue_t* q);
+
+/**
+ * @brief Stop DMA and free the queue memory.
+ */
+void spi_queue_close(spi_queue_t* q);
+/**@}*/
+
+/** @name Simulated SPI0 Block */
+/**@{*/
+
+/** Virtual time charged per CPU register access. */
+#define SPI_SIM_ACCESS_NS 50
+
+/**
+ * @brief Byte seen on the simulated bus.
+ */
+typedef struct {
+    uint64_t t_ns;            /**< End of the byte. */
+    uint8_t cs;
+    uint8_t mosi;
+    uint8_t miso;
+} spi_sim_byte_t;
+
+/**
+ * @brief SPI0 registers, FIFOs and shifter.
+ *
+ * FIFO entries are one byte in polled mode and one word (up to four bytes,
+ * first byte in bits 7:0) in DMA mode; a DMA transfer's last word is
+ * partial on both sides. TX DREQ is raised while a transfer is active and
+ * the TX FIFO is at or below DC.TDREQ bytes; RX DREQ while the RX FIFO is
+ * above DC.RDREQ bytes, or holds anything once the transfer has finished.
+ * A byte takes 8 * CDIV core clocks and starts as soon as the previous one
+ * ends, if the TX FIFO has data and the RX FIFO has room.
+ */
+struct spi_sim {
+    uint32_t regs[PERIPH_BLOCK_SIZE / 4];  /**< Stored register values (status bits are computed). */
+    uint32_t tx[SPI_FIFO_BYTES];
+    uint8_t tx_n[SPI_FIFO_BYTES];          /**< Bytes per TX entry. */
+    int tx_head, tx_count, tx_bytes;
+    int tx_pos;                            /**< Bytes already shifted from the head entry. */
+    uint32_t rx[SPI_FIFO_BYTES];
+    uint8_t rx_n[SPI_FIFO_BYTES];
+    int rx_head, rx_count, rx_bytes;
+    uint32_t rx_word;                      /**< DMA mode: word being assembled. */
+    int rx_pos;
+    int shifting;                          /**< A byte is on the wire. */
+    uint8_t shift_mosi;
+    double next_ns;                        /**< End of the byte on the wire. */
+    double free_ns;                        /**< End of the last byte. */
+    uint64_t now_ns;                       /**< Virtual time. */
+    uint32_t access_ns;                    /**< SPI_SIM_ACCESS_NS. */
+    double core_hz;                        /**< SPI_CORE_HZ. */
+    uint8_t (*slave)(void* user, int cs, uint8_t mosi);  /**< NULL = MOSI looped to MISO. */
+    void* user;
+    dma_sim_t* dma;                        /**< Set by spi_sim_attach(). */
+    spi_sim_byte_t* log;
+    size_t log_cap;
+    size_t log_len;
+    uint64_t bytes;                        /**< Bytes shifted. */
+    uint64_t transfers;                    /**< DMA-mode length words accepted. */
+    uint64_t accesses;                     /**< CPU register accesses. */
+    uint64_t overflows;                    /**< Writes to a full TX FIFO. */
+};
+
+/**
+ * @brief Reset the model (registers at their reset values).
+ * @param slave Answers each byte, NULL for loopback.
+ * @param log Buffer for bus bytes (may be NULL).
+ */
+void spi_sim_init(spi_sim_t* sim, uint8_t (*slave)(void* user, int cs, uint8_t mosi), void* user,
+                  spi_sim_byte_t* log, size_t log_cap);
+
+/**
+ * @brief Describe the model as a PERIPH_SPI0 device for dma_sim_add_device().
+ */
+void spi_sim_device(spi_sim_t* sim, dma_sim_dev_t* dev);
+
+/**
+ * @brief Attach a context to the model and, if dma is given, register the
+ *        device with it so queues can run on channels attached to dma->regs.
+ * @return 0 on success, -1 on error.
+ */
+int spi_sim_attach(spi_sim_t* sim, spi_ctx_t* ctx, dma_sim_t* dma);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_SPI_H */
+
+#ifdef RPI_SPI_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** @name Register Offsets */
+/**@{*/
+#define SPI_CS   0
+#define SPI_FIFO 1
+#define SPI_CLK  2
+#define SPI_DLEN 3
+#define SPI_LTOH 4
+#define SPI_DC   5
+/**@}*/
+
+/** @name CS Register Bits */
+/**@{*/
+#define SPI_CS_CS(x)     ((uint32_t)(x) & 3)
+#define SPI_CS_CPHA      (1u << 2)
+#define SPI_CS_CPOL      (1u << 3)
+#define SPI_CS_CLEAR_TX  (1u << 4)   /**< Write only */
+#define SPI_CS_CLEAR_RX  (1u << 5)   /**< Write only */
+#define SPI_CS_TA        (1u << 7)   /**< Transfer active */
+#define SPI_CS_DMAEN     (1u << 8)
+#define SPI_CS_ADCS      (1u << 11)  /**< Release CS when a DMA transfer ends */
+#define SPI_CS_DONE      (1u << 16)
+#define SPI_CS_RXD       (1u << 17)  /**< RX FIFO not empty */
+#define SPI_CS_TXD       (1u << 18)  /**< TX FIFO has room */
+#define SPI_CS_RXR       (1u << 19)  /**< RX FIFO at least 3/4 full */
+#define SPI_CS_RXF       (1u << 20)  /**< RX FIFO full */
+#define SPI_CS_STATUS    (SPI_CS_DONE | SPI_CS_RXD | SPI_CS_TXD | SPI_CS_RXR | SPI_CS_RXF)
+/**@}*/
+
+/** @name DMA Thresholds (reset values, in bytes) */
+/**@{*/
+#define SPI_DC_TDREQ(x)  ((uint32_t)(x))
+#define SPI_DC_TPANIC(x) ((uint32_t)(x) << 8)
+#define SPI_DC_RDREQ(x)  ((uint32_t)(x) << 16)
+#define SPI_DC_RPANIC(x) ((uint32_t)(x) << 24)
+#define SPI_DC_DEFAULT   (SPI_DC_TDREQ(0x20) | SPI_DC_TPANIC(0x10) | SPI_DC_RDREQ(0x20) | SPI_DC_RPANIC(0x30))
+/**@}*/
+
+/** Bytes read without status checks while RXR is set. */
+#define SPI_RXR_BYTES (SPI_FIFO_BYTES * 3 / 4)
+
+/** Virtual time the simulator runs per polling step while waiting on DMA. */
+#define SPI_SIM_WAIT_NS 1000
+
+static uint32_t spi_sim_cpu_read(spi_sim_t* sim, uint32_t reg);
+static void spi_sim_cpu_write(spi_sim_t* sim, uint32_t reg, uint32_t value);
+
+static inline uint32_t spi_rd(const spi_ctx_t* ctx, uint32_t reg) {
+    return ctx->sim ? spi_sim_cpu_read(ctx->sim, reg) : ctx->regs[reg];
+}
+
+static inline void spi_wr(const spi_ctx_t* ctx, uint32_t reg, uint32_t value) {
+    if (ctx->sim) spi_sim_cpu_write(ctx->sim, reg, value);
+    else ctx->regs[reg] = value;
+}
+
+/** Virtual time on the simulator, CLOCK_MONOTONIC otherwise. */
+static uint64_t spi_now_ns(const spi_ctx_t* ctx) {
+    if (ctx->sim) return ctx->sim->now_ns;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* ============================================================================
+ * CONTEXT
+ * ============================================================================ */
+
+static void spi_reset(spi_ctx_t* ctx) {
+    spi_wr(ctx, SPI_CS, SPI_CS_CLEAR_TX | SPI_CS_CLEAR_RX);
+    spi_wr(ctx, SPI_DLEN, 0);
+    spi_wr(ctx, SPI_DC, SPI_DC_DEFAULT);
+}
+
+int spi_ctx_attach(spi_ctx_t* ctx, volatile uint32_t* regs, gpio_ctx_t* gpio) {
+    if (!ctx || !regs) return -1;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->regs = regs;
+    ctx->gpio = gpio ? gpio : &gpio_ctx_default;
+    ctx->dma_min = SPI_DMA_MIN_DEFAULT;
+    spi_reset(ctx);
+    spi_ctx_set_clock(ctx, 1000000);
+    return 0;
+}
+
+int spi_ctx_init(spi_ctx_t* ctx, gpio_ctx_t* gpio) {
+    if (!ctx) return -1;
+
+    volatile uint32_t* regs = periph_map(PERIPH_SPI0);
+    if (!regs) return -1;
+
+    spi_ctx_attach(ctx, regs, gpio);
+    ctx->mapped = 1;
+    static const int pins[] = { SPI0_PIN_CE1, SPI0_PIN_CE0, SPI0_PIN_MISO, SPI0_PIN_MOSI, SPI0_PIN_SCLK };
+    for (size_t i = 0; i < sizeof(pins) / sizeof(pins[0]); i++) {
+        gpio_ctx_set_function(ctx->gpio, pins[i], ALT0);
+    }
+    return 0;
+}
+
+void spi_ctx_close(spi_ctx_t* ctx) {
+    if (!ctx || !ctx->regs) return;
+    spi_reset(ctx);
+    if (ctx->mapped) {
+        periph_unmap(PERIPH_SPI0);
+        ctx->mapped = 0;
+    }
+    ctx->regs = NULL;
+    ctx->sim = NULL;
+    ctx->dma = NULL;
+}
+
+uint32_t spi_ctx_set_clock(spi_ctx_t* ctx, uint32_t hz) {
+    if (!ctx || !ctx->regs || hz == 0) return 0;
+    uint64_t cdiv = ((uint64_t)SPI_CORE_HZ + hz - 1) / hz;
+    cdiv += cdiv & 1;
+    if (cdiv < 2) cdiv = 2;
+    if (cdiv > 65536) cdiv = 65536;
+    spi_wr(ctx, SPI_CLK, (uint32_t)(cdiv & 0xFFFF));  /* 0 encodes 65536 */
+    ctx->clock_hz = (uint32_t)(SPI_CORE_HZ / cdiv);
+    return ctx->clock_hz;
+}
+
+int spi_ctx_set_mode(spi_ctx_t* ctx, int mode) {
+    if (!ctx || mode < 0 || mode > 3) return -1;
+    ctx->mode_bits = ((mode & 2) ? SPI_CS_CPOL : 0) | ((mode & 1) ? SPI_CS_CPHA : 0);
+    return 0;
+}
+
+void spi_ctx_set_dma(spi_ctx_t* ctx, spi_queue_t* queue, size_t min_len) {
+    if (!ctx) return;
+    ctx->dma = queue;
+    ctx->dma_min = min_len ? min_len : SPI_DMA_MIN_DEFAULT;
+}
+
+/** Spin until the shifter is idle; returns 0, or -1 after SPI_TIMEOUT_MS. */
+static int spi_wait_done(spi_ctx_t* ctx, uint64_t start_ns) {
+    while (!(spi_rd(ctx, SPI_CS) & SPI_CS_DONE)) {
+        if (spi_now_ns(ctx) - start_ns > SPI_TIMEOUT_MS * 1000000ull) return -1;
+    }
+    return 0;
+}
+
+static int spi_poll_transfer(spi_ctx_t* ctx, int cs, const uint8_t* tx, uint8_t* rx, size_t len) {
+    uint64_t start = spi_now_ns(ctx);
+    spi_wr(ctx, SPI_CS, ctx->mode_bits | SPI_CS_CS(cs) | SPI_CS_CLEAR_TX | SPI_CS_CLEAR_RX | SPI_CS_TA);
+
+    /*
+     * With at most a FIFO's worth in flight neither FIFO can overflow, so
+     * TX is refilled without reading TXD and RX drained blind while RXR
+     * says a burst is there.
+     */
+    size_t t = 0, r = 0;
+    while (r < len) {
+        while (t < len && t - r < SPI_FIFO_BYTES) {
+            spi_wr(ctx, SPI_FIFO, tx ? tx[t] : SPI_FILL);
+            t++;
+        }
+        uint32_t status = spi_rd(ctx, SPI_CS);
+        if (status & SPI_CS_RXR) {
+            size_t burst = t - r < SPI_RXR_BYTES ? t - r : SPI_RXR_BYTES;
+            for (size_t i = 0; i < burst; i++, r++) {
+                uint8_t b = (uint8_t)spi_rd(ctx, SPI_FIFO);
+                if (rx) rx[r] = b;
+            }
+        } else if (status & SPI_CS_RXD) {
+            do {
+                uint8_t b = (uint8_t)spi_rd(ctx, SPI_FIFO);
+                if (rx) rx[r] = b;
+                r++;
+            } while (r < t && (spi_rd(ctx, SPI_CS) & SPI_CS_RXD));
+        } else if (spi_now_ns(ctx) - start > SPI_TIMEOUT_MS * 1000000ull) {
+            break;
+        }
+    }
+
+    int rc = r == len ? spi_wait_done(ctx, start) : -1;
+    spi_wr(ctx, SPI_CS, ctx->mode_bits | SPI_CS_CLEAR_TX | SPI_CS_CLEAR_RX);
+    return rc;
+}
+
+int spi_ctx_transfer(spi_ctx_t* ctx, int cs, const uint8_t* tx, uint8_t* rx, size_t len) {
+    if (!ctx || !ctx->regs || cs < 0 || cs > 2) return -1;
+    if (len == 0) return 0;
+
+    spi_queue_t* q = ctx->dma;
+    int rc = -1, dma = 0;
+    if (q && len >= ctx->dma_min && q->current >= q->count) {
+        spi_queue_clear(q);
+        if (spi_queue_add(q, cs, tx, len) == 0) {
+            dma = 1;
+            spi_queue_start(q);
+            rc = spi_queue_wait(q);
+            if (rc == 0 && rx) memcpy(rx, q->entries[0].rx, len);
+            spi_queue_clear(q);
+        }
+    }
+    if (!dma) rc = spi_poll_transfer(ctx, cs, tx, rx, len);
+
+    if (rc != 0) {
+        ctx->timeouts++;
+        fprintf(stderr, "SPI Error: Transfer of %zu bytes timed out\n", len);
+        return -1;
+    }
+    ctx->transfers++;
+    ctx->bytes += len;
+    ctx->dma_transfers += (uint64_t)dma;
+    return 0;
+}
+
+/* ============================================================================
+ * DMA QUEUE
+ * ============================================================================ */
+
+int spi_queue_open(spi_queue_t* q, spi_ctx_t* ctx, dma_chan_t* tx_dma, dma_chan_t* rx_dma,
+                   int max_entries, size_t max_bytes) {
+    if (!q || !ctx || !ctx->regs || !tx_dma || !rx_dma || !tx_dma->regs || !rx_dma->regs) return -1;
+    if (tx_dma == rx_dma || max_entries <= 0 || max_bytes == 0) return -1;
+
+    memset(q, 0, sizeof(*q));
+    q->entries = (spi_queue_entry_t*)calloc((size_t)max_entries, sizeof(spi_queue_entry_t));
+    if (!q->entries) return -1;
+
+    /* Each entry may waste up to 3 bytes of padding on either side */
+    q->buf_size = (max_bytes + 3 * (size_t)max_entries + 3) & ~(size_t)3;
+    size_t cb_bytes = 2 * (size_t)max_entries * sizeof(dma_cb_t);
+    if (dma_mem_alloc(&q->mem, cb_bytes + 2 * q->buf_size) != 0) {
+        free(q->entries);
+        q->entries = NULL;
+        return -1;
+    }
+    q->tx_buf = (uint8_t*)q->mem.virt + cb_bytes;
+    q->rx_buf = q->tx_buf + q->buf_size;
+    q->ctx = ctx;
+    q->tx_dma = tx_dma;
+    q->rx_dma = rx_dma;
+    q->max_entries = max_entries;
+    return 0;
+}
+
+int spi_queue_add(spi_queue_t* q, int cs, const uint8_t* tx, size_t len) {
+    if (!q || !q->entries || q->current < q->count) return -1;
+    if (cs < 0 || cs > 2 || len == 0 || len > SPI_DMA_MAX_LEN || q->count >= q->max_entries) return -1;
+    size_t padded = (len + 3) & ~(size_t)3;
+    if (q->buf_used + padded > q->buf_size) return -1;
+
+    uint8_t* txp = q->tx_buf + q->buf_used;
+    if (tx) memcpy(txp, tx, len);
+    else memset(txp, SPI_FILL, len);
+    memset(txp + len, 0, padded - len);
+
+    int i = q->count;
+    spi_queue_entry_t* e = &q->entries[i];
+    dma_cb_t* cbs = (dma_cb_t*)q->mem.virt;
+    e->cs = cs;
+    e->len = len;
+    e->tx_cb = &cbs[2 * i];
+    e->rx_cb = &cbs[2 * i + 1];
+    e->rx = q->rx_buf + q->buf_used;
+
+    e->tx_cb->ti = DMA_TI_NO_WIDE_BURSTS | DMA_TI_WAIT_RESP | DMA_TI_DEST_DREQ |
+                   DMA_TI_PERMAP(DMA_DREQ_SPI_TX) | DMA_TI_SRC_INC;
+    e->tx_cb->source_ad = dma_mem_bus(&q->mem, txp);
+    e->tx_cb->dest_ad = dma_periph_bus(PERIPH_SPI0, SPI_FIFO);
+    e->tx_cb->txfr_len = (uint32_t)padded;
+    e->tx_cb->nextconbk = 0;
+
+    e->rx_cb->ti = DMA_TI_NO_WIDE_BURSTS | DMA_TI_SRC_DREQ |
+                   DMA_TI_PERMAP(DMA_DREQ_SPI_RX) | DMA_TI_DEST_INC;
+    e->rx_cb->source_ad = dma_periph_bus(PERIPH_SPI0, SPI_FIFO);
+    e->rx_cb->dest_ad = dma_mem_bus(&q->mem, e->rx);
+    e->rx_cb->txfr_len = (uint32_t)padded;
+    e->rx_cb->nextconbk = 0;
+
+    q->buf_used += padded;
+    q->count++;
+    q->current = q->count;
+    return i;
+}
+
+/** Put entry i on the wire: length word through the FIFO, then both channels. */
+static void spi_queue_kick(spi_queue_t* q, int i) {
+    spi_ctx_t* ctx = q->ctx;
+    const spi_queue_entry_t* e = &q->entries[i];
+    uint32_t cs = ctx->mode_bits | SPI_CS_DMAEN | SPI_CS_ADCS;
+    spi_wr(ctx, SPI_CS, cs | SPI_CS_CLEAR_TX | SPI_CS_CLEAR_RX);
+    spi_wr(ctx, SPI_FIFO, ((uint32_t)e->len << 16) | ((cs | SPI_CS_CS(e->cs) | SPI_CS_TA) & 0xFF));
+    dma_chan_start(q->rx_dma, dma_mem_bus(&q->mem, e->rx_cb));
+    dma_chan_start(q->tx_dma, dma_mem_bus(&q->mem, e->tx_cb));
+}
+
+int spi_queue_start(spi_queue_t* q) {
+    if (!q || !q->entries || q->count == 0 || q->current < q->count) return -1;
+    q->current = 0;
+    q->done = 0;
+    spi_queue_kick(q, 0);
+    return 0;
+}
+
+int spi_queue_poll(spi_queue_t* q) {
+    if (!q || !q->entries) return 0;
+    while (q->current < q->count) {
+        if (dma_chan_active(q->rx_dma) || dma_chan_active(q->tx_dma)) return q->count - q->current;
+        q->completed++;
+        q->done++;
+        if (++q->current < q->count) {
+            spi_queue_kick(q, q->current);
+        } else {
+            spi_wr(q->ctx, SPI_CS, q->ctx->mode_bits | SPI_CS_CLEAR_TX | SPI_CS_CLEAR_RX);
+        }
+    }
+    return 0;
+}
+
+int spi_queue_wait(spi_queue_t* q) {
+    if (!q || !q->entries) return -1;
+    spi_ctx_t* ctx = q->ctx;
+    if (ctx->sim && !ctx->sim->dma) {
+        spi_queue_clear(q);  /* Nothing would advance virtual time */
+        return -1;
+    }
+    uint64_t start = spi_now_ns(ctx);
+    while (spi_queue_poll(q)) {
+        if (ctx->sim && ctx->sim->dma) dma_sim_run(ctx->sim->dma, SPI_SIM_WAIT_NS);
+        if (spi_now_ns(ctx) - start > SPI_TIMEOUT_MS * 1000000ull) {
+            spi_queue_clear(q);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+const uint8_t* spi_queue_rx(const spi_queue_t* q, int index, size_t* len) {
+    if (!q || !q->entries || index < 0 || index >= q->count) return NULL;
+    if (index >= q->done) return NULL;
+    if (len) *len = q->entries[index].len;
+    return q->entries[index].rx;
+}
+
+void spi_queue_clear(spi_queue_t* q) {
+    if (!q || !q->entries) return;
+    if (q->current < q->count) {
+        dma_chan_stop(q->tx_dma);
+        dma_chan_stop(q->rx_dma);
+        spi_wr(q->ctx, SPI_CS, q->ctx->mode_bits | SPI_CS_CLEAR_TX | SPI_CS_CLEAR_RX);
+    }
+    q->count = 0;
+    q->current = 0;
+    q->done = 0;
+    q->buf_used = 0;
+}
+
+void spi_queue_close(spi_queue_t* q) {
+    if (!q || !q->entries) return;
+    spi_queue_clear(q);
+    if (q->ctx && q->ctx->dma == q) q->ctx->dma = NULL;
+    dma_mem_free(&q->mem);
+    free(q->entries);
+    q->entries = NULL;
+}
+
+/* ============================================================================
+ * SIMULATOR
+ * ============================================================================ */
+
+static double spi_sim_byte_ns(const spi_sim_t* sim) {
+    uint32_t cdiv = sim->regs[SPI_CLK] & 0xFFFF;
+    if (cdiv == 0) cdiv = 65536;
+    return 8.0 * cdiv * 1e9 / sim->core_hz;
+}
+
+static int spi_sim_dma_mode(const spi_sim_t* sim) {
+    return (sim->regs[SPI_CS] & SPI_CS_DMAEN) != 0;
+}
+
+static void spi_sim_rx_push(spi_sim_t* sim, uint32_t word, int n) {
+    int tail = (sim->rx_head + sim->rx_count) % SPI_FIFO_BYTES;
+    sim->rx[tail] = word;
+    sim->rx_n[tail] = (uint8_t)n;
+    sim->rx_count++;
+    sim->rx_bytes += n;
+}
+
+static void spi_sim_tx_pop(spi_sim_t* sim) {
+    sim->tx_bytes -= sim->tx_n[sim->tx_head];
+    sim->tx_head = (sim->tx_head + 1) % SPI_FIFO_BYTES;
+    sim->tx_count--;
+    sim->tx_pos = 0;
+}
+
+/** A DMA transfer has shifted its last byte. */
+static void spi_sim_end_dma(spi_sim_t* sim) {
+    if (sim->rx_pos) {
+        spi_sim_rx_push(sim, sim->rx_word, sim->rx_pos);
+        sim->rx_word = 0;
+        sim->rx_pos = 0;
+    }
+    if (sim->tx_pos) spi_sim_tx_pop(sim);  /* Padding of the last word */
+    if (sim->regs[SPI_CS] & SPI_CS_ADCS) sim->regs[SPI_CS] &= ~SPI_CS_TA;
+}
+
+/** Run the shifter up to now; returns the next event time. */
+static uint64_t spi_sim_run(spi_sim_t* sim) {
+    double now = (double)sim->now_ns;
+    for (;;) {
+        int chained = 0;
+        if (sim->shifting) {
+            if (sim->next_ns > now) return (uint64_t)sim->next_ns + 1;
+
+            int cs = (int)SPI_CS_CS(sim->regs[SPI_CS]);
+            uint8_t miso = sim->slave ? sim->slave(sim->user, cs, sim->shift_mosi) : sim->shift_mosi;
+            if (sim->log && sim->log_len < sim->log_cap) {
+                spi_sim_byte_t* b = &sim->log[sim->log_len++];
+                b->t_ns = (uint64_t)sim->next_ns;
+                b->cs = (uint8_t)cs;
+                b->mosi = sim->shift_mosi;
+                b->miso = miso;
+            }
+            sim->shifting = 0;
+            sim->free_ns = sim->next_ns;
+            sim->bytes++;
+            chained = 1;
+
+            if (spi_sim_dma_mode(sim)) {
+                sim->rx_word |= (uint32_t)miso << (8 * sim->rx_pos);
+                if (++sim->rx_pos == 4) {
+                    spi_sim_rx_push(sim, sim->rx_word, 4);
+                    sim->rx_word = 0;
+                    sim->rx_pos = 0;
+                }
+                if (sim->regs[SPI_DLEN] > 0 && --sim->regs[SPI_DLEN] == 0) spi_sim_end_dma(sim);
+            } else {
+                spi_sim_rx_push(sim, miso, 1);
+            }
+        }
+
+        uint32_t cs = sim->regs[SPI_CS];
+        int dma = spi_sim_dma_mode(sim);
+        if (!(cs & SPI_CS_TA) || sim->tx_count == 0) return UINT64_MAX;
+        if (dma && sim->regs[SPI_DLEN] == 0) return UINT64_MAX;
+        if (sim->rx_bytes + sim->rx_pos >= SPI_FIFO_BYTES || sim->rx_count == SPI_FIFO_BYTES) return UINT64_MAX;
+
+        sim->shift_mosi = (uint8_t)(sim->tx[sim->tx_head] >> (8 * sim->tx_pos));
+        if (++sim->tx_pos == sim->tx_n[sim->tx_head]) spi_sim_tx_pop(sim);
+        /* Data waiting when a byte ends follows it without a gap, however late we look */
+        double start = chained || sim->free_ns > now ? sim->free_ns : now;
+        sim->next_ns = start + spi_sim_byte_ns(sim);
+        sim->shifting = 1;
+    }
+}
+
+static uint32_t spi_sim_read(void* user, uint32_t reg) {
+    spi_sim_t* sim = (spi_sim_t*)user;
+    if (reg == SPI_FIFO) {
+        if (sim->rx_count == 0) return 0;
+        uint32_t v = sim->rx[sim->rx_head];
+        sim->rx_bytes -= sim->rx_n[sim->rx_head];
+        sim->rx_head = (sim->rx_head + 1) % SPI_FIFO_BYTES;
+        sim->rx_count--;
+        spi_sim_run(sim);  /* Room may restart a stalled shifter */
+        return v;
+    }
+    if (reg != SPI_CS) return sim->regs[reg];
+
+    uint32_t cs = sim->regs[SPI_CS] & ~SPI_CS_STATUS;
+    int n = spi_sim_dma_mode(sim) ? 4 : 1;
+    int idle = !sim->shifting && (spi_sim_dma_mode(sim) ? sim->regs[SPI_DLEN] == 0 : sim->tx_count == 0);
+    if ((cs & SPI_CS_TA) && idle) cs |= SPI_CS_DONE;
+    if (sim->rx_count) cs |= SPI_CS_RXD;
+    if (sim->tx_bytes + n <= SPI_FIFO_BYTES && sim->tx_count < SPI_FIFO_BYTES) cs |= SPI_CS_TXD;
+    if (sim->rx_bytes >= SPI_RXR_BYTES) cs |= SPI_CS_RXR;
+    if (sim->rx_bytes >= SPI_FIFO_BYTES) cs |= SPI_CS_RXF;
+    return cs;
+}
+
+static void spi_sim_write(void* user, uint32_t reg, uint32_t value) {
+    spi_sim_t* sim = (spi_sim_t*)user;
+    if (reg == SPI_CS) {
+        if (value & SPI_CS_CLEAR_TX) {
+            sim->tx_head = sim->tx_count = sim->tx_bytes = sim->tx_pos = 0;
+        }
+        if (value & SPI_CS_CLEAR_RX) {
+            sim->rx_head = sim->rx_count = sim->rx_bytes = 0;
+            sim->rx_word = 0;
+            sim->rx_pos = 0;
+        }
+        sim->regs[SPI_CS] = value & ~(SPI_CS_CLEAR_TX | SPI_CS_CLEAR_RX | SPI_CS_STATUS);
+        if (!(value & SPI_CS_TA)) sim->shifting = 0;
+    } else if (reg == SPI_FIFO) {
+        uint32_t cs = sim->regs[SPI_CS];
+        if ((cs & SPI_CS_DMAEN) && !(cs & SPI_CS_TA)) {
+            /* DMA mode: the first word of a transfer is DLEN and CS[7:0] */
+            sim->regs[SPI_DLEN] = value >> 16;
+            sim->regs[SPI_CS] = (cs & ~0xFFu) | (value & 0xFF & ~(SPI_CS_CLEAR_TX | SPI_CS_CLEAR_RX));
+            sim->transfers++;
+        } else {
+            int n = (cs & SPI_CS_DMAEN) ? 4 : 1;
+            if (sim->tx_bytes + n > SPI_FIFO_BYTES || sim->tx_count == SPI_FIFO_BYTES) {
+                sim->overflows++;
+                return;
+            }
+            int tail = (sim->tx_head + sim->tx_count) % SPI_FIFO_BYTES;
+            sim->tx[tail] = value;
+            sim->tx_n[tail] = (uint8_t)n;
+            sim->tx_count++;
+            sim->tx_bytes += n;
+        }
+    } else {
+        sim->regs[reg] = value;
+    }
+    spi_sim_run(sim);
+}
+
+static int spi_sim_dreq(void* user, int dreq) {
+    spi_sim_t* sim = (spi_sim_t*)user;
+    uint32_t cs = sim->regs[SPI_CS];
+    uint32_t dc = sim->regs[SPI_DC];
+    if (!(cs & SPI_CS_DMAEN)) return 0;
+    if (dreq == DMA_DREQ_SPI_TX) {
+        return (cs & SPI_CS_TA) && sim->tx_bytes <= (int)(dc & 0xFF) &&
+               sim->tx_bytes + 4 <= SPI_FIFO_BYTES && sim->tx_count < SPI_FIFO_BYTES;
+    }
+    if (sim->rx_count == 0) return 0;
+    int finished = sim->regs[SPI_DLEN] == 0 && !sim->shifting;
+    return finished || sim->rx_bytes > (int)((dc >> 16) & 0xFF);
+}
+
+static uint64_t spi_sim_advance(void* user, uint64_t now_ns) {
+    spi_sim_t* sim = (spi_sim_t*)user;
+    if (now_ns > sim->now_ns) sim->now_ns = now_ns;
+    return spi_sim_run(sim);
+}
+
+/** Catch the DMA simulator up with CPU time spent on register accesses. */
+static void spi_sim_sync(spi_sim_t* sim) {
+    if (sim->dma && sim->dma->now_ns < sim->now_ns) dma_sim_run(sim->dma, sim->now_ns - sim->dma->now_ns);
+}
+
+static uint32_t spi_sim_cpu_read(spi_sim_t* sim, uint32_t reg) {
+    sim->now_ns += sim->access_ns;
+    sim->accesses++;
+    spi_sim_sync(sim);
+    spi_sim_run(sim);
+    return spi_sim_read(sim, reg);
+}
+
+static void spi_sim_cpu_write(spi_sim_t* sim, uint32_t reg, uint32_t value) {
+    sim->now_ns += sim->access_ns;
+    sim->accesses++;
+    spi_sim_sync(sim);
+    spi_sim_run(sim);
+    spi_sim_write(sim, reg, value);
+}
+
+void spi_sim_init(spi_sim_t* sim, uint8_t (*slave)(void* user, int cs, uint8_t mosi), void* user,
+                  spi_sim_byte_t* log, size_t log_cap) {
+    memset(sim, 0, sizeof(*sim));
+    sim->regs[SPI_DC] = SPI_DC_DEFAULT;
+    sim->access_ns = SPI_SIM_ACCESS_NS;
+    sim->core_hz = SPI_CORE_HZ;
+    sim->slave = slave;
+    sim->user = user;
+    sim->log = log;
+    sim->log_cap = log_cap;
+}
+
+void spi_sim_device(spi_sim_t* sim, dma_sim_dev_t* dev) {
+    memset(dev, 0, sizeof(*dev));
+    dev->block = PERIPH_SPI0;
+    dev->regs = sim->regs;
+    dev->dreqs = (1u << DMA_DREQ_SPI_TX) | (1u << DMA_DREQ_SPI_RX);
+    dev->dreq = spi_sim_dreq;
+    dev->write = spi_sim_write;
+    dev->read = spi_sim_read;
+    dev->advance = spi_sim_advance;
+    dev->user = sim;
+}
+
+int spi_sim_attach(spi_sim_t* sim, spi_ctx_t* ctx, dma_sim_t* dma) {
+    if (!sim || !ctx) return -1;
+    if (dma) {
+        dma_sim_dev_t dev;
+        spi_sim_device(sim, &dev);
+        if (dma_sim_add_device(dma, &dev) != 0) return -1;
+        sim->dma = dma;
+    }
+    if (spi_ctx_attach(ctx, sim->regs, NULL) != 0) return -1;
+
+    /* Redo the reset through the model so the FIFOs are cleared too */
+    ctx->sim = sim;
+    spi_reset(ctx);
+    spi_ctx_set_clock(ctx, 1000000);
+    return 0;
+}
+
+#endif /* RPI_SPI_IMPLEMENTATION */
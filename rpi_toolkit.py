@@ -1,7 +1,7 @@
 """Python bindings for rpi-toolkit C library.
 
-Provides access to GPIO, software PWM, hardware PWM, and timer functionality
-for Raspberry Pi 4B via ctypes wrapper around libtoolkit.so.
+Provides access to GPIO, software PWM, hardware PWM, timer and SPI ADC
+sampling functionality for Raspberry Pi 4B via ctypes wrapper around libtoolkit.so.
 
 Usage:
     from rpi_toolkit import gpio_init, pin_mode, digital_write, OUTPUT, HIGH
@@ -27,18 +27,33 @@ __all__ = [
     # Constants
     'INPUT', 'OUTPUT', 'LOW', 'HIGH',
     'ALT0', 'ALT1', 'ALT2', 'ALT3', 'ALT4', 'ALT5',
+    'GPIO_EDGE_NONE', 'GPIO_EDGE_RISING', 'GPIO_EDGE_FALLING', 'GPIO_EDGE_BOTH',
+    'GPIO_EDGE_HIGH', 'GPIO_EDGE_LOW', 'GPIO_EDGE_ASYNC_RISING', 'GPIO_EDGE_ASYNC_FALLING',
+    'GPIO_BACKEND_AUTO', 'GPIO_BACKEND_MMAP', 'GPIO_BACKEND_GPIOCHIP',
+    'GPIO_BACKEND_SIM', 'GPIO_BACKEND_NULL',
+    'ADC_MCP3008', 'ADC_MCP3208', 'ADC_ADS7886',
     # Types
-    'SimpleTimer',
+    'SimpleTimer', 'GpioEvent', 'AdcSample', 'AdcStats',
     # GPIO functions
-    'gpio_init', 'gpio_cleanup', 'pin_mode', 'gpio_set_function',
-    'digital_write', 'digital_read',
+    'gpio_init', 'gpio_init_backend', 'gpio_get_backend', 'gpio_backend_name',
+    'gpio_cleanup', 'pin_mode', 'gpio_set_function',
+    'digital_write', 'digital_read', 'gpio_write_mask',
+    'gpio_read_all', 'gpio_set_edge_detect', 'gpio_edge_status',
+    # GPIO event functions
+    'gpio_event_start', 'gpio_event_stop', 'gpio_event_poll',
+    'gpio_event_read', 'gpio_event_wait', 'gpio_event_dropped',
+    # ADC sampling functions
+    'adc_open', 'adc_open_sim', 'adc_close', 'adc_set_channels',
+    'adc_start', 'adc_stop', 'adc_poll', 'adc_available',
+    'adc_peek', 'adc_release', 'adc_read', 'adc_wait',
+    'adc_stats', 'adc_scan_rate',
     # Timer functions
     'timer_set', 'timer_expired', 'timer_tick',
     'millis', 'micros', 'delay_ms', 'delay_us',
     # Software PWM functions
     'pwm_init', 'pwm_init_freq', 'pwm_write', 'pwm_stop',
     # Hardware PWM functions
-    'hpwm_init', 'hpwm_set', 'hpwm_stop',
+    'hpwm_init', 'hpwm_set', 'hpwm_set_duty', 'hpwm_stop',
     # Real-time functions (optional jitter reduction)
     'set_realtime_priority', 'pin_to_core', 'get_cpu_count',
 ]
@@ -54,6 +69,28 @@ ALT2 = 6
 ALT3 = 7
 ALT4 = 3
 ALT5 = 2
+GPIO_EDGE_NONE = 0
+GPIO_EDGE_RISING = 1 << 0
+GPIO_EDGE_FALLING = 1 << 1
+GPIO_EDGE_HIGH = 1 << 2
+GPIO_EDGE_LOW = 1 << 3
+GPIO_EDGE_ASYNC_RISING = 1 << 4
+GPIO_EDGE_ASYNC_FALLING = 1 << 5
+GPIO_EDGE_BOTH = GPIO_EDGE_RISING | GPIO_EDGE_FALLING
+GPIO_BACKEND_AUTO = 0
+GPIO_BACKEND_MMAP = 1
+GPIO_BACKEND_GPIOCHIP = 2
+GPIO_BACKEND_SIM = 3
+GPIO_BACKEND_NULL = 4
+ADC_MCP3008 = 0
+ADC_MCP3208 = 1
+ADC_ADS7886 = 2
+
+# Upper bound for a single gpio_event_read() batch
+_EVENT_BATCH = 256
+
+# Default batch for adc_read() (512 scans of 8 channels, 64 KB of AdcSample)
+_ADC_BATCH = 4096
 
 # ---------------------------------------------------------------------------
 # Type Definitions
@@ -66,12 +103,60 @@ class SimpleTimer(ctypes.Structure):
         ("interval", ctypes.c_uint64)
     ]
 
+class GpioEvent(ctypes.Structure):
+    """Edge event record matching C gpio_event_t."""
+    _fields_ = [
+        ("timestamp_ns", ctypes.c_uint64),
+        ("pin", ctypes.c_uint8),
+        ("edge", ctypes.c_uint8)
+    ]
+
+    def __repr__(self):
+        return f"GpioEvent(timestamp_ns={self.timestamp_ns}, pin={self.pin}, edge={self.edge})"
+
+class AdcSample(ctypes.Structure):
+    """One conversion matching C adc_sample_t (16 bytes)."""
+    _fields_ = [
+        ("t_ns", ctypes.c_uint64),
+        ("seq", ctypes.c_uint32),
+        ("channel", ctypes.c_uint16),
+        ("value", ctypes.c_uint16)
+    ]
+
+    def __repr__(self):
+        return f"AdcSample(t_ns={self.t_ns}, seq={self.seq}, channel={self.channel}, value={self.value})"
+
+class AdcStats(ctypes.Structure):
+    """Sampling pipeline statistics matching C adc_stats_t."""
+    _fields_ = [
+        ("scans", ctypes.c_uint64),
+        ("samples", ctypes.c_uint64),
+        ("overruns", ctypes.c_uint64),
+        ("missed", ctypes.c_uint64),
+        ("errors", ctypes.c_uint64),
+        ("max_late_ns", ctypes.c_uint64),
+        ("start_ns", ctypes.c_uint64),
+        ("end_ns", ctypes.c_uint64)
+    ]
+
 # Function Signatures
 
 # int gpio_init(void);
 _lib.gpio_init.argtypes = []
 _lib.gpio_init.restype = ctypes.c_int
 
+# int gpio_init_backend(gpio_backend_t backend);
+_lib.gpio_init_backend.argtypes = [ctypes.c_int]
+_lib.gpio_init_backend.restype = ctypes.c_int
+
+# gpio_backend_t gpio_get_backend(void);
+_lib.gpio_get_backend.argtypes = []
+_lib.gpio_get_backend.restype = ctypes.c_int
+
+# const char* gpio_backend_name(gpio_backend_t backend);
+_lib.gpio_backend_name.argtypes = [ctypes.c_int]
+_lib.gpio_backend_name.restype = ctypes.c_char_p
+
 # void gpio_cleanup(void);
 _lib.gpio_cleanup.argtypes = []
 _lib.gpio_cleanup.restype = None
@@ -92,6 +177,104 @@ _lib.digital_write.restype = None
 _lib.digital_read.argtypes = [ctypes.c_int]
 _lib.digital_read.restype = ctypes.c_int
 
+# void gpio_write_mask(uint64_t set_mask, uint64_t clr_mask);
+_lib.gpio_write_mask.argtypes = [ctypes.c_uint64, ctypes.c_uint64]
+_lib.gpio_write_mask.restype = None
+
+# uint64_t gpio_read_all(void);
+_lib.gpio_read_all.argtypes = []
+_lib.gpio_read_all.restype = ctypes.c_uint64
+
+# void gpio_set_edge_detect(int pin, int edges);
+_lib.gpio_set_edge_detect.argtypes = [ctypes.c_int, ctypes.c_int]
+_lib.gpio_set_edge_detect.restype = None
+
+# uint64_t gpio_edge_status(void);
+_lib.gpio_edge_status.argtypes = []
+_lib.gpio_edge_status.restype = ctypes.c_uint64
+
+# int gpio_event_start(uint64_t pin_mask, int edges, int core_id);
+_lib.gpio_event_start.argtypes = [ctypes.c_uint64, ctypes.c_int, ctypes.c_int]
+_lib.gpio_event_start.restype = ctypes.c_int
+
+# void gpio_event_stop(void);
+_lib.gpio_event_stop.argtypes = []
+_lib.gpio_event_stop.restype = None
+
+# int gpio_event_poll(void);
+_lib.gpio_event_poll.argtypes = []
+_lib.gpio_event_poll.restype = ctypes.c_int
+
+# int gpio_event_read(gpio_event_t* events, int max);
+_lib.gpio_event_read.argtypes = [ctypes.POINTER(GpioEvent), ctypes.c_int]
+_lib.gpio_event_read.restype = ctypes.c_int
+
+# int gpio_event_wait(gpio_event_t* events, int max, uint64_t timeout_us);
+_lib.gpio_event_wait.argtypes = [ctypes.POINTER(GpioEvent), ctypes.c_int, ctypes.c_uint64]
+_lib.gpio_event_wait.restype = ctypes.c_int
+
+# uint64_t gpio_event_dropped(void);
+_lib.gpio_event_dropped.argtypes = []
+_lib.gpio_event_dropped.restype = ctypes.c_uint64
+
+# All adc_* calls pass NULL for the adc_t*, selecting adc_default
+
+# int adc_open(adc_t* adc, spi_ctx_t* spi, int cs, adc_chip_t chip, size_t capacity);
+_lib.adc_open.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_size_t]
+_lib.adc_open.restype = ctypes.c_int
+
+# int adc_open_sim(adc_t* adc, adc_chip_t chip, size_t capacity, signal, void* user);
+_lib.adc_open_sim.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_size_t, ctypes.c_void_p, ctypes.c_void_p]
+_lib.adc_open_sim.restype = ctypes.c_int
+
+# void adc_close(adc_t* adc);
+_lib.adc_close.argtypes = [ctypes.c_void_p]
+_lib.adc_close.restype = None
+
+# int adc_set_channels(adc_t* adc, const int* channels, int count);
+_lib.adc_set_channels.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int), ctypes.c_int]
+_lib.adc_set_channels.restype = ctypes.c_int
+
+# size_t adc_poll(adc_t* adc, size_t scans);
+_lib.adc_poll.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+_lib.adc_poll.restype = ctypes.c_size_t
+
+# int adc_start(adc_t* adc, double rate_hz, int core_id);
+_lib.adc_start.argtypes = [ctypes.c_void_p, ctypes.c_double, ctypes.c_int]
+_lib.adc_start.restype = ctypes.c_int
+
+# void adc_stop(adc_t* adc);
+_lib.adc_stop.argtypes = [ctypes.c_void_p]
+_lib.adc_stop.restype = None
+
+# size_t adc_available(adc_t* adc);
+_lib.adc_available.argtypes = [ctypes.c_void_p]
+_lib.adc_available.restype = ctypes.c_size_t
+
+# size_t adc_peek(adc_t* adc, const adc_sample_t** samples);
+_lib.adc_peek.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.POINTER(AdcSample))]
+_lib.adc_peek.restype = ctypes.c_size_t
+
+# void adc_release(adc_t* adc, size_t count);
+_lib.adc_release.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+_lib.adc_release.restype = None
+
+# size_t adc_read(adc_t* adc, adc_sample_t* samples, size_t max);
+_lib.adc_read.argtypes = [ctypes.c_void_p, ctypes.POINTER(AdcSample), ctypes.c_size_t]
+_lib.adc_read.restype = ctypes.c_size_t
+
+# size_t adc_wait(adc_t* adc, size_t min_count, uint64_t timeout_us);
+_lib.adc_wait.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_uint64]
+_lib.adc_wait.restype = ctypes.c_size_t
+
+# void adc_get_stats(adc_t* adc, adc_stats_t* stats);
+_lib.adc_get_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(AdcStats)]
+_lib.adc_get_stats.restype = None
+
+# double adc_scan_rate(adc_t* adc);
+_lib.adc_scan_rate.argtypes = [ctypes.c_void_p]
+_lib.adc_scan_rate.restype = ctypes.c_double
+
 # void timer_set(simple_timer_t* t, uint64_t interval_ms);
 _lib.timer_set.argtypes = [ctypes.POINTER(SimpleTimer), ctypes.c_uint64]
 _lib.timer_set.restype = None
@@ -144,6 +327,10 @@ _lib.hpwm_init.restype = ctypes.c_int
 _lib.hpwm_set.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int]
 _lib.hpwm_set.restype = None
 
+# int hpwm_set_duty(int pin, int duty_per_mille);
+_lib.hpwm_set_duty.argtypes = [ctypes.c_int, ctypes.c_int]
+_lib.hpwm_set_duty.restype = ctypes.c_int
+
 # void hpwm_stop(void);
 _lib.hpwm_stop.argtypes = []
 _lib.hpwm_stop.restype = None
@@ -168,6 +355,20 @@ def gpio_init():
     """Initialize GPIO subsystem. Returns 0 on success, -1 on error."""
     return _lib.gpio_init()
 
+def gpio_init_backend(backend):
+    """Initialize GPIO with an explicit GPIO_BACKEND_* value. Returns 0 or -1."""
+    return _lib.gpio_init_backend(backend)
+
+def gpio_get_backend():
+    """Return the active GPIO_BACKEND_* value."""
+    return _lib.gpio_get_backend()
+
+def gpio_backend_name(backend=None):
+    """Return the name of a backend (default: the active one)."""
+    if backend is None:
+        backend = _lib.gpio_get_backend()
+    return _lib.gpio_backend_name(backend).decode()
+
 def gpio_cleanup():
     """Release GPIO resources."""
     _lib.gpio_cleanup()
@@ -188,6 +389,154 @@ def digital_read(pin):
     """Read digital input. Returns LOW or HIGH."""
     return _lib.digital_read(pin)
 
+def gpio_write_mask(set_mask, clr_mask=0):
+    """Set and clear several pins at once. Bit n selects BCM pin n."""
+    _lib.gpio_write_mask(set_mask, clr_mask)
+
+def gpio_read_all():
+    """Read all pin levels at once. Bit n holds the level of BCM pin n."""
+    return _lib.gpio_read_all()
+
+def gpio_set_edge_detect(pin, edges):
+    """Configure edge/level detection (GPIO_EDGE_* flags) for a pin."""
+    _lib.gpio_set_edge_detect(pin, edges)
+
+def gpio_edge_status():
+    """Read and clear latched edge events. Bit n is set if pin n fired."""
+    return _lib.gpio_edge_status()
+
+# ---------------------------------------------------------------------------
+# GPIO Event Functions
+# ---------------------------------------------------------------------------
+
+def gpio_event_start(pins, edges=GPIO_EDGE_BOTH, core_id=-1):
+    """Enable edge detection on the given pins and start the poller thread.
+
+    Args:
+        pins: Iterable of BCM pin numbers.
+        edges: GPIO_EDGE_* flags applied to every pin.
+        core_id: CPU core for a busy-polling poller, or -1 to sleep between polls.
+
+    Returns: 0 on success, -1 on error
+    """
+    mask = 0
+    for pin in pins:
+        mask |= 1 << pin
+    return _lib.gpio_event_start(mask, edges, core_id)
+
+def gpio_event_stop():
+    """Stop the poller thread and disable edge detection."""
+    _lib.gpio_event_stop()
+
+def gpio_event_poll():
+    """Run one poll iteration on the calling thread. Returns events queued."""
+    return _lib.gpio_event_poll()
+
+def gpio_event_read(max_events=_EVENT_BATCH):
+    """Dequeue pending events without blocking. Returns a list of GpioEvent."""
+    buf = (GpioEvent * max_events)()
+    n = _lib.gpio_event_read(buf, max_events)
+    return list(buf[:n])
+
+def gpio_event_wait(timeout_us, max_events=_EVENT_BATCH):
+    """Dequeue events, waiting up to timeout_us for at least one."""
+    buf = (GpioEvent * max_events)()
+    n = _lib.gpio_event_wait(buf, max_events, timeout_us)
+    return list(buf[:n])
+
+def gpio_event_dropped():
+    """Number of events discarded because the ring was full."""
+    return _lib.gpio_event_dropped()
+
+# ---------------------------------------------------------------------------
+# ADC Sampling Functions
+# ---------------------------------------------------------------------------
+
+def adc_open(chip=ADC_MCP3008, cs=0, capacity=0):
+    """Open SPI0 and a sample ring for a converter on chip select cs.
+
+    Requires root on a Pi. Returns 0 on success, -1 on error.
+    """
+    return _lib.adc_open(None, None, cs, chip, capacity)
+
+def adc_open_sim(chip=ADC_MCP3008, capacity=0):
+    """Open the pipeline on a simulated converter whose input is a ramp per channel.
+
+    Returns 0 on success, -1 on error.
+    """
+    return _lib.adc_open_sim(None, chip, capacity, None, None)
+
+def adc_close():
+    """Stop sampling and release the ring and SPI0."""
+    _lib.adc_close(None)
+
+def adc_set_channels(channels):
+    """Select the channels converted per scan, in order. Returns 0 or -1."""
+    channels = list(channels)
+    arr = (ctypes.c_int * len(channels))(*channels)
+    return _lib.adc_set_channels(None, arr, len(channels))
+
+def adc_start(rate_hz, core_id=-1):
+    """Start the sampler thread at rate_hz scans per second.
+
+    Args:
+        rate_hz: Scans per second; each scan converts every selected channel.
+        core_id: CPU core for a busy-waiting sampler, or -1 to sleep between scans.
+
+    Returns: 0 on success, -1 on error
+    """
+    return _lib.adc_start(None, rate_hz, core_id)
+
+def adc_stop():
+    """Stop the sampler thread. Stored samples stay readable."""
+    _lib.adc_stop(None)
+
+def adc_poll(scans=1):
+    """Run scans back to back on the calling thread. Returns samples stored."""
+    return _lib.adc_poll(None, scans)
+
+def adc_available():
+    """Number of samples waiting in the ring."""
+    return _lib.adc_available(None)
+
+def adc_peek():
+    """Oldest contiguous run of samples, without copying.
+
+    Returns an AdcSample array that views the ring in place; it supports the
+    buffer protocol, so memoryview() and numpy.frombuffer() share the same
+    memory. Call adc_release(len(run)) once done with it; the view must not
+    be used afterwards. An empty array means nothing is waiting.
+    """
+    ptr = ctypes.POINTER(AdcSample)()
+    n = _lib.adc_peek(None, ctypes.byref(ptr))
+    if n == 0:
+        return (AdcSample * 0)()
+    return (AdcSample * n).from_address(ctypes.addressof(ptr.contents))
+
+def adc_release(count):
+    """Hand the oldest count samples back to the sampler."""
+    _lib.adc_release(None, count)
+
+def adc_read(max_samples=_ADC_BATCH):
+    """Copy and release waiting samples. Returns a list of AdcSample."""
+    buf = (AdcSample * max_samples)()
+    n = _lib.adc_read(None, buf, max_samples)
+    return list(buf[:n])
+
+def adc_wait(min_count, timeout_us):
+    """Wait up to timeout_us for at least min_count samples. Returns samples waiting."""
+    return _lib.adc_wait(None, min_count, timeout_us)
+
+def adc_stats():
+    """Snapshot of the pipeline statistics as an AdcStats."""
+    stats = AdcStats()
+    _lib.adc_get_stats(None, ctypes.byref(stats))
+    return stats
+
+def adc_scan_rate():
+    """Achieved scan rate in scans per second (0 before two scans)."""
+    return _lib.adc_scan_rate(None)
+
 # ---------------------------------------------------------------------------
 # Timer Functions
 # ---------------------------------------------------------------------------
@@ -252,6 +601,10 @@ def hpwm_set(pin, freq_hz, duty_per_mille):
     """Set hardware PWM output. Pins: 12, 13 (ALT0), 18, 19 (ALT5). Duty in per-mille (0-1000)."""
     _lib.hpwm_set(pin, freq_hz, duty_per_mille)
 
+def hpwm_set_duty(pin, duty_per_mille):
+    """Change duty only, keeping the frequency from hpwm_set(). Returns 0, or -1 if unconfigured."""
+    return _lib.hpwm_set_duty(pin, duty_per_mille)
+
 def hpwm_stop():
     """Stop hardware PWM and release resources."""
     _lib.hpwm_stop()
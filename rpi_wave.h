@@ -0,0 +1,595 @@
+/**
+ * @file rpi_wave.h
+ * @brief DMA-timed GPIO waveforms for Raspberry Pi 4B.
+ *
+ * Single-header library. Define RPI_WAVE_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h and rpi_hw_pwm.h, with RPI_HW_PWM_IMPLEMENTATION in
+ * the same translation unit (clock planning and register layout), and root
+ * privileges (/dev/mem, mailbox memory).
+ *
+ * A waveform is a list of (set_mask, clr_mask, delay_us) steps. wave_compile()
+ * turns it into a chain of DMA control blocks: GPIO writes go straight to
+ * GPSETn/GPCLRn, and each delay is a transfer of N dummy words into the PWM
+ * or PCM FIFO, paced by that peripheral's DREQ so one word drains per tick.
+ * Once started the waveform plays without the CPU; edges land on tick
+ * boundaries, so the jitter is that of the DMA engine, not the scheduler.
+ *
+ * The pacer peripheral is owned by the engine: the PWM pacer uses PWM
+ * channel 1 without muxing a pin, so hardware PWM is unavailable while it
+ * runs; the PCM pacer leaves PWM free.
+ *
+ * wave_sim_t runs compiled waveforms on the host against simulated PWM, PCM
+ * and GPIO blocks (rpi_dma.h simulator) in virtual time, logging every GPIO
+ * write with its timestamp.
+ */
+
+#ifndef RPI_WAVE_H
+#define RPI_WAVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default pacing resolution. */
+#define WAVE_TICK_NS_DEFAULT 1000
+
+/** Longest delay per control block: lite DMA channels move at most 65535 bytes. */
+#define WAVE_DELAY_MAX_TICKS 16383
+
+/**
+ * @brief Peripheral whose FIFO paces delays.
+ */
+typedef enum {
+    WAVE_PACE_PWM = 0,        /**< PWM FIFO (DREQ 5). */
+    WAVE_PACE_PCM             /**< PCM TX FIFO (DREQ 2). */
+} wave_pacer_t;
+
+/**
+ * @brief One waveform step: drive pins, then wait.
+ */
+typedef struct {
+    uint64_t set_mask;        /**< Pins driven high (bit n = GPIO n). */
+    uint64_t clr_mask;        /**< Pins driven low. */
+    uint32_t delay_us;        /**< Time until the next step. */
+} wave_step_t;
+
+/**
+ * @brief DMA engine and pacer.
+ */
+typedef struct {
+    wave_pacer_t pacer;
+    volatile uint32_t* regs;  /**< PWM or PCM register block. */
+    volatile uint32_t* clk;   /**< Clock manager block. */
+    dma_chan_t* dma;
+    double tick_ns;           /**< Achieved tick (one FIFO word). */
+    int mapped;               /**< 1 if the blocks come from the rpi_periph.h registry. */
+    uint32_t dummy_bus;       /**< Bus address of the pacing word. */
+    dma_mem_t mem;            /**< Holds the pacing word. */
+} wave_engine_t;
+
+/**
+ * @brief Compiled waveform.
+ */
+typedef struct {
+    dma_mem_t mem;            /**< Control blocks followed by GPIO mask words. */
+    dma_cb_t* cbs;
+    int num_cbs;
+    int first_step;           /**< Control block looped back to (after priming). */
+    uint64_t ticks;           /**< Length of one pass in ticks. */
+    double duration_ns;       /**< Length of one pass. */
+} wave_t;
+
+/**
+ * @brief Map the pacer, clock and DMA blocks and start the pacer.
+ * @param tick_ns Pacing resolution (0 for WAVE_TICK_NS_DEFAULT).
+ * @return 0 on success, -1 on error (always on non-Pi hosts unless
+ *         periph_set_io() supplies fake blocks).
+ */
+int wave_engine_init(wave_engine_t* eng, wave_pacer_t pacer, uint32_t tick_ns, dma_chan_t* dma);
+
+/**
+ * @brief Use existing register blocks (e.g. a wave_sim_t) and start the pacer.
+ * @param regs PWM block for WAVE_PACE_PWM, PCM block for WAVE_PACE_PCM.
+ * @return 0 on success, -1 on invalid arguments or a tick the pacer cannot make.
+ */
+int wave_engine_attach(wave_engine_t* eng, wave_pacer_t pacer, uint32_t tick_ns,
+                       volatile uint32_t* regs, volatile uint32_t* clk, dma_chan_t* dma);
+
+/**
+ * @brief Stop DMA and the pacer, release mapped blocks.
+ */
+void wave_engine_close(wave_engine_t* eng);
+
+/**
+ * @brief Compile steps into a control block chain for an engine.
+ *
+ * Delays are rounded to whole ticks; steps with neither pins nor a delay
+ * cost nothing. Pins must already be outputs.
+ *
+ * @return 0 on success, -1 on invalid steps or DMA memory error.
+ */
+int wave_compile(wave_t* wave, const wave_engine_t* eng, const wave_step_t* steps, int count);
+
+/**
+ * @brief Free a compiled waveform (must not be playing).
+ */
+void wave_free(wave_t* wave);
+
+/**
+ * @brief Start a waveform. Non-blocking.
+ * @param loop Repeat until wave_stop() instead of stopping after one pass.
+ * @return 0 on success, -1 if the engine is busy.
+ */
+int wave_play(wave_engine_t* eng, wave_t* wave, int loop);
+
+/**
+ * @brief 1 while a waveform is playing.
+ */
+int wave_busy(const wave_engine_t* eng);
+
+/**
+ * @brief Abort the current waveform; pins keep their last level.
+ */
+void wave_stop(wave_engine_t* eng);
+
+/** @name Simulator */
+/**@{*/
+
+/** PCM TX FIFO depth modelled by wave_sim_t. */
+#define WAVE_PCM_FIFO_DEPTH 64
+
+/**
+ * @brief GPIO write seen by the simulator.
+ */
+typedef struct {
+    uint64_t t_ns;            /**< Virtual time of the write. */
+    uint64_t levels;          /**< Output levels after it. */
+} wave_edge_t;
+
+/**
+ * @brief DMA, PWM, PCM and GPIO blocks in virtual time.
+ */
+typedef struct {
+    dma_sim_t dma;                        /**< DMA engine; channels attach to dma.regs. */
+    hpwm_sim_t pwm;                       /**< PWM block and clock manager. */
+    uint32_t pcm[PERIPH_BLOCK_SIZE / 4];  /**< PCM registers. */
+    int pcm_fifo;                         /**< PCM TX FIFO level (contents are not kept). */
+    double pcm_next_ns;                   /**< Next PCM frame, 0 while idle. */
+    uint32_t gpio[PERIPH_BLOCK_SIZE / 4]; /**< GPIO registers; GPLEVn follows GPSET/GPCLR. */
+    uint64_t levels;
+    gpio_ctx_t* mirror;                   /**< Also apply writes here (NULL = none). */
+    wave_edge_t* log;
+    size_t log_cap;
+    size_t log_len;
+} wave_sim_t;
+
+/**
+ * @brief Reset the simulator and register its devices.
+ * @param log Buffer for GPIO writes that change levels (may be NULL).
+ */
+void wave_sim_init(wave_sim_t* sim, wave_edge_t* log, size_t log_cap);
+
+/**
+ * @brief Attach a DMA channel and an engine to the simulated blocks.
+ * @return wave_engine_attach() result.
+ */
+int wave_sim_engine(wave_sim_t* sim, wave_engine_t* eng, wave_pacer_t pacer,
+                    uint32_t tick_ns, dma_chan_t* dma);
+
+/**
+ * @brief Advance virtual time.
+ * @return DMA words transferred.
+ */
+uint64_t wave_sim_run(wave_sim_t* sim, uint64_t duration_ns);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_WAVE_H */
+
+#ifdef RPI_WAVE_IMPLEMENTATION
+
+#ifndef RPI_HW_PWM_IMPLEMENTATION
+#error "rpi_wave.h needs RPI_HW_PWM_IMPLEMENTATION in the same translation unit"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** @name PCM Registers */
+/**@{*/
+#define PCM_CS_A   0
+#define PCM_FIFO_A 1
+#define PCM_MODE_A 2
+#define PCM_TXC_A  4
+#define PCM_DREQ_A 5
+/**@}*/
+
+/** @name PCM Bits */
+/**@{*/
+#define PCM_CS_EN          (1 << 0)
+#define PCM_CS_TXON        (1 << 2)
+#define PCM_CS_TXCLR       (1 << 3)
+#define PCM_CS_DMAEN       (1 << 9)
+#define PCM_MODE_FLEN(x)   ((uint32_t)(x) << 10)  /**< Frame length - 1 (bit clocks) */
+#define PCM_TXC_CH1EN      (1u << 30)
+#define PCM_DREQ_TX(x)     ((uint32_t)(x) << 8)
+#define PCM_DREQ_TX_PANIC(x) ((uint32_t)(x) << 24)
+#define PCM_FLEN_MAX       1024
+/**@}*/
+
+/** @name PCM Clock */
+/**@{*/
+#define CM_PCMCTL 38
+#define CM_PCMDIV 39
+/**@}*/
+
+/**
+ * FIFO level the pacer keeps. Delays only advance as the pacer drains it,
+ * so edges are spaced exactly. Priming writes twice as many words, so the
+ * FIFO is at its level (even if ticks drain it while filling) and the first
+ * step starts on a tick.
+ */
+#define WAVE_FIFO_LEVEL 8
+#define WAVE_PRIME_WORDS (2 * WAVE_FIFO_LEVEL)
+
+#define WAVE_TI_GPIO (DMA_TI_NO_WIDE_BURSTS | DMA_TI_WAIT_RESP | DMA_TI_SRC_INC | DMA_TI_DEST_INC)
+
+static int wave_dreq(const wave_engine_t* eng) {
+    return eng->pacer == WAVE_PACE_PCM ? DMA_DREQ_PCM_TX : DMA_DREQ_PWM;
+}
+
+static uint32_t wave_fifo_bus(const wave_engine_t* eng) {
+    return eng->pacer == WAVE_PACE_PCM ? dma_periph_bus(PERIPH_PCM, PCM_FIFO_A)
+                                       : dma_periph_bus(PERIPH_PWM, PWM_FIF1);
+}
+
+/* ============================================================================
+ * ENGINE
+ * ============================================================================ */
+
+static void wave_pacer_stop(wave_engine_t* eng) {
+    volatile uint32_t* r = eng->regs;
+    if (!r) return;
+    if (eng->pacer == WAVE_PACE_PCM) {
+        r[PCM_CS_A] = 0;
+    } else {
+        r[PWM_DMAC] = 0;
+        r[PWM_CTL] = PWM_CTL_CLRF1;
+    }
+}
+
+/** Program the pacer clock so that one FIFO word drains per tick. */
+static int wave_pacer_start(wave_engine_t* eng, uint32_t tick_ns) {
+    hpwm_plan_t plan;
+    if (hpwm_plan((int)(1e9 / tick_ns + 0.5), 0, &plan) != 0) return -1;
+
+    volatile uint32_t* r = eng->regs;
+    uint32_t words = plan.range[0];
+    if (eng->pacer == WAVE_PACE_PCM && words > PCM_FLEN_MAX) {
+        /* A PCM frame is at most PCM_FLEN_MAX bit clocks: slow the clock instead */
+        if (hpwm_plan_clock(PCM_FLEN_MAX * 1e9 / tick_ns, &plan) != 0) return -1;
+        double fit = plan.clock_hz * tick_ns / 1e9 + 0.5;
+        if (fit < 2.0) return -1;
+        words = fit > PCM_FLEN_MAX ? PCM_FLEN_MAX : (uint32_t)fit;
+    }
+    if (eng->pacer == WAVE_PACE_PCM) {
+        r[PCM_CS_A] = 0;
+        hpwm_cm_setup(eng->clk, CM_PCMCTL, &plan);
+        r[PCM_MODE_A] = PCM_MODE_FLEN(words - 1);
+        r[PCM_TXC_A] = PCM_TXC_CH1EN;
+        r[PCM_CS_A] = PCM_CS_EN | PCM_CS_TXCLR;
+        r[PCM_DREQ_A] = PCM_DREQ_TX_PANIC(WAVE_FIFO_LEVEL) | PCM_DREQ_TX(WAVE_FIFO_LEVEL);
+        r[PCM_CS_A] = PCM_CS_EN | PCM_CS_DMAEN | PCM_CS_TXON;
+    } else {
+        r[PWM_CTL] = 0;
+        usleep(10);
+        hpwm_cm_setup(eng->clk, CM_PWMCTL, &plan);
+        r[PWM_RNG1] = words;
+        r[PWM_CTL] = PWM_CTL_CLRF1;
+        r[PWM_DMAC] = PWM_DMAC_ENAB | PWM_DMAC_PANIC(WAVE_FIFO_LEVEL) | PWM_DMAC_DREQ(WAVE_FIFO_LEVEL);
+        r[PWM_CTL] = PWM_CTL_USEF1 | PWM_CTL_PWEN1;
+    }
+    eng->tick_ns = words * 1e9 / plan.clock_hz;
+    return 0;
+}
+
+int wave_engine_attach(wave_engine_t* eng, wave_pacer_t pacer, uint32_t tick_ns,
+                       volatile uint32_t* regs, volatile uint32_t* clk, dma_chan_t* dma) {
+    if (!eng || !regs || !clk || !dma || !dma->regs) return -1;
+    if (pacer != WAVE_PACE_PWM && pacer != WAVE_PACE_PCM) return -1;
+    if (tick_ns == 0) tick_ns = WAVE_TICK_NS_DEFAULT;
+
+    memset(eng, 0, sizeof(*eng));
+    eng->pacer = pacer;
+    eng->regs = regs;
+    eng->clk = clk;
+    eng->dma = dma;
+    if (wave_pacer_start(eng, tick_ns) != 0) {
+        eng->regs = NULL;
+        return -1;
+    }
+
+    if (dma_mem_alloc(&eng->mem, sizeof(uint32_t)) != 0) {
+        wave_pacer_stop(eng);
+        eng->regs = NULL;
+        return -1;
+    }
+    *(uint32_t*)eng->mem.virt = 0;
+    eng->dummy_bus = eng->mem.bus;
+    return 0;
+}
+
+int wave_engine_init(wave_engine_t* eng, wave_pacer_t pacer, uint32_t tick_ns, dma_chan_t* dma) {
+    if (!eng) return -1;
+    periph_block_t block = pacer == WAVE_PACE_PCM ? PERIPH_PCM : PERIPH_PWM;
+
+    volatile uint32_t* regs = periph_map(block);
+    if (!regs) return -1;
+
+    volatile uint32_t* clk = periph_map(PERIPH_CLK);
+    if (!clk) {
+        periph_unmap(block);
+        return -1;
+    }
+
+    if (wave_engine_attach(eng, pacer, tick_ns, regs, clk, dma) != 0) {
+        periph_unmap(PERIPH_CLK);
+        periph_unmap(block);
+        return -1;
+    }
+    eng->mapped = 1;
+    return 0;
+}
+
+void wave_engine_close(wave_engine_t* eng) {
+    if (!eng || !eng->regs) return;
+    dma_chan_stop(eng->dma);
+    wave_pacer_stop(eng);
+    dma_mem_free(&eng->mem);
+    if (eng->mapped) {
+        periph_unmap(eng->pacer == WAVE_PACE_PCM ? PERIPH_PCM : PERIPH_PWM);
+        periph_unmap(PERIPH_CLK);
+        eng->mapped = 0;
+    }
+    eng->regs = NULL;
+    eng->clk = NULL;
+}
+
+/* ============================================================================
+ * COMPILER
+ * ============================================================================ */
+
+static uint64_t wave_step_ticks(const wave_engine_t* eng, const wave_step_t* step) {
+    return (uint64_t)(step->delay_us * 1000.0 / eng->tick_ns + 0.5);
+}
+
+/** Control blocks for n ticks of delay. */
+static int wave_delay_cbs(uint64_t ticks) {
+    return (int)((ticks + WAVE_DELAY_MAX_TICKS - 1) / WAVE_DELAY_MAX_TICKS);
+}
+
+static void wave_cb_delay(const wave_engine_t* eng, dma_cb_t* cb, uint32_t ticks) {
+    cb->ti = DMA_TI_NO_WIDE_BURSTS | DMA_TI_WAIT_RESP | DMA_TI_DEST_DREQ |
+             DMA_TI_PERMAP(wave_dreq(eng));
+    cb->source_ad = eng->dummy_bus;
+    cb->dest_ad = wave_fifo_bus(eng);
+    cb->txfr_len = ticks * sizeof(uint32_t);
+    cb->stride = 0;
+}
+
+/** GPSETn or GPCLRn for both banks, from two words in wave memory. */
+static void wave_cb_gpio(wave_t* wave, dma_cb_t* cb, uint32_t* words, uint64_t mask, int reg) {
+    words[0] = (uint32_t)mask;
+    words[1] = (uint32_t)(mask >> 32);
+    cb->ti = WAVE_TI_GPIO;
+    cb->source_ad = dma_mem_bus(&wave->mem, words);
+    cb->dest_ad = dma_periph_bus(PERIPH_GPIO, (uint32_t)reg);
+    cb->txfr_len = 2 * sizeof(uint32_t);
+    cb->stride = 0;
+}
+
+int wave_compile(wave_t* wave, const wave_engine_t* eng, const wave_step_t* steps, int count) {
+    if (!wave || !eng || !eng->regs || !steps || count <= 0) return -1;
+
+    /* Pass 1: size */
+    int cbs = 1, gpio_writes = 0;
+    for (int i = 0; i < count; i++) {
+        if ((steps[i].set_mask | steps[i].clr_mask) & ~GPIO_ALL_PINS_MASK) return -1;
+        gpio_writes += (steps[i].set_mask != 0) + (steps[i].clr_mask != 0);
+        cbs += wave_delay_cbs(wave_step_ticks(eng, &steps[i]));
+    }
+    cbs += gpio_writes;
+
+    memset(wave, 0, sizeof(*wave));
+    size_t cb_bytes = (size_t)cbs * sizeof(dma_cb_t);
+    if (dma_mem_alloc(&wave->mem, cb_bytes + (size_t)gpio_writes * 2 * sizeof(uint32_t)) != 0) return -1;
+    wave->cbs = (dma_cb_t*)wave->mem.virt;
+    uint32_t* words = (uint32_t*)((uint8_t*)wave->mem.virt + cb_bytes);
+
+    /* Pass 2: emit. Block 0 fills the pacer FIFO so step 0 starts on a tick. */
+    int n = 0;
+    wave_cb_delay(eng, &wave->cbs[n++], WAVE_PRIME_WORDS);
+    wave->first_step = n;
+    for (int i = 0; i < count; i++) {
+        const wave_step_t* st = &steps[i];
+        if (st->set_mask) {
+            wave_cb_gpio(wave, &wave->cbs[n++], words, st->set_mask, GPSET0);
+            words += 2;
+        }
+        if (st->clr_mask) {
+            wave_cb_gpio(wave, &wave->cbs[n++], words, st->clr_mask, GPCLR0);
+            words += 2;
+        }
+        uint64_t ticks = wave_step_ticks(eng, st);
+        wave->ticks += ticks;
+        while (ticks) {
+            uint32_t chunk = ticks > WAVE_DELAY_MAX_TICKS ? WAVE_DELAY_MAX_TICKS : (uint32_t)ticks;
+            wave_cb_delay(eng, &wave->cbs[n++], chunk);
+            ticks -= chunk;
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        wave->cbs[i].nextconbk = i + 1 < n ? dma_mem_bus(&wave->mem, &wave->cbs[i + 1]) : 0;
+    }
+    wave->num_cbs = n;
+    wave->duration_ns = wave->ticks * eng->tick_ns;
+    return 0;
+}
+
+void wave_free(wave_t* wave) {
+    if (!wave || !wave->cbs) return;
+    dma_mem_free(&wave->mem);
+    wave->cbs = NULL;
+    wave->num_cbs = 0;
+}
+
+int wave_busy(const wave_engine_t* eng) {
+    return eng && eng->regs && dma_chan_active(eng->dma);
+}
+
+int wave_play(wave_engine_t* eng, wave_t* wave, int loop) {
+    if (!eng || !eng->regs || !wave || !wave->cbs) return -1;
+    if (wave_busy(eng)) return -1;
+    if (loop && wave->ticks == 0) return -1;  /* Would spin on GPIO writes */
+
+    /* A looping pass returns after priming: the FIFO is already at its level */
+    dma_cb_t* last = &wave->cbs[wave->num_cbs - 1];
+    last->nextconbk = loop ? dma_mem_bus(&wave->mem, &wave->cbs[wave->first_step]) : 0;
+    dma_chan_start(eng->dma, dma_mem_bus(&wave->mem, wave->cbs));
+    return 0;
+}
+
+void wave_stop(wave_engine_t* eng) {
+    if (!eng || !eng->regs) return;
+    dma_chan_stop(eng->dma);
+    if (eng->pacer == WAVE_PACE_PCM) {
+        eng->regs[PCM_CS_A] |= PCM_CS_TXCLR;
+    } else {
+        eng->regs[PWM_CTL] |= PWM_CTL_CLRF1;
+    }
+}
+
+/* ============================================================================
+ * SIMULATOR
+ * ============================================================================ */
+
+static void wave_sim_gpio_write(void* user, uint32_t reg, uint32_t value) {
+    wave_sim_t* sim = (wave_sim_t*)user;
+    uint64_t prev = sim->levels;
+
+    if (reg == GPSET0 || reg == GPSET1) {
+        uint64_t mask = (uint64_t)value << (32 * (reg - GPSET0));
+        sim->levels |= mask;
+        if (sim->mirror && mask) gpio_ctx_write_mask(sim->mirror, mask, 0);
+    } else if (reg == GPCLR0 || reg == GPCLR1) {
+        uint64_t mask = (uint64_t)value << (32 * (reg - GPCLR0));
+        sim->levels &= ~mask;
+        if (sim->mirror && mask) gpio_ctx_write_mask(sim->mirror, 0, mask);
+    } else {
+        sim->gpio[reg] = value;
+        return;
+    }
+
+    sim->gpio[GPLEV0] = (uint32_t)sim->levels;
+    sim->gpio[GPLEV1] = (uint32_t)(sim->levels >> 32);
+    if (sim->levels != prev && sim->log && sim->log_len < sim->log_cap) {
+        sim->log[sim->log_len].t_ns = sim->dma.now_ns;
+        sim->log[sim->log_len].levels = sim->levels;
+        sim->log_len++;
+    }
+}
+
+static uint64_t wave_sim_pcm_advance(void* user, uint64_t now_ns) {
+    wave_sim_t* sim = (wave_sim_t*)user;
+    uint32_t cs = sim->pcm[PCM_CS_A];
+
+    if (cs & PCM_CS_TXCLR) {
+        sim->pcm_fifo = 0;
+        sim->pcm[PCM_CS_A] = cs &= ~PCM_CS_TXCLR;
+    }
+
+    double clock = hpwm_sim_cm_clock(sim->pwm.clk, CM_PCMCTL);
+    uint32_t flen = ((sim->pcm[PCM_MODE_A] >> 10) & 0x3FF) + 1;
+    if (!(cs & PCM_CS_EN) || !(cs & PCM_CS_TXON) || clock <= 0.0) {
+        sim->pcm_next_ns = 0.0;
+        return UINT64_MAX;
+    }
+
+    double frame_ns = flen * 1e9 / clock;
+    if (sim->pcm_next_ns == 0.0) sim->pcm_next_ns = (double)now_ns + frame_ns;
+    while (sim->pcm_next_ns <= (double)now_ns) {
+        if (sim->pcm_fifo > 0) sim->pcm_fifo--;  /* Underflow just repeats silence */
+        sim->pcm_next_ns += frame_ns;
+    }
+    return (uint64_t)sim->pcm_next_ns + 1;
+}
+
+static int wave_sim_pcm_dreq(void* user, int dreq) {
+    wave_sim_t* sim = (wave_sim_t*)user;
+    (void)dreq;
+    int threshold = (int)((sim->pcm[PCM_DREQ_A] >> 8) & 0x7F);
+    if (threshold > WAVE_PCM_FIFO_DEPTH) threshold = WAVE_PCM_FIFO_DEPTH;
+    return (sim->pcm[PCM_CS_A] & PCM_CS_DMAEN) && sim->pcm_fifo < threshold;
+}
+
+static void wave_sim_pcm_write(void* user, uint32_t reg, uint32_t value) {
+    wave_sim_t* sim = (wave_sim_t*)user;
+    if (reg != PCM_FIFO_A) {
+        sim->pcm[reg] = value;
+        return;
+    }
+    if (sim->pcm_fifo < WAVE_PCM_FIFO_DEPTH) sim->pcm_fifo++;
+}
+
+void wave_sim_init(wave_sim_t* sim, wave_edge_t* log, size_t log_cap) {
+    memset(sim, 0, sizeof(*sim));
+    dma_sim_init(&sim->dma);
+    hpwm_sim_init(&sim->pwm, NULL, 0);
+    sim->log = log;
+    sim->log_cap = log_cap;
+
+    dma_sim_dev_t dev;
+    hpwm_sim_device(&sim->pwm, &dev);
+    dma_sim_add_device(&sim->dma, &dev);
+
+    memset(&dev, 0, sizeof(dev));
+    dev.block = PERIPH_PCM;
+    dev.regs = sim->pcm;
+    dev.dreqs = 1u << DMA_DREQ_PCM_TX;
+    dev.dreq = wave_sim_pcm_dreq;
+    dev.write = wave_sim_pcm_write;
+    dev.advance = wave_sim_pcm_advance;
+    dev.user = sim;
+    dma_sim_add_device(&sim->dma, &dev);
+
+    memset(&dev, 0, sizeof(dev));
+    dev.block = PERIPH_GPIO;
+    dev.regs = sim->gpio;
+    dev.write = wave_sim_gpio_write;
+    dev.user = sim;
+    dma_sim_add_device(&sim->dma, &dev);
+}
+
+int wave_sim_engine(wave_sim_t* sim, wave_engine_t* eng, wave_pacer_t pacer,
+                    uint32_t tick_ns, dma_chan_t* dma) {
+    if (!sim || dma_chan_attach(dma, sim->dma.regs, DMA_CHANNEL_DEFAULT) != 0) return -1;
+    volatile uint32_t* regs = pacer == WAVE_PACE_PCM ? sim->pcm : sim->pwm.pwm;
+    return wave_engine_attach(eng, pacer, tick_ns, regs, sim->pwm.clk, dma);
+}
+
+uint64_t wave_sim_run(wave_sim_t* sim, uint64_t duration_ns) {
+    return dma_sim_run(&sim->dma, duration_ns);
+}
+
+#endif /* RPI_WAVE_IMPLEMENTATION */
@@ -0,0 +1,515 @@
+/**
+ * @file rpi_ws2812.h
+ * @brief WS2812/SK6812 LED strips bit-banged from the CPU.
+ *
+ * Single-header library. Define RPI_WS2812_IMPLEMENTATION in exactly one
+ * translation unit before including this file.
+ *
+ * Requires rpi_gpio.h, rpi_realtime.h and pthread (-pthread linker flag).
+ *
+ * A fallback for when the PWM/PCM pins that rpi_hw_pwm.h drives are taken.
+ * Pixels are encoded into one (high, low) pair per bit, in ticks of a fast
+ * counter: the ARM generic timer on 64-bit kernels, the TSC on x86
+ * (calibrated once against CLOCK_MONOTONIC), CLOCK_MONOTONIC elsewhere. A
+ * 256-entry table holds the eight pairs of every byte value, so encoding is
+ * one copy per colour byte. Emission spins on the counter: each bit rises when its slot
+ * starts, falls once its high time has passed since the measured rise, and
+ * the next slot is timed from that rise, so a late edge never shortens the
+ * pulse that decides the bit.
+ *
+ * Each emitted bit is measured: the high time error goes into a histogram
+ * and lows long enough to be taken as a reset are counted, so the stats
+ * tell whether a given core setup is reliable. The frame is a critical
+ * section of 30 us per LED: run it from ws2812_start() on an isolated core
+ * (SCHED_FIFO when pinned), where ws2812_show() encodes the next frame in
+ * the caller's thread while the current one is sent.
+ */
+
+#ifndef RPI_WS2812_H
+#define RPI_WS2812_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** LEDs per strip. */
+#define WS2812_MAX_LEDS 4096
+
+/** @name LED Types */
+/**@{*/
+#define WS2812_GRB   0    /**< WS2812(B): 3 bytes per LED. */
+#define SK6812_GRBW  1    /**< SK6812 RGBW: 4 bytes per LED. */
+/**@}*/
+
+/** Pack a pixel (white only used by SK6812_GRBW). */
+#define WS2812_RGB(r, g, b)     (((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+#define WS2812_RGBW(r, g, b, w) (WS2812_RGB(r, g, b) | ((uint32_t)(w) << 24))
+
+/** Histogram bin width and bins of the high time error. */
+#define WS2812_HIST_NS   25
+#define WS2812_HIST_BINS 16
+
+/** High time error the LEDs tolerate (datasheet +-150 ns). */
+#ifndef WS2812_TOLERANCE_NS
+#define WS2812_TOLERANCE_NS 150
+#endif
+
+/** Lows longer than this risk being taken as a reset mid-frame. */
+#ifndef WS2812_MAX_LOW_NS
+#define WS2812_MAX_LOW_NS 5000
+#endif
+
+/** Poll interval of an idle, unpinned thread. */
+#define WS2812_IDLE_US 50
+
+/**
+ * @brief One encoded bit, in counter ticks.
+ */
+typedef struct {
+    uint32_t high;
+    uint32_t low;
+} ws2812_bit_t;
+
+/**
+ * @brief Emission counters and timing error distribution.
+ */
+typedef struct {
+    uint64_t frames;
+    uint64_t bits;
+    uint64_t hist[WS2812_HIST_BINS + 1];  /**< |high error| per WS2812_HIST_NS, last = beyond. */
+    uint64_t out_of_spec;                 /**< Bits off by more than WS2812_TOLERANCE_NS. */
+    uint64_t long_lows;                   /**< Lows over WS2812_MAX_LOW_NS. */
+    uint64_t max_err_ns;
+    uint64_t total_err_ns;                /**< Mean = total / bits. */
+    uint64_t max_low_ns;
+    uint64_t last_frame_ns;               /**< Emission time of the last frame. */
+} ws2812_stats_t;
+
+/**
+ * @brief A strip.
+ */
+typedef struct {
+    gpio_ctx_t* gpio;
+    int pin;
+    size_t count;
+    int type;
+    int bytes_per_led;
+    uint32_t t0h_ns;
+    uint32_t t1h_ns;
+    uint32_t bit_ns;
+    uint32_t reset_us;
+    double ticks_per_ns;
+    ws2812_bit_t* table;            /**< [byte * 8 + bit], MSB first. */
+    uint32_t* pixels;               /**< 0xWWRRGGBB per LED. */
+    ws2812_bit_t* bits[2];          /**< Encoded frames. */
+    size_t nbits;
+    int front;                      /**< Frame the thread sends. */
+    int pending;                    /**< Back frame published, not yet taken. */
+    uint64_t last_end;              /**< Counter at the end of the last frame. */
+    ws2812_stats_t stats;
+    pthread_t thread;
+    int running;
+    int realtime;                   /**< Thread got SCHED_FIFO. */
+    int core_id;
+} ws2812_t;
+
+/**
+ * @brief Set up a strip with the datasheet timing of @p type. The pin
+ * becomes an output, low; pixels start black.
+ * @param gpio GPIO context (NULL for gpio_ctx_default).
+ * @param count LEDs (1-WS2812_MAX_LEDS).
+ * @param type WS2812_GRB or SK6812_GRBW.
+ * @return 0 on success, -1 on error.
+ */
+int ws2812_init(ws2812_t* strip, gpio_ctx_t* gpio, int pin, size_t count, int type);
+
+/**
+ * @brief Stop the thread and free the buffers.
+ */
+void ws2812_free(ws2812_t* strip);
+
+/**
+ * @brief Override the bit timing.
+ * @param t0h_ns High time of a 0 bit.
+ * @param t1h_ns High time of a 1 bit (> t0h_ns).
+ * @param bit_ns Bit period (> t1h_ns).
+ * @param reset_us Low time that latches a frame.
+ * @return 0 on success, -1 on error or while the thread runs.
+ */
+int ws2812_set_timing(ws2812_t* strip, uint32_t t0h_ns, uint32_t t1h_ns, uint32_t bit_ns, uint32_t reset_us);
+
+/** @name Pixels */
+/**@{*/
+
+/** Framebuffer, count pixels as 0xWWRRGGBB. */
+uint32_t* ws2812_pixels(ws2812_t* strip);
+
+void ws2812_set_pixel(ws2812_t* strip, size_t index, uint32_t color);
+
+/**
+ * @brief Encode the framebuffer and send it.
+ *
+ * Without the thread this sends the frame now, in the calling thread. With
+ * the thread running it waits until the previous frame has been taken,
+ * encodes into the free buffer and returns while the thread sends. Call it
+ * from the thread that starts and stops the strip.
+ * @return 0 on success, -1 on error.
+ */
+int ws2812_show(ws2812_t* strip);
+/**@}*/
+
+/**
+ * @brief Start the sending thread.
+ * @param core_id Isolated CPU core to pin to, or -1.
+ * @return 0 on success, -1 on error.
+ */
+int ws2812_start(ws2812_t* strip, int core_id);
+
+/**
+ * @brief Stop the thread once the frame it is sending is complete.
+ */
+void ws2812_stop(ws2812_t* strip);
+
+/**
+ * @brief Copy the counters (safe while the thread runs).
+ */
+void ws2812_get_stats(ws2812_t* strip, ws2812_stats_t* stats);
+
+/**
+ * @brief Clear the counters.
+ */
+void ws2812_reset_stats(ws2812_t* strip);
+
+/**
+ * @brief Counter ticks per nanosecond (calibrated on first call).
+ */
+double ws2812_ticks_per_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RPI_WS2812_H */
+
+#ifdef RPI_WS2812_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static double ws2812_calibration = 0.0;
+
+static uint64_t ws2812_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t ws2812_ticks(void) {
+#if defined(__aarch64__)
+    uint64_t v;
+    __asm__ volatile("isb; mrs %0, cntvct_el0" : "=r"(v)::"memory");
+    return v;
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return ws2812_now_ns();
+#endif
+}
+
+double ws2812_ticks_per_ns(void) {
+    if (ws2812_calibration > 0.0) return ws2812_calibration;
+#if defined(__aarch64__)
+    uint64_t freq;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    ws2812_calibration = (double)freq / 1e9;
+#elif defined(__x86_64__) || defined(__i386__)
+    /* Best of several short runs: a preempted run only skews one */
+    double best = 0.0;
+    for (int run = 0; run < 5; run++) {
+        uint64_t n0 = ws2812_now_ns(), c0 = ws2812_ticks();
+        while (ws2812_now_ns() - n0 < 2000000ull) {
+        }
+        uint64_t n1 = ws2812_now_ns(), c1 = ws2812_ticks();
+        double r = (double)(c1 - c0) / (double)(n1 - n0);
+        if (run == 0 || r < best) best = r;
+    }
+    ws2812_calibration = best;
+#else
+    ws2812_calibration = 1.0;
+#endif
+    return ws2812_calibration;
+}
+
+static inline uint32_t ws2812_ns_to_ticks(const ws2812_t* strip, uint32_t ns) {
+    double t = ns * strip->ticks_per_ns + 0.5;
+    return t < 1.0 ? 1 : (uint32_t)t;
+}
+
+static inline uint64_t ws2812_ticks_to_ns(const ws2812_t* strip, uint64_t ticks) {
+    return (uint64_t)((double)ticks / strip->ticks_per_ns + 0.5);
+}
+
+/** Histogram bin of a high time error, binned in ns whatever the counter rate. */
+static inline int ws2812_hist_bin(const ws2812_t* strip, uint64_t err_ticks) {
+    uint64_t bin = ws2812_ticks_to_ns(strip, err_ticks) / WS2812_HIST_NS;
+    return bin < WS2812_HIST_BINS ? (int)bin : WS2812_HIST_BINS;
+}
+
+static void ws2812_build(ws2812_t* strip) {
+    ws2812_bit_t zero = { ws2812_ns_to_ticks(strip, strip->t0h_ns), ws2812_ns_to_ticks(strip, strip->bit_ns - strip->t0h_ns) };
+    ws2812_bit_t one = { ws2812_ns_to_ticks(strip, strip->t1h_ns), ws2812_ns_to_ticks(strip, strip->bit_ns - strip->t1h_ns) };
+    for (int v = 0; v < 256; v++) {
+        for (int i = 0; i < 8; i++) strip->table[v * 8 + i] = ((v >> (7 - i)) & 1) ? one : zero;
+    }
+}
+
+/** Framebuffer -> bit pairs, wire order G R B (W). */
+static void ws2812_encode(const ws2812_t* strip, ws2812_bit_t* out) {
+    const ws2812_bit_t* table = strip->table;
+    for (size_t n = 0; n < strip->count; n++) {
+        uint32_t p = strip->pixels[n];
+        uint8_t bytes[4] = { (uint8_t)(p >> 8), (uint8_t)(p >> 16), (uint8_t)p, (uint8_t)(p >> 24) };
+        for (int b = 0; b < strip->bytes_per_led; b++, out += 8) memcpy(out, &table[bytes[b] * 8], 8 * sizeof(*out));
+    }
+}
+
+/**
+ * Send one encoded frame: wait out the reset since the last one, then the
+ * critical section. The error histogram is kept locally and merged once.
+ */
+static void ws2812_emit(ws2812_t* strip, const ws2812_bit_t* bits) {
+    gpio_ctx_t* gpio = strip->gpio;
+    const int pin = strip->pin;
+    const size_t nbits = strip->nbits;
+    /* Not rounded to whole ticks: one is 52 ns at 19.2 MHz */
+    const double tol_ticks = WS2812_TOLERANCE_NS * strip->ticks_per_ns;
+    const uint64_t max_low = ws2812_ns_to_ticks(strip, WS2812_MAX_LOW_NS);
+
+    uint64_t hist[WS2812_HIST_BINS + 1] = { 0 };
+    uint64_t out_of_spec = 0, long_lows = 0, max_err = 0, total_err = 0, worst_low = 0;
+
+    uint64_t reset = (uint64_t)strip->reset_us * 1000u;
+    uint64_t now = ws2812_ticks();
+    uint64_t ready = strip->last_end + (uint64_t)((double)reset * strip->ticks_per_ns);
+    while (strip->last_end && now < ready) now = ws2812_ticks();
+
+    uint64_t t0 = ws2812_now_ns();
+    uint64_t rise = ws2812_ticks(), fell = rise;
+    for (size_t i = 0; i < nbits; i++) {
+        uint64_t t = ws2812_ticks();
+        while (t < rise) t = ws2812_ticks();
+        gpio_ctx_write_fast(gpio, pin, HIGH);
+        uint64_t hi = ws2812_ticks();
+        if (i > 0 && hi - fell > worst_low) worst_low = hi - fell;
+        if (i > 0 && hi - fell > max_low) long_lows++;
+
+        uint64_t fall = hi + bits[i].high;
+        while ((t = ws2812_ticks()) < fall) {
+        }
+        gpio_ctx_write_fast(gpio, pin, LOW);
+        fell = ws2812_ticks();
+
+        uint64_t err = (fell - hi) - bits[i].high;
+        hist[ws2812_hist_bin(strip, err)]++;
+        if ((double)err > tol_ticks) out_of_spec++;
+        if (err > max_err) max_err = err;
+        total_err += err;
+        rise = hi + bits[i].high + bits[i].low;
+    }
+    while (ws2812_ticks() < rise) {
+    }
+    strip->last_end = ws2812_ticks();
+    uint64_t took = ws2812_now_ns() - t0;
+
+    ws2812_stats_t* st = &strip->stats;
+    for (int b = 0; b <= WS2812_HIST_BINS; b++) {
+        if (hist[b]) __atomic_store_n(&st->hist[b], st->hist[b] + hist[b], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&st->bits, st->bits + nbits, __ATOMIC_RELAXED);
+    __atomic_store_n(&st->out_of_spec, st->out_of_spec + out_of_spec, __ATOMIC_RELAXED);
+    __atomic_store_n(&st->long_lows, st->long_lows + long_lows, __ATOMIC_RELAXED);
+    __atomic_store_n(&st->total_err_ns, st->total_err_ns + ws2812_ticks_to_ns(strip, total_err), __ATOMIC_RELAXED);
+    uint64_t max_ns = ws2812_ticks_to_ns(strip, max_err), low_ns = ws2812_ticks_to_ns(strip, worst_low);
+    if (max_ns > st->max_err_ns) __atomic_store_n(&st->max_err_ns, max_ns, __ATOMIC_RELAXED);
+    if (low_ns > st->max_low_ns) __atomic_store_n(&st->max_low_ns, low_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&st->last_frame_ns, took, __ATOMIC_RELAXED);
+    __atomic_store_n(&st->frames, st->frames + 1, __ATOMIC_RELEASE);
+}
+
+int ws2812_init(ws2812_t* strip, gpio_ctx_t* gpio, int pin, size_t count, int type) {
+    if (!strip) return -1;
+    if (!GPIO_VALID_PIN(pin) || count == 0 || count > WS2812_MAX_LEDS || (type != WS2812_GRB && type != SK6812_GRBW)) {
+        fprintf(stderr, "WS2812 Error: Invalid strip (pin %d, %zu LEDs, type %d)\n", pin, count, type);
+        return -1;
+    }
+
+    memset(strip, 0, sizeof(*strip));
+    strip->bytes_per_led = type == SK6812_GRBW ? 4 : 3;
+    strip->nbits = count * (size_t)strip->bytes_per_led * 8;
+    size_t frame = (strip->nbits * sizeof(ws2812_bit_t) + 63) & ~(size_t)63;
+    strip->table = (ws2812_bit_t*)aligned_alloc(64, 256 * 8 * sizeof(ws2812_bit_t));
+    strip->bits[0] = (ws2812_bit_t*)aligned_alloc(64, 2 * frame);
+    strip->pixels = (uint32_t*)calloc(count, sizeof(uint32_t));
+    if (!strip->table || !strip->bits[0] || !strip->pixels) {
+        perror("WS2812 Error: Failed to allocate strip");
+        free(strip->table);
+        free(strip->bits[0]);
+        free(strip->pixels);
+        memset(strip, 0, sizeof(*strip));
+        return -1;
+    }
+    strip->bits[1] = strip->bits[0] + frame / sizeof(ws2812_bit_t);
+    strip->gpio = gpio ? gpio : &gpio_ctx_default;
+    strip->pin = pin;
+    strip->count = count;
+    strip->type = type;
+    strip->core_id = -1;
+    strip->ticks_per_ns = ws2812_ticks_per_ns();
+    if (type == SK6812_GRBW) ws2812_set_timing(strip, 300, 600, 1250, 80);
+    else ws2812_set_timing(strip, 400, 800, 1250, 300);
+
+    gpio_ctx_write(strip->gpio, pin, LOW);
+    gpio_ctx_pin_mode(strip->gpio, pin, OUTPUT);
+    return 0;
+}
+
+void ws2812_free(ws2812_t* strip) {
+    if (!strip || !strip->table) return;
+    ws2812_stop(strip);
+    free(strip->table);
+    free(strip->bits[0]);
+    free(strip->pixels);
+    strip->table = NULL;
+    strip->bits[0] = strip->bits[1] = NULL;
+    strip->pixels = NULL;
+}
+
+int ws2812_set_timing(ws2812_t* strip, uint32_t t0h_ns, uint32_t t1h_ns, uint32_t bit_ns, uint32_t reset_us) {
+    if (!strip || !strip->table) return -1;
+    if (t0h_ns == 0 || t1h_ns <= t0h_ns || bit_ns <= t1h_ns) {
+        fprintf(stderr, "WS2812 Error: Invalid timing (T0H %u, T1H %u, bit %u ns)\n", t0h_ns, t1h_ns, bit_ns);
+        return -1;
+    }
+    if (strip->running) {
+        fprintf(stderr, "WS2812 Error: Stop the thread before changing the timing\n");
+        return -1;
+    }
+    strip->t0h_ns = t0h_ns;
+    strip->t1h_ns = t1h_ns;
+    strip->bit_ns = bit_ns;
+    strip->reset_us = reset_us;
+    ws2812_build(strip);
+    return 0;
+}
+
+/* ============================================================================
+ * PIXELS
+ * ============================================================================ */
+
+uint32_t* ws2812_pixels(ws2812_t* strip) {
+    return strip ? strip->pixels : NULL;
+}
+
+void ws2812_set_pixel(ws2812_t* strip, size_t index, uint32_t color) {
+    if (!strip || !strip->pixels || index >= strip->count) return;
+    strip->pixels[index] = color;
+}
+
+int ws2812_show(ws2812_t* strip) {
+    if (!strip || !strip->table) return -1;
+
+    if (!__atomic_load_n(&strip->running, __ATOMIC_ACQUIRE)) {
+        ws2812_encode(strip, strip->bits[strip->front]);
+        ws2812_emit(strip, strip->bits[strip->front]);
+        return 0;
+    }
+
+    /* The back buffer is free once the thread has taken the last frame */
+    while (__atomic_load_n(&strip->pending, __ATOMIC_ACQUIRE)) usleep(WS2812_IDLE_US);
+    ws2812_encode(strip, strip->bits[strip->front ^ 1]);
+    __atomic_store_n(&strip->pending, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* ============================================================================
+ * SENDING THREAD
+ * ============================================================================ */
+
+static void* ws2812_thread_func(void* arg) {
+    ws2812_t* strip = (ws2812_t*)arg;
+    int pinned = strip->core_id >= 0 && pin_to_core(strip->core_id) == 0;
+    if (pinned) {
+        struct sched_param param = { .sched_priority = sched_get_priority_max(SCHED_FIFO) };
+        strip->realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+
+    for (;;) {
+        if (__atomic_load_n(&strip->pending, __ATOMIC_ACQUIRE)) {
+            strip->front ^= 1;
+            __atomic_store_n(&strip->pending, 0, __ATOMIC_RELEASE);
+            ws2812_emit(strip, strip->bits[strip->front]);
+            continue;
+        }
+        if (!__atomic_load_n(&strip->running, __ATOMIC_RELAXED)) break;
+        if (!pinned) usleep(WS2812_IDLE_US);
+    }
+    return NULL;
+}
+
+int ws2812_start(ws2812_t* strip, int core_id) {
+    if (!strip || !strip->table) return -1;
+    if (strip->running) {
+        fprintf(stderr, "WS2812 Error: Thread already running\n");
+        return -1;
+    }
+
+    strip->core_id = core_id;
+    strip->realtime = 0;
+    strip->pending = 0;
+    __atomic_store_n(&strip->running, 1, __ATOMIC_RELEASE);
+
+    if (pthread_create(&strip->thread, NULL, ws2812_thread_func, strip) != 0) {
+        perror("WS2812 Error: Failed to create thread");
+        strip->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void ws2812_stop(ws2812_t* strip) {
+    if (!strip || !strip->running) return;
+    __atomic_store_n(&strip->running, 0, __ATOMIC_RELEASE);
+    pthread_join(strip->thread, NULL);
+}
+
+void ws2812_get_stats(ws2812_t* strip, ws2812_stats_t* stats) {
+    if (!strip || !stats) return;
+    const ws2812_stats_t* s = &strip->stats;
+    stats->frames = __atomic_load_n(&s->frames, __ATOMIC_ACQUIRE);
+    stats->bits = __atomic_load_n(&s->bits, __ATOMIC_RELAXED);
+    for (int b = 0; b <= WS2812_HIST_BINS; b++) stats->hist[b] = __atomic_load_n(&s->hist[b], __ATOMIC_RELAXED);
+    stats->out_of_spec = __atomic_load_n(&s->out_of_spec, __ATOMIC_RELAXED);
+    stats->long_lows = __atomic_load_n(&s->long_lows, __ATOMIC_RELAXED);
+    stats->max_err_ns = __atomic_load_n(&s->max_err_ns, __ATOMIC_RELAXED);
+    stats->total_err_ns = __atomic_load_n(&s->total_err_ns, __ATOMIC_RELAXED);
+    stats->max_low_ns = __atomic_load_n(&s->max_low_ns, __ATOMIC_RELAXED);
+    stats->last_frame_ns = __atomic_load_n(&s->last_frame_ns, __ATOMIC_RELAXED);
+}
+
+void ws2812_reset_stats(ws2812_t* strip) {
+    if (!strip || strip->running) return;
+    memset(&strip->stats, 0, sizeof(strip->stats));
+}
+
+#endif /* RPI_WS2812_IMPLEMENTATION */
@@ -0,0 +1,267 @@
+/*
+ * test_rpi_adc.c - Validation tests for rpi_adc.h
+ *
+ * The pipeline runs against adc_sim_t answering the simulated SPI0 block,
+ * driven by adc_poll() for exact checks and by the sampler thread for
+ * pacing. The simulated input is a per-channel ramp, so every value tells
+ * which conversion it came from.
+ * Focus: command framing per chip, decoded values and channel order,
+ * zero-copy peek across the wrap, overrun reporting, paced sampling.
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_SPI_IMPLEMENTATION
+#include "rpi_spi.h"
+
+#define RPI_ADC_IMPLEMENTATION
+#include "rpi_adc.h"
+
+static uint16_t signal_const(void* user, int channel, uint64_t n) {
+    (void)n;
+    return (uint16_t)(*(int*)user + channel);
+}
+
+/* ============================================================================
+ * FRAMING
+ * ============================================================================ */
+
+void test_frames_per_chip(void) {
+    uint8_t tx[ADC_FRAME_MAX];
+
+    TEST_ASSERT_EQUAL_INT(3, adc_frame(ADC_MCP3008, 5, tx));
+    TEST_ASSERT_EQUAL_INT(0x01, tx[0]);
+    TEST_ASSERT_EQUAL_INT(0xD0, tx[1]);
+    TEST_ASSERT_EQUAL_INT(0x00, tx[2]);
+
+    TEST_ASSERT_EQUAL_INT(3, adc_frame(ADC_MCP3208, 5, tx));
+    TEST_ASSERT_EQUAL_INT(0x07, tx[0]);
+    TEST_ASSERT_EQUAL_INT(0x40, tx[1]);
+
+    TEST_ASSERT_EQUAL_INT(2, adc_frame(ADC_ADS7886, 0, tx));
+    TEST_ASSERT_EQUAL_INT(-1, adc_frame(ADC_ADS7886, 1, tx));
+    TEST_ASSERT_EQUAL_INT(-1, adc_frame(ADC_MCP3008, 8, tx));
+    TEST_ASSERT_EQUAL_INT(-1, adc_frame(ADC_CHIP_COUNT, 0, tx));
+
+    /* Bits outside the code (null bit, leading zeros) are masked */
+    const uint8_t rx[3] = { 0xFF, 0xFE, 0x5A };
+    TEST_ASSERT_EQUAL_INT(0x25A, adc_decode(ADC_MCP3008, rx));
+    TEST_ASSERT_EQUAL_INT(0xE5A, adc_decode(ADC_MCP3208, rx));
+    TEST_ASSERT_EQUAL_INT(0xFFE, adc_decode(ADC_ADS7886, rx));
+}
+
+void test_open_unavailable_on_host(void) {
+    adc_t adc;
+    TEST_ASSERT_EQUAL_INT(-1, adc_open(&adc, NULL, 0, ADC_MCP3008, 0));
+    TEST_ASSERT_NULL(adc.ring);
+    TEST_ASSERT_EQUAL_INT(-1, adc_open(&adc, NULL, 3, ADC_MCP3008, 0));
+}
+
+/* ============================================================================
+ * CONVERSIONS
+ * ============================================================================ */
+
+void test_scan_values_and_order(void) {
+    adc_t adc;
+    TEST_ASSERT_EQUAL_INT(0, adc_open_sim(&adc, ADC_MCP3008, 64, NULL, NULL));
+    const int chans[] = { 7, 0, 3 };
+    TEST_ASSERT_EQUAL_INT(0, adc_set_channels(&adc, chans, 3));
+
+    TEST_ASSERT_EQUAL_INT(30, adc_poll(&adc, 10));
+    TEST_ASSERT_EQUAL_INT(30, adc_available(&adc));
+
+    adc_sample_t s[30];
+    TEST_ASSERT_EQUAL_INT(30, adc_read(&adc, s, 30));
+    for (int i = 0; i < 30; i++) {
+        int scan = i / 3;
+        TEST_ASSERT_EQUAL_INT(scan, (int)s[i].seq);
+        TEST_ASSERT_EQUAL_INT(chans[i % 3], s[i].channel);
+        TEST_ASSERT_EQUAL_INT(adc_sim_ramp(ADC_MCP3008, chans[i % 3], (uint64_t)scan), s[i].value);
+        if (i) TEST_ASSERT_GREATER_OR_EQUAL(s[i - 1].t_ns, s[i].t_ns);
+    }
+
+    adc_stats_t st;
+    adc_get_stats(&adc, &st);
+    TEST_ASSERT_EQUAL_UINT64(10, st.scans);
+    TEST_ASSERT_EQUAL_UINT64(30, st.samples);
+    TEST_ASSERT_EQUAL_UINT64(0, st.overruns);
+    TEST_ASSERT_EQUAL_UINT64(0, st.errors);
+    TEST_ASSERT_EQUAL_INT(0, adc_available(&adc));
+    adc_close(&adc);
+    TEST_ASSERT_NULL(adc.ring);
+}
+
+void test_twelve_bit_chips(void) {
+    adc_t adc;
+    int base = 4000;
+    TEST_ASSERT_EQUAL_INT(0, adc_open_sim(&adc, ADC_MCP3208, 0, signal_const, &base));
+    TEST_ASSERT_EQUAL_INT(ADC_CAPACITY_DEFAULT, adc.capacity);
+    const int chans[] = { 6, 1 };
+    TEST_ASSERT_EQUAL_INT(0, adc_set_channels(&adc, chans, 2));
+    TEST_ASSERT_EQUAL_INT(2, adc_poll(&adc, 1));
+
+    adc_sample_t s[3];
+    TEST_ASSERT_EQUAL_INT(2, adc_read(&adc, s, 2));
+    TEST_ASSERT_EQUAL_INT(4006, s[0].value);
+    TEST_ASSERT_EQUAL_INT(4001, s[1].value);
+    adc_close(&adc);
+
+    TEST_ASSERT_EQUAL_INT(0, adc_open_sim(&adc, ADC_ADS7886, 16, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, adc_set_channels(&adc, chans, 2));
+    TEST_ASSERT_EQUAL_INT(5, adc_poll(&adc, 5));
+    TEST_ASSERT_EQUAL_INT(5, adc_read(&adc, s, 2) + adc_read(&adc, s, 3));
+    TEST_ASSERT_EQUAL_INT(4, s[2].value);
+    adc_close(&adc);
+}
+
+/* ============================================================================
+ * CONSUMER
+ * ============================================================================ */
+
+void test_peek_is_zero_copy_across_wrap(void) {
+    adc_t adc;
+    TEST_ASSERT_EQUAL_INT(0, adc_open_sim(&adc, ADC_MCP3008, 16, NULL, NULL));
+    const int chans[] = { 0, 1, 2 };
+    TEST_ASSERT_EQUAL_INT(0, adc_set_channels(&adc, chans, 3));
+
+    const adc_sample_t* p = NULL;
+    TEST_ASSERT_EQUAL_INT(0, adc_peek(&adc, &p));
+    TEST_ASSERT_NULL(p);
+
+    /* 4 scans, release 12, then 4 more: the run wraps after 4 samples */
+    adc_poll(&adc, 4);
+    TEST_ASSERT_EQUAL_INT(12, adc_peek(&adc, &p));
+    TEST_ASSERT(p == adc.ring);
+    adc_release(&adc, 12);
+    adc_poll(&adc, 4);
+
+    TEST_ASSERT_EQUAL_INT(4, adc_peek(&adc, &p));
+    TEST_ASSERT(p == adc.ring + 12);
+    TEST_ASSERT_EQUAL_INT(4, p[0].seq);
+    adc_release(&adc, 4);
+
+    TEST_ASSERT_EQUAL_INT(8, adc_peek(&adc, &p));
+    TEST_ASSERT(p == adc.ring);
+    TEST_ASSERT_EQUAL_INT(1, p[0].channel);
+    TEST_ASSERT_EQUAL_INT(7, p[7].seq);
+
+    adc_release(&adc, 100);
+    TEST_ASSERT_EQUAL_INT(0, adc_available(&adc));
+    adc_close(&adc);
+}
+
+void test_overruns_skip_whole_scans(void) {
+    adc_t adc;
+    TEST_ASSERT_EQUAL_INT(0, adc_open_sim(&adc, ADC_MCP3008, 8, NULL, NULL));
+    const int chans[] = { 0, 5, 6 };
+    TEST_ASSERT_EQUAL_INT(0, adc_set_channels(&adc, chans, 3));
+    spi_sim_t* sim = adc.spi->sim;
+
+    /* Room for two whole scans of three; the third and fourth are skipped */
+    TEST_ASSERT_EQUAL_INT(6, adc_poll(&adc, 4));
+    TEST_ASSERT_EQUAL_UINT64(18, sim->bytes);
+    adc_stats_t st;
+    adc_get_stats(&adc, &st);
+    TEST_ASSERT_EQUAL_UINT64(6, st.overruns);
+
+    /* Consumer catches up: scan numbers show the gap */
+    adc_release(&adc, 6);
+    TEST_ASSERT_EQUAL_INT(3, adc_poll(&adc, 1));
+    adc_sample_t s[3];
+    TEST_ASSERT_EQUAL_INT(3, adc_read(&adc, s, 3));
+    TEST_ASSERT_EQUAL_INT(4, s[0].seq);
+    TEST_ASSERT_EQUAL_INT(adc_sim_ramp(ADC_MCP3008, 5, 2), s[1].value);
+    adc_close(&adc);
+}
+
+/* ============================================================================
+ * SAMPLER THREAD
+ * ============================================================================ */
+
+void test_sampler_paced(void) {
+    adc_t adc;
+    TEST_ASSERT_EQUAL_INT(0, adc_open_sim(&adc, ADC_MCP3008, 4096, NULL, NULL));
+    const int chans[] = { 2, 4 };
+    TEST_ASSERT_EQUAL_INT(0, adc_set_channels(&adc, chans, 2));
+
+    TEST_ASSERT_EQUAL_INT(0, adc_start(&adc, 2000.0, -1));
+    TEST_ASSERT_EQUAL_INT(-1, adc_start(&adc, 2000.0, -1));
+    TEST_ASSERT_EQUAL_INT(-1, adc_set_channels(&adc, chans, 1));
+    TEST_ASSERT_EQUAL_INT(0, adc_poll(&adc, 1));
+    TEST_ASSERT_GREATER_OR_EQUAL(40, adc_wait(&adc, 40, 1000000));
+    usleep(50000);
+    adc_stop(&adc);
+    TEST_ASSERT_EQUAL_INT(0, adc.realtime);  /* Unpinned samplers stay normal */
+
+    adc_stats_t st;
+    adc_get_stats(&adc, &st);
+    TEST_ASSERT_GREATER_OR_EQUAL(60, st.scans);
+    TEST_ASSERT_EQUAL_UINT64(st.scans * 2, st.samples);
+    TEST_ASSERT_EQUAL_UINT64(0, st.overruns);
+    TEST_ASSERT_WITHIN(400.0, 2000.0, adc_scan_rate(&adc));
+
+    /* Every stored scan is whole; values follow each channel's ramp */
+    size_t n = 0;
+    uint32_t last_seq = 0;
+    const adc_sample_t* p;
+    size_t run;
+    while ((run = adc_peek(&adc, &p)) > 0) {
+        for (size_t i = 0; i < run; i++, n++) {
+            TEST_ASSERT_EQUAL_INT(chans[n % 2], p[i].channel);
+            TEST_ASSERT_EQUAL_INT(adc_sim_ramp(ADC_MCP3008, chans[n % 2], n / 2), p[i].value);
+            if (n % 2 == 0 && n) TEST_ASSERT_GREATER_THAN(last_seq, p[i].seq);
+            last_seq = p[i].seq;
+        }
+        adc_release(&adc, run);
+    }
+    TEST_ASSERT_EQUAL_UINT64(st.samples, n);
+    TEST_ASSERT_EQUAL_UINT64(st.scans + st.missed, (uint64_t)last_seq + 1);
+    adc_close(&adc);
+}
+
+void test_start_rejects_bad_rate(void) {
+    adc_t adc;
+    TEST_ASSERT_EQUAL_INT(0, adc_open_sim(&adc, ADC_MCP3008, 0, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, adc_start(&adc, 0.0, -1));
+    TEST_ASSERT_EQUAL_INT(-1, adc_start(&adc, -5.0, -1));
+    TEST_ASSERT_FALSE(adc.running);
+    adc_close(&adc);
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Framing
+    RUN_TEST(test_frames_per_chip);
+    RUN_TEST(test_open_unavailable_on_host);
+
+    // Conversions
+    RUN_TEST(test_scan_values_and_order);
+    RUN_TEST(test_twelve_bit_chips);
+
+    // Consumer
+    RUN_TEST(test_peek_is_zero_copy_across_wrap);
+    RUN_TEST(test_overruns_skip_whole_scans);
+
+    // Sampler thread
+    RUN_TEST(test_sampler_paced);
+    RUN_TEST(test_start_rejects_bad_rate);
+
+    return UNITY_END();
+}
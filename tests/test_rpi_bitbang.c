@@ -0,0 +1,290 @@
+/*
+ * test_rpi_bitbang.c - Validation tests for rpi_bitbang.h
+ *
+ * These tests play schedules against the GPIO simulator backend and record
+ * every level change with its CLOCK_MONOTONIC timestamp.
+ * Focus: ring accounting, ordering, deadlines, bank-1 masks, streaming
+ * from a producer thread, stop during long waits.
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_BITBANG_IMPLEMENTATION
+#include "rpi_bitbang.h"
+
+/* ============================================================================
+ * LEVEL RECORDER
+ * ============================================================================ */
+
+#define REC_MAX 4096
+
+typedef struct {
+    uint64_t t_ns[REC_MAX];
+    uint64_t levels[REC_MAX];
+    int count;
+} recorder_t;
+
+static recorder_t rec;
+
+static void record_observer(void* user, uint64_t prev, uint64_t levels) {
+    (void)user;
+    (void)prev;
+    if (rec.count < REC_MAX) {
+        rec.t_ns[rec.count] = bitbang_now_ns();
+        rec.levels[rec.count] = levels;
+        rec.count++;
+    }
+}
+
+static void setup_sim(gpio_ctx_t* ctx, uint64_t outputs) {
+    gpio_ctx_init(ctx, GPIO_BACKEND_SIM);
+    for (int pin = 0; pin <= GPIO_PIN_MAX; pin++) {
+        if (outputs & (1ull << pin)) gpio_ctx_pin_mode(ctx, pin, OUTPUT);
+    }
+    memset(&rec, 0, sizeof(rec));
+    gpio_ctx_sim_set_observer(ctx, record_observer, NULL);
+}
+
+/* Alternating pulses on pin 5: even entries set, odd entries clear */
+static void make_pulses(bitbang_entry_t* e, int n, uint64_t step_ns) {
+    for (int i = 0; i < n; i++) {
+        e[i].set_mask = (i % 2) ? 0 : (1ull << 5);
+        e[i].clr_mask = (i % 2) ? (1ull << 5) : 0;
+        e[i].t_ns = (uint64_t)i * step_ns;
+    }
+}
+
+/* ============================================================================
+ * RING TESTS
+ * ============================================================================ */
+
+void test_init_rounds_capacity(void) {
+    bitbang_t bb;
+    TEST_ASSERT_EQUAL_INT(0, bitbang_init(&bb, NULL, 100));
+    TEST_ASSERT_EQUAL_UINT64(128, bb.capacity);
+    TEST_ASSERT_EQUAL_UINT64(128, bitbang_space(&bb));
+    TEST_ASSERT_EQUAL_UINT64(0, bitbang_pending(&bb));
+    TEST_ASSERT(&gpio_ctx_default == bb.gpio);
+    TEST_ASSERT_EQUAL_UINT64(0, (uintptr_t)bb.t_ns % 64);
+    bitbang_free(&bb);
+
+    TEST_ASSERT_EQUAL_INT(0, bitbang_init(&bb, NULL, 0));
+    TEST_ASSERT_EQUAL_UINT64(BITBANG_CAPACITY_DEFAULT, bb.capacity);
+    bitbang_free(&bb);
+
+    TEST_ASSERT_EQUAL_INT(-1, bitbang_init(NULL, NULL, 16));
+}
+
+void test_append_never_exceeds_capacity(void) {
+    bitbang_t bb;
+    bitbang_entry_t e[40];
+    make_pulses(e, 40, 1000);
+    bitbang_init(&bb, NULL, 32);
+
+    TEST_ASSERT_EQUAL_UINT64(32, bitbang_append(&bb, e, 40));
+    TEST_ASSERT_EQUAL_UINT64(0, bitbang_space(&bb));
+    TEST_ASSERT_EQUAL_UINT64(32, bitbang_pending(&bb));
+    TEST_ASSERT_EQUAL_UINT64(0, bitbang_append(&bb, e, 1));
+    TEST_ASSERT_EQUAL_UINT64(0, bitbang_append(&bb, NULL, 1));
+
+    /* Stored as separate arrays */
+    TEST_ASSERT_EQUAL_UINT64(3000, bb.t_ns[3]);
+    TEST_ASSERT_EQUAL_UINT64(1ull << 5, bb.clr_mask[3]);
+    TEST_ASSERT_EQUAL_UINT64(0, bb.set_mask[3]);
+
+    TEST_ASSERT_EQUAL_INT(-1, bitbang_wait(&bb, 1000));  /* Nobody plays */
+    bitbang_free(&bb);
+}
+
+/* ============================================================================
+ * PLAYBACK TESTS
+ * ============================================================================ */
+
+void test_run_plays_in_order_on_deadline(void) {
+    gpio_ctx_t ctx;
+    bitbang_t bb;
+    bitbang_entry_t e[20];
+    setup_sim(&ctx, 1ull << 5);
+    make_pulses(e, 20, 20000);
+    bitbang_init(&bb, &ctx, 64);
+    bitbang_append(&bb, e, 20);
+
+    TEST_ASSERT_EQUAL_UINT64(20, bitbang_run(&bb));
+    TEST_ASSERT_EQUAL_UINT64(0, bitbang_pending(&bb));
+    TEST_ASSERT_EQUAL_UINT64(20, bb.stats.played);
+
+    TEST_ASSERT_EQUAL_INT(20, rec.count);
+    for (int i = 0; i < rec.count; i++) {
+        TEST_ASSERT_EQUAL_UINT64((i % 2) ? 0 : (1ull << 5), rec.levels[i]);
+        /* Never early */
+        TEST_ASSERT(rec.t_ns[i] >= bb.epoch_ns + e[i].t_ns);
+    }
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_ctx_read_all(&ctx));
+
+    bitbang_free(&bb);
+    gpio_ctx_cleanup(&ctx);
+}
+
+void test_masks_cover_both_banks(void) {
+    gpio_ctx_t ctx;
+    bitbang_t bb;
+    uint64_t pins = (1ull << 3) | (1ull << 40);
+    setup_sim(&ctx, pins);
+    bitbang_init(&bb, &ctx, 8);
+
+    bitbang_entry_t e[3] = {
+        { pins, 0, 0 },
+        { 0, 1ull << 3, 1000 },
+        { 1ull << 3, 1ull << 40, 2000 },
+    };
+    bitbang_append(&bb, e, 3);
+    uint64_t writes = ctx.stats.writes;
+    bitbang_run(&bb);
+
+    /* The simulator reports each bank store: entries 0 and 2 touch both */
+    TEST_ASSERT_EQUAL_INT(5, rec.count);
+    TEST_ASSERT_EQUAL_UINT64(pins, rec.levels[1]);
+    TEST_ASSERT_EQUAL_UINT64(1ull << 40, rec.levels[2]);
+    TEST_ASSERT_EQUAL_UINT64(1ull << 3, gpio_ctx_read_all(&ctx));
+
+    /* One write per entry, whatever the number of banks */
+    TEST_ASSERT_EQUAL_UINT64(3, ctx.stats.writes - writes);
+
+    bitbang_free(&bb);
+    gpio_ctx_cleanup(&ctx);
+}
+
+void test_late_entries_are_counted(void) {
+    gpio_ctx_t ctx;
+    bitbang_t bb;
+    bitbang_entry_t e[8];
+    setup_sim(&ctx, 1ull << 5);
+    make_pulses(e, 8, 100);
+    bitbang_init(&bb, &ctx, 8);
+    bitbang_append(&bb, e, 8);
+
+    /* Playback "started" 1 ms ago: every deadline has passed */
+    bb.epoch_ns = bitbang_now_ns() - 1000000;
+    bitbang_run(&bb);
+
+    TEST_ASSERT_EQUAL_UINT64(8, bb.stats.played);
+    TEST_ASSERT_EQUAL_UINT64(8, bb.stats.late);
+    TEST_ASSERT(bb.stats.max_late_ns >= 1000000 - 700);
+    TEST_ASSERT(bb.stats.total_late_ns >= 8 * (1000000 - 700));
+
+    bitbang_free(&bb);
+    gpio_ctx_cleanup(&ctx);
+}
+
+void test_spin_until_never_returns_early(void) {
+    uint64_t deadline = bitbang_now_ns() + 200000;
+    uint64_t end = bitbang_spin_until(deadline);
+    TEST_ASSERT(end >= deadline);
+    TEST_ASSERT(bitbang_now_ns() >= deadline);
+
+    /* Past deadline returns at once */
+    TEST_ASSERT(bitbang_spin_until(0) > 0);
+}
+
+/* ============================================================================
+ * PLAYER THREAD TESTS
+ * ============================================================================ */
+
+void test_thread_streams_more_than_capacity(void) {
+    gpio_ctx_t ctx;
+    bitbang_t bb;
+    enum { TOTAL = 2000 };
+    static bitbang_entry_t e[TOTAL];
+    setup_sim(&ctx, 1ull << 5);
+    make_pulses(e, TOTAL, 5000);
+    bitbang_init(&bb, &ctx, 64);
+
+    TEST_ASSERT_EQUAL_UINT64(0, bitbang_elapsed_ns(&bb));
+    TEST_ASSERT_EQUAL_INT(0, bitbang_start(&bb, -1, 0));
+    TEST_ASSERT_EQUAL_INT(-1, bitbang_start(&bb, -1, 0));
+
+    /* Producer keeps the ring topped up while the player drains it */
+    size_t sent = 0;
+    uint64_t give_up = bitbang_now_ns() + 5000000000ull;
+    while (sent < TOTAL && bitbang_now_ns() < give_up) {
+        sent += bitbang_append(&bb, e + sent, TOTAL - sent);
+        usleep(20);
+    }
+    TEST_ASSERT_EQUAL_UINT64(TOTAL, sent);
+    TEST_ASSERT_EQUAL_INT(0, bitbang_wait(&bb, 5000000));
+    TEST_ASSERT(bitbang_elapsed_ns(&bb) >= (TOTAL - 1) * 5000ull);
+    bitbang_stop(&bb);
+
+    TEST_ASSERT_EQUAL_UINT64(TOTAL, bb.stats.played);
+    TEST_ASSERT_EQUAL_INT(TOTAL, rec.count);
+    int ordered = 1;
+    for (int i = 1; i < rec.count; i++) {
+        if (rec.levels[i] == rec.levels[i - 1] || rec.t_ns[i] < bb.epoch_ns + e[i].t_ns) ordered = 0;
+    }
+    TEST_ASSERT_TRUE(ordered);
+
+    bitbang_free(&bb);
+    gpio_ctx_cleanup(&ctx);
+}
+
+void test_stop_interrupts_long_wait(void) {
+    gpio_ctx_t ctx;
+    bitbang_t bb;
+    setup_sim(&ctx, 1ull << 5);
+    bitbang_init(&bb, &ctx, 8);
+
+    bitbang_entry_t e[2] = {
+        { 1ull << 5, 0, 0 },
+        { 0, 1ull << 5, 10000000000ull },  /* 10 s away */
+    };
+    bitbang_append(&bb, e, 2);
+    bitbang_start(&bb, -1, 0);
+    usleep(5000);
+
+    uint64_t t0 = bitbang_now_ns();
+    bitbang_stop(&bb);
+    TEST_ASSERT(bitbang_now_ns() - t0 < 100000000ull);
+
+    /* The pending entry stays queued */
+    TEST_ASSERT_EQUAL_UINT64(1, bb.stats.played);
+    TEST_ASSERT_EQUAL_UINT64(1, bitbang_pending(&bb));
+    TEST_ASSERT_EQUAL_UINT64(1ull << 5, gpio_ctx_read_all(&ctx));
+
+    bitbang_stop(&bb);  /* Second stop is a no-op */
+    bitbang_free(&bb);
+    gpio_ctx_cleanup(&ctx);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Ring tests
+    RUN_TEST(test_init_rounds_capacity);
+    RUN_TEST(test_append_never_exceeds_capacity);
+
+    // Playback tests
+    RUN_TEST(test_run_plays_in_order_on_deadline);
+    RUN_TEST(test_masks_cover_both_banks);
+    RUN_TEST(test_late_entries_are_counted);
+    RUN_TEST(test_spin_until_never_returns_early);
+
+    // Player thread tests
+    RUN_TEST(test_thread_streams_more_than_capacity);
+    RUN_TEST(test_stop_interrupts_long_wait);
+
+    return UNITY_END();
+}
@@ -0,0 +1,195 @@
+/*
+ * test_rpi_debounce.c - Validation tests for rpi_debounce.h
+ *
+ * Pure logic tests: snapshots are fed by hand and compared against a
+ * straightforward per-pin counter model.
+ * Focus: bounce rejection, exact stable counts, pin groups, all 64 bits.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity_mini.h"
+
+#define RPI_DEBOUNCE_IMPLEMENTATION
+#include "rpi_debounce.h"
+
+#define PIN_A 4
+#define PIN_B 40
+#define BIT(p) (1ull << (p))
+
+/* Reference: one counter per pin */
+typedef struct {
+    uint64_t state;
+    int count[64];
+    int stable[64];
+} ref_debounce_t;
+
+static uint64_t ref_update(ref_debounce_t* r, uint64_t sample) {
+    uint64_t changed = 0;
+    for (int pin = 0; pin < 64; pin++) {
+        int raw = (sample >> pin) & 1;
+        int cur = (r->state >> pin) & 1;
+        if (raw == cur) {
+            r->count[pin] = 0;
+        } else if (++r->count[pin] >= r->stable[pin]) {
+            r->count[pin] = 0;
+            changed |= BIT(pin);
+        }
+    }
+    r->state ^= changed;
+    return changed;
+}
+
+/* ============================================================================
+ * BASIC TESTS
+ * ============================================================================ */
+
+void test_init_validates_count(void) {
+    debounce_t db;
+    TEST_ASSERT_EQUAL_INT(-1, debounce_init(&db, 0, 0));
+    TEST_ASSERT_EQUAL_INT(-1, debounce_init(&db, 0, DEBOUNCE_MAX_COUNT + 1));
+    TEST_ASSERT_EQUAL_INT(-1, debounce_init(NULL, 0, 3));
+
+    TEST_ASSERT_EQUAL_INT(0, debounce_init(&db, BIT(PIN_A), 5));
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_A), db.state);
+    TEST_ASSERT_EQUAL_INT(3, db.bits);  /* 5 = 0b101 */
+    TEST_ASSERT_EQUAL_INT(5, debounce_pin_count(&db, PIN_B));
+
+    TEST_ASSERT_EQUAL_INT(0, debounce_init(&db, 0, DEBOUNCE_MAX_COUNT));
+    TEST_ASSERT_EQUAL_INT(DEBOUNCE_MAX_BITS, db.bits);
+}
+
+void test_change_accepted_after_stable_count(void) {
+    debounce_t db;
+    debounce_init(&db, 0, 4);
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_UINT64(0, debounce_update(&db, BIT(PIN_A)));
+    }
+    uint64_t changed = debounce_update(&db, BIT(PIN_A));
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_A), changed);
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_A), debounce_rising(&db, changed));
+    TEST_ASSERT_EQUAL_UINT64(0, debounce_falling(&db, changed));
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_A), db.state);
+
+    /* Reported once */
+    TEST_ASSERT_EQUAL_UINT64(0, debounce_update(&db, BIT(PIN_A)));
+}
+
+void test_bounce_is_rejected(void) {
+    debounce_t db;
+    debounce_init(&db, 0, 3);
+
+    /* Two high samples, then a glitch back low restarts the count */
+    uint64_t seq[] = { BIT(PIN_A), BIT(PIN_A), 0, BIT(PIN_A), BIT(PIN_A) };
+    for (size_t i = 0; i < sizeof(seq) / sizeof(seq[0]); i++) {
+        TEST_ASSERT_EQUAL_UINT64(0, debounce_update(&db, seq[i]));
+    }
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_A), debounce_update(&db, BIT(PIN_A)));
+
+    /* Falling edge the same way */
+    debounce_update(&db, 0);
+    debounce_update(&db, 0);
+    uint64_t changed = debounce_update(&db, 0);
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_A), debounce_falling(&db, changed));
+}
+
+void test_count_one_passes_through(void) {
+    debounce_t db;
+    debounce_init(&db, 0, 1);
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_A) | BIT(PIN_B), debounce_update(&db, BIT(PIN_A) | BIT(PIN_B)));
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_B), debounce_update(&db, BIT(PIN_A)));
+}
+
+/* ============================================================================
+ * GROUP TESTS
+ * ============================================================================ */
+
+void test_groups_have_own_counts(void) {
+    debounce_t db;
+    debounce_init(&db, 0, 2);
+    int g = debounce_set_group(&db, BIT(PIN_B), 6);
+    TEST_ASSERT_EQUAL_INT(1, g);
+    TEST_ASSERT_EQUAL_INT(6, debounce_pin_count(&db, PIN_B));
+    TEST_ASSERT_EQUAL_INT(2, debounce_pin_count(&db, PIN_A));
+
+    uint64_t both = BIT(PIN_A) | BIT(PIN_B);
+    TEST_ASSERT_EQUAL_UINT64(0, debounce_update(&db, both));
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_A), debounce_update(&db, both));
+    for (int i = 0; i < 3; i++) TEST_ASSERT_EQUAL_UINT64(0, debounce_update(&db, both));
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_B), debounce_update(&db, both));
+}
+
+void test_group_reuse_and_limit(void) {
+    debounce_t db;
+    debounce_init(&db, 0, 2);
+
+    /* Same count joins the existing group */
+    TEST_ASSERT_EQUAL_INT(1, debounce_set_group(&db, BIT(1), 9));
+    TEST_ASSERT_EQUAL_INT(1, debounce_set_group(&db, BIT(2), 9));
+    TEST_ASSERT_EQUAL_UINT64(BIT(1) | BIT(2), db.group_mask[1]);
+
+    /* Moving every pin of a group out frees it for reuse */
+    TEST_ASSERT_EQUAL_INT(1, debounce_set_group(&db, BIT(1) | BIT(2), 11));
+    TEST_ASSERT_EQUAL_INT(11, debounce_pin_count(&db, 2));
+
+    for (int i = 2; i < DEBOUNCE_MAX_GROUPS; i++) {
+        TEST_ASSERT_EQUAL_INT(i, debounce_set_group(&db, BIT(10 + i), 20 + i));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, debounce_set_group(&db, BIT(30), 99));
+    TEST_ASSERT_EQUAL_INT(-1, debounce_set_group(&db, BIT(30), 0));
+}
+
+/* ============================================================================
+ * MODEL COMPARISON
+ * ============================================================================ */
+
+void test_matches_per_pin_model(void) {
+    debounce_t db;
+    ref_debounce_t ref;
+    memset(&ref, 0, sizeof(ref));
+    debounce_init(&db, 0, 3);
+    debounce_set_group(&db, 0x00000000FFFF0000ull, 7);
+    debounce_set_group(&db, 0xFFFF000000000000ull, 1);
+    debounce_set_group(&db, 0x0000FFFF00000000ull, 200);
+    for (int pin = 0; pin < 64; pin++) ref.stable[pin] = debounce_pin_count(&db, pin);
+
+    /* Slowly drifting levels with random bounce on top */
+    uint32_t x = 12345;
+    uint64_t level = 0;
+    int mismatches = 0;
+    for (int tick = 0; tick < 20000; tick++) {
+        x = x * 1103515245u + 12345u;
+        if ((x >> 24) < 8) level ^= BIT((x >> 8) & 63);
+        x = x * 1103515245u + 12345u;
+        uint64_t noise = ((uint64_t)x << 32 | (x >> 3)) & ((uint64_t)x * 0x9E3779B97F4A7C15ull);
+        uint64_t sample = level ^ (noise & ((tick % 4) ? 0 : ~0ull));
+
+        uint64_t a = debounce_update(&db, sample);
+        uint64_t b = ref_update(&ref, sample);
+        if (a != b || db.state != ref.state) mismatches++;
+    }
+    TEST_ASSERT_EQUAL_INT(0, mismatches);
+    TEST_ASSERT(db.state != 0);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Basic tests
+    RUN_TEST(test_init_validates_count);
+    RUN_TEST(test_change_accepted_after_stable_count);
+    RUN_TEST(test_bounce_is_rejected);
+    RUN_TEST(test_count_one_passes_through);
+
+    // Group tests
+    RUN_TEST(test_groups_have_own_counts);
+    RUN_TEST(test_group_reuse_and_limit);
+
+    // Model comparison
+    RUN_TEST(test_matches_per_pin_model);
+
+    return UNITY_END();
+}
@@ -0,0 +1,293 @@
+/*
+ * test_rpi_dma.c - Validation tests for rpi_dma.h
+ *
+ * These tests run control-block chains on the host DMA simulator.
+ * Focus: DMA memory and bus addresses, chain execution, DREQ pacing
+ * in virtual time, restart and error handling.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+/* ============================================================================
+ * TEST DEVICE
+ * ============================================================================ */
+
+/* A paced sink on PERIPH_SPI0: accepts one word every period_ns. */
+typedef struct {
+    uint32_t regs[PERIPH_BLOCK_SIZE / 4];
+    uint32_t received[64];
+    uint64_t times[64];
+    int count;
+    int ready;
+    uint64_t period_ns;
+    uint64_t next_ns;
+    uint64_t now_ns;
+} sink_t;
+
+static int sink_dreq(void* user, int dreq) {
+    sink_t* s = (sink_t*)user;
+    return dreq == DMA_DREQ_SPI_TX && s->ready;
+}
+
+static void sink_write(void* user, uint32_t reg, uint32_t value) {
+    sink_t* s = (sink_t*)user;
+    if (reg == 1 && s->count < 64) {
+        s->received[s->count] = value;
+        s->times[s->count++] = s->now_ns;
+        s->ready = 0;
+        s->next_ns = s->now_ns + s->period_ns;
+    } else {
+        s->regs[reg] = value;
+    }
+}
+
+static uint64_t sink_advance(void* user, uint64_t now_ns) {
+    sink_t* s = (sink_t*)user;
+    s->now_ns = now_ns;
+    if (!s->ready && now_ns >= s->next_ns) s->ready = 1;
+    return s->ready ? UINT64_MAX : s->next_ns;
+}
+
+static void sink_attach(dma_sim_t* sim, sink_t* s, uint64_t period_ns) {
+    memset(s, 0, sizeof(*s));
+    s->ready = 1;
+    s->period_ns = period_ns;
+    dma_sim_dev_t dev = {0};
+    dev.block = PERIPH_SPI0;
+    dev.regs = s->regs;
+    dev.dreqs = 1u << DMA_DREQ_SPI_TX;
+    dev.dreq = sink_dreq;
+    dev.write = sink_write;
+    dev.advance = sink_advance;
+    dev.user = s;
+    TEST_ASSERT_EQUAL_INT(0, dma_sim_add_device(sim, &dev));
+}
+
+/* ============================================================================
+ * MEMORY TESTS
+ * ============================================================================ */
+
+void test_mem_alloc_rounds_and_zeroes(void) {
+    dma_mem_t mem;
+    TEST_ASSERT_EQUAL_INT(0, dma_mem_alloc(&mem, 100));
+    TEST_ASSERT_NOT_NULL(mem.virt);
+    TEST_ASSERT_EQUAL_UINT64(4096, mem.size);
+    TEST_ASSERT_EQUAL_UINT64(0, ((uint8_t*)mem.virt)[4095]);
+    TEST_ASSERT_EQUAL_UINT64(0, mem.bus & 0xFFF);
+    dma_mem_free(&mem);
+    TEST_ASSERT_NULL(mem.virt);
+    TEST_ASSERT_EQUAL_INT(-1, dma_mem_alloc(&mem, 0));
+}
+
+void test_mem_bus_round_trip(void) {
+    dma_mem_t a, b;
+    TEST_ASSERT_EQUAL_INT(0, dma_mem_alloc(&a, 8192));
+    TEST_ASSERT_EQUAL_INT(0, dma_mem_alloc(&b, 4096));
+    TEST_ASSERT_TRUE(a.bus != b.bus);
+
+    uint32_t* p = (uint32_t*)a.virt + 1500;
+    uint32_t bus = dma_mem_bus(&a, p);
+    TEST_ASSERT_EQUAL_UINT64(a.bus + 6000, bus);
+    TEST_ASSERT_TRUE(dma_mem_virt(bus) == (void*)p);
+    TEST_ASSERT_TRUE(dma_mem_virt(b.bus) == b.virt);
+    TEST_ASSERT_NULL(dma_mem_virt(b.bus + 4096 * 16));
+
+    uint32_t freed = b.bus;
+    dma_mem_free(&b);
+    TEST_ASSERT_NULL(dma_mem_virt(freed));
+    dma_mem_free(&a);
+}
+
+void test_periph_bus_addresses(void) {
+    TEST_ASSERT_EQUAL_UINT64(0x7E20C018u, dma_periph_bus(PERIPH_PWM, 6));
+    TEST_ASSERT_EQUAL_UINT64(0x7E20001Cu, dma_periph_bus(PERIPH_GPIO, 7));
+}
+
+/* ============================================================================
+ * CHANNEL AND SIMULATOR TESTS
+ * ============================================================================ */
+
+void test_chan_attach_enables_channel(void) {
+    static dma_sim_t sim;
+    dma_chan_t ch;
+    dma_sim_init(&sim);
+    TEST_ASSERT_EQUAL_INT(0, dma_chan_attach(&ch, sim.regs, 5));
+    TEST_ASSERT_TRUE(ch.regs == sim.regs + 5 * DMA_CHAN_WORDS);
+    TEST_ASSERT_EQUAL_UINT64(1u << 5, sim.regs[DMA_ENABLE]);
+    TEST_ASSERT_EQUAL_INT(-1, dma_chan_attach(&ch, sim.regs, DMA_CHANNEL_COUNT));
+    TEST_ASSERT_EQUAL_INT(-1, dma_chan_attach(&ch, NULL, 5));
+}
+
+void test_sim_memory_copy_chain(void) {
+    static dma_sim_t sim;
+    dma_chan_t ch;
+    dma_mem_t mem;
+    dma_sim_init(&sim);
+    dma_chan_attach(&ch, sim.regs, 3);
+    TEST_ASSERT_EQUAL_INT(0, dma_mem_alloc(&mem, 4096));
+
+    dma_cb_t* cb = (dma_cb_t*)mem.virt;
+    uint32_t* src = (uint32_t*)((uint8_t*)mem.virt + 1024);
+    uint32_t* dst = (uint32_t*)((uint8_t*)mem.virt + 2048);
+    for (int i = 0; i < 8; i++) src[i] = 0x100 + i;
+
+    cb[0].ti = DMA_TI_SRC_INC | DMA_TI_DEST_INC;
+    cb[0].source_ad = dma_mem_bus(&mem, src);
+    cb[0].dest_ad = dma_mem_bus(&mem, dst);
+    cb[0].txfr_len = 16;
+    cb[0].nextconbk = dma_mem_bus(&mem, &cb[1]);
+    cb[1] = cb[0];
+    cb[1].source_ad = dma_mem_bus(&mem, src + 4);
+    cb[1].dest_ad = dma_mem_bus(&mem, dst + 4);
+    cb[1].nextconbk = 0;
+
+    dma_chan_start(&ch, dma_mem_bus(&mem, cb));
+    TEST_ASSERT_TRUE(dma_chan_active(&ch));
+    TEST_ASSERT_EQUAL_UINT64(8, dma_sim_run(&sim, 10000));
+
+    for (int i = 0; i < 8; i++) TEST_ASSERT_EQUAL_UINT64(0x100u + i, dst[i]);
+    TEST_ASSERT_EQUAL_UINT64(2, sim.cbs);
+    TEST_ASSERT_FALSE(dma_chan_active(&ch));
+    TEST_ASSERT_TRUE(ch.regs[DMA_CS] & DMA_CS_END);
+    TEST_ASSERT_EQUAL_UINT64(0, dma_chan_cb(&ch));
+    dma_mem_free(&mem);
+}
+
+void test_sim_dreq_paces_transfers(void) {
+    static dma_sim_t sim;
+    static sink_t sink;
+    dma_chan_t ch;
+    dma_mem_t mem;
+    dma_sim_init(&sim);
+    sink_attach(&sim, &sink, 1000);
+    dma_chan_attach(&ch, sim.regs, 4);
+    TEST_ASSERT_EQUAL_INT(0, dma_mem_alloc(&mem, 4096));
+
+    dma_cb_t* cb = (dma_cb_t*)mem.virt;
+    uint32_t* src = (uint32_t*)((uint8_t*)mem.virt + 1024);
+    for (int i = 0; i < 10; i++) src[i] = i * 3;
+    cb->ti = DMA_TI_SRC_INC | DMA_TI_DEST_DREQ | DMA_TI_PERMAP(DMA_DREQ_SPI_TX);
+    cb->source_ad = dma_mem_bus(&mem, src);
+    cb->dest_ad = dma_periph_bus(PERIPH_SPI0, 1);
+    cb->txfr_len = 40;
+
+    dma_chan_start(&ch, dma_mem_bus(&mem, cb));
+    dma_sim_run(&sim, 4500);  /* Words at 0, 1000, 2000, 3000, 4000 */
+    TEST_ASSERT_EQUAL_INT(5, sink.count);
+    TEST_ASSERT_TRUE(dma_chan_active(&ch));
+
+    dma_sim_run(&sim, 10000);
+    TEST_ASSERT_EQUAL_INT(10, sink.count);
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_UINT64((uint32_t)i * 3, sink.received[i]);
+        TEST_ASSERT_EQUAL_UINT64((uint64_t)i * 1000, sink.times[i]);
+    }
+    TEST_ASSERT_FALSE(dma_chan_active(&ch));
+    TEST_ASSERT_EQUAL_UINT64(14500, sim.now_ns);
+    dma_mem_free(&mem);
+}
+
+void test_sim_looping_chain_and_restart(void) {
+    static dma_sim_t sim;
+    dma_chan_t ch;
+    dma_mem_t mem;
+    dma_sim_init(&sim);
+    dma_chan_attach(&ch, sim.regs, 0);
+    TEST_ASSERT_EQUAL_INT(0, dma_mem_alloc(&mem, 4096));
+
+    dma_cb_t* cb = (dma_cb_t*)mem.virt;
+    uint32_t* word = (uint32_t*)((uint8_t*)mem.virt + 1024);
+    cb->ti = 0;
+    cb->source_ad = dma_mem_bus(&mem, word);
+    cb->dest_ad = dma_mem_bus(&mem, word + 1);
+    cb->txfr_len = 4;
+    cb->nextconbk = dma_mem_bus(&mem, cb);  /* Loops on itself */
+
+    dma_chan_start(&ch, dma_mem_bus(&mem, cb));
+    dma_sim_run(&sim, 100 * DMA_SIM_WORD_NS);
+    TEST_ASSERT_EQUAL_UINT64(100, sim.words);
+    TEST_ASSERT_TRUE(dma_chan_active(&ch));
+    TEST_ASSERT_EQUAL_UINT64(dma_mem_bus(&mem, cb), dma_chan_cb(&ch));
+
+    dma_chan_stop(&ch);
+    dma_sim_run(&sim, 1000);
+    TEST_ASSERT_EQUAL_UINT64(100, sim.words);
+
+    /* Restarting at the same block reloads it */
+    *word = 42;
+    dma_chan_start(&ch, dma_mem_bus(&mem, cb));
+    dma_sim_run(&sim, DMA_SIM_WORD_NS);
+    TEST_ASSERT_EQUAL_UINT64(42, word[1]);
+    dma_chan_stop(&ch);
+    dma_mem_free(&mem);
+}
+
+void test_sim_bad_address_sets_error(void) {
+    static dma_sim_t sim;
+    dma_chan_t ch;
+    dma_mem_t mem;
+    dma_sim_init(&sim);
+    dma_chan_attach(&ch, sim.regs, 1);
+    TEST_ASSERT_EQUAL_INT(0, dma_mem_alloc(&mem, 4096));
+
+    dma_cb_t* cb = (dma_cb_t*)mem.virt;
+    cb->ti = 0;
+    cb->source_ad = 0x12345678;
+    cb->dest_ad = dma_mem_bus(&mem, cb + 4);
+    cb->txfr_len = 4;
+
+    dma_chan_start(&ch, dma_mem_bus(&mem, cb));
+    dma_sim_run(&sim, 1000);
+    TEST_ASSERT_TRUE(ch.regs[DMA_CS] & DMA_CS_ERROR);
+    TEST_ASSERT_FALSE(dma_chan_active(&ch));
+    TEST_ASSERT_EQUAL_UINT64(1, sim.errors);
+
+    /* Chain pointing outside DMA memory */
+    dma_chan_start(&ch, 0xDEAD0000);
+    dma_sim_run(&sim, 1000);
+    TEST_ASSERT_EQUAL_UINT64(2, sim.errors);
+    dma_mem_free(&mem);
+}
+
+void test_sim_idle_advances_time(void) {
+    static dma_sim_t sim;
+    dma_sim_init(&sim);
+    TEST_ASSERT_EQUAL_UINT64(0, dma_sim_run(&sim, 1000000));
+    TEST_ASSERT_EQUAL_UINT64(1000000, sim.now_ns);
+}
+
+void test_chan_open_unavailable_on_host(void) {
+    dma_chan_t ch;
+    TEST_ASSERT_EQUAL_INT(-1, dma_chan_open(&ch, DMA_CHANNEL_DEFAULT));
+    TEST_ASSERT_EQUAL_INT(-1, dma_chan_open(&ch, -1));
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Memory
+    RUN_TEST(test_mem_alloc_rounds_and_zeroes);
+    RUN_TEST(test_mem_bus_round_trip);
+    RUN_TEST(test_periph_bus_addresses);
+
+    // Channels and simulator
+    RUN_TEST(test_chan_attach_enables_channel);
+    RUN_TEST(test_sim_memory_copy_chain);
+    RUN_TEST(test_sim_dreq_paces_transfers);
+    RUN_TEST(test_sim_looping_chain_and_restart);
+    RUN_TEST(test_sim_bad_address_sets_error);
+    RUN_TEST(test_sim_idle_advances_time);
+    RUN_TEST(test_chan_open_unavailable_on_host);
+
+    return UNITY_END();
+}
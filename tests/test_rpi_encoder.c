@@ -0,0 +1,184 @@
+/*
+ * test_rpi_encoder.c - Validation tests for rpi_encoder.h
+ *
+ * Quadrature sequences are fed as level snapshots, as edge events and
+ * through the GPIO simulator with the sampler thread running.
+ * Focus: direction, x4 counting, skipped states, independent channels,
+ * velocity windows.
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_ENCODER_IMPLEMENTATION
+#include "rpi_encoder.h"
+
+/* Forward Gray sequence of (A, B) */
+static const int seq_a[4] = { 0, 0, 1, 1 };
+static const int seq_b[4] = { 0, 1, 1, 0 };
+
+static uint64_t ab_levels(int pin_a, int pin_b, int phase) {
+    phase &= 3;
+    return ((uint64_t)seq_a[phase] << pin_a) | ((uint64_t)seq_b[phase] << pin_b);
+}
+
+/* ============================================================================
+ * DECODE TESTS
+ * ============================================================================ */
+
+void test_add_validates_pins(void) {
+    encoder_set_t set;
+    encoder_set_init(&set, NULL, 0);
+    TEST_ASSERT_EQUAL_UINT64(ENCODER_WINDOW_NS_DEFAULT, set.window_ns);
+    TEST_ASSERT_EQUAL_INT(-1, encoder_add(&set, 5, 5));
+    TEST_ASSERT_EQUAL_INT(-1, encoder_add(&set, -1, 5));
+    TEST_ASSERT_EQUAL_INT(-1, encoder_add(&set, 5, 54));
+
+    for (int i = 0; i < ENCODER_MAX; i++) {
+        TEST_ASSERT_EQUAL_INT(i, encoder_add(&set, 2 * i, 2 * i + 1));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, encoder_add(&set, 40, 41));
+    TEST_ASSERT_EQUAL_INT(0, encoder_position(&set, 99));
+}
+
+void test_forward_and_reverse_counts(void) {
+    encoder_set_t set;
+    encoder_set_init(&set, NULL, 0);
+    int e = encoder_add(&set, 17, 27);
+
+    uint64_t t = 0;
+    for (int phase = 0; phase <= 8; phase++) encoder_update(&set, ab_levels(17, 27, phase), t++);
+    TEST_ASSERT_EQUAL_INT(8, encoder_position(&set, e));  /* x4: two full cycles */
+
+    for (int phase = 7; phase >= -4; phase--) encoder_update(&set, ab_levels(17, 27, phase), t++);
+    TEST_ASSERT_EQUAL_INT(-4, encoder_position(&set, e));
+    TEST_ASSERT_EQUAL_UINT64(0, encoder_errors(&set, e));
+    TEST_ASSERT_EQUAL_UINT64(21, set.samples);
+}
+
+void test_skipped_state_is_an_error(void) {
+    encoder_set_t set;
+    encoder_set_init(&set, NULL, 0);
+    int e = encoder_add(&set, 3, 4);
+
+    encoder_update(&set, ab_levels(3, 4, 0), 0);
+    encoder_update(&set, ab_levels(3, 4, 2), 1);  /* 00 -> 11 */
+    TEST_ASSERT_EQUAL_INT(0, encoder_position(&set, e));
+    TEST_ASSERT_EQUAL_UINT64(1, encoder_errors(&set, e));
+
+    /* Decoding continues from the new state */
+    encoder_update(&set, ab_levels(3, 4, 3), 2);
+    TEST_ASSERT_EQUAL_INT(1, encoder_position(&set, e));
+}
+
+void test_channels_are_independent(void) {
+    encoder_set_t set;
+    encoder_set_init(&set, NULL, 0);
+    int e0 = encoder_add(&set, 5, 6);
+    int e1 = encoder_add(&set, 40, 41);  /* Bank 1 */
+
+    /* Noise on other pins is masked out */
+    for (int phase = 0; phase <= 12; phase++) {
+        uint64_t levels = ab_levels(5, 6, phase) | ab_levels(40, 41, -phase) | (phase & 1 ? 1ull << 20 : 0);
+        encoder_update(&set, levels, (uint64_t)phase);
+    }
+    TEST_ASSERT_EQUAL_INT(12, encoder_position(&set, e0));
+    TEST_ASSERT_EQUAL_INT(-12, encoder_position(&set, e1));
+    TEST_ASSERT_EQUAL_UINT64((3ull << 5) | (3ull << 40), set.pin_mask);
+}
+
+void test_edge_events_decode(void) {
+    encoder_set_t set;
+    encoder_set_init(&set, NULL, 0);
+    int e = encoder_add(&set, 22, 23);
+    encoder_update(&set, 0, 0);
+
+    /* B rises, A rises, B falls, A falls: one forward cycle */
+    encoder_edge(&set, 23, 1, 10);
+    encoder_edge(&set, 22, 1, 20);
+    encoder_edge(&set, 23, 0, 30);
+    encoder_edge(&set, 22, 0, 40);
+    TEST_ASSERT_EQUAL_INT(4, encoder_position(&set, e));
+    encoder_edge(&set, 99, 1, 50);  /* Ignored */
+    TEST_ASSERT_EQUAL_INT(4, encoder_position(&set, e));
+}
+
+void test_velocity_over_window(void) {
+    encoder_set_t set;
+    encoder_set_init(&set, NULL, 10000000);  /* 10 ms */
+    int e = encoder_add(&set, 8, 9);
+
+    /* One count per 100 us = 10000 counts/s for 50 ms */
+    for (int i = 0; i <= 500; i++) {
+        encoder_update(&set, ab_levels(8, 9, i), (uint64_t)i * 100000);
+    }
+    TEST_ASSERT_EQUAL_INT(500, encoder_position(&set, e));
+    TEST_ASSERT_WITHIN(1.0, 10000.0, encoder_velocity(&set, e));
+
+    /* Standing still: the next closed window reads zero */
+    for (int i = 1; i <= 110; i++) {
+        encoder_update(&set, ab_levels(8, 9, 500), 50000000 + (uint64_t)i * 100000);
+    }
+    TEST_ASSERT_WITHIN(1.0, 0.0, encoder_velocity(&set, e));
+}
+
+/* ============================================================================
+ * THREAD TESTS
+ * ============================================================================ */
+
+void test_sampler_thread_tracks_simulated_shaft(void) {
+    gpio_ctx_t ctx;
+    encoder_set_t set;
+    gpio_ctx_init(&ctx, GPIO_BACKEND_SIM);
+    encoder_set_init(&set, &ctx, 0);
+    int e = encoder_add(&set, 12, 13);
+
+    TEST_ASSERT_EQUAL_INT(0, encoder_start(&set, -1));
+    TEST_ASSERT_EQUAL_INT(-1, encoder_start(&set, -1));
+    TEST_ASSERT_EQUAL_INT(-1, encoder_add(&set, 14, 15));  /* Not while sampling */
+    usleep(1000);
+
+    for (int phase = 1; phase <= 40; phase++) {
+        gpio_ctx_sim_set_input(&ctx, 12, seq_a[phase & 3]);
+        gpio_ctx_sim_set_input(&ctx, 13, seq_b[phase & 3]);
+        usleep(500);
+    }
+    usleep(1000);
+    TEST_ASSERT_EQUAL_INT(40, encoder_position(&set, e));
+    encoder_stop(&set);
+
+    TEST_ASSERT_EQUAL_UINT64(0, encoder_errors(&set, e));
+    TEST_ASSERT(set.samples > 40);
+    encoder_stop(&set);  /* Second stop is a no-op */
+    gpio_ctx_cleanup(&ctx);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Decode tests
+    RUN_TEST(test_add_validates_pins);
+    RUN_TEST(test_forward_and_reverse_counts);
+    RUN_TEST(test_skipped_state_is_an_error);
+    RUN_TEST(test_channels_are_independent);
+    RUN_TEST(test_edge_events_decode);
+    RUN_TEST(test_velocity_over_window);
+
+    // Thread tests
+    RUN_TEST(test_sampler_thread_tracks_simulated_shaft);
+
+    return UNITY_END();
+}
@@ -8,6 +8,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "unity_mini.h"
 
@@ -342,6 +344,351 @@ void test_constants_pin_range(void) {
     TEST_ASSERT_EQUAL_INT(53, GPIO_PIN_MAX);
 }
 
+/* ============================================================================
+ * BACKEND SELECTION TESTS
+ * ============================================================================ */
+
+void test_backend_default_is_sim_on_host(void) {
+    TEST_ASSERT_EQUAL_INT(0, gpio_init());
+    TEST_ASSERT_EQUAL_INT(GPIO_BACKEND_SIM, gpio_get_backend());
+    TEST_ASSERT_NULL(gpio_ctx_default.regs);
+    gpio_cleanup();
+    TEST_ASSERT_EQUAL_INT(GPIO_BACKEND_NULL, gpio_get_backend());
+}
+
+void test_backend_env_override(void) {
+    setenv("RPI_GPIO_BACKEND", "null", 1);
+    TEST_ASSERT_EQUAL_INT(0, gpio_init());
+    TEST_ASSERT_EQUAL_INT(GPIO_BACKEND_NULL, gpio_get_backend());
+    gpio_cleanup();
+
+    setenv("RPI_GPIO_BACKEND", "bogus", 1);
+    TEST_ASSERT_EQUAL_INT(0, gpio_init());
+    TEST_ASSERT_EQUAL_INT(GPIO_BACKEND_SIM, gpio_get_backend());
+    gpio_cleanup();
+    unsetenv("RPI_GPIO_BACKEND");
+}
+
+void test_backend_unavailable(void) {
+    // gpiochip is only registered when rpi_gpiochip.h is compiled in
+    TEST_ASSERT_EQUAL_INT(-1, gpio_init_backend(GPIO_BACKEND_GPIOCHIP));
+    TEST_ASSERT_EQUAL_INT(-1, gpio_init_backend(GPIO_BACKEND_COUNT));
+    TEST_ASSERT_EQUAL_INT(GPIO_BACKEND_NULL, gpio_get_backend());
+}
+
+void test_backend_mmap_fails_without_device(void) {
+    if (access("/dev/gpiomem", F_OK) == 0) {
+        TEST_PASS();
+        return;
+    }
+    TEST_ASSERT_EQUAL_INT(-1, gpio_init_backend(GPIO_BACKEND_MMAP));
+    TEST_ASSERT_EQUAL_INT(GPIO_BACKEND_NULL, gpio_get_backend());
+    digital_write(18, HIGH);  // Falls back to the null backend
+    TEST_ASSERT_EQUAL_INT(LOW, digital_read(18));
+}
+
+void test_backend_names(void) {
+    TEST_ASSERT_EQUAL_INT(0, strcmp("mmap", gpio_backend_name(GPIO_BACKEND_MMAP)));
+    TEST_ASSERT_EQUAL_INT(0, strcmp("sim", gpio_backend_name(GPIO_BACKEND_SIM)));
+    TEST_ASSERT_EQUAL_INT(0, strcmp("null", gpio_backend_name(GPIO_BACKEND_NULL)));
+    TEST_ASSERT_EQUAL_INT(0, strcmp("auto", gpio_backend_name(GPIO_BACKEND_AUTO)));
+    TEST_ASSERT_EQUAL_INT(0, strcmp("unavailable", gpio_backend_name(GPIO_BACKEND_COUNT)));
+}
+
+void test_backend_null_drops_writes(void) {
+    gpio_init_backend(GPIO_BACKEND_NULL);
+    pin_mode(18, OUTPUT);
+    digital_write(18, HIGH);
+    TEST_ASSERT_EQUAL_INT(LOW, digital_read(18));
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_read_all());
+    gpio_cleanup();
+}
+
+void test_backend_register_rejects_invalid(void) {
+    TEST_ASSERT_EQUAL_INT(-1, gpio_register_backend(GPIO_BACKEND_AUTO, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, gpio_register_backend(GPIO_BACKEND_COUNT, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, gpio_register_backend(GPIO_BACKEND_SIM, NULL));
+}
+
+/* ============================================================================
+ * SIMULATOR TESTS
+ * ============================================================================ */
+
+void test_sim_output_readback(void) {
+    gpio_init_backend(GPIO_BACKEND_SIM);
+    pin_mode(21, OUTPUT);
+    digital_write(21, HIGH);
+    TEST_ASSERT_EQUAL_INT(HIGH, digital_read(21));
+    TEST_ASSERT_EQUAL_INT(HIGH, digital_read_fast(21));
+    digital_write_fast(21, LOW);
+    TEST_ASSERT_EQUAL_INT(LOW, digital_read(21));
+    gpio_cleanup();
+}
+
+void test_sim_input_ignores_output_latch(void) {
+    gpio_init_backend(GPIO_BACKEND_SIM);
+    pin_mode(17, INPUT);
+    digital_write(17, HIGH);
+    TEST_ASSERT_EQUAL_INT(LOW, digital_read(17));
+
+    gpio_sim_set_input(17, HIGH);
+    TEST_ASSERT_EQUAL_INT(HIGH, digital_read(17));
+
+    // Switching to output exposes the latched HIGH
+    gpio_sim_set_input(17, LOW);
+    pin_mode(17, OUTPUT);
+    TEST_ASSERT_EQUAL_INT(HIGH, digital_read(17));
+    gpio_cleanup();
+}
+
+void test_sim_function_select(void) {
+    gpio_init_backend(GPIO_BACKEND_SIM);
+    gpio_set_function(18, ALT5);
+    TEST_ASSERT_EQUAL_INT(ALT5, gpio_sim_get_function(18));
+    pin_mode(18, OUTPUT);
+    TEST_ASSERT_EQUAL_INT(OUTPUT, gpio_sim_get_function(18));
+    TEST_ASSERT_EQUAL_INT(-1, gpio_sim_get_function(54));
+    gpio_cleanup();
+}
+
+void test_sim_write_mask_both_banks(void) {
+    gpio_init_backend(GPIO_BACKEND_SIM);
+    pin_mode(4, OUTPUT);
+    pin_mode(31, OUTPUT);
+    pin_mode(32, OUTPUT);
+    pin_mode(53, OUTPUT);
+
+    uint64_t pins = (1ull << 4) | (1ull << 31) | (1ull << 32) | (1ull << 53);
+    gpio_write_mask(pins, 0);
+    TEST_ASSERT_EQUAL_UINT64(pins, gpio_read_all());
+
+    gpio_write_mask(1ull << 53, 1ull << 4);
+    TEST_ASSERT_EQUAL_UINT64(pins & ~(1ull << 4), gpio_read_all());
+
+    // A pin in both masks ends up HIGH
+    gpio_write_mask(1ull << 4, 1ull << 4);
+    TEST_ASSERT_EQUAL_INT(HIGH, digital_read(4));
+    gpio_cleanup();
+}
+
+void test_fast_write_masks_like_write_mask(void) {
+    // Stand-in register block so the direct-store path runs on the host
+    uint32_t regs[64] = {0};
+    gpio_ctx_t ctx = {0};
+    ctx.regs = regs;
+
+    // A pin in both masks is set, not cleared; bits above pin 53 are dropped
+    gpio_ctx_write_mask_fast(&ctx, (1ull << 4) | (1ull << 60), (1ull << 4) | (1ull << 5) | (1ull << 62));
+    TEST_ASSERT_EQUAL_UINT64(1u << 4, regs[GPSET0]);
+    TEST_ASSERT_EQUAL_UINT64(1u << 5, regs[GPCLR0]);
+    TEST_ASSERT_EQUAL_UINT64(0, regs[GPSET1]);
+    TEST_ASSERT_EQUAL_UINT64(0, regs[GPCLR1]);
+
+    gpio_ctx_write_mask_fast(&ctx, 1ull << 53, 1ull << 53);
+    TEST_ASSERT_EQUAL_UINT64(1u << 21, regs[GPSET1]);
+    TEST_ASSERT_EQUAL_UINT64(0, regs[GPCLR1]);
+}
+
+void test_sim_edge_detection(void) {
+    gpio_init_backend(GPIO_BACKEND_SIM);
+    pin_mode(17, INPUT);
+    pin_mode(27, INPUT);
+    gpio_set_edge_detect(17, GPIO_EDGE_RISING);
+    gpio_set_edge_detect(27, GPIO_EDGE_FALLING);
+
+    gpio_sim_set_input(17, HIGH);
+    gpio_sim_set_input(27, HIGH);
+    TEST_ASSERT_EQUAL_UINT64(1ull << 17, gpio_edge_status());
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_edge_status());  // Cleared on read
+
+    gpio_sim_set_input(17, LOW);
+    gpio_sim_set_input(27, LOW);
+    TEST_ASSERT_EQUAL_UINT64(1ull << 27, gpio_edge_status());
+
+    // Short pulse between two status reads is still latched
+    gpio_sim_set_input(17, HIGH);
+    gpio_sim_set_input(17, LOW);
+    TEST_ASSERT_EQUAL_UINT64(1ull << 17, gpio_edge_status());
+    gpio_cleanup();
+}
+
+void test_sim_level_detection(void) {
+    gpio_init_backend(GPIO_BACKEND_SIM);
+    gpio_set_edge_detect(5, GPIO_EDGE_LOW);
+    TEST_ASSERT_EQUAL_UINT64(1ull << 5, gpio_edge_status());
+    TEST_ASSERT_EQUAL_UINT64(1ull << 5, gpio_edge_status());  // Re-latches while low
+    gpio_sim_set_input(5, HIGH);
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_edge_status());
+    gpio_cleanup();
+}
+
+static int observer_calls;
+static uint64_t observer_last;
+
+static void loopback_observer(void* user, uint64_t prev, uint64_t levels) {
+    (void)user; (void)prev;
+    observer_calls++;
+    observer_last = levels;
+    // Model a wire from pin 20 (output) to pin 26 (input)
+    gpio_sim_set_input(26, (int)((levels >> 20) & 1));
+}
+
+void test_sim_observer_loopback(void) {
+    gpio_init_backend(GPIO_BACKEND_SIM);
+    gpio_sim_set_observer(loopback_observer, NULL);
+    observer_calls = 0;
+
+    pin_mode(20, OUTPUT);
+    pin_mode(26, INPUT);
+    digital_write(20, HIGH);
+    TEST_ASSERT_EQUAL_INT(HIGH, digital_read(26));
+    TEST_ASSERT_EQUAL_INT(1, observer_calls);
+    TEST_ASSERT_TRUE(observer_last & (1ull << 20));
+
+    digital_write(20, HIGH);  // No level change, no callback
+    TEST_ASSERT_EQUAL_INT(1, observer_calls);
+
+    digital_write(20, LOW);
+    TEST_ASSERT_EQUAL_INT(LOW, digital_read(26));
+
+    gpio_sim_set_observer(NULL, NULL);
+    gpio_cleanup();
+}
+
+void test_sim_state_reset_on_init(void) {
+    gpio_init_backend(GPIO_BACKEND_SIM);
+    pin_mode(21, OUTPUT);
+    digital_write(21, HIGH);
+    gpio_init_backend(GPIO_BACKEND_SIM);
+    TEST_ASSERT_EQUAL_INT(INPUT, gpio_sim_get_function(21));
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_read_all());
+    gpio_cleanup();
+}
+
+/* ============================================================================
+ * CONTEXT TESTS
+ * ============================================================================ */
+
+void test_ctx_instances_are_independent(void) {
+    gpio_ctx_t a = {0}, b = {0};
+    TEST_ASSERT_EQUAL_INT(0, gpio_ctx_init(&a, GPIO_BACKEND_SIM));
+    TEST_ASSERT_EQUAL_INT(0, gpio_ctx_init(&b, GPIO_BACKEND_SIM));
+
+    gpio_ctx_pin_mode(&a, 21, OUTPUT);
+    gpio_ctx_write(&a, 21, HIGH);
+    gpio_ctx_sim_set_input(&b, 5, HIGH);
+
+    TEST_ASSERT_EQUAL_UINT64(1ull << 21, gpio_ctx_read_all(&a));
+    TEST_ASSERT_EQUAL_UINT64(1ull << 5, gpio_ctx_read_all(&b));
+    TEST_ASSERT_EQUAL_INT(OUTPUT, gpio_ctx_sim_get_function(&a, 21));
+    TEST_ASSERT_EQUAL_INT(INPUT, gpio_ctx_sim_get_function(&b, 21));
+
+    gpio_ctx_cleanup(&a);
+    gpio_ctx_cleanup(&b);
+    TEST_ASSERT_EQUAL_INT(GPIO_BACKEND_NULL, a.backend);
+    TEST_ASSERT_NULL(a.state);
+}
+
+void test_ctx_does_not_touch_default(void) {
+    gpio_init_backend(GPIO_BACKEND_SIM);
+    gpio_ctx_t ctx = {0};
+    gpio_ctx_init(&ctx, GPIO_BACKEND_SIM);
+
+    gpio_ctx_pin_mode(&ctx, 17, OUTPUT);
+    gpio_ctx_write(&ctx, 17, HIGH);
+    TEST_ASSERT_EQUAL_INT(LOW, digital_read(17));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&ctx, 17));
+
+    gpio_ctx_cleanup(&ctx);
+    gpio_cleanup();
+}
+
+void test_ctx_stats_count_operations(void) {
+    gpio_ctx_t ctx = {0};
+    gpio_ctx_init(&ctx, GPIO_BACKEND_NULL);
+
+    gpio_ctx_pin_mode(&ctx, 18, OUTPUT);
+    for (int i = 0; i < 10; i++) {
+        gpio_ctx_write(&ctx, 18, i & 1);
+    }
+    gpio_ctx_write_mask(&ctx, 0xF, 0);
+    gpio_ctx_read(&ctx, 18);
+    gpio_ctx_read_all(&ctx);
+    gpio_ctx_write(&ctx, 99, HIGH);  /* Invalid pins are not counted */
+
+    TEST_ASSERT_EQUAL_UINT64(11, ctx.stats.writes);
+    TEST_ASSERT_EQUAL_UINT64(2, ctx.stats.reads);
+    TEST_ASSERT_EQUAL_UINT64(1, ctx.stats.config);
+
+    gpio_ctx_init(&ctx, GPIO_BACKEND_NULL);
+    TEST_ASSERT_EQUAL_UINT64(0, ctx.stats.writes);
+    gpio_ctx_cleanup(&ctx);
+}
+
+void test_ctx_sim_api_ignores_other_backends(void) {
+    gpio_ctx_t ctx = {0};
+    gpio_ctx_init(&ctx, GPIO_BACKEND_NULL);
+    gpio_ctx_sim_set_input(&ctx, 5, HIGH);
+    TEST_ASSERT_EQUAL_INT(-1, gpio_ctx_sim_get_function(&ctx, 5));
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_ctx_read_all(&ctx));
+    gpio_ctx_cleanup(&ctx);
+}
+
+void test_ctx_init_failure_leaves_null_backend(void) {
+    gpio_ctx_t ctx = {0};
+    TEST_ASSERT_EQUAL_INT(-1, gpio_ctx_init(&ctx, GPIO_BACKEND_COUNT));
+    TEST_ASSERT_EQUAL_INT(GPIO_BACKEND_NULL, ctx.backend);
+    gpio_ctx_write(&ctx, 18, HIGH);  /* Must not crash */
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&ctx, 18));
+    gpio_ctx_cleanup(&ctx);
+}
+
+void test_ctx_cleanup_zeroed_context(void) {
+    gpio_ctx_t ctx = {0};
+    gpio_ctx_cleanup(&ctx);
+    gpio_ctx_cleanup(NULL);
+    TEST_PASS();
+}
+
+typedef struct {
+    int pin;
+    int toggles;
+    uint64_t final_levels;
+    uint64_t writes;
+} ctx_worker_t;
+
+static void* ctx_worker(void* arg) {
+    ctx_worker_t* w = (ctx_worker_t*)arg;
+    gpio_ctx_t ctx = {0};
+    gpio_ctx_init(&ctx, GPIO_BACKEND_SIM);
+    gpio_ctx_pin_mode(&ctx, w->pin, OUTPUT);
+    for (int i = 0; i < w->toggles; i++) {
+        gpio_ctx_write_fast(&ctx, w->pin, HIGH);
+        gpio_ctx_write(&ctx, w->pin, (i & 1) ? HIGH : LOW);
+    }
+    w->final_levels = gpio_ctx_read_all(&ctx);
+    w->writes = ctx.stats.writes;
+    gpio_ctx_cleanup(&ctx);
+    return NULL;
+}
+
+void test_ctx_parallel_simulators(void) {
+    enum { WORKERS = 4 };
+    pthread_t threads[WORKERS];
+    ctx_worker_t workers[WORKERS];
+
+    for (int i = 0; i < WORKERS; i++) {
+        workers[i] = (ctx_worker_t){ .pin = 20 + i, .toggles = 10001 };
+        pthread_create(&threads[i], NULL, ctx_worker, &workers[i]);
+    }
+    for (int i = 0; i < WORKERS; i++) {
+        pthread_join(threads[i], NULL);
+        /* Last toggle (i = 10000) writes LOW; each context sees only its own pin */
+        TEST_ASSERT_EQUAL_UINT64(0, workers[i].final_levels);
+        TEST_ASSERT_EQUAL_UINT64(20002, workers[i].writes);
+    }
+}
+
 /* ============================================================================
  * STRESS TESTS
  * ============================================================================ */
@@ -429,6 +776,35 @@ int main(void) {
     RUN_TEST(test_constants_alt_function_values);
     RUN_TEST(test_constants_pin_range);
     
+    // Backend selection
+    RUN_TEST(test_backend_default_is_sim_on_host);
+    RUN_TEST(test_backend_env_override);
+    RUN_TEST(test_backend_unavailable);
+    RUN_TEST(test_backend_mmap_fails_without_device);
+    RUN_TEST(test_backend_names);
+    RUN_TEST(test_backend_null_drops_writes);
+    RUN_TEST(test_backend_register_rejects_invalid);
+    
+    // Simulator
+    RUN_TEST(test_sim_output_readback);
+    RUN_TEST(test_sim_input_ignores_output_latch);
+    RUN_TEST(test_sim_function_select);
+    RUN_TEST(test_sim_write_mask_both_banks);
+    RUN_TEST(test_fast_write_masks_like_write_mask);
+    RUN_TEST(test_sim_edge_detection);
+    RUN_TEST(test_sim_level_detection);
+    RUN_TEST(test_sim_observer_loopback);
+    RUN_TEST(test_sim_state_reset_on_init);
+
+    // Context tests
+    RUN_TEST(test_ctx_instances_are_independent);
+    RUN_TEST(test_ctx_does_not_touch_default);
+    RUN_TEST(test_ctx_stats_count_operations);
+    RUN_TEST(test_ctx_sim_api_ignores_other_backends);
+    RUN_TEST(test_ctx_init_failure_leaves_null_backend);
+    RUN_TEST(test_ctx_cleanup_zeroed_context);
+    RUN_TEST(test_ctx_parallel_simulators);
+    
     // Stress tests
     RUN_TEST(test_stress_many_operations);
     RUN_TEST(test_stress_full_gpio_cycle);
@@ -0,0 +1,412 @@
+/*
+ * test_rpi_gpio_bus.c - Validation tests for rpi_gpio_bus.h
+ *
+ * A parallel TFT controller is modelled in the GPIO simulator observer: it
+ * takes the data lines and D/C on the latching strobe edge (WR rising in
+ * 8080 mode, E falling in 6800 mode) while CS is low, and checks that the
+ * data lines were settled before the strobe was released.
+ * Focus: scrambled pin maps across both banks, 8/16-bit words, command
+ * framing, stores per word and idle levels. For reads a parallel ADC
+ * drives the next sample onto the data pins on each read strobe.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_GPIO_BUS_IMPLEMENTATION
+#include "rpi_gpio_bus.h"
+
+#define MAX_LOG 1024
+
+/* 16 data lines, out of order, some in bank 1 */
+static const gpio_bus_pins_t pins16 = {
+    16, { 5, 34, 6, 13, 19, 26, 12, 16, 20, 21, 40, 7, 8, 25, 24, 36 }, 23, 22, 27, 17
+};
+static const gpio_bus_pins_t pins8 = {
+    8, { 9, 11, 10, 4, 14, 15, 2, 3 }, 23, 22, 27, 17
+};
+/* D0-D15 on GPIO 4-19 */
+static const gpio_bus_pins_t pins_contiguous = {
+    16, { 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 }, 20, 21, 22, 23
+};
+/* In order but with gaps */
+static const gpio_bus_pins_t pins_ordered = {
+    8, { 2, 3, 5, 8, 13, 19, 26, 40 }, 20, 21, 22, 23
+};
+
+/* ============================================================================
+ * CONTROLLER MODEL
+ * ============================================================================ */
+
+typedef struct {
+    const gpio_bus_pins_t* pins;
+    int mode;
+    uint16_t word[MAX_LOG];
+    int dc[MAX_LOG];
+    int count;
+    int selects;
+    int unsettled;      /* Data changed in the same store as the latching edge */
+} model_t;
+
+static model_t model;
+
+static int level(uint64_t levels, int pin) {
+    return (int)((levels >> pin) & 1);
+}
+
+static uint16_t data_word(const gpio_bus_pins_t* p, uint64_t levels) {
+    uint16_t w = 0;
+    for (int i = 0; i < p->width; i++) w |= (uint16_t)(level(levels, p->data[i]) << i);
+    return w;
+}
+
+static void bus_observer(void* user, uint64_t prev, uint64_t levels) {
+    model_t* m = (model_t*)user;
+    const gpio_bus_pins_t* p = m->pins;
+    uint64_t changed = prev ^ levels;
+
+    if (level(prev, p->cs) && !level(levels, p->cs)) m->selects++;
+    if (!((changed >> p->wr) & 1)) return;
+    int latch = m->mode == GPIO_BUS_8080 ? level(levels, p->wr) : !level(levels, p->wr);
+    if (!latch || level(levels, p->cs)) return;
+
+    if (data_word(p, prev) != data_word(p, levels)) m->unsettled++;
+    if (m->count < MAX_LOG) {
+        m->word[m->count] = data_word(p, levels);
+        m->dc[m->count] = level(levels, p->dc);
+        m->count++;
+    }
+}
+
+static void setup(gpio_ctx_t* gpio, gpio_bus_t* bus, const gpio_bus_pins_t* pins, int mode) {
+    memset(gpio, 0, sizeof(*gpio));
+    gpio_ctx_init(gpio, GPIO_BACKEND_SIM);
+    memset(&model, 0, sizeof(model));
+    model.pins = pins;
+    model.mode = mode;
+    gpio_ctx_sim_set_observer(gpio, bus_observer, &model);
+    TEST_ASSERT_EQUAL_INT(0, gpio_bus_init(bus, gpio, pins, mode));
+}
+
+static void teardown(gpio_ctx_t* gpio, gpio_bus_t* bus) {
+    gpio_bus_free(bus);
+    gpio_ctx_sim_set_observer(gpio, NULL, NULL);
+    gpio_ctx_cleanup(gpio);
+}
+
+/* ============================================================================
+ * SETUP
+ * ============================================================================ */
+
+void test_init_validation(void) {
+    gpio_ctx_t gpio;
+    gpio_bus_t bus;
+    setup(&gpio, &bus, &pins8, GPIO_BUS_8080);
+
+    TEST_ASSERT_EQUAL_INT(OUTPUT, gpio_ctx_sim_get_function(&gpio, pins8.data[7]));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, pins8.wr));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, pins8.rd));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, pins8.cs));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, pins8.dc));
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&gpio, pins8.data[0]));
+
+    gpio_bus_t bad;
+    gpio_bus_pins_t p = pins8;
+    p.width = 12;
+    TEST_ASSERT_EQUAL_INT(-1, gpio_bus_init(&bad, &gpio, &p, GPIO_BUS_8080));
+    p = pins8;
+    p.dc = p.data[3];
+    TEST_ASSERT_EQUAL_INT(-1, gpio_bus_init(&bad, &gpio, &p, GPIO_BUS_8080));
+    p = pins8;
+    p.wr = GPIO_BUS_NO_PIN;
+    TEST_ASSERT_EQUAL_INT(-1, gpio_bus_init(&bad, &gpio, &p, GPIO_BUS_8080));
+    TEST_ASSERT_EQUAL_INT(-1, gpio_bus_init(&bad, &gpio, &pins8, 2));
+
+    /* Optional controls may be left out */
+    p = pins8;
+    p.rd = p.cs = GPIO_BUS_NO_PIN;
+    TEST_ASSERT_EQUAL_INT(0, gpio_bus_init(&bad, &gpio, &p, GPIO_BUS_8080));
+    gpio_bus_free(&bad);
+    teardown(&gpio, &bus);
+}
+
+/* ============================================================================
+ * WRITES
+ * ============================================================================ */
+
+void test_8bit_bytes_in_order(void) {
+    gpio_ctx_t gpio;
+    gpio_bus_t bus;
+    setup(&gpio, &bus, &pins8, GPIO_BUS_8080);
+
+    uint8_t buf[256];
+    for (int i = 0; i < 256; i++) buf[i] = (uint8_t)(i * 73 + 5);
+    gpio_bus_select(&bus, 1);
+    gpio_bus_write_buffer(&bus, buf, sizeof(buf));
+    gpio_bus_write(&bus, 0x1A5);
+    gpio_bus_select(&bus, 0);
+
+    TEST_ASSERT_EQUAL_INT(257, model.count);
+    for (int i = 0; i < 256; i++) TEST_ASSERT_EQUAL_INT(buf[i], model.word[i]);
+    TEST_ASSERT_EQUAL_INT(0xA5, model.word[256]);
+    TEST_ASSERT_EQUAL_INT(0, model.unsettled);
+    TEST_ASSERT_EQUAL_UINT64(257, bus.words);
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, pins8.wr));
+    teardown(&gpio, &bus);
+}
+
+void test_16bit_scrambled_pins(void) {
+    gpio_ctx_t gpio;
+    gpio_bus_t bus;
+    setup(&gpio, &bus, &pins16, GPIO_BUS_8080);
+
+    uint16_t buf[512];
+    for (int i = 0; i < 512; i++) buf[i] = (uint16_t)(i * 40503u + 17);
+    buf[0] = 0xFFFF;
+    buf[1] = 0x0000;
+    gpio_bus_select(&bus, 1);
+    gpio_bus_write_buffer(&bus, buf, 512);
+    gpio_bus_select(&bus, 0);
+
+    TEST_ASSERT_EQUAL_INT(512, model.count);
+    for (int i = 0; i < 512; i++) TEST_ASSERT_EQUAL_INT(buf[i], model.word[i]);
+    TEST_ASSERT_EQUAL_INT(0, model.unsettled);
+    teardown(&gpio, &bus);
+}
+
+void test_two_stores_per_word(void) {
+    gpio_ctx_t gpio;
+    gpio_bus_t bus;
+    setup(&gpio, &bus, &pins16, GPIO_BUS_8080);
+
+    uint16_t buf[100] = { 0 };
+    uint64_t writes = gpio.stats.writes;
+    gpio_bus_write_buffer(&bus, buf, 100);
+    TEST_ASSERT_EQUAL_UINT64(200, gpio.stats.writes - writes);
+
+    /* Slowdown repeats stores, it does not add any */
+    gpio_bus_set_slowdown(&bus, 3);
+    writes = gpio.stats.writes;
+    gpio_bus_write_buffer(&bus, buf, 100);
+    TEST_ASSERT_EQUAL_UINT64(200, gpio.stats.writes - writes);
+    teardown(&gpio, &bus);
+}
+
+void test_command_framing(void) {
+    gpio_ctx_t gpio;
+    gpio_bus_t bus;
+    setup(&gpio, &bus, &pins8, GPIO_BUS_8080);
+
+    const uint8_t params[4] = { 0x00, 0x00, 0x01, 0x3F };
+    gpio_bus_command(&bus, 0x2A, params, 4);
+
+    TEST_ASSERT_EQUAL_INT(1, model.selects);
+    TEST_ASSERT_EQUAL_INT(5, model.count);
+    TEST_ASSERT_EQUAL_INT(0x2A, model.word[0]);
+    TEST_ASSERT_EQUAL_INT(0, model.dc[0]);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(params[i], model.word[1 + i]);
+        TEST_ASSERT_EQUAL_INT(1, model.dc[1 + i]);
+    }
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, pins8.cs));
+
+    /* Not selected: the controller ignores the bus */
+    gpio_bus_write(&bus, 0x55);
+    TEST_ASSERT_EQUAL_INT(5, model.count);
+    teardown(&gpio, &bus);
+}
+
+void test_6800_mode(void) {
+    gpio_ctx_t gpio;
+    gpio_bus_t bus;
+    setup(&gpio, &bus, &pins8, GPIO_BUS_6800);
+
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&gpio, pins8.wr));     /* E idle low */
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&gpio, pins8.rd));     /* R/W = write */
+
+    const uint8_t buf[3] = { 0x81, 0x7E, 0xC3 };
+    gpio_bus_select(&bus, 1);
+    gpio_bus_write_buffer(&bus, buf, 3);
+    gpio_bus_select(&bus, 0);
+
+    TEST_ASSERT_EQUAL_INT(3, model.count);
+    for (int i = 0; i < 3; i++) TEST_ASSERT_EQUAL_INT(buf[i], model.word[i]);
+    TEST_ASSERT_EQUAL_INT(0, model.unsettled);
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&gpio, pins8.wr));
+    teardown(&gpio, &bus);
+}
+
+/* ============================================================================
+ * READS
+ * ============================================================================ */
+
+static uint64_t spread_word(const gpio_bus_pins_t* p, uint16_t w) {
+    uint64_t levels = 0;
+    for (int i = 0; i < p->width; i++) {
+        if (w & (1u << i)) levels |= 1ull << p->data[i];
+    }
+    return levels;
+}
+
+static void check_gather(const gpio_bus_pins_t* p, int expected_best) {
+    gpio_ctx_t gpio;
+    gpio_bus_t bus;
+    setup(&gpio, &bus, p, GPIO_BUS_8080);
+    TEST_ASSERT_EQUAL_INT(expected_best, bus.gather_mode);
+
+    /* Non-data pins set in the snapshot must not leak into the word */
+    uint64_t noise = ~bus.data_mask & GPIO_ALL_PINS_MASK;
+    int modes[2] = { bus.gather_best, GPIO_BUS_GATHER_LUT };
+    for (int m = 0; m < 2; m++) {
+        TEST_ASSERT_EQUAL_INT(0, gpio_bus_set_gather(&bus, modes[m]));
+        uint32_t limit = 1u << p->width;
+        for (uint32_t w = 0; w < limit; w += (p->width == 16 ? 7 : 1)) {
+            TEST_ASSERT_EQUAL_INT(w, gpio_bus_gather(&bus, spread_word(p, (uint16_t)w)));
+            TEST_ASSERT_EQUAL_INT(w, gpio_bus_gather(&bus, spread_word(p, (uint16_t)w) | noise));
+        }
+    }
+    teardown(&gpio, &bus);
+}
+
+void test_gather_modes(void) {
+    check_gather(&pins16, GPIO_BUS_GATHER_LUT);
+    check_gather(&pins8, GPIO_BUS_GATHER_LUT);
+    check_gather(&pins_contiguous, GPIO_BUS_GATHER_SHIFT);
+#if defined(__BMI2__)
+    check_gather(&pins_ordered, GPIO_BUS_GATHER_PEXT);
+#else
+    check_gather(&pins_ordered, GPIO_BUS_GATHER_LUT);
+#endif
+
+    gpio_ctx_t gpio;
+    gpio_bus_t bus;
+    setup(&gpio, &bus, &pins16, GPIO_BUS_8080);
+    TEST_ASSERT_EQUAL_INT(-1, gpio_bus_set_gather(&bus, GPIO_BUS_GATHER_SHIFT));
+    TEST_ASSERT_EQUAL_INT(-1, gpio_bus_set_gather(&bus, GPIO_BUS_GATHER_PEXT));
+    teardown(&gpio, &bus);
+}
+
+typedef struct {
+    gpio_ctx_t* gpio;
+    const gpio_bus_pins_t* pins;
+    int mode;
+    uint16_t next;
+    int strobes;
+} adc_t;
+
+static void drive_word(gpio_ctx_t* gpio, const gpio_bus_pins_t* p, uint16_t w) {
+    for (int i = 0; i < p->width; i++) gpio_ctx_sim_set_input(gpio, p->data[i], (w >> i) & 1);
+}
+
+/* Puts the next sample on the bus as the read strobe is asserted */
+static void adc_observer(void* user, uint64_t prev, uint64_t levels) {
+    adc_t* a = (adc_t*)user;
+    int pin = a->mode == GPIO_BUS_8080 ? a->pins->rd : a->pins->wr;
+    int was = level(prev, pin), now = level(levels, pin);
+    int asserted = a->mode == GPIO_BUS_8080 ? (was && !now) : (!was && now);
+    if (!asserted) return;
+    drive_word(a->gpio, a->pins, a->next);
+    a->next = (uint16_t)(a->next * 25173u + 13849u);
+    a->strobes++;
+}
+
+static void check_adc(const gpio_bus_pins_t* p, int mode) {
+    gpio_ctx_t gpio;
+    gpio_bus_t bus;
+    memset(&gpio, 0, sizeof(gpio));
+    gpio_ctx_init(&gpio, GPIO_BACKEND_SIM);
+    TEST_ASSERT_EQUAL_INT(0, gpio_bus_init(&bus, &gpio, p, mode));
+
+    adc_t adc = { &gpio, p, mode, 1, 0 };
+    gpio_ctx_sim_set_observer(&gpio, adc_observer, &adc);
+    gpio_bus_set_input(&bus, 1);
+    TEST_ASSERT_EQUAL_INT(INPUT, gpio_ctx_sim_get_function(&gpio, p->data[p->width - 1]));
+    if (mode == GPIO_BUS_6800) TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, p->rd));
+
+    uint16_t words[300];
+    uint64_t writes = gpio.stats.writes, reads = gpio.stats.reads;
+    TEST_ASSERT_EQUAL_UINT64(300, gpio_bus_read_buffer(&bus, words, 300));
+    TEST_ASSERT_EQUAL_INT(300, adc.strobes);
+    TEST_ASSERT_EQUAL_UINT64(600, gpio.stats.writes - writes);
+    TEST_ASSERT_EQUAL_UINT64(300, gpio.stats.reads - reads);
+
+    uint16_t expect = 1;
+    uint16_t mask = (uint16_t)((1u << p->width) - 1);
+    for (int i = 0; i < 300; i++) {
+        uint16_t got = p->width == 16 ? words[i] : ((uint8_t*)words)[i];
+        TEST_ASSERT_EQUAL_INT(expect & mask, got);
+        expect = (uint16_t)(expect * 25173u + 13849u);
+    }
+
+    /* Unstrobed sample sees the last word left on the pins */
+    drive_word(&gpio, p, 0x5A5A & mask);
+    TEST_ASSERT_EQUAL_INT(0x5A5A & mask, gpio_bus_sample(&bus));
+
+    /* Writes are ignored while the pins are inputs */
+    writes = gpio.stats.writes;
+    gpio_bus_write(&bus, 0x1234);
+    TEST_ASSERT_EQUAL_UINT64(writes, gpio.stats.writes);
+
+    gpio_bus_set_input(&bus, 0);
+    TEST_ASSERT_EQUAL_INT(OUTPUT, gpio_ctx_sim_get_function(&gpio, p->data[0]));
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_bus_read_buffer(&bus, words, 1));
+    gpio_bus_free(&bus);
+    gpio_ctx_sim_set_observer(&gpio, NULL, NULL);
+    gpio_ctx_cleanup(&gpio);
+}
+
+void test_strobed_reads_8080(void) {
+    check_adc(&pins16, GPIO_BUS_8080);
+    check_adc(&pins8, GPIO_BUS_8080);
+}
+
+void test_strobed_reads_6800(void) {
+    check_adc(&pins_contiguous, GPIO_BUS_6800);
+}
+
+void test_read_needs_strobe(void) {
+    gpio_ctx_t gpio;
+    gpio_bus_t bus;
+    gpio_bus_pins_t p = pins8;
+    p.rd = GPIO_BUS_NO_PIN;
+    memset(&gpio, 0, sizeof(gpio));
+    gpio_ctx_init(&gpio, GPIO_BACKEND_SIM);
+    TEST_ASSERT_EQUAL_INT(0, gpio_bus_init(&bus, &gpio, &p, GPIO_BUS_8080));
+    gpio_bus_set_input(&bus, 1);
+
+    uint8_t buf[4];
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_bus_read_buffer(&bus, buf, 4));
+    gpio_bus_free(&bus);
+    gpio_ctx_cleanup(&gpio);
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Setup
+    RUN_TEST(test_init_validation);
+
+    // Writes
+    RUN_TEST(test_8bit_bytes_in_order);
+    RUN_TEST(test_16bit_scrambled_pins);
+    RUN_TEST(test_two_stores_per_word);
+    RUN_TEST(test_command_framing);
+    RUN_TEST(test_6800_mode);
+
+    // Reads
+    RUN_TEST(test_gather_modes);
+    RUN_TEST(test_strobed_reads_8080);
+    RUN_TEST(test_strobed_reads_6800);
+    RUN_TEST(test_read_needs_strobe);
+
+    return UNITY_END();
+}
@@ -0,0 +1,291 @@
+/*
+ * test_rpi_gpio_event.c - Validation tests for rpi_gpio_event.h
+ *
+ * These tests validate the edge event ring in EMULATION MODE using an
+ * injected event source.
+ * Focus: ordering, batch dequeue, overflow accounting, poller lifecycle.
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_GPIO_EVENT_IMPLEMENTATION
+#include "rpi_gpio_event.h"
+
+/* ============================================================================
+ * SCRIPTED EVENT SOURCE
+ * ============================================================================ */
+
+typedef struct {
+    int pending;        /* Events still to emit */
+    int per_poll;       /* Events emitted per poll */
+    int next_seq;       /* Sequence number encoded in timestamp */
+} scripted_source_t;
+
+static int scripted_source(void* user, gpio_event_t* out, int max) {
+    scripted_source_t* s = (scripted_source_t*)user;
+    int n = s->pending < s->per_poll ? s->pending : s->per_poll;
+    if (n > max) n = max;
+
+    for (int i = 0; i < n; i++) {
+        out[i].timestamp_ns = (uint64_t)s->next_seq;
+        out[i].pin = (uint8_t)(s->next_seq % 54);
+        out[i].edge = (s->next_seq & 1) ? GPIO_EDGE_FALLING : GPIO_EDGE_RISING;
+        s->next_seq++;
+    }
+    s->pending -= n;
+    return n;
+}
+
+static void reset_ring(void) {
+    gpio_event_t drain[64];
+    while (gpio_event_read(drain, 64) > 0) {}
+    atomic_store(&gpio_event_ring.dropped, 0);
+}
+
+/* ============================================================================
+ * RING TESTS
+ * ============================================================================ */
+
+void test_event_read_empty_ring(void) {
+    reset_ring();
+    gpio_event_t ev[4];
+    TEST_ASSERT_EQUAL_INT(0, gpio_event_read(ev, 4));
+}
+
+void test_event_read_invalid_args(void) {
+    gpio_event_t ev[4];
+    TEST_ASSERT_EQUAL_INT(0, gpio_event_read(NULL, 4));
+    TEST_ASSERT_EQUAL_INT(0, gpio_event_read(ev, 0));
+    TEST_ASSERT_EQUAL_INT(0, gpio_event_read(ev, -1));
+}
+
+void test_event_poll_preserves_order(void) {
+    reset_ring();
+    scripted_source_t src = { .pending = 10, .per_poll = 3, .next_seq = 0 };
+    gpio_event_set_source(scripted_source, &src);
+
+    while (gpio_event_poll() > 0) {}
+
+    gpio_event_t ev[16];
+    int n = gpio_event_read(ev, 16);
+    TEST_ASSERT_EQUAL_INT(10, n);
+    for (int i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL_UINT64((uint64_t)i, ev[i].timestamp_ns);
+        TEST_ASSERT_EQUAL_INT(i % 54, ev[i].pin);
+    }
+    TEST_ASSERT_EQUAL_INT(GPIO_EDGE_RISING, ev[0].edge);
+    TEST_ASSERT_EQUAL_INT(GPIO_EDGE_FALLING, ev[1].edge);
+
+    gpio_event_set_source(NULL, NULL);
+}
+
+void test_event_batch_dequeue_partial(void) {
+    reset_ring();
+    scripted_source_t src = { .pending = 7, .per_poll = 7, .next_seq = 100 };
+    gpio_event_set_source(scripted_source, &src);
+    gpio_event_poll();
+
+    gpio_event_t ev[4];
+    TEST_ASSERT_EQUAL_INT(4, gpio_event_read(ev, 4));
+    TEST_ASSERT_EQUAL_UINT64(100, ev[0].timestamp_ns);
+    TEST_ASSERT_EQUAL_INT(3, gpio_event_read(ev, 4));
+    TEST_ASSERT_EQUAL_UINT64(104, ev[0].timestamp_ns);
+    TEST_ASSERT_EQUAL_INT(0, gpio_event_read(ev, 4));
+
+    gpio_event_set_source(NULL, NULL);
+}
+
+void test_event_ring_overflow_counts_drops(void) {
+    reset_ring();
+    int total = GPIO_EVENT_RING_SIZE + 100;
+    scripted_source_t src = { .pending = total, .per_poll = GPIO_EVENT_BATCH_MAX, .next_seq = 0 };
+    gpio_event_set_source(scripted_source, &src);
+
+    while (src.pending > 0) {
+        gpio_event_poll();
+    }
+    TEST_ASSERT_EQUAL_UINT64(100, gpio_event_dropped());
+
+    /* Oldest events are kept; overflow drops the newest */
+    gpio_event_t ev[1];
+    TEST_ASSERT_EQUAL_INT(1, gpio_event_read(ev, 1));
+    TEST_ASSERT_EQUAL_UINT64(0, ev[0].timestamp_ns);
+
+    gpio_event_set_source(NULL, NULL);
+    reset_ring();
+}
+
+void test_event_ring_wraparound(void) {
+    reset_ring();
+    scripted_source_t src = { .pending = 0, .per_poll = 50, .next_seq = 0 };
+    gpio_event_set_source(scripted_source, &src);
+
+    gpio_event_t ev[64];
+    int expected = 0;
+    for (int round = 0; round < 100; round++) {
+        src.pending = 50;
+        gpio_event_poll();
+        int n = gpio_event_read(ev, 64);
+        TEST_ASSERT_EQUAL_INT(50, n);
+        for (int i = 0; i < n; i++) {
+            TEST_ASSERT_EQUAL_UINT64((uint64_t)expected, ev[i].timestamp_ns);
+            expected++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_event_dropped());
+
+    gpio_event_set_source(NULL, NULL);
+}
+
+void test_event_default_source_idle_in_emulation(void) {
+    reset_ring();
+    gpio_init();
+    TEST_ASSERT_EQUAL_INT(0, gpio_event_poll());
+    gpio_cleanup();
+}
+
+void test_event_default_source_keeps_other_latches(void) {
+    reset_ring();
+    gpio_init_backend(GPIO_BACKEND_SIM);
+    pin_mode(17, INPUT);
+    pin_mode(27, INPUT);
+    gpio_set_edge_detect(17, GPIO_EDGE_RISING);
+    gpio_set_edge_detect(27, GPIO_EDGE_RISING);
+    gpio_event_pins = 1ull << 17;
+    gpio_event_edges = GPIO_EDGE_RISING;
+
+    gpio_sim_set_input(17, HIGH);
+    gpio_sim_set_input(27, HIGH);
+    TEST_ASSERT_EQUAL_INT(1, gpio_event_poll());
+    gpio_event_t ev;
+    TEST_ASSERT_EQUAL_INT(1, gpio_event_read(&ev, 1));
+    TEST_ASSERT_EQUAL_INT(17, ev.pin);
+    TEST_ASSERT_EQUAL_UINT64(1ull << 27, gpio_edge_status());  // Unwatched pin still latched
+
+    gpio_event_pins = 0;
+    gpio_event_edges = GPIO_EDGE_NONE;
+    gpio_cleanup();
+}
+
+/* ============================================================================
+ * POLLER THREAD TESTS
+ * ============================================================================ */
+
+void test_event_poller_delivers_events(void) {
+    reset_ring();
+    gpio_init();
+    scripted_source_t src = { .pending = 200, .per_poll = 5, .next_seq = 0 };
+    gpio_event_set_source(scripted_source, &src);
+
+    TEST_ASSERT_EQUAL_INT(0, gpio_event_start((1ull << 17) | (1ull << 27), GPIO_EDGE_BOTH, -1));
+
+    int received = 0;
+    gpio_event_t ev[32];
+    while (received < 200) {
+        int n = gpio_event_wait(ev, 32, 1000000);
+        if (n == 0) break;
+        for (int i = 0; i < n; i++) {
+            TEST_ASSERT_EQUAL_UINT64((uint64_t)(received + i), ev[i].timestamp_ns);
+        }
+        received += n;
+    }
+    TEST_ASSERT_EQUAL_INT(200, received);
+
+    gpio_event_stop();
+    gpio_event_set_source(NULL, NULL);
+    gpio_cleanup();
+}
+
+void test_event_double_start_fails(void) {
+    reset_ring();
+    gpio_init();
+    TEST_ASSERT_EQUAL_INT(0, gpio_event_start(1ull << 17, GPIO_EDGE_RISING, -1));
+    TEST_ASSERT_EQUAL_INT(-1, gpio_event_start(1ull << 17, GPIO_EDGE_RISING, -1));
+    gpio_event_stop();
+    gpio_cleanup();
+}
+
+void test_event_stop_without_start(void) {
+    gpio_event_stop();
+    gpio_event_stop();
+    TEST_PASS();
+}
+
+void test_event_wait_times_out(void) {
+    reset_ring();
+    gpio_event_t ev[4];
+    uint64_t start = gpio_event_now_ns();
+    TEST_ASSERT_EQUAL_INT(0, gpio_event_wait(ev, 4, 2000));
+    TEST_ASSERT_GREATER_OR_EQUAL(2000000, (long long)(gpio_event_now_ns() - start));
+}
+
+/* ============================================================================
+ * EDGE DETECT CONFIGURATION TESTS
+ * ============================================================================ */
+
+void test_edge_detect_invalid_pins(void) {
+    gpio_init();
+    gpio_set_edge_detect(-1, GPIO_EDGE_BOTH);
+    gpio_set_edge_detect(54, GPIO_EDGE_BOTH);
+    gpio_cleanup();
+    TEST_PASS();
+}
+
+void test_edge_status_and_levels_in_emulation(void) {
+    gpio_init();
+    gpio_set_edge_detect(17, GPIO_EDGE_RISING | GPIO_EDGE_ASYNC_FALLING);
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_edge_status());
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_read_all());
+    gpio_cleanup();
+}
+
+void test_edge_flag_values(void) {
+    TEST_ASSERT_EQUAL_INT(0, GPIO_EDGE_NONE);
+    TEST_ASSERT_EQUAL_INT(3, GPIO_EDGE_BOTH);
+    TEST_ASSERT_EQUAL_INT(0x20, GPIO_EDGE_ASYNC_FALLING);
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Ring tests
+    RUN_TEST(test_event_read_empty_ring);
+    RUN_TEST(test_event_read_invalid_args);
+    RUN_TEST(test_event_poll_preserves_order);
+    RUN_TEST(test_event_batch_dequeue_partial);
+    RUN_TEST(test_event_ring_overflow_counts_drops);
+    RUN_TEST(test_event_ring_wraparound);
+    RUN_TEST(test_event_default_source_idle_in_emulation);
+    RUN_TEST(test_event_default_source_keeps_other_latches);
+
+    // Poller thread tests
+    RUN_TEST(test_event_poller_delivers_events);
+    RUN_TEST(test_event_double_start_fails);
+    RUN_TEST(test_event_stop_without_start);
+    RUN_TEST(test_event_wait_times_out);
+
+    // Edge detect configuration
+    RUN_TEST(test_edge_detect_invalid_pins);
+    RUN_TEST(test_edge_status_and_levels_in_emulation);
+    RUN_TEST(test_edge_flag_values);
+
+    return UNITY_END();
+}
@@ -0,0 +1,479 @@
+/*
+ * test_rpi_gpiochip.c - Validation tests for rpi_gpiochip.h
+ *
+ * These tests run the gpiochip v2 backend against a fake ioctl layer.
+ * Focus: request encoding, batched value access, batched event reads.
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/gpio.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_GPIO_EVENT_IMPLEMENTATION
+#include "rpi_gpio_event.h"
+
+#define RPI_GPIOCHIP_IMPLEMENTATION
+#include "rpi_gpiochip.h"
+
+/* ============================================================================
+ * FAKE CHIP
+ * ============================================================================ */
+
+#define FAKE_CHIP_FD 3
+#define FAKE_LINE_FD 42
+#define FAKE_QUEUE   128
+
+static struct {
+    int fail_open;
+    int open_fds;
+    int ioctl_calls;
+    int read_calls;
+    struct gpio_v2_line_request last_req;
+    uint64_t values;
+    struct gpio_v2_line_event queue[FAKE_QUEUE];
+    int q_head;
+    int q_count;
+} fake;
+
+static int fake_open(const char* path, int flags) {
+    (void)path; (void)flags;
+    if (fake.fail_open) return -1;
+    fake.open_fds++;
+    return FAKE_CHIP_FD;
+}
+
+static int fake_close(int fd) {
+    (void)fd;
+    fake.open_fds--;
+    return 0;
+}
+
+static int fake_ioctl(int fd, unsigned long request, void* arg) {
+    fake.ioctl_calls++;
+    if (request == GPIO_V2_GET_LINE_IOCTL && fd == FAKE_CHIP_FD) {
+        struct gpio_v2_line_request* req = (struct gpio_v2_line_request*)arg;
+        fake.last_req = *req;
+        req->fd = FAKE_LINE_FD;
+        fake.open_fds++;
+        return 0;
+    }
+    if (request == GPIO_V2_LINE_SET_VALUES_IOCTL && fd == FAKE_LINE_FD) {
+        struct gpio_v2_line_values* v = (struct gpio_v2_line_values*)arg;
+        fake.values = (fake.values & ~v->mask) | (v->bits & v->mask);
+        return 0;
+    }
+    if (request == GPIO_V2_LINE_GET_VALUES_IOCTL && fd == FAKE_LINE_FD) {
+        struct gpio_v2_line_values* v = (struct gpio_v2_line_values*)arg;
+        v->bits = fake.values & v->mask;
+        return 0;
+    }
+    return -1;
+}
+
+static ssize_t fake_read(int fd, void* buf, size_t count) {
+    if (fd != FAKE_LINE_FD) return -1;
+    fake.read_calls++;
+    size_t max = count / sizeof(struct gpio_v2_line_event);
+    size_t n = (size_t)fake.q_count < max ? (size_t)fake.q_count : max;
+    memcpy(buf, &fake.queue[fake.q_head], n * sizeof(struct gpio_v2_line_event));
+    fake.q_head += (int)n;
+    fake.q_count -= (int)n;
+    return (ssize_t)(n * sizeof(struct gpio_v2_line_event));
+}
+
+static int fake_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
+    (void)nfds; (void)timeout_ms;
+    fds[0].revents = fake.q_count > 0 ? POLLIN : 0;
+    return fake.q_count > 0 ? 1 : 0;
+}
+
+static const gpiochip_io_t fake_io = { fake_open, fake_close, fake_ioctl, fake_read, fake_poll };
+
+static void fake_reset(void) {
+    memset(&fake, 0, sizeof(fake));
+    gpiochip_set_io(&fake_io);
+}
+
+static void fake_queue_event(uint32_t offset, uint32_t id, uint64_t ts) {
+    struct gpio_v2_line_event* e = &fake.queue[fake.q_head + fake.q_count++];
+    memset(e, 0, sizeof(*e));
+    e->offset = offset;
+    e->id = id;
+    e->timestamp_ns = ts;
+}
+
+/* ============================================================================
+ * INIT TESTS
+ * ============================================================================ */
+
+void test_gpiochip_init_missing_device(void) {
+    gpiochip_set_io(NULL);
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_init("/nonexistent/gpiochip99"));
+    gpiochip_cleanup();
+}
+
+void test_gpiochip_init_cleanup_fake(void) {
+    fake_reset();
+    TEST_ASSERT_EQUAL_INT(0, gpiochip_init(NULL));
+    TEST_ASSERT_EQUAL_INT(0, gpiochip_init(NULL));  /* Already open */
+    TEST_ASSERT_EQUAL_INT(1, fake.open_fds);
+    gpiochip_cleanup();
+    gpiochip_cleanup();
+    TEST_ASSERT_EQUAL_INT(0, fake.open_fds);
+}
+
+void test_gpiochip_request_without_init(void) {
+    fake_reset();
+    gpiochip_lines_t lines;
+    int pins[] = {17};
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_request_lines(&lines, pins, 1, 1, GPIO_EDGE_NONE));
+    TEST_ASSERT_EQUAL_INT(-1, lines.fd);
+}
+
+/* ============================================================================
+ * LINE REQUEST TESTS
+ * ============================================================================ */
+
+void test_gpiochip_request_encodes_config(void) {
+    fake_reset();
+    gpiochip_init(NULL);
+
+    gpiochip_lines_t lines;
+    int pins[] = {17, 27, 22, 5};
+    TEST_ASSERT_EQUAL_INT(0, gpiochip_request_lines(&lines, pins, 4, 0x3, GPIO_EDGE_BOTH));
+    TEST_ASSERT_EQUAL_INT(FAKE_LINE_FD, lines.fd);
+    TEST_ASSERT_EQUAL_INT(4, lines.num_lines);
+    TEST_ASSERT_EQUAL_INT(1, fake.ioctl_calls);
+
+    struct gpio_v2_line_request* req = &fake.last_req;
+    TEST_ASSERT_EQUAL_INT(4, req->num_lines);
+    TEST_ASSERT_EQUAL_INT(27, req->offsets[1]);
+    TEST_ASSERT_EQUAL_INT(0, strcmp(req->consumer, GPIOCHIP_CONSUMER));
+    TEST_ASSERT_EQUAL_UINT64(GPIO_V2_LINE_FLAG_INPUT, req->config.flags);
+    TEST_ASSERT_EQUAL_INT(3, req->config.num_attrs);
+    TEST_ASSERT_EQUAL_INT(GPIO_V2_LINE_ATTR_ID_FLAGS, req->config.attrs[0].attr.id);
+    TEST_ASSERT_EQUAL_UINT64(GPIO_V2_LINE_FLAG_OUTPUT, req->config.attrs[0].attr.flags);
+    TEST_ASSERT_EQUAL_UINT64(0x3, req->config.attrs[0].mask);
+    /* Edge detection only on the input lines */
+    TEST_ASSERT_EQUAL_UINT64(GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING |
+                             GPIO_V2_LINE_FLAG_EDGE_FALLING, req->config.attrs[1].attr.flags);
+    TEST_ASSERT_EQUAL_UINT64(0xC, req->config.attrs[1].mask);
+    TEST_ASSERT_EQUAL_INT(GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES, req->config.attrs[2].attr.id);
+
+    gpiochip_release_lines(&lines);
+    TEST_ASSERT_EQUAL_INT(-1, lines.fd);
+    gpiochip_cleanup();
+    TEST_ASSERT_EQUAL_INT(0, fake.open_fds);
+}
+
+void test_gpiochip_request_inputs_only(void) {
+    fake_reset();
+    gpiochip_init(NULL);
+
+    gpiochip_lines_t lines;
+    int pins[] = {4};
+    TEST_ASSERT_EQUAL_INT(0, gpiochip_request_lines(&lines, pins, 1, 0, GPIO_EDGE_NONE));
+    TEST_ASSERT_EQUAL_UINT64(GPIO_V2_LINE_FLAG_INPUT, fake.last_req.config.flags);
+    TEST_ASSERT_EQUAL_INT(0, fake.last_req.config.num_attrs);
+
+    gpiochip_release_lines(&lines);
+    gpiochip_cleanup();
+}
+
+void test_gpiochip_request_invalid_args(void) {
+    fake_reset();
+    gpiochip_init(NULL);
+
+    gpiochip_lines_t lines;
+    int bad_pins[] = {17, 54};
+    int pins[GPIOCHIP_LINES_MAX + 1] = {0};
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_request_lines(&lines, bad_pins, 2, 0, GPIO_EDGE_NONE));
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_request_lines(&lines, pins, 0, 0, GPIO_EDGE_NONE));
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_request_lines(&lines, pins, GPIOCHIP_LINES_MAX + 1, 0, GPIO_EDGE_NONE));
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_request_lines(NULL, pins, 1, 0, GPIO_EDGE_NONE));
+    TEST_ASSERT_EQUAL_INT(0, fake.ioctl_calls);
+
+    gpiochip_cleanup();
+}
+
+/* ============================================================================
+ * VALUE ACCESS TESTS
+ * ============================================================================ */
+
+void test_gpiochip_bulk_write_single_ioctl(void) {
+    fake_reset();
+    gpiochip_init(NULL);
+
+    gpiochip_lines_t lines;
+    int pins[] = {5, 6, 13, 19, 26};
+    gpiochip_request_lines(&lines, pins, 5, 0x1F, GPIO_EDGE_NONE);
+    int calls = fake.ioctl_calls;
+
+    TEST_ASSERT_EQUAL_INT(0, gpiochip_set_values(&lines, 0x1F, 0x15));
+    TEST_ASSERT_EQUAL_INT(calls + 1, fake.ioctl_calls);
+    TEST_ASSERT_EQUAL_UINT64(0x15, fake.values);
+
+    uint64_t bits = 0;
+    TEST_ASSERT_EQUAL_INT(0, gpiochip_get_values(&lines, 0x1F, &bits));
+    TEST_ASSERT_EQUAL_UINT64(0x15, bits);
+
+    gpiochip_release_lines(&lines);
+    gpiochip_cleanup();
+}
+
+void test_gpiochip_set_values_skips_inputs(void) {
+    fake_reset();
+    gpiochip_init(NULL);
+
+    gpiochip_lines_t lines;
+    int pins[] = {5, 6};
+    gpiochip_request_lines(&lines, pins, 2, 0x1, GPIO_EDGE_NONE);
+    int calls = fake.ioctl_calls;
+
+    /* Only line 1 selected, which is an input: no ioctl at all */
+    TEST_ASSERT_EQUAL_INT(0, gpiochip_set_values(&lines, 0x2, 0x2));
+    TEST_ASSERT_EQUAL_INT(calls, fake.ioctl_calls);
+
+    gpiochip_set_values(&lines, 0x3, 0x3);
+    TEST_ASSERT_EQUAL_UINT64(0x1, fake.values);
+
+    gpiochip_release_lines(&lines);
+    gpiochip_cleanup();
+}
+
+void test_gpiochip_values_on_released_lines(void) {
+    gpiochip_lines_t lines = { .fd = -1 };
+    uint64_t bits;
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_set_values(&lines, 1, 1));
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_get_values(&lines, 1, &bits));
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_set_values(NULL, 1, 1));
+}
+
+void test_gpiochip_line_index(void) {
+    gpiochip_lines_t lines = { .fd = -1, .num_lines = 3, .offsets = {17, 27, 22} };
+    TEST_ASSERT_EQUAL_INT(0, gpiochip_line_index(&lines, 17));
+    TEST_ASSERT_EQUAL_INT(2, gpiochip_line_index(&lines, 22));
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_line_index(&lines, 4));
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_line_index(NULL, 4));
+}
+
+/* ============================================================================
+ * EVENT TESTS
+ * ============================================================================ */
+
+void test_gpiochip_read_events_converts_records(void) {
+    fake_reset();
+    gpiochip_init(NULL);
+
+    gpiochip_lines_t lines;
+    int pins[] = {17, 27};
+    gpiochip_request_lines(&lines, pins, 2, 0, GPIO_EDGE_BOTH);
+
+    fake_queue_event(17, GPIO_V2_LINE_EVENT_RISING_EDGE, 1000);
+    fake_queue_event(27, GPIO_V2_LINE_EVENT_FALLING_EDGE, 2000);
+
+    gpio_event_t ev[8];
+    TEST_ASSERT_EQUAL_INT(2, gpiochip_read_events(&lines, ev, 8, 0));
+    TEST_ASSERT_EQUAL_INT(17, ev[0].pin);
+    TEST_ASSERT_EQUAL_INT(GPIO_EDGE_RISING, ev[0].edge);
+    TEST_ASSERT_EQUAL_UINT64(1000, ev[0].timestamp_ns);
+    TEST_ASSERT_EQUAL_INT(27, ev[1].pin);
+    TEST_ASSERT_EQUAL_INT(GPIO_EDGE_FALLING, ev[1].edge);
+    TEST_ASSERT_EQUAL_INT(1, fake.read_calls);
+
+    gpiochip_release_lines(&lines);
+    gpiochip_cleanup();
+}
+
+void test_gpiochip_read_events_batches_reads(void) {
+    fake_reset();
+    gpiochip_init(NULL);
+
+    gpiochip_lines_t lines;
+    int pins[] = {17};
+    gpiochip_request_lines(&lines, pins, 1, 0, GPIO_EDGE_RISING);
+
+    for (int i = 0; i < 40; i++) {
+        fake_queue_event(17, GPIO_V2_LINE_EVENT_RISING_EDGE, (uint64_t)i);
+    }
+
+    gpio_event_t ev[64];
+    TEST_ASSERT_EQUAL_INT(40, gpiochip_read_events(&lines, ev, 64, 0));
+    TEST_ASSERT_EQUAL_UINT64(39, ev[39].timestamp_ns);
+    /* 40 events in batches of GPIOCHIP_READ_BATCH */
+    TEST_ASSERT_EQUAL_INT((40 + GPIOCHIP_READ_BATCH - 1) / GPIOCHIP_READ_BATCH, fake.read_calls);
+
+    gpiochip_release_lines(&lines);
+    gpiochip_cleanup();
+}
+
+void test_gpiochip_read_events_respects_max(void) {
+    fake_reset();
+    gpiochip_init(NULL);
+
+    gpiochip_lines_t lines;
+    int pins[] = {17};
+    gpiochip_request_lines(&lines, pins, 1, 0, GPIO_EDGE_RISING);
+    for (int i = 0; i < 10; i++) {
+        fake_queue_event(17, GPIO_V2_LINE_EVENT_RISING_EDGE, (uint64_t)i);
+    }
+
+    gpio_event_t ev[4];
+    TEST_ASSERT_EQUAL_INT(4, gpiochip_read_events(&lines, ev, 4, 0));
+    TEST_ASSERT_EQUAL_INT(6, fake.q_count);
+
+    gpiochip_release_lines(&lines);
+    gpiochip_cleanup();
+}
+
+void test_gpiochip_read_events_timeout(void) {
+    fake_reset();
+    gpiochip_init(NULL);
+
+    gpiochip_lines_t lines;
+    int pins[] = {17};
+    gpiochip_request_lines(&lines, pins, 1, 0, GPIO_EDGE_RISING);
+
+    gpio_event_t ev[4];
+    TEST_ASSERT_EQUAL_INT(0, gpiochip_read_events(&lines, ev, 4, 0));
+    TEST_ASSERT_EQUAL_INT(0, fake.read_calls);
+    TEST_ASSERT_EQUAL_INT(-1, gpiochip_read_events(&lines, NULL, 4, 0));
+
+    gpiochip_release_lines(&lines);
+    gpiochip_cleanup();
+}
+
+void test_gpiochip_feeds_event_ring(void) {
+    fake_reset();
+    gpiochip_init(NULL);
+
+    gpiochip_lines_t lines;
+    int pins[] = {17, 27};
+    gpiochip_request_lines(&lines, pins, 2, 0, GPIO_EDGE_BOTH);
+    fake_queue_event(27, GPIO_V2_LINE_EVENT_RISING_EDGE, 555);
+
+    gpio_event_set_source(gpiochip_event_source, &lines);
+    TEST_ASSERT_EQUAL_INT(1, gpio_event_poll());
+
+    gpio_event_t ev[4];
+    TEST_ASSERT_EQUAL_INT(1, gpio_event_read(ev, 4));
+    TEST_ASSERT_EQUAL_INT(27, ev[0].pin);
+    TEST_ASSERT_EQUAL_UINT64(555, ev[0].timestamp_ns);
+
+    gpio_event_set_source(NULL, NULL);
+    gpiochip_release_lines(&lines);
+    gpiochip_cleanup();
+}
+
+/* ============================================================================
+ * GPIO BACKEND TESTS
+ * ============================================================================ */
+
+void test_gpiochip_backend_registered(void) {
+    TEST_ASSERT_EQUAL_INT(0, strcmp("gpiochip", gpio_backend_name(GPIO_BACKEND_GPIOCHIP)));
+}
+
+void test_gpiochip_backend_pin_api(void) {
+    fake_reset();
+    TEST_ASSERT_EQUAL_INT(0, gpio_init_backend(GPIO_BACKEND_GPIOCHIP));
+    TEST_ASSERT_EQUAL_INT(GPIO_BACKEND_GPIOCHIP, gpio_get_backend());
+
+    pin_mode(5, OUTPUT);
+    TEST_ASSERT_EQUAL_INT(1, fake.last_req.num_lines);
+    digital_write(5, HIGH);
+    TEST_ASSERT_EQUAL_UINT64(0x1, fake.values);
+
+    /* Adding a pin re-requests the set and keeps pin 5 driven high */
+    pin_mode(32, OUTPUT);
+    struct gpio_v2_line_request* req = &fake.last_req;
+    TEST_ASSERT_EQUAL_INT(2, req->num_lines);
+    TEST_ASSERT_EQUAL_INT(5, req->offsets[0]);
+    TEST_ASSERT_EQUAL_INT(32, req->offsets[1]);
+    TEST_ASSERT_EQUAL_INT(GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES, req->config.attrs[1].attr.id);
+    TEST_ASSERT_EQUAL_UINT64(0x1, req->config.attrs[1].attr.values);
+
+    /* Bank 1 pin maps to line index 1 */
+    fake.values = 0;
+    digital_write(32, HIGH);
+    TEST_ASSERT_EQUAL_UINT64(0x2, fake.values);
+    TEST_ASSERT_EQUAL_INT(HIGH, digital_read(32));
+    TEST_ASSERT_EQUAL_INT(LOW, digital_read(5));
+    TEST_ASSERT_EQUAL_UINT64(1ull << 32, gpio_read_all());
+
+    /* One ioctl for a multi-pin write within a bank */
+    pin_mode(6, OUTPUT);
+    int calls = fake.ioctl_calls;
+    gpio_write_mask((1ull << 5) | (1ull << 6), 0);
+    TEST_ASSERT_EQUAL_INT(calls + 1, fake.ioctl_calls);
+
+    gpio_cleanup();
+    TEST_ASSERT_EQUAL_INT(0, fake.open_fds);
+}
+
+void test_gpiochip_backend_edge_status(void) {
+    fake_reset();
+    gpio_init_backend(GPIO_BACKEND_GPIOCHIP);
+
+    gpio_set_edge_detect(17, GPIO_EDGE_RISING);
+    TEST_ASSERT_EQUAL_UINT64(GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING,
+                             fake.last_req.config.attrs[0].attr.flags);
+
+    fake_queue_event(17, GPIO_V2_LINE_EVENT_RISING_EDGE, 1);
+    fake_queue_event(17, GPIO_V2_LINE_EVENT_RISING_EDGE, 2);
+    TEST_ASSERT_EQUAL_UINT64(1ull << 17, gpio_edge_status());
+    TEST_ASSERT_EQUAL_UINT64(0, gpio_edge_status());
+
+    gpio_cleanup();
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Init tests
+    RUN_TEST(test_gpiochip_init_missing_device);
+    RUN_TEST(test_gpiochip_init_cleanup_fake);
+    RUN_TEST(test_gpiochip_request_without_init);
+
+    // Line request tests
+    RUN_TEST(test_gpiochip_request_encodes_config);
+    RUN_TEST(test_gpiochip_request_inputs_only);
+    RUN_TEST(test_gpiochip_request_invalid_args);
+
+    // Value access tests
+    RUN_TEST(test_gpiochip_bulk_write_single_ioctl);
+    RUN_TEST(test_gpiochip_set_values_skips_inputs);
+    RUN_TEST(test_gpiochip_values_on_released_lines);
+    RUN_TEST(test_gpiochip_line_index);
+
+    // Event tests
+    RUN_TEST(test_gpiochip_read_events_converts_records);
+    RUN_TEST(test_gpiochip_read_events_batches_reads);
+    RUN_TEST(test_gpiochip_read_events_respects_max);
+    RUN_TEST(test_gpiochip_read_events_timeout);
+    RUN_TEST(test_gpiochip_feeds_event_ring);
+
+    // GPIO backend tests
+    RUN_TEST(test_gpiochip_backend_registered);
+    RUN_TEST(test_gpiochip_backend_pin_api);
+    RUN_TEST(test_gpiochip_backend_edge_status);
+
+    gpiochip_set_io(NULL);
+    return UNITY_END();
+}
@@ -0,0 +1,255 @@
+/*
+ * test_rpi_hc595.c - Validation tests for rpi_hc595.h
+ *
+ * A chain of 74HC595s is modelled in the GPIO simulator observer: SER is
+ * shifted in on each SRCLK rising edge (QH' feeding the next register) and
+ * the shift stages are copied to the outputs on each RCLK rising edge.
+ * Focus: bit order along the chain, one latch per frame, stores per bit,
+ * double buffering with and without the refresh thread.
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_HC595_IMPLEMENTATION
+#include "rpi_hc595.h"
+
+#define PIN_SER   17
+#define PIN_SRCLK 27
+#define PIN_RCLK  22
+#define MAX_REGS  64
+
+/* ============================================================================
+ * CHAIN MODEL
+ * ============================================================================ */
+
+typedef struct {
+    int length;
+    uint8_t stage[MAX_REGS];    /* Shift stages, bit 0 = QA */
+    uint8_t out[MAX_REGS];      /* Latched outputs */
+    uint64_t clocks;
+    uint64_t latches;
+    uint64_t ser_changes;
+} model_t;
+
+static model_t model;
+
+static void chain_observer(void* user, uint64_t prev, uint64_t levels) {
+    model_t* m = (model_t*)user;
+    uint64_t rose = ~prev & levels;
+    if ((prev ^ levels) & (1ull << PIN_SER)) m->ser_changes++;
+
+    if (rose & (1ull << PIN_SRCLK)) {
+        int in = (int)((levels >> PIN_SER) & 1);
+        for (int r = 0; r < m->length; r++) {
+            int carry = m->stage[r] >> 7;
+            m->stage[r] = (uint8_t)((m->stage[r] << 1) | in);
+            in = carry;
+        }
+        m->clocks++;
+    }
+    if (rose & (1ull << PIN_RCLK)) {
+        memcpy(m->out, m->stage, sizeof(m->out));
+        m->latches++;
+    }
+}
+
+static void setup(gpio_ctx_t* gpio, hc595_t* chain, int length) {
+    memset(gpio, 0, sizeof(*gpio));
+    gpio_ctx_init(gpio, GPIO_BACKEND_SIM);
+    memset(&model, 0, sizeof(model));
+    model.length = length;
+    memset(model.out, 0xAA, sizeof(model.out));
+    gpio_ctx_sim_set_observer(gpio, chain_observer, &model);
+    TEST_ASSERT_EQUAL_INT(0, hc595_init(chain, gpio, PIN_SER, PIN_SRCLK, PIN_RCLK, (size_t)length));
+}
+
+static void teardown(gpio_ctx_t* gpio, hc595_t* chain) {
+    hc595_free(chain);
+    gpio_ctx_sim_set_observer(gpio, NULL, NULL);
+    gpio_ctx_cleanup(gpio);
+}
+
+/* ============================================================================
+ * SHIFTING
+ * ============================================================================ */
+
+void test_init_clears_chain(void) {
+    gpio_ctx_t gpio;
+    hc595_t chain;
+    setup(&gpio, &chain, 4);
+
+    TEST_ASSERT_EQUAL_UINT64(32, model.clocks);
+    TEST_ASSERT_EQUAL_UINT64(1, model.latches);
+    for (int r = 0; r < 4; r++) TEST_ASSERT_EQUAL_INT(0, model.out[r]);
+    TEST_ASSERT_EQUAL_INT(OUTPUT, gpio_ctx_sim_get_function(&gpio, PIN_RCLK));
+
+    hc595_t bad;
+    TEST_ASSERT_EQUAL_INT(-1, hc595_init(&bad, &gpio, PIN_SER, PIN_SER, PIN_RCLK, 4));
+    TEST_ASSERT_EQUAL_INT(-1, hc595_init(&bad, &gpio, PIN_SER, PIN_SRCLK, PIN_RCLK, 0));
+    teardown(&gpio, &chain);
+}
+
+void test_bytes_land_on_their_registers(void) {
+    gpio_ctx_t gpio;
+    hc595_t chain;
+    setup(&gpio, &chain, 8);
+
+    const uint8_t data[8] = { 0x01, 0x80, 0xA5, 0x5A, 0xFF, 0x00, 0x3C, 0xC3 };
+    TEST_ASSERT_EQUAL_INT(0, hc595_write(&chain, data));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(model.out, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT64(2, model.latches);
+    TEST_ASSERT_EQUAL_UINT64(8 * 8 * 2, model.clocks);
+    TEST_ASSERT_EQUAL_UINT64(8, chain.bytes - 8);
+    teardown(&gpio, &chain);
+}
+
+void test_two_stores_per_bit_one_latch(void) {
+    gpio_ctx_t gpio;
+    hc595_t chain;
+    setup(&gpio, &chain, 16);
+
+    uint8_t data[16];
+    for (int i = 0; i < 16; i++) data[i] = (uint8_t)(i * 29 + 7);
+    uint64_t writes = gpio.stats.writes;
+    model.ser_changes = 0;
+    hc595_write(&chain, data);
+
+    /* 16 stores per byte, RCLK up, RCLK and SRCLK down */
+    TEST_ASSERT_EQUAL_UINT64(16 * 16 + 2, gpio.stats.writes - writes);
+    /* SER only moves where consecutive bits differ */
+    uint64_t changes = 0;
+    int prev = 0;
+    for (int n = 15; n >= 0; n--) {
+        for (int i = 7; i >= 0; i--) {
+            int bit = (data[n] >> i) & 1;
+            changes += bit != prev;
+            prev = bit;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT64(changes, model.ser_changes);
+    TEST_ASSERT_EQUAL_UINT64(2, model.latches);
+    teardown(&gpio, &chain);
+}
+
+void test_clock_rounding(void) {
+    gpio_ctx_t gpio;
+    hc595_t chain;
+    setup(&gpio, &chain, 1);
+
+    TEST_ASSERT_EQUAL_INT(1000000, hc595_set_clock(&chain, 1000000));
+    TEST_ASSERT_EQUAL_INT(500, chain.half_period_ns);
+    TEST_ASSERT_EQUAL_INT(0, hc595_set_clock(&chain, 0));
+
+    /* Paced at 1 MHz a byte takes 8 us */
+    hc595_set_clock(&chain, 1000000);
+    const uint8_t b = 0x42;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    hc595_write(&chain, &b);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    long ns = (t1.tv_sec - t0.tv_sec) * 1000000000L + (t1.tv_nsec - t0.tv_nsec);
+    TEST_ASSERT_GREATER_OR_EQUAL(8500, ns);
+    TEST_ASSERT_EQUAL_INT(0x42, model.out[0]);
+    teardown(&gpio, &chain);
+}
+
+/* ============================================================================
+ * DOUBLE BUFFERING
+ * ============================================================================ */
+
+void test_swap_without_thread(void) {
+    gpio_ctx_t gpio;
+    hc595_t chain;
+    setup(&gpio, &chain, 4);
+
+    hc595_set_output(&chain, 0, 1);     /* Register 0, QA */
+    hc595_set_output(&chain, 31, 1);    /* Register 3, QH */
+    TEST_ASSERT_EQUAL_INT(0, model.out[0]);
+    TEST_ASSERT_EQUAL_INT(0, hc595_swap(&chain));
+    TEST_ASSERT_EQUAL_INT(0x01, model.out[0]);
+    TEST_ASSERT_EQUAL_INT(0x80, model.out[3]);
+
+    /* The new back buffer starts from the published frame */
+    hc595_set_output(&chain, 0, 0);
+    hc595_set_output(&chain, 9, 1);
+    hc595_swap(&chain);
+    TEST_ASSERT_EQUAL_INT(0x00, model.out[0]);
+    TEST_ASSERT_EQUAL_INT(0x02, model.out[1]);
+    TEST_ASSERT_EQUAL_INT(0x80, model.out[3]);
+    teardown(&gpio, &chain);
+}
+
+static void wait_frames(hc595_t* chain, uint64_t frames) {
+    hc595_stats_t st;
+    for (int i = 0; i < 2000; i++) {
+        hc595_get_stats(chain, &st);
+        if (st.frames >= frames) return;
+        usleep(500);
+    }
+}
+
+void test_refresh_thread(void) {
+    gpio_ctx_t gpio;
+    hc595_t chain;
+    setup(&gpio, &chain, 8);
+
+    TEST_ASSERT_EQUAL_INT(-1, hc595_start(&chain, 0.0, -1));
+    TEST_ASSERT_EQUAL_INT(0, hc595_start(&chain, 1000.0, -1));
+    TEST_ASSERT_EQUAL_INT(-1, hc595_start(&chain, 1000.0, -1));
+    TEST_ASSERT_EQUAL_INT(-1, hc595_write(&chain, hc595_back(&chain)));
+
+    hc595_stats_t st;
+    for (int f = 1; f <= 5; f++) {
+        memset(hc595_back(&chain), f * 0x11, 8);
+        TEST_ASSERT_EQUAL_INT(0, hc595_swap(&chain));
+        hc595_get_stats(&chain, &st);
+        wait_frames(&chain, st.frames + 2);
+        for (int r = 0; r < 8; r++) TEST_ASSERT_EQUAL_INT(f * 0x11, model.out[r]);
+    }
+    wait_frames(&chain, 50);
+    hc595_stop(&chain);
+    TEST_ASSERT_EQUAL_INT(0, chain.realtime);  /* Unpinned refresh stays normal */
+
+    hc595_get_stats(&chain, &st);
+    TEST_ASSERT_EQUAL_UINT64(5, st.swaps);
+    TEST_ASSERT_GREATER_OR_EQUAL(50, st.frames);
+    TEST_ASSERT_EQUAL_UINT64(st.frames + 1, model.latches);
+    TEST_ASSERT_GREATER_THAN(0, st.last_frame_ns);
+    /* Missed ticks on a loaded host lower the rate but never raise it */
+    TEST_ASSERT_LESS_THAN(1100.0, hc595_refresh_rate(&chain));
+    TEST_ASSERT_GREATER_THAN(0.0, hc595_refresh_rate(&chain));
+    teardown(&gpio, &chain);
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Shifting
+    RUN_TEST(test_init_clears_chain);
+    RUN_TEST(test_bytes_land_on_their_registers);
+    RUN_TEST(test_two_stores_per_bit_one_latch);
+    RUN_TEST(test_clock_rounding);
+
+    // Double buffering
+    RUN_TEST(test_swap_without_thread);
+    RUN_TEST(test_refresh_thread);
+
+    return UNITY_END();
+}
@@ -0,0 +1,335 @@
+/*
+ * test_rpi_hub75.c - Validation tests for rpi_hub75.h
+ *
+ * A HUB75 panel is modelled in the GPIO simulator observer: each CLK rising
+ * edge shifts one R1-B2 code into the column registers (the first column
+ * shifted ends up at x = 0), each LAT rising edge latches them into the row
+ * on A-E, and the time OE spends low is credited to the latch before it.
+ * Focus: emitted bitplanes against the framebuffer, plane order and
+ * depth, stores per column, lit time per plane and the refresh thread.
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_HUB75_IMPLEMENTATION
+#include "rpi_hub75.h"
+
+#define WIDTH      16
+#define HEIGHT     16
+#define ROWS       (HEIGHT / 2)
+#define MAX_EVENTS 4096
+
+static const hub75_pins_t pins = HUB75_PINS_REGULAR;
+
+/* ============================================================================
+ * PANEL MODEL
+ * ============================================================================ */
+
+typedef struct {
+    int row;
+    uint8_t code[WIDTH];    /* R1 G1 B1 R2 G2 B2 in bits 0-5 */
+    uint64_t lit_ns;
+} latch_t;
+
+typedef struct {
+    uint8_t shift[WIDTH];
+    latch_t events[MAX_EVENTS];
+    int count;
+    uint64_t clocks;
+    uint64_t lit_since;
+    uint64_t row_latches[ROWS];
+    uint8_t shown[ROWS][8][WIDTH];  /* Last data latched per row and plane (depth 8) */
+} model_t;
+
+static model_t model;
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int level(uint64_t levels, int pin) {
+    return (int)((levels >> pin) & 1);
+}
+
+static void panel_observer(void* user, uint64_t prev, uint64_t levels) {
+    model_t* m = (model_t*)user;
+    uint64_t rose = ~prev & levels;
+    uint64_t fell = prev & ~levels;
+
+    if (rose & (1ull << pins.clk)) {
+        const int data[6] = { pins.r1, pins.g1, pins.b1, pins.r2, pins.g2, pins.b2 };
+        uint8_t code = 0;
+        for (int c = 0; c < 6; c++) code |= (uint8_t)(level(levels, data[c]) << c);
+        memmove(m->shift, m->shift + 1, WIDTH - 1);
+        m->shift[WIDTH - 1] = code;
+        m->clocks++;
+    }
+    if (rose & (1ull << pins.oe)) {
+        if (m->count > 0 && m->lit_since) m->events[m->count - 1].lit_ns += mono_ns() - m->lit_since;
+        m->lit_since = 0;
+    }
+    if (rose & (1ull << pins.lat)) {
+        TEST_ASSERT_TRUE(level(levels, pins.oe));
+        int row = 0;
+        for (int a = 0; a < 3; a++) row |= level(levels, pins.addr[a]) << a;
+        memcpy(m->shown[row][m->row_latches[row]++ % 8], m->shift, WIDTH);
+        if (m->count < MAX_EVENTS) {
+            latch_t* e = &m->events[m->count++];
+            e->row = row;
+            memcpy(e->code, m->shift, WIDTH);
+            e->lit_ns = 0;
+        }
+    }
+    if (fell & (1ull << pins.oe)) m->lit_since = mono_ns();
+}
+
+static void setup(gpio_ctx_t* gpio, hub75_t* panel) {
+    memset(gpio, 0, sizeof(*gpio));
+    gpio_ctx_init(gpio, GPIO_BACKEND_SIM);
+    memset(&model, 0, sizeof(model));
+    gpio_ctx_sim_set_observer(gpio, panel_observer, &model);
+    TEST_ASSERT_EQUAL_INT(0, hub75_init(panel, gpio, NULL, WIDTH, HEIGHT));
+}
+
+static void teardown(gpio_ctx_t* gpio, hub75_t* panel) {
+    hub75_free(panel);
+    gpio_ctx_sim_set_observer(gpio, NULL, NULL);
+    gpio_ctx_cleanup(gpio);
+}
+
+static void random_fill(hub75_t* panel, unsigned seed) {
+    srand(seed);
+    uint8_t* px = hub75_pixels(panel);
+    for (int i = 0; i < WIDTH * HEIGHT * 3; i++) px[i] = (uint8_t)rand();
+}
+
+/* Code the panel should latch for column x of scan row, plane k */
+static uint8_t expected_code(hub75_t* panel, int row, int x, int k) {
+    const uint8_t* top = hub75_pixels(panel) + ((size_t)row * WIDTH + x) * 3;
+    const uint8_t* bot = top + (size_t)ROWS * WIDTH * 3;
+    uint8_t code = 0;
+    for (int c = 0; c < 3; c++) {
+        code |= (uint8_t)(((top[c] >> k) & 1) << c);
+        code |= (uint8_t)(((bot[c] >> k) & 1) << (c + 3));
+    }
+    return code;
+}
+
+static void check_frame(hub75_t* panel, int first_event, int depth) {
+    int e = first_event;
+    for (int row = 0; row < ROWS; row++) {
+        for (int k = 8 - depth; k < 8; k++, e++) {
+            TEST_ASSERT_EQUAL_INT(row, model.events[e].row);
+            for (int x = 0; x < WIDTH; x++) {
+                TEST_ASSERT_EQUAL_INT(expected_code(panel, row, x, k), model.events[e].code[x]);
+            }
+        }
+    }
+}
+
+/* ============================================================================
+ * PATTERNS
+ * ============================================================================ */
+
+void test_init_validation(void) {
+    gpio_ctx_t gpio;
+    hub75_t panel;
+    setup(&gpio, &panel);
+
+    TEST_ASSERT_EQUAL_INT(OUTPUT, gpio_ctx_sim_get_function(&gpio, pins.oe));
+    TEST_ASSERT_EQUAL_INT(OUTPUT, gpio_ctx_sim_get_function(&gpio, pins.addr[2]));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, pins.oe));
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&gpio, pins.clk));
+
+    hub75_t bad;
+    hub75_pins_t dup = HUB75_PINS_REGULAR;
+    dup.lat = dup.clk;
+    hub75_pins_t high = HUB75_PINS_REGULAR;
+    high.oe = 40;
+    TEST_ASSERT_EQUAL_INT(-1, hub75_init(&bad, &gpio, NULL, WIDTH, 24));
+    TEST_ASSERT_EQUAL_INT(-1, hub75_init(&bad, &gpio, NULL, 0, HEIGHT));
+    TEST_ASSERT_EQUAL_INT(-1, hub75_init(&bad, &gpio, &dup, WIDTH, HEIGHT));
+    TEST_ASSERT_EQUAL_INT(-1, hub75_init(&bad, &gpio, &high, WIDTH, HEIGHT));
+    TEST_ASSERT_EQUAL_INT(-1, hub75_set_depth(&panel, 0));
+    TEST_ASSERT_EQUAL_INT(-1, hub75_set_depth(&panel, 9));
+    TEST_ASSERT_EQUAL_INT(-1, hub75_set_timing(&panel, 0, 0));
+    teardown(&gpio, &panel);
+}
+
+void test_bitplanes_match_framebuffer(void) {
+    gpio_ctx_t gpio;
+    hub75_t panel;
+    setup(&gpio, &panel);
+
+    random_fill(&panel, 75);
+    TEST_ASSERT_EQUAL_INT(0, hub75_swap(&panel));
+    TEST_ASSERT_EQUAL_INT(0, hub75_refresh(&panel));
+
+    TEST_ASSERT_EQUAL_INT(ROWS * 8, model.count);
+    TEST_ASSERT_EQUAL_UINT64(ROWS * 8 * WIDTH, model.clocks);
+    check_frame(&panel, 0, 8);
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, pins.oe));
+    teardown(&gpio, &panel);
+}
+
+void test_depth_plays_top_planes(void) {
+    gpio_ctx_t gpio;
+    hub75_t panel;
+    setup(&gpio, &panel);
+
+    random_fill(&panel, 7);
+    hub75_set_pixel(&panel, 3, 12, 0xF0, 0x0F, 0x81);
+    hub75_swap(&panel);
+    TEST_ASSERT_EQUAL_INT(0, hub75_set_depth(&panel, 3));
+    hub75_refresh(&panel);
+
+    TEST_ASSERT_EQUAL_INT(ROWS * 3, model.count);
+    check_frame(&panel, 0, 3);
+    teardown(&gpio, &panel);
+}
+
+void test_two_stores_per_column(void) {
+    gpio_ctx_t gpio;
+    hub75_t panel;
+    setup(&gpio, &panel);
+
+    random_fill(&panel, 1);
+    hub75_swap(&panel);
+    hub75_set_depth(&panel, 4);
+    uint64_t writes = gpio.stats.writes;
+    hub75_refresh(&panel);
+
+    /* Per row and plane: 2 per column, blank, address + latch, show; one final blank */
+    TEST_ASSERT_EQUAL_UINT64(ROWS * 4 * (2 * WIDTH + 3) + 1, gpio.stats.writes - writes);
+    teardown(&gpio, &panel);
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+void test_plane_lit_times(void) {
+    gpio_ctx_t gpio;
+    hub75_t panel;
+    setup(&gpio, &panel);
+
+    /* Time one plane's shift, then light the lowest plane for half of it */
+    hub75_set_depth(&panel, 1);
+    hub75_set_timing(&panel, 1, 0);
+    uint64_t t0 = mono_ns();
+    hub75_refresh(&panel);
+    const uint64_t base = (mono_ns() - t0) / ROWS / 2;
+
+    model.count = 0;
+    hub75_set_depth(&panel, 4);
+    TEST_ASSERT_EQUAL_INT(0, hub75_set_timing(&panel, (uint32_t)base, 0));
+    hub75_refresh(&panel);
+    TEST_ASSERT_EQUAL_INT(ROWS * 4, model.count);
+
+    /* Median over the rows of each plane, robust to a preempted row */
+    uint64_t median[4];
+    for (int k = 0; k < 4; k++) {
+        uint64_t lit[ROWS];
+        for (int r = 0; r < ROWS; r++) lit[r] = model.events[r * 4 + k].lit_ns;
+        qsort(lit, ROWS, sizeof(lit[0]), cmp_u64);
+        median[k] = lit[ROWS / 2];
+        TEST_ASSERT_GREATER_OR_EQUAL(base << k, median[k]);
+    }
+    /* Blanked mid-shift: not stretched to the shift time, and 2:1 between planes */
+    TEST_ASSERT_LESS_THAN(base * 3 / 2, median[0]);
+    for (int k = 1; k < 4; k++) {
+        double ratio = (double)median[k] / (double)median[k - 1];
+        TEST_ASSERT(ratio > 1.7 && ratio < 2.3);
+    }
+    teardown(&gpio, &panel);
+}
+
+/* ============================================================================
+ * REFRESH THREAD
+ * ============================================================================ */
+
+static void wait_frames(hub75_t* panel, uint64_t frames) {
+    hub75_stats_t st;
+    for (int i = 0; i < 4000; i++) {
+        hub75_get_stats(panel, &st);
+        if (st.frames >= frames) return;
+        usleep(500);
+    }
+}
+
+void test_refresh_thread(void) {
+    gpio_ctx_t gpio;
+    hub75_t panel;
+    setup(&gpio, &panel);
+
+    TEST_ASSERT_EQUAL_INT(0, hub75_start(&panel, -1));
+    TEST_ASSERT_EQUAL_INT(-1, hub75_start(&panel, -1));
+    TEST_ASSERT_EQUAL_INT(-1, hub75_refresh(&panel));
+    TEST_ASSERT_EQUAL_INT(-1, hub75_set_depth(&panel, 4));
+
+    hub75_stats_t st;
+    for (unsigned f = 1; f <= 3; f++) {
+        random_fill(&panel, f);
+        TEST_ASSERT_EQUAL_INT(0, hub75_swap(&panel));
+        hub75_get_stats(&panel, &st);
+        wait_frames(&panel, st.frames + 2);
+        for (int row = 0; row < ROWS; row++) {
+            for (int k = 0; k < 8; k++) {
+                for (int x = 0; x < WIDTH; x++) {
+                    TEST_ASSERT_EQUAL_INT(expected_code(&panel, row, x, k), model.shown[row][k][x]);
+                }
+            }
+        }
+    }
+    wait_frames(&panel, 20);
+    hub75_stop(&panel);
+
+    hub75_get_stats(&panel, &st);
+    TEST_ASSERT_EQUAL_UINT64(3, st.swaps);
+    TEST_ASSERT_GREATER_OR_EQUAL(20, st.frames);
+    TEST_ASSERT_GREATER_THAN(0, st.max_frame_ns);
+    /* At least the nominal 255 base periods per row of every full frame */
+    TEST_ASSERT_GREATER_OR_EQUAL((st.frames - 1) * ROWS * 255ull * panel.base_ns, st.lit_ns);
+    TEST_ASSERT_LESS_THAN(st.end_ns - st.start_ns, st.lit_ns);
+    TEST_ASSERT_GREATER_THAN(0.0, hub75_refresh_rate(&panel));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, pins.oe));
+    teardown(&gpio, &panel);
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Patterns
+    RUN_TEST(test_init_validation);
+    RUN_TEST(test_bitplanes_match_framebuffer);
+    RUN_TEST(test_depth_plays_top_planes);
+    RUN_TEST(test_two_stores_per_column);
+    RUN_TEST(test_plane_lit_times);
+
+    // Refresh thread
+    RUN_TEST(test_refresh_thread);
+
+    return UNITY_END();
+}
@@ -414,6 +414,586 @@ void test_hpwm_stress_all_pins_rapid(void) {
     TEST_PASS();
 }
 
+/* ============================================================================
+ * CONTEXT TESTS (register blocks in RAM)
+ * ============================================================================ */
+
+static uint32_t fake_pwm[16];
+static uint32_t fake_clk[64];
+
+static void attach_fake(hpwm_ctx_t* ctx, gpio_ctx_t* gpio) {
+    memset(fake_pwm, 0, sizeof(fake_pwm));
+    memset(fake_clk, 0, sizeof(fake_clk));
+    TEST_ASSERT_EQUAL_INT(0, hpwm_ctx_attach(ctx, fake_pwm, fake_clk, gpio));
+}
+
+void test_hpwm_ctx_attach_programs_clock(void) {
+    hpwm_ctx_t ctx;
+    attach_fake(&ctx, NULL);
+    TEST_ASSERT_EQUAL_UINT64(CM_PASSWD | (CM_DIV_VALUE << 12), fake_clk[CM_PWMDIV]);
+    TEST_ASSERT_EQUAL_UINT64(CM_PASSWD | CM_SRC_OSC | CM_ENAB, fake_clk[CM_PWMCTL]);
+    TEST_ASSERT_EQUAL_INT(0, ctx.mapped);
+    hpwm_ctx_stop(&ctx);
+}
+
+void test_hpwm_ctx_set_channel_registers(void) {
+    gpio_ctx_t gpio = {0};
+    hpwm_ctx_t ctx;
+    gpio_ctx_init(&gpio, GPIO_BACKEND_SIM);
+    attach_fake(&ctx, &gpio);
+
+    hpwm_ctx_set(&ctx, 18, 1000, 250);  /* PLLD / 6 = 125 MHz */
+    TEST_ASSERT_EQUAL_UINT64(125000, fake_pwm[PWM_RNG1]);
+    TEST_ASSERT_EQUAL_UINT64(31250, fake_pwm[PWM_DAT1]);
+    TEST_ASSERT_EQUAL_UINT64(PWM_CTL_MSEN1 | PWM_CTL_PWEN1, fake_pwm[PWM_CTL]);
+    TEST_ASSERT_EQUAL_INT(ALT5, gpio_ctx_sim_get_function(&gpio, 18));
+
+    hpwm_ctx_set(&ctx, 13, 2000, 2000);  /* Duty clamped to 1000 */
+    TEST_ASSERT_EQUAL_UINT64(62500, fake_pwm[PWM_RNG2]);
+    TEST_ASSERT_EQUAL_UINT64(62500, fake_pwm[PWM_DAT2]);
+    TEST_ASSERT_EQUAL_UINT64(PWM_CTL_MSEN1 | PWM_CTL_PWEN1 | PWM_CTL_MSEN2 | PWM_CTL_PWEN2,
+                             fake_pwm[PWM_CTL]);
+    TEST_ASSERT_EQUAL_INT(ALT0, gpio_ctx_sim_get_function(&gpio, 13));
+    TEST_ASSERT_EQUAL_UINT64(2, ctx.updates);
+
+    hpwm_ctx_stop(&ctx);
+    TEST_ASSERT_EQUAL_UINT64(0, fake_pwm[PWM_CTL]);
+    TEST_ASSERT_NULL(ctx.pwm);
+    gpio_ctx_cleanup(&gpio);
+}
+
+void test_hpwm_ctx_rejects_invalid_input(void) {
+    hpwm_ctx_t ctx;
+    attach_fake(&ctx, NULL);
+
+    hpwm_ctx_set(&ctx, 17, 1000, 500);   /* Not a PWM pin */
+    hpwm_ctx_set(&ctx, 18, 0, 500);      /* Invalid frequency */
+    TEST_ASSERT_EQUAL_UINT64(0, fake_pwm[PWM_CTL]);
+    TEST_ASSERT_EQUAL_UINT64(0, ctx.updates);
+
+    hpwm_ctx_stop(&ctx);
+    hpwm_ctx_set(&ctx, 18, 1000, 500);   /* Stopped context */
+    TEST_ASSERT_EQUAL_UINT64(0, ctx.updates);
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_ctx_attach(&ctx, NULL, fake_clk, NULL));
+}
+
+void test_hpwm_ctx_duty_only_update(void) {
+    hpwm_ctx_t ctx;
+    attach_fake(&ctx, NULL);
+
+    hpwm_ctx_set(&ctx, 18, 1000, 250);
+    TEST_ASSERT_EQUAL_UINT64(1, ctx.reconfigs);
+    fake_pwm[PWM_RNG1] = 0xDEAD;  /* Would be overwritten by a full reconfigure */
+
+    TEST_ASSERT_EQUAL_INT(0, hpwm_ctx_set_duty(&ctx, 18, 600));
+    TEST_ASSERT_EQUAL_UINT64(75000, fake_pwm[PWM_DAT1]);
+    TEST_ASSERT_EQUAL_UINT64(0xDEAD, fake_pwm[PWM_RNG1]);
+
+    hpwm_ctx_set(&ctx, 18, 1000, 700);  /* Same frequency takes the duty path too */
+    TEST_ASSERT_EQUAL_UINT64(87500, fake_pwm[PWM_DAT1]);
+    TEST_ASSERT_EQUAL_UINT64(0xDEAD, fake_pwm[PWM_RNG1]);
+    TEST_ASSERT_EQUAL_UINT64(1, ctx.reconfigs);
+    TEST_ASSERT_EQUAL_UINT64(3, ctx.updates);
+
+    hpwm_ctx_set(&ctx, 18, 2000, 500);  /* New frequency reconfigures */
+    TEST_ASSERT_EQUAL_UINT64(62500, fake_pwm[PWM_RNG1]);
+    TEST_ASSERT_EQUAL_UINT64(31250, fake_pwm[PWM_DAT1]);
+    TEST_ASSERT_EQUAL_UINT64(2, ctx.reconfigs);
+
+    TEST_ASSERT_EQUAL_INT(0, hpwm_ctx_set_duty(&ctx, 18, 2000));  /* Clamped */
+    TEST_ASSERT_EQUAL_UINT64(62500, fake_pwm[PWM_DAT1]);
+    hpwm_ctx_stop(&ctx);
+}
+
+void test_hpwm_ctx_skips_redundant_writes(void) {
+    gpio_ctx_t gpio = {0};
+    hpwm_ctx_t ctx;
+    gpio_ctx_init(&gpio, GPIO_BACKEND_SIM);
+    attach_fake(&ctx, &gpio);
+
+    hpwm_ctx_set(&ctx, 13, 1000, 400);
+    gpio_ctx_set_function(&gpio, 13, INPUT);  /* Mux is cached, so it stays untouched */
+    fake_pwm[PWM_DAT2] = 0;
+
+    hpwm_ctx_set(&ctx, 13, 1000, 400);
+    TEST_ASSERT_EQUAL_INT(0, hpwm_ctx_set_duty(&ctx, 13, 400));
+    TEST_ASSERT_EQUAL_UINT64(1, ctx.updates);
+    TEST_ASSERT_EQUAL_UINT64(0, fake_pwm[PWM_DAT2]);
+    TEST_ASSERT_EQUAL_INT(INPUT, gpio_ctx_sim_get_function(&gpio, 13));
+
+    hpwm_ctx_stop(&ctx);
+    gpio_ctx_cleanup(&gpio);
+}
+
+void test_hpwm_ctx_set_duty_requires_configured_pin(void) {
+    hpwm_ctx_t ctx;
+    attach_fake(&ctx, NULL);
+
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_ctx_set_duty(&ctx, 18, 500));  /* No frequency yet */
+    hpwm_ctx_set(&ctx, 18, 1000, 500);
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_ctx_set_duty(&ctx, 12, 500));  /* Same channel, other pin */
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_ctx_set_duty(&ctx, 19, 500));  /* Other channel */
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_ctx_set_duty(&ctx, 17, 500));  /* Not a PWM pin */
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_ctx_set_duty(NULL, 18, 500));
+
+    hpwm_ctx_stop(&ctx);
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_ctx_set_duty(&ctx, 18, 500));
+}
+
+static double rel_error(double got, double want) {
+    double e = (got - want) / want;
+    return e < 0 ? -e : e;
+}
+
+void test_hpwm_plan_low_frequency_uses_fastest_integer_clock(void) {
+    hpwm_plan_t p;
+    TEST_ASSERT_EQUAL_INT(0, hpwm_plan(1000, 0, &p));
+    TEST_ASSERT_EQUAL_INT(CM_SRC_PLLD, p.src);
+    TEST_ASSERT_EQUAL_UINT64(6, p.divi);
+    TEST_ASSERT_EQUAL_INT(0, p.mash);
+    TEST_ASSERT_EQUAL_UINT64(125000, p.range[0]);
+    TEST_ASSERT_EQUAL_UINT64(0, p.range[1]);
+    TEST_ASSERT_TRUE(rel_error(p.freq_hz[0], 1000.0) < 1e-9);
+}
+
+void test_hpwm_plan_100khz_resolution(void) {
+    hpwm_plan_t p;
+    TEST_ASSERT_EQUAL_INT(0, hpwm_plan(0, 100000, &p));
+    TEST_ASSERT_EQUAL_UINT64(1250, p.range[1]);  /* 10 steps with the fixed 1 MHz clock */
+    TEST_ASSERT_EQUAL_INT(0, p.mash);
+    TEST_ASSERT_TRUE(rel_error(p.freq_hz[1], 100000.0) < 1e-9);
+}
+
+void test_hpwm_plan_fractional_divider(void) {
+    /* 125 MHz / 7 MHz = 17.86: no integer divider is within tolerance at 17+ steps */
+    hpwm_plan_t p;
+    TEST_ASSERT_EQUAL_INT(0, hpwm_plan(7000000, 0, &p));
+    TEST_ASSERT_EQUAL_INT(1, p.mash);
+    TEST_ASSERT_TRUE(p.divf > 0 && p.divf < 4096);
+    TEST_ASSERT_EQUAL_UINT64(17, p.range[0]);
+    TEST_ASSERT_TRUE(rel_error(p.freq_hz[0], 7000000.0) < HPWM_PLAN_TOLERANCE_PPM / 1e6);
+    TEST_ASSERT_TRUE(p.clock_hz <= HPWM_CLOCK_MAX_HZ);
+}
+
+void test_hpwm_plan_two_channels_share_clock(void) {
+    hpwm_plan_t p;
+    TEST_ASSERT_EQUAL_INT(0, hpwm_plan(50, 7000000, &p));
+    TEST_ASSERT_EQUAL_UINT64(17, p.range[1]);
+    TEST_ASSERT_TRUE(rel_error(p.freq_hz[0], 50.0) < HPWM_PLAN_TOLERANCE_PPM / 1e6);
+    TEST_ASSERT_TRUE(rel_error(p.freq_hz[1], 7000000.0) < HPWM_PLAN_TOLERANCE_PPM / 1e6);
+    TEST_ASSERT_TRUE(rel_error(p.clock_hz / p.range[0], p.freq_hz[0]) < 1e-12);
+}
+
+void test_hpwm_plan_rejects_invalid(void) {
+    hpwm_plan_t p;
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_plan(0, 0, &p));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_plan(-1, 1000, &p));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_plan(HPWM_CLOCK_MAX_HZ, 0, &p));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_plan(1000, 0, NULL));
+    TEST_ASSERT_EQUAL_INT(0, hpwm_plan(HPWM_CLOCK_MAX_HZ / 2, 0, &p));
+    TEST_ASSERT_EQUAL_UINT64(2, p.range[0]);
+}
+
+void test_hpwm_ctx_set_replans_clock(void) {
+    hpwm_ctx_t ctx;
+    attach_fake(&ctx, NULL);
+
+    hpwm_ctx_set(&ctx, 18, 1000, 250);
+    TEST_ASSERT_EQUAL_UINT64(CM_PASSWD | (6 << 12), fake_clk[CM_PWMDIV]);
+    TEST_ASSERT_EQUAL_UINT64(CM_PASSWD | CM_SRC_PLLD | CM_ENAB, fake_clk[CM_PWMCTL]);
+
+    hpwm_ctx_set(&ctx, 19, 7000000, 500);  /* Needs a fractional clock */
+    hpwm_plan_t p;
+    hpwm_plan(1000, 7000000, &p);
+    TEST_ASSERT_EQUAL_UINT64(CM_PASSWD | (p.divi << 12) | p.divf, fake_clk[CM_PWMDIV]);
+    TEST_ASSERT_EQUAL_UINT64(CM_PASSWD | (1 << CM_MASH_SHIFT) | CM_SRC_PLLD | CM_ENAB,
+                             fake_clk[CM_PWMCTL]);
+
+    /* Channel 1 was rescaled to the new clock and kept its 25% duty */
+    TEST_ASSERT_EQUAL_UINT64(p.range[0], fake_pwm[PWM_RNG1]);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)p.range[0] / 4, fake_pwm[PWM_DAT1]);
+    TEST_ASSERT_EQUAL_UINT64(p.range[1], fake_pwm[PWM_RNG2]);
+    TEST_ASSERT_EQUAL_UINT64(PWM_CTL_MSEN1 | PWM_CTL_PWEN1 | PWM_CTL_MSEN2 | PWM_CTL_PWEN2,
+                             fake_pwm[PWM_CTL]);
+    TEST_ASSERT_EQUAL_UINT64(p.divi, ctx.plan.divi);
+    hpwm_ctx_stop(&ctx);
+}
+
+/* ============================================================================
+ * FIFO STREAMING TESTS (simulated PWM block + DMA)
+ * ============================================================================ */
+
+#define STREAM_LOG 1024
+static hpwm_sim_t pwm_sim;
+static dma_sim_t dma_sim;
+static uint32_t pwm_log[STREAM_LOG];
+
+static void stream_setup(hpwm_ctx_t* ctx, dma_chan_t* dma) {
+    dma_sim_dev_t dev;
+    hpwm_sim_init(&pwm_sim, pwm_log, STREAM_LOG);
+    dma_sim_init(&dma_sim);
+    hpwm_sim_device(&pwm_sim, &dev);
+    TEST_ASSERT_EQUAL_INT(0, dma_sim_add_device(&dma_sim, &dev));
+    TEST_ASSERT_EQUAL_INT(0, hpwm_ctx_attach(ctx, pwm_sim.pwm, pwm_sim.clk, NULL));
+    TEST_ASSERT_EQUAL_INT(0, dma_chan_attach(dma, dma_sim.regs, DMA_CHANNEL_DEFAULT));
+}
+
+static double pwm_sim_clock_hz(void) {
+    uint32_t div = pwm_sim.clk[CM_PWMDIV];
+    double src = (pwm_sim.clk[CM_PWMCTL] & 0xF) == CM_SRC_PLLD ? HPWM_PLLD_HZ : HPWM_OSC_HZ;
+    return src * 4096.0 / (((div >> 12) & 0xFFF) * 4096.0 + (div & 0xFFF));
+}
+
+/* Virtual time for n PWM periods of the stream */
+static uint64_t stream_periods(const hpwm_stream_t* st, int n) {
+    return (uint64_t)(n * (st->range * 1e9 / pwm_sim_clock_hz())) + 1;
+}
+
+static uint32_t stream_scaled(const hpwm_stream_t* st, uint16_t sample) {
+    return (uint32_t)(((uint64_t)sample * st->scale) >> 32);
+}
+
+void test_hpwm_stream_plays_samples_in_order(void) {
+    hpwm_ctx_t ctx;
+    dma_chan_t dma;
+    hpwm_stream_t st;
+    uint16_t samples[256];
+    stream_setup(&ctx, &dma);
+    for (int i = 0; i < 256; i++) samples[i] = (uint16_t)(i * 251);
+
+    hpwm_stream_config_t cfg = { 18, 48000, 32, 4 };
+    TEST_ASSERT_EQUAL_INT(0, hpwm_stream_open(&st, &ctx, &dma, &cfg));
+    TEST_ASSERT_EQUAL_UINT64(2604, st.range);  /* 125 MHz / 48 kHz */
+    TEST_ASSERT_TRUE(pwm_sim.pwm[PWM_CTL] & PWM_CTL_USEF1);
+
+    TEST_ASSERT_EQUAL_INT(128, hpwm_stream_write(&st, samples, 256));  /* Ring holds 4 x 32 */
+    hpwm_stream_start(&st);
+    dma_sim_run(&dma_sim, stream_periods(&st, 64));
+    TEST_ASSERT_EQUAL_UINT64(64, pwm_sim.log_len);
+
+    /* DMA runs a FIFO ahead of the output: segments 0 and 1 are free again */
+    TEST_ASSERT_EQUAL_INT(64, hpwm_stream_poll(&st));
+    TEST_ASSERT_EQUAL_INT(64, hpwm_stream_write(&st, samples + 128, 128));
+    dma_sim_run(&dma_sim, stream_periods(&st, 128));
+
+    TEST_ASSERT_EQUAL_UINT64(192, pwm_sim.log_len);
+    for (int i = 0; i < 192; i++) {
+        TEST_ASSERT_EQUAL_UINT64(stream_scaled(&st, samples[i]), pwm_log[i]);
+    }
+    hpwm_stream_poll(&st);
+    TEST_ASSERT_EQUAL_UINT64(0, st.underruns);
+    TEST_ASSERT_EQUAL_UINT64(0, pwm_sim.empty);
+    TEST_ASSERT_EQUAL_UINT64(192, st.written);
+
+    hpwm_stream_close(&st);
+    hpwm_ctx_stop(&ctx);
+}
+
+void test_hpwm_stream_underrun_plays_idle(void) {
+    hpwm_ctx_t ctx;
+    dma_chan_t dma;
+    hpwm_stream_t st;
+    uint16_t samples[64];
+    stream_setup(&ctx, &dma);
+    for (int i = 0; i < 64; i++) samples[i] = 65535;
+
+    hpwm_stream_config_t cfg = { 13, 48000, 32, 4 };
+    TEST_ASSERT_EQUAL_INT(0, hpwm_stream_open(&st, &ctx, &dma, &cfg));
+    TEST_ASSERT_EQUAL_INT(64, hpwm_stream_write(&st, samples, 64));
+    hpwm_stream_start(&st);
+
+    /* Consumer polls once per segment but has nothing more to write */
+    for (int i = 0; i < 6; i++) {
+        dma_sim_run(&dma_sim, stream_periods(&st, 32));
+        hpwm_stream_poll(&st);
+    }
+    dma_sim_run(&dma_sim, stream_periods(&st, 8));
+    TEST_ASSERT_EQUAL_UINT64(200, pwm_sim.log_len);
+    TEST_ASSERT_EQUAL_UINT64(64, st.played);
+    TEST_ASSERT_EQUAL_UINT64(4, st.underruns);  /* Segments 2, 3, then 0, 1 of the next lap */
+    TEST_ASSERT_EQUAL_UINT64(stream_scaled(&st, 65535), pwm_log[63]);
+    for (int i = 64; i < 200; i++) TEST_ASSERT_EQUAL_UINT64(st.idle, pwm_log[i]);
+    TEST_ASSERT_EQUAL_UINT64(0, pwm_sim.empty);  /* The PWM itself never starved */
+
+    /* Late producer: the segment being played is skipped, the next one is used */
+    TEST_ASSERT_EQUAL_INT(32, hpwm_stream_write(&st, samples, 32));
+    dma_sim_run(&dma_sim, stream_periods(&st, 64));
+    int start = 7 * 32;  /* Segment 3 of the second lap */
+    TEST_ASSERT_EQUAL_UINT64(st.idle, pwm_log[start - 1]);
+    for (int i = start; i < start + 32; i++) {
+        TEST_ASSERT_EQUAL_UINT64(stream_scaled(&st, 65535), pwm_log[i]);
+    }
+
+    hpwm_stream_close(&st);
+    hpwm_ctx_stop(&ctx);
+}
+
+void test_hpwm_stream_rejects_invalid_config(void) {
+    hpwm_ctx_t ctx;
+    dma_chan_t dma;
+    hpwm_stream_t st, other;
+    stream_setup(&ctx, &dma);
+
+    hpwm_stream_config_t bad_pin = { 17, 48000, 32, 4 };
+    hpwm_stream_config_t bad_rate = { 18, 0, 32, 4 };
+    hpwm_stream_config_t bad_segments = { 18, 48000, 32, 1 };
+    hpwm_stream_config_t too_many = { 18, 48000, 32, HPWM_STREAM_MAX_SEGMENTS + 1 };
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_stream_open(&st, &ctx, &dma, &bad_pin));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_stream_open(&st, &ctx, &dma, &bad_rate));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_stream_open(&st, &ctx, &dma, &bad_segments));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_stream_open(&st, &ctx, &dma, &too_many));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_stream_open(&st, &ctx, &dma, NULL));
+
+    /* A rate the clock cannot make leaves the pin stopped, not at its old setting */
+    TEST_ASSERT_EQUAL_INT(0, hpwm_ctx_set(&ctx, 18, 1000, 500));
+    hpwm_stream_config_t too_fast = { 18, HPWM_CLOCK_MAX_HZ, 32, 4 };
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_stream_open(&st, &ctx, &dma, &too_fast));
+    TEST_ASSERT_FALSE(pwm_sim.pwm[PWM_CTL] & PWM_CTL_PWEN1);
+    TEST_ASSERT_EQUAL_INT(0, ctx.ch[0].enabled);
+
+    hpwm_stream_config_t cfg = { 18, 8000, 16, 2 };
+    TEST_ASSERT_EQUAL_INT(0, hpwm_stream_open(&st, &ctx, &dma, &cfg));
+    cfg.pin = 19;
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_stream_open(&other, &ctx, &dma, &cfg));  /* FIFO busy */
+    hpwm_stream_close(&st);
+    hpwm_ctx_stop(&ctx);
+
+    cfg.pin = 18;
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_stream_open(&st, &ctx, &dma, &cfg));  /* Stopped context */
+}
+
+void test_hpwm_stream_close_releases_channel(void) {
+    hpwm_ctx_t ctx;
+    dma_chan_t dma;
+    hpwm_stream_t st;
+    uint16_t samples[16] = {0};
+    stream_setup(&ctx, &dma);
+
+    hpwm_stream_config_t cfg = { 12, 44100, 16, 2 };
+    TEST_ASSERT_EQUAL_INT(0, hpwm_stream_open(&st, &ctx, &dma, &cfg));
+    hpwm_stream_write(&st, samples, 16);
+    hpwm_stream_start(&st);
+    dma_sim_run(&dma_sim, stream_periods(&st, 8));
+    TEST_ASSERT_TRUE(dma_chan_active(&dma));
+
+    hpwm_stream_close(&st);
+    TEST_ASSERT_FALSE(dma_chan_active(&dma));
+    TEST_ASSERT_NULL(st.samples);
+    TEST_ASSERT_EQUAL_UINT64(0, pwm_sim.pwm[PWM_DMAC]);
+    TEST_ASSERT_EQUAL_UINT64(0, pwm_sim.pwm[PWM_CTL] & (PWM_CTL_USEF1 | PWM_CTL_PWEN1));
+
+    uint64_t reads = pwm_sim.reads;
+    dma_sim_run(&dma_sim, 1000000);
+    TEST_ASSERT_EQUAL_UINT64(reads, pwm_sim.reads);
+    hpwm_ctx_stop(&ctx);
+}
+
+/* ============================================================================
+ * SERIALIZER TESTS
+ * ============================================================================ */
+
+/* Bit-by-bit reference for hpwm_serial_encode() */
+static size_t serial_reference(const uint8_t* data, size_t len, int slots,
+                               uint8_t zero, uint8_t one, uint32_t* out) {
+    size_t bit = 0;
+    size_t words = (len * 8 * slots + 31) / 32;
+    memset(out, 0, words * sizeof(uint32_t));
+    for (size_t i = 0; i < len; i++) {
+        for (int b = 7; b >= 0; b--) {
+            uint8_t pattern = (data[i] >> b) & 1 ? one : zero;
+            for (int j = slots - 1; j >= 0; j--, bit++) {
+                if ((pattern >> j) & 1) out[bit / 32] |= 1u << (31 - bit % 32);
+            }
+        }
+    }
+    return words;
+}
+
+void test_hpwm_serial_encode_matches_reference(void) {
+    static uint8_t data[3001];
+    static uint32_t got[3001], want[3001];
+    hpwm_ctx_t ctx;
+    dma_chan_t dma;
+    hpwm_serial_t ser;
+    stream_setup(&ctx, &dma);
+
+    uint32_t x = 12345;
+    for (size_t i = 0; i < sizeof(data); i++) {
+        x = x * 1103515245u + 12345u;
+        data[i] = (uint8_t)(x >> 16);
+    }
+
+    static const uint8_t zero[5] = { 0, 0x0, 0x1, 0x4, 0x8 };
+    static const uint8_t one[5] = { 0, 0x1, 0x3, 0x6, 0xE };
+    static const size_t lens[] = { 0, 1, 2, 3, 4, 5, 7, 8, 13, 3001 };
+    for (int slots = 1; slots <= 4; slots++) {
+        hpwm_serial_config_t cfg = { 18, 2400000, slots, zero[slots], one[slots], 0, 3001 };
+        TEST_ASSERT_EQUAL_INT(0, hpwm_serial_open(&ser, &ctx, &dma, &cfg));
+        for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+            size_t n = hpwm_serial_encode(&ser, data, lens[l], got);
+            TEST_ASSERT_EQUAL_UINT64(serial_reference(data, lens[l], slots, zero[slots], one[slots], want), n);
+            TEST_ASSERT_EQUAL_UINT64(hpwm_serial_words(&ser, lens[l]), n);
+            TEST_ASSERT_EQUAL_INT(0, memcmp(got, want, n * sizeof(uint32_t)));
+        }
+        hpwm_serial_close(&ser);
+    }
+    hpwm_ctx_stop(&ctx);
+}
+
+void test_hpwm_serial_ws2812_symbols(void) {
+    hpwm_ctx_t ctx;
+    dma_chan_t dma;
+    hpwm_serial_t ser;
+    stream_setup(&ctx, &dma);
+
+    hpwm_serial_config_t cfg = HPWM_SERIAL_WS2812(18, 30);
+    TEST_ASSERT_EQUAL_INT(0, hpwm_serial_open(&ser, &ctx, &dma, &cfg));
+    TEST_ASSERT_EQUAL_UINT64(0x924924, ser.lut[0x00]);  /* 100 x 8 */
+    TEST_ASSERT_EQUAL_UINT64(0xDB6DB6, ser.lut[0xFF]);  /* 110 x 8 */
+
+    const uint8_t data[4] = { 0xFF, 0x00, 0xFF, 0x00 };
+    uint32_t words[3];
+    TEST_ASSERT_EQUAL_UINT64(3, hpwm_serial_encode(&ser, data, 4, words));
+    TEST_ASSERT_EQUAL_UINT64(0xDB6DB692, words[0]);
+    TEST_ASSERT_EQUAL_UINT64(0x4924DB6D, words[1]);
+    TEST_ASSERT_EQUAL_UINT64(0xB6924924, words[2]);
+
+    /* 2.4 MHz = PLLD / 312.5 exactly; no integer divider within 0.1 % */
+    TEST_ASSERT_EQUAL_INT(CM_SRC_PLLD, ctx.plan.src);
+    TEST_ASSERT_EQUAL_UINT64(312, ctx.plan.divi);
+    TEST_ASSERT_EQUAL_UINT64(2048, ctx.plan.divf);
+    TEST_ASSERT_EQUAL_INT(1, ctx.plan.mash);
+    TEST_ASSERT_EQUAL_UINT64(23, ser.reset_words);  /* 300 us = 720 slots */
+
+    uint32_t ctl = pwm_sim.pwm[PWM_CTL];
+    TEST_ASSERT_TRUE(ctl & PWM_CTL_MODE1);
+    TEST_ASSERT_TRUE(ctl & PWM_CTL_USEF1);
+    TEST_ASSERT_TRUE(ctl & PWM_CTL_PWEN1);
+    TEST_ASSERT_FALSE(ctl & (PWM_CTL_MSEN1 | PWM_CTL_SBIT1 | PWM_CTL_RPTL1));
+    TEST_ASSERT_EQUAL_UINT64(32, pwm_sim.pwm[PWM_RNG1]);
+
+    hpwm_serial_close(&ser);
+    hpwm_ctx_stop(&ctx);
+}
+
+void test_hpwm_serial_send_frame(void) {
+    hpwm_ctx_t ctx;
+    dma_chan_t dma;
+    hpwm_serial_t ser;
+    stream_setup(&ctx, &dma);
+
+    hpwm_serial_config_t cfg = HPWM_SERIAL_WS2812(18, 30);
+    TEST_ASSERT_EQUAL_INT(0, hpwm_serial_open(&ser, &ctx, &dma, &cfg));
+
+    const uint8_t leds[9] = { 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x12, 0x34, 0x56 };
+    uint32_t expect[7];
+    TEST_ASSERT_EQUAL_UINT64(7, hpwm_serial_encode(&ser, leds, 9, expect));
+
+    TEST_ASSERT_EQUAL_INT(0, hpwm_serial_send(&ser, leds, 9));
+    TEST_ASSERT_TRUE(hpwm_serial_busy(&ser));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_send(&ser, leds, 9));  /* Still in flight */
+
+    uint64_t word_ns = (uint64_t)(32 * 1e9 / ctx.plan.clock_hz);
+    dma_sim_run(&dma_sim, 40 * word_ns);
+    TEST_ASSERT_FALSE(hpwm_serial_busy(&ser));
+    TEST_ASSERT_GREATER_OR_EQUAL(7 + 23, pwm_sim.log_len);
+    for (int i = 0; i < 7; i++) TEST_ASSERT_EQUAL_UINT64(expect[i], pwm_log[i]);
+    for (size_t i = 7; i < pwm_sim.log_len; i++) TEST_ASSERT_EQUAL_UINT64(0, pwm_log[i]);  /* Latch, then SBIT */
+    TEST_ASSERT_EQUAL_UINT64(0, pwm_sim.overflows);
+
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_send(&ser, leds, 31));  /* Over max_bytes */
+    TEST_ASSERT_EQUAL_INT(0, hpwm_serial_send(&ser, leds, 9));
+    TEST_ASSERT_EQUAL_UINT64(2, ser.frames);
+
+    hpwm_serial_close(&ser);
+    hpwm_ctx_stop(&ctx);
+}
+
+void test_hpwm_serial_rejects_invalid_config(void) {
+    hpwm_ctx_t ctx;
+    dma_chan_t dma;
+    hpwm_serial_t ser;
+    hpwm_stream_t st;
+    stream_setup(&ctx, &dma);
+
+    hpwm_serial_config_t bad_pin = HPWM_SERIAL_WS2812(17, 30);
+    hpwm_serial_config_t no_slots = { 18, 2400000, 0, 0, 1, 0, 30 };
+    hpwm_serial_config_t wide = { 18, 2400000, 5, 0x10, 0x18, 0, 30 };
+    hpwm_serial_config_t bad_pattern = { 18, 2400000, 3, 0x8, 0x6, 0, 30 };
+    hpwm_serial_config_t no_bytes = HPWM_SERIAL_WS2812(18, 0);
+    hpwm_serial_config_t slow = { 18, 0, 3, 0x4, 0x6, 0, 30 };
+    hpwm_serial_config_t fast = { 18, 200000000, 3, 0x4, 0x6, 0, 30 };
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_open(&ser, &ctx, &dma, &bad_pin));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_open(&ser, &ctx, &dma, &no_slots));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_open(&ser, &ctx, &dma, &wide));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_open(&ser, &ctx, &dma, &bad_pattern));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_open(&ser, &ctx, &dma, &no_bytes));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_open(&ser, &ctx, &dma, &slow));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_open(&ser, &ctx, &dma, &fast));
+
+    /* The other channel shares the clock */
+    hpwm_serial_config_t cfg = HPWM_SERIAL_WS2812(18, 30);
+    hpwm_ctx_set(&ctx, 19, 1000, 500);
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_open(&ser, &ctx, &dma, &cfg));
+    hpwm_ctx_stop(&ctx);
+
+    /* The FIFO and the clock are taken by the serializer */
+    stream_setup(&ctx, &dma);
+    TEST_ASSERT_EQUAL_INT(0, hpwm_serial_open(&ser, &ctx, &dma, &cfg));
+    hpwm_stream_config_t scfg = { 19, 8000, 16, 2 };
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_stream_open(&st, &ctx, &dma, &scfg));
+    hpwm_plan_t plan = ctx.plan;
+    uint32_t cm_div = pwm_sim.clk[CM_PWMDIV];
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_ctx_set(&ctx, 19, 1000, 500));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_ctx_set_duty(&ctx, 19, 500));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_ctx_set_duty(&ctx, 18, 500));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_open(&ser, &ctx, &dma, &cfg));
+    TEST_ASSERT_EQUAL_UINT64(cm_div, pwm_sim.clk[CM_PWMDIV]);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(&plan, &ctx.plan, sizeof(plan)));
+    hpwm_serial_close(&ser);
+    TEST_ASSERT_EQUAL_INT(0, hpwm_ctx_set(&ctx, 19, 1000, 500));
+    hpwm_ctx_stop(&ctx);
+}
+
+void test_hpwm_serial_close_restores_pwm(void) {
+    hpwm_ctx_t ctx;
+    dma_chan_t dma;
+    hpwm_serial_t ser;
+    const uint8_t leds[3] = { 1, 2, 3 };
+    stream_setup(&ctx, &dma);
+
+    hpwm_serial_config_t cfg = HPWM_SERIAL_WS2812(12, 3);
+    TEST_ASSERT_EQUAL_INT(0, hpwm_serial_open(&ser, &ctx, &dma, &cfg));
+    TEST_ASSERT_EQUAL_INT(0, hpwm_serial_send(&ser, leds, 3));
+
+    hpwm_serial_close(&ser);
+    TEST_ASSERT_FALSE(dma_chan_active(&dma));
+    TEST_ASSERT_NULL(ser.words);
+    TEST_ASSERT_EQUAL_UINT64(0, pwm_sim.pwm[PWM_DMAC]);
+    TEST_ASSERT_EQUAL_UINT64(0, pwm_sim.pwm[PWM_CTL] & (PWM_CTL_MODE1 | PWM_CTL_USEF1 | PWM_CTL_PWEN1));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_serial_send(&ser, leds, 3));
+
+    /* Back to duty-cycle PWM with a replanned clock */
+    hpwm_ctx_set(&ctx, 12, 1000, 250);
+    TEST_ASSERT_EQUAL_UINT64(125000, pwm_sim.pwm[PWM_RNG1]);
+    TEST_ASSERT_EQUAL_UINT64(31250, pwm_sim.pwm[PWM_DAT1]);
+    TEST_ASSERT_TRUE(pwm_sim.pwm[PWM_CTL] & PWM_CTL_MSEN1);
+    hpwm_ctx_stop(&ctx);
+}
+
+void test_hpwm_set_duty_default_context(void) {
+    hpwm_init();
+    hpwm_set(18, 1000, 500);
+    TEST_ASSERT_EQUAL_INT(0, hpwm_set_duty(18, 250));
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_set_duty(17, 250));
+    hpwm_stop();
+}
+
+void test_hpwm_ctx_init_unavailable_on_host(void) {
+    hpwm_ctx_t ctx;
+    TEST_ASSERT_EQUAL_INT(-1, hpwm_ctx_init(&ctx, NULL));
+}
+
 /* ============================================================================
  * MAIN TEST RUNNER
  * ============================================================================ */
@@ -470,6 +1050,37 @@ int main(void) {
     RUN_TEST(test_hpwm_stress_rapid_set);
     RUN_TEST(test_hpwm_stress_init_stop_cycles);
     RUN_TEST(test_hpwm_stress_all_pins_rapid);
+
+    // Context tests
+    RUN_TEST(test_hpwm_ctx_attach_programs_clock);
+    RUN_TEST(test_hpwm_ctx_set_channel_registers);
+    RUN_TEST(test_hpwm_ctx_rejects_invalid_input);
+    RUN_TEST(test_hpwm_ctx_init_unavailable_on_host);
+    RUN_TEST(test_hpwm_ctx_duty_only_update);
+    RUN_TEST(test_hpwm_ctx_skips_redundant_writes);
+    RUN_TEST(test_hpwm_ctx_set_duty_requires_configured_pin);
+    RUN_TEST(test_hpwm_set_duty_default_context);
+
+    // Frequency planner
+    RUN_TEST(test_hpwm_plan_low_frequency_uses_fastest_integer_clock);
+    RUN_TEST(test_hpwm_plan_100khz_resolution);
+    RUN_TEST(test_hpwm_plan_fractional_divider);
+    RUN_TEST(test_hpwm_plan_two_channels_share_clock);
+    RUN_TEST(test_hpwm_plan_rejects_invalid);
+    RUN_TEST(test_hpwm_ctx_set_replans_clock);
+
+    // FIFO streaming
+    RUN_TEST(test_hpwm_stream_plays_samples_in_order);
+    RUN_TEST(test_hpwm_stream_underrun_plays_idle);
+    RUN_TEST(test_hpwm_stream_rejects_invalid_config);
+    RUN_TEST(test_hpwm_stream_close_releases_channel);
+
+    // Serializer
+    RUN_TEST(test_hpwm_serial_encode_matches_reference);
+    RUN_TEST(test_hpwm_serial_ws2812_symbols);
+    RUN_TEST(test_hpwm_serial_send_frame);
+    RUN_TEST(test_hpwm_serial_rejects_invalid_config);
+    RUN_TEST(test_hpwm_serial_close_restores_pwm);
     
     return UNITY_END();
 }
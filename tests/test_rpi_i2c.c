@@ -0,0 +1,245 @@
+/*
+ * test_rpi_i2c.c - Validation tests for rpi_i2c.h
+ *
+ * The driver runs against the simulated BSC block in virtual time, with a
+ * register-file slave (or a custom one) answering through callbacks.
+ * Focus: divider setup, repeated-START write-read, FIFO refill and drain
+ * on long transfers, sleeping through waits, NACK and argument errors.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_I2C_IMPLEMENTATION
+#include "rpi_i2c.h"
+
+#define DEV_ADDR 0x68
+
+static i2c_sim_t sim;
+static i2c_sim_regfile_t dev;
+
+static void setup(i2c_ctx_t* ctx, uint32_t hz) {
+    i2c_sim_slave_t slave;
+    i2c_sim_regfile(&dev, DEV_ADDR, &slave);
+    i2c_sim_init(&sim, &slave);
+    TEST_ASSERT_EQUAL_INT(0, i2c_sim_attach(&sim, ctx));
+    i2c_ctx_set_clock(ctx, hz);
+}
+
+static void fill(uint8_t* buf, size_t len, int seed) {
+    for (size_t i = 0; i < len; i++) buf[i] = (uint8_t)(i * 13 + seed);
+}
+
+/* Slave that acknowledges the address and then only nack_after bytes */
+typedef struct {
+    int nack_after;
+    int written;
+} nacker_t;
+
+static int nacker_start(void* user, uint8_t addr, int read) {
+    (void)addr;
+    (void)read;
+    ((nacker_t*)user)->written = 0;
+    return 1;
+}
+
+static int nacker_write(void* user, uint8_t byte) {
+    nacker_t* n = (nacker_t*)user;
+    (void)byte;
+    return n->written++ < n->nack_after;
+}
+
+/* ============================================================================
+ * CONFIGURATION
+ * ============================================================================ */
+
+void test_clock_divider(void) {
+    i2c_ctx_t ctx;
+    setup(&ctx, I2C_HZ_DEFAULT);
+
+    TEST_ASSERT_EQUAL_INT(100000, ctx.clock_hz);
+    TEST_ASSERT_EQUAL_INT(5000, sim.regs[I2C_DIV]);
+    TEST_ASSERT_EQUAL_INT((312u << 16) | 1250u, sim.regs[I2C_DEL]);  /* FEDL, REDL */
+    TEST_ASSERT_EQUAL_INT(3500, sim.regs[I2C_CLKT]);
+    TEST_ASSERT_EQUAL_INT(90000, ctx.byte_ns);
+
+    TEST_ASSERT_EQUAL_INT(400000, i2c_ctx_set_clock(&ctx, 400000));
+    TEST_ASSERT_EQUAL_INT(1250, sim.regs[I2C_DIV]);
+    TEST_ASSERT_EQUAL_INT((78u << 16) | 312u, sim.regs[I2C_DEL]);
+
+    /* Never faster than asked: 500 MHz / 3 MHz = 166.7, rounded to 168 */
+    TEST_ASSERT_EQUAL_INT(2976190, i2c_ctx_set_clock(&ctx, 3000000));
+    TEST_ASSERT_EQUAL_INT(168, sim.regs[I2C_DIV]);
+    TEST_ASSERT_EQUAL_INT(0, i2c_ctx_set_clock(&ctx, 0));
+}
+
+void test_init_unavailable_on_host(void) {
+    i2c_ctx_t ctx;
+    TEST_ASSERT_EQUAL_INT(-1, i2c_ctx_init(&ctx, NULL));
+}
+
+/* ============================================================================
+ * TRANSFERS
+ * ============================================================================ */
+
+void test_register_write_and_burst_read(void) {
+    i2c_ctx_t ctx;
+    setup(&ctx, 400000);
+
+    uint8_t out[14], in[14];
+    fill(out, sizeof(out), 3);
+    TEST_ASSERT_EQUAL_INT(0, i2c_ctx_write_regs(&ctx, DEV_ADDR, 0x3B, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(&dev.regs[0x3B], out, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT64(1, sim.stops);
+
+    memset(in, 0, sizeof(in));
+    TEST_ASSERT_EQUAL_INT(0, i2c_ctx_read_regs(&ctx, DEV_ADDR, 0x3B, in, sizeof(in)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(in, out, sizeof(in)));
+    TEST_ASSERT_EQUAL_INT(I2C_OK, ctx.error);
+    TEST_ASSERT_EQUAL_UINT64(2, ctx.stats.transactions);
+    TEST_ASSERT_EQUAL_UINT64(15 + 1 + 14, ctx.stats.bytes);
+}
+
+void test_write_read_uses_repeated_start(void) {
+    i2c_ctx_t ctx;
+    setup(&ctx, 400000);
+    fill(dev.regs, sizeof(dev.regs), 7);
+
+    uint64_t t0 = sim.now_ns;
+    uint8_t in[6];
+    TEST_ASSERT_EQUAL_INT(0, i2c_ctx_read_regs(&ctx, DEV_ADDR, 0x10, in, sizeof(in)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(in, &dev.regs[0x10], sizeof(in)));
+
+    TEST_ASSERT_EQUAL_UINT64(1, sim.starts);
+    TEST_ASSERT_EQUAL_UINT64(1, sim.repeated_starts);
+    TEST_ASSERT_EQUAL_UINT64(1, sim.stops);
+    TEST_ASSERT_EQUAL_UINT64(0, sim.stalls);
+
+    /* START + addr + reg, Sr + addr + 6 bytes, STOP: 1 + 18 + 10 + 54 + 1 SCL periods */
+    uint64_t wire = 84 * 2500;
+    TEST_ASSERT_GREATER_OR_EQUAL(wire, sim.now_ns - t0);
+    TEST_ASSERT_LESS_THAN(wire + 10000, sim.now_ns - t0);
+}
+
+void test_long_transfers_refill_and_drain(void) {
+    i2c_ctx_t ctx;
+    setup(&ctx, 1000000);
+
+    uint8_t out[201], in[200];
+    out[0] = 0x20;
+    fill(out + 1, 200, 5);
+    TEST_ASSERT_EQUAL_INT(0, i2c_ctx_write(&ctx, DEV_ADDR, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(&dev.regs[0x20], out + 1, 200));
+    TEST_ASSERT_EQUAL_UINT64(201, sim.bytes);
+
+    TEST_ASSERT_EQUAL_INT(0, i2c_ctx_read_regs(&ctx, DEV_ADDR, 0x20, in, sizeof(in)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(in, out + 1, sizeof(in)));
+
+    /* Bursts keep both directions ahead of the bus */
+    TEST_ASSERT_EQUAL_UINT64(0, sim.stalls);
+    TEST_ASSERT_GREATER_THAN(0, ctx.stats.sleeps);
+}
+
+void test_sleeping_cuts_register_accesses(void) {
+    i2c_ctx_t ctx;
+    uint8_t in[14];
+    setup(&ctx, 400000);
+    ctx.sleep = 0;
+    TEST_ASSERT_EQUAL_INT(0, i2c_ctx_read_regs(&ctx, DEV_ADDR, 0, in, sizeof(in)));
+    uint64_t polled = sim.accesses;
+    uint64_t polled_ns = sim.now_ns;
+
+    setup(&ctx, 400000);
+    uint64_t a0 = sim.accesses, t0 = sim.now_ns;
+    TEST_ASSERT_EQUAL_INT(0, i2c_ctx_read_regs(&ctx, DEV_ADDR, 0, in, sizeof(in)));
+    uint64_t slept = sim.accesses - a0;
+
+    TEST_ASSERT_GREATER_THAN(0, ctx.stats.sleeps);
+    TEST_ASSERT_LESS_THAN(polled / 4, slept);
+    /* Same bus time either way, give or take the wake-up slack */
+    TEST_ASSERT_LESS_THAN(polled_ns + 60000, sim.now_ns - t0);
+}
+
+/* ============================================================================
+ * ERRORS
+ * ============================================================================ */
+
+void test_address_nack(void) {
+    i2c_ctx_t ctx;
+    setup(&ctx, 400000);
+    uint8_t b = 0x55;
+
+    TEST_ASSERT_EQUAL_INT(-1, i2c_ctx_write(&ctx, 0x50, &b, 1));
+    TEST_ASSERT_EQUAL_INT(I2C_NACK, ctx.error);
+    TEST_ASSERT_EQUAL_UINT64(1, ctx.stats.nacks);
+    TEST_ASSERT_EQUAL_UINT64(1, sim.stops);
+
+    TEST_ASSERT_EQUAL_INT(0, i2c_ctx_probe(&ctx, 0x50));
+    TEST_ASSERT_EQUAL_INT(1, i2c_ctx_probe(&ctx, DEV_ADDR));
+    TEST_ASSERT_EQUAL_INT(-1, i2c_ctx_read_regs(&ctx, 0x51, 0, &b, 1));
+    TEST_ASSERT_EQUAL_INT(I2C_NACK, ctx.error);
+
+    /* The controller is usable again after an error */
+    TEST_ASSERT_EQUAL_INT(0, i2c_ctx_write_regs(&ctx, DEV_ADDR, 1, &b, 1));
+    TEST_ASSERT_EQUAL_INT(0x55, dev.regs[1]);
+}
+
+void test_data_nack_stops_write(void) {
+    i2c_ctx_t ctx;
+    nacker_t n = { 2, 0 };
+    i2c_sim_slave_t slave = { nacker_start, nacker_write, NULL, NULL, &n };
+    i2c_sim_init(&sim, &slave);
+    TEST_ASSERT_EQUAL_INT(0, i2c_sim_attach(&sim, &ctx));
+
+    uint8_t out[40];
+    fill(out, sizeof(out), 1);
+    TEST_ASSERT_EQUAL_INT(-1, i2c_ctx_write(&ctx, DEV_ADDR, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_INT(I2C_NACK, ctx.error);
+    TEST_ASSERT_EQUAL_UINT64(3, sim.bytes);
+    TEST_ASSERT_EQUAL_UINT64(1, sim.stops);
+}
+
+void test_invalid_arguments(void) {
+    i2c_ctx_t ctx;
+    setup(&ctx, 400000);
+    uint8_t buf[I2C_FIFO_BYTES + 1] = { 0 };
+
+    TEST_ASSERT_EQUAL_INT(-1, i2c_ctx_write(&ctx, 0x80, buf, 1));
+    TEST_ASSERT_EQUAL_INT(I2C_INVALID, ctx.error);
+    TEST_ASSERT_EQUAL_INT(-1, i2c_ctx_write(&ctx, DEV_ADDR, buf, 0));
+    TEST_ASSERT_EQUAL_INT(-1, i2c_ctx_read(&ctx, DEV_ADDR, NULL, 4));
+    TEST_ASSERT_EQUAL_INT(-1, i2c_ctx_write_read(&ctx, DEV_ADDR, buf, sizeof(buf), buf, 1));
+    TEST_ASSERT_EQUAL_INT(-1, i2c_ctx_write_read(&ctx, DEV_ADDR, buf, 1, buf, 0));
+    TEST_ASSERT_EQUAL_INT(I2C_INVALID, ctx.error);
+    TEST_ASSERT_EQUAL_UINT64(0, sim.starts);
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Configuration
+    RUN_TEST(test_clock_divider);
+    RUN_TEST(test_init_unavailable_on_host);
+
+    // Transfers
+    RUN_TEST(test_register_write_and_burst_read);
+    RUN_TEST(test_write_read_uses_repeated_start);
+    RUN_TEST(test_long_transfers_refill_and_drain);
+    RUN_TEST(test_sleeping_cuts_register_accesses);
+
+    // Errors
+    RUN_TEST(test_address_nack);
+    RUN_TEST(test_data_nack_stops_write);
+    RUN_TEST(test_invalid_arguments);
+
+    return UNITY_END();
+}
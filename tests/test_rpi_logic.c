@@ -0,0 +1,261 @@
+/*
+ * test_rpi_logic.c - Validation tests for rpi_logic.h
+ *
+ * These tests capture from the GPIO simulator backend, driving inputs with
+ * gpio_ctx_sim_set_input() between polls.
+ * Focus: run-length records, pin masking, full-ring drops and recovery,
+ * VCD output, sampler and writer threads.
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_LOGIC_IMPLEMENTATION
+#include "rpi_logic.h"
+
+#define PIN_A 6
+#define PIN_B 40
+
+static int count_lines_starting(const char* text, char c) {
+    int n = 0;
+    for (const char* p = text; p && *p; p = strchr(p, '\n'), p = p ? p + 1 : NULL) {
+        if (*p == c) n++;
+    }
+    return n;
+}
+
+/* ============================================================================
+ * CAPTURE TESTS
+ * ============================================================================ */
+
+void test_init_defaults(void) {
+    logic_t la;
+    TEST_ASSERT_EQUAL_INT(0, logic_init(&la, NULL, 0, 1000));
+    TEST_ASSERT_EQUAL_UINT64(1024, la.capacity);
+    TEST_ASSERT_EQUAL_UINT64(GPIO_ALL_PINS_MASK, la.pin_mask);
+    TEST_ASSERT(&gpio_ctx_default == la.gpio);
+    TEST_ASSERT(logic_sample_rate(&la) == 0.0);
+    logic_free(&la);
+
+    TEST_ASSERT_EQUAL_INT(-1, logic_init(NULL, NULL, 0, 0));
+}
+
+void test_poll_stores_only_changes(void) {
+    gpio_ctx_t ctx;
+    logic_t la;
+    logic_record_t rec[8];
+    gpio_ctx_init(&ctx, GPIO_BACKEND_SIM);
+    logic_init(&la, &ctx, 0, 64);
+
+    TEST_ASSERT_EQUAL_UINT64(1, logic_poll(&la, 5));   /* Initial levels */
+    gpio_ctx_sim_set_input(&ctx, PIN_A, HIGH);
+    TEST_ASSERT_EQUAL_UINT64(1, logic_poll(&la, 5));
+    gpio_ctx_sim_set_input(&ctx, PIN_B, HIGH);
+    gpio_ctx_sim_set_input(&ctx, PIN_A, LOW);
+    TEST_ASSERT_EQUAL_UINT64(1, logic_poll(&la, 5));   /* Both pins in one record */
+
+    TEST_ASSERT_EQUAL_UINT64(15, la.stats.samples);
+    TEST_ASSERT_EQUAL_UINT64(3, la.stats.records);
+    TEST_ASSERT_EQUAL_UINT64(0, la.stats.dropped);
+    TEST_ASSERT(logic_sample_rate(&la) > 0.0);
+
+    TEST_ASSERT_EQUAL_UINT64(3, logic_read(&la, rec, 8));
+    TEST_ASSERT_EQUAL_UINT64(0, rec[0].levels);
+    TEST_ASSERT_EQUAL_UINT64(0, rec[0].delta_ns);
+    TEST_ASSERT_EQUAL_UINT64(1ull << PIN_A, rec[1].levels);
+    TEST_ASSERT_EQUAL_UINT64(1ull << PIN_B, rec[2].levels);
+    TEST_ASSERT(rec[1].delta_ns > 0);
+
+    /* Deltas add up to the capture span up to the last change */
+    TEST_ASSERT(rec[1].delta_ns + rec[2].delta_ns <= la.stats.end_ns - la.stats.start_ns);
+    TEST_ASSERT_EQUAL_UINT64(0, logic_read(&la, rec, 8));
+
+    logic_free(&la);
+    gpio_ctx_cleanup(&ctx);
+}
+
+void test_pin_mask_filters_changes(void) {
+    gpio_ctx_t ctx;
+    logic_t la;
+    logic_record_t rec[4];
+    gpio_ctx_init(&ctx, GPIO_BACKEND_SIM);
+    logic_init(&la, &ctx, 1ull << PIN_A, 16);
+
+    logic_poll(&la, 1);
+    gpio_ctx_sim_set_input(&ctx, PIN_B, HIGH);  /* Not captured */
+    TEST_ASSERT_EQUAL_UINT64(0, logic_poll(&la, 3));
+    gpio_ctx_sim_set_input(&ctx, PIN_A, HIGH);
+    TEST_ASSERT_EQUAL_UINT64(1, logic_poll(&la, 3));
+
+    TEST_ASSERT_EQUAL_UINT64(2, logic_read(&la, rec, 4));
+    TEST_ASSERT_EQUAL_UINT64(1ull << PIN_A, rec[1].levels);
+
+    logic_free(&la);
+    gpio_ctx_cleanup(&ctx);
+}
+
+void test_full_ring_drops_then_recovers(void) {
+    gpio_ctx_t ctx;
+    logic_t la;
+    logic_record_t rec[8];
+    gpio_ctx_init(&ctx, GPIO_BACKEND_SIM);
+    logic_init(&la, &ctx, 1ull << PIN_A, 4);
+
+    /* Toggle on every sample with nobody reading */
+    for (int i = 0; i < 8; i++) {
+        gpio_ctx_sim_set_input(&ctx, PIN_A, i & 1);
+        logic_poll(&la, 1);
+    }
+    /* i = 4 and 6 differ from the last stored level (HIGH); 5 and 7 match it */
+    TEST_ASSERT_EQUAL_UINT64(4, la.stats.records);
+    TEST_ASSERT_EQUAL_UINT64(2, la.stats.dropped);
+
+    TEST_ASSERT_EQUAL_UINT64(4, logic_read(&la, rec, 8));
+    TEST_ASSERT_EQUAL_UINT64(0, rec[0].levels);
+    TEST_ASSERT_EQUAL_UINT64(1ull << PIN_A, rec[3].levels);
+
+    /* Level is now HIGH (i = 7), last stored was HIGH (i = 3): nothing new */
+    TEST_ASSERT_EQUAL_UINT64(0, logic_poll(&la, 1));
+    gpio_ctx_sim_set_input(&ctx, PIN_A, LOW);
+    TEST_ASSERT_EQUAL_UINT64(1, logic_poll(&la, 1));
+    TEST_ASSERT_EQUAL_UINT64(1, logic_read(&la, rec, 8));
+    TEST_ASSERT_EQUAL_UINT64(0, rec[0].levels);
+
+    logic_free(&la);
+    gpio_ctx_cleanup(&ctx);
+}
+
+/* ============================================================================
+ * VCD TESTS
+ * ============================================================================ */
+
+void test_vcd_output_format(void) {
+    char* text = NULL;
+    size_t size = 0;
+    FILE* out = open_memstream(&text, &size);
+    uint64_t mask = (1ull << PIN_A) | (1ull << PIN_B);
+
+    logic_record_t rec[3] = {
+        { 0, 1ull << PIN_B },
+        { 100, (1ull << PIN_B) | (1ull << PIN_A) },
+        { 50, 1ull << PIN_A },
+    };
+    uint64_t t = 0, prev = ~rec[0].levels;
+    logic_vcd_header(out, mask);
+    logic_vcd_records(out, mask, rec, 3, &t, &prev);
+    fclose(out);
+
+    TEST_ASSERT_EQUAL_UINT64(150, t);
+    TEST_ASSERT_EQUAL_UINT64(1ull << PIN_A, prev);
+    TEST_ASSERT_NOT_NULL(strstr(text, "$timescale 1ns $end\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "$var wire 1 ' gpio6 $end\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "$var wire 1 I gpio40 $end\n"));
+    TEST_ASSERT_NULL(strstr(text, "gpio7"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "$enddefinitions $end\n#0\n0'\n1I\n#100\n1'\n#150\n0I\n"));
+
+    free(text);
+}
+
+/* ============================================================================
+ * THREAD TESTS
+ * ============================================================================ */
+
+void test_threaded_capture_writes_vcd(void) {
+    gpio_ctx_t ctx;
+    logic_t la;
+    char* text = NULL;
+    size_t size = 0;
+    FILE* out = open_memstream(&text, &size);
+    gpio_ctx_init(&ctx, GPIO_BACKEND_SIM);
+    logic_init(&la, &ctx, 1ull << PIN_A, 1024);
+
+    TEST_ASSERT_EQUAL_INT(0, logic_start(&la, -1, out));
+    TEST_ASSERT_EQUAL_INT(-1, logic_start(&la, -1, out));
+    TEST_ASSERT_EQUAL_UINT64(0, logic_poll(&la, 1));  /* Sampler owns the ring */
+
+    usleep(2000);
+    for (int i = 0; i < 10; i++) {
+        gpio_ctx_sim_set_input(&ctx, PIN_A, (i & 1) ? LOW : HIGH);
+        usleep(2000);
+    }
+    logic_stop(&la);
+    fclose(out);
+
+    TEST_ASSERT_EQUAL_UINT64(11, la.stats.records);
+    TEST_ASSERT_EQUAL_UINT64(0, la.stats.dropped);
+    TEST_ASSERT(la.stats.samples > 100);
+    TEST_ASSERT(logic_sample_rate(&la) > 0.0);
+    TEST_ASSERT_EQUAL_INT(11, count_lines_starting(text, '#'));
+    TEST_ASSERT_NOT_NULL(strstr(text, "#0\n0'\n"));
+
+    logic_stop(&la);  /* Second stop is a no-op */
+    logic_free(&la);
+    gpio_ctx_cleanup(&ctx);
+    free(text);
+}
+
+void test_restart_begins_a_new_capture(void) {
+    gpio_ctx_t ctx;
+    logic_t la;
+    logic_record_t rec[8];
+    gpio_ctx_init(&ctx, GPIO_BACKEND_SIM);
+    logic_init(&la, &ctx, 1ull << PIN_A, 64);
+
+    TEST_ASSERT_EQUAL_INT(0, logic_start(&la, -1, NULL));
+    usleep(2000);
+    gpio_ctx_sim_set_input(&ctx, PIN_A, HIGH);
+    usleep(2000);
+    gpio_ctx_sim_set_input(&ctx, PIN_A, LOW);
+    usleep(2000);
+    logic_stop(&la);
+    TEST_ASSERT_EQUAL_UINT64(3, la.stats.records);
+
+    /* Records of the first capture are never read */
+    gpio_ctx_sim_set_input(&ctx, PIN_A, HIGH);
+    TEST_ASSERT_EQUAL_INT(0, logic_start(&la, -1, NULL));
+    usleep(2000);
+    gpio_ctx_sim_set_input(&ctx, PIN_A, LOW);
+    usleep(2000);
+    logic_stop(&la);
+
+    TEST_ASSERT_EQUAL_UINT64(2, la.stats.records);
+    TEST_ASSERT_EQUAL_UINT64(0, la.stats.dropped);
+    TEST_ASSERT_EQUAL_UINT64(2, logic_read(&la, rec, 8));
+    TEST_ASSERT_EQUAL_UINT64(1ull << PIN_A, rec[0].levels);
+    TEST_ASSERT_EQUAL_UINT64(0, rec[1].levels);
+
+    logic_free(&la);
+    gpio_ctx_cleanup(&ctx);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Capture tests
+    RUN_TEST(test_init_defaults);
+    RUN_TEST(test_poll_stores_only_changes);
+    RUN_TEST(test_pin_mask_filters_changes);
+    RUN_TEST(test_full_ring_drops_then_recovers);
+
+    // VCD tests
+    RUN_TEST(test_vcd_output_format);
+
+    // Thread tests
+    RUN_TEST(test_threaded_capture_writes_vcd);
+    RUN_TEST(test_restart_begins_a_new_capture);
+
+    return UNITY_END();
+}
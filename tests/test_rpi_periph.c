@@ -0,0 +1,288 @@
+/*
+ * test_rpi_periph.c - Validation tests for rpi_periph.h
+ *
+ * These tests run the mapping registry against a fake syscall table that
+ * hands out RAM blocks instead of /dev/mem.
+ * Focus: base detection, lazy mapping, reference counting, fd sharing,
+ * /dev/gpiomem fallback, and the GPIO/HW PWM users of the registry.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_HW_PWM_IMPLEMENTATION
+#include "rpi_hw_pwm.h"
+
+/* ============================================================================
+ * FAKE SYSCALLS
+ * ============================================================================ */
+
+#define FAKE_MEM_FD     10
+#define FAKE_GPIOMEM_FD 11
+
+static struct {
+    int mem_allowed;          /* 0 simulates an unprivileged process */
+    int opens_mem;
+    int opens_gpiomem;
+    int closes;
+    int mmaps;
+    int munmaps;
+    int fail_mmap;
+    off_t offsets[PERIPH_COUNT * 2];
+    uint32_t blocks[PERIPH_COUNT * 2][PERIPH_BLOCK_SIZE / 4];
+} fake;
+
+static int fake_open(const char* path, int flags) {
+    (void)flags;
+    if (strcmp(path, "/dev/mem") == 0) {
+        if (!fake.mem_allowed) return -1;
+        fake.opens_mem++;
+        return FAKE_MEM_FD;
+    }
+    if (strcmp(path, "/dev/gpiomem") == 0) {
+        fake.opens_gpiomem++;
+        return FAKE_GPIOMEM_FD;
+    }
+    return -1;
+}
+
+static int fake_close(int fd) {
+    (void)fd;
+    fake.closes++;
+    return 0;
+}
+
+static void* fake_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
+    (void)addr; (void)length; (void)prot; (void)flags; (void)fd;
+    if (fake.fail_mmap || fake.mmaps >= PERIPH_COUNT * 2) return MAP_FAILED;
+    fake.offsets[fake.mmaps] = offset;
+    return fake.blocks[fake.mmaps++];
+}
+
+static int fake_munmap(void* addr, size_t length) {
+    (void)addr; (void)length;
+    fake.munmaps++;
+    return 0;
+}
+
+static const periph_io_t fake_io = { fake_open, fake_close, fake_mmap, fake_munmap };
+
+static void fake_reset(int mem_allowed) {
+    memset(&fake, 0, sizeof(fake));
+    fake.mem_allowed = mem_allowed;
+    periph_set_io(&fake_io);
+}
+
+static void write_file(const char* path, const unsigned char* data, size_t n) {
+    FILE* f = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    fwrite(data, 1, n, f);
+    fclose(f);
+}
+
+/* ============================================================================
+ * BASE DETECTION TESTS
+ * ============================================================================ */
+
+void test_detect_base_pi4_two_cell_parent(void) {
+    const unsigned char ranges[] = {
+        0x7e, 0x00, 0x00, 0x00,  0x00, 0x00, 0x00, 0x00,  0xfe, 0x00, 0x00, 0x00,
+        0x01, 0x80, 0x00, 0x00
+    };
+    write_file("/tmp/rpi_periph_ranges_pi4", ranges, sizeof(ranges));
+    TEST_ASSERT_EQUAL_UINT64(0xFE000000u, periph_detect_base("/tmp/rpi_periph_ranges_pi4"));
+    unlink("/tmp/rpi_periph_ranges_pi4");
+}
+
+void test_detect_base_pi3_one_cell_parent(void) {
+    const unsigned char ranges[] = {
+        0x7e, 0x00, 0x00, 0x00,  0x3f, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00
+    };
+    write_file("/tmp/rpi_periph_ranges_pi3", ranges, sizeof(ranges));
+    TEST_ASSERT_EQUAL_UINT64(0x3F000000u, periph_detect_base("/tmp/rpi_periph_ranges_pi3"));
+    unlink("/tmp/rpi_periph_ranges_pi3");
+}
+
+void test_detect_base_fallbacks(void) {
+    const unsigned char short_ranges[] = { 0x7e, 0x00 };
+    write_file("/tmp/rpi_periph_ranges_short", short_ranges, sizeof(short_ranges));
+    TEST_ASSERT_EQUAL_UINT64(PERIPH_DEFAULT_BASE, periph_detect_base("/tmp/rpi_periph_ranges_short"));
+    unlink("/tmp/rpi_periph_ranges_short");
+
+    TEST_ASSERT_EQUAL_UINT64(PERIPH_DEFAULT_BASE, periph_detect_base("/nonexistent/ranges"));
+}
+
+/* ============================================================================
+ * REGISTRY TESTS
+ * ============================================================================ */
+
+void test_map_is_lazy_and_uses_base_offset(void) {
+    fake_reset(1);
+    TEST_ASSERT_EQUAL_INT(0, fake.opens_mem);
+
+    volatile uint32_t* pwm = periph_map(PERIPH_PWM);
+    TEST_ASSERT_NOT_NULL(pwm);
+    TEST_ASSERT_EQUAL_INT(1, fake.mmaps);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)periph_base() + 0x20C000, (uint64_t)fake.offsets[0]);
+
+    periph_unmap(PERIPH_PWM);
+    periph_set_io(NULL);
+}
+
+void test_map_refcounts_shared_block(void) {
+    fake_reset(1);
+    volatile uint32_t* a = periph_map(PERIPH_CLK);
+    volatile uint32_t* b = periph_map(PERIPH_CLK);
+    TEST_ASSERT_TRUE(a == b);
+    TEST_ASSERT_EQUAL_INT(1, fake.mmaps);
+    TEST_ASSERT_EQUAL_INT(2, periph_refcount(PERIPH_CLK));
+
+    periph_unmap(PERIPH_CLK);
+    TEST_ASSERT_EQUAL_INT(0, fake.munmaps);
+    TEST_ASSERT_EQUAL_INT(1, periph_refcount(PERIPH_CLK));
+
+    periph_unmap(PERIPH_CLK);
+    TEST_ASSERT_EQUAL_INT(1, fake.munmaps);
+    TEST_ASSERT_EQUAL_INT(0, periph_refcount(PERIPH_CLK));
+    TEST_ASSERT_EQUAL_INT(1, fake.closes);
+    periph_set_io(NULL);
+}
+
+void test_blocks_share_one_mem_fd(void) {
+    fake_reset(1);
+    periph_map(PERIPH_GPIO);
+    periph_map(PERIPH_PWM);
+    periph_map(PERIPH_CLK);
+    periph_map(PERIPH_DMA);
+    TEST_ASSERT_EQUAL_INT(1, fake.opens_mem);
+    TEST_ASSERT_EQUAL_INT(0, fake.opens_gpiomem);
+    TEST_ASSERT_EQUAL_INT(4, fake.mmaps);
+
+    periph_unmap(PERIPH_GPIO);
+    periph_unmap(PERIPH_PWM);
+    periph_unmap(PERIPH_CLK);
+    TEST_ASSERT_EQUAL_INT(0, fake.closes);  /* DMA still mapped */
+    periph_unmap(PERIPH_DMA);
+    TEST_ASSERT_EQUAL_INT(1, fake.closes);
+
+    /* Remapping reopens */
+    periph_map(PERIPH_SPI0);
+    TEST_ASSERT_EQUAL_INT(2, fake.opens_mem);
+    periph_unmap(PERIPH_SPI0);
+    periph_set_io(NULL);
+}
+
+void test_gpio_falls_back_to_gpiomem(void) {
+    fake_reset(0);
+    TEST_ASSERT_NOT_NULL(periph_map(PERIPH_GPIO));
+    TEST_ASSERT_EQUAL_INT(1, fake.opens_gpiomem);
+    TEST_ASSERT_EQUAL_UINT64(0, (uint64_t)fake.offsets[0]);
+
+    TEST_ASSERT_NULL(periph_map(PERIPH_PWM));  /* Needs /dev/mem */
+    TEST_ASSERT_EQUAL_INT(0, periph_refcount(PERIPH_PWM));
+
+    periph_unmap(PERIPH_GPIO);
+    TEST_ASSERT_EQUAL_INT(1, fake.closes);
+    periph_set_io(NULL);
+}
+
+void test_mmap_failure_releases_fd(void) {
+    fake_reset(1);
+    fake.fail_mmap = 1;
+    TEST_ASSERT_NULL(periph_map(PERIPH_BSC1));
+    TEST_ASSERT_EQUAL_INT(0, periph_refcount(PERIPH_BSC1));
+    TEST_ASSERT_EQUAL_INT(1, fake.closes);
+    periph_set_io(NULL);
+}
+
+void test_invalid_blocks(void) {
+    fake_reset(1);
+    TEST_ASSERT_NULL(periph_map(PERIPH_COUNT));
+    TEST_ASSERT_NULL(periph_map((periph_block_t)-1));
+    periph_unmap(PERIPH_COUNT);
+    periph_unmap(PERIPH_SPI0);  /* Not mapped: no-op */
+    TEST_ASSERT_EQUAL_INT(0, fake.munmaps);
+    TEST_ASSERT_EQUAL_INT(0, periph_refcount(PERIPH_COUNT));
+    periph_set_io(NULL);
+}
+
+void test_real_io_refused_on_host(void) {
+    periph_set_io(NULL);
+    TEST_ASSERT_NULL(periph_map(PERIPH_GPIO));
+}
+
+/* ============================================================================
+ * REGISTRY USERS
+ * ============================================================================ */
+
+void test_gpio_mmap_backend_through_registry(void) {
+    fake_reset(1);
+    gpio_ctx_t a = {0}, b = {0};
+    TEST_ASSERT_EQUAL_INT(0, gpio_ctx_init(&a, GPIO_BACKEND_MMAP));
+    TEST_ASSERT_EQUAL_INT(0, gpio_ctx_init(&b, GPIO_BACKEND_MMAP));
+    TEST_ASSERT_TRUE(a.regs == b.regs);
+    TEST_ASSERT_EQUAL_INT(1, fake.mmaps);
+
+    gpio_ctx_pin_mode(&a, 21, OUTPUT);
+    gpio_ctx_write(&a, 21, HIGH);
+    TEST_ASSERT_EQUAL_UINT64(1u << 21, a.regs[GPSET0]);
+    TEST_ASSERT_EQUAL_UINT64(1u << 3, a.regs[2] & (FSEL_MASK << 3));
+
+    gpio_ctx_cleanup(&a);
+    TEST_ASSERT_EQUAL_INT(1, periph_refcount(PERIPH_GPIO));
+    gpio_ctx_cleanup(&b);
+    TEST_ASSERT_EQUAL_INT(0, periph_refcount(PERIPH_GPIO));
+    periph_set_io(NULL);
+}
+
+void test_hpwm_ctx_init_through_registry(void) {
+    fake_reset(1);
+    hpwm_ctx_t ctx = {0};
+    TEST_ASSERT_EQUAL_INT(0, hpwm_ctx_init(&ctx, NULL));
+    TEST_ASSERT_EQUAL_INT(1, ctx.mapped);
+    TEST_ASSERT_EQUAL_INT(1, periph_refcount(PERIPH_PWM));
+    TEST_ASSERT_EQUAL_INT(1, periph_refcount(PERIPH_CLK));
+    TEST_ASSERT_EQUAL_INT(1, fake.opens_mem);
+
+    hpwm_ctx_stop(&ctx);
+    TEST_ASSERT_EQUAL_INT(0, periph_refcount(PERIPH_PWM));
+    TEST_ASSERT_EQUAL_INT(0, periph_refcount(PERIPH_CLK));
+    TEST_ASSERT_EQUAL_INT(1, fake.closes);
+    periph_set_io(NULL);
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Base detection
+    RUN_TEST(test_detect_base_pi4_two_cell_parent);
+    RUN_TEST(test_detect_base_pi3_one_cell_parent);
+    RUN_TEST(test_detect_base_fallbacks);
+
+    // Registry
+    RUN_TEST(test_map_is_lazy_and_uses_base_offset);
+    RUN_TEST(test_map_refcounts_shared_block);
+    RUN_TEST(test_blocks_share_one_mem_fd);
+    RUN_TEST(test_gpio_falls_back_to_gpiomem);
+    RUN_TEST(test_mmap_failure_releases_fd);
+    RUN_TEST(test_invalid_blocks);
+    RUN_TEST(test_real_io_refused_on_host);
+
+    // Registry users
+    RUN_TEST(test_gpio_mmap_backend_through_registry);
+    RUN_TEST(test_hpwm_ctx_init_through_registry);
+
+    return UNITY_END();
+}
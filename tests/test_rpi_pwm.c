@@ -409,6 +409,98 @@ void test_pwm_stress_many_pins_rapid(void) {
     TEST_PASS();
 }
 
+/* ============================================================================
+ * CONTEXT TESTS (real PWM threads on a simulated GPIO context)
+ * ============================================================================ */
+
+static volatile int rising_edges_18;
+
+static void count_rising_18(void* user, uint64_t prev, uint64_t levels) {
+    (void)user;
+    if (!(prev & (1ull << 18)) && (levels & (1ull << 18))) {
+        rising_edges_18++;
+    }
+}
+
+void test_pwm_ctx_drives_simulated_pin(void) {
+    gpio_ctx_t gpio = {0};
+    pwm_ctx_t pwm;
+    gpio_ctx_init(&gpio, GPIO_BACKEND_SIM);
+    gpio_ctx_sim_set_observer(&gpio, count_rising_18, NULL);
+    rising_edges_18 = 0;
+
+    TEST_ASSERT_EQUAL_INT(0, pwm_ctx_init(&pwm, &gpio));
+    TEST_ASSERT_EQUAL_INT(0, pwm_ctx_start(&pwm, 18, 1000));
+    TEST_ASSERT_EQUAL_INT(OUTPUT, gpio_ctx_sim_get_function(&gpio, 18));
+    pwm_ctx_write(&pwm, 18, 50);
+    usleep(30000);
+
+    TEST_ASSERT_GREATER_THAN(0, (long long)pwm_ctx_cycles(&pwm, 18));
+    pwm_ctx_stop(&pwm, 18);
+    TEST_ASSERT_GREATER_THAN(0, rising_edges_18);
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&gpio, 18));
+    TEST_ASSERT_EQUAL_UINT64(0, pwm_ctx_cycles(&pwm, 18));
+
+    pwm_ctx_cleanup(&pwm);
+    gpio_ctx_cleanup(&gpio);
+}
+
+void test_pwm_ctx_full_duty_holds_high(void) {
+    gpio_ctx_t gpio = {0};
+    pwm_ctx_t pwm;
+    gpio_ctx_init(&gpio, GPIO_BACKEND_SIM);
+    pwm_ctx_init(&pwm, &gpio);
+
+    pwm_ctx_start(&pwm, 21, 1000);
+    pwm_ctx_write(&pwm, 21, 150);  /* Clamped to 100% */
+    usleep(10000);
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, 21));
+
+    pwm_ctx_cleanup(&pwm);  /* Stops the channel */
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&gpio, 21));
+    gpio_ctx_cleanup(&gpio);
+}
+
+void test_pwm_ctx_slot_limit(void) {
+    gpio_ctx_t gpio = {0};
+    pwm_ctx_t pwm;
+    gpio_ctx_init(&gpio, GPIO_BACKEND_NULL);
+    pwm_ctx_init(&pwm, &gpio);
+
+    for (int pin = 0; pin < MAX_PWM_PINS; pin++) {
+        TEST_ASSERT_EQUAL_INT(0, pwm_ctx_start(&pwm, pin, 500));
+    }
+    TEST_ASSERT_EQUAL_INT(0, pwm_ctx_start(&pwm, 0, 500));  /* Already running */
+    TEST_ASSERT_EQUAL_INT(-1, pwm_ctx_start(&pwm, MAX_PWM_PINS, 500));
+
+    pwm_ctx_stop(&pwm, 3);
+    TEST_ASSERT_EQUAL_INT(0, pwm_ctx_start(&pwm, MAX_PWM_PINS, 500));
+
+    pwm_ctx_cleanup(&pwm);
+    gpio_ctx_cleanup(&gpio);
+}
+
+void test_pwm_ctx_independent_instances(void) {
+    gpio_ctx_t gpio_a = {0}, gpio_b = {0};
+    pwm_ctx_t a, b;
+    gpio_ctx_init(&gpio_a, GPIO_BACKEND_SIM);
+    gpio_ctx_init(&gpio_b, GPIO_BACKEND_SIM);
+    pwm_ctx_init(&a, &gpio_a);
+    pwm_ctx_init(&b, &gpio_b);
+
+    pwm_ctx_start(&a, 12, 1000);
+    pwm_ctx_write(&a, 12, 100);
+    usleep(10000);
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio_a, 12));
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&gpio_b, 12));
+    TEST_ASSERT_EQUAL_UINT64(0, pwm_ctx_cycles(&b, 12));
+
+    pwm_ctx_cleanup(&a);
+    pwm_ctx_cleanup(&b);
+    gpio_ctx_cleanup(&gpio_a);
+    gpio_ctx_cleanup(&gpio_b);
+}
+
 /* ============================================================================
  * MAIN TEST RUNNER
  * ============================================================================ */
@@ -458,6 +550,12 @@ int main(void) {
     RUN_TEST(test_pwm_stress_rapid_init_stop);
     RUN_TEST(test_pwm_stress_many_writes);
     RUN_TEST(test_pwm_stress_many_pins_rapid);
+
+    // Context tests
+    RUN_TEST(test_pwm_ctx_drives_simulated_pin);
+    RUN_TEST(test_pwm_ctx_full_duty_holds_high);
+    RUN_TEST(test_pwm_ctx_slot_limit);
+    RUN_TEST(test_pwm_ctx_independent_instances);
     
     return UNITY_END();
 }
@@ -0,0 +1,379 @@
+/*
+ * test_rpi_soft_i2c.c - Validation tests for rpi_soft_i2c.h
+ *
+ * The master runs on the GPIO simulator. A register-file slave is modelled
+ * in the simulator observer: it provides the pull-ups, decodes START/STOP
+ * and bits from the line levels and drives SDA (and, to stretch the clock,
+ * SCL) through the external input levels.
+ * Focus: byte framing, ACK/NACK, repeated START batches, clock stretching.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_SOFT_I2C_IMPLEMENTATION
+#include "rpi_soft_i2c.h"
+
+#define PIN_SDA    2
+#define PIN_SCL    3
+#define SLAVE_ADDR 0x48
+#define BIT(p)     (1ull << (p))
+
+/* ============================================================================
+ * SLAVE MODEL
+ * ============================================================================ */
+
+enum { SL_IDLE, SL_ADDR, SL_RX, SL_SLAVE_ACK, SL_TX, SL_MASTER_ACK };
+
+typedef struct {
+    gpio_ctx_t* gpio;
+    uint8_t regs[256];
+    uint8_t ptr;
+    int state;
+    int reading;
+    int first;                 /* Next written byte is the register pointer */
+    int bits;
+    uint8_t shift;
+    int master_ack;
+    int starts, stops;
+    int stretch;               /* Master polls to hold SCL low after each slave ACK */
+    int held;                  /* Polls left before SCL is released */
+} slave_t;
+
+static void slave_sda(slave_t* s, int level) {
+    gpio_ctx_sim_set_input(s->gpio, PIN_SDA, level);
+}
+
+static void slave_observer(void* user, uint64_t prev, uint64_t levels) {
+    slave_t* s = (slave_t*)user;
+    uint64_t changed = prev ^ levels;
+    int scl = (levels >> PIN_SCL) & 1;
+    int sda = (levels >> PIN_SDA) & 1;
+
+    if (scl && !(changed & BIT(PIN_SCL)) && (changed & BIT(PIN_SDA))) {
+        if (!sda) {
+            s->starts++;
+            s->state = SL_ADDR;
+            s->bits = 0;
+            s->shift = 0;
+        } else {
+            s->stops++;
+            s->state = SL_IDLE;
+        }
+    } else if ((changed & BIT(PIN_SCL)) && scl) {
+        if (s->state == SL_ADDR || s->state == SL_RX) {
+            s->shift = (uint8_t)((s->shift << 1) | sda);
+            s->bits++;
+        } else if (s->state == SL_TX) {
+            s->bits++;
+        } else if (s->state == SL_MASTER_ACK) {
+            s->master_ack = !sda;
+        }
+    } else if (changed & BIT(PIN_SCL)) {
+        switch (s->state) {
+        case SL_ADDR:
+            if (s->bits < 8) break;
+            if ((s->shift >> 1) == SLAVE_ADDR) {
+                s->reading = s->shift & 1;
+                s->first = !s->reading;
+                slave_sda(s, LOW);
+                s->state = SL_SLAVE_ACK;
+            } else {
+                s->state = SL_IDLE;  /* NACK: SDA stays released */
+            }
+            break;
+        case SL_RX:
+            if (s->bits < 8) break;
+            if (s->first) s->ptr = s->shift;
+            else s->regs[s->ptr++] = s->shift;
+            s->first = 0;
+            slave_sda(s, LOW);
+            s->state = SL_SLAVE_ACK;
+            break;
+        case SL_SLAVE_ACK:
+            slave_sda(s, HIGH);
+            s->bits = 0;
+            s->shift = 0;
+            if (s->reading) {
+                s->state = SL_TX;
+                slave_sda(s, s->regs[s->ptr] >> 7);
+            } else {
+                s->state = SL_RX;
+            }
+            if (s->stretch) {
+                gpio_ctx_sim_set_input(s->gpio, PIN_SCL, LOW);
+                s->held = s->stretch;
+            }
+            break;
+        case SL_TX:
+            if (s->bits < 8) {
+                slave_sda(s, (s->regs[s->ptr] >> (7 - s->bits)) & 1);
+            } else {
+                s->ptr++;
+                slave_sda(s, HIGH);
+                s->state = SL_MASTER_ACK;
+            }
+            break;
+        case SL_MASTER_ACK:
+            if (s->master_ack) {
+                s->bits = 0;
+                s->state = SL_TX;
+                slave_sda(s, s->regs[s->ptr] >> 7);
+            } else {
+                s->state = SL_IDLE;
+            }
+            break;
+        }
+    }
+}
+
+static void slave_attach(slave_t* s, gpio_ctx_t* ctx) {
+    memset(s, 0, sizeof(*s));
+    s->gpio = ctx;
+
+    /* Pull-ups */
+    gpio_ctx_sim_set_input(ctx, PIN_SDA, HIGH);
+    gpio_ctx_sim_set_input(ctx, PIN_SCL, HIGH);
+    gpio_ctx_sim_set_observer(ctx, slave_observer, s);
+}
+
+/* Virtual time for clock stretching: each read the master makes is one
+ * tick, and a held SCL is released once its ticks run out. The master gets
+ * a copy of the simulator context whose reads go through here; the slave
+ * keeps driving the real one. */
+static slave_t* stretch_slave;
+static gpio_backend_ops_t stretch_ops;
+
+static uint32_t stretch_read_bank(gpio_ctx_t* ctx, int bank) {
+    slave_t* s = stretch_slave;
+    if (s->held && --s->held == 0) gpio_ctx_sim_set_input(s->gpio, PIN_SCL, HIGH);
+    return s->gpio->ops->read_bank(ctx, bank);
+}
+
+static void stretch_attach(gpio_ctx_t* master, gpio_ctx_t* ctx, slave_t* slave, int polls) {
+    stretch_slave = slave;
+    slave->stretch = polls;
+    stretch_ops = *ctx->ops;
+    stretch_ops.read_bank = stretch_read_bank;
+    *master = *ctx;
+    master->ops = &stretch_ops;
+}
+
+static void setup(gpio_ctx_t* ctx, soft_i2c_t* bus, slave_t* slave, uint32_t hz) {
+    memset(ctx, 0, sizeof(*ctx));
+    gpio_ctx_init(ctx, GPIO_BACKEND_SIM);
+    slave_attach(slave, ctx);
+    TEST_ASSERT_EQUAL_INT(0, soft_i2c_init(bus, ctx, PIN_SDA, PIN_SCL, hz));
+}
+
+static void teardown(gpio_ctx_t* ctx) {
+    gpio_ctx_sim_set_observer(ctx, NULL, NULL);
+    gpio_ctx_cleanup(ctx);
+}
+
+/* ============================================================================
+ * BASIC TESTS
+ * ============================================================================ */
+
+void test_init_releases_lines(void) {
+    gpio_ctx_t ctx;
+    soft_i2c_t bus;
+    slave_t slave;
+    setup(&ctx, &bus, &slave, 0);
+
+    TEST_ASSERT_EQUAL_INT(-1, soft_i2c_init(&bus, &ctx, PIN_SDA, PIN_SDA, 0));
+    TEST_ASSERT_EQUAL_INT(-1, soft_i2c_init(&bus, &ctx, 60, PIN_SCL, 0));
+    TEST_ASSERT_EQUAL_INT(0, soft_i2c_init(&bus, &ctx, PIN_SDA, PIN_SCL, 0));
+
+    TEST_ASSERT_EQUAL_INT(INPUT, gpio_ctx_sim_get_function(&ctx, PIN_SDA));
+    TEST_ASSERT_EQUAL_INT(INPUT, gpio_ctx_sim_get_function(&ctx, PIN_SCL));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&ctx, PIN_SDA));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&ctx, PIN_SCL));
+    TEST_ASSERT_EQUAL_INT(SOFT_I2C_HZ_DEFAULT, bus.hz);
+
+    /* Half period scales with the calibrated loop rate */
+    TEST_ASSERT(soft_i2c_loops_per_us() > 0.0);
+    uint32_t slow = bus.half_loops;
+    soft_i2c_set_clock(&bus, 400000);
+    TEST_ASSERT(bus.half_loops * 3 < slow);
+    teardown(&ctx);
+}
+
+void test_write_then_register_read(void) {
+    gpio_ctx_t ctx;
+    soft_i2c_t bus;
+    slave_t slave;
+    setup(&ctx, &bus, &slave, 1000000);
+
+    uint8_t w[4] = { 0x10, 0xDE, 0xAD, 0xBE };
+    TEST_ASSERT_EQUAL_INT(0, soft_i2c_write(&bus, SLAVE_ADDR, w, sizeof(w)));
+    TEST_ASSERT_EQUAL_INT(0xDE, slave.regs[0x10]);
+    TEST_ASSERT_EQUAL_INT(0xBE, slave.regs[0x12]);
+
+    uint8_t reg = 0x11, r[2] = { 0 };
+    TEST_ASSERT_EQUAL_INT(0, soft_i2c_write_read(&bus, SLAVE_ADDR, &reg, 1, r, 2));
+    TEST_ASSERT_EQUAL_INT(0xAD, r[0]);
+    TEST_ASSERT_EQUAL_INT(0xBE, r[1]);
+
+    /* write: 1 START; write_read: START + repeated START; one STOP each */
+    TEST_ASSERT_EQUAL_INT(3, slave.starts);
+    TEST_ASSERT_EQUAL_INT(2, slave.stops);
+    TEST_ASSERT_EQUAL_UINT64(7, bus.stats.bytes);
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&ctx, PIN_SDA));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&ctx, PIN_SCL));
+    teardown(&ctx);
+}
+
+void test_nack_aborts_with_stop(void) {
+    gpio_ctx_t ctx;
+    soft_i2c_t bus;
+    slave_t slave;
+    setup(&ctx, &bus, &slave, 1000000);
+
+    TEST_ASSERT_EQUAL_INT(1, soft_i2c_probe(&bus, SLAVE_ADDR));
+    TEST_ASSERT_EQUAL_INT(0, soft_i2c_probe(&bus, 0x50));
+    TEST_ASSERT_EQUAL_INT(SOFT_I2C_NACK, bus.error);
+
+    /* A NACKed first message skips the rest of the batch */
+    uint8_t r[1];
+    soft_i2c_msg_t msgs[2] = { { 0x51, 0, 0, NULL }, { SLAVE_ADDR, SOFT_I2C_M_RD, 1, r } };
+    TEST_ASSERT_EQUAL_INT(-1, soft_i2c_transfer(&bus, msgs, 2));
+    TEST_ASSERT_EQUAL_INT(3, slave.starts);
+    TEST_ASSERT_EQUAL_INT(3, slave.stops);
+    TEST_ASSERT_EQUAL_UINT64(2, bus.stats.nacks);
+    TEST_ASSERT_EQUAL_UINT64(3, bus.stats.transactions);
+    teardown(&ctx);
+}
+
+void test_invalid_messages_touch_nothing(void) {
+    gpio_ctx_t ctx;
+    soft_i2c_t bus;
+    slave_t slave;
+    setup(&ctx, &bus, &slave, 1000000);
+    uint8_t b[1];
+
+    soft_i2c_msg_t empty_read = { SLAVE_ADDR, SOFT_I2C_M_RD, 0, b };
+    soft_i2c_msg_t wide_addr = { 0x80, 0, 1, b };
+    soft_i2c_msg_t bad_flags = { SLAVE_ADDR, 0x8000, 1, b };
+    soft_i2c_msg_t no_buf = { SLAVE_ADDR, 0, 1, NULL };
+    TEST_ASSERT_EQUAL_INT(-1, soft_i2c_transfer(&bus, &empty_read, 1));
+    TEST_ASSERT_EQUAL_INT(SOFT_I2C_INVALID, bus.error);
+    TEST_ASSERT_EQUAL_INT(-1, soft_i2c_transfer(&bus, &wide_addr, 1));
+    TEST_ASSERT_EQUAL_INT(-1, soft_i2c_transfer(&bus, &bad_flags, 1));
+    TEST_ASSERT_EQUAL_INT(-1, soft_i2c_transfer(&bus, &no_buf, 1));
+    TEST_ASSERT_EQUAL_INT(-1, soft_i2c_transfer(&bus, NULL, 1));
+    TEST_ASSERT_EQUAL_INT(0, slave.starts);
+    teardown(&ctx);
+}
+
+/* ============================================================================
+ * TRANSACTION TESTS
+ * ============================================================================ */
+
+void test_batch_uses_repeated_starts(void) {
+    gpio_ctx_t ctx;
+    soft_i2c_t bus;
+    slave_t slave;
+    setup(&ctx, &bus, &slave, 1000000);
+
+    uint8_t w0[3] = { 0x20, 0x11, 0x22 };
+    uint8_t w1[1] = { 0x20 };
+    uint8_t r[2] = { 0 };
+    uint8_t w2[2] = { 0x30, 0x33 };
+    soft_i2c_msg_t msgs[4] = {
+        { SLAVE_ADDR, 0, sizeof(w0), w0 },
+        { SLAVE_ADDR, 0, sizeof(w1), w1 },
+        { SLAVE_ADDR, SOFT_I2C_M_RD, sizeof(r), r },
+        { SLAVE_ADDR, 0, sizeof(w2), w2 },
+    };
+    TEST_ASSERT_EQUAL_INT(0, soft_i2c_transfer(&bus, msgs, 4));
+    TEST_ASSERT_EQUAL_INT(4, slave.starts);
+    TEST_ASSERT_EQUAL_INT(1, slave.stops);
+    TEST_ASSERT_EQUAL_INT(0x11, r[0]);
+    TEST_ASSERT_EQUAL_INT(0x22, r[1]);
+    TEST_ASSERT_EQUAL_INT(0x33, slave.regs[0x30]);
+    teardown(&ctx);
+}
+
+void test_clock_stretching_is_honoured(void) {
+    gpio_ctx_t ctx, master;
+    soft_i2c_t bus;
+    slave_t slave;
+    setup(&ctx, &bus, &slave, 1000000);
+    stretch_attach(&master, &ctx, &slave, 4);
+    TEST_ASSERT_EQUAL_INT(0, soft_i2c_init(&bus, &master, PIN_SDA, PIN_SCL, 1000000));
+
+    uint8_t w[3] = { 0x40, 0x5A, 0xA5 };
+    uint8_t reg = 0x40, r[2] = { 0 };
+    TEST_ASSERT_EQUAL_INT(0, soft_i2c_write(&bus, SLAVE_ADDR, w, sizeof(w)));
+    TEST_ASSERT_EQUAL_INT(0, soft_i2c_write_read(&bus, SLAVE_ADDR, &reg, 1, r, 2));
+
+    TEST_ASSERT_EQUAL_INT(0x5A, r[0]);
+    TEST_ASSERT_EQUAL_INT(0xA5, r[1]);
+    TEST_ASSERT_EQUAL_INT(0, slave.held);
+    TEST_ASSERT_EQUAL_UINT64(7, bus.stats.stretches);  /* One per slave ACK */
+    TEST_ASSERT_EQUAL_UINT64(0, bus.stats.timeouts);
+    teardown(&ctx);
+}
+
+void test_stuck_clock_times_out(void) {
+    gpio_ctx_t ctx;
+    soft_i2c_t bus;
+    slave_t slave;
+    setup(&ctx, &bus, &slave, 1000000);
+    gpio_ctx_sim_set_input(&ctx, PIN_SCL, LOW);
+
+    uint8_t b = 0;
+    TEST_ASSERT_EQUAL_INT(-1, soft_i2c_write(&bus, SLAVE_ADDR, &b, 1));
+    TEST_ASSERT_EQUAL_INT(SOFT_I2C_TIMEOUT, bus.error);
+    TEST_ASSERT(bus.stats.timeouts >= 1);
+    teardown(&ctx);
+}
+
+void test_clock_sets_minimum_duration(void) {
+    gpio_ctx_t ctx;
+    soft_i2c_t bus;
+    slave_t slave;
+    setup(&ctx, &bus, &slave, 100000);
+
+    /* The half period is the driver's calibrated spin for 5 us */
+    double half_us = bus.half_loops / soft_i2c_loops_per_us();
+    TEST_ASSERT_WITHIN(1, (long long)(5.0 * soft_i2c_loops_per_us() + 0.5), bus.half_loops);
+    uint8_t w[4] = { 0x00, 1, 2, 3 };
+    struct timespec a, b;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    TEST_ASSERT_EQUAL_INT(0, soft_i2c_write(&bus, SLAVE_ADDR, w, sizeof(w)));
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    double us = (b.tv_sec - a.tv_sec) * 1e6 + (b.tv_nsec - a.tv_nsec) / 1e3;
+    /* Address + 4 bytes = 45 clocks of two half periods each. The spin can
+     * run up to twice as fast as calibrated on a shared or virtual CPU;
+     * without the spin the transfer takes a small fraction of this bound */
+    TEST_ASSERT(us >= 90 * half_us / 3);
+    TEST_ASSERT_EQUAL_INT(3, slave.regs[2]);
+    teardown(&ctx);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Basic tests
+    RUN_TEST(test_init_releases_lines);
+    RUN_TEST(test_write_then_register_read);
+    RUN_TEST(test_nack_aborts_with_stop);
+    RUN_TEST(test_invalid_messages_touch_nothing);
+
+    // Transaction tests
+    RUN_TEST(test_batch_uses_repeated_starts);
+    RUN_TEST(test_clock_stretching_is_honoured);
+    RUN_TEST(test_stuck_clock_times_out);
+    RUN_TEST(test_clock_sets_minimum_duration);
+
+    return UNITY_END();
+}
@@ -0,0 +1,279 @@
+/*
+ * test_rpi_soft_spi.c - Validation tests for rpi_soft_spi.h
+ *
+ * The master runs on the GPIO simulator; a slave modelled in the simulator
+ * observer samples MOSI and drives MISO on the edges its mode dictates.
+ * Focus: all four modes, bit order, combined stores, chip selects, clock.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_SOFT_SPI_IMPLEMENTATION
+#include "rpi_soft_spi.h"
+
+#define PIN_SCK  11
+#define PIN_MOSI 10
+#define PIN_MISO 9
+#define PIN_CS0  8
+#define PIN_CS1  7
+#define BIT(p)   (1ull << (p))
+
+/* ============================================================================
+ * SLAVE MODEL
+ * ============================================================================ */
+
+typedef struct {
+    gpio_ctx_t* gpio;
+    int mode;
+    int lsb_first;
+    int cs_pin;
+    const uint8_t* reply;      /* Bytes shifted out on MISO */
+    uint8_t rx[64];            /* Bytes sampled from MOSI */
+    int bits;                  /* Bits sampled in this selection */
+    int out_bits;              /* Bits driven in this selection */
+    int mosi_on_sample_edge;   /* MOSI moved in the store of a sampling edge */
+    int combined;              /* SCK and MOSI moved in one store */
+    int selects;
+} slave_t;
+
+static void slave_drive(slave_t* s) {
+    int byte = s->out_bits / 8, i = s->out_bits % 8;
+    int bit = s->lsb_first ? (s->reply[byte] >> i) & 1 : (s->reply[byte] >> (7 - i)) & 1;
+    gpio_ctx_sim_set_input(s->gpio, PIN_MISO, bit);
+    s->out_bits++;
+}
+
+static void slave_observer(void* user, uint64_t prev, uint64_t levels) {
+    slave_t* s = (slave_t*)user;
+    uint64_t changed = prev ^ levels;
+    int cpol = s->mode >> 1, cpha = s->mode & 1;
+
+    if ((changed & BIT(s->cs_pin)) && !(levels & BIT(s->cs_pin))) {
+        s->bits = 0;
+        s->out_bits = 0;
+        s->selects++;
+        if (!cpha) slave_drive(s);
+    }
+    if (levels & BIT(s->cs_pin)) return;
+
+    if ((changed & BIT(PIN_SCK)) && (changed & BIT(PIN_MOSI))) s->combined++;
+    if (!(changed & BIT(PIN_SCK))) return;
+
+    int leading = (int)((levels >> PIN_SCK) & 1) != cpol;
+    if (leading == !cpha) {
+        /* Sampling edge */
+        if (changed & BIT(PIN_MOSI)) s->mosi_on_sample_edge++;
+        int bit = (levels >> PIN_MOSI) & 1;
+        int byte = s->bits / 8, i = s->bits % 8;
+        if (i == 0) s->rx[byte] = 0;
+        s->rx[byte] |= (uint8_t)(s->lsb_first ? bit << i : bit << (7 - i));
+        s->bits++;
+    } else if (s->out_bits < 8 * 16) {
+        /* Shift edge: leading with CPHA 1, trailing with CPHA 0 */
+        slave_drive(s);
+    }
+}
+
+static void setup(gpio_ctx_t* ctx, soft_spi_t* spi, slave_t* slave, int mode, int order, const uint8_t* reply) {
+    memset(ctx, 0, sizeof(*ctx));
+    gpio_ctx_init(ctx, GPIO_BACKEND_SIM);
+    TEST_ASSERT_EQUAL_INT(0, soft_spi_init(spi, ctx, PIN_SCK, PIN_MOSI, PIN_MISO));
+    TEST_ASSERT_EQUAL_INT(0, soft_spi_set_mode(spi, mode, order));
+    TEST_ASSERT_EQUAL_INT(0, soft_spi_add_cs(spi, PIN_CS0));
+
+    memset(slave, 0, sizeof(*slave));
+    slave->gpio = ctx;
+    slave->mode = mode;
+    slave->lsb_first = order == SOFT_SPI_LSB_FIRST;
+    slave->cs_pin = PIN_CS0;
+    slave->reply = reply;
+    gpio_ctx_sim_set_observer(ctx, slave_observer, slave);
+}
+
+static void teardown(gpio_ctx_t* ctx, soft_spi_t* spi) {
+    soft_spi_free(spi);
+    gpio_ctx_cleanup(ctx);
+}
+
+/* ============================================================================
+ * SETUP TESTS
+ * ============================================================================ */
+
+void test_init_validates_pins(void) {
+    gpio_ctx_t ctx;
+    soft_spi_t spi;
+    memset(&ctx, 0, sizeof(ctx));
+    gpio_ctx_init(&ctx, GPIO_BACKEND_SIM);
+
+    TEST_ASSERT_EQUAL_INT(-1, soft_spi_init(&spi, &ctx, 60, PIN_MOSI, PIN_MISO));
+    TEST_ASSERT_EQUAL_INT(-1, soft_spi_init(&spi, &ctx, PIN_SCK, PIN_SCK, PIN_MISO));
+    TEST_ASSERT_EQUAL_INT(-1, soft_spi_init(&spi, &ctx, PIN_SCK, PIN_MOSI, PIN_MOSI));
+    TEST_ASSERT_EQUAL_INT(0, soft_spi_init(&spi, &ctx, PIN_SCK, PIN_MOSI, -1));
+    TEST_ASSERT_EQUAL_INT(OUTPUT, gpio_ctx_sim_get_function(&ctx, PIN_SCK));
+    TEST_ASSERT_EQUAL_INT(OUTPUT, gpio_ctx_sim_get_function(&ctx, PIN_MOSI));
+
+    TEST_ASSERT_EQUAL_INT(-1, soft_spi_set_mode(&spi, 4, SOFT_SPI_MSB_FIRST));
+    TEST_ASSERT_EQUAL_INT(0, soft_spi_set_mode(&spi, 2, SOFT_SPI_MSB_FIRST));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&ctx, PIN_SCK));  /* CPOL 1 idles high */
+
+    TEST_ASSERT_EQUAL_INT(-1, soft_spi_add_cs(&spi, PIN_SCK));
+    for (int i = 0; i < SOFT_SPI_MAX_CS; i++) {
+        TEST_ASSERT_EQUAL_INT(i, soft_spi_add_cs(&spi, 16 + i));
+        TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&ctx, 16 + i));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, soft_spi_add_cs(&spi, 30));
+    TEST_ASSERT_EQUAL_INT(-1, soft_spi_transfer(&spi, SOFT_SPI_MAX_CS, NULL, NULL, 1));
+
+    soft_spi_free(&spi);
+    gpio_ctx_cleanup(&ctx);
+}
+
+void test_clock_rounds_to_half_period(void) {
+    gpio_ctx_t ctx;
+    soft_spi_t spi;
+    memset(&ctx, 0, sizeof(ctx));
+    gpio_ctx_init(&ctx, GPIO_BACKEND_SIM);
+    soft_spi_init(&spi, &ctx, PIN_SCK, PIN_MOSI, PIN_MISO);
+
+    TEST_ASSERT_EQUAL_INT(1000000, soft_spi_set_clock(&spi, 1000000));
+    TEST_ASSERT_EQUAL_INT(500, spi.half_period_ns);
+    TEST_ASSERT_EQUAL_INT(500000000 / 166, soft_spi_set_clock(&spi, 3000000));
+    TEST_ASSERT_EQUAL_INT(0, soft_spi_set_clock(&spi, 0));
+    TEST_ASSERT_EQUAL_INT(0, spi.half_period_ns);
+
+    soft_spi_free(&spi);
+    gpio_ctx_cleanup(&ctx);
+}
+
+/* ============================================================================
+ * TRANSFER TESTS
+ * ============================================================================ */
+
+void test_full_duplex_all_modes_and_orders(void) {
+    static const uint8_t tx[] = { 0xA5, 0x00, 0xFF, 0x3C, 0x81, 0x7E };
+    static const uint8_t reply[16] = { 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC };
+
+    for (int mode = 0; mode < 4; mode++) {
+        for (int order = SOFT_SPI_MSB_FIRST; order <= SOFT_SPI_LSB_FIRST; order++) {
+            gpio_ctx_t ctx;
+            soft_spi_t spi;
+            slave_t slave;
+            uint8_t rx[sizeof(tx)];
+            setup(&ctx, &spi, &slave, mode, order, reply);
+
+            TEST_ASSERT_EQUAL_INT(0, soft_spi_transfer(&spi, 0, tx, rx, sizeof(tx)));
+            TEST_ASSERT_EQUAL_INT(1, slave.selects);
+            TEST_ASSERT_EQUAL_INT(8 * (int)sizeof(tx), slave.bits);
+            TEST_ASSERT_EQUAL_INT(0, memcmp(tx, slave.rx, sizeof(tx)));
+            TEST_ASSERT_EQUAL_INT(0, memcmp(reply, rx, sizeof(tx)));
+            TEST_ASSERT_EQUAL_INT(0, slave.mosi_on_sample_edge);
+
+            /* Bus returns to idle with CS released */
+            TEST_ASSERT_EQUAL_INT(mode >> 1, gpio_ctx_read(&ctx, PIN_SCK));
+            TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&ctx, PIN_CS0));
+            teardown(&ctx, &spi);
+        }
+    }
+}
+
+void test_mosi_and_clock_share_stores(void) {
+    static const uint8_t reply[16] = { 0 };
+    gpio_ctx_t ctx;
+    soft_spi_t spi;
+    slave_t slave;
+    setup(&ctx, &spi, &slave, 0, SOFT_SPI_MSB_FIRST, reply);
+
+    /* 0x55: MOSI changes on every bit, always in the data store */
+    uint8_t tx = 0x55;
+    uint64_t writes = ctx.stats.writes;
+    soft_spi_transfer(&spi, 0, &tx, NULL, 1);
+
+    /* 8 data + 8 clock stores, the final trailing edge, CS low and high */
+    TEST_ASSERT_EQUAL_UINT64(8 * 2 + 1 + 2, ctx.stats.writes - writes);
+    TEST_ASSERT_EQUAL_INT(7, slave.combined);  /* Bits 1-7 ride on a trailing edge */
+    TEST_ASSERT_EQUAL_INT(0x55, slave.rx[0]);
+
+    /* Within a byte, an unchanged MOSI is not rewritten */
+    const gpio_store_t* st = &spi.table[0xFF * 8];
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_MOSI), st[0].set_mask);
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_SCK), st[0].clr_mask);
+    TEST_ASSERT_EQUAL_UINT64(0, st[1].set_mask);
+    TEST_ASSERT_EQUAL_UINT64(BIT(PIN_SCK), st[1].clr_mask);
+    teardown(&ctx, &spi);
+}
+
+void test_manual_chip_select_spans_transfers(void) {
+    static const uint8_t reply[16] = { 0xDE, 0xAD, 0xBE, 0xEF };
+    gpio_ctx_t ctx;
+    soft_spi_t spi;
+    slave_t slave;
+    setup(&ctx, &spi, &slave, 3, SOFT_SPI_MSB_FIRST, reply);
+    TEST_ASSERT_EQUAL_INT(1, soft_spi_add_cs(&spi, PIN_CS1));
+
+    /* Command, then read with NULL TX, under one selection */
+    uint8_t cmd[2] = { 0x0B, 0x42 };
+    uint8_t rx[2];
+    soft_spi_select(&spi, 0);
+    soft_spi_transfer(&spi, SOFT_SPI_NO_CS, cmd, NULL, 2);
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&ctx, PIN_CS0));
+    soft_spi_transfer(&spi, SOFT_SPI_NO_CS, NULL, rx, 2);
+    soft_spi_deselect(&spi, 0);
+
+    TEST_ASSERT_EQUAL_INT(1, slave.selects);
+    TEST_ASSERT_EQUAL_INT(32, slave.bits);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(cmd, slave.rx, 2));
+    TEST_ASSERT_EQUAL_INT(SOFT_SPI_FILL, slave.rx[2]);
+    TEST_ASSERT_EQUAL_INT(0xBE, rx[0]);
+    TEST_ASSERT_EQUAL_INT(0xEF, rx[1]);
+
+    /* The other chip select was never touched */
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&ctx, PIN_CS1));
+    TEST_ASSERT_EQUAL_UINT64(4, spi.bytes);
+    TEST_ASSERT_EQUAL_UINT64(2, spi.transfers);
+    teardown(&ctx, &spi);
+}
+
+void test_clocked_transfer_takes_its_periods(void) {
+    static const uint8_t reply[16] = { 0 };
+    gpio_ctx_t ctx;
+    soft_spi_t spi;
+    slave_t slave;
+    setup(&ctx, &spi, &slave, 0, SOFT_SPI_MSB_FIRST, reply);
+    soft_spi_set_clock(&spi, 100000);  /* 10 us per bit */
+
+    uint8_t tx[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    struct timespec a, b;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    soft_spi_transfer(&spi, 0, tx, NULL, sizeof(tx));
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    double us = (b.tv_sec - a.tv_sec) * 1e6 + (b.tv_nsec - a.tv_nsec) / 1e3;
+
+    TEST_ASSERT(us >= 800.0);
+    TEST_ASSERT(us < 20000.0);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(tx, slave.rx, sizeof(tx)));
+    teardown(&ctx, &spi);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Setup tests
+    RUN_TEST(test_init_validates_pins);
+    RUN_TEST(test_clock_rounds_to_half_period);
+
+    // Transfer tests
+    RUN_TEST(test_full_duplex_all_modes_and_orders);
+    RUN_TEST(test_mosi_and_clock_share_stores);
+    RUN_TEST(test_manual_chip_select_spans_transfers);
+    RUN_TEST(test_clocked_transfer_takes_its_periods);
+
+    return UNITY_END();
+}
@@ -0,0 +1,441 @@
+/*
+ * test_rpi_soft_uart.c - Validation tests for rpi_soft_uart.h
+ *
+ * Ports run on the GPIO simulator. Wires are modelled in the simulator
+ * observer, which copies each TX level onto the RX input it is looped to
+ * and can log those edges with the virtual time of the pass that made
+ * them. Most tests step soft_uart_update() through virtual time; one runs
+ * the service thread in wall time.
+ * Focus: frame layout, bit timing, full-duplex loopback in polled and edge
+ * mode, framing/parity/false-start detection, overruns.
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_SOFT_UART_IMPLEMENTATION
+#include "rpi_soft_uart.h"
+
+#define PIN_TX0 17
+#define PIN_RX0 27
+#define PIN_TX1 22
+#define PIN_RX1 23
+#define PIN_IN  24   /* Driven by the test */
+#define STEP_NS 1000
+
+/* ============================================================================
+ * WIRING
+ * ============================================================================ */
+
+#define MAX_EDGES 4096
+
+typedef struct {
+    int pin;
+    int level;
+    uint64_t t_ns;
+} edge_t;
+
+typedef struct {
+    gpio_ctx_t* gpio;
+    int from[4];
+    int to[4];
+    int wires;
+    uint64_t now_ns;           /* Virtual time of the current pass */
+    edge_t edges[MAX_EDGES];   /* Levels arriving on the wired inputs */
+    int edge_count;
+} wiring_t;
+
+static wiring_t wiring;
+
+static void wire_observer(void* user, uint64_t prev, uint64_t levels) {
+    wiring_t* w = (wiring_t*)user;
+    for (int i = 0; i < w->wires; i++) {
+        if (!(((prev ^ levels) >> w->from[i]) & 1)) continue;
+        int level = (int)((levels >> w->from[i]) & 1);
+        gpio_ctx_sim_set_input(w->gpio, w->to[i], level);
+        if (w->edge_count < MAX_EDGES) w->edges[w->edge_count++] = (edge_t){ w->to[i], level, w->now_ns };
+    }
+}
+
+static void wire(int from, int to) {
+    wiring.from[wiring.wires] = from;
+    wiring.to[wiring.wires] = to;
+    wiring.wires++;
+    gpio_ctx_sim_set_input(wiring.gpio, to, HIGH);
+}
+
+static void setup(gpio_ctx_t* gpio, soft_uart_t* uart) {
+    memset(gpio, 0, sizeof(*gpio));
+    gpio_ctx_init(gpio, GPIO_BACKEND_SIM);
+    memset(&wiring, 0, sizeof(wiring));
+    wiring.gpio = gpio;
+    gpio_ctx_sim_set_observer(gpio, wire_observer, &wiring);
+    TEST_ASSERT_EQUAL_INT(0, soft_uart_init(uart, gpio));
+}
+
+static void teardown(gpio_ctx_t* gpio) {
+    gpio_ctx_sim_set_observer(gpio, NULL, NULL);
+    gpio_ctx_cleanup(gpio);
+}
+
+/* Polled passes every STEP_NS of virtual time, up to end_ns */
+static void run_until(soft_uart_t* uart, uint64_t end_ns) {
+    for (; wiring.now_ns < end_ns; wiring.now_ns += STEP_NS) {
+        soft_uart_update(uart, gpio_ctx_read_all(uart->gpio), wiring.now_ns);
+    }
+}
+
+/* Edge-mode passes: logged edges are handed over after the pass that made them */
+static void run_edges_until(soft_uart_t* uart, uint64_t end_ns) {
+    for (; wiring.now_ns < end_ns; wiring.now_ns += STEP_NS) {
+        wiring.edge_count = 0;
+        soft_uart_update(uart, 0, wiring.now_ns);
+        for (int i = 0; i < wiring.edge_count; i++) {
+            soft_uart_edge(uart, wiring.edges[i].pin, wiring.edges[i].level, wiring.edges[i].t_ns);
+        }
+    }
+}
+
+static uint64_t frame_ns(uint32_t baud, int bits, size_t bytes) {
+    return (uint64_t)bits * bytes * 1000000000ull / baud;
+}
+
+/* Sends raw bits (start bit first) on PIN_IN, one bit per period */
+static void drive_bits(soft_uart_t* uart, uint32_t frame, int bits, uint32_t baud) {
+    uint64_t start = wiring.now_ns;
+    for (int b = 0; b < bits; b++) {
+        gpio_ctx_sim_set_input(uart->gpio, PIN_IN, (frame >> b) & 1);
+        run_until(uart, start + (uint64_t)(b + 1) * 1000000000ull / baud);
+    }
+    gpio_ctx_sim_set_input(uart->gpio, PIN_IN, HIGH);
+}
+
+/* ============================================================================
+ * FRAMES AND TIMING
+ * ============================================================================ */
+
+void test_frame_table(void) {
+    gpio_ctx_t gpio;
+    soft_uart_t uart;
+    setup(&gpio, &uart);
+
+    int p = soft_uart_add(&uart, PIN_TX0, PIN_RX0, 9600);
+    TEST_ASSERT_EQUAL_INT(0, p);
+    TEST_ASSERT_EQUAL_INT(10, uart.port[p].frame_bits);
+    TEST_ASSERT_EQUAL_INT(0x200 | (0xA5 << 1), uart.port[p].frames[0xA5]);
+
+    /* 7E2: 0x41 has two ones, so the even parity bit is 0 */
+    TEST_ASSERT_EQUAL_INT(0, soft_uart_set_format(&uart, p, 7, SOFT_UART_PARITY_EVEN, 2));
+    TEST_ASSERT_EQUAL_INT(11, uart.port[p].frame_bits);
+    TEST_ASSERT_EQUAL_INT(0x600 | (0x41 << 1), uart.port[p].frames[0x41]);
+    TEST_ASSERT_EQUAL_INT(0x600 | 0x100 | (0x43 << 1), uart.port[p].frames[0x43]);
+    TEST_ASSERT_EQUAL_INT(0, soft_uart_set_format(&uart, p, 7, SOFT_UART_PARITY_ODD, 1));
+    TEST_ASSERT_EQUAL_INT(0x200 | 0x100 | (0x41 << 1), uart.port[p].frames[0x41]);
+
+    TEST_ASSERT_EQUAL_INT(-1, soft_uart_set_format(&uart, p, 9, SOFT_UART_PARITY_NONE, 1));
+    TEST_ASSERT_EQUAL_INT(-1, soft_uart_set_format(&uart, p, 8, SOFT_UART_PARITY_NONE, 3));
+    TEST_ASSERT_EQUAL_INT(-1, soft_uart_add(&uart, PIN_TX1, PIN_TX1, 9600));
+    TEST_ASSERT_EQUAL_INT(-1, soft_uart_add(&uart, SOFT_UART_NO_PIN, SOFT_UART_NO_PIN, 9600));
+    TEST_ASSERT_EQUAL_INT(-1, soft_uart_add(&uart, PIN_TX1, PIN_RX1, 10));
+    TEST_ASSERT_EQUAL_INT(1, soft_uart_add(&uart, PIN_TX1, SOFT_UART_NO_PIN, 115200));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, PIN_TX1));
+    teardown(&gpio);
+}
+
+void test_tx_bits_on_absolute_deadlines(void) {
+    gpio_ctx_t gpio;
+    soft_uart_t uart;
+    setup(&gpio, &uart);
+    wire(PIN_TX0, PIN_RX0);
+    int p = soft_uart_add(&uart, PIN_TX0, SOFT_UART_NO_PIN, 115200);
+    wiring.edge_count = 0;
+
+    /* 0x55 toggles on every bit boundary; two back-to-back frames */
+    const uint8_t data[2] = { 0x55, 0x55 };
+    wiring.now_ns = 5000;
+    TEST_ASSERT_EQUAL_INT(2, soft_uart_write(&uart, p, data, 2));
+    TEST_ASSERT_FALSE(soft_uart_tx_idle(&uart, p));
+    run_until(&uart, 5000 + frame_ns(115200, 10, 2) + 20000);
+    TEST_ASSERT_TRUE(soft_uart_tx_idle(&uart, p));
+
+    /* Every bit boundary of both frames; the stop bit runs into idle */
+    TEST_ASSERT_EQUAL_INT(20, wiring.edge_count);
+    uint64_t t0 = wiring.edges[0].t_ns;
+    TEST_ASSERT_EQUAL_UINT64(5000, t0);
+    for (int i = 0; i < wiring.edge_count; i++) {
+        uint64_t ideal = t0 + (uint64_t)i * 1000000000ull / 115200;
+        TEST_ASSERT_GREATER_OR_EQUAL(ideal, wiring.edges[i].t_ns);
+        TEST_ASSERT_LESS_THAN(ideal + STEP_NS, wiring.edges[i].t_ns);
+        TEST_ASSERT_EQUAL_INT(i & 1, wiring.edges[i].level);
+    }
+
+    soft_uart_stats_t st;
+    soft_uart_get_stats(&uart, p, &st);
+    TEST_ASSERT_EQUAL_UINT64(2, st.tx_bytes);
+    TEST_ASSERT_LESS_THAN(STEP_NS, st.max_late_ns);
+    teardown(&gpio);
+}
+
+/* ============================================================================
+ * LOOPBACK
+ * ============================================================================ */
+
+void test_full_duplex_loopback_all_bytes(void) {
+    gpio_ctx_t gpio;
+    soft_uart_t uart;
+    setup(&gpio, &uart);
+    wire(PIN_TX0, PIN_RX1);
+    wire(PIN_TX1, PIN_RX0);
+    int a = soft_uart_add(&uart, PIN_TX0, PIN_RX0, 115200);
+    int b = soft_uart_add(&uart, PIN_TX1, PIN_RX1, 115200);
+
+    uint8_t out[256], back[256], in[256];
+    for (int i = 0; i < 256; i++) {
+        out[i] = (uint8_t)i;
+        back[i] = (uint8_t)(255 - i);
+    }
+    TEST_ASSERT_EQUAL_INT(256, soft_uart_write(&uart, a, out, 256));
+    wiring.now_ns = 3000;   /* Port b starts a third of a bit later */
+    run_until(&uart, 3000);
+    TEST_ASSERT_EQUAL_INT(256, soft_uart_write(&uart, b, back, 256));
+    run_until(&uart, frame_ns(115200, 10, 256) + 50000);
+
+    TEST_ASSERT_EQUAL_INT(256, soft_uart_available(&uart, b));
+    TEST_ASSERT_EQUAL_INT(256, soft_uart_read(&uart, b, in, sizeof(in)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(in, out, 256));
+    TEST_ASSERT_EQUAL_INT(256, soft_uart_read(&uart, a, in, sizeof(in)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(in, back, 256));
+
+    soft_uart_stats_t st;
+    soft_uart_get_stats(&uart, a, &st);
+    TEST_ASSERT_EQUAL_UINT64(0, st.framing_errors + st.false_starts + st.overruns);
+    teardown(&gpio);
+}
+
+void test_loopback_seven_bits_even_parity(void) {
+    gpio_ctx_t gpio;
+    soft_uart_t uart;
+    setup(&gpio, &uart);
+    wire(PIN_TX0, PIN_RX0);
+    int p = soft_uart_add(&uart, PIN_TX0, PIN_RX0, 9600);
+    TEST_ASSERT_EQUAL_INT(0, soft_uart_set_format(&uart, p, 7, SOFT_UART_PARITY_EVEN, 2));
+
+    const uint8_t msg[] = "AT+GMR\r\n";
+    uint8_t in[16];
+    soft_uart_write(&uart, p, msg, sizeof(msg) - 1);
+    run_until(&uart, frame_ns(9600, 11, sizeof(msg)));
+
+    TEST_ASSERT_EQUAL_INT(sizeof(msg) - 1, soft_uart_read(&uart, p, in, sizeof(in)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(in, msg, sizeof(msg) - 1));
+    soft_uart_stats_t st;
+    soft_uart_get_stats(&uart, p, &st);
+    TEST_ASSERT_EQUAL_UINT64(0, st.parity_errors);
+    teardown(&gpio);
+}
+
+void test_edge_mode_loopback(void) {
+    gpio_ctx_t gpio;
+    soft_uart_t uart;
+    setup(&gpio, &uart);
+    wire(PIN_TX0, PIN_RX1);
+    int a = soft_uart_add(&uart, PIN_TX0, SOFT_UART_NO_PIN, 115200);
+    int b = soft_uart_add(&uart, SOFT_UART_NO_PIN, PIN_RX1, 115200);
+    TEST_ASSERT_EQUAL_INT(0, soft_uart_set_rx_edges(&uart, b, 1));
+    TEST_ASSERT_EQUAL_INT(0, uart.polled_rx);
+
+    uint8_t out[64], in[64];
+    for (int i = 0; i < 64; i++) out[i] = (uint8_t)(i * 37 + 1);
+    soft_uart_write(&uart, a, out, sizeof(out));
+    run_edges_until(&uart, frame_ns(115200, 10, 64) + 20000);
+
+    TEST_ASSERT_EQUAL_INT(64, soft_uart_read(&uart, b, in, sizeof(in)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(in, out, sizeof(out)));
+
+    /* Edge-fed ports need their own thread */
+    TEST_ASSERT_EQUAL_INT(-1, soft_uart_start(&uart, -1));
+    teardown(&gpio);
+}
+
+/* ============================================================================
+ * LINE ERRORS
+ * ============================================================================ */
+
+void test_framing_error_and_break(void) {
+    gpio_ctx_t gpio;
+    soft_uart_t uart;
+    setup(&gpio, &uart);
+    gpio_ctx_sim_set_input(&gpio, PIN_IN, HIGH);
+    int p = soft_uart_add(&uart, SOFT_UART_NO_PIN, PIN_IN, 9600);
+    run_until(&uart, 200000);
+
+    /* 0x3C with a low stop bit, then a 30-bit break */
+    drive_bits(&uart, (uint32_t)0x3C << 1, 10, 9600);
+    run_until(&uart, wiring.now_ns + 200000);
+    drive_bits(&uart, 0, 30, 9600);
+    run_until(&uart, wiring.now_ns + 200000);
+    drive_bits(&uart, 0x200 | (0x7E << 1), 10, 9600);
+    run_until(&uart, wiring.now_ns + 200000);
+
+    soft_uart_stats_t st;
+    soft_uart_get_stats(&uart, p, &st);
+    TEST_ASSERT_EQUAL_UINT64(2, st.framing_errors);
+    TEST_ASSERT_EQUAL_UINT64(1, st.rx_bytes);
+    uint8_t in[4];
+    TEST_ASSERT_EQUAL_INT(1, soft_uart_read(&uart, p, in, sizeof(in)));
+    TEST_ASSERT_EQUAL_INT(0x7E, in[0]);
+    teardown(&gpio);
+}
+
+void test_parity_error_and_false_start(void) {
+    gpio_ctx_t gpio;
+    soft_uart_t uart;
+    setup(&gpio, &uart);
+    gpio_ctx_sim_set_input(&gpio, PIN_IN, HIGH);
+    int p = soft_uart_add(&uart, SOFT_UART_NO_PIN, PIN_IN, 9600);
+    soft_uart_set_format(&uart, p, 8, SOFT_UART_PARITY_ODD, 1);
+    run_until(&uart, 200000);
+
+    /* 0x01 needs an odd parity bit of 0; send 1 */
+    drive_bits(&uart, 0x600 | (0x01 << 1), 11, 9600);
+    /* A 20 us glitch is gone by the centre of the start bit */
+    gpio_ctx_sim_set_input(&gpio, PIN_IN, LOW);
+    run_until(&uart, wiring.now_ns + 20000);
+    gpio_ctx_sim_set_input(&gpio, PIN_IN, HIGH);
+    run_until(&uart, wiring.now_ns + 200000);
+
+    soft_uart_stats_t st;
+    soft_uart_get_stats(&uart, p, &st);
+    TEST_ASSERT_EQUAL_UINT64(1, st.parity_errors);
+    TEST_ASSERT_EQUAL_UINT64(1, st.false_starts);
+    TEST_ASSERT_EQUAL_UINT64(0, st.rx_bytes);
+    TEST_ASSERT_EQUAL_INT(0, soft_uart_available(&uart, p));
+    teardown(&gpio);
+}
+
+void test_rx_overrun(void) {
+    gpio_ctx_t gpio;
+    soft_uart_t uart;
+    setup(&gpio, &uart);
+    wire(PIN_TX0, PIN_RX0);
+    int p = soft_uart_add(&uart, PIN_TX0, PIN_RX0, 250000);
+
+    static uint8_t out[SOFT_UART_BUF + 10];
+    for (size_t i = 0; i < sizeof(out); i++) out[i] = (uint8_t)i;
+    TEST_ASSERT_EQUAL_INT(SOFT_UART_BUF, soft_uart_write(&uart, p, out, sizeof(out)));
+    run_until(&uart, frame_ns(250000, 10, SOFT_UART_BUF / 2) + 10000);
+    soft_uart_write(&uart, p, out + SOFT_UART_BUF, 10);
+    run_until(&uart, frame_ns(250000, 10, SOFT_UART_BUF + 10) + 20000);
+
+    soft_uart_stats_t st;
+    soft_uart_get_stats(&uart, p, &st);
+    TEST_ASSERT_EQUAL_UINT64(SOFT_UART_BUF + 10, st.tx_bytes);
+    TEST_ASSERT_EQUAL_UINT64(SOFT_UART_BUF, st.rx_bytes);
+    TEST_ASSERT_EQUAL_UINT64(10, st.overruns);
+    teardown(&gpio);
+}
+
+/* ============================================================================
+ * SERVICE THREAD
+ * ============================================================================ */
+
+void test_two_ports_at_different_rates(void) {
+    gpio_ctx_t gpio;
+    soft_uart_t uart;
+    setup(&gpio, &uart);
+    wire(PIN_TX0, PIN_RX0);
+    wire(PIN_TX1, PIN_RX1);
+    int a = soft_uart_add(&uart, PIN_TX0, PIN_RX0, 2400);
+    int b = soft_uart_add(&uart, PIN_TX1, PIN_RX1, 1200);
+
+    soft_uart_write(&uart, a, (const uint8_t*)"ping", 4);
+    soft_uart_write(&uart, b, (const uint8_t*)"pong", 4);
+    run_until(&uart, frame_ns(1200, 10, 4) + 1000000);
+
+    uint8_t in[8];
+    TEST_ASSERT_EQUAL_INT(4, soft_uart_read(&uart, a, in, sizeof(in)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(in, "ping", 4));
+    TEST_ASSERT_EQUAL_INT(4, soft_uart_read(&uart, b, in, sizeof(in)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(in, "pong", 4));
+
+    /* One pass per STEP_NS: nothing waits longer than a step */
+    soft_uart_stats_t sa, sb;
+    soft_uart_get_stats(&uart, a, &sa);
+    soft_uart_get_stats(&uart, b, &sb);
+    TEST_ASSERT_LESS_THAN(STEP_NS, sa.max_late_ns);
+    TEST_ASSERT_LESS_THAN(STEP_NS, sb.max_late_ns);
+    teardown(&gpio);
+}
+
+void test_thread_serves_two_ports(void) {
+    gpio_ctx_t gpio;
+    soft_uart_t uart;
+    setup(&gpio, &uart);
+    wire(PIN_TX0, PIN_RX0);
+    wire(PIN_TX1, PIN_RX1);
+    int a = soft_uart_add(&uart, PIN_TX0, PIN_RX0, 2400);
+    int b = soft_uart_add(&uart, PIN_TX1, PIN_RX1, 1200);
+
+    soft_uart_write(&uart, a, (const uint8_t*)"ping", 4);
+    soft_uart_write(&uart, b, (const uint8_t*)"pong", 4);
+    TEST_ASSERT_EQUAL_INT(0, soft_uart_start(&uart, get_cpu_count() - 1));
+    TEST_ASSERT_EQUAL_INT(-1, soft_uart_add(&uart, PIN_IN, SOFT_UART_NO_PIN, 9600));
+    for (int i = 0; i < 2000 && !(soft_uart_tx_idle(&uart, a) && soft_uart_tx_idle(&uart, b)); i++) {
+        usleep(1000);
+    }
+    soft_uart_stop(&uart);
+
+    soft_uart_stats_t sa, sb;
+    soft_uart_get_stats(&uart, a, &sa);
+    soft_uart_get_stats(&uart, b, &sb);
+    TEST_ASSERT_GREATER_THAN(0, sb.busy_ns);
+    TEST_ASSERT_GREATER_THAN(0, uart.thread_ns);
+
+    /* Wall-time deadlines only hold under SCHED_FIFO; without it a busy
+     * neighbour can delay the thread by whole bits */
+    if (uart.realtime) {
+        TEST_ASSERT_LESS_THAN(1000000000ull / 2400 / 4, sa.max_late_ns);  /* Within a quarter bit */
+        TEST_ASSERT_LESS_THAN(1000000000ull / 1200 / 4, sb.max_late_ns);
+    }
+    teardown(&gpio);
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Frames and timing
+    RUN_TEST(test_frame_table);
+    RUN_TEST(test_tx_bits_on_absolute_deadlines);
+
+    // Loopback
+    RUN_TEST(test_full_duplex_loopback_all_bytes);
+    RUN_TEST(test_loopback_seven_bits_even_parity);
+    RUN_TEST(test_edge_mode_loopback);
+
+    // Line errors
+    RUN_TEST(test_framing_error_and_break);
+    RUN_TEST(test_parity_error_and_false_start);
+    RUN_TEST(test_rx_overrun);
+
+    // Service thread
+    RUN_TEST(test_two_ports_at_different_rates);
+    RUN_TEST(test_thread_serves_two_ports);
+
+    return UNITY_END();
+}
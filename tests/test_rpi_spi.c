@@ -0,0 +1,320 @@
+/*
+ * test_rpi_spi.c - Validation tests for rpi_spi.h
+ *
+ * The driver runs against the simulated SPI0 block in virtual time, polled
+ * on its own and through the DMA simulator for queued transfers. A slave
+ * callback answers each byte.
+ * Focus: divider rounding, polled FIFO handling, bus timing, DMA queue
+ * layout and back-to-back runs, path selection by length.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_SPI_IMPLEMENTATION
+#include "rpi_spi.h"
+
+#define TX_CHANNEL 4
+#define RX_CHANNEL 5
+#define LOG_CAP    8192
+
+static spi_sim_t sim;
+static dma_sim_t dma_sim;
+static spi_sim_byte_t bus_log[LOG_CAP];
+
+/* Slave answer: complement of the byte XOR the chip select */
+static int invert(uint8_t mosi, int cs) {
+    return (mosi ^ 0xFF ^ cs) & 0xFF;
+}
+
+static uint8_t slave_invert(void* user, int cs, uint8_t mosi) {
+    (void)user;
+    return (uint8_t)invert(mosi, cs);
+}
+
+/* Slave: records the mode bits seen on the bus */
+static uint8_t slave_mode(void* user, int cs, uint8_t mosi) {
+    uint32_t* seen = (uint32_t*)user;
+    (void)cs;
+    *seen = sim.regs[SPI_CS] & (SPI_CS_CPOL | SPI_CS_CPHA);
+    return mosi;
+}
+
+static void fill(uint8_t* buf, size_t len, int seed) {
+    for (size_t i = 0; i < len; i++) buf[i] = (uint8_t)(i * 31 + seed);
+}
+
+static void setup_polled(spi_ctx_t* ctx, uint8_t (*slave)(void*, int, uint8_t), void* user) {
+    spi_sim_init(&sim, slave, user, bus_log, LOG_CAP);
+    TEST_ASSERT_EQUAL_INT(0, spi_sim_attach(&sim, ctx, NULL));
+}
+
+static void setup_dma(spi_ctx_t* ctx, spi_queue_t* q, dma_chan_t* tx, dma_chan_t* rx,
+                      int entries, size_t bytes) {
+    spi_sim_init(&sim, slave_invert, NULL, bus_log, LOG_CAP);
+    dma_sim_init(&dma_sim);
+    TEST_ASSERT_EQUAL_INT(0, spi_sim_attach(&sim, ctx, &dma_sim));
+    TEST_ASSERT_EQUAL_INT(0, dma_chan_attach(tx, dma_sim.regs, TX_CHANNEL));
+    TEST_ASSERT_EQUAL_INT(0, dma_chan_attach(rx, dma_sim.regs, RX_CHANNEL));
+    TEST_ASSERT_EQUAL_INT(0, spi_queue_open(q, ctx, tx, rx, entries, bytes));
+}
+
+/* ============================================================================
+ * CONFIGURATION TESTS
+ * ============================================================================ */
+
+void test_clock_divider_rounding(void) {
+    static uint32_t regs[PERIPH_BLOCK_SIZE / 4];
+    spi_ctx_t ctx;
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_attach(&ctx, regs, NULL));
+
+    TEST_ASSERT_EQUAL_INT(10000000, spi_ctx_set_clock(&ctx, 10000000));
+    TEST_ASSERT_EQUAL_INT(50, regs[SPI_CLK]);
+
+    /* 166.7 rounds up to the next even divider: never faster than asked */
+    uint32_t hz = spi_ctx_set_clock(&ctx, 3000000);
+    TEST_ASSERT_EQUAL_INT(168, regs[SPI_CLK]);
+    TEST_ASSERT_LESS_OR_EQUAL(3000000, hz);
+
+    TEST_ASSERT_EQUAL_INT(SPI_CORE_HZ / 2, spi_ctx_set_clock(&ctx, 400000000));
+    TEST_ASSERT_EQUAL_INT(2, regs[SPI_CLK]);
+
+    /* Slowest divider 65536 is written as 0 */
+    spi_ctx_set_clock(&ctx, 1);
+    TEST_ASSERT_EQUAL_INT(0, regs[SPI_CLK]);
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_set_clock(&ctx, 0));
+
+    TEST_ASSERT_EQUAL_INT(-1, spi_ctx_set_mode(&ctx, 4));
+    TEST_ASSERT_EQUAL_INT(-1, spi_ctx_transfer(&ctx, 3, NULL, NULL, 1));
+}
+
+void test_init_unavailable_on_host(void) {
+    spi_ctx_t ctx;
+    TEST_ASSERT_EQUAL_INT(-1, spi_ctx_init(&ctx, NULL));
+}
+
+/* ============================================================================
+ * POLLED TESTS
+ * ============================================================================ */
+
+void test_polled_transfer(void) {
+    spi_ctx_t ctx;
+    setup_polled(&ctx, slave_invert, NULL);
+    spi_ctx_set_clock(&ctx, 25000000);
+
+    uint8_t tx[300], rx[300];
+    fill(tx, sizeof(tx), 7);
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_transfer(&ctx, 1, tx, rx, sizeof(tx)));
+
+    for (size_t i = 0; i < sizeof(tx); i++) {
+        TEST_ASSERT_EQUAL_INT(invert(tx[i], 1), rx[i]);
+        TEST_ASSERT_EQUAL_INT(1, bus_log[i].cs);
+        TEST_ASSERT_EQUAL_INT(tx[i], bus_log[i].mosi);
+    }
+    TEST_ASSERT_EQUAL_UINT64(300, sim.bytes);
+    TEST_ASSERT_EQUAL_UINT64(0, sim.overflows);
+    TEST_ASSERT_EQUAL_UINT64(1, ctx.transfers);
+    TEST_ASSERT_EQUAL_UINT64(0, ctx.dma_transfers);
+
+    /* TA is dropped afterwards and the FIFOs are empty */
+    TEST_ASSERT_FALSE(sim.regs[SPI_CS] & SPI_CS_TA);
+    TEST_ASSERT_EQUAL_INT(0, sim.rx_count);
+
+    /* No TX buffer clocks out the fill byte; no RX buffer is fine */
+    sim.log_len = 0;
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_transfer(&ctx, 0, NULL, NULL, 10));
+    TEST_ASSERT_EQUAL_INT(10, sim.log_len);
+    TEST_ASSERT_EQUAL_INT(SPI_FILL, bus_log[9].mosi);
+}
+
+void test_polled_bytes_back_to_back(void) {
+    spi_ctx_t ctx;
+    setup_polled(&ctx, NULL, NULL);
+    spi_ctx_set_clock(&ctx, 1000000);
+
+    uint8_t tx[200], rx[200];
+    fill(tx, sizeof(tx), 3);
+    uint64_t t0 = sim.now_ns;
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_transfer(&ctx, 0, tx, rx, sizeof(tx)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(tx, rx, sizeof(tx)));
+
+    /* The FIFO never runs dry at 1 MHz: one byte every 8 us, no gaps */
+    for (size_t i = 1; i < sizeof(tx); i++) {
+        TEST_ASSERT_WITHIN(1, 8000, (int)(bus_log[i].t_ns - bus_log[i - 1].t_ns));
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(200 * 8000, (int)(sim.now_ns - t0));
+    TEST_ASSERT_LESS_THAN(200 * 8000 + 20000, (int)(sim.now_ns - t0));
+}
+
+void test_polled_mode_bits(void) {
+    spi_ctx_t ctx;
+    uint32_t seen = 0;
+    setup_polled(&ctx, slave_mode, &seen);
+
+    uint8_t b = 0x5A;
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_set_mode(&ctx, 3));
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_transfer(&ctx, 0, &b, NULL, 1));
+    TEST_ASSERT_EQUAL_INT(SPI_CS_CPOL | SPI_CS_CPHA, seen);
+
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_set_mode(&ctx, 1));
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_transfer(&ctx, 0, &b, NULL, 1));
+    TEST_ASSERT_EQUAL_INT(SPI_CS_CPHA, seen);
+}
+
+/* ============================================================================
+ * DMA TESTS
+ * ============================================================================ */
+
+void test_queue_layout(void) {
+    spi_ctx_t ctx;
+    spi_queue_t q;
+    dma_chan_t tx, rx;
+    setup_dma(&ctx, &q, &tx, &rx, 2, 64);
+
+    TEST_ASSERT_EQUAL_INT(-1, spi_queue_start(&q));
+    TEST_ASSERT_EQUAL_INT(-1, spi_queue_add(&q, 0, NULL, 0));
+    TEST_ASSERT_EQUAL_INT(-1, spi_queue_add(&q, 3, NULL, 4));
+    TEST_ASSERT_EQUAL_INT(0, spi_queue_add(&q, 0, NULL, 5));
+
+    /* TX writes FIFO words paced by DREQ 6, RX reads them paced by DREQ 7 */
+    const spi_queue_entry_t* e = &q.entries[0];
+    TEST_ASSERT_EQUAL_INT(8, e->tx_cb->txfr_len);
+    TEST_ASSERT_EQUAL_INT(8, e->rx_cb->txfr_len);
+    TEST_ASSERT_EQUAL_INT(dma_periph_bus(PERIPH_SPI0, SPI_FIFO), e->tx_cb->dest_ad);
+    TEST_ASSERT_EQUAL_INT(dma_periph_bus(PERIPH_SPI0, SPI_FIFO), e->rx_cb->source_ad);
+    TEST_ASSERT_TRUE(e->tx_cb->ti & DMA_TI_DEST_DREQ);
+    TEST_ASSERT_EQUAL_INT(DMA_DREQ_SPI_TX, (e->tx_cb->ti >> 16) & 0x1F);
+    TEST_ASSERT_TRUE(e->rx_cb->ti & DMA_TI_SRC_DREQ);
+    TEST_ASSERT_EQUAL_INT(DMA_DREQ_SPI_RX, (e->rx_cb->ti >> 16) & 0x1F);
+    TEST_ASSERT_EQUAL_INT(0, e->tx_cb->nextconbk);
+    TEST_ASSERT_NULL(spi_queue_rx(&q, 0, NULL));
+
+    /* Buffer space and entry count are both limits */
+    TEST_ASSERT_EQUAL_INT(-1, spi_queue_add(&q, 0, NULL, 200));
+    TEST_ASSERT_EQUAL_INT(1, spi_queue_add(&q, 0, NULL, 8));
+    TEST_ASSERT_EQUAL_INT(-1, spi_queue_add(&q, 0, NULL, 1));
+
+    spi_queue_close(&q);
+}
+
+void test_queue_back_to_back(void) {
+    spi_ctx_t ctx;
+    spi_queue_t q;
+    dma_chan_t tx, rx;
+    setup_dma(&ctx, &q, &tx, &rx, 8, 4096);
+    spi_ctx_set_clock(&ctx, 31250000);
+
+    static const size_t lens[] = { 5, 256, 1001, 64 };
+    uint8_t data[4][1001];
+    for (int i = 0; i < 4; i++) {
+        fill(data[i], lens[i], 11 * i + 1);
+        TEST_ASSERT_EQUAL_INT(i, spi_queue_add(&q, i & 1, data[i], lens[i]));
+    }
+    TEST_ASSERT_EQUAL_INT(0, spi_queue_start(&q));
+    TEST_ASSERT_EQUAL_INT(-1, spi_queue_add(&q, 0, NULL, 4));
+    TEST_ASSERT_EQUAL_INT(0, spi_queue_wait(&q));
+
+    size_t total = 0;
+    for (int i = 0; i < 4; i++) {
+        size_t len = 0;
+        const uint8_t* in = spi_queue_rx(&q, i, &len);
+        TEST_ASSERT_NOT_NULL(in);
+        TEST_ASSERT_EQUAL_INT((int)lens[i], (int)len);
+        for (size_t k = 0; k < len; k++) {
+            TEST_ASSERT_EQUAL_INT(invert(data[i][k], i & 1), in[k]);
+            TEST_ASSERT_EQUAL_INT(i & 1, bus_log[total + k].cs);
+        }
+        total += len;
+    }
+
+    /* Exactly the payload went out: word padding is never shifted */
+    TEST_ASSERT_EQUAL_UINT64(total, sim.bytes);
+    TEST_ASSERT_EQUAL_UINT64(4, sim.transfers);
+    TEST_ASSERT_EQUAL_UINT64(0, sim.overflows);
+    TEST_ASSERT_EQUAL_UINT64(0, dma_sim.errors);
+    TEST_ASSERT_EQUAL_UINT64(4, q.completed);
+
+    /* Within a transfer bytes are contiguous; between them only the restart */
+    double byte_ns = 8e9 * 16 / SPI_CORE_HZ;
+    size_t first = 0;
+    for (int i = 0; i < 4; i++) {
+        for (size_t k = first + 1; k < first + lens[i]; k++) {
+            TEST_ASSERT_WITHIN(1, (int)byte_ns, (int)(bus_log[k].t_ns - bus_log[k - 1].t_ns));
+        }
+        if (i > 0) TEST_ASSERT_LESS_THAN(2000, (int)(bus_log[first].t_ns - bus_log[first - 1].t_ns));
+        first += lens[i];
+    }
+
+    /* The queue can be rerun as is */
+    sim.log_len = 0;
+    TEST_ASSERT_EQUAL_INT(0, spi_queue_start(&q));
+    TEST_ASSERT_EQUAL_INT(0, spi_queue_wait(&q));
+    TEST_ASSERT_EQUAL_INT((int)total, (int)sim.log_len);
+
+    spi_queue_close(&q);
+}
+
+void test_transfer_picks_path_by_length(void) {
+    spi_ctx_t ctx;
+    spi_queue_t q;
+    dma_chan_t tx, rx;
+    setup_dma(&ctx, &q, &tx, &rx, 4, 2048);
+    spi_ctx_set_clock(&ctx, 50000000);
+    spi_ctx_set_dma(&ctx, &q, 64);
+
+    static uint8_t out[4096], in[4096];
+    fill(out, sizeof(out), 5);
+
+    /* Short: polled, one FIFO write and read per byte */
+    uint64_t accesses = sim.accesses;
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_transfer(&ctx, 0, out, in, 16));
+    TEST_ASSERT_EQUAL_UINT64(0, ctx.dma_transfers);
+    TEST_ASSERT_GREATER_OR_EQUAL(32, (int)(sim.accesses - accesses));
+
+    /* Long: DMA, a handful of register accesses regardless of length */
+    accesses = sim.accesses;
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_transfer(&ctx, 1, out, in, 2000));
+    TEST_ASSERT_EQUAL_UINT64(1, ctx.dma_transfers);
+    TEST_ASSERT_LESS_THAN(16, (int)(sim.accesses - accesses));
+    for (int i = 0; i < 2000; i++) TEST_ASSERT_EQUAL_INT(invert(out[i], 1), in[i]);
+    TEST_ASSERT_EQUAL_INT(0, q.count);
+
+    /* Too big for the queue buffer: falls back to polling */
+    TEST_ASSERT_EQUAL_INT(0, spi_ctx_transfer(&ctx, 0, out, in, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT64(1, ctx.dma_transfers);
+    for (size_t i = 0; i < sizeof(out); i++) TEST_ASSERT_EQUAL_INT(invert(out[i], 0), in[i]);
+    TEST_ASSERT_EQUAL_UINT64(3, ctx.transfers);
+    TEST_ASSERT_EQUAL_UINT64(16 + 2000 + sizeof(out), ctx.bytes);
+
+    spi_queue_close(&q);
+    TEST_ASSERT_NULL(ctx.dma);
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Configuration
+    RUN_TEST(test_clock_divider_rounding);
+    RUN_TEST(test_init_unavailable_on_host);
+
+    // Polled
+    RUN_TEST(test_polled_transfer);
+    RUN_TEST(test_polled_bytes_back_to_back);
+    RUN_TEST(test_polled_mode_bits);
+
+    // DMA
+    RUN_TEST(test_queue_layout);
+    RUN_TEST(test_queue_back_to_back);
+    RUN_TEST(test_transfer_picks_path_by_length);
+
+    return UNITY_END();
+}
@@ -23,13 +23,26 @@ from rpi_toolkit import (
     # GPIO functions
     gpio_init, gpio_cleanup, pin_mode, gpio_set_function,
     digital_write, digital_read,
+    # GPIO backend functions
+    GPIO_BACKEND_AUTO, GPIO_BACKEND_SIM, GPIO_BACKEND_NULL,
+    gpio_init_backend, gpio_get_backend, gpio_backend_name, gpio_write_mask,
     # Timer functions
     timer_set, timer_expired, timer_tick,
     millis, micros, delay_ms, delay_us,
     # Software PWM functions
     pwm_init, pwm_init_freq, pwm_write, pwm_stop,
     # Hardware PWM functions
-    hpwm_init, hpwm_set, hpwm_stop,
+    hpwm_init, hpwm_set, hpwm_set_duty, hpwm_stop,
+    # GPIO event functions
+    GpioEvent, GPIO_EDGE_RISING, GPIO_EDGE_FALLING, GPIO_EDGE_BOTH,
+    gpio_read_all, gpio_set_edge_detect, gpio_edge_status,
+    gpio_event_start, gpio_event_stop, gpio_event_poll,
+    gpio_event_read, gpio_event_wait, gpio_event_dropped,
+    # ADC sampling functions
+    AdcSample, ADC_MCP3008, ADC_MCP3208,
+    adc_open, adc_open_sim, adc_close, adc_set_channels,
+    adc_start, adc_stop, adc_poll, adc_available,
+    adc_peek, adc_release, adc_read, adc_wait, adc_stats, adc_scan_rate,
 )
 
 
@@ -148,6 +161,27 @@ class TestGPIOWrapper:
             pin_mode(pin, INPUT)
             assert digital_read(pin) == LOW
         gpio_cleanup()
+    
+    def test_backend_constants(self):
+        assert GPIO_BACKEND_AUTO == 0
+        assert GPIO_BACKEND_NULL == 4
+    
+    def test_init_backend_sim(self):
+        assert gpio_init_backend(GPIO_BACKEND_SIM) == 0
+        assert gpio_get_backend() == GPIO_BACKEND_SIM
+        assert gpio_backend_name() == "sim"
+        gpio_cleanup()
+    
+    def test_write_mask_in_simulator(self):
+        gpio_init_backend(GPIO_BACKEND_SIM)
+        pin_mode(20, OUTPUT)
+        pin_mode(21, OUTPUT)
+        gpio_write_mask((1 << 20) | (1 << 21))
+        assert digital_read(20) == HIGH
+        assert digital_read(21) == HIGH
+        gpio_write_mask(0, 1 << 21)
+        assert digital_read(21) == LOW
+        gpio_cleanup()
 
 
 # ============================================================================
@@ -423,6 +457,16 @@ class TestHWPWMWrapper:
         hpwm_stop()
         gpio_cleanup()
     
+    def test_hpwm_set_duty_only(self):
+        gpio_init()
+        hpwm_init()
+        hpwm_set(18, 1000, 500)
+        for duty in [0, 250, 1000, 1500]:
+            assert hpwm_set_duty(18, duty) == 0
+        assert hpwm_set_duty(17, 500) == -1
+        hpwm_stop()
+        gpio_cleanup()
+    
     def test_hpwm_set_duty_clamping(self):
         gpio_init()
         hpwm_init()
@@ -456,6 +500,116 @@ class TestHWPWMWrapper:
         gpio_cleanup()
 
 
+# ============================================================================
+# GPIO EVENT WRAPPER TESTS
+# ============================================================================
+
+class TestGPIOEventWrapper:
+    """Test edge detection and event ring wrapper functions."""
+    
+    def test_event_struct_layout(self):
+        assert ctypes.sizeof(GpioEvent) == 16
+    
+    def test_edge_flag_values(self):
+        assert GPIO_EDGE_RISING == 1
+        assert GPIO_EDGE_FALLING == 2
+        assert GPIO_EDGE_BOTH == 3
+    
+    def test_read_all_returns_int(self):
+        gpio_init()
+        assert gpio_read_all() == 0
+        gpio_cleanup()
+    
+    def test_edge_status_in_emulation(self):
+        gpio_init()
+        gpio_set_edge_detect(17, GPIO_EDGE_BOTH)
+        assert gpio_edge_status() == 0
+        gpio_cleanup()
+    
+    def test_event_read_empty(self):
+        assert gpio_event_read() == []
+        assert gpio_event_poll() == 0
+    
+    def test_event_start_stop(self):
+        gpio_init()
+        assert gpio_event_start([17, 27], GPIO_EDGE_BOTH) == 0
+        assert gpio_event_wait(1000) == []
+        gpio_event_stop()
+        assert gpio_event_dropped() == 0
+        gpio_cleanup()
+    
+    def test_event_stop_without_start(self):
+        gpio_event_stop()  # Should not raise
+
+
+# ============================================================================
+# ADC SAMPLING WRAPPER TESTS
+# ============================================================================
+
+def _ramp(channel, n, bits=10):
+    """Simulated converter input (adc_sim_ramp())."""
+    return (n + 64 * channel) & ((1 << bits) - 1)
+
+class TestADCWrapper:
+    """Test the SPI ADC sampling pipeline on the simulated converter."""
+
+    def teardown_method(self, method):
+        adc_close()
+
+    def test_sample_struct_layout(self):
+        assert ctypes.sizeof(AdcSample) == 16
+
+    def test_open_hardware_fails_in_emulation(self):
+        assert adc_open(ADC_MCP3008) == -1
+
+    def test_poll_and_read(self):
+        assert adc_open_sim(ADC_MCP3008, 64) == 0
+        assert adc_set_channels([3, 1]) == 0
+        assert adc_poll(5) == 10
+        samples = adc_read()
+        assert [s.channel for s in samples] == [3, 1] * 5
+        assert [s.value for s in samples] == [_ramp(c, n) for n in range(5) for c in (3, 1)]
+        assert adc_available() == 0
+
+    def test_peek_is_zero_copy(self):
+        assert adc_open_sim(ADC_MCP3208, 64) == 0
+        assert adc_set_channels([0, 7]) == 0
+        assert len(adc_peek()) == 0
+        adc_poll(4)
+        run = adc_peek()
+        assert len(run) == 8
+        view = memoryview(run)
+        assert view.nbytes == 8 * 16
+        assert run[3].value == _ramp(7, 1, 12)
+        adc_poll(1)  # Writes behind the run, never into it
+        assert run[3].value == _ramp(7, 1, 12)
+        adc_release(len(run))
+        assert adc_available() == 2
+
+    def test_overruns_reported(self):
+        assert adc_open_sim(ADC_MCP3008, 8) == 0
+        assert adc_poll(10) == 8
+        stats = adc_stats()
+        assert stats.scans == 8
+        assert stats.overruns == 2
+
+    def test_invalid_channels(self):
+        assert adc_open_sim(ADC_MCP3008) == 0
+        assert adc_set_channels([8]) == -1
+        assert adc_set_channels([]) == -1
+
+    def test_sampler_thread(self):
+        assert adc_open_sim(ADC_MCP3008, 4096) == 0
+        assert adc_start(1000.0) == 0
+        assert adc_wait(20, 1000000) >= 20
+        adc_stop()
+        stats = adc_stats()
+        assert stats.samples == adc_available()
+        assert adc_scan_rate() > 0
+        values = [s.value for s in adc_read(4096)]
+        assert values == [_ramp(0, n) for n in range(len(values))]
+
+
 # ============================================================================
 # TYPE CONVERSION TESTS
 # ============================================================================
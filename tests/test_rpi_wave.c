@@ -0,0 +1,293 @@
+/*
+ * test_rpi_wave.c - Validation tests for rpi_wave.h
+ *
+ * These tests compile waveforms and play them on the host DMA simulator.
+ * Focus: control block layout, PWM and PCM pacing in virtual time, edge
+ * placement, looping, and mirroring into a simulated GPIO context.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_HW_PWM_IMPLEMENTATION
+#include "rpi_hw_pwm.h"
+
+#define RPI_WAVE_IMPLEMENTATION
+#include "rpi_wave.h"
+
+/* Edges may trail their tick by a few DMA bus cycles (block fetch + write) */
+#define EDGE_TOLERANCE_NS 200
+
+#define PIN_A (1ull << 17)
+#define PIN_B (1ull << 27)
+#define PIN_C (1ull << 40)
+
+static wave_sim_t sim;
+static wave_edge_t edges[256];
+
+static void setup(wave_engine_t* eng, dma_chan_t* dma, wave_pacer_t pacer, uint32_t tick_ns) {
+    wave_sim_init(&sim, edges, 256);
+    TEST_ASSERT_EQUAL_INT(0, wave_sim_engine(&sim, eng, pacer, tick_ns, dma));
+}
+
+/* ============================================================================
+ * COMPILER TESTS
+ * ============================================================================ */
+
+void test_compile_block_layout(void) {
+    wave_engine_t eng;
+    dma_chan_t dma;
+    wave_t w;
+    setup(&eng, &dma, WAVE_PACE_PWM, 1000);
+
+    const wave_step_t steps[] = {
+        { PIN_A, 0, 10 },            /* set + delay */
+        { PIN_B, PIN_A, 5 },         /* set + clr + delay */
+        { 0, PIN_B, 0 },             /* clr only */
+        { 0, 0, 20000 },             /* delay split in two */
+    };
+    TEST_ASSERT_EQUAL_INT(0, wave_compile(&w, &eng, steps, 4));
+    TEST_ASSERT_EQUAL_INT(1 + 2 + 3 + 1 + 2, w.num_cbs);
+    TEST_ASSERT_EQUAL_INT(1, w.first_step);
+    TEST_ASSERT_EQUAL_UINT64(10 + 5 + 20000, w.ticks);
+    TEST_ASSERT_WITHIN(1, 20015000, (long long)w.duration_ns);
+
+    /* Priming block fills the FIFO past its level */
+    TEST_ASSERT_EQUAL_UINT64(WAVE_PRIME_WORDS * 4, w.cbs[0].txfr_len);
+    TEST_ASSERT_EQUAL_UINT64(dma_periph_bus(PERIPH_PWM, PWM_FIF1), w.cbs[0].dest_ad);
+    TEST_ASSERT_TRUE(w.cbs[0].ti & DMA_TI_DEST_DREQ);
+
+    /* GPSET0/1 from two mask words */
+    TEST_ASSERT_EQUAL_UINT64(dma_periph_bus(PERIPH_GPIO, GPSET0), w.cbs[1].dest_ad);
+    TEST_ASSERT_EQUAL_UINT64(8, w.cbs[1].txfr_len);
+    uint32_t* mask = (uint32_t*)dma_mem_virt(w.cbs[1].source_ad);
+    TEST_ASSERT_EQUAL_UINT64((uint32_t)PIN_A, mask[0]);
+    TEST_ASSERT_EQUAL_UINT64(0, mask[1]);
+    TEST_ASSERT_EQUAL_UINT64(dma_periph_bus(PERIPH_GPIO, GPCLR0), w.cbs[4].dest_ad);
+
+    /* 20000 ticks: one full block plus the rest */
+    TEST_ASSERT_EQUAL_UINT64(WAVE_DELAY_MAX_TICKS * 4, w.cbs[7].txfr_len);
+    TEST_ASSERT_EQUAL_UINT64((20000 - WAVE_DELAY_MAX_TICKS) * 4, w.cbs[8].txfr_len);
+    TEST_ASSERT_EQUAL_UINT64(0, w.cbs[8].nextconbk);
+
+    wave_free(&w);
+    wave_engine_close(&eng);
+}
+
+void test_compile_rejects_invalid(void) {
+    wave_engine_t eng;
+    dma_chan_t dma;
+    wave_t w;
+    setup(&eng, &dma, WAVE_PACE_PWM, 1000);
+
+    const wave_step_t bad_pin[] = { { 1ull << 54, 0, 1 } };
+    const wave_step_t ok[] = { { PIN_A, 0, 1 } };
+    TEST_ASSERT_EQUAL_INT(-1, wave_compile(&w, &eng, bad_pin, 1));
+    TEST_ASSERT_EQUAL_INT(-1, wave_compile(&w, &eng, ok, 0));
+    TEST_ASSERT_EQUAL_INT(-1, wave_compile(&w, &eng, NULL, 1));
+    TEST_ASSERT_EQUAL_INT(-1, wave_compile(NULL, &eng, ok, 1));
+    wave_engine_close(&eng);
+    TEST_ASSERT_EQUAL_INT(-1, wave_compile(&w, &eng, ok, 1));  /* Closed engine */
+}
+
+void test_engine_tick_planning(void) {
+    wave_engine_t eng;
+    dma_chan_t dma;
+
+    setup(&eng, &dma, WAVE_PACE_PWM, 0);
+    TEST_ASSERT_WITHIN(1, WAVE_TICK_NS_DEFAULT, (long long)eng.tick_ns);
+    TEST_ASSERT_EQUAL_UINT64(125, sim.pwm.pwm[PWM_RNG1]);  /* 125 MHz clock */
+    TEST_ASSERT_TRUE(sim.pwm.pwm[PWM_CTL] & PWM_CTL_USEF1);
+    TEST_ASSERT_FALSE(sim.pwm.pwm[PWM_CTL] & PWM_CTL_MSEN1);
+    wave_engine_close(&eng);
+    TEST_ASSERT_EQUAL_UINT64(0, sim.pwm.pwm[PWM_DMAC]);
+
+    setup(&eng, &dma, WAVE_PACE_PCM, 250);
+    TEST_ASSERT_WITHIN(1, 250, (long long)eng.tick_ns);
+    TEST_ASSERT_TRUE(sim.pcm[PCM_CS_A] & PCM_CS_TXON);
+    TEST_ASSERT_EQUAL_UINT64(0, sim.pwm.pwm[PWM_CTL]);  /* PWM left alone */
+    wave_engine_close(&eng);
+    TEST_ASSERT_EQUAL_UINT64(0, sim.pcm[PCM_CS_A]);
+
+    /* PCM frames are at most 1024 bit clocks: long ticks take a slower clock */
+    wave_sim_init(&sim, NULL, 0);
+    TEST_ASSERT_EQUAL_INT(0, wave_sim_engine(&sim, &eng, WAVE_PACE_PCM, 100000, &dma));
+    TEST_ASSERT_WITHIN(100, 100000, (long long)eng.tick_ns);
+    wave_engine_close(&eng);
+    TEST_ASSERT_EQUAL_INT(0, wave_sim_engine(&sim, &eng, WAVE_PACE_PWM, 100000, &dma));
+    wave_engine_close(&eng);
+}
+
+/* ============================================================================
+ * PLAYBACK TESTS
+ * ============================================================================ */
+
+static void play_square_wave(wave_pacer_t pacer) {
+    wave_engine_t eng;
+    dma_chan_t dma;
+    wave_t w;
+    setup(&eng, &dma, pacer, 1000);
+
+    const wave_step_t steps[] = {
+        { PIN_A | PIN_C, 0, 5 },
+        { PIN_B, PIN_A, 3 },
+        { 0, PIN_B | PIN_C, 2 },
+        { PIN_A, 0, 1 },
+    };
+    TEST_ASSERT_EQUAL_INT(0, wave_compile(&w, &eng, steps, 4));
+    TEST_ASSERT_EQUAL_INT(0, wave_play(&eng, &w, 0));
+    TEST_ASSERT_TRUE(wave_busy(&eng));
+    TEST_ASSERT_EQUAL_INT(-1, wave_play(&eng, &w, 0));
+
+    wave_sim_run(&sim, 50000);
+    TEST_ASSERT_FALSE(wave_busy(&eng));
+    TEST_ASSERT_EQUAL_UINT64(0, sim.dma.errors);
+
+    /* Bank 0 and bank 1 are separate bus writes, one cycle apart */
+    static const struct { uint64_t levels; long long t_ns; } expect[] = {
+        { PIN_A, 0 }, { PIN_A | PIN_C, 0 },            /* Step 0 */
+        { PIN_A | PIN_B | PIN_C, 5000 }, { PIN_B | PIN_C, 5000 },
+        { PIN_C, 8000 }, { 0, 8000 },
+        { PIN_A, 10000 },
+    };
+    TEST_ASSERT_EQUAL_UINT64(7, sim.log_len);
+    for (int i = 0; i < 7; i++) {
+        TEST_ASSERT_EQUAL_UINT64(expect[i].levels, edges[i].levels);
+        TEST_ASSERT_WITHIN(EDGE_TOLERANCE_NS, expect[i].t_ns, (long long)(edges[i].t_ns - edges[0].t_ns));
+    }
+    TEST_ASSERT_EQUAL_UINT64(PIN_A, ((uint64_t)sim.gpio[GPLEV1] << 32) | sim.gpio[GPLEV0]);
+
+    wave_free(&w);
+    wave_engine_close(&eng);
+}
+
+void test_play_pwm_paced(void) {
+    play_square_wave(WAVE_PACE_PWM);
+}
+
+void test_play_pcm_paced(void) {
+    play_square_wave(WAVE_PACE_PCM);
+}
+
+void test_sub_microsecond_ticks(void) {
+    wave_engine_t eng;
+    dma_chan_t dma;
+    wave_t w;
+    setup(&eng, &dma, WAVE_PACE_PWM, 500);
+
+    /* 1 us high / 1 us low, 20 periods: edges every 2 ticks */
+    wave_step_t steps[40];
+    for (int i = 0; i < 40; i++) {
+        steps[i].set_mask = i % 2 ? 0 : PIN_A;
+        steps[i].clr_mask = i % 2 ? PIN_A : 0;
+        steps[i].delay_us = 1;
+    }
+    TEST_ASSERT_EQUAL_INT(0, wave_compile(&w, &eng, steps, 40));
+    TEST_ASSERT_EQUAL_UINT64(80, w.ticks);
+    wave_play(&eng, &w, 0);
+    wave_sim_run(&sim, 100000);
+
+    TEST_ASSERT_EQUAL_UINT64(40, sim.log_len);
+    for (int i = 1; i < 40; i++) {
+        TEST_ASSERT_WITHIN(EDGE_TOLERANCE_NS, 1000, (long long)(edges[i].t_ns - edges[i - 1].t_ns));
+        TEST_ASSERT_WITHIN(EDGE_TOLERANCE_NS, (long long)i * 1000, (long long)(edges[i].t_ns - edges[0].t_ns));
+    }
+
+    wave_free(&w);
+    wave_engine_close(&eng);
+}
+
+void test_loop_until_stopped(void) {
+    wave_engine_t eng;
+    dma_chan_t dma;
+    wave_t w;
+    setup(&eng, &dma, WAVE_PACE_PWM, 1000);
+
+    const wave_step_t steps[] = { { PIN_B, 0, 4 }, { 0, PIN_B, 6 } };
+    TEST_ASSERT_EQUAL_INT(0, wave_compile(&w, &eng, steps, 2));
+    TEST_ASSERT_EQUAL_INT(0, wave_play(&eng, &w, 1));
+    wave_sim_run(&sim, 55000);
+
+    TEST_ASSERT_TRUE(wave_busy(&eng));
+    TEST_ASSERT_GREATER_OR_EQUAL(10, sim.log_len);
+    for (size_t i = 2; i < sim.log_len; i++) {
+        TEST_ASSERT_WITHIN(EDGE_TOLERANCE_NS, 10000, (long long)(edges[i].t_ns - edges[i - 2].t_ns));
+    }
+
+    wave_stop(&eng);
+    TEST_ASSERT_FALSE(wave_busy(&eng));
+    size_t len = sim.log_len;
+    wave_sim_run(&sim, 50000);
+    TEST_ASSERT_EQUAL_UINT64(len, sim.log_len);
+
+    /* Zero-length loops would never yield the bus */
+    const wave_step_t no_delay[] = { { PIN_B, 0, 0 } };
+    wave_t w2;
+    TEST_ASSERT_EQUAL_INT(0, wave_compile(&w2, &eng, no_delay, 1));
+    TEST_ASSERT_EQUAL_INT(-1, wave_play(&eng, &w2, 1));
+    TEST_ASSERT_EQUAL_INT(0, wave_play(&eng, &w2, 0));
+
+    wave_free(&w2);
+    wave_free(&w);
+    wave_engine_close(&eng);
+}
+
+void test_mirror_into_gpio_sim(void) {
+    wave_engine_t eng;
+    dma_chan_t dma;
+    wave_t w;
+    gpio_ctx_t gpio;
+    TEST_ASSERT_EQUAL_INT(0, gpio_ctx_init(&gpio, GPIO_BACKEND_SIM));
+    gpio_ctx_pin_mode(&gpio, 17, OUTPUT);
+    gpio_ctx_pin_mode(&gpio, 27, OUTPUT);
+
+    setup(&eng, &dma, WAVE_PACE_PCM, 1000);
+    sim.mirror = &gpio;
+
+    const wave_step_t steps[] = { { PIN_A | PIN_B, 0, 2 }, { 0, PIN_A, 2 } };
+    TEST_ASSERT_EQUAL_INT(0, wave_compile(&w, &eng, steps, 2));
+    wave_play(&eng, &w, 0);
+    wave_sim_run(&sim, 20000);
+
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&gpio, 17));
+    TEST_ASSERT_EQUAL_INT(HIGH, gpio_ctx_read(&gpio, 27));
+
+    wave_free(&w);
+    wave_engine_close(&eng);
+    gpio_ctx_cleanup(&gpio);
+}
+
+void test_engine_init_unavailable_on_host(void) {
+    wave_engine_t eng;
+    dma_chan_t dma;
+    memset(&dma, 0, sizeof(dma));
+    TEST_ASSERT_EQUAL_INT(-1, wave_engine_init(&eng, WAVE_PACE_PWM, 1000, &dma));
+}
+
+/* ============================================================================
+ * MAIN TEST RUNNER
+ * ============================================================================ */
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Compiler
+    RUN_TEST(test_compile_block_layout);
+    RUN_TEST(test_compile_rejects_invalid);
+    RUN_TEST(test_engine_tick_planning);
+
+    // Playback
+    RUN_TEST(test_play_pwm_paced);
+    RUN_TEST(test_play_pcm_paced);
+    RUN_TEST(test_sub_microsecond_ticks);
+    RUN_TEST(test_loop_until_stopped);
+    RUN_TEST(test_mirror_into_gpio_sim);
+    RUN_TEST(test_engine_init_unavailable_on_host);
+
+    return UNITY_END();
+}
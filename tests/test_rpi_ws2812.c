@@ -0,0 +1,330 @@
+/*
+ * test_rpi_ws2812.c - Validation tests for rpi_ws2812.h
+ *
+ * A strip is modelled in the GPIO simulator observer: every high pulse on
+ * the data pin is timed and decoded as a 1 when it is longer than the
+ * midpoint of T0H and T1H. Simulated stores are far too slow for datasheet
+ * timing, so the decoding tests stretch the bit to 100 us; they only check
+ * the decoded data when the strip's own stats show no preemption.
+ * Focus: encoding tables and byte order, two edges per bit, the error
+ * histogram, the reset gap and frames sent from the thread.
+ */
+
+/* Required for pthread_setaffinity_np in rpi_realtime.h */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "unity_mini.h"
+
+#define RPI_GPIO_IMPLEMENTATION
+#include "rpi_gpio.h"
+
+#define RPI_REALTIME_IMPLEMENTATION
+#include "rpi_realtime.h"
+
+#define RPI_WS2812_IMPLEMENTATION
+#include "rpi_ws2812.h"
+
+#define PIN         12
+#define LEDS        4
+#define MAX_PULSES  1024
+
+/* Stretched timing for the simulator */
+#define SLOW_T0H_NS 20000
+#define SLOW_T1H_NS 60000
+#define SLOW_BIT_NS 100000
+#define SLOW_RESET  300
+
+/* ============================================================================
+ * STRIP MODEL
+ * ============================================================================ */
+
+typedef struct {
+    uint64_t rise[MAX_PULSES];
+    uint64_t fall[MAX_PULSES];
+    int rises;
+    int falls;
+} model_t;
+
+static model_t model;
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void strip_observer(void* user, uint64_t prev, uint64_t levels) {
+    model_t* m = (model_t*)user;
+    uint64_t bit = 1ull << PIN;
+    if ((~prev & levels & bit) && m->rises < MAX_PULSES) m->rise[m->rises++] = mono_ns();
+    if ((prev & ~levels & bit) && m->falls < MAX_PULSES) m->fall[m->falls++] = mono_ns();
+}
+
+static void setup(gpio_ctx_t* gpio, ws2812_t* strip, int type) {
+    memset(gpio, 0, sizeof(*gpio));
+    gpio_ctx_init(gpio, GPIO_BACKEND_SIM);
+    memset(&model, 0, sizeof(model));
+    gpio_ctx_sim_set_observer(gpio, strip_observer, &model);
+    TEST_ASSERT_EQUAL_INT(0, ws2812_init(strip, gpio, PIN, LEDS, type));
+}
+
+static void teardown(gpio_ctx_t* gpio, ws2812_t* strip) {
+    ws2812_free(strip);
+    gpio_ctx_sim_set_observer(gpio, NULL, NULL);
+    gpio_ctx_cleanup(gpio);
+}
+
+static void fill(ws2812_t* strip, unsigned seed) {
+    srand(seed);
+    for (size_t i = 0; i < strip->count; i++) ws2812_set_pixel(strip, i, (uint32_t)rand() ^ ((uint32_t)rand() << 16));
+}
+
+/* Wire bytes the strip should receive: G R B (W) per LED */
+static int wire_bytes(ws2812_t* strip, uint8_t* out) {
+    int n = 0;
+    for (size_t i = 0; i < strip->count; i++) {
+        uint32_t p = ws2812_pixels(strip)[i];
+        out[n++] = (uint8_t)(p >> 8);
+        out[n++] = (uint8_t)(p >> 16);
+        out[n++] = (uint8_t)p;
+        if (strip->type == SK6812_GRBW) out[n++] = (uint8_t)(p >> 24);
+    }
+    return n;
+}
+
+/* Decode the pulses from first on and compare with the framebuffer */
+static void check_decoded(ws2812_t* strip, int first) {
+    ws2812_stats_t st;
+    ws2812_get_stats(strip, &st);
+    if (st.max_err_ns > (SLOW_T1H_NS - SLOW_T0H_NS) / 4) {
+        printf("  (host preempted the strip by %llu us, data not checked)\n", (unsigned long long)(st.max_err_ns / 1000));
+        return;
+    }
+
+    uint8_t expect[LEDS * 4];
+    int bytes = wire_bytes(strip, expect);
+    TEST_ASSERT_TRUE(model.falls >= first + bytes * 8);
+    for (int b = 0; b < bytes; b++) {
+        uint8_t got = 0;
+        for (int i = 0; i < 8; i++) {
+            int p = first + b * 8 + i;
+            uint64_t width = model.fall[p] - model.rise[p];
+            got = (uint8_t)((got << 1) | (width > (SLOW_T0H_NS + SLOW_T1H_NS) / 2));
+        }
+        TEST_ASSERT_EQUAL_INT(expect[b], got);
+    }
+}
+
+/* ============================================================================
+ * TESTS
+ * ============================================================================ */
+
+void test_init_validation(void) {
+    gpio_ctx_t gpio;
+    memset(&gpio, 0, sizeof(gpio));
+    gpio_ctx_init(&gpio, GPIO_BACKEND_SIM);
+    ws2812_t strip;
+
+    TEST_ASSERT_EQUAL_INT(-1, ws2812_init(&strip, &gpio, 99, LEDS, WS2812_GRB));
+    TEST_ASSERT_EQUAL_INT(-1, ws2812_init(&strip, &gpio, PIN, 0, WS2812_GRB));
+    TEST_ASSERT_EQUAL_INT(-1, ws2812_init(&strip, &gpio, PIN, WS2812_MAX_LEDS + 1, WS2812_GRB));
+    TEST_ASSERT_EQUAL_INT(-1, ws2812_init(&strip, &gpio, PIN, LEDS, 7));
+
+    TEST_ASSERT_EQUAL_INT(0, ws2812_init(&strip, &gpio, PIN, LEDS, WS2812_GRB));
+    TEST_ASSERT_EQUAL_INT(OUTPUT, gpio_ctx_sim_get_function(&gpio, PIN));
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&gpio, PIN));
+    TEST_ASSERT_EQUAL_INT(LEDS * 24, (int)strip.nbits);
+    TEST_ASSERT_TRUE(ws2812_ticks_per_ns() > 0.0);
+
+    TEST_ASSERT_EQUAL_INT(-1, ws2812_set_timing(&strip, 0, 800, 1250, 300));
+    TEST_ASSERT_EQUAL_INT(-1, ws2812_set_timing(&strip, 800, 400, 1250, 300));
+    TEST_ASSERT_EQUAL_INT(-1, ws2812_set_timing(&strip, 400, 800, 800, 300));
+
+    TEST_ASSERT_EQUAL_INT(0, ws2812_start(&strip, -1));
+    TEST_ASSERT_EQUAL_INT(-1, ws2812_start(&strip, -1));
+    TEST_ASSERT_EQUAL_INT(-1, ws2812_set_timing(&strip, 300, 600, 1250, 80));
+    ws2812_stop(&strip);
+
+    ws2812_free(&strip);
+    ws2812_free(&strip);
+    gpio_ctx_cleanup(&gpio);
+}
+
+void test_encoding_byte_order(void) {
+    gpio_ctx_t gpio;
+    ws2812_t strip;
+    const int types[2] = { WS2812_GRB, SK6812_GRBW };
+
+    for (int t = 0; t < 2; t++) {
+        setup(&gpio, &strip, types[t]);
+        TEST_ASSERT_EQUAL_INT(types[t] == SK6812_GRBW ? 4 : 3, strip.bytes_per_led);
+        uint32_t one = strip.table[0xFF * 8].high, zero = strip.table[0].high;
+        TEST_ASSERT_TRUE(one > zero);
+        TEST_ASSERT_EQUAL_INT((int)(strip.table[0].high + strip.table[0].low), (int)(one + strip.table[0xFF * 8].low));
+
+        fill(&strip, 11 + t);
+        ws2812_set_pixel(&strip, 0, WS2812_RGBW(0x12, 0x34, 0x56, 0x78));
+        TEST_ASSERT_EQUAL_INT(0, ws2812_show(&strip));
+
+        uint8_t expect[LEDS * 4];
+        int bytes = wire_bytes(&strip, expect);
+        TEST_ASSERT_EQUAL_INT(0x34, expect[0]);
+        const ws2812_bit_t* bits = strip.bits[strip.front];
+        for (int b = 0; b < bytes; b++) {
+            for (int i = 0; i < 8; i++) {
+                uint32_t want = ((expect[b] >> (7 - i)) & 1) ? one : zero;
+                TEST_ASSERT_EQUAL_INT((int)want, (int)bits[b * 8 + i].high);
+            }
+        }
+        teardown(&gpio, &strip);
+    }
+}
+
+void test_two_edges_per_bit(void) {
+    gpio_ctx_t gpio;
+    ws2812_t strip;
+    setup(&gpio, &strip, SK6812_GRBW);
+    fill(&strip, 3);
+
+    uint64_t writes = gpio.stats.writes;
+    TEST_ASSERT_EQUAL_INT(0, ws2812_show(&strip));
+    TEST_ASSERT_EQUAL_INT((int)strip.nbits, model.rises);
+    TEST_ASSERT_EQUAL_INT((int)strip.nbits, model.falls);
+    TEST_ASSERT_EQUAL_INT((int)(2 * strip.nbits), (int)(gpio.stats.writes - writes));
+    TEST_ASSERT_EQUAL_INT(LOW, gpio_ctx_read(&gpio, PIN));
+
+    teardown(&gpio, &strip);
+}
+
+void test_error_histogram(void) {
+    gpio_ctx_t gpio;
+    ws2812_t strip;
+    setup(&gpio, &strip, WS2812_GRB);
+    fill(&strip, 5);
+
+    TEST_ASSERT_EQUAL_INT(0, ws2812_show(&strip));
+    TEST_ASSERT_EQUAL_INT(0, ws2812_show(&strip));
+
+    ws2812_stats_t st;
+    ws2812_get_stats(&strip, &st);
+    TEST_ASSERT_EQUAL_INT(2, (int)st.frames);
+    TEST_ASSERT_EQUAL_INT((int)(2 * strip.nbits), (int)st.bits);
+    uint64_t total = 0, beyond = 0;
+    for (int b = 0; b <= WS2812_HIST_BINS; b++) total += st.hist[b];
+    for (int b = WS2812_TOLERANCE_NS / WS2812_HIST_NS + 1; b <= WS2812_HIST_BINS; b++) beyond += st.hist[b];
+    TEST_ASSERT_EQUAL_INT((int)st.bits, (int)total);
+    TEST_ASSERT_TRUE(st.out_of_spec >= beyond);
+    TEST_ASSERT_TRUE(st.out_of_spec <= st.bits);
+    TEST_ASSERT_TRUE(st.total_err_ns <= st.max_err_ns * st.bits);
+    TEST_ASSERT_TRUE(st.last_frame_ns > 0);
+
+    /* The worst bit lands in the bin its error in ns names */
+    int top = WS2812_HIST_BINS;
+    while (top > 0 && !st.hist[top]) top--;
+    uint64_t max_bin = st.max_err_ns / WS2812_HIST_NS;
+    TEST_ASSERT_EQUAL_INT(max_bin < WS2812_HIST_BINS ? (int)max_bin : WS2812_HIST_BINS, top);
+
+    ws2812_reset_stats(&strip);
+    ws2812_get_stats(&strip, &st);
+    TEST_ASSERT_EQUAL_INT(0, (int)st.frames);
+    TEST_ASSERT_EQUAL_INT(0, (int)st.hist[0]);
+
+    teardown(&gpio, &strip);
+}
+
+void test_histogram_bins_at_slow_counters(void) {
+    gpio_ctx_t gpio;
+    ws2812_t strip;
+    setup(&gpio, &strip, WS2812_GRB);
+
+    /* Pi 3 (19.2 MHz): a tick is 52 ns, two bins, not one */
+    strip.ticks_per_ns = 0.0192;
+    TEST_ASSERT_EQUAL_INT(0, ws2812_set_timing(&strip, 400, 800, 1250, 300));
+    TEST_ASSERT_EQUAL_INT(0, ws2812_hist_bin(&strip, 0));
+    TEST_ASSERT_EQUAL_INT(2, ws2812_hist_bin(&strip, 1));
+    TEST_ASSERT_EQUAL_INT(6, ws2812_hist_bin(&strip, 3));
+    TEST_ASSERT_EQUAL_INT(14, ws2812_hist_bin(&strip, 7));
+    TEST_ASSERT_EQUAL_INT(WS2812_HIST_BINS, ws2812_hist_bin(&strip, 8));
+
+    /* Pi 4 (54 MHz): 18.5 ns per tick */
+    strip.ticks_per_ns = 0.054;
+    TEST_ASSERT_EQUAL_INT(0, ws2812_set_timing(&strip, 400, 800, 1250, 300));
+    TEST_ASSERT_EQUAL_INT(0, ws2812_hist_bin(&strip, 1));
+    TEST_ASSERT_EQUAL_INT(1, ws2812_hist_bin(&strip, 2));
+    TEST_ASSERT_EQUAL_INT(2, ws2812_hist_bin(&strip, 3));
+    TEST_ASSERT_EQUAL_INT(8, ws2812_hist_bin(&strip, 11));
+    teardown(&gpio, &strip);
+}
+
+void test_decoded_frames_and_reset(void) {
+    gpio_ctx_t gpio;
+    ws2812_t strip;
+    setup(&gpio, &strip, WS2812_GRB);
+    TEST_ASSERT_EQUAL_INT(0, ws2812_set_timing(&strip, SLOW_T0H_NS, SLOW_T1H_NS, SLOW_BIT_NS, SLOW_RESET));
+
+    fill(&strip, 7);
+    TEST_ASSERT_EQUAL_INT(0, ws2812_show(&strip));
+    check_decoded(&strip, 0);
+
+    int first = model.rises;
+    fill(&strip, 8);
+    TEST_ASSERT_EQUAL_INT(0, ws2812_show(&strip));
+    check_decoded(&strip, first);
+
+    /* The last low plus the reset time separate the frames */
+    uint64_t gap = model.rise[first] - model.fall[first - 1];
+    TEST_ASSERT_TRUE(gap >= (uint64_t)SLOW_RESET * 1000u);
+
+    teardown(&gpio, &strip);
+}
+
+void test_thread_sends_every_frame(void) {
+    gpio_ctx_t gpio;
+    ws2812_t strip;
+    setup(&gpio, &strip, SK6812_GRBW);
+    TEST_ASSERT_EQUAL_INT(0, ws2812_set_timing(&strip, SLOW_T0H_NS, SLOW_T1H_NS, SLOW_BIT_NS, SLOW_RESET));
+    TEST_ASSERT_EQUAL_INT(0, ws2812_start(&strip, -1));
+
+    /* Each show encodes while the previous frame is on the wire */
+    for (unsigned f = 0; f < 3; f++) {
+        fill(&strip, 20 + f);
+        TEST_ASSERT_EQUAL_INT(0, ws2812_show(&strip));
+    }
+
+    ws2812_stats_t st;
+    for (int i = 0; i < 2000; i++) {
+        ws2812_get_stats(&strip, &st);
+        if (st.frames == 3) break;
+        usleep(1000);
+    }
+    ws2812_stop(&strip);
+    TEST_ASSERT_EQUAL_INT(3, (int)st.frames);
+    TEST_ASSERT_EQUAL_INT(0, strip.realtime);
+    TEST_ASSERT_EQUAL_INT((int)(3 * strip.nbits), model.falls);
+    check_decoded(&strip, (int)(2 * strip.nbits));
+
+    teardown(&gpio, &strip);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    // Encoding and emission
+    RUN_TEST(test_init_validation);
+    RUN_TEST(test_encoding_byte_order);
+    RUN_TEST(test_two_edges_per_bit);
+    RUN_TEST(test_error_histogram);
+    RUN_TEST(test_histogram_bins_at_slow_counters);
+    RUN_TEST(test_decoded_frames_and_reset);
+
+    // Sending thread
+    RUN_TEST(test_thread_sends_every_frame);
+
+    return UNITY_END();
+}